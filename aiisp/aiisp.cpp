@@ -1,70 +1,32 @@
 #include "aiisp.h"
+#include "aiisp_model_cache.h"
+#include "aiisp_bnr.h"
+#include "aiisp_drc.h"
+#include "aiisp_3dnr.h"
+#include <string.h>
 
 bool aiisp::read_model(const char* model_file,ot_aiisp_mem_info* mem)
 {
-    td_s32 ret;
-    FILE* fp = TD_NULL;
-
-    fp = fopen(model_file, "rb");
-    if(fp == NULL)
+    aiisp_model_mem model;
+    if(!aiisp_model_cache::acquire(model_file,&model))
     {
-        printf("[%s]: fopen failed\n",__FUNCTION__);
+        printf("[%s]: %s failed\n",__FUNCTION__,model_file);
         return false;
     }
 
-    ret = fseek(fp, 0L, SEEK_END);
-    if (ret != TD_SUCCESS) 
-    {
-        printf("[%s]: fseek failed with error 0x%x\n",__FUNCTION__,ret);
-        goto fail_0;
-    }
-
-    mem->size = ftell(fp);
-    if (mem->size <= 0) 
-    {
-        printf("[%s]: ftell failed\n",__FUNCTION__);
-        goto fail_0;
-    }
-
-    ret = fseek(fp, 0L, SEEK_SET);
-    if (ret != TD_SUCCESS) 
-    {
-        printf("[%s]: fseek failed\n",__FUNCTION__);
-        goto fail_0;
-    }
-
-    /* malloc model file mem */
-    ret = ss_mpi_sys_mmz_alloc(&(mem->phys_addr), &(mem->virt_addr), "aibnr_cfg", TD_NULL, mem->size);
-    if (ret != TD_SUCCESS)
-    {
-        printf("[%s]: ss_mpi_sys_mmz_alloc failed with error 0x%x\n",__FUNCTION__,ret);
-        goto fail_0;
-    }
-
-    ret = fread(mem->virt_addr, mem->size, 1, fp);
-    if (ret != 1) 
-    {
-        printf("[%s]: fread failed with error 0x%x\n",__FUNCTION__,ret);
-        goto fail_1;
-    }
-
-    ret = fclose(fp);
-    if (ret != 0) 
-    {
-        printf("[%s]: fclose failed with error 0x%x\n",__FUNCTION__,ret);
-    }
-    return true;;
+    mem->phys_addr = model.phys_addr;
+    mem->virt_addr = model.virt_addr;
+    mem->size = model.size;
+    return true;
+}
 
-fail_1:
-    ss_mpi_sys_mmz_free(mem->phys_addr, mem->virt_addr);
-    mem->phys_addr = 0;
-    mem->virt_addr = TD_NULL;
-fail_0:
-    if (fp != TD_NULL) 
+void aiisp::free_model(ot_aiisp_mem_info* mem)
+{
+    if(mem->virt_addr != TD_NULL)
     {
-        fclose(fp);
+        aiisp_model_cache::release(mem->virt_addr);
     }
-    return false;
+    memset(mem,0,sizeof(*mem));
 }
 
 ot_vb_pool aiisp::create_pool(td_u64 blk_size,td_u32 blk_cnt,ot_vb_remap_mode mode)
@@ -81,3 +43,66 @@ void aiisp::destroy_pool(ot_vb_pool pool_id)
 {
     ss_mpi_vb_destroy_pool(pool_id);
 }
+
+std::shared_ptr<aiisp> aiisp::create(int mode,const char* model_file,int pipe,int w,int h,int is_wdr_mode)
+{
+    switch(mode)
+    {
+        case AIISP_MODE_BNR:
+            {
+                if(!aiisp_bnr::init(model_file,w,h,is_wdr_mode))
+                {
+                    aiisp_bnr::release();
+                    return NULL;
+                }
+                return std::make_shared<aiisp_bnr>(pipe);
+            }
+
+        case AIISP_MODE_DRC:
+            {
+                if(!aiisp_drc::init(model_file,w,h,is_wdr_mode))
+                {
+                    aiisp_drc::release();
+                    return NULL;
+                }
+                return std::make_shared<aiisp_drc>(pipe);
+            }
+
+        case AIISP_MODE_3DNR:
+            {
+                if(!aiisp_3dnr::init(model_file,w,h))
+                {
+                    aiisp_3dnr::release();
+                    return NULL;
+                }
+                return std::make_shared<aiisp_3dnr>(pipe);
+            }
+
+        default:
+            {
+                printf("[%s]: invalid mode %d\n",__FUNCTION__,mode);
+                return NULL;
+            }
+    }
+}
+
+void aiisp::release(int mode)
+{
+    switch(mode)
+    {
+        case AIISP_MODE_BNR:
+            aiisp_bnr::release();
+            break;
+
+        case AIISP_MODE_DRC:
+            aiisp_drc::release();
+            break;
+
+        case AIISP_MODE_3DNR:
+            aiisp_3dnr::release();
+            break;
+
+        default:
+            break;
+    }
+}
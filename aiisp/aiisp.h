@@ -6,6 +6,14 @@
 #include <ss_mpi_sys_mem.h>
 #include <ss_mpi_vb.h>
 #include <ss_mpi_vi.h>
+#include <memory>
+
+enum
+{
+    AIISP_MODE_BNR = 0,
+    AIISP_MODE_DRC,
+    AIISP_MODE_3DNR,
+};
 
 class aiisp
 {
@@ -16,9 +24,15 @@ public:
     virtual bool start() = 0;
     virtual void stop() = 0;
 
+    //the mmz copy comes from aiisp_model_cache,free_model gives the reference back
     static bool read_model(const char* model_file,ot_aiisp_mem_info* meminfo);
+    static void free_model(ot_aiisp_mem_info* meminfo);
     static ot_vb_pool create_pool(td_u64 blk_size,td_u32 blk_cnt,ot_vb_remap_mode mode);
     static void destroy_pool(ot_vb_pool pool_id);
+
+    //init of the mode(model,pools) and its instance on pipe,not started
+    static std::shared_ptr<aiisp> create(int mode,const char* model_file,int pipe,int w,int h,int is_wdr_mode);
+    static void release(int mode);
 };
 
 #endif
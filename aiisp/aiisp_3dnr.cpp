@@ -62,14 +62,13 @@ void aiisp_3dnr::release()
     if(g_model_id != -1)
     {
         ss_mpi_ai3dnr_unload_model(g_model_id);
+        g_model_id = -1;
     }
 
     ss_mpi_ai3dnr_exit();
 
-    if(g_model_info.model.mem_info.phys_addr != 0)
-    {
-        ss_mpi_sys_mmz_free(g_model_info.model.mem_info.phys_addr, g_model_info.model.mem_info.virt_addr);
-    }
+    //the mmz copy stays in aiisp_model_cache for the next init
+    aiisp::free_model(&g_model_info.model.mem_info);
 
     if (g_aiisp_3dnr_pool != OT_VB_INVALID_POOL_ID)
     {
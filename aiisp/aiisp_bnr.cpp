@@ -64,14 +64,13 @@ void aiisp_bnr::release()
     if(g_model_id != -1)
     {
         ss_mpi_aibnr_unload_model(g_model_id);
+        g_model_id = -1;
     }
 
     ss_mpi_aibnr_exit();
 
-    if(g_model_info.model.mem_info.phys_addr != 0)
-    {
-        ss_mpi_sys_mmz_free(g_model_info.model.mem_info.phys_addr, g_model_info.model.mem_info.virt_addr);
-    }
+    //the mmz copy stays in aiisp_model_cache for the next init
+    aiisp::free_model(&g_model_info.model.mem_info);
 
     if (g_aiisp_bnr_pool != OT_VB_INVALID_POOL_ID)
     {
@@ -0,0 +1,272 @@
+#include "aiisp_model_cache.h"
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <chrono>
+
+//read() chunk when the file can not be mapped
+#define AIISP_MODEL_READ_CHUNK (1024 * 1024)
+
+std::mutex aiisp_model_cache::g_mu;
+std::map<std::string,aiisp_model_cache::entry_t> aiisp_model_cache::g_models;
+td_u64 aiisp_model_cache::g_budget = 0;
+td_u64 aiisp_model_cache::g_bytes = 0;
+td_u64 aiisp_model_cache::g_tick = 0;
+aiisp_model_cache_stat aiisp_model_cache::g_stat;
+
+static td_u64 now_us()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+bool aiisp_model_cache::load(const char* model_file,aiisp_model_mem* mem)
+{
+    int fd = open(model_file,O_RDONLY);
+    if(fd < 0)
+    {
+        printf("[%s]: open %s failed\n",__FUNCTION__,model_file);
+        return false;
+    }
+
+    struct stat st;
+    if(fstat(fd,&st) != 0 || st.st_size <= 0)
+    {
+        printf("[%s]: %s is empty\n",__FUNCTION__,model_file);
+        close(fd);
+        return false;
+    }
+
+    mem->size = st.st_size;
+    td_s32 ret = ss_mpi_sys_mmz_alloc(&mem->phys_addr,&mem->virt_addr,"aiisp_model",TD_NULL,mem->size);
+    if(ret != TD_SUCCESS)
+    {
+        printf("[%s]: ss_mpi_sys_mmz_alloc failed with error 0x%x\n",__FUNCTION__,ret);
+        close(fd);
+        return false;
+    }
+
+    //one sequential pass over the page cache,the kernel reads ahead the whole file
+    bool ok = true;
+    void* map = mmap(NULL,mem->size,PROT_READ,MAP_PRIVATE,fd,0);
+    if(map != MAP_FAILED)
+    {
+        madvise(map,mem->size,MADV_SEQUENTIAL);
+        madvise(map,mem->size,MADV_WILLNEED);
+        memcpy(mem->virt_addr,map,mem->size);
+        munmap(map,mem->size);
+    }
+    else
+    {
+        td_u64 off = 0;
+        while(off < mem->size)
+        {
+            td_u64 len = mem->size - off < AIISP_MODEL_READ_CHUNK ? mem->size - off : AIISP_MODEL_READ_CHUNK;
+            ssize_t n = read(fd,(char*)mem->virt_addr + off,len);
+            if(n <= 0)
+            {
+                printf("[%s]: read %s failed at %llu\n",__FUNCTION__,model_file,(unsigned long long)off);
+                ok = false;
+                break;
+            }
+            off += n;
+        }
+    }
+    close(fd);
+
+    if(!ok)
+    {
+        ss_mpi_sys_mmz_free(mem->phys_addr,mem->virt_addr);
+        memset(mem,0,sizeof(*mem));
+        return false;
+    }
+
+    return true;
+}
+
+void aiisp_model_cache::evict(td_u64 need)
+{
+    if(g_budget == 0)
+    {
+        return;
+    }
+
+    while(g_bytes + need > g_budget)
+    {
+        auto lru = g_models.end();
+        for(auto it = g_models.begin(); it != g_models.end(); it++)
+        {
+            if(it->second.refs == 0
+                    && (lru == g_models.end() || it->second.last_use < lru->second.last_use))
+            {
+                lru = it;
+            }
+        }
+
+        if(lru == g_models.end())
+        {
+            return;
+        }
+
+        printf("[%s]: %s,%llu bytes\n",__FUNCTION__,lru->first.c_str(),(unsigned long long)lru->second.mem.size);
+        ss_mpi_sys_mmz_free(lru->second.mem.phys_addr,lru->second.mem.virt_addr);
+        g_bytes -= lru->second.mem.size;
+        g_stat.evictions++;
+        g_models.erase(lru);
+    }
+}
+
+bool aiisp_model_cache::acquire(const char* model_file,aiisp_model_mem* mem)
+{
+    std::unique_lock<std::mutex> lock(g_mu);
+
+    auto it = g_models.find(model_file);
+    if(it != g_models.end())
+    {
+        it->second.refs++;
+        it->second.last_use = ++g_tick;
+        g_stat.hits++;
+        *mem = it->second.mem;
+        return true;
+    }
+
+    struct stat st;
+    if(stat(model_file,&st) != 0)
+    {
+        printf("[%s]: %s not found\n",__FUNCTION__,model_file);
+        return false;
+    }
+
+    //a model in use may go over the budget,only the idle copies make room
+    evict(st.st_size);
+
+    entry_t e;
+    memset(&e,0,sizeof(e));
+    td_u64 beg = now_us();
+    if(!load(model_file,&e.mem))
+    {
+        return false;
+    }
+    e.load_us = now_us() - beg;
+    e.refs = 1;
+    e.last_use = ++g_tick;
+
+    g_models[model_file] = e;
+    g_bytes += e.mem.size;
+    g_stat.misses++;
+    g_stat.last_load_us = e.load_us;
+    printf("[%s]: %s,%llu bytes in %lluus\n",__FUNCTION__,model_file,(unsigned long long)e.mem.size,(unsigned long long)e.load_us);
+
+    *mem = e.mem;
+    return true;
+}
+
+void aiisp_model_cache::release(const td_void* virt_addr)
+{
+    if(virt_addr == TD_NULL)
+    {
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(g_mu);
+    for(auto it = g_models.begin(); it != g_models.end(); it++)
+    {
+        if(it->second.mem.virt_addr == virt_addr)
+        {
+            if(it->second.refs > 0)
+            {
+                it->second.refs--;
+            }
+            break;
+        }
+    }
+
+    evict(0);
+}
+
+bool aiisp_model_cache::preload(const char* model_file)
+{
+    std::unique_lock<std::mutex> lock(g_mu);
+
+    auto it = g_models.find(model_file);
+    if(it != g_models.end())
+    {
+        it->second.last_use = ++g_tick;
+        return true;
+    }
+
+    struct stat st;
+    if(stat(model_file,&st) != 0)
+    {
+        printf("[%s]: %s not found\n",__FUNCTION__,model_file);
+        return false;
+    }
+
+    evict(st.st_size);
+    if(g_budget != 0 && g_bytes + st.st_size > g_budget)
+    {
+        printf("[%s]: %s does not fit the budget(%llu of %llu bytes used)\n",
+                __FUNCTION__,model_file,(unsigned long long)g_bytes,(unsigned long long)g_budget);
+        return false;
+    }
+
+    entry_t e;
+    memset(&e,0,sizeof(e));
+    td_u64 beg = now_us();
+    if(!load(model_file,&e.mem))
+    {
+        return false;
+    }
+    e.load_us = now_us() - beg;
+    e.last_use = ++g_tick;
+
+    g_models[model_file] = e;
+    g_bytes += e.mem.size;
+    g_stat.last_load_us = e.load_us;
+    printf("[%s]: %s,%llu bytes in %lluus\n",__FUNCTION__,model_file,(unsigned long long)e.mem.size,(unsigned long long)e.load_us);
+    return true;
+}
+
+void aiisp_model_cache::set_budget(td_u64 bytes)
+{
+    std::unique_lock<std::mutex> lock(g_mu);
+    g_budget = bytes;
+    evict(0);
+}
+
+void aiisp_model_cache::clear()
+{
+    std::unique_lock<std::mutex> lock(g_mu);
+    for(auto it = g_models.begin(); it != g_models.end();)
+    {
+        if(it->second.refs == 0)
+        {
+            ss_mpi_sys_mmz_free(it->second.mem.phys_addr,it->second.mem.virt_addr);
+            g_bytes -= it->second.mem.size;
+            it = g_models.erase(it);
+        }
+        else
+        {
+            it++;
+        }
+    }
+}
+
+void aiisp_model_cache::get_stat(aiisp_model_cache_stat* stat)
+{
+    std::unique_lock<std::mutex> lock(g_mu);
+    *stat = g_stat;
+    stat->models = g_models.size();
+    stat->used = 0;
+    for(auto it = g_models.begin(); it != g_models.end(); it++)
+    {
+        if(it->second.refs > 0)
+        {
+            stat->used++;
+        }
+    }
+    stat->bytes = g_bytes;
+    stat->budget = g_budget;
+}
@@ -0,0 +1,70 @@
+#ifndef aiisp_model_cache_include_h
+#define aiisp_model_cache_include_h
+
+#include <ss_mpi_sys_mem.h>
+#include <string>
+#include <map>
+#include <mutex>
+
+typedef struct
+{
+    td_phys_addr_t phys_addr;
+    td_void* virt_addr;
+    td_u64 size;
+}aiisp_model_mem;
+
+typedef struct
+{
+    td_u32 models;          //resident mmz copies
+    td_u32 used;            //of them referenced by a loaded model
+    td_u64 bytes;           //mmz held by the cache
+    td_u64 budget;          //0:no limit
+    td_u32 hits;
+    td_u32 misses;
+    td_u32 evictions;
+    td_u64 last_load_us;    //file to mmz time of the last miss
+}aiisp_model_cache_stat;
+
+//mmz copies of the aiisp model files,each read once and shared by reference count.
+//a released copy stays resident,so the next init of that model(a mode switch back,a restart)
+//skips the file,until the budget needs its room:then the least recently used go first
+class aiisp_model_cache
+{
+public:
+    //the mmz copy of model_file,read on the first acquire,one reference per acquire
+    static bool acquire(const char* model_file,aiisp_model_mem* mem);
+    static void release(const td_void* virt_addr);
+
+    //read model_file ahead without a reference,false when it does not fit the budget
+    static bool preload(const char* model_file);
+
+    //bytes of mmz the unreferenced copies may fill up to,0:no limit
+    static void set_budget(td_u64 bytes);
+
+    //frees every unreferenced copy
+    static void clear();
+
+    static void get_stat(aiisp_model_cache_stat* stat);
+
+private:
+    typedef struct
+    {
+        aiisp_model_mem mem;
+        td_u32 refs;
+        td_u64 last_use;
+        td_u64 load_us;
+    }entry_t;
+
+    static bool load(const char* model_file,aiisp_model_mem* mem);
+    static void evict(td_u64 need);
+
+private:
+    static std::mutex g_mu;
+    static std::map<std::string,entry_t> g_models;
+    static td_u64 g_budget;
+    static td_u64 g_bytes;
+    static td_u64 g_tick;
+    static aiisp_model_cache_stat g_stat;
+};
+
+#endif
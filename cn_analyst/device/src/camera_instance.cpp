@@ -1,5 +1,6 @@
 #include "camera_instance.h"
 #include <algorithm>
+#include <chrono>
 
 #include "dev_log.h"
 #include "dev_venc.h"
@@ -65,7 +66,11 @@ public:
         }
 
         m_is_running = true;
+        m_venc_ptr->set_slice_lines(m_config.slice_lines);
         m_venc_ptr->start(vpss_grp, vpss_chn);
+        if (m_config.gop > 0) {
+            m_venc_ptr->set_rc(m_config.framerate, m_config.bitrate, m_config.gop);
+        }
 
         // 使用了默认的osd配置，后期可根据主视窗大小适配
         m_osd_ptr = std::make_shared<osd_date>(32,32,64, m_venc_ptr->venc_chn());
@@ -81,6 +86,39 @@ public:
         m_is_running = false;
     }
 
+    // Applies the rate control and size of config to the running encoder, the venc
+    // object and its observers stay. Type and slice mode need a new encoder
+    bool reconfigure(const stream_config& config) {
+        if (!m_venc_ptr) {
+            return false;
+        }
+
+        if (config.framerate != m_config.framerate || config.bitrate != m_config.bitrate || config.gop != m_config.gop) {
+            if (!m_venc_ptr->set_rc(config.framerate, config.bitrate, config.gop)) {
+                return false;
+            }
+            m_config.framerate = config.framerate;
+            m_config.bitrate = config.bitrate;
+            m_config.gop = config.gop;
+        }
+
+        if (config.width != m_config.width || config.height != m_config.height) {
+            // The date goes back onto the channel, it may have been rebuilt
+            m_osd_ptr->stop();
+            bool ret = m_venc_ptr->set_size(config.width, config.height);
+            m_osd_ptr->start();
+            if (!ret) {
+                return false;
+            }
+            m_config.width = config.width;
+            m_config.height = config.height;
+        }
+
+        m_config.name = config.name;
+        m_config.outputs = config.outputs;
+        return true;
+    }
+
     bool register_stream_observer(ceanic::util::stream_observer_ptr observer) {
         if (!m_venc_ptr || !observer) {
             return false;
@@ -99,6 +137,8 @@ public:
         return true;
     }
 
+    std::shared_ptr<venc> get_venc() const { return m_venc_ptr; }
+
     bool request_i_frame()
     {
         if (!m_venc_ptr) {
@@ -161,6 +201,9 @@ camera_instance::camera_instance(int32_t camera_id, const camera_config& config)
     : m_camera_id(camera_id)
     , m_config(config)
     , m_is_running(false)
+    , m_aiisp_mode(-1)
+    , m_roi_enabled(false)
+    , m_roi_ab_period_ms(0)
 {
     m_vi_ptr = nullptr;
 }
@@ -228,11 +271,22 @@ void camera_instance::stop() {
     if (!m_is_running) {
         return;
     }
+
+    // Close the recording before its source goes away
+    stop_save();
+
+    if (m_snap) {
+        m_snap->stop();
+        m_snap.reset();
+    }
     
     // Stop all streams
+    stop_yolov5();
+    release_mjpeg();
     stop_streams();
     
     // Disable all features
+    stop_aiisp();
     m_enabled_features.clear();
     
     // Free hardware resources
@@ -336,8 +390,21 @@ std::vector<int32_t> camera_instance::list_streams() const {
 bool camera_instance::enable_feature(const std::string& feature_name, const std::string& config) {
     std::lock_guard<std::mutex> lock(m_mutex);
     
-    // Placeholder implementation
-    // In real implementation, would initialize the specific feature
+    if (feature_name == "aiisp") {
+        // config is the model file, empty for the configured one
+        const std::string& model = config.empty() ? m_config.features.aiisp_model : config;
+        if (!m_aiisp_ptr && !start_aiisp(m_config.features.aiisp_mode, model)) {
+            return false;
+        }
+    } else if (feature_name == "yolov5") {
+        // config is the model file, empty for the configured one
+        const std::string& model = config.empty() ? m_config.features.yolov5_model : config;
+        if (!m_yolov5 && !start_yolov5(model, true, true, 0, NULL)) {
+            return false;
+        }
+    }
+
+    // Placeholder implementation for the other features
     m_enabled_features[feature_name] = true;
     return true;
 }
@@ -347,6 +414,11 @@ bool camera_instance::disable_feature(const std::string& feature_name) {
     
     auto it = m_enabled_features.find(feature_name);
     if (it != m_enabled_features.end()) {
+        if (feature_name == "aiisp") {
+            stop_aiisp();
+        } else if (feature_name == "yolov5") {
+            stop_yolov5();
+        }
         m_enabled_features.erase(it);
         return true;
     }
@@ -354,6 +426,90 @@ bool camera_instance::disable_feature(const std::string& feature_name) {
     return false;
 }
 
+bool camera_instance::switch_aiisp(int32_t mode, const std::string& model_file) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (!m_is_running) {
+        return false;
+    }
+
+    // The old mode gives its model back to aiisp_model_cache, the new one is only
+    // read from the file when it was not preloaded
+    auto begin = std::chrono::steady_clock::now();
+    int32_t old_mode = m_aiisp_mode;
+    stop_aiisp();
+    bool ret = start_aiisp(mode, model_file);
+    int64_t us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - begin).count();
+    DEV_WRITE_LOG_INFO("camera %d aiisp mode %d->%d %s,%lldus", m_camera_id, old_mode, mode, ret ? "ok" : "failed", (long long)us);
+
+    if (ret) {
+        m_enabled_features["aiisp"] = true;
+    } else {
+        m_enabled_features.erase("aiisp");
+    }
+    return ret;
+}
+
+bool camera_instance::enable_yolov5(const std::string& model_file, bool burn_in, bool metadata, uint32_t track_interval,
+                                    const yolov5_post_t* post) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (!m_is_running || m_yolov5) {
+        return false;
+    }
+
+    if (!start_yolov5(model_file, burn_in, metadata, track_interval, post)) {
+        return false;
+    }
+
+    m_enabled_features["yolov5"] = true;
+    return true;
+}
+
+bool camera_instance::enable_yolov5_roi(const ceanic::roi::roi_qp_param* param, uint32_t ab_period_ms) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (!m_yolov5 || !param) {
+        return false;
+    }
+
+    m_roi_param = *param;
+    m_roi_ab_period_ms = ab_period_ms;
+    m_roi_enabled = true;
+    if (!attach_yolov5_roi()) {
+        detach_yolov5_roi();
+        return false;
+    }
+    return true;
+}
+
+void camera_instance::disable_yolov5_roi() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    detach_yolov5_roi();
+}
+
+bool camera_instance::enable_yolov5_motion(const ceanic::motion::motion_param* param, bool gate) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_yolov5 && m_yolov5->start_motion(param, gate);
+}
+
+void camera_instance::disable_yolov5_motion() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_yolov5) {
+        m_yolov5->stop_motion();
+    }
+}
+
+bool camera_instance::get_yolov5_motion_event(ceanic::motion::motion_event* event) {
+    std::shared_ptr<yolov5> y = std::atomic_load(&m_yolov5);
+    return y && y->get_motion_event(event);
+}
+
+bool camera_instance::get_yolov5_stat(yolov5_stat_t* stat) {
+    std::shared_ptr<yolov5> y = std::atomic_load(&m_yolov5);
+    return y && y->get_stat(stat);
+}
+
 bool camera_instance::is_feature_enabled(const std::string& feature_name) const {
     std::lock_guard<std::mutex> lock(m_mutex);
     
@@ -475,6 +631,12 @@ bool camera_instance::init_vi() {
             m_vi_ptr = std::make_shared<vi_os08a20_2to1wdr>();
         }
     }
+#ifdef CEANIC_SDK_SIM
+    else if (sensor_type == "sim" || sensor_type == "SIM")
+    {
+        m_vi_ptr = std::make_shared<vi_sim>();
+    }
+#endif
     else
     {
         DEV_WRITE_LOG_ERROR("Vi start failed, unsupported sensor type: %s, work mode: %s",
@@ -509,6 +671,141 @@ bool camera_instance::init_streams() {
     return true;
 }
 
+bool camera_instance::start_aiisp(int32_t mode, const std::string& model_file) {
+    std::shared_ptr<vi_isp> viisp = std::dynamic_pointer_cast<vi_isp>(m_vi_ptr);
+    if (!viisp) {
+        return false;
+    }
+
+    m_aiisp_ptr = aiisp::create(mode, model_file.c_str(), viisp->pipes()[0], viisp->isp_w(), viisp->isp_h(), viisp->wdr_mode());
+    if (!m_aiisp_ptr) {
+        DEV_WRITE_LOG_ERROR("camera %d aiisp mode %d,%s failed", m_camera_id, mode, model_file.c_str());
+        return false;
+    }
+
+    if (!m_aiisp_ptr->start()) {
+        m_aiisp_ptr.reset();
+        aiisp::release(mode);
+        return false;
+    }
+
+    m_aiisp_mode = mode;
+    return true;
+}
+
+void camera_instance::stop_aiisp() {
+    if (m_aiisp_ptr) {
+        m_aiisp_ptr->stop();
+        m_aiisp_ptr.reset();
+    }
+
+    if (m_aiisp_mode >= 0) {
+        aiisp::release(m_aiisp_mode);
+        m_aiisp_mode = -1;
+    }
+}
+
+bool camera_instance::start_yolov5(const std::string& model_file, bool burn_in, bool metadata, uint32_t track_interval,
+                                   const yolov5_post_t* post) {
+    // The ai stream and the metadata frames come back through on_stream_come
+    auto y = std::make_shared<yolov5>(m_camera_id, 2 /* AI_STREAM_ID */, m_vi_ptr, model_file.c_str(), burn_in, metadata,
+        track_interval, post);
+    if (!y->start()) {
+        DEV_WRITE_LOG_ERROR("camera %d yolov5 %s start failed", m_camera_id, model_file.c_str());
+        return false;
+    }
+
+    y->register_stream_observer(shared_from_this());
+    std::atomic_store(&m_yolov5, y);
+    return true;
+}
+
+void camera_instance::stop_yolov5() {
+    if (m_roi_enabled) {
+        detach_yolov5_roi();
+    }
+
+    std::shared_ptr<yolov5> y = std::atomic_exchange(&m_yolov5, std::shared_ptr<yolov5>());
+    if (y) {
+        y->stop_motion();
+        y->unregister_stream_observer(shared_from_this());
+        y->stop();
+    }
+}
+
+// Hands the main and sub encoders to yolov5, their roi follows the boxes of every frame
+bool camera_instance::attach_yolov5_roi() {
+    m_yolov5->clear_roi_venc();
+    const int32_t ids[] = {0 /* MAIN_STREAM_ID */, 1 /* SUB_STREAM_ID */};
+    for (int32_t id : ids) {
+        auto it = m_streams.find(id);
+        if (it == m_streams.end() || !it->second) {
+            continue;
+        }
+
+        std::shared_ptr<venc> v = it->second->get_venc();
+        if (!v->start_roi(&m_roi_param, m_yolov5->venc_w(), m_yolov5->venc_h(), m_roi_ab_period_ms)) {
+            return false;
+        }
+        m_yolov5->add_roi_venc(v);
+    }
+    return true;
+}
+
+void camera_instance::detach_yolov5_roi() {
+    if (m_yolov5) {
+        m_yolov5->clear_roi_venc();
+    }
+
+    const int32_t ids[] = {0 /* MAIN_STREAM_ID */, 1 /* SUB_STREAM_ID */};
+    for (int32_t id : ids) {
+        auto it = m_streams.find(id);
+        if (it != m_streams.end() && it->second) {
+            it->second->get_venc()->stop_roi();
+        }
+    }
+    m_roi_enabled = false;
+}
+
+bool camera_instance::start_mjpeg(int32_t width, int32_t height, int32_t framerate, int32_t quality) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (!m_is_running || m_venc_mjpeg) {
+        return false;
+    }
+
+    if (width > m_vi_ptr->w() || height > m_vi_ptr->h() || framerate > m_vi_ptr->fr()
+            || quality < 1 || quality > 99) {
+        DEV_WRITE_LOG_ERROR("camera %d invalid mjpeg param %dx%d@%d quality %d", m_camera_id, width, height, framerate, quality);
+        return false;
+    }
+
+    auto mjpeg = std::make_shared<venc_mjpeg>(m_camera_id, 3 /* MJPEG_STREAM_ID */, width, height,
+        m_vi_ptr->fr(), framerate, m_vi_ptr->vpss_grp(), m_vi_ptr->vpss_chn(), quality);
+    if (!mjpeg->start(m_vi_ptr->vpss_grp(), m_vi_ptr->vpss_chn())) {
+        DEV_WRITE_LOG_ERROR("camera %d mjpeg venc start failed", m_camera_id);
+        mjpeg->stop();
+        return false;
+    }
+
+    mjpeg->register_stream_observer(shared_from_this());
+    std::atomic_store(&m_venc_mjpeg, std::shared_ptr<venc>(mjpeg));
+    return true;
+}
+
+void camera_instance::stop_mjpeg() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    release_mjpeg();
+}
+
+void camera_instance::release_mjpeg() {
+    std::shared_ptr<venc> mjpeg = std::atomic_exchange(&m_venc_mjpeg, std::shared_ptr<venc>());
+    if (mjpeg) {
+        mjpeg->unregister_stream_observer(shared_from_this());
+        mjpeg->stop();
+    }
+}
+
 void camera_instance::stop_streams() {
     // Cleanup already created streams
     for (auto& pair : m_streams) {
@@ -529,11 +826,15 @@ bool camera_instance::init_features() {
     }
     
     if (m_config.features.aiisp_enabled) {
-        m_enabled_features["aiisp"] = true;
+        if (start_aiisp(m_config.features.aiisp_mode, m_config.features.aiisp_model)) {
+            m_enabled_features["aiisp"] = true;
+        }
     }
     
     if (m_config.features.yolov5_enabled) {
-        m_enabled_features["yolov5"] = true;
+        if (start_yolov5(m_config.features.yolov5_model, true, true, 0, NULL)) {
+            m_enabled_features["yolov5"] = true;
+        }
     }
     
     if (m_config.features.vo_enabled) {
@@ -549,6 +850,14 @@ void camera_instance::on_stream_come(ceanic::util::stream_obj_ptr obj, ceanic::u
     int32_t stream = obj->stream_id();
     std::string sname = obj->name();
 
+    // Detections of yolov5 ride along the main and sub streams as a metadata track
+    if(IS_META_FRAME(head->type))
+    {
+        ceanic::rtsp::stream_manager::instance()->process_data(chn,0 /* MAIN_STREAM_ID */,head,buf,len);
+        ceanic::rtsp::stream_manager::instance()->process_data(chn,1 /* SUB_STREAM_ID */,head,buf,len);
+        return;
+    }
+
 #if 0
     //rtmp当前支持主码流/子码流 H264格式
     if(stream == 0 /* MAIN_STREAM_ID */ || stream == 1 /* SUB_STREAM_ID */)
@@ -558,26 +867,135 @@ void camera_instance::on_stream_come(ceanic::util::stream_obj_ptr obj, ceanic::u
             ceanic::rtmp::session_manager::instance()->process_data(chn,stream,head,(uint8_t*)buf,len);
         }
     }
+#endif
 
     //mp4当前保存的是主码流
-    if(stream == MAIN_STREAM_ID )
+    if(stream == 0 /* MAIN_STREAM_ID */)
     {
-        if(m_save)
+        std::shared_ptr<ceanic::stream_save::stream_save> save;
+        {
+            std::lock_guard<std::mutex> lock(m_save_mutex);
+            save = m_save;
+        }
+
+        if(save)
         {
-            m_save->input_data(head,buf,len);
+            save->input_data(head,buf,len);
         }
     }
-#endif
 
-    ceanic::rtsp::stream_manager::instance()->process_data(chn,stream,head,buf,len);
+    // Low latency streams were sent to rtsp slice by slice
+    if(!(head->flags & STREAM_FLAG_SLICE_SENT))
+    {
+        ceanic::rtsp::stream_manager::instance()->process_data(chn,stream,head,buf,len);
+    }
 }
 
 void camera_instance::on_stream_error(ceanic::util::stream_obj_ptr obj, int32_t error)
 {
 }
 
+void camera_instance::on_frame_come(ceanic::util::stream_obj_ptr obj, ceanic::util::stream_frame_ptr frame)
+{
+    // Recorder queues the encoder frame by reference, the rest works on the head
+    if(obj->stream_id() != 0 /* MAIN_STREAM_ID */)
+    {
+        on_stream_come(obj, frame->head(), NULL, 0);
+        return;
+    }
+
+    std::shared_ptr<ceanic::stream_save::stream_save> save;
+    {
+        std::lock_guard<std::mutex> lock(m_save_mutex);
+        save = m_save;
+    }
+
+    if(save)
+    {
+        save->input_stream_frame(frame);
+    }
+
+    if(!(frame->head()->flags & STREAM_FLAG_SLICE_SENT))
+    {
+        ceanic::rtsp::stream_manager::instance()->process_data(obj->chn(), obj->stream_id(), frame->head(), NULL, 0);
+    }
+}
+
+void camera_instance::on_slice_come(ceanic::util::stream_obj_ptr obj, ceanic::util::stream_head* head)
+{
+    ceanic::rtsp::stream_manager::instance()->process_data(obj->chn(), obj->stream_id(), head, NULL, 0);
+}
+
+bool camera_instance::request_jpg(const snap_request& req)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (!m_is_running) {
+        return false;
+    }
+
+    snap_request r = req;
+    r.quality = std::min(std::max(r.quality, 1), 99);
+
+    if (!m_snap) {
+        auto s = std::make_shared<snap>(m_vi_ptr);
+        if (!s->start()) {
+            s->stop();
+            return false;
+        }
+        m_snap = s;
+    }
+
+    return m_snap->request(r);
+}
+
+bool camera_instance::start_save(std::shared_ptr<ceanic::stream_save::stream_save> saver)
+{
+    if (!saver) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(m_save_mutex);
+    if (m_save) {
+        DEV_WRITE_LOG_ERROR("camera %d is already recording", m_camera_id);
+        return false;
+    }
+
+    m_save = saver;
+    return true;
+}
+
+void camera_instance::stop_save()
+{
+    std::shared_ptr<ceanic::stream_save::stream_save> save;
+    {
+        std::lock_guard<std::mutex> lock(m_save_mutex);
+        save.swap(m_save);
+    }
+
+    // close outside the lock, it waits for the writer to drain
+    if (save) {
+        save->close();
+    }
+}
+
+std::shared_ptr<ceanic::stream_save::stream_save> camera_instance::get_save() const
+{
+    std::lock_guard<std::mutex> lock(m_save_mutex);
+    return m_save;
+}
+
 bool camera_instance::request_i_frame(int stream)
 {
+    if (stream == 2 /* AI_STREAM_ID */) {
+        return std::atomic_load(&m_yolov5) != nullptr;
+    }
+
+    if (stream == 3 /* MJPEG_STREAM_ID */) {
+        // Every mjpeg frame stands alone
+        return std::atomic_load(&m_venc_mjpeg) != nullptr;
+    }
+
     auto it = m_streams.find(stream);
     if (it == m_streams.end()) {
         return false; // Stream not found
@@ -592,16 +1010,119 @@ bool camera_instance::request_i_frame(int stream)
     return false;
 }
 
+bool camera_instance::reconfigure_stream(const stream_config& config)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (!m_is_running) {
+        return false;
+    }
+
+    std::string error_msg;
+    if (!stream_config_helper::validate(config, error_msg)) {
+        DEV_WRITE_LOG_ERROR("camera %d stream %d: %s", m_camera_id, config.stream_id, error_msg.c_str());
+        return false;
+    }
+
+    auto it = m_streams.find(config.stream_id);
+    if (it == m_streams.end() || !it->second) {
+        return false;
+    }
+
+    auto begin = std::chrono::steady_clock::now();
+    stream_config old = it->second->get_config();
+    bool ret;
+    if (config.type != old.type || config.slice_lines != old.slice_lines) {
+        // A new encoder for this stream only, rtsp/rtmp stay subscribed to the chn/stream id.
+        // Players have to set up again after a codec change
+        it->second->unregister_stream_observer(shared_from_this());
+        it->second->stop();
+
+        auto stream = std::make_shared<stream_instance>(config.stream_id, config);
+        ret = stream->start(m_vi_ptr->vpss_grp(), m_vi_ptr->vpss_chn());
+        if (!ret) {
+            stream = std::make_shared<stream_instance>(old.stream_id, old);
+            stream->start(m_vi_ptr->vpss_grp(), m_vi_ptr->vpss_chn());
+        }
+        stream->register_stream_observer(shared_from_this());
+        it->second = stream;
+
+        // The roi of yolov5 goes over to the new encoder
+        if (m_roi_enabled && m_yolov5 && (config.stream_id == 0 || config.stream_id == 1) && !attach_yolov5_roi()) {
+            DEV_WRITE_LOG_ERROR("camera %d stream %d roi lost", m_camera_id, config.stream_id);
+        }
+    } else {
+        ret = it->second->reconfigure(config);
+    }
+
+    // Keep the camera config in step, a restart comes up the same
+    stream_config now = it->second->get_config();
+    for (auto& stream_cfg : m_config.streams) {
+        if (stream_cfg.stream_id == config.stream_id) {
+            stream_cfg = now;
+        }
+    }
+
+    int64_t us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - begin).count();
+    DEV_WRITE_LOG_INFO("camera %d stream %d %s %dx%d@%d %dkbps gop %d %s,%lldus", m_camera_id, config.stream_id,
+        stream_config_helper::encoder_type_to_string(now.type).c_str(), now.width, now.height, now.framerate,
+        now.bitrate, now.gop, ret ? "ok" : "failed", (long long)us);
+    return ret;
+}
+
+bool camera_instance::get_stream_config(int32_t stream_id, stream_config& config) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto it = m_streams.find(stream_id);
+    if (it == m_streams.end() || !it->second) {
+        return false;
+    }
+
+    config = it->second->get_config();
+    return true;
+}
+
 bool camera_instance::get_stream_head(int stream, ceanic::util::media_head *mh)
 {
+    std::shared_ptr<yolov5> y = std::atomic_load(&m_yolov5);
+    if (stream == 2 /* AI_STREAM_ID */) {
+        // Aidetect stream, only encoded while the boxes are burnt in
+        if (!y || !y->burn_in()) {
+            return false;
+        }
+
+        using namespace ceanic::util;
+        memset(mh, 0, sizeof(media_head));
+        mh->audio_info.acode = STREAM_AUDIO_ENCODE_NONE;
+        mh->video_info.vcode = STREAM_VIDEO_ENCODE_H264;
+        return true;
+    }
+
+    if (stream == 3 /* MJPEG_STREAM_ID */) {
+        std::shared_ptr<venc> mjpeg = std::atomic_load(&m_venc_mjpeg);
+        if (!mjpeg) {
+            return false;
+        }
+
+        using namespace ceanic::util;
+        memset(mh, 0, sizeof(media_head));
+        mh->audio_info.acode = STREAM_AUDIO_ENCODE_NONE;
+        mh->video_info.w = mjpeg->venc_w();
+        mh->video_info.h = mjpeg->venc_h();
+        mh->video_info.fr = mjpeg->venc_fr();
+        mh->video_info.vcode = STREAM_VIDEO_ENCODE_MJPEG;
+        return true;
+    }
+
     auto it = m_streams.find(stream);
     if (it == m_streams.end()) {
         return false; // Stream not found
     }
 
-    // Stop and remove stream
     if (it->second) {
         it->second->get_stream_head(mh);
+        mh->meta_info.mcode = (y && y->metadata()) ? ceanic::util::STREAM_META_ENCODE_ONVIF : ceanic::util::STREAM_META_ENCODE_NONE;
         return true;
     }
 
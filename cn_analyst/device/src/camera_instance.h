@@ -14,8 +14,16 @@
 #include "dev_vi_os04a10_2to1wdr.h"
 #include "dev_vi_os08a20_liner.h"
 #include "dev_vi_os08a20_2to1wdr.h"
+#ifdef CEANIC_SDK_SIM
+#include "dev_vi_sim.h"
+#endif
+#include "dev_venc.h"
+#include "dev_snap.h"
+#include "dev_svp_yolov5.h"
 
 #include <stream_observer.h>
+#include <stream_save.h>
+#include <aiisp.h>
 
 using namespace hisilicon::dev;
 
@@ -42,6 +50,7 @@ struct feature_config {
     bool scene_auto_enabled;
     int32_t scene_mode;
     bool aiisp_enabled;
+    int32_t aiisp_mode;  // AIISP_MODE_BNR/DRC/3DNR
     std::string aiisp_model;
     bool yolov5_enabled;
     std::string yolov5_model;
@@ -54,6 +63,7 @@ struct feature_config {
         , scene_auto_enabled(false)
         , scene_mode(0)
         , aiisp_enabled(false)
+        , aiisp_mode(0)
         , yolov5_enabled(false)
         , vo_enabled(false)
     {}
@@ -197,6 +207,26 @@ public:
      */
     std::vector<int32_t> list_streams() const;
     
+    /**
+     * @brief Apply a changed stream configuration to the running stream
+     *
+     * Diffs config against the running one by stream_id. Framerate, bitrate and GOP
+     * are set on the running encoder, a new resolution restarts only that VENC channel
+     * with an IDR carrying the new parameter sets, a new encoder type or slice mode
+     * rebuilds only this stream. The RTSP/RTMP/recording consumers stay attached.
+     * @param config New stream configuration (stream_id selects the stream)
+     * @return true if applied, false if invalid or failed (the stream keeps running)
+     */
+    bool reconfigure_stream(const stream_config& config);
+    
+    /**
+     * @brief Get the running configuration of a stream
+     * @param stream_id Stream ID
+     * @param config Output parameter for the configuration
+     * @return true if the stream exists
+     */
+    bool get_stream_config(int32_t stream_id, stream_config& config) const;
+    
     // Feature Management
     
     /**
@@ -220,6 +250,68 @@ public:
      * @return true if enabled, false otherwise
      */
     bool is_feature_enabled(const std::string& feature_name) const;
+
+    /**
+     * @brief Switch the AI-ISP mode, starting it if it is not running
+     * @param mode AIISP_MODE_BNR/DRC/3DNR
+     * @param model_file Model of the mode, fast when preloaded to aiisp_model_cache
+     * @return true if successful, false otherwise
+     */
+    bool switch_aiisp(int32_t mode, const std::string& model_file);
+    
+    /**
+     * @brief Start YOLOv5 detection on the frames of this camera
+     * @param model_file Model file
+     * @param burn_in Boxes drawn into the frames, encoded as the ai stream (stream id 2)
+     * @param metadata Detections of every frame as an ONVIF metadata track of the main and sub streams
+     * @param track_interval 0 raw detections, N tracked boxes and inference on up to every Nth frame
+     * @param post NULL when the model has the npu roi/nms layers, otherwise cpu decode of its raw heads
+     * @return true if successful, false if not running, already started or failed
+     */
+    bool enable_yolov5(const std::string& model_file, bool burn_in, bool metadata, uint32_t track_interval = 0,
+                       const yolov5_post_t* post = NULL);
+
+    /**
+     * @brief Get the YOLOv5 pipeline statistics
+     * @param stat Output statistics
+     * @return true if YOLOv5 is running
+     */
+    bool get_yolov5_stat(yolov5_stat_t* stat);
+
+    /**
+     * @brief Drive the ROI QP of the main and sub streams from the YOLOv5 detections
+     *
+     * A main or sub stream rebuilt by reconfigure_stream keeps following the detections.
+     * @param param ROI QP parameters
+     * @param ab_period_ms >0 switches the ROI on and off every period and logs the bitrate of both halves
+     * @return true if successful, false if YOLOv5 is not running or the encoders refused it
+     */
+    bool enable_yolov5_roi(const ceanic::roi::roi_qp_param* param, uint32_t ab_period_ms = 0);
+
+    /**
+     * @brief Stop the detection driven ROI QP
+     */
+    void disable_yolov5_roi();
+
+    /**
+     * @brief CPU motion analysis of the YOLOv5 frames
+     * @param param Motion detection parameters
+     * @param gate true: no inference while nothing moves
+     * @return true if successful, false if YOLOv5 is not running or failed
+     */
+    bool enable_yolov5_motion(const ceanic::motion::motion_param* param, bool gate = false);
+
+    /**
+     * @brief Stop the motion analysis
+     */
+    void disable_yolov5_motion();
+
+    /**
+     * @brief Get the latest motion event
+     * @param event Output event
+     * @return true if an event was read
+     */
+    bool get_yolov5_motion_event(ceanic::motion::motion_event* event);
     
     // Information
     
@@ -249,10 +341,63 @@ public:
 
     bool get_isp_exposure_info(isp_exposure_t* val);
 
+    // MJPEG
+
+    /**
+     * @brief Start the low rate MJPEG stream (stream id 3) for rtsp and the http mjpeg server
+     *
+     * Every viewer is fed from this one encoder. Call it before the venc capture starts.
+     * @param width Picture width, at most the VI width
+     * @param height Picture height, at most the VI height
+     * @param framerate Frame rate, at most the VI frame rate
+     * @param quality JPEG quality (1-99)
+     * @return true if successful, false if invalid, already running or failed
+     */
+    bool start_mjpeg(int32_t width, int32_t height, int32_t framerate, int32_t quality);
+
+    /**
+     * @brief Stop the MJPEG stream
+     */
+    void stop_mjpeg();
+
+    // Snapshots
+
+    /**
+     * @brief Queue a JPEG snapshot request (single shot or burst)
+     *
+     * The snap service is started on the first request, the JPEGs are encoded and
+     * written on its own threads.
+     * @param req Quality (clamped to 1-99), overlay text, burst count/interval, optional path and callback
+     * @return true if queued, false if not running or the snap queue is full
+     */
+    bool request_jpg(const snap_request& req);
+
+    // Recording
+
+    /**
+     * @brief Start feeding main stream frames to a saver
+     * @param saver Opened saver (mp4_save, event_save, ...)
+     * @return true if successful, false if already recording
+     */
+    bool start_save(std::shared_ptr<ceanic::stream_save::stream_save> saver);
+
+    /**
+     * @brief Stop recording and close the saver
+     */
+    void stop_save();
+
+    /**
+     * @brief Get the current saver
+     * @return Saver pointer or nullptr if not recording
+     */
+    std::shared_ptr<ceanic::stream_save::stream_save> get_save() const;
+
     // Observer Pattern (from device to streaming)
     void on_stream_come(ceanic::util::stream_obj_ptr obj, ceanic::util::stream_head* head,
                        const char* buf, int32_t len) override;
     void on_stream_error(ceanic::util::stream_obj_ptr obj, int32_t error) override;
+    void on_frame_come(ceanic::util::stream_obj_ptr obj, ceanic::util::stream_frame_ptr frame) override;
+    void on_slice_come(ceanic::util::stream_obj_ptr obj, ceanic::util::stream_head* head) override;
     bool request_i_frame(int stream);
     bool get_stream_head(int stream, ceanic::util::media_head* mh);
 
@@ -265,6 +410,14 @@ private:
     bool init_vpss();
     bool init_streams();
     bool init_features();
+    bool start_aiisp(int32_t mode, const std::string& model_file);
+    void stop_aiisp();
+    void release_mjpeg();
+    bool start_yolov5(const std::string& model_file, bool burn_in, bool metadata, uint32_t track_interval,
+                      const yolov5_post_t* post);
+    void stop_yolov5();
+    bool attach_yolov5_roi();
+    void detach_yolov5_roi();
 
     void stop_streams();
     
@@ -286,6 +439,26 @@ private:
     std::map<std::string, bool> m_enabled_features;
 
     std::shared_ptr<vi> m_vi_ptr;
+
+    // Running AI-ISP mode, its model stays in aiisp_model_cache after a switch
+    std::shared_ptr<aiisp> m_aiisp_ptr;
+    int32_t m_aiisp_mode;
+
+    // YOLOv5 detection, read without the lock by get_stream_head and the stats readers
+    std::shared_ptr<yolov5> m_yolov5;
+    bool m_roi_enabled;
+    ceanic::roi::roi_qp_param m_roi_param;
+    uint32_t m_roi_ab_period_ms;
+
+    // Snap service, started by the first request_jpg
+    std::shared_ptr<snap> m_snap;
+
+    // MJPEG encoder, read without the lock by get_stream_head
+    std::shared_ptr<venc> m_venc_mjpeg;
+
+    // Main stream saver, has its own lock since it is used on every frame
+    std::shared_ptr<ceanic::stream_save::stream_save> m_save;
+    mutable std::mutex m_save_mutex;
     
     // Thread safety
     mutable std::mutex m_mutex;
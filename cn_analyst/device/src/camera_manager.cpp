@@ -1,5 +1,6 @@
 #include "camera_manager.h"
 #include "dev_log.h"
+#include <startup/startup_dag.h>
 #include <algorithm>
 #include <sstream>
 
@@ -10,7 +11,8 @@ namespace device {
 bool camera_manager::m_initialized = false;
 int32_t camera_manager::m_max_cameras = 4;
 int32_t camera_manager::m_next_camera_id = 0;
-std::map<int32_t, std::shared_ptr<camera_instance>> camera_manager::m_cameras;
+camera_manager::camera_map camera_manager::m_cameras;
+std::shared_ptr<const camera_manager::camera_map> camera_manager::m_snapshot;
 std::mutex camera_manager::m_mutex;
 
 bool camera_manager::init(int32_t max_cameras) {
@@ -27,6 +29,7 @@ bool camera_manager::init(int32_t max_cameras) {
     m_max_cameras = max_cameras;
     m_next_camera_id = 0;
     m_cameras.clear();
+    publish();
     m_initialized = true;
     
     return true;
@@ -43,6 +46,7 @@ void camera_manager::release() {
     }
     
     m_cameras.clear();
+    publish();
     m_next_camera_id = 0;
     m_initialized = false;
 }
@@ -98,11 +102,42 @@ std::shared_ptr<camera_instance> camera_manager::create_camera(const camera_conf
     
     // Add to camera map
     m_cameras[camera_id] = camera;
+    publish();
     DEV_WRITE_LOG_INFO("Create camera instance [success, camera_id=%d]", camera_id);
     
+    memory_plan plan;
+    get_memory_plan(plan);
+    DEV_WRITE_LOG_INFO("Memory plan:\n%s", resource_manager::format_memory_plan(plan).c_str());
+    
     return camera;
 }
 
+bool camera_manager::start_cameras(const std::vector<int32_t>& camera_ids, uint32_t threads) {
+    std::vector<std::shared_ptr<camera_instance>> cameras;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (auto& pair : m_cameras) {
+            if (camera_ids.empty()
+                    || std::find(camera_ids.begin(), camera_ids.end(), pair.first) != camera_ids.end()) {
+                cameras.push_back(pair.second);
+            }
+        }
+    }
+
+    // Cameras share no hardware chain, so none of them waits for another
+    ceanic::startup::startup_dag dag;
+    for (auto& camera : cameras) {
+        std::string name = "camera" + std::to_string(camera->camera_id());
+        dag.add(name.c_str(), {}, [camera] { return camera->is_running() || camera->start(); });
+    }
+    dag.set_observer([](const ceanic::startup::step_result& r) {
+        DEV_WRITE_LOG_INFO("Start %s [%s, %llu-%lluus]", r.name.c_str(), r.ok ? "success" : "failed",
+                (unsigned long long)r.begin_us, (unsigned long long)r.end_us);
+    });
+
+    return dag.run(threads);
+}
+
 bool camera_manager::destroy_camera(int32_t camera_id) {
     std::lock_guard<std::mutex> lock(m_mutex);
     
@@ -122,6 +157,7 @@ bool camera_manager::destroy_camera(int32_t camera_id) {
     
     // Remove from map
     m_cameras.erase(it);
+    publish();
     
     return true;
 }
@@ -142,17 +178,14 @@ void camera_manager::destroy_all_cameras() {
     
     // Clear map
     m_cameras.clear();
+    publish();
 }
 
 std::shared_ptr<camera_instance> camera_manager::get_camera(int32_t camera_id) {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    
-    if (!m_initialized) {
-        return nullptr;
-    }
-    
-    auto it = m_cameras.find(camera_id);
-    if (it != m_cameras.end()) {
+    // The map is empty while not initialized
+    std::shared_ptr<const camera_map> cameras = snapshot();
+    auto it = cameras->find(camera_id);
+    if (it != cameras->end()) {
         return it->second;
     }
     
@@ -160,10 +193,10 @@ std::shared_ptr<camera_instance> camera_manager::get_camera(int32_t camera_id) {
 }
 
 std::vector<int32_t> camera_manager::list_cameras() {
-    std::lock_guard<std::mutex> lock(m_mutex);
+    std::shared_ptr<const camera_map> cameras = snapshot();
     
     std::vector<int32_t> camera_ids;
-    for (const auto& pair : m_cameras) {
+    for (const auto& pair : *cameras) {
         camera_ids.push_back(pair.first);
     }
     
@@ -171,13 +204,12 @@ std::vector<int32_t> camera_manager::list_cameras() {
 }
 
 int32_t camera_manager::get_camera_count() {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    return static_cast<int32_t>(m_cameras.size());
+    return static_cast<int32_t>(snapshot()->size());
 }
 
 bool camera_manager::camera_exists(int32_t camera_id) {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    return (m_cameras.find(camera_id) != m_cameras.end());
+    std::shared_ptr<const camera_map> cameras = snapshot();
+    return (cameras->find(camera_id) != cameras->end());
 }
 
 bool camera_manager::validate_config(const camera_config& config, std::string& error_msg) {
@@ -217,6 +249,13 @@ bool camera_manager::validate_config(const camera_config& config, std::string& e
         stream_ids.push_back(stream.stream_id);
     }
     
+    // Memory is what runs out first with a second camera or a third stream
+    memory_plan plan;
+    if (!plan_with(config, plan)) {
+        error_msg = "Memory plan: " + plan.error;
+        return false;
+    }
+    
     return true;
 }
 
@@ -255,6 +294,16 @@ bool camera_manager::can_create_camera(const camera_config& config) {
     return true;
 }
 
+bool camera_manager::get_memory_plan(memory_plan& plan) {
+    std::vector<memory_plan_camera> cameras;
+    std::shared_ptr<const camera_map> created = snapshot();
+    for (const auto& pair : *created) {
+        cameras.push_back(to_plan_camera(pair.second->get_config()));
+    }
+    
+    return resource_manager::plan_memory(cameras, plan);
+}
+
 int32_t camera_manager::get_max_cameras() {
     std::lock_guard<std::mutex> lock(m_mutex);
     return m_max_cameras;
@@ -262,6 +311,19 @@ int32_t camera_manager::get_max_cameras() {
 
 // Private helper methods
 
+void camera_manager::publish() {
+    std::atomic_store(&m_snapshot, std::shared_ptr<const camera_map>(std::make_shared<camera_map>(m_cameras)));
+}
+
+std::shared_ptr<const camera_manager::camera_map> camera_manager::snapshot() {
+    std::shared_ptr<const camera_map> cameras = std::atomic_load(&m_snapshot);
+    if (!cameras) {
+        static const std::shared_ptr<const camera_map> empty = std::make_shared<camera_map>();
+        return empty;
+    }
+    return cameras;
+}
+
 int32_t camera_manager::allocate_camera_id() {
     // Find first available ID
     for (int32_t i = 0; i < m_max_cameras * 10; ++i) {
@@ -276,6 +338,40 @@ int32_t camera_manager::allocate_camera_id() {
     return -1; // Failed to find available ID
 }
 
+memory_plan_camera camera_manager::to_plan_camera(const camera_config& config) {
+    memory_plan_camera camera;
+    camera.camera_id = config.camera_id;
+    if (config.sensor.name.find("OS04A10") == 0) {
+        camera.sensor_width = 2688;
+        camera.sensor_height = 1520;
+    } else if (config.sensor.name.find("OS08A20") == 0) {
+        camera.sensor_width = 3840;
+        camera.sensor_height = 2160;
+    }
+    camera.wdr = config.sensor.mode == "2to1wdr";
+    camera.streams = config.streams;
+    camera.aiisp_enabled = config.features.aiisp_enabled;
+    camera.aiisp_mode = config.features.aiisp_mode;
+    camera.aiisp_model = config.features.aiisp_model;
+    camera.yolov5_enabled = config.features.yolov5_enabled;
+    camera.yolov5_model = config.features.yolov5_model;
+    return camera;
+}
+
+bool camera_manager::plan_with(const camera_config& config, memory_plan& plan) {
+    std::vector<memory_plan_camera> cameras;
+    std::shared_ptr<const camera_map> created = snapshot();
+    for (const auto& pair : *created) {
+        // A config of a created camera replaces it
+        if (pair.first != config.camera_id) {
+            cameras.push_back(to_plan_camera(pair.second->get_config()));
+        }
+    }
+    cameras.push_back(to_plan_camera(config));
+    
+    return resource_manager::plan_memory(cameras, plan);
+}
+
 bool camera_manager::validate_sensor_config(const sensor_config& sensor, std::string& error_msg) {
     // Check sensor name
     if (sensor.name.empty()) {
@@ -17,7 +17,8 @@ namespace device {
  * Enforces camera count limits and coordinates with resource_manager
  * for hardware resource allocation.
  * 
- * Thread-safe singleton pattern.
+ * Thread-safe singleton pattern. The queries read a published snapshot of
+ * the camera map and take no lock, create/destroy publish a new one.
  */
 class camera_manager {
 public:
@@ -59,6 +60,14 @@ public:
      * @brief Destroy all cameras
      */
     static void destroy_all_cameras();
+
+    /**
+     * @brief Start created cameras in parallel, each one on its own worker
+     * @param camera_ids Cameras to start, empty for all created ones
+     * @param threads Cameras brought up at the same time
+     * @return true if every camera started
+     */
+    static bool start_cameras(const std::vector<int32_t>& camera_ids = std::vector<int32_t>(), uint32_t threads = 4);
     
     // Query Functions
     
@@ -92,6 +101,8 @@ public:
     
     /**
      * @brief Validate camera configuration
+     *
+     * Includes the memory plan of the created cameras together with this one.
      * @param config Camera configuration to validate
      * @param error_msg Output parameter for error message if validation fails
      * @return true if valid, false otherwise
@@ -105,6 +116,13 @@ public:
      */
     static bool can_create_camera(const camera_config& config);
     
+    /**
+     * @brief Plan the memory of the created cameras
+     * @param plan Output parameter for the VB pools and mmz allocations
+     * @return true if the plan fits the resource limits
+     */
+    static bool get_memory_plan(memory_plan& plan);
+    
     /**
      * @brief Get maximum number of cameras supported
      * @return Maximum camera count
@@ -121,12 +139,27 @@ private:
     // Internal helper methods
     static int32_t allocate_camera_id();
     static bool validate_sensor_config(const sensor_config& sensor, std::string& error_msg);
+    static memory_plan_camera to_plan_camera(const camera_config& config);
+    static bool plan_with(const camera_config& config, memory_plan& plan);
+    
+    typedef std::map<int32_t, std::shared_ptr<camera_instance>> camera_map;
+    
+    /**
+     * @brief Publish a copy of m_cameras for the queries, call with m_mutex held
+     */
+    static void publish();
+    
+    /**
+     * @brief The last published camera map, never null
+     */
+    static std::shared_ptr<const camera_map> snapshot();
     
     // Internal state
     static bool m_initialized;
     static int32_t m_max_cameras;
     static int32_t m_next_camera_id;
-    static std::map<int32_t, std::shared_ptr<camera_instance>> m_cameras;
+    static camera_map m_cameras;
+    static std::shared_ptr<const camera_map> m_snapshot;
     static std::mutex m_mutex;
 };
 
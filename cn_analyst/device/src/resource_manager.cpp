@@ -1,4 +1,8 @@
 #include "resource_manager.h"
+#include <algorithm>
+#include <cstdio>
+#include <sstream>
+#include <sys/stat.h>
 
 namespace hisilicon {
 namespace device {
@@ -308,5 +312,222 @@ resource_limits resource_manager::get_limits() {
     return m_limits;
 }
 
+// Memory Planning
+
+namespace {
+
+// Blocks of the common pools the device code takes frames from
+const uint32_t VI_RAW_BLKS_PER_PIPE = 3;  // offline vi, raw frames waiting for the isp
+const uint32_t VI_YUV_BLKS = 2;           // isp output on its way to vpss
+const uint32_t VPSS_BLKS = 2;             // depth 0 chn, plus one frame per bound venc
+const uint32_t YOLOV5_VPSS_BLKS = 2;      // the depth 1 analysis chn
+// Private pools, the counts of aiisp_*.cpp and yolov5::create_vb_pool
+const uint32_t AIISP_BNR_BLKS = 7;
+const uint32_t AIISP_3DNR_BLKS = 7;
+const uint32_t AIISP_DRC_BLKS = 3;        // one pool in, one out
+const uint32_t YOLOV5_BLKS = 16;
+const int32_t YOLOV5_INPUT = 640;
+// venc reference and reconstruction frames, allocated by the driver
+const uint32_t VENC_REF_FRAMES = 2;
+// Model sizes when the file can not be read
+const uint64_t AIISP_MODEL_BYTES = 1200 * 1024;
+const uint64_t YOLOV5_MODEL_BYTES = 8 * 1024 * 1024;
+const uint64_t MMZ_PAGE = 4096;
+
+uint64_t align_up(uint64_t v, uint64_t a) {
+    return (v + a - 1) / a * a;
+}
+
+uint64_t raw12_frame_size(int32_t width, int32_t height) {
+    return align_up((static_cast<uint64_t>(width) * 12 + 7) / 8, 32) * height;
+}
+
+uint64_t yuv422_frame_size(int32_t width, int32_t height) {
+    return align_up(width, 32) * height * 2;
+}
+
+// 16 bit bayer in and out of the npu, what ot_aibnr_get_pic_buf_size comes to
+uint64_t aiisp_frame_size(int32_t width, int32_t height) {
+    return align_up(static_cast<uint64_t>(width) * 2, 32) * height;
+}
+
+uint64_t model_size(const std::string& path, uint64_t fallback) {
+    struct stat st;
+    if (!path.empty() && stat(path.c_str(), &st) == 0 && st.st_size > 0) {
+        return static_cast<uint64_t>(st.st_size);
+    }
+    return fallback;
+}
+
+struct pool_request {
+    bool common;
+    uint64_t blk_size;
+    uint32_t blk_cnt;
+    std::string user;
+};
+
+std::string camera_name(const memory_plan_camera& camera) {
+    // Not created yet, no id assigned
+    if (camera.camera_id < 0) {
+        return "camera_new";
+    }
+    return "camera" + std::to_string(camera.camera_id);
+}
+
+std::string format_mb(uint64_t bytes) {
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%.1fMB", bytes / (1024.0 * 1024.0));
+    return buf;
+}
+
+} // namespace
+
+uint64_t resource_manager::yuv420_frame_size(int32_t width, int32_t height) {
+    return align_up(width, 32) * align_up(height, 2) * 3 / 2;
+}
+
+bool resource_manager::plan_memory(const std::vector<memory_plan_camera>& cameras, memory_plan& plan) {
+    plan = memory_plan();
+    plan.budget_bytes = get_limits().mmz_bytes;
+    int32_t max_common_pools = get_limits().max_common_pools;
+    
+    std::vector<pool_request> requests;
+    for (const auto& camera : cameras) {
+        std::string name = camera_name(camera);
+        int32_t w = camera.sensor_width;
+        int32_t h = camera.sensor_height;
+        // Unknown sensors are planned at the largest stream
+        for (const auto& stream : camera.streams) {
+            w = std::max(w, stream.width);
+            h = std::max(h, stream.height);
+        }
+        if (w <= 0 || h <= 0) {
+            plan.error = name + " has no size";
+            return false;
+        }
+        
+        uint32_t pipes = camera.wdr ? 2 : 1;
+        requests.push_back({true, raw12_frame_size(w, h), VI_RAW_BLKS_PER_PIPE * pipes, name + "/vi_raw"});
+        requests.push_back({true, yuv420_frame_size(w, h), VI_YUV_BLKS, name + "/vi"});
+        // Every stream's venc scales from the one vpss chn
+        requests.push_back({true, yuv420_frame_size(w, h),
+                VPSS_BLKS + static_cast<uint32_t>(camera.streams.size()), name + "/vpss"});
+        
+        for (const auto& stream : camera.streams) {
+            std::string sname = name + "/stream" + std::to_string(stream.stream_id);
+            // buf_size of the venc chn attr in dev_venc.cpp
+            plan.mmz.push_back({sname + "/venc_buf",
+                    align_up(static_cast<uint64_t>(stream.width) * stream.height * 3 / 2, MMZ_PAGE)});
+            plan.mmz.push_back({sname + "/venc_ref",
+                    align_up(yuv420_frame_size(align_up(stream.width, 64), align_up(stream.height, 64)) * VENC_REF_FRAMES, MMZ_PAGE)});
+            if (stream.outputs.jpeg_enabled) {
+                // dev_snap sizes its stream buffer at two bytes a pixel
+                plan.mmz.push_back({sname + "/jpeg_buf",
+                        align_up(static_cast<uint64_t>(stream.width) * stream.height * 2, MMZ_PAGE)});
+            }
+        }
+        
+        if (camera.aiisp_enabled) {
+            uint64_t blk = aiisp_frame_size(w, h);
+            switch (camera.aiisp_mode) {
+                case 1: // AIISP_MODE_DRC
+                    requests.push_back({false, blk, AIISP_DRC_BLKS, name + "/aiisp_drc_in"});
+                    requests.push_back({false, blk, AIISP_DRC_BLKS, name + "/aiisp_drc_out"});
+                    break;
+                case 2: // AIISP_MODE_3DNR
+                    requests.push_back({false, blk, AIISP_3DNR_BLKS, name + "/aiisp_3dnr"});
+                    break;
+                default: // AIISP_MODE_BNR
+                    requests.push_back({false, blk, AIISP_BNR_BLKS, name + "/aiisp_bnr"});
+                    break;
+            }
+            plan.mmz.push_back({name + "/aiisp_model",
+                    align_up(model_size(camera.aiisp_model, AIISP_MODEL_BYTES), MMZ_PAGE)});
+        }
+        
+        if (camera.yolov5_enabled) {
+            requests.push_back({true, yuv420_frame_size(YOLOV5_INPUT, YOLOV5_INPUT), YOLOV5_VPSS_BLKS, name + "/yolov5_vpss"});
+            requests.push_back({false, yuv422_frame_size(YOLOV5_INPUT, YOLOV5_INPUT), YOLOV5_BLKS, name + "/yolov5"});
+            plan.mmz.push_back({name + "/yolov5_model",
+                    align_up(model_size(camera.yolov5_model, YOLOV5_MODEL_BYTES), MMZ_PAGE)});
+        }
+    }
+    
+    // Largest blocks first, a smaller request joins a common pool when it
+    // uses at least 7/8 of the block
+    std::stable_sort(requests.begin(), requests.end(), [](const pool_request& a, const pool_request& b) {
+        return a.blk_size > b.blk_size;
+    });
+    for (const auto& req : requests) {
+        vb_pool_plan* pool = nullptr;
+        if (req.common) {
+            for (auto& p : plan.pools) {
+                if (p.common && p.blk_size >= req.blk_size && req.blk_size * 8 >= p.blk_size * 7) {
+                    pool = &p;
+                    break;
+                }
+            }
+        }
+        if (!pool) {
+            plan.pools.push_back(vb_pool_plan());
+            pool = &plan.pools.back();
+            pool->common = req.common;
+            pool->blk_size = req.blk_size;
+        }
+        pool->blk_cnt += req.blk_cnt;
+        pool->users.push_back(req.user);
+    }
+    
+    int32_t common_pools = 0;
+    for (const auto& pool : plan.pools) {
+        plan.vb_bytes += pool.blk_size * pool.blk_cnt;
+        if (pool.common) {
+            common_pools++;
+        }
+    }
+    for (const auto& item : plan.mmz) {
+        plan.mmz_bytes += item.bytes;
+    }
+    plan.total_bytes = plan.vb_bytes + plan.mmz_bytes;
+    
+    if (common_pools > max_common_pools) {
+        plan.error = std::to_string(common_pools) + " common pools, at most " + std::to_string(max_common_pools);
+        return false;
+    }
+    if (plan.total_bytes > plan.budget_bytes) {
+        plan.error = "needs " + format_mb(plan.total_bytes) + " of mmz, "
+            + format_mb(plan.budget_bytes) + " available";
+        return false;
+    }
+    
+    plan.feasible = true;
+    return true;
+}
+
+std::string resource_manager::format_memory_plan(const memory_plan& plan) {
+    std::ostringstream oss;
+    char line[128];
+    for (const auto& pool : plan.pools) {
+        snprintf(line, sizeof(line), "vb  %-7s blk %9llu x %3u %10s ", pool.common ? "common" : "private",
+                (unsigned long long)pool.blk_size, pool.blk_cnt, format_mb(pool.blk_size * pool.blk_cnt).c_str());
+        oss << line;
+        for (size_t i = 0; i < pool.users.size(); ++i) {
+            oss << (i ? "," : "") << pool.users[i];
+        }
+        oss << "\n";
+    }
+    for (const auto& item : plan.mmz) {
+        snprintf(line, sizeof(line), "mmz %-28s %10s\n", item.name.c_str(), format_mb(item.bytes).c_str());
+        oss << line;
+    }
+    oss << "total " << format_mb(plan.total_bytes) << " (vb " << format_mb(plan.vb_bytes)
+        << ", mmz " << format_mb(plan.mmz_bytes) << ") of " << format_mb(plan.budget_bytes);
+    if (!plan.feasible && !plan.error.empty()) {
+        oss << ", " << plan.error;
+    }
+    oss << "\n";
+    return oss.str();
+}
+
 } // namespace device
 } // namespace hisilicon
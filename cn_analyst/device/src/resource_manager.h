@@ -1,9 +1,11 @@
 #ifndef RESOURCE_MANAGER_H
 #define RESOURCE_MANAGER_H
 
+#include "stream_config.h"
 #include <cstdint>
 #include <map>
 #include <mutex>
+#include <string>
 #include <vector>
 
 namespace hisilicon {
@@ -27,6 +29,8 @@ struct resource_limits {
     int32_t max_venc_channels;     // Default: 16
     int32_t max_h264_channels;     // Default: 12
     int32_t max_h265_channels;     // Default: 8
+    int32_t max_common_pools;      // Default: 16 (OT_VB_MAX_COMM_POOLS)
+    uint64_t mmz_bytes;            // Default: 1536MB, the mmz zone of the load script (2GB DDR, 512MB os)
     
     resource_limits()
         : max_vi_devices(4)
@@ -35,6 +39,8 @@ struct resource_limits {
         , max_venc_channels(16)
         , max_h264_channels(12)
         , max_h265_channels(8)
+        , max_common_pools(16)
+        , mmz_bytes(1536ULL * 1024 * 1024)
     {}
 };
 
@@ -53,6 +59,81 @@ struct resource_status {
     int32_t available_venc_channels;
 };
 
+/**
+ * @brief What the memory planner needs to know about one camera
+ *
+ * Filled from camera_config by camera_manager, the sensor size comes from
+ * the sensor name.
+ */
+struct memory_plan_camera {
+    int32_t camera_id;
+    int32_t sensor_width;
+    int32_t sensor_height;
+    bool wdr;                      // 2to1 wdr, two vi pipes
+    std::vector<stream_config> streams;
+    bool aiisp_enabled;
+    int32_t aiisp_mode;            // AIISP_MODE_BNR/DRC/3DNR
+    std::string aiisp_model;
+    bool yolov5_enabled;
+    std::string yolov5_model;
+    
+    memory_plan_camera()
+        : camera_id(-1)
+        , sensor_width(0)
+        , sensor_height(0)
+        , wdr(false)
+        , aiisp_enabled(false)
+        , aiisp_mode(0)
+        , yolov5_enabled(false)
+    {}
+};
+
+/**
+ * @brief One VB pool of the plan
+ *
+ * Common pools are shared by every user whose block fits without wasting
+ * more than 1/8 of the block, private pools belong to one module
+ * (aiisp, yolov5) like the ss_mpi_vb_create_pool calls they stand for.
+ */
+struct vb_pool_plan {
+    bool common;
+    uint64_t blk_size;
+    uint32_t blk_cnt;
+    std::vector<std::string> users;  // "camera0/vi_raw", ...
+    
+    vb_pool_plan() : common(true), blk_size(0), blk_cnt(0) {}
+};
+
+/**
+ * @brief One mmz allocation outside the VB pools (venc buffers, models)
+ */
+struct mmz_plan_item {
+    std::string name;
+    uint64_t bytes;
+};
+
+/**
+ * @brief Planned memory map of a set of cameras
+ */
+struct memory_plan {
+    std::vector<vb_pool_plan> pools;
+    std::vector<mmz_plan_item> mmz;
+    uint64_t vb_bytes;
+    uint64_t mmz_bytes;
+    uint64_t total_bytes;
+    uint64_t budget_bytes;
+    bool feasible;
+    std::string error;             // why it is not feasible
+    
+    memory_plan()
+        : vb_bytes(0)
+        , mmz_bytes(0)
+        , total_bytes(0)
+        , budget_bytes(0)
+        , feasible(false)
+    {}
+};
+
 /**
  * @brief Resource Manager - Tracks and allocates hardware resources
  * 
@@ -162,6 +243,33 @@ public:
      */
     static resource_limits get_limits();
     
+    // Memory Planning
+    
+    /**
+     * @brief Plan the VB pools and mmz allocations the cameras need
+     *
+     * Block sizes follow the pixel formats the device code sets up (12 bit raw,
+     * yuv420/422 8 bit, 32 byte stride), the venc reference frames and model sizes
+     * are estimates (the model file size when it can be read). Works without init,
+     * the limits are the defaults then.
+     * @param cameras Cameras sharing the board
+     * @param plan Output parameter for the plan, filled even when not feasible
+     * @return true if the plan fits max_common_pools and mmz_bytes
+     */
+    static bool plan_memory(const std::vector<memory_plan_camera>& cameras, memory_plan& plan);
+    
+    /**
+     * @brief The plan as text, one pool or allocation per line
+     * @param plan Memory plan
+     * @return Printable memory map
+     */
+    static std::string format_memory_plan(const memory_plan& plan);
+    
+    /**
+     * @brief Size of a yuv420 semiplanar 8 bit frame
+     */
+    static uint64_t yuv420_frame_size(int32_t width, int32_t height);
+    
 private:
     // Prevent instantiation
     resource_manager() = delete;
@@ -63,6 +63,13 @@ bool stream_config_helper::validate(const stream_config& config, std::string& er
         return false;
     }
     
+    // Check GOP
+    if (config.gop < 0) {
+        oss << "Invalid gop: " << config.gop << " (must be >= 0)";
+        error_msg = oss.str();
+        return false;
+    }
+    
     // Check output configuration
     if (!config.outputs.rtsp_enabled && 
         !config.outputs.rtmp_enabled && 
@@ -57,6 +57,8 @@ struct stream_config {
     int32_t height;
     int32_t framerate;
     int32_t bitrate;  // in Kbps
+    int32_t slice_lines;  // low latency slice size in macroblock rows, 0 for whole frames
+    int32_t gop;          // I frame interval in frames, 0 for one per second
     
     stream_output_config outputs;
     
@@ -67,6 +69,8 @@ struct stream_config {
         , height(1080)
         , framerate(30)
         , bitrate(4096)
+        , slice_lines(0)
+        , gop(0)
     {}
 };
 
@@ -0,0 +1,312 @@
+#include "config_service.h"
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fstream>
+#include <sstream>
+#include <exception>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+#include <sys/eventfd.h>
+
+namespace ceanic{namespace config{
+
+    config_file::config_file(const char* name,const char* path,const char* default_text)
+        :m_name(name),m_path(path),m_default_text(default_text ? default_text : "")
+    {
+    }
+
+    config_file::~config_file()
+    {
+    }
+
+    const std::string& config_file::name() const
+    {
+        return m_name;
+    }
+
+    const std::string& config_file::path() const
+    {
+        return m_path;
+    }
+
+    bool config_file::read(Json::Value* root)
+    {
+        std::string text;
+        std::ifstream ifs(m_path.c_str());
+        if(ifs.is_open())
+        {
+            std::stringstream ss;
+            ss << ifs.rdbuf();
+            text = ss.str();
+        }
+        else if(access(m_path.c_str(),F_OK) < 0 && !m_default_text.empty())
+        {
+            //first boot,the default text is written as it is and parsed from memory
+            std::ofstream ofs(m_path.c_str());
+            ofs << m_default_text;
+            if(!ofs.good())
+            {
+                printf("[%s]: write default %s failed\n",__FUNCTION__,m_path.c_str());
+            }
+            text = m_default_text;
+        }
+        else
+        {
+            printf("[%s]: open %s failed\n",__FUNCTION__,m_path.c_str());
+            return false;
+        }
+
+        Json::Reader reader;
+        if(!reader.parse(text,*root,false))
+        {
+            printf("[%s]: %s is not valid json\n",__FUNCTION__,m_path.c_str());
+            return false;
+        }
+        return true;
+    }
+
+    bool config_file::load(bool notify,std::vector<std::string>* applied)
+    {
+        std::unique_lock<std::mutex> lock(m_load_mu);
+        try
+        {
+            Json::Value root;
+            if(!read(&root))
+            {
+                return false;
+            }
+
+            if(!publish(root,notify,applied))
+            {
+                printf("[%s]: %s refused\n",__FUNCTION__,m_path.c_str());
+                return false;
+            }
+            return true;
+        }
+        catch(std::exception& e)
+        {
+            //jsoncpp throws on a value of the wrong type
+            printf("[%s]: %s:%s\n",__FUNCTION__,m_path.c_str(),e.what());
+            return false;
+        }
+    }
+
+    bool config_file::load()
+    {
+        return load(false,NULL);
+    }
+
+    bool config_file::load_text(const std::string& text)
+    {
+        std::unique_lock<std::mutex> lock(m_load_mu);
+        try
+        {
+            Json::Value root;
+            Json::Reader reader;
+            if(!reader.parse(text,root,false) || !publish(root,false,NULL))
+            {
+                printf("[%s]: default of %s refused\n",__FUNCTION__,m_path.c_str());
+                return false;
+            }
+            return true;
+        }
+        catch(std::exception& e)
+        {
+            printf("[%s]: default of %s:%s\n",__FUNCTION__,m_path.c_str(),e.what());
+            return false;
+        }
+    }
+
+    bool config_file::load_default()
+    {
+        if(m_default_text.empty())
+        {
+            return false;
+        }
+        return load_text(m_default_text);
+    }
+
+    bool config_file::reload(reload_result* result)
+    {
+        result->name = m_name;
+        result->applied.clear();
+        result->ok = load(true,&result->applied);
+        return result->ok;
+    }
+
+    config_service::config_service()
+        :m_inotify_fd(-1),m_wake_fd(-1),m_run(false)
+    {
+    }
+
+    config_service::~config_service()
+    {
+        stop_watch();
+    }
+
+    bool config_service::load_all()
+    {
+        bool ret = true;
+        for(size_t i = 0; i < m_files.size(); i++)
+        {
+            ret = m_files[i]->load() && ret;
+        }
+        return ret;
+    }
+
+    void config_service::set_observer(reload_observer observer)
+    {
+        m_observer = observer;
+    }
+
+    bool config_service::start_watch()
+    {
+        if(m_run)
+        {
+            return false;
+        }
+
+        m_inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        m_wake_fd = eventfd(0,EFD_NONBLOCK | EFD_CLOEXEC);
+        if(m_inotify_fd < 0 || m_wake_fd < 0)
+        {
+            printf("[%s]: inotify/eventfd failed,%s\n",__FUNCTION__,strerror(errno));
+            stop_watch();
+            return false;
+        }
+
+        //the directory and not the file,a rename replaces the inode a file watch sits on
+        m_dirs.clear();
+        for(size_t i = 0; i < m_files.size(); i++)
+        {
+            std::string dir = ".";
+            size_t pos = m_files[i]->path().rfind('/');
+            if(pos != std::string::npos)
+            {
+                dir = pos == 0 ? "/" : m_files[i]->path().substr(0,pos);
+            }
+
+            int wd = inotify_add_watch(m_inotify_fd,dir.c_str(),IN_CLOSE_WRITE | IN_MOVED_TO);
+            if(wd < 0)
+            {
+                printf("[%s]: watch %s failed,%s\n",__FUNCTION__,dir.c_str(),strerror(errno));
+                continue;
+            }
+            m_dirs[wd] = dir;
+        }
+
+        m_run = true;
+        m_thread = std::thread(&config_service::on_watch,this);
+        return true;
+    }
+
+    void config_service::stop_watch()
+    {
+        m_run = false;
+        if(m_wake_fd >= 0)
+        {
+            uint64_t one = 1;
+            if(write(m_wake_fd,&one,sizeof(one)) < 0)
+            {
+                printf("[%s]: wake failed,%s\n",__FUNCTION__,strerror(errno));
+            }
+        }
+
+        if(m_thread.joinable())
+        {
+            m_thread.join();
+        }
+
+        if(m_inotify_fd >= 0)
+        {
+            close(m_inotify_fd);
+            m_inotify_fd = -1;
+        }
+        if(m_wake_fd >= 0)
+        {
+            close(m_wake_fd);
+            m_wake_fd = -1;
+        }
+    }
+
+    void config_service::handle_events(const char* buf,ssize_t len,std::vector<std::shared_ptr<config_file>>* changed)
+    {
+        const char* p = buf;
+        while(p < buf + len)
+        {
+            const struct inotify_event* ev = (const struct inotify_event*)p;
+            p += sizeof(struct inotify_event) + ev->len;
+
+            std::map<int,std::string>::iterator dir = m_dirs.find(ev->wd);
+            if(ev->len == 0 || dir == m_dirs.end())
+            {
+                continue;
+            }
+
+            std::string path = dir->second == "/" ? "/" + std::string(ev->name) : dir->second + "/" + ev->name;
+            for(size_t i = 0; i < m_files.size(); i++)
+            {
+                if(m_files[i]->path() == path)
+                {
+                    bool found = false;
+                    for(size_t k = 0; k < changed->size(); k++)
+                    {
+                        found = found || (*changed)[k] == m_files[i];
+                    }
+                    if(!found)
+                    {
+                        changed->push_back(m_files[i]);
+                    }
+                }
+            }
+        }
+    }
+
+    void config_service::on_watch()
+    {
+        char buf[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+        struct pollfd fds[2];
+        fds[0].fd = m_inotify_fd;
+        fds[0].events = POLLIN;
+        fds[1].fd = m_wake_fd;
+        fds[1].events = POLLIN;
+
+        while(m_run)
+        {
+            int ret = poll(fds,2,-1);
+            if(ret < 0 && errno != EINTR)
+            {
+                printf("[%s]: poll failed,%s\n",__FUNCTION__,strerror(errno));
+                break;
+            }
+            if(ret <= 0 || !(fds[0].revents & POLLIN))
+            {
+                continue;
+            }
+
+            //an editor saving makes several events,the ones that came within 50ms make one reload
+            std::vector<std::shared_ptr<config_file>> changed;
+            do
+            {
+                ssize_t len;
+                while((len = read(m_inotify_fd,buf,sizeof(buf))) > 0)
+                {
+                    handle_events(buf,len,&changed);
+                }
+            }while(m_run && poll(fds,1,50) > 0);
+
+            for(size_t i = 0; m_run && i < changed.size(); i++)
+            {
+                reload_result result;
+                changed[i]->reload(&result);
+                if(m_observer)
+                {
+                    m_observer(result);
+                }
+            }
+        }
+    }
+
+}}//namespace
@@ -0,0 +1,185 @@
+#ifndef config_service_include_h
+#define config_service_include_h
+
+#include <stdint.h>
+#include <sys/types.h>
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <functional>
+#include <json/json.h>
+
+namespace ceanic{namespace config{
+
+    typedef struct
+    {
+        std::string name;
+        bool ok;                            //false:the file is broken or invalid,the old values stay
+        std::vector<std::string> applied;   //the subsystems told about their changed settings
+    }reload_result;
+
+    typedef std::function<void(const reload_result&)> reload_observer;
+
+    //one json file of the app.a missing file is written from its default text,
+    //the default is parsed from memory,never written and read back
+    class config_file
+    {
+        public:
+            config_file(const char* name,const char* path,const char* default_text);
+            virtual ~config_file();
+
+            const std::string& name() const;
+            const std::string& path() const;
+
+            //reads and publishes the file.false when it is broken or invalid,the values stay then
+            bool load();
+
+            //publishes the default text,for a file refused at startup.the file is left alone
+            bool load_default();
+
+            //load() for the watcher,the subscribers whose settings changed are called
+            bool reload(reload_result* result);
+
+        protected:
+            //parses root and publishes the new values,adds the subscribers called to applied when notify
+            virtual bool publish(const Json::Value& root,bool notify,std::vector<std::string>* applied) = 0;
+
+        private:
+            bool read(Json::Value* root);
+            bool load(bool notify,std::vector<std::string>* applied);
+            bool load_text(const std::string& text);
+
+        private:
+            std::string m_name;
+            std::string m_path;
+            std::string m_default_text;
+            std::mutex m_load_mu;
+    };
+
+    //the file parsed into T.readers take the current values with one atomic load,
+    //a reload publishes a new T and leaves the one a reader holds alone
+    template<typename T>
+    class typed_file : public config_file
+    {
+        public:
+            typedef std::shared_ptr<const T> value_ptr;
+            //fills value(zeroed before) from root and checks it,false refuses the file
+            typedef std::function<bool(const Json::Value& root,T* value)> parse_fun;
+            //true when the settings a subsystem runs with differ
+            typedef std::function<bool(const T& old_value,const T& new_value)> diff_fun;
+            typedef std::function<void(const T& old_value,const T& new_value)> apply_fun;
+
+        public:
+            typed_file(const char* name,const char* path,const char* default_text,parse_fun parse)
+                :config_file(name,path,default_text),m_parse(parse),m_value(std::make_shared<T>())
+            {
+            }
+
+            //zeroed until the first load succeeded
+            value_ptr get() const
+            {
+                return std::atomic_load(&m_value);
+            }
+
+            //apply runs on the watch thread,in the order of subscribe,when a reload
+            //changes what changed compares.subscribe before start_watch
+            void subscribe(const char* subsystem,diff_fun changed,apply_fun apply)
+            {
+                subscriber_t sub;
+                sub.subsystem = subsystem;
+                sub.changed = changed;
+                sub.apply = apply;
+                m_subscribers.push_back(sub);
+            }
+
+        protected:
+            bool publish(const Json::Value& root,bool notify,std::vector<std::string>* applied) override
+            {
+                std::shared_ptr<T> value = std::make_shared<T>();
+                if(!m_parse(root,value.get()))
+                {
+                    return false;
+                }
+
+                value_ptr old = get();
+                std::atomic_store(&m_value,value_ptr(value));
+                for(size_t i = 0; notify && i < m_subscribers.size(); i++)
+                {
+                    if(m_subscribers[i].changed(*old,*value))
+                    {
+                        m_subscribers[i].apply(*old,*value);
+                        applied->push_back(m_subscribers[i].subsystem);
+                    }
+                }
+                return true;
+            }
+
+        private:
+            typedef struct
+            {
+                std::string subsystem;
+                diff_fun changed;
+                apply_fun apply;
+            }subscriber_t;
+
+            parse_fun m_parse;
+            value_ptr m_value;
+            std::vector<subscriber_t> m_subscribers;
+    };
+
+    //the config files of the app and the thread reloading them.
+    //the directories of the files are watched with inotify,a file closed after writing
+    //or moved in(editors save to a temporary file and rename it) is reloaded,
+    //several events of one file in a row make one reload
+    class config_service
+    {
+        public:
+            config_service();
+            virtual ~config_service();
+
+            config_service(const config_service&) = delete;
+            config_service& operator=(const config_service&) = delete;
+
+        public:
+            //add the files before start_watch
+            template<typename T>
+            std::shared_ptr<typed_file<T>> add(const char* name,const char* path,const char* default_text,
+                    typename typed_file<T>::parse_fun parse)
+            {
+                std::shared_ptr<typed_file<T>> file = std::make_shared<typed_file<T>>(name,path,default_text,parse);
+                m_files.push_back(file);
+                return file;
+            }
+
+            //load() of every file,false when one failed
+            bool load_all();
+
+            //called on the watch thread after every reload
+            void set_observer(reload_observer observer);
+
+            bool start_watch();
+            void stop_watch();
+
+        private:
+            void on_watch();
+            //the files of the events read,each once
+            void handle_events(const char* buf,ssize_t len,std::vector<std::shared_ptr<config_file>>* changed);
+
+        private:
+            std::vector<std::shared_ptr<config_file>> m_files;
+            std::map<int,std::string> m_dirs;   //watch descriptor->directory
+            reload_observer m_observer;
+
+            int m_inotify_fd;
+            int m_wake_fd;
+            std::atomic<bool> m_run;
+            std::thread m_thread;
+    };
+
+}}//namespace
+
+#endif
@@ -6,11 +6,12 @@
 #include <codecvt>
 #include "dev_log.h"
 
-static std::vector<basic_char_t> g_basic_chars;
+//glyphs by font size and code point
+static std::unordered_map<uint64_t,basic_char_t> g_basic_chars;
 static std::mutex g_freetype_mutex;
 
 ceanic_freetype::ceanic_freetype(const char* font_path)
-	:m_font_path(font_path),m_inited(false)
+	:m_inited(false),m_font_path(font_path)
 {
 }
 
@@ -21,17 +22,13 @@ ceanic_freetype::~ceanic_freetype()
 
 bool ceanic_freetype::get_glyph_char(wchar_t c,int32_t font_size,basic_char_t* char_info)
 {
-    std::unique_lock<std::mutex> lock(g_freetype_mutex);
-
-	for(uint32_t i = 0; i < g_basic_chars.size(); i++)
-	{
-		if(g_basic_chars[i].c == c
-				&& g_basic_chars[i].font_size == font_size)
-		{
-			*char_info =  g_basic_chars[i];
-			return true;
-		}
-	}
+    uint64_t key = ((uint64_t)font_size << 32) | (uint32_t)c;
+    auto it = g_basic_chars.find(key);
+    if(it != g_basic_chars.end())
+    {
+        *char_info = it->second;
+        return true;
+    }
 
     FT_Face glyph_face =  m_ft_face;
 	FT_Error error = FT_Set_Pixel_Sizes(glyph_face,font_size,0);
@@ -62,7 +59,7 @@ bool ceanic_freetype::get_glyph_char(wchar_t c,int32_t font_size,basic_char_t* c
         basic_char.top = font_size;
     }
 
-    g_basic_chars.push_back(basic_char);
+    g_basic_chars[key] = basic_char;
 
     *char_info = basic_char;
 	return true;
@@ -100,6 +97,16 @@ void ceanic_freetype::release()
 {
 	if(is_init())
 	{
+        std::unique_lock<std::mutex> lock(g_freetype_mutex);
+        for(auto it = g_basic_chars.begin(); it != g_basic_chars.end(); it++)
+        {
+            FT_Done_Glyph(it->second.glyph_ori);
+            FT_Done_Glyph(it->second.glyph_outline);
+        }
+        g_basic_chars.clear();
+        m_tiles.clear();
+        m_atlas.clear();
+
 		FT_Done_Face(m_ft_face);
 		FT_Done_FreeType(m_ft_lib);
 		m_inited = false;
@@ -119,10 +126,13 @@ bool ceanic_freetype::get_width(const char* str,int32_t font_pixel,int* w)
     std::wstring wstr = conv.from_bytes(str);
 
     basic_char_t char_info;
-    
+    std::unique_lock<std::mutex> lock(g_freetype_mutex);
     for(uint32_t i = 0; i < wstr.size(); i++)
     {
-        get_glyph_char(wstr[i],font_pixel,&char_info);
+        if(!get_glyph_char(wstr[i],font_pixel,&char_info))
+        {
+            continue;
+        }
 
         *w +=  char_info.w;
     }
@@ -143,10 +153,13 @@ bool ceanic_freetype::get_max_width(const char* str,int32_t font_pixel,int* w)
     std::wstring wstr = conv.from_bytes(str);
 
     basic_char_t char_info;
-    
+    std::unique_lock<std::mutex> lock(g_freetype_mutex);
     for(uint32_t i = 0; i < wstr.size(); i++)
     {
-        get_glyph_char(wstr[i],font_pixel,&char_info);
+        if(!get_glyph_char(wstr[i],font_pixel,&char_info))
+        {
+            continue;
+        }
 
         if(char_info.w > *w)
         {
@@ -162,34 +175,21 @@ bool ceanic_freetype::show_string(const char* str,int32_t area_w,int32_t area_h,
     std::wstring_convert<std::codecvt_utf8<wchar_t>> conv;
     std::wstring wstr = conv.from_bytes(str);
 
-    basic_char_t char_info;
+    std::unique_lock<std::mutex> lock(g_freetype_mutex);
 
 	int32_t startx=0;
-    int32_t starty = 0;
 	for(uint32_t i = 0; i < wstr.size(); i++)
 	{
-		if(!get_glyph_char(wstr[i],font_pixel,&char_info))
+        const glyph_tile_t* tile = get_tile(wstr[i],font_pixel,area_h,bg_color,fg_color,outline_color);
+		if(!tile)
 		{
             DEV_WRITE_LOG_ERROR("get_glyph failed");
 			continue;
 		}
 
-        starty = char_info.top;
-
-		draw_rgb1555_char(area_w,
-                area_h,
-                char_info.w,
-                char_info.glyph_ori,
-                char_info.glyph_outline,
-                startx,
-                starty,
-                pdata,
-                data_size,
-                bg_color,
-                fg_color,
-                outline_color);
-
-        startx += char_info.w;
+        blit_tile(tile,area_w,area_h,startx,pdata,data_size);
+
+        startx += tile->w;
         if(startx > area_w)
         {
             DEV_WRITE_LOG_ERROR("unexpcepted error,startx:%d,area_w:%d",startx,area_w);
@@ -212,49 +212,115 @@ bool ceanic_freetype::show_string_compare(const char* str_before,const char* str
 		return false;
 	}
 
+    std::unique_lock<std::mutex> lock(g_freetype_mutex);
+
 	int32_t startx =0;
-    int32_t starty =0;
 	bool draw_char = false;
-    basic_char_t char_info;
 	for(uint32_t i = 0; i < wstr_cur.size(); i++)
 	{
-		//从i之后的所有字符都要修改
-		if(wstr_cur[i] != wstr_before[i])
-		{
-			draw_char = true;
-		}
+        bool changed = !draw_char && wstr_cur[i] != wstr_before[i];
+        int32_t before_w = -1;
+        if(changed)
+        {
+            //looked up first,a full atlas starts over and only the last tile stays valid
+            const glyph_tile_t* tile_before = get_tile(wstr_before[i],font_pixel,area_h,bg_color,fg_color,outline_color);
+            before_w = tile_before ? tile_before->w : -1;
+        }
 
-        if(!get_glyph_char(wstr_cur[i],font_pixel,&char_info))
+        const glyph_tile_t* tile = get_tile(wstr_cur[i],font_pixel,area_h,bg_color,fg_color,outline_color);
+        if(!tile)
         {
             DEV_WRITE_LOG_ERROR("get_glyph failed");
             continue;
         }
 
+		if(changed)
+		{
+            //same advance,only this cell changes
+            if(before_w == tile->w)
+            {
+                blit_tile(tile,area_w,area_h,startx,pdata,data_size);
+                startx += tile->w;
+                continue;
+            }
+
+            //从i之后的所有字符都要修改
+			draw_char = true;
+		}
+
 		if(draw_char)
 		{
-            starty = char_info.top;
-
-			draw_rgb1555_char(area_w,
-                    area_h,
-                    char_info.w,
-                    char_info.glyph_ori,
-                    char_info.glyph_outline,
-                    startx,
-                    starty,
-                    pdata,
-                    data_size,
-                    bg_color,
-                    fg_color,
-                    outline_color);
+            blit_tile(tile,area_w,area_h,startx,pdata,data_size);
         }
 
-        startx += char_info.w;
+        startx += tile->w;
     }
 
 	return true;
 }
 
+bool ceanic_freetype::prewarm(const char* str,int32_t area_h,int32_t font_pixel,int16_t bg_color,int16_t fg_color,int16_t outline_color)
+{
+    if(!is_init())
+    {
+        return false;
+    }
 
+    std::wstring_convert<std::codecvt_utf8<wchar_t>> conv;
+    std::wstring wstr = conv.from_bytes(str);
+
+    std::unique_lock<std::mutex> lock(g_freetype_mutex);
+    for(uint32_t i = 0; i < wstr.size(); i++)
+    {
+        if(!get_tile(wstr[i],font_pixel,area_h,bg_color,fg_color,outline_color))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void ceanic_freetype::atlas_info(uint32_t* tiles,uint32_t* pixels)
+{
+    std::unique_lock<std::mutex> lock(g_freetype_mutex);
+    *tiles = m_tiles.size();
+    *pixels = m_atlas.size();
+}
+
+const glyph_tile_t* ceanic_freetype::get_tile(wchar_t c,int32_t font_size,int32_t area_h,int16_t bg_color,int16_t fg_color,int16_t outline_color)
+{
+    glyph_tile_key_t key = {c,font_size,FREETYPE_OUTLINE_PIXEL,area_h,bg_color,fg_color,outline_color};
+    auto it = m_tiles.find(key);
+    if(it != m_tiles.end())
+    {
+        return &it->second;
+    }
+
+    basic_char_t char_info;
+    if(!get_glyph_char(c,font_size,&char_info))
+    {
+        return NULL;
+    }
+
+    glyph_tile_t tile;
+    tile.w = char_info.w;
+    tile.h = area_h;
+    uint32_t pixels = tile.w * tile.h;
+    if(m_atlas.size() + pixels > FREETYPE_ATLAS_MAX_PIXELS)
+    {
+        //too many sizes or colors,start over with what is drawn from now on
+        DEV_WRITE_LOG_INFO("glyph atlas full(%u tiles),reset",(uint32_t)m_tiles.size());
+        m_tiles.clear();
+        m_atlas.clear();
+    }
+
+    tile.offset = m_atlas.size();
+    m_atlas.resize(m_atlas.size() + pixels);
+    draw_rgb1555_tile(char_info,area_h,m_atlas.data() + tile.offset,bg_color,fg_color,outline_color);
+
+    return &(m_tiles[key] = tile);
+}
 bool ceanic_freetype::get_glyph(FT_Face face,FT_ULong ch,FT_Glyph* orig,FT_Glyph* outline)
 {
     float outline_pixel = 1.0;
@@ -308,40 +374,58 @@ fail:
 
 extern int32_t rgb24to1555(int32_t r,int32_t g,int32_t b,int32_t a);
 #define SHOW_LEVEL (5)
-bool ceanic_freetype::draw_rgb1555_char(int32_t area_w,int32_t area_h,int32_t font_pixel,FT_Glyph orig,FT_Glyph outline,int32_t startx,int32_t starty,unsigned char* buf,int32_t size,int16_t bg_color,int16_t fg_color,int16_t outline_color)
+void ceanic_freetype::draw_rgb1555_tile(const basic_char_t& char_info,int32_t area_h,uint16_t* tile,int16_t bg_color,int16_t fg_color,int16_t outline_color)
 {
-	FT_Bitmap * orig_bitmap = &((FT_BitmapGlyph)orig)->bitmap; 
-	FT_Bitmap * outline_bitmap = &((FT_BitmapGlyph)outline)->bitmap; 
-	unsigned char *pdata;
+	FT_Bitmap * orig_bitmap = &((FT_BitmapGlyph)char_info.glyph_ori)->bitmap; 
+	FT_Bitmap * outline_bitmap = &((FT_BitmapGlyph)char_info.glyph_outline)->bitmap; 
 
 	int32_t h_offset = (outline_bitmap->width - orig_bitmap->width) >> 1;
 	int32_t v_offset = (outline_bitmap->rows - orig_bitmap->rows) >> 1;
-    int32_t total_width = font_pixel;
+    int32_t total_width = char_info.w;
+    int32_t starty = char_info.top;
 
     for(int32_t i = 0; i < area_h; i++)
     {
         for (int32_t  j = 0 ; j < total_width;  ++j)  
         {
-			pdata = buf + i * area_w * 2 + (startx + j) * 2;//RGB1555,so need to *2
+            uint16_t* pdata = tile + i * total_width + j;
 
-            *(short*)pdata = bg_color;
+            *pdata = bg_color;
 
             if (j >= h_offset 
                     && j < (int32_t)orig_bitmap->width + h_offset 
                     && i >= starty + v_offset 
                     && i < (int32_t)orig_bitmap->rows + starty + v_offset)
             {
-                if (orig_bitmap->buffer[(i-starty-v_offset)*orig_bitmap->width+j-h_offset] >= SHOW_LEVEL)
+                if (orig_bitmap->buffer[(i-starty-v_offset)*orig_bitmap->pitch+j-h_offset] >= SHOW_LEVEL)
                 {
-                    *(short*)pdata = fg_color;
+                    *pdata = fg_color;
                 }
-                else if (outline_bitmap->buffer[(i-starty)*outline_bitmap->width+j] >= SHOW_LEVEL)
+                else if (i - starty < (int32_t)outline_bitmap->rows
+                        && j < (int32_t)outline_bitmap->width
+                        && outline_bitmap->buffer[(i-starty)*outline_bitmap->pitch+j] >= SHOW_LEVEL)
                 {
-                    *(short*)pdata = outline_color;
+                    *pdata = outline_color;
                 }
             }
         }
     }
-	
-	return true;
+}
+
+void ceanic_freetype::blit_tile(const glyph_tile_t* tile,int32_t area_w,int32_t area_h,int32_t startx,unsigned char* buf,int32_t size)
+{
+    //a whole row of the tile at once,clipped to the area and the buffer
+    int32_t copy_w = std::min(tile->w,area_w - startx);
+    int32_t rows = std::min(tile->h,area_h);
+    const uint16_t* src = m_atlas.data() + tile->offset;
+    for(int32_t i = 0; i < rows && copy_w > 0; i++)
+    {
+        int32_t pos = (i * area_w + startx) * 2;//RGB1555,so need to *2
+        if(pos + copy_w * 2 > size)
+        {
+            break;
+        }
+
+        memcpy(buf + pos,src + i * tile->w,copy_w * 2);
+    }
 }
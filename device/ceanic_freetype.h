@@ -7,8 +7,15 @@
 #include FT_GLYPH_H
 #include FT_STROKER_H
 #include <string>
+#include <vector>
+#include <unordered_map>
 //#include <glib.h>
 
+//outline stroked around every glyph,in pixels
+#define FREETYPE_OUTLINE_PIXEL 1
+//the atlas starts over when it would grow past this(in ARGB1555 pixels)
+#define FREETYPE_ATLAS_MAX_PIXELS (1024 * 1024)
+
 typedef struct
 {
 	wchar_t c;
@@ -20,6 +27,45 @@ typedef struct
     int32_t w;
 }basic_char_t;
 
+//a glyph drawn once with its colors,area_h rows of w(advance) pixels
+typedef struct
+{
+    wchar_t c;
+    int32_t font_size;
+    int32_t outline;
+    int32_t area_h;
+    short bg_color;
+    short fg_color;
+    short outline_color;
+}glyph_tile_key_t;
+
+typedef struct
+{
+    size_t operator()(const glyph_tile_key_t& k) const
+    {
+        uint64_t v = ((uint64_t)(uint32_t)k.c << 32) ^ ((uint64_t)k.font_size << 20) ^ ((uint64_t)k.area_h << 8) ^ k.outline;
+        uint64_t color = ((uint64_t)(uint16_t)k.bg_color << 32) | ((uint32_t)(uint16_t)k.fg_color << 16) | (uint16_t)k.outline_color;
+        return std::hash<uint64_t>()(v) ^ (std::hash<uint64_t>()(color) << 1);
+    }
+}glyph_tile_hash_t;
+
+typedef struct
+{
+    bool operator()(const glyph_tile_key_t& a,const glyph_tile_key_t& b) const
+    {
+        return a.c == b.c && a.font_size == b.font_size && a.outline == b.outline && a.area_h == b.area_h
+            && a.bg_color == b.bg_color && a.fg_color == b.fg_color && a.outline_color == b.outline_color;
+    }
+}glyph_tile_equal_t;
+
+typedef struct
+{
+    //in pixels from the start of the atlas
+    uint32_t offset;
+    int32_t w;
+    int32_t h;
+}glyph_tile_t;
+
 class ceanic_freetype
 {
 public:
@@ -41,30 +87,42 @@ public:
 
 	bool show_string_compare(const char* str_before,const char* str_now,int32_t area_w,int32_t area_h,int32_t font_pixel,unsigned char* pdata,int32_t data_size,short bg_clor,short fg_color,short outline_color);
 
+    //draw the tiles of str ahead of time,e.g. digits and week days before the date osd starts
+    bool prewarm(const char* str,int32_t area_h,int32_t font_pixel,short bg_color,short fg_color,short outline_color);
+
+    //tiles and pixels held by the atlas
+    void atlas_info(uint32_t* tiles,uint32_t* pixels);
+
 private:
+    //g_freetype_mutex held by the callers
     bool get_glyph_char(wchar_t c,int32_t font_size,basic_char_t* char_info);
 	bool get_glyph(FT_Face face,FT_ULong ch,FT_Glyph* org,FT_Glyph* outline);
 
-	bool draw_rgb1555_char(int32_t area_w,
+    const glyph_tile_t* get_tile(wchar_t c,int32_t font_size,int32_t area_h,short bg_color,short fg_color,short outline_color);
+
+	void draw_rgb1555_tile(const basic_char_t& char_info,
             int32_t area_h,
-            int32_t font_pixel,
-            FT_Glyph orig,
-            FT_Glyph outline,
-            int32_t startx,
-            int32_t starty,
-            unsigned char* buf,
-            int32_t size,
+            uint16_t* tile,
             short bg_color,
             short fg_color,
             short outline_color);
 
-	bool get_basic_char(wchar_t c,int32_t font_size,basic_char_t& char_info);
+    void blit_tile(const glyph_tile_t* tile,
+            int32_t area_w,
+            int32_t area_h,
+            int32_t startx,
+            unsigned char* buf,
+            int32_t size);
 
 private:
 	bool m_inited;
 	std::string m_font_path;
 	FT_Library  m_ft_lib;
 	FT_Face		m_ft_face;
+
+    //ready to copy ARGB1555 tiles of every glyph drawn so far
+    std::vector<uint16_t> m_atlas;
+    std::unordered_map<glyph_tile_key_t,glyph_tile_t,glyph_tile_hash_t,glyph_tile_equal_t> m_tiles;
 };
 
 #endif
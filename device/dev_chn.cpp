@@ -13,7 +13,7 @@ namespace hisilicon{namespace dev{
     rate_auto_param chn::g_rate_auto_param;
 
     chn::chn(const char* vi_name,const char* venc_mode,int chn_no)
-        :m_is_start(false),m_vi_name(vi_name),m_chn(chn_no),m_venc_mode(venc_mode)
+        :m_is_start(false),m_vi_name(vi_name),m_aiisp_mode(-1),m_chn(chn_no),m_venc_mode(venc_mode)
     {
     }
 
@@ -22,7 +22,7 @@ namespace hisilicon{namespace dev{
         stop();
     }
 
-    bool chn::start(int venc_w,int venc_h,int fr,int bitrate)
+    bool chn::start(int venc_w,int venc_h,int fr,int bitrate,int slice_lines)
     {
         if(m_is_start)
         {
@@ -45,6 +45,12 @@ namespace hisilicon{namespace dev{
         {
             m_vi_ptr = std::make_shared<vi_os08a20_2to1wdr>();
         }
+#ifdef CEANIC_SDK_SIM
+        else if(m_vi_name == "SIM")
+        {
+            m_vi_ptr = std::make_shared<vi_sim>();
+        }
+#endif
         else
         {
             DEV_WRITE_LOG_ERROR("unsupport sensor name=%s",m_vi_name.c_str());
@@ -94,6 +100,7 @@ namespace hisilicon{namespace dev{
             return false;
         }
 
+        m_venc_main_ptr->set_slice_lines(slice_lines);
         if(!m_venc_main_ptr->start(m_vi_ptr->vpss_grp(), m_vi_ptr->vpss_chn())
                 || !m_venc_sub_ptr->start(m_vi_ptr->vpss_grp(), m_vi_ptr->vpss_chn()))
         {
@@ -132,6 +139,7 @@ namespace hisilicon{namespace dev{
         if(m_snap)
         {
             m_snap->stop();
+            m_snap = nullptr;
         }
 
         if(m_vo)
@@ -140,6 +148,8 @@ namespace hisilicon{namespace dev{
             m_vo = nullptr;
         }
 
+        stop_mjpeg();
+
         m_osd_date_main->stop();
         m_osd_date_sub->stop();
 
@@ -157,7 +167,94 @@ namespace hisilicon{namespace dev{
         g_chns[m_chn] = nullptr;
     }
 
-    bool chn::start_save(const char* file)
+    bool chn::reconfigure_stream(int stream,int venc_w,int venc_h,int fr,int bitrate,int gop)
+    {
+        if(!m_is_start || (stream != MAIN_STREAM_ID && stream != SUB_STREAM_ID))
+        {
+            return false;
+        }
+
+        if(venc_w > m_vi_ptr->w()
+                || venc_h > m_vi_ptr->h()
+                || fr > m_vi_ptr->fr())
+        {
+            DEV_WRITE_LOG_ERROR("invalid param");
+            return false;
+        }
+
+        std::shared_ptr<venc> venc_ptr = (stream == MAIN_STREAM_ID) ? m_venc_main_ptr : m_venc_sub_ptr;
+        std::shared_ptr<osd_date> osd_ptr = (stream == MAIN_STREAM_ID) ? m_osd_date_main : m_osd_date_sub;
+        std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+
+        if((fr != venc_ptr->venc_fr() || bitrate != venc_ptr->venc_bitrate() || (gop ? gop : fr) != venc_ptr->venc_gop())
+                && !venc_ptr->set_rc(fr,bitrate,gop))
+        {
+            return false;
+        }
+
+        bool ret = true;
+        if(venc_w != venc_ptr->venc_w() || venc_h != venc_ptr->venc_h())
+        {
+            //the date goes back onto the channel,it may have been rebuilt
+            osd_ptr->stop();
+            ret = venc_ptr->set_size(venc_w,venc_h);
+            osd_ptr->start();
+
+            if(stream == MAIN_STREAM_ID && m_save)
+            {
+                DEV_WRITE_LOG_INFO("chn %d recording keeps its old video head until it is started again",m_chn);
+            }
+        }
+
+        int64_t us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - begin).count();
+        DEV_WRITE_LOG_INFO("chn %d stream %d %dx%d@%d %dkbps gop %d %s,%lldus",m_chn,stream,venc_ptr->venc_w(),venc_ptr->venc_h(),
+            venc_ptr->venc_fr(),venc_ptr->venc_bitrate(),venc_ptr->venc_gop(),ret ? "ok" : "failed",(long long)us);
+        return ret;
+    }
+
+    bool chn::start_mjpeg(int w,int h,int fr,int quality)
+    {
+        if(!m_is_start || m_venc_mjpeg_ptr)
+        {
+            return false;
+        }
+
+        if(w > m_vi_ptr->w()
+                || h > m_vi_ptr->h()
+                || fr > m_vi_ptr->fr()
+                || quality < 1
+                || quality > 99)
+        {
+            DEV_WRITE_LOG_ERROR("invalid mjpeg param");
+            return false;
+        }
+
+        m_venc_mjpeg_ptr = std::make_shared<venc_mjpeg>(m_chn,MJPEG_STREAM_ID,w,h,m_vi_ptr->fr(),fr,m_vi_ptr->vpss_grp(),m_vi_ptr->vpss_chn(),quality);
+        if(!m_venc_mjpeg_ptr->start(m_vi_ptr->vpss_grp(), m_vi_ptr->vpss_chn()))
+        {
+            DEV_WRITE_LOG_ERROR("mjpeg venc start failed");
+            m_venc_mjpeg_ptr->stop();
+            m_venc_mjpeg_ptr = nullptr;
+            return false;
+        }
+
+        m_venc_mjpeg_ptr->register_stream_observer(shared_from_this());
+        return true;
+    }
+
+    void chn::stop_mjpeg()
+    {
+        if(!m_venc_mjpeg_ptr)
+        {
+            return;
+        }
+
+        m_venc_mjpeg_ptr->unregister_stream_observer(shared_from_this());
+        m_venc_mjpeg_ptr->stop();
+        m_venc_mjpeg_ptr = nullptr;
+    }
+
+    bool chn::start_save(const char* file,const ceanic::stream_save::mp4_save_param* param)
     {
         if(!m_is_start)
         {
@@ -170,7 +267,7 @@ namespace hisilicon{namespace dev{
             return false;
         }
 
-        m_save = std::make_shared<ceanic::stream_save::mp4_save>(mh,file);
+        m_save = std::make_shared<ceanic::stream_save::mp4_save>(mh,file,param);
 
         return m_save->open();
     }
@@ -184,6 +281,87 @@ namespace hisilicon{namespace dev{
         }
     }
 
+    bool chn::start_fmp4_save(const char* file,const ceanic::stream_save::fmp4_save_param* param)
+    {
+        if(!m_is_start || m_save)
+        {
+            return false;
+        }
+
+        ceanic::util::media_head mh;
+        if(!get_stream_head(m_chn,MAIN_STREAM_ID,&mh))
+        {
+            return false;
+        }
+
+        std::shared_ptr<ceanic::stream_save::fmp4_save> save = std::make_shared<ceanic::stream_save::fmp4_save>(mh,file,param);
+        if(!save->open())
+        {
+            return false;
+        }
+
+        m_save = save;
+        return true;
+    }
+
+    bool chn::start_pool_save(const ceanic::stream_save::segment_pool_param* pool_param,const ceanic::stream_save::fmp4_save_param* param)
+    {
+        if(!m_is_start || m_save)
+        {
+            return false;
+        }
+
+        ceanic::util::media_head mh;
+        if(!get_stream_head(m_chn,MAIN_STREAM_ID,&mh))
+        {
+            return false;
+        }
+
+        std::shared_ptr<ceanic::stream_save::segment_pool> pool = std::make_shared<ceanic::stream_save::segment_pool>(pool_param);
+        std::shared_ptr<ceanic::stream_save::fmp4_save> save = std::make_shared<ceanic::stream_save::fmp4_save>(mh,pool,param);
+        if(!save->open())
+        {
+            return false;
+        }
+
+        m_save = save;
+        return true;
+    }
+
+    bool chn::start_event_save(const ceanic::stream_save::event_save_param* param)
+    {
+        if(!m_is_start || m_save)
+        {
+            return false;
+        }
+
+        ceanic::util::media_head mh;
+        if(!get_stream_head(m_chn,MAIN_STREAM_ID,&mh))
+        {
+            return false;
+        }
+
+        std::shared_ptr<ceanic::stream_save::event_save> save = std::make_shared<ceanic::stream_save::event_save>(mh,param);
+        if(!save->open())
+        {
+            return false;
+        }
+
+        m_save = save;
+        return true;
+    }
+
+    bool chn::trigger_event(const char* reason)
+    {
+        std::shared_ptr<ceanic::stream_save::event_save> save = std::dynamic_pointer_cast<ceanic::stream_save::event_save>(m_save);
+        if(!save)
+        {
+            return false;
+        }
+
+        return save->trigger(reason);
+    }
+
     void chn::start_capture(bool enable)
     {
         if(enable)
@@ -220,6 +398,16 @@ namespace hisilicon{namespace dev{
     }
 
     void chn::on_stream_come(ceanic::util::stream_obj_ptr sobj,ceanic::util::stream_head* head, const char* buf, int32_t len)
+    {
+        process_stream(sobj,head,buf,len,nullptr);
+    }
+
+    void chn::on_frame_come(ceanic::util::stream_obj_ptr sobj,ceanic::util::stream_frame_ptr frame)
+    {
+        process_stream(sobj,frame->head(),NULL,0,frame);
+    }
+
+    void chn::process_stream(ceanic::util::stream_obj_ptr sobj,ceanic::util::stream_head* head, const char* buf, int32_t len,ceanic::util::stream_frame_ptr frame)
     {
         if(!m_is_start)
         {
@@ -230,6 +418,14 @@ namespace hisilicon{namespace dev{
         int32_t stream = sobj->stream_id();
         std::string sname = sobj->name();
 
+        //detections of yolov5 ride along the live streams as a metadata track
+        if(IS_META_FRAME(head->type))
+        {
+            ceanic::rtsp::stream_manager::instance()->process_data(chn,MAIN_STREAM_ID,head,buf,len);
+            ceanic::rtsp::stream_manager::instance()->process_data(chn,SUB_STREAM_ID,head,buf,len);
+            return;
+        }
+
         //rtmp当前支持主码流/子码流 H264格式
         if(stream == MAIN_STREAM_ID || stream == SUB_STREAM_ID)
         {
@@ -244,11 +440,33 @@ namespace hisilicon{namespace dev{
         {
             if(m_save)
             {
-                m_save->input_data(head,buf,len);
+                //the recorder queues the encoder frame instead of copying it
+                if(frame)
+                {
+                    m_save->input_stream_frame(frame);
+                }
+                else
+                {
+                    m_save->input_data(head,buf,len);
+                }
             }
         }
 
-        ceanic::rtsp::stream_manager::instance()->process_data(chn,stream,head,buf,len);
+        //low latency streams were sent to rtsp slice by slice
+        if(!(head->flags & STREAM_FLAG_SLICE_SENT))
+        {
+            ceanic::rtsp::stream_manager::instance()->process_data(chn,stream,head,buf,len);
+        }
+    }
+
+    void chn::on_slice_come(ceanic::util::stream_obj_ptr sobj,ceanic::util::stream_head* head)
+    {
+        if(!m_is_start)
+        {
+            return;
+        }
+
+        ceanic::rtsp::stream_manager::instance()->process_data(sobj->chn(),sobj->stream_id(),head,NULL,0);
     }
 
     void chn::on_stream_error(ceanic::util::stream_obj_ptr sobj,int32_t error)
@@ -313,44 +531,45 @@ namespace hisilicon{namespace dev{
             return false;
         }
 
-        switch(mode)
+        m_aiisp_ptr = aiisp::create(mode,model_file,viisp->pipes()[0],viisp->isp_w(),viisp->isp_h(),viisp->wdr_mode());
+        if(!m_aiisp_ptr)
         {
-            case 0://brn
-                {
-                    aiisp_bnr::init(model_file,viisp->isp_w(),viisp->isp_h(),viisp->wdr_mode());
-                    m_aiisp_ptr = std::make_shared<aiisp_bnr>(viisp->pipes()[0]);
-                    break;
-                }
-
-            case 1://drc
-                {
-                    aiisp_drc::init(model_file,viisp->isp_w(),viisp->isp_h(),viisp->wdr_mode());
-                    m_aiisp_ptr = std::make_shared<aiisp_drc>(viisp->pipes()[0]);
-                    break;
-                }
-
-            case 2://3dnr
-                {
-                    aiisp_3dnr::init(model_file,viisp->isp_w(),viisp->isp_h());
-                    m_aiisp_ptr = std::make_shared<aiisp_3dnr>(viisp->pipes()[0]);
-                    break;
-                }
-
-            default:
-                {
-                    return false;
-                }
+            return false;
         }
 
         if(!m_aiisp_ptr->start())
         {
             m_aiisp_ptr.reset();
+            aiisp::release(mode);
             return false;
         }
 
+        m_aiisp_mode = mode;
         return true;
     }
 
+    bool chn::aiisp_switch(const char* model_file,int mode)
+    {
+        if(!m_aiisp_ptr)
+        {
+            return aiisp_start(model_file,mode);
+        }
+
+        //the old mode gives its model back to aiisp_model_cache,the new one comes from there
+        //too when preloaded,so the switch costs the sdk load,not the file read
+        std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+        m_aiisp_ptr->stop();
+        m_aiisp_ptr.reset();
+        aiisp::release(m_aiisp_mode);
+
+        int old_mode = m_aiisp_mode;
+        m_aiisp_mode = -1;
+        bool ret = aiisp_start(model_file,mode);
+        int64_t us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - begin).count();
+        DEV_WRITE_LOG_INFO("chn %d aiisp mode %d->%d %s,%lldus",m_chn,old_mode,mode,ret ? "ok" : "failed",(long long)us);
+        return ret;
+    }
+
     void chn::aiisp_stop()
     {
         if(m_aiisp_ptr)
@@ -358,6 +577,7 @@ namespace hisilicon{namespace dev{
             m_aiisp_ptr->stop();
             m_aiisp_ptr.reset();
         }
+        m_aiisp_mode = -1;
 
         aiisp_bnr::release();
         aiisp_drc::release();
@@ -398,9 +618,9 @@ namespace hisilicon{namespace dev{
             return false;
         }
 
-        if(stream == AI_STREAM_ID)
+        if(stream == AI_STREAM_ID || stream == MJPEG_STREAM_ID)
         {
-            //yolov5 stream
+            //yolov5 stream,every mjpeg frame stands alone
             return true;
         }
         else if(stream == MAIN_STREAM_ID)
@@ -432,17 +652,38 @@ namespace hisilicon{namespace dev{
 
         if(stream == AI_STREAM_ID)
         {
-            //aidetect stream
+            //aidetect stream,only encoded while the boxes are burnt in
+            if(!chn_ptr->m_yolov5 || !chn_ptr->m_yolov5->burn_in())
+            {
+                return false;
+            }
+
             mh->audio_info.acode = STREAM_AUDIO_ENCODE_NONE;
             mh->video_info.vcode = STREAM_VIDEO_ENCODE_H264;
             return true;
         }
 
+        if(stream == MJPEG_STREAM_ID)
+        {
+            if(!chn_ptr->m_venc_mjpeg_ptr)
+            {
+                return false;
+            }
+
+            mh->audio_info.acode = STREAM_AUDIO_ENCODE_NONE;
+            mh->video_info.w = chn_ptr->m_venc_mjpeg_ptr->venc_w();
+            mh->video_info.h = chn_ptr->m_venc_mjpeg_ptr->venc_h();
+            mh->video_info.fr = chn_ptr->m_venc_mjpeg_ptr->venc_fr();
+            mh->video_info.vcode = STREAM_VIDEO_ENCODE_MJPEG;
+            return true;
+        }
+
         std::shared_ptr<venc> venc_ptr = (stream == MAIN_STREAM_ID) ? chn_ptr-> m_venc_main_ptr : chn_ptr->m_venc_sub_ptr;
         mh->video_info.w = venc_ptr->venc_w();
         mh->video_info.h = venc_ptr->venc_h();
         mh->video_info.fr = venc_ptr->venc_fr();
         mh->video_info.vcode = (std::dynamic_pointer_cast<venc_h264>(venc_ptr) != nullptr) ? STREAM_VIDEO_ENCODE_H264 : STREAM_VIDEO_ENCODE_H265;
+        mh->meta_info.mcode = (chn_ptr->m_yolov5 && chn_ptr->m_yolov5->metadata()) ? STREAM_META_ENCODE_ONVIF : STREAM_META_ENCODE_NONE;
 
         return true;
     }
@@ -476,20 +717,30 @@ namespace hisilicon{namespace dev{
     }
 
     bool chn::trigger_jpg(const char* file,int quality,const char* str_info)
+    {
+        snap_request req;
+        req.quality = quality;
+        req.info = str_info ? str_info : "";
+        req.path = file;
+        return request_jpg(req);
+    }
+
+    bool chn::request_jpg(const snap_request& req)
     {
         if(!m_is_start)
         {
             return false;
         }
 
-        if(quality <1)
+        snap_request r = req;
+        if(r.quality <1)
         {
-            quality = 1;
+            r.quality = 1;
         }
 
-        if(quality > 99)
+        if(r.quality > 99)
         {
-            quality = 99;
+            r.quality = 99;
         }
 
         if(!m_snap)
@@ -498,22 +749,23 @@ namespace hisilicon{namespace dev{
 
             if(!m_snap->start())
             {
+                m_snap->stop();
                 m_snap = nullptr;
                 return false;
             }
         }
 
-        return m_snap->trigger(file,quality,str_info);
+        return m_snap->request(r);
     }
 
-    bool chn::yolov5_start(const char* model_file)
+    bool chn::yolov5_start(const char* model_file,bool burn_in,bool metadata,uint32_t track_interval,const yolov5_post_t* post)
     {
         if(!m_is_start)
         {
             return false;
         }
 
-        m_yolov5 = std::make_shared<yolov5>(m_chn,AI_STREAM_ID,m_vi_ptr,model_file);
+        m_yolov5 = std::make_shared<yolov5>(m_chn,AI_STREAM_ID,m_vi_ptr,model_file,burn_in,metadata,track_interval,post);
         if(!m_yolov5->start())
         {
             m_yolov5 = nullptr;
@@ -525,10 +777,82 @@ namespace hisilicon{namespace dev{
         return true;
     }
 
+    bool chn::yolov5_roi_start(const ceanic::roi::roi_qp_param* param,uint32_t ab_period_ms)
+    {
+        if(!m_yolov5)
+        {
+            return false;
+        }
+
+        std::shared_ptr<venc> vencs[] = {m_venc_main_ptr,m_venc_sub_ptr};
+        for(size_t i = 0; i < sizeof(vencs) / sizeof(vencs[0]); i++)
+        {
+            if(!vencs[i]->start_roi(param,m_yolov5->venc_w(),m_yolov5->venc_h(),ab_period_ms))
+            {
+                yolov5_roi_stop();
+                return false;
+            }
+            m_yolov5->add_roi_venc(vencs[i]);
+        }
+
+        return true;
+    }
+
+    void chn::yolov5_roi_stop()
+    {
+        if(m_yolov5)
+        {
+            m_yolov5->clear_roi_venc();
+        }
+
+        m_venc_main_ptr->stop_roi();
+        m_venc_sub_ptr->stop_roi();
+    }
+
+    bool chn::yolov5_motion_start(const ceanic::motion::motion_param* param,bool gate)
+    {
+        if(!m_yolov5)
+        {
+            return false;
+        }
+
+        return m_yolov5->start_motion(param,gate);
+    }
+
+    void chn::yolov5_motion_stop()
+    {
+        if(m_yolov5)
+        {
+            m_yolov5->stop_motion();
+        }
+    }
+
+    bool chn::get_yolov5_motion_event(ceanic::motion::motion_event* event)
+    {
+        if(!m_yolov5)
+        {
+            return false;
+        }
+
+        return m_yolov5->get_motion_event(event);
+    }
+
+    bool chn::get_yolov5_stat(yolov5_stat_t* stat)
+    {
+        if(!m_yolov5)
+        {
+            return false;
+        }
+
+        return m_yolov5->get_stat(stat);
+    }
+
     void chn::yolov5_stop()
     {
         if(m_yolov5)
         {
+            yolov5_roi_stop();
+            yolov5_motion_stop();
             m_yolov5->unregister_stream_observer(shared_from_this());
             m_yolov5->stop();
             m_yolov5 = nullptr;
@@ -23,6 +23,9 @@
 #include "dev_vi_os04a10_2to1wdr.h"
 #include "dev_vi_os08a20_liner.h"
 #include "dev_vi_os08a20_2to1wdr.h"
+#ifdef CEANIC_SDK_SIM
+#include "dev_vi_sim.h"
+#endif
 #include "dev_venc.h"
 #include "dev_osd.h"
 #include "dev_log.h"
@@ -47,9 +50,12 @@ extern "C"
 #include <aiisp_bnr.h>
 #include <aiisp_drc.h>
 #include <aiisp_3dnr.h>
+#include <aiisp_model_cache.h>
 
 //mp4
 #include <mp4_save.h>
+#include <event_save.h>
+#include <fmp4_save.h>
 
 //snap
 #include "dev_snap.h"
@@ -64,6 +70,7 @@ namespace hisilicon{namespace dev{
 #define MAIN_STREAM_ID 0
 #define SUB_STREAM_ID 1
 #define AI_STREAM_ID 2
+#define MJPEG_STREAM_ID 3
 
     /**
      * @brief Legacy channel class for single-camera operation
@@ -80,16 +87,39 @@ namespace hisilicon{namespace dev{
             chn(const char* vi_name,const char*venc_mode,int chn_no);
             ~chn();
 
-            bool start(int venc_w,int venc_h,int fr,int bitrate);
+            //slice_lines:main stream low latency slice size,0 for whole frames
+            bool start(int venc_w,int venc_h,int fr,int bitrate,int slice_lines = 0);
             void stop();
             bool is_start();
 
+            //low rate jpeg stream(MJPEG_STREAM_ID) for rtsp and the http mjpeg server,
+            //every viewer is fed from the one encoder.call before start_capture
+            bool start_mjpeg(int w,int h,int fr,int quality);
+            void stop_mjpeg();
+
+            //main or sub stream on the fly,the rtsp/rtmp/recording consumers stay attached.
+            //frame rate,bitrate and gop(0:one per second) go to the running encoder,a new size
+            //restarts only that encoder with an idr that carries the new sps/pps
+            bool reconfigure_stream(int stream,int venc_w,int venc_h,int fr,int bitrate,int gop = 0);
+
             bool get_isp_exposure_info(isp_exposure_t* val);
 
-            bool start_save(const char* file);
+            bool start_save(const char* file,const ceanic::stream_save::mp4_save_param* param = NULL);
             void stop_save();
 
+            //fragmented mp4 without the vendor muxer,stopped by stop_save
+            bool start_fmp4_save(const char* file,const ceanic::stream_save::fmp4_save_param* param);
+
+            //fragmented mp4 into a preallocated segment pool,overwritten in a circle,stopped by stop_save
+            bool start_pool_save(const ceanic::stream_save::segment_pool_param* pool_param,const ceanic::stream_save::fmp4_save_param* param);
+
+            //pre-event ring + triggered segments,stopped by stop_save
+            bool start_event_save(const ceanic::stream_save::event_save_param* param);
+            bool trigger_event(const char* reason);
+
             bool trigger_jpg(const char* file,int quality,const char* str_info);
+            //queued to the snap thread,the jpegs come back through req.on_done
+            bool request_jpg(const snap_request& req);
 
             static bool init(ot_vi_vpss_mode_type mode);
             static void release();
@@ -98,6 +128,8 @@ namespace hisilicon{namespace dev{
 
             void on_stream_come(ceanic::util::stream_obj_ptr sobj,ceanic::util::stream_head* head, const char* buf, int32_t len);
             void on_stream_error(ceanic::util::stream_obj_ptr sobj,int32_t error);
+            void on_frame_come(ceanic::util::stream_obj_ptr sobj,ceanic::util::stream_frame_ptr frame);
+            void on_slice_come(ceanic::util::stream_obj_ptr sobj,ceanic::util::stream_head* head);
 
             //for scene
             static bool scene_init(const char* dir_path);
@@ -111,12 +143,25 @@ namespace hisilicon{namespace dev{
 
             //for aiisp
             bool aiisp_start(const char* model_file,int mode);
+            //stop the running mode and start mode,preload the models to aiisp_model_cache for a fast switch
+            bool aiisp_switch(const char* model_file,int mode);
             void aiisp_stop();
 
 
             //for yolov5
-            bool yolov5_start(const char* model_file);
+            //burn_in:boxes drawn into the ai stream,metadata:onvif track on the main/sub rtsp streams
+            //track_interval:0 raw detections,N tracked boxes and inference on up to every Nth frame
+            //post:NULL the model has the npu roi/nms layers,otherwise cpu decode of its raw heads
+            bool yolov5_start(const char* model_file,bool burn_in = true,bool metadata = true,uint32_t track_interval = 0,const yolov5_post_t* post = NULL);
             void yolov5_stop();
+            bool get_yolov5_stat(yolov5_stat_t* stat);
+            //after yolov5_start,the detections drive the roi qp of the main and sub streams
+            bool yolov5_roi_start(const ceanic::roi::roi_qp_param* param,uint32_t ab_period_ms = 0);
+            void yolov5_roi_stop();
+            //after yolov5_start,cpu motion analysis of the yolov5 frames,gate:no inference while nothing moves
+            bool yolov5_motion_start(const ceanic::motion::motion_param* param,bool gate = false);
+            void yolov5_motion_stop();
+            bool get_yolov5_motion_event(ceanic::motion::motion_event* event);
 
             //for vo
             bool vo_start(const char* intf_type,const char* intf_sync);
@@ -125,13 +170,18 @@ namespace hisilicon{namespace dev{
             static bool get_stream_head(int chn,int stram,ceanic::util::media_head* mh);
             static bool request_i_frame(int chn,int stream);
 
+        private:
+            void process_stream(ceanic::util::stream_obj_ptr sobj,ceanic::util::stream_head* head, const char* buf, int32_t len,ceanic::util::stream_frame_ptr frame);
+
         private:
             bool m_is_start;
             std::string m_vi_name;
             std::shared_ptr<vi> m_vi_ptr;
             std::shared_ptr<venc> m_venc_main_ptr;
             std::shared_ptr<venc> m_venc_sub_ptr;
+            std::shared_ptr<venc> m_venc_mjpeg_ptr;
             std::shared_ptr<aiisp> m_aiisp_ptr;
+            int m_aiisp_mode;
             std::shared_ptr<osd_date> m_osd_date_main;
             std::shared_ptr<osd_date> m_osd_date_sub;
             int m_chn;
@@ -36,7 +36,7 @@ chn_wrapper::~chn_wrapper()
     DEV_WRITE_LOG_INFO("Destroyed chn_wrapper for chn=%d", m_chn);
 }
 
-bool chn_wrapper::start(int venc_w, int venc_h, int fr, int bitrate)
+bool chn_wrapper::start(int venc_w, int venc_h, int fr, int bitrate, int slice_lines)
 {
     if (m_is_start) {
         DEV_WRITE_LOG_WARN("Camera already started");
@@ -46,7 +46,7 @@ bool chn_wrapper::start(int venc_w, int venc_h, int fr, int bitrate)
     // Use legacy implementation if camera manager not available
     if (m_use_legacy && m_legacy_chn) {
         DEV_WRITE_LOG_INFO("Using legacy dev_chn implementation");
-        bool result = m_legacy_chn->start(venc_w, venc_h, fr, bitrate);
+        bool result = m_legacy_chn->start(venc_w, venc_h, fr, bitrate, slice_lines);
         if (result) {
             m_is_start = true;
         }
@@ -62,7 +62,7 @@ bool chn_wrapper::start(int venc_w, int venc_h, int fr, int bitrate)
     try {
         // Create camera configuration
         hisilicon::device::camera_config config;
-        create_camera_config(venc_w, venc_h, fr, bitrate, config);
+        create_camera_config(venc_w, venc_h, fr, bitrate, slice_lines, config);
         
         // Create camera via camera_manager
         // 这里只是使用 camera_manager 创建了一个 camera 实例，并没有完全使用 camera_manager 来管理
@@ -137,15 +137,32 @@ bool chn_wrapper::get_isp_exposure_info(isp_exposure_t* val)
     return m_camera_instance->get_isp_exposure_info(val);
 }
 
-bool chn_wrapper::start_save(const char* file)
+bool chn_wrapper::start_save(const char* file, const ceanic::stream_save::mp4_save_param* param)
 {
     if (m_use_legacy && m_legacy_chn) {
-        return m_legacy_chn->start_save(file);
+        return m_legacy_chn->start_save(file, param);
     }
-    
-    // TODO: Implement MP4 save via camera_instance
-    DEV_WRITE_LOG_WARN("start_save not yet implemented in new architecture");
-    return false;
+
+    if (!m_is_start || !m_camera_instance) {
+        return false;
+    }
+
+    ceanic::util::media_head mh;
+    if (!m_camera_instance->get_stream_head(MAIN_STREAM_ID, &mh)) {
+        return false;
+    }
+
+    auto save = std::make_shared<ceanic::stream_save::mp4_save>(mh, file, param);
+    if (!save->open()) {
+        return false;
+    }
+
+    if (!m_camera_instance->start_save(save)) {
+        save->close();
+        return false;
+    }
+
+    return true;
 }
 
 void chn_wrapper::stop_save()
@@ -154,9 +171,114 @@ void chn_wrapper::stop_save()
         m_legacy_chn->stop_save();
         return;
     }
-    
-    // TODO: Implement via camera_instance
-    DEV_WRITE_LOG_WARN("stop_save not yet implemented in new architecture");
+
+    if (m_camera_instance) {
+        m_camera_instance->stop_save();
+    }
+}
+
+bool chn_wrapper::start_fmp4_save(const char* file, const ceanic::stream_save::fmp4_save_param* param)
+{
+    if (m_use_legacy && m_legacy_chn) {
+        return m_legacy_chn->start_fmp4_save(file, param);
+    }
+
+    if (!m_is_start || !m_camera_instance) {
+        return false;
+    }
+
+    ceanic::util::media_head mh;
+    if (!m_camera_instance->get_stream_head(MAIN_STREAM_ID, &mh)) {
+        return false;
+    }
+
+    auto save = std::make_shared<ceanic::stream_save::fmp4_save>(mh, file, param);
+    if (!save->open()) {
+        return false;
+    }
+
+    if (!m_camera_instance->start_save(save)) {
+        save->close();
+        return false;
+    }
+
+    return true;
+}
+
+bool chn_wrapper::start_pool_save(const ceanic::stream_save::segment_pool_param* pool_param,
+                                  const ceanic::stream_save::fmp4_save_param* param)
+{
+    if (m_use_legacy && m_legacy_chn) {
+        return m_legacy_chn->start_pool_save(pool_param, param);
+    }
+
+    if (!m_is_start || !m_camera_instance) {
+        return false;
+    }
+
+    ceanic::util::media_head mh;
+    if (!m_camera_instance->get_stream_head(MAIN_STREAM_ID, &mh)) {
+        return false;
+    }
+
+    auto pool = std::make_shared<ceanic::stream_save::segment_pool>(pool_param);
+    auto save = std::make_shared<ceanic::stream_save::fmp4_save>(mh, pool, param);
+    if (!save->open()) {
+        return false;
+    }
+
+    if (!m_camera_instance->start_save(save)) {
+        save->close();
+        return false;
+    }
+
+    return true;
+}
+
+bool chn_wrapper::start_event_save(const ceanic::stream_save::event_save_param* param)
+{
+    if (m_use_legacy && m_legacy_chn) {
+        return m_legacy_chn->start_event_save(param);
+    }
+
+    if (!m_is_start || !m_camera_instance) {
+        return false;
+    }
+
+    ceanic::util::media_head mh;
+    if (!m_camera_instance->get_stream_head(MAIN_STREAM_ID, &mh)) {
+        return false;
+    }
+
+    auto save = std::make_shared<ceanic::stream_save::event_save>(mh, param);
+    if (!save->open()) {
+        return false;
+    }
+
+    if (!m_camera_instance->start_save(save)) {
+        save->close();
+        return false;
+    }
+
+    return true;
+}
+
+bool chn_wrapper::trigger_event(const char* reason)
+{
+    if (m_use_legacy && m_legacy_chn) {
+        return m_legacy_chn->trigger_event(reason);
+    }
+
+    if (!m_camera_instance) {
+        return false;
+    }
+
+    auto save = std::dynamic_pointer_cast<ceanic::stream_save::event_save>(m_camera_instance->get_save());
+    if (!save) {
+        return false;
+    }
+
+    return save->trigger(reason);
 }
 
 bool chn_wrapper::trigger_jpg(const char* file, int quality, const char* str_info)
@@ -164,9 +286,24 @@ bool chn_wrapper::trigger_jpg(const char* file, int quality, const char* str_inf
     if (m_use_legacy && m_legacy_chn) {
         return m_legacy_chn->trigger_jpg(file, quality, str_info);
     }
-    
-    // TODO: Implement JPEG snapshot via camera_instance
-    DEV_WRITE_LOG_WARN("trigger_jpg not yet implemented in new architecture");
+
+    snap_request req;
+    req.quality = quality;
+    req.info = str_info ? str_info : "";
+    req.path = file;
+    return request_jpg(req);
+}
+
+bool chn_wrapper::request_jpg(const snap_request& req)
+{
+    if (m_use_legacy && m_legacy_chn) {
+        return m_legacy_chn->request_jpg(req);
+    }
+
+    if (m_camera_instance) {
+        return m_camera_instance->request_jpg(req);
+    }
+
     return false;
 }
 
@@ -262,6 +399,38 @@ void chn_wrapper::on_stream_come(ceanic::util::stream_obj_ptr sobj,
     m_camera_instance->on_stream_come(sobj, head, buf, len);
 }
 
+void chn_wrapper::on_frame_come(ceanic::util::stream_obj_ptr sobj,
+                               ceanic::util::stream_frame_ptr frame)
+{
+    if (m_use_legacy && m_legacy_chn) {
+        m_legacy_chn->on_frame_come(sobj, frame);
+        return;
+    }
+
+    if(!m_is_start)
+    {
+        return;
+    }
+
+    m_camera_instance->on_frame_come(sobj, frame);
+}
+
+void chn_wrapper::on_slice_come(ceanic::util::stream_obj_ptr sobj,
+                               ceanic::util::stream_head* head)
+{
+    if (m_use_legacy && m_legacy_chn) {
+        m_legacy_chn->on_slice_come(sobj, head);
+        return;
+    }
+
+    if(!m_is_start)
+    {
+        return;
+    }
+
+    m_camera_instance->on_slice_come(sobj, head);
+}
+
 void chn_wrapper::on_stream_error(ceanic::util::stream_obj_ptr sobj, int32_t error)
 {
     if (m_use_legacy && m_legacy_chn) {
@@ -313,6 +482,19 @@ bool chn_wrapper::aiisp_start(const char* model_file, int mode)
     return false;
 }
 
+bool chn_wrapper::aiisp_switch(const char* model_file, int mode)
+{
+    if (m_use_legacy && m_legacy_chn) {
+        return m_legacy_chn->aiisp_switch(model_file, mode);
+    }
+    
+    if (m_camera_instance) {
+        return m_camera_instance->switch_aiisp(mode, model_file);
+    }
+    
+    return false;
+}
+
 void chn_wrapper::aiisp_stop()
 {
     if (m_use_legacy && m_legacy_chn) {
@@ -325,20 +507,144 @@ void chn_wrapper::aiisp_stop()
     }
 }
 
-bool chn_wrapper::yolov5_start(const char* model_file)
+bool chn_wrapper::reconfigure_stream(int stream, int venc_w, int venc_h, int fr, int bitrate, int gop)
 {
     if (m_use_legacy && m_legacy_chn) {
-        return m_legacy_chn->yolov5_start(model_file);
+        return m_legacy_chn->reconfigure_stream(stream, venc_w, venc_h, fr, bitrate, gop);
     }
     
     if (m_camera_instance) {
-        std::string model_path = model_file;
-        return m_camera_instance->enable_feature("yolov5", model_path);
+        hisilicon::device::stream_config config;
+        if (!m_camera_instance->get_stream_config(stream, config)) {
+            return false;
+        }
+        
+        config.width = venc_w;
+        config.height = venc_h;
+        config.framerate = fr;
+        config.bitrate = bitrate;
+        config.gop = gop;
+        return m_camera_instance->reconfigure_stream(config);
     }
     
     return false;
 }
 
+bool chn_wrapper::start_mjpeg(int w, int h, int fr, int quality)
+{
+    if (m_use_legacy && m_legacy_chn) {
+        return m_legacy_chn->start_mjpeg(w, h, fr, quality);
+    }
+
+    if (m_camera_instance) {
+        return m_camera_instance->start_mjpeg(w, h, fr, quality);
+    }
+
+    return false;
+}
+
+void chn_wrapper::stop_mjpeg()
+{
+    if (m_use_legacy && m_legacy_chn) {
+        m_legacy_chn->stop_mjpeg();
+        return;
+    }
+
+    if (m_camera_instance) {
+        m_camera_instance->stop_mjpeg();
+    }
+}
+
+bool chn_wrapper::yolov5_start(const char* model_file, bool burn_in, bool metadata, uint32_t track_interval,
+                               const yolov5_post_t* post)
+{
+    if (m_use_legacy && m_legacy_chn) {
+        return m_legacy_chn->yolov5_start(model_file, burn_in, metadata, track_interval, post);
+    }
+    
+    if (m_camera_instance) {
+        return m_camera_instance->enable_yolov5(model_file, burn_in, metadata, track_interval, post);
+    }
+    
+    return false;
+}
+
+bool chn_wrapper::yolov5_roi_start(const ceanic::roi::roi_qp_param* param, uint32_t ab_period_ms)
+{
+    if (m_use_legacy && m_legacy_chn) {
+        return m_legacy_chn->yolov5_roi_start(param, ab_period_ms);
+    }
+
+    if (m_camera_instance) {
+        return m_camera_instance->enable_yolov5_roi(param, ab_period_ms);
+    }
+
+    return false;
+}
+
+void chn_wrapper::yolov5_roi_stop()
+{
+    if (m_use_legacy && m_legacy_chn) {
+        m_legacy_chn->yolov5_roi_stop();
+        return;
+    }
+
+    if (m_camera_instance) {
+        m_camera_instance->disable_yolov5_roi();
+    }
+}
+
+bool chn_wrapper::yolov5_motion_start(const ceanic::motion::motion_param* param, bool gate)
+{
+    if (m_use_legacy && m_legacy_chn) {
+        return m_legacy_chn->yolov5_motion_start(param, gate);
+    }
+
+    if (m_camera_instance) {
+        return m_camera_instance->enable_yolov5_motion(param, gate);
+    }
+
+    return false;
+}
+
+void chn_wrapper::yolov5_motion_stop()
+{
+    if (m_use_legacy && m_legacy_chn) {
+        m_legacy_chn->yolov5_motion_stop();
+        return;
+    }
+
+    if (m_camera_instance) {
+        m_camera_instance->disable_yolov5_motion();
+    }
+}
+
+bool chn_wrapper::get_yolov5_motion_event(ceanic::motion::motion_event* event)
+{
+    if (m_use_legacy && m_legacy_chn) {
+        return m_legacy_chn->get_yolov5_motion_event(event);
+    }
+
+    if (m_camera_instance) {
+        return m_camera_instance->get_yolov5_motion_event(event);
+    }
+
+    return false;
+}
+
+bool chn_wrapper::get_yolov5_stat(yolov5_stat_t* stat)
+{
+    if (m_use_legacy && m_legacy_chn) {
+        return m_legacy_chn->get_yolov5_stat(stat);
+    }
+
+    if (m_camera_instance) {
+        return m_camera_instance->get_yolov5_stat(stat);
+    }
+
+    return false;
+}
+
 void chn_wrapper::yolov5_stop()
 {
     if (m_use_legacy && m_legacy_chn) {
@@ -453,7 +759,7 @@ std::string chn_wrapper::parse_sensor_mode(const std::string& vi_name)
     return "liner";
 }
 
-void chn_wrapper::create_camera_config(int venc_w, int venc_h, int fr, int bitrate,
+void chn_wrapper::create_camera_config(int venc_w, int venc_h, int fr, int bitrate, int slice_lines,
                                        hisilicon::device::camera_config& config)
 {
     // Set camera ID (auto-assign)
@@ -473,6 +779,7 @@ void chn_wrapper::create_camera_config(int venc_w, int venc_h, int fr, int bitra
     main_stream.height = venc_h;
     main_stream.framerate = fr;
     main_stream.bitrate = bitrate;
+    main_stream.slice_lines = slice_lines;
     main_stream.outputs.rtsp_enabled = true;
     main_stream.outputs.rtsp_url_path = "/stream1";
     
@@ -64,9 +64,10 @@ public:
      * @param venc_h Video height
      * @param fr Frame rate
      * @param bitrate Bitrate in kbps
+     * @param slice_lines Main stream low latency slice size in macroblock rows, 0 for whole frames
      * @return true if successful, false otherwise
      */
-    bool start(int venc_w, int venc_h, int fr, int bitrate);
+    bool start(int venc_w, int venc_h, int fr, int bitrate, int slice_lines = 0);
     
     /**
      * @brief Stop the camera
@@ -79,6 +80,33 @@ public:
      */
     bool is_start();
 
+    /**
+     * @brief Change the main or sub stream while it runs, consumers stay attached
+     * @param stream MAIN_STREAM_ID or SUB_STREAM_ID
+     * @param venc_w Video width, a new size restarts only this encoder
+     * @param venc_h Video height
+     * @param fr Frame rate
+     * @param bitrate Bitrate in kbps
+     * @param gop I frame interval in frames, 0 for one per second
+     * @return true if applied, false otherwise (the stream keeps its old settings)
+     */
+    bool reconfigure_stream(int stream, int venc_w, int venc_h, int fr, int bitrate, int gop = 0);
+
+    /**
+     * @brief Start the low rate MJPEG stream (MJPEG_STREAM_ID), call before start_capture
+     * @param w Picture width
+     * @param h Picture height
+     * @param fr Frame rate
+     * @param quality JPEG quality (1-99)
+     * @return true if successful, false otherwise
+     */
+    bool start_mjpeg(int w, int h, int fr, int quality);
+
+    /**
+     * @brief Stop the MJPEG stream
+     */
+    void stop_mjpeg();
+
     /**
      * @brief Get ISP exposure information
      * @param val Output exposure info structure
@@ -91,22 +119,63 @@ public:
      * @param file File path for recording
      * @return true if successful, false otherwise
      */
-    bool start_save(const char* file);
+    bool start_save(const char* file, const ceanic::stream_save::mp4_save_param* param = NULL);
     
     /**
-     * @brief Stop MP4 recording
+     * @brief Stop MP4 recording (continuous or event)
      */
     void stop_save();
 
     /**
-     * @brief Trigger JPEG snapshot
+     * @brief Start fragmented MP4 recording (no vendor muxer, survives power loss
+     *        up to the last fragment)
+     * @param file File path for recording
+     * @param param Fragment/queue parameters, NULL for defaults
+     * @return true if successful, false otherwise
+     */
+    bool start_fmp4_save(const char* file, const ceanic::stream_save::fmp4_save_param* param = NULL);
+
+    /**
+     * @brief Start fragmented MP4 recording into a preallocated segment pool;
+     *        the oldest segment is overwritten when the pool is full
+     * @param pool_param Pool directory and layout, formatted on first use
+     * @param param Fragment/queue parameters, NULL for defaults
+     * @return true if successful, false otherwise
+     */
+    bool start_pool_save(const ceanic::stream_save::segment_pool_param* pool_param,
+                         const ceanic::stream_save::fmp4_save_param* param = NULL);
+
+    /**
+     * @brief Start event recording: keep a pre-event ring in memory and
+     *        write segments only after trigger_event()
+     * @param param Event recording parameters, NULL for defaults
+     * @return true if successful, false otherwise
+     */
+    bool start_event_save(const ceanic::stream_save::event_save_param* param);
+
+    /**
+     * @brief Start (or extend) an event recording
+     * @param reason Trigger source, only used for logging (e.g., "api", "motion")
+     * @return true if successful, false if event recording is not running
+     */
+    bool trigger_event(const char* reason);
+
+    /**
+     * @brief Trigger JPEG snapshot, the file is written in the background
      * @param file Output file path
      * @param quality JPEG quality (1-100)
      * @param str_info Text overlay info
-     * @return true if successful, false otherwise
+     * @return true if the snapshot was queued, false otherwise
      */
     bool trigger_jpg(const char* file, int quality, const char* str_info);
 
+    /**
+     * @brief Queue a snapshot request (single shot or burst)
+     * @param req Quality, overlay text, burst count/interval, optional path and callback
+     * @return true if queued, false if the snap queue is full or not running
+     */
+    bool request_jpg(const snap_request& req);
+
     // Static methods - system-level operations
     static bool init(ot_vi_vpss_mode_type mode);
     static void release();
@@ -117,6 +186,10 @@ public:
                        ceanic::util::stream_head* head,
                        const char* buf, int32_t len) override;
     void on_stream_error(ceanic::util::stream_obj_ptr sobj, int32_t error) override;
+    void on_frame_come(ceanic::util::stream_obj_ptr sobj,
+                      ceanic::util::stream_frame_ptr frame) override;
+    void on_slice_come(ceanic::util::stream_obj_ptr sobj,
+                      ceanic::util::stream_head* head) override;
 
     // Scene management
     static bool scene_init(const char* dir_path);
@@ -129,11 +202,19 @@ public:
 
     // AIISP features
     bool aiisp_start(const char* model_file, int mode);
+    bool aiisp_switch(const char* model_file, int mode);
     void aiisp_stop();
 
     // YOLOv5 detection
-    bool yolov5_start(const char* model_file);
+    bool yolov5_start(const char* model_file, bool burn_in = true, bool metadata = true, uint32_t track_interval = 0,
+                      const yolov5_post_t* post = NULL);
     void yolov5_stop();
+    bool get_yolov5_stat(yolov5_stat_t* stat);
+    bool yolov5_roi_start(const ceanic::roi::roi_qp_param* param, uint32_t ab_period_ms = 0);
+    void yolov5_roi_stop();
+    bool yolov5_motion_start(const ceanic::motion::motion_param* param, bool gate = false);
+    void yolov5_motion_stop();
+    bool get_yolov5_motion_event(ceanic::motion::motion_event* event);
 
     // Video output
     bool vo_start(const char* intf_type, const char* intf_sync);
@@ -174,7 +255,7 @@ private:
     hisilicon::device::encoder_type parse_encoder_type(const std::string& venc_mode);
     std::string parse_sensor_name(const std::string& vi_name);
     std::string parse_sensor_mode(const std::string& vi_name);
-    void create_camera_config(int venc_w, int venc_h, int fr, int bitrate,
+    void create_camera_config(int venc_w, int venc_h, int fr, int bitrate, int slice_lines,
                              hisilicon::device::camera_config& config);
 };
 
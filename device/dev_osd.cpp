@@ -2,6 +2,7 @@
 #include "dev_osd.h"
 #include "dev_log.h"
 #include "ceanic_freetype.h"
+#include <sys/timerfd.h>
 
 namespace hisilicon{namespace dev{
 
@@ -53,6 +54,7 @@ namespace hisilicon{namespace dev{
 
     void osd::release()
     {
+        osd_scheduler::stop();
         g_freetype.release();
     }
 
@@ -105,14 +107,94 @@ namespace hisilicon{namespace dev{
         m_is_start = false;
     }
 
+    osd_dynamic::osd_dynamic(int x,int y,int font_size,ot_venc_chn venc_h,int interval_ms)
+        :osd(x,y,font_size,venc_h),m_interval_ms(interval_ms)
+    {
+        reset_canvas();
+    }
+
+    osd_dynamic::~osd_dynamic()
+    {
+    }
+
+    int osd_dynamic::interval_ms()
+    {
+        return m_interval_ms;
+    }
+
+    ot_rgn_handle osd_dynamic::rgn_handle()
+    {
+        return m_rgn_h;
+    }
+
+    void osd_dynamic::reset_canvas()
+    {
+        m_shown_str.clear();
+        for(int i = 0; i < 2; i++)
+        {
+            m_canvas_addr[i] = NULL;
+            m_canvas_str[i].clear();
+        }
+    }
+
+    bool osd_dynamic::draw_text(const char* str)
+    {
+        if(m_shown_str == str)
+        {
+            return false;
+        }
+
+        ot_rgn_canvas_info canvas_info;
+        td_s32 ret = ss_mpi_rgn_get_canvas_info(m_rgn_h, &canvas_info);
+        if (ret != TD_SUCCESS)
+        {
+            DEV_WRITE_LOG_ERROR("ss_mpi_rgn_get_canvas_info failed with error 0x%x", ret);
+            return false;
+        }
+
+        int slot = 0;
+        if(m_canvas_addr[0] != canvas_info.virt_addr)
+        {
+            slot = (m_canvas_addr[1] == canvas_info.virt_addr || m_canvas_addr[1] == NULL) ? 1 : 0;
+            if(m_canvas_addr[slot] != canvas_info.virt_addr)
+            {
+                m_canvas_addr[slot] = canvas_info.virt_addr;
+                m_canvas_str[slot].clear();
+            }
+        }
+
+        int area_w = m_rgn_attr.attr.overlay.size.width;
+        int area_h = m_rgn_attr.attr.overlay.size.height;
+        int size = canvas_info.size.width * canvas_info.size.height * 2;
+        if(m_canvas_str[slot].empty()
+                || !g_freetype.show_string_compare(m_canvas_str[slot].c_str(),str,area_w,area_h,m_font_size,
+                    (unsigned char*)canvas_info.virt_addr,size,m_font_bg_color,m_font_fg_color,m_font_outline_color))
+        {
+            //a new canvas or a text of another length
+            uint16_t* pix = (uint16_t*)canvas_info.virt_addr;
+            uint32_t pix_cnt = canvas_info.stride / 2 * canvas_info.size.height;
+            for(uint32_t i = 0; i < pix_cnt; i++)
+            {
+                pix[i] = m_font_bg_color;
+            }
+
+            g_freetype.show_string(str,area_w,area_h,m_font_size,(unsigned char*)canvas_info.virt_addr,size,
+                    m_font_bg_color,m_font_fg_color,m_font_outline_color);
+        }
+
+        m_canvas_str[slot] = str;
+        m_shown_str = str;
+        return true;
+    }
+
     osd_date::osd_date(int x,int y,int font_size,ot_venc_chn venc_h)
-        :osd(x,y,font_size,venc_h)
+        :osd_dynamic(x,y,font_size,venc_h,1000)
     {
-        m_last_date_str[0] = '\0';
     }
 
     osd_date::~osd_date()
     {
+        stop();
     }
 
     bool osd_date::start()
@@ -131,6 +213,14 @@ namespace hisilicon{namespace dev{
         area_h = ROUND_UP(m_font_size + 4,2);
         printf("area_w=%d,area_h=%d\n",area_w,area_h);
 
+        //every glyph the date can show is in the atlas before the first refresh
+        std::string glyphs = "0123456789-: ";
+        for(int i = 0; i < 7; i++)
+        {
+            glyphs += g_week_stsr[i];
+        }
+        g_freetype.prewarm(glyphs.c_str(),area_h,m_font_size,m_font_bg_color,m_font_fg_color,m_font_outline_color);
+
         m_rgn_attr.attr.overlay.size.width = area_w;
         m_rgn_attr.attr.overlay.size.height = area_h;
 
@@ -139,95 +229,229 @@ namespace hisilicon{namespace dev{
             return false;
         }
 
-        m_last_date_str[0] = '\0';
-        m_thd = std::thread(std::bind(&osd_date::on_refresh,this));
-        return true;
+        reset_canvas();
+        return osd_scheduler::add(this);
     }
 
-    void osd_date::on_refresh()
+    bool osd_date::refresh(time_t now)
     {
-        time_t last_tm = 0;
-        time_t cur_tm;
         struct tm cur;
-        char cur_osd_date_str[255] = {0};
-        td_s32 ret; 
-        ot_rgn_canvas_info canvas_info;
+        char cur_osd_date_str[255];
+        localtime_r(&now,&cur);
+        sprintf(cur_osd_date_str,"%s %04d-%02d-%02d %02d:%02d:%02d",g_week_stsr[cur.tm_wday],cur.tm_year + 1900,cur.tm_mon + 1,cur.tm_mday,cur.tm_hour,cur.tm_min,cur.tm_sec);
+
+        return draw_text(cur_osd_date_str);
+    }
+
+    void osd_date::stop()
+    {
+        osd_scheduler::remove(this);
+        osd::stop();
+    }
 
-        while(m_is_start)
+    osd_text::osd_text(int x,int y,int font_size,ot_venc_chn venc_h,int interval_ms,const char* sample,std::function<std::string()> get_text)
+        :osd_dynamic(x,y,font_size,venc_h,interval_ms),m_sample(sample),m_get_text(get_text)
+    {
+    }
+
+    osd_text::~osd_text()
+    {
+        stop();
+    }
+
+    bool osd_text::start()
+    {
+        int area_w;
+        if(!g_freetype.get_width(m_sample.c_str(),m_font_size,&area_w))
         {
-            cur_tm = time(NULL); 
-            if(cur_tm == last_tm)
-            {
-                usleep(10000);
-                continue;
-            }
+            DEV_WRITE_LOG_ERROR("get width of %s failed",m_sample.c_str());
+            return false;
+        }
+
+        m_rgn_attr.attr.overlay.size.width = ROUND_UP(area_w,64);
+        m_rgn_attr.attr.overlay.size.height = ROUND_UP(m_font_size + 4,2);
+
+        if(!osd::start())
+        {
+            return false;
+        }
+
+        reset_canvas();
+        return osd_scheduler::add(this);
+    }
 
-            last_tm = cur_tm;
+    //get_text decides the text,the time is not used
+    bool osd_text::refresh(time_t)
+    {
+        return draw_text(m_get_text().c_str());
+    }
+
+    void osd_text::stop()
+    {
+        osd_scheduler::remove(this);
+        osd::stop();
+    }
 
-            localtime_r(&cur_tm,&cur);
-            sprintf(cur_osd_date_str,"%s %04d-%02d-%02d %02d:%02d:%02d",g_week_stsr[cur.tm_wday],cur.tm_year + 1900,cur.tm_mon + 1,cur.tm_mday,cur.tm_hour,cur.tm_min,cur.tm_sec);
+    std::mutex osd_scheduler::g_mu;
+    std::list<osd_scheduler::entry_t> osd_scheduler::g_entries;
+    std::thread osd_scheduler::g_thread;
+    int osd_scheduler::g_timer_fd = -1;
+    bool osd_scheduler::g_is_run = false;
+    uint64_t osd_scheduler::g_wakeups = 0;
 
-            ret = ss_mpi_rgn_get_canvas_info(m_rgn_h, &canvas_info);
-            if (ret != TD_SUCCESS)
+    int64_t osd_scheduler::now_ms()
+    {
+        struct timespec ts;
+        clock_gettime(CLOCK_REALTIME,&ts);
+        return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+    }
+
+    //g_mu held,0 fires at once,-1 disarms
+    void osd_scheduler::arm(int64_t due_ms)
+    {
+        struct itimerspec its;
+        memset(&its,0,sizeof(its));
+        if(due_ms == 0)
+        {
+            //an absolute time in the past expires immediately
+            its.it_value.tv_nsec = 1;
+        }
+        else if(due_ms > 0)
+        {
+            its.it_value.tv_sec = due_ms / 1000;
+            its.it_value.tv_nsec = (due_ms % 1000) * 1000000;
+        }
+
+        if(timerfd_settime(g_timer_fd,TFD_TIMER_ABSTIME | TFD_TIMER_CANCEL_ON_SET,&its,NULL) != 0)
+        {
+            DEV_WRITE_LOG_ERROR("timerfd_settime failed,%s",strerror(errno));
+        }
+    }
+
+    bool osd_scheduler::add(osd_dynamic* o)
+    {
+        std::unique_lock<std::mutex> lock(g_mu);
+        if(!g_is_run)
+        {
+            g_timer_fd = timerfd_create(CLOCK_REALTIME,TFD_CLOEXEC);
+            if(g_timer_fd < 0)
             {
-                DEV_WRITE_LOG_ERROR("ss_mpi_rgn_get_canvas_info failed with error 0x%x", ret);
-                return ;
+                DEV_WRITE_LOG_ERROR("timerfd_create failed,%s",strerror(errno));
+                return false;
             }
 
-            if(strlen(m_last_date_str) == 0)
+            g_is_run = true;
+            g_thread = std::thread(&on_timer);
+        }
+
+        //drawn at the next wakeup
+        entry_t e = {o,0};
+        g_entries.push_back(e);
+        arm(0);
+        return true;
+    }
+
+    void osd_scheduler::remove(osd_dynamic* o)
+    {
+        std::unique_lock<std::mutex> lock(g_mu);
+        for(auto it = g_entries.begin(); it != g_entries.end(); it++)
+        {
+            if(it->o == o)
             {
-                //printf("chn=%d,stream=%d,area_w=%d,area_h=%d,%d,%d\n",chn,stream,g_osd_date_info[chn][stream].area_w,g_osd_date_info[chn][stream].area_h,stCanvasInfo.stSize.u32Width,stCanvasInfo.stSize.u32Height);
-                g_freetype.show_string(
-                        cur_osd_date_str,
-                        m_rgn_attr.attr.overlay.size.width,
-                        m_rgn_attr.attr.overlay.size.height,
-                        m_font_size,
-                        (unsigned char*)canvas_info.virt_addr,
-                        canvas_info.size.width * canvas_info.size.height * 2,
-                        m_font_bg_color,
-                        m_font_fg_color,
-                        m_font_outline_color);
+                g_entries.erase(it);
+                break;
             }
-            else
+        }
+    }
+
+    void osd_scheduler::stop()
+    {
+        {
+            std::unique_lock<std::mutex> lock(g_mu);
+            if(!g_is_run)
             {
-                g_freetype.show_string_compare(
-                        m_last_date_str,
-                        cur_osd_date_str,
-                        m_rgn_attr.attr.overlay.size.width,
-                        m_rgn_attr.attr.overlay.size.height,
-                        m_font_size,
-                        (unsigned char*)canvas_info.virt_addr, 
-                        canvas_info.size.width * canvas_info.size.height * 2,
-                        m_font_bg_color,
-                        m_font_fg_color,
-                        m_font_outline_color);
+                return;
             }
 
-            strcpy(m_last_date_str,cur_osd_date_str);
+            g_is_run = false;
+            arm(0);
+        }
+
+        g_thread.join();
+        close(g_timer_fd);
+        g_timer_fd = -1;
+    }
 
-            ret = ss_mpi_rgn_update_canvas(m_rgn_h);
-            if (ret != TD_SUCCESS)
+    uint64_t osd_scheduler::wakeups()
+    {
+        std::unique_lock<std::mutex> lock(g_mu);
+        return g_wakeups;
+    }
+
+    void osd_scheduler::on_timer()
+    {
+        std::vector<ot_rgn_handle> drawn;
+        while(true)
+        {
+            uint64_t expirations;
+            ssize_t n = read(g_timer_fd,&expirations,sizeof(expirations));
+
+            std::unique_lock<std::mutex> lock(g_mu);
+            if(!g_is_run)
             {
-                DEV_WRITE_LOG_ERROR("ss_mpi_rgn_update_canvas failed with error 0x%x", ret);
                 break;
             }
-        }
 
-        DEV_WRITE_LOG_INFO("osd date thread exit");
-    }
+            if(n < 0)
+            {
+                if(errno == ECANCELED)
+                {
+                    //the wall clock was set,redraw everything now
+                    for(auto it = g_entries.begin(); it != g_entries.end(); it++)
+                    {
+                        it->due_ms = 0;
+                    }
+                    arm(0);
+                }
+                continue;
+            }
 
-    void osd_date::stop()
-    {
-        m_is_start = false;
-        m_thd.join();
+            g_wakeups++;
+            int64_t now = now_ms();
+            int64_t next = -1;
+            drawn.clear();
+            for(auto it = g_entries.begin(); it != g_entries.end(); it++)
+            {
+                if(it->due_ms <= now)
+                {
+                    if(it->o->refresh(now / 1000))
+                    {
+                        drawn.push_back(it->o->rgn_handle());
+                    }
+
+                    int64_t interval = it->o->interval_ms() > 0 ? it->o->interval_ms() : 1000;
+                    it->due_ms = (now / interval + 1) * interval;
+                }
+
+                if(next < 0 || it->due_ms < next)
+                {
+                    next = it->due_ms;
+                }
+            }
 
-        ot_mpp_chn src_chn;
-        src_chn.mod_id = OT_ID_VENC;
-        src_chn.dev_id = 0;
-        src_chn.chn_id = m_venc_h;
+            for(uint32_t i = 0; i < drawn.size(); i++)
+            {
+                td_s32 ret = ss_mpi_rgn_update_canvas(drawn[i]);
+                if (ret != TD_SUCCESS)
+                {
+                    DEV_WRITE_LOG_ERROR("ss_mpi_rgn_update_canvas failed with error 0x%x", ret);
+                }
+            }
 
-        ss_mpi_rgn_detach_from_chn(m_rgn_h, &src_chn);
-        ss_mpi_rgn_destroy(m_rgn_h); 
+            arm(next);
+        }
+
+        DEV_WRITE_LOG_INFO("osd scheduler thread exit");
     }
 
     osd_name::osd_name(int x,int y,int font_size,ot_venc_chn venc_h,const char* name)
@@ -242,10 +466,13 @@ namespace hisilicon{namespace dev{
 
     bool osd_name::start()
     {
-        td_s32 ret;
         int area_w;
         int area_h;
-        g_freetype.get_width(m_name.c_str(),m_font_size,&area_w);
+        if(!g_freetype.get_width(m_name.c_str(),m_font_size,&area_w))
+        {
+            DEV_WRITE_LOG_ERROR("get width of %s failed",m_name.c_str());
+            return false;
+        }
         area_w = ROUND_UP(area_w,64);
         area_h = ROUND_UP(m_font_size + 4,2);
         printf("area_w=%d,area_h=%d\n",area_w,area_h);
@@ -258,6 +485,12 @@ namespace hisilicon{namespace dev{
             return false;
         }
 
+        return render();
+    }
+
+    bool osd_name::render()
+    {
+        td_s32 ret;
         ot_rgn_canvas_info canvas_info;
         ret = ss_mpi_rgn_get_canvas_info(m_rgn_h, &canvas_info);
         if (ret != TD_SUCCESS)
@@ -266,6 +499,14 @@ namespace hisilicon{namespace dev{
             return false;
         }
 
+        //the back canvas still holds an older text
+        uint16_t* pix = (uint16_t*)canvas_info.virt_addr;
+        uint32_t pix_cnt = canvas_info.stride / 2 * canvas_info.size.height;
+        for(uint32_t i = 0; i < pix_cnt; i++)
+        {
+            pix[i] = m_font_bg_color;
+        }
+
         g_freetype.show_string(
                 m_name.c_str(),
                 m_rgn_attr.attr.overlay.size.width,
@@ -287,6 +528,43 @@ namespace hisilicon{namespace dev{
         return true;
     }
 
+    bool osd_name::set_name(const char* name)
+    {
+        if(m_is_start && m_name == name)
+        {
+            return true;
+        }
+
+        m_name = name;
+        if(!m_is_start)
+        {
+            return start();
+        }
+
+        int area_w;
+        if(!g_freetype.get_width(name,m_font_size,&area_w))
+        {
+            DEV_WRITE_LOG_ERROR("get width of %s failed",name);
+            return false;
+        }
+
+        if(area_w <= (int)m_rgn_attr.attr.overlay.size.width)
+        {
+            return render();
+        }
+
+        //too wide,recreate the region with the same handle
+        ot_mpp_chn src_chn;
+        src_chn.mod_id = OT_ID_VENC;
+        src_chn.dev_id = 0;
+        src_chn.chn_id = m_venc_h;
+
+        ss_mpi_rgn_detach_from_chn(m_rgn_h, &src_chn);
+        ss_mpi_rgn_destroy(m_rgn_h);
+        m_is_start = false;
+        return start();
+    }
+
     void osd_name::stop()
     {
         osd::stop();
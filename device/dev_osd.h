@@ -2,6 +2,9 @@
 #define dev_osd_include_h
 
 #include "dev_std.h"
+#include <functional>
+#include <list>
+#include <mutex>
 
 namespace hisilicon{namespace dev{
 
@@ -32,8 +35,35 @@ namespace hisilicon{namespace dev{
             short m_font_outline_color;
     };
 
-    class osd_date
+    //overlay redrawn by osd_scheduler every interval_ms
+    class osd_dynamic
         :public osd
+    {
+        public:
+            osd_dynamic(int x,int y,int font_size,ot_venc_chn venc_h,int interval_ms);
+            virtual ~osd_dynamic();
+
+            int interval_ms();
+            ot_rgn_handle rgn_handle();
+
+            //called from the scheduler thread,true when the canvas was drawn and has to be updated
+            virtual bool refresh(time_t now) = 0;
+
+        protected:
+            //only the glyph cells that differ from what the back canvas holds are drawn
+            bool draw_text(const char* str);
+            void reset_canvas();
+
+        protected:
+            int m_interval_ms;
+            std::string m_shown_str;
+            //the region is double buffered,each canvas keeps the text last drawn on it
+            void* m_canvas_addr[2];
+            std::string m_canvas_str[2];
+    };
+
+    class osd_date
+        :public osd_dynamic
     {
         public:
             osd_date(int x,int y,int font_size,ot_venc_chn venc_h);
@@ -42,11 +72,59 @@ namespace hisilicon{namespace dev{
             virtual bool start() override;
             virtual void stop() override;
 
+            virtual bool refresh(time_t now) override;
+    };
+
+    //text from get_text,e.g. bitrate or detection counts,the region is as wide as sample
+    class osd_text
+        :public osd_dynamic
+    {
+        public:
+            osd_text(int x,int y,int font_size,ot_venc_chn venc_h,int interval_ms,const char* sample,std::function<std::string()> get_text);
+            virtual ~osd_text();
+
+            virtual bool start() override;
+            virtual void stop() override;
+
+            virtual bool refresh(time_t now) override;
+
         protected:
-            void on_refresh();
+            std::string m_sample;
+            std::function<std::string()> m_get_text;
+    };
+
+    //one timerfd thread for the dynamic overlays of every channel.it sleeps until the
+    //earliest overlay is due(aligned to multiples of its interval on the wall clock),
+    //refreshes the due ones and then updates their canvases in one pass
+    class osd_scheduler
+    {
+        public:
+            static bool add(osd_dynamic* o);
 
-            std::thread m_thd;
-            char m_last_date_str[64];
+            //waits for a refresh of o in progress
+            static void remove(osd_dynamic* o);
+
+            static void stop();
+
+            static uint64_t wakeups();
+
+        private:
+            static void on_timer();
+            static void arm(int64_t due_ms);
+            static int64_t now_ms();
+
+            typedef struct
+            {
+                osd_dynamic* o;
+                int64_t due_ms;
+            }entry_t;
+
+            static std::mutex g_mu;
+            static std::list<entry_t> g_entries;
+            static std::thread g_thread;
+            static int g_timer_fd;
+            static bool g_is_run;
+            static uint64_t g_wakeups;
     };
 
     class osd_name
@@ -59,6 +137,12 @@ namespace hisilicon{namespace dev{
             virtual bool start() override;
             virtual void stop() override;
 
+            //re-render only when the text changed,the region is recreated when it no longer fits
+            bool set_name(const char* name);
+
+        protected:
+            bool render();
+
         protected:
             std::string m_name;
     };
@@ -3,13 +3,14 @@
 #include "dev_log.h"
 #include "dev_osd.h"
 #include "ceanic_freetype.h"
+#include <future>
 
 namespace hisilicon{namespace dev{
 
     snap::snap(std::shared_ptr<vi> vi_ptr)
-        :m_vi_ptr(vi_ptr)
+        :m_vi_ptr(vi_ptr),m_bstart(false),m_save_run(false),m_quality(-1),
+        m_latest_quality(-1),m_cache_ms(SNAP_DEFAULT_CACHE_MS)
     {
-        m_bstart = false;
 
         m_venc_chn_attr.venc_attr.type = OT_PT_JPEG;
         m_venc_chn_attr.venc_attr.max_pic_width = 0;
@@ -35,18 +36,23 @@ namespace hisilicon{namespace dev{
     {
         td_s32 ret;
 
+        //snap at the pipe size for raw sensors,at the vi size otherwise
+        td_u32 snap_w = m_vi_ptr->w();
+        td_u32 snap_h = m_vi_ptr->h();
+#ifndef CEANIC_SDK_SIM
         std::shared_ptr<vi_isp> viisp = std::dynamic_pointer_cast<vi_isp>(m_vi_ptr);
-        if(!viisp)
+        if(viisp)
         {
-            return false;
+            ot_vi_pipe_attr vi_pipe_attr = viisp->vi_pipe_attr();
+            snap_w = vi_pipe_attr.size.width;
+            snap_h = vi_pipe_attr.size.height;
         }
+#endif
 
-        ot_vi_pipe_attr vi_pipe_attr = viisp->vi_pipe_attr();
-
-        m_venc_chn_attr.venc_attr.max_pic_width = vi_pipe_attr.size.width;
-        m_venc_chn_attr.venc_attr.max_pic_height = vi_pipe_attr.size.height;
-        m_venc_chn_attr.venc_attr.pic_width = vi_pipe_attr.size.width;
-        m_venc_chn_attr.venc_attr.pic_height = vi_pipe_attr.size.height;
+        m_venc_chn_attr.venc_attr.max_pic_width = snap_w;
+        m_venc_chn_attr.venc_attr.max_pic_height = snap_h;
+        m_venc_chn_attr.venc_attr.pic_width = snap_w;
+        m_venc_chn_attr.venc_attr.pic_height = snap_h;
         m_venc_chn_attr.venc_attr.buf_size = m_venc_chn_attr.venc_attr.pic_width * m_venc_chn_attr.venc_attr.pic_height * 2;
         ret = ss_mpi_venc_create_chn(m_venc_chn, &m_venc_chn_attr);
         if(ret != TD_SUCCESS) 
@@ -64,34 +70,260 @@ namespace hisilicon{namespace dev{
             return false;
         }
 
+        //a jpeg is a handful of packs,more are added when a picture needs them
+        m_packs.resize(8);
+        m_quality = -1;
+
         m_bstart = true;
+        m_save_run = true;
+        m_thd = std::thread(std::bind(&snap::on_snap,this));
+        m_save_thd = std::thread(std::bind(&snap::on_save,this));
         return true;
     }
 
     void snap::stop()
     {
+        if(m_bstart)
+        {
+            {
+                std::unique_lock<std::mutex> lock(m_mu);
+                m_bstart = false;
+            }
+            m_cond.notify_all();
+            m_thd.join();
+
+            //the jpegs of the last requests are still written
+            {
+                std::unique_lock<std::mutex> lock(m_save_mu);
+                m_save_run = false;
+            }
+            m_save_cond.notify_all();
+            m_save_thd.join();
+
+            std::deque<snap_request> reqs;
+            {
+                std::unique_lock<std::mutex> lock(m_mu);
+                reqs.swap(m_reqs);
+            }
+            for(auto it = reqs.begin(); it != reqs.end(); it++)
+            {
+                if(it->on_done)
+                {
+                    it->on_done(nullptr);
+                }
+            }
+
+            m_osd_date = nullptr;
+            m_osd_info = nullptr;
+        }
+
         //stop venc
         ss_mpi_venc_stop_chn(m_venc_chn);
         ss_mpi_venc_destroy_chn(m_venc_chn);
+    }
+
+    bool snap::request(const snap_request& req)
+    {
+        std::unique_lock<std::mutex> lock(m_mu);
+        if(!m_bstart)
+        {
+            return false;
+        }
+
+        if(m_reqs.size() >= SNAP_MAX_REQUEST)
+        {
+            DEV_WRITE_LOG_ERROR("snap chn %d has %d requests waiting,refused",m_venc_chn,(int)m_reqs.size());
+            return false;
+        }
+
+        m_reqs.push_back(req);
+        m_cond.notify_one();
+        return true;
+    }
+
+    snap_image_ptr snap::capture(int quality,const char* str_info,int timeout_ms)
+    {
+        //the promise outlives a timed out wait,the snap thread still fulfils it
+        std::shared_ptr<std::promise<snap_image_ptr>> done = std::make_shared<std::promise<snap_image_ptr>>();
+        std::future<snap_image_ptr> result = done->get_future();
+
+        snap_request req;
+        req.quality = quality;
+        req.info = str_info ? str_info : "";
+        req.on_done = [done](snap_image_ptr img){ done->set_value(img); };
+        if(!request(req))
+        {
+            return nullptr;
+        }
+
+        if(result.wait_for(std::chrono::milliseconds(timeout_ms)) != std::future_status::ready)
+        {
+            DEV_WRITE_LOG_ERROR("snap chn %d capture timeout",m_venc_chn);
+            return nullptr;
+        }
+
+        return result.get();
+    }
+
+    snap_image_ptr snap::latest()
+    {
+        std::unique_lock<std::mutex> lock(m_latest_mu);
+        return m_latest;
+    }
 
-        m_bstart = false;
+    void snap::set_cache_ms(int cache_ms)
+    {
+        std::unique_lock<std::mutex> lock(m_latest_mu);
+        m_cache_ms = cache_ms;
     }
 
     bool snap::trigger(const char* path,int quality,const char* str_info)
+    {
+        snap_request req;
+        req.quality = quality;
+        req.info = str_info ? str_info : "";
+        req.path = path;
+        return request(req);
+    }
+
+    void snap::on_snap()
+    {
+        while(true)
+        {
+            snap_request req;
+            {
+                std::unique_lock<std::mutex> lock(m_mu);
+                m_cond.wait(lock,[this](){ return !m_bstart || !m_reqs.empty(); });
+                if(!m_bstart)
+                {
+                    break;
+                }
+
+                req = m_reqs.front();
+                m_reqs.pop_front();
+            }
+
+            process(req);
+        }
+
+        DEV_WRITE_LOG_INFO("snap thread exit");
+    }
+
+    static std::string burst_path(const std::string& path,int index)
+    {
+        size_t dot = path.rfind('.');
+        size_t slash = path.rfind('/');
+        if(dot == std::string::npos || (slash != std::string::npos && dot < slash))
+        {
+            dot = path.size();
+        }
+
+        char idx[16];
+        snprintf(idx,sizeof(idx),"_%d",index);
+        return path.substr(0,dot) + idx + path.substr(dot);
+    }
+
+    void snap::process(const snap_request& req)
+    {
+        int count = req.count < 1 ? 1 : req.count;
+        std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+
+        for(int i = 0; i < count; i++)
+        {
+            if(i > 0 && req.interval_ms > 0)
+            {
+                //keep the burst on its own clock,stop cuts it short
+                std::unique_lock<std::mutex> lock(m_mu);
+                m_cond.wait_until(lock,begin + std::chrono::milliseconds((int64_t)req.interval_ms * i),[this](){ return !m_bstart; });
+            }
+
+            if(!m_bstart)
+            {
+                break;
+            }
+
+            snap_image_ptr img;
+            if(count == 1)
+            {
+                //repeated single shots share the latest jpeg
+                std::unique_lock<std::mutex> lock(m_latest_mu);
+                if(m_latest
+                        && m_latest_quality == req.quality
+                        && m_latest_info == req.info
+                        && std::chrono::steady_clock::now() - m_latest_tp < std::chrono::milliseconds(m_cache_ms))
+                {
+                    img = m_latest;
+                }
+            }
+
+            if(!img)
+            {
+                img = shot(req.quality,req.info.c_str(),i);
+            }
+
+            if(img && !req.path.empty())
+            {
+                save(count == 1 ? req.path : burst_path(req.path,i),img);
+            }
+
+            if(req.on_done)
+            {
+                req.on_done(img);
+            }
+        }
+    }
+
+    snap_image_ptr snap::shot(int quality,const char* str_info,int index)
     {
         td_s32 ret;
-        td_u32 i;
-        td_s32 venc_fd;
-        fd_set read_fds;
-        struct timeval timeout_val;
-        ot_venc_chn_status stat;
-        ot_venc_stream stream;
 
-        if(!m_bstart)
+        if(!set_quality(quality))
         {
-            return false;
+            return nullptr;
         }
 
+        ot_video_frame_info frame_info;
+        ret = ss_mpi_vpss_get_grp_frame(m_vi_ptr->vpss_grp(),&frame_info,1000);
+        if(ret != TD_SUCCESS)
+        {
+            DEV_WRITE_LOG_ERROR("ss_mpi_vpss_get_frame failed with %#x", ret);
+            return nullptr;
+        }
+
+        update_osd(str_info);
+
+        ret = ss_mpi_venc_send_frame(m_venc_chn,&frame_info,1000);
+        ss_mpi_vpss_release_grp_frame(m_vi_ptr->vpss_grp(),&frame_info);
+        if(ret != TD_SUCCESS)
+        {
+            DEV_WRITE_LOG_ERROR("ss_mpi_venc_send_frame failed with %#x", ret);
+            return nullptr;
+        }
+
+        snap_image_ptr img = std::make_shared<snap_image>();
+        img->time = time(NULL);
+        img->index = index;
+        if(!get_jpeg(img))
+        {
+            return nullptr;
+        }
+
+        std::unique_lock<std::mutex> lock(m_latest_mu);
+        m_latest = img;
+        m_latest_quality = quality;
+        m_latest_info = str_info;
+        m_latest_tp = std::chrono::steady_clock::now();
+        return img;
+    }
+
+    bool snap::set_quality(int quality)
+    {
+        if(quality == m_quality)
+        {
+            return true;
+        }
+
+        td_s32 ret;
         ot_venc_jpeg_param jpg_param;
         ret = ss_mpi_venc_get_jpeg_param(m_venc_chn, &jpg_param);
         if(ret != TD_SUCCESS)
@@ -108,12 +340,16 @@ namespace hisilicon{namespace dev{
             return false;
         }
 
-        ot_video_frame_info frame_info;
-        ret = ss_mpi_vpss_get_grp_frame(m_vi_ptr->vpss_grp(),&frame_info,1000);
-        if(ret != TD_SUCCESS)
+        m_quality = quality;
+        return true;
+    }
+
+    void snap::update_osd(const char* str_info)
+    {
+        //the overlays need the font,snap without them otherwise
+        if(!g_freetype.is_init())
         {
-            DEV_WRITE_LOG_ERROR("ss_mpi_vpss_get_frame failed with %#x", ret);
-            return false;
+            return;
         }
 
         time_t cur_tm = time(NULL);
@@ -122,27 +358,45 @@ namespace hisilicon{namespace dev{
         char data_str[255];
         sprintf(data_str,"%s %04d-%02d-%02d %02d:%02d:%02d",g_week_stsr[cur.tm_wday],cur.tm_year + 1900,cur.tm_mon + 1,cur.tm_mday,cur.tm_hour,cur.tm_min,cur.tm_sec);
 
-        std::shared_ptr<osd_name> osd1 = std::make_shared<osd_name>(10,10,64,m_venc_chn,data_str);
-        osd1->start();
-        std::shared_ptr<osd_name> osd2;
-        if(str_info)
+        //the regions stay attached between shots,set_name redraws only a changed text
+        if(!m_osd_date)
+        {
+            m_osd_date = std::make_shared<osd_name>(10,10,64,m_venc_chn,data_str);
+            m_osd_date->start();
+        }
+        else
         {
-            osd2 = std::make_shared<osd_name>(10,96,64,m_venc_chn,str_info);
-            osd2->start();
+            m_osd_date->set_name(data_str);
         }
 
-        ret = ss_mpi_venc_send_frame(m_venc_chn,&frame_info,1000);
-        ss_mpi_vpss_release_grp_frame(m_vi_ptr->vpss_grp(),&frame_info);
-        if(ret != TD_SUCCESS)
+        if(!str_info || strlen(str_info) == 0)
         {
-            DEV_WRITE_LOG_ERROR("ss_mpi_venc_send_frame failed with %#x", ret);
-            return false;
+            m_osd_info = nullptr;
+        }
+        else if(!m_osd_info)
+        {
+            m_osd_info = std::make_shared<osd_name>(10,96,64,m_venc_chn,str_info);
+            m_osd_info->start();
+        }
+        else
+        {
+            m_osd_info->set_name(str_info);
         }
+    }
+
+    bool snap::get_jpeg(snap_image_ptr img)
+    {
+        td_s32 ret;
+        td_s32 venc_fd;
+        fd_set read_fds;
+        struct timeval timeout_val;
+        ot_venc_chn_status stat;
+        ot_venc_stream stream;
 
         venc_fd = ss_mpi_venc_get_fd(m_venc_chn);
         if(venc_fd < 0)
         {
-            DEV_WRITE_LOG_ERROR("ss_mpi_venc_get_fd failed with %#x", ret);
+            DEV_WRITE_LOG_ERROR("ss_mpi_venc_get_fd failed with %#x", venc_fd);
             return false;
         }
 
@@ -174,40 +428,84 @@ namespace hisilicon{namespace dev{
             return false;
         }
 
-        stream.pack = (ot_venc_pack *)malloc(sizeof(ot_venc_pack) * stat.cur_packs);
-        if (stream.pack == NULL)
+        if(m_packs.size() < stat.cur_packs)
         {
-            DEV_WRITE_LOG_ERROR("malloc failed");
-            return false;
+            m_packs.resize(stat.cur_packs);
         }
+        stream.pack = m_packs.data();
         stream.pack_cnt = stat.cur_packs;
 
         ret = ss_mpi_venc_get_stream(m_venc_chn, &stream, -1);
         if(ret != TD_SUCCESS)
         {
-            free(stream.pack);
             DEV_WRITE_LOG_ERROR("ss_mpi_get_stream failed with %#x", ret);
             return false;
         }
 
-        FILE* f = fopen(path,"wb");
-        if(!f)
+        uint32_t len = 0;
+        for(td_u32 i = 0; i < stream.pack_cnt; i++)
         {
-            free(stream.pack);
-            ss_mpi_venc_release_stream(m_venc_chn, &stream);
-            return false;
+            len += stream.pack[i].len - stream.pack[i].offset;
         }
-        for (i = 0; i < stream.pack_cnt; i++) 
+
+        img->data.reserve(len);
+        for(td_u32 i = 0; i < stream.pack_cnt; i++)
         {
-            fwrite(stream.pack[i].addr + stream.pack[i].offset,stream.pack[i].len - stream.pack[i].offset, 1,f);
+            img->data.insert(img->data.end(),stream.pack[i].addr + stream.pack[i].offset,stream.pack[i].addr + stream.pack[i].len);
         }
+        img->pts = stream.pack[0].pts;
 
-        fclose(f);
         ss_mpi_venc_release_stream(m_venc_chn, &stream);
-        free(stream.pack);
         return true;
     }
 
+    void snap::save(const std::string& path,snap_image_ptr img)
+    {
+        std::unique_lock<std::mutex> lock(m_save_mu);
+        if(m_saves.size() >= SNAP_MAX_SAVE)
+        {
+            DEV_WRITE_LOG_ERROR("snap chn %d writes too slow,%s dropped",m_venc_chn,path.c_str());
+            return;
+        }
+
+        m_saves.push_back(std::make_pair(path,img));
+        m_save_cond.notify_one();
+    }
+
+    void snap::on_save()
+    {
+        while(true)
+        {
+            std::pair<std::string,snap_image_ptr> item;
+            {
+                std::unique_lock<std::mutex> lock(m_save_mu);
+                m_save_cond.wait(lock,[this](){ return !m_save_run || !m_saves.empty(); });
+                if(m_saves.empty())
+                {
+                    break;
+                }
+
+                item = m_saves.front();
+                m_saves.pop_front();
+            }
+
+            FILE* f = fopen(item.first.c_str(),"wb");
+            if(!f)
+            {
+                DEV_WRITE_LOG_ERROR("open %s failed",item.first.c_str());
+                continue;
+            }
+
+            if(fwrite(item.second->data.data(),1,item.second->data.size(),f) != item.second->data.size())
+            {
+                DEV_WRITE_LOG_ERROR("write %s failed",item.first.c_str());
+            }
+            fclose(f);
+        }
+
+        DEV_WRITE_LOG_INFO("snap save thread exit");
+    }
+
     bool snap::is_start()
     {
         return m_bstart;
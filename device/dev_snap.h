@@ -4,10 +4,54 @@
 #include "dev_std.h"
 #include "dev_vi.h"
 #include "dev_vi_isp.h"
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
 
 namespace hisilicon{namespace dev{
 
-    class snap 
+//requests waiting for the snap thread,more are refused
+#define SNAP_MAX_REQUEST 8
+//jpegs waiting to be written,more are dropped
+#define SNAP_MAX_SAVE 16
+//a single shot with the same quality and info within this window gets the latest jpeg again
+#define SNAP_DEFAULT_CACHE_MS 1000
+
+    class osd_name;
+
+    //one encoded jpeg
+    typedef struct
+    {
+        std::vector<uint8_t> data;
+        uint64_t pts;
+        time_t time;
+        //shot index within a burst
+        int index;
+    }snap_image;
+    typedef std::shared_ptr<snap_image> snap_image_ptr;
+
+    typedef struct snap_request
+    {
+        snap_request()
+            :quality(90),count(1),interval_ms(0)
+        {
+        }
+
+        int quality;
+        std::string info;
+        //burst mode when count > 1,interval_ms between shots
+        int count;
+        int interval_ms;
+        //written in the background when not empty,burst shots get _<index> before the extension
+        std::string path;
+        //called from the snap thread for every shot,nullptr when the shot failed
+        std::function<void(snap_image_ptr)> on_done;
+    }snap_request;
+
+    class snap
     {
         public:
             snap(std::shared_ptr<vi> vi_ptr);
@@ -18,13 +62,59 @@ namespace hisilicon{namespace dev{
 
             bool is_start();
 
+            //queue the request and return at once,false when the queue is full
+            bool request(const snap_request& req);
+
+            //single shot,blocks until the jpeg is encoded or timeout_ms passed
+            snap_image_ptr capture(int quality,const char* str_info,int timeout_ms = 2000);
+
+            //the last jpeg encoded,nullptr before the first one
+            snap_image_ptr latest();
+
+            void set_cache_ms(int cache_ms);
+
+            //write a jpeg to path in the background
             bool trigger(const char* path,int quality,const char* str_info);
 
+        private:
+            void on_snap();
+            void on_save();
+            void process(const snap_request& req);
+            snap_image_ptr shot(int quality,const char* str_info,int index);
+            bool set_quality(int quality);
+            void update_osd(const char* str_info);
+            bool get_jpeg(snap_image_ptr img);
+            void save(const std::string& path,snap_image_ptr img);
+
         private:
             std::shared_ptr<vi> m_vi_ptr;
             ot_venc_chn m_venc_chn;
             ot_venc_chn_attr m_venc_chn_attr;
-            bool m_bstart;
+            std::atomic<bool> m_bstart;
+
+            std::mutex m_mu;
+            std::condition_variable m_cond;
+            std::deque<snap_request> m_reqs;
+            std::thread m_thd;
+
+            std::mutex m_save_mu;
+            std::condition_variable m_save_cond;
+            std::deque<std::pair<std::string,snap_image_ptr>> m_saves;
+            bool m_save_run;
+            std::thread m_save_thd;
+
+            //only touched by the snap thread
+            std::shared_ptr<osd_name> m_osd_date;
+            std::shared_ptr<osd_name> m_osd_info;
+            std::vector<ot_venc_pack> m_packs;
+            int m_quality;
+
+            std::mutex m_latest_mu;
+            snap_image_ptr m_latest;
+            int m_latest_quality;
+            std::string m_latest_info;
+            std::chrono::steady_clock::time_point m_latest_tp;
+            int m_cache_ms;
     };
 
 }}//namespace
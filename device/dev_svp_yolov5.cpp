@@ -3,6 +3,7 @@
 #include "dev_log.h"
 #include "ceanic_freetype.h"
 #include <util/check_interval.h>
+#include <sys/time.h>
 
 namespace hisilicon{namespace dev{
 
@@ -20,10 +21,11 @@ namespace hisilicon{namespace dev{
 
 static std::vector<std::string> g_yolov5_class_str = {"person", "bicycle", "car", "motorcycle", "airplane", "bus", "train", "truck", "boat", "traffic light", "fire hydrant", "stop sign", "parking meter", "bench", "bird", "cat", "dog", "horse", "sheep", "cow", "elephant", "bear", "zebra", "giraffe", "backpack", "umbrella", "handbag", "tie", "suitcase", "frisbee", "skis", "snowboard", "sports ball", "kite", "baseball bat", "baseball glove", "skateboard", "surfboard", "tennis racket", "bottle", "wine glass", "cup", "fork", "knife", "spoon", "bowl", "banana", "apple", "sandwich", "orange", "broccoli", "carrot", "hot dog", "pizza", "donut", "cake", "chair", "couch", "potted plant", "bed", "dining table", "toilet", "tv", "laptop", "mouse", "remote", "keyboard", "cell phone", "microwave", "oven", "toaster", "sink", "refrigerator", "book", "clock", "vase", "scissors", "teddy bear", "hair drier", "toothbrush"};
 
-    yolov5::yolov5(int32_t chn,int32_t stream,std::shared_ptr<vi> vi_ptr,const char* model_path)
+    yolov5::yolov5(int32_t chn,int32_t stream,std::shared_ptr<vi> vi_ptr,const char* model_path,bool burn_in,bool metadata,uint32_t track_interval,
+            const yolov5_post_t* post)
         :stream_obj("yolov5_stream",chn,stream),m_is_start(false),m_model_path(model_path),m_vi_ptr(vi_ptr),m_vb_poolid(OT_VB_INVALID_POOL_ID)
          ,m_vpss_grp(0),m_vpss_chn(0),m_model_mem_size(0),m_model_mem_ptr(NULL),m_model_id(0),m_model_desc(NULL)
-         ,m_input_num(0),m_output_num(0),m_dynamic_batch_idx(0)
+         ,m_input_num(0),m_output_num(0),m_dynamic_batch_idx(0),m_burn_in(burn_in),m_metadata(metadata)
     {
         //init vpss chn attr
         memset(&m_vpss_chn_attr,0,sizeof(m_vpss_chn_attr));
@@ -75,6 +77,31 @@ static std::vector<std::string> g_yolov5_class_str = {"person", "bicycle", "car"
             m_rgn[i] =  OT_INVALID_HANDLE;
         }
 
+        memset(m_slots,0,sizeof(m_slots));
+        m_capture_done = false;
+        memset(&m_stat,0,sizeof(m_stat));
+        memset(&m_stat_acc,0,sizeof(m_stat_acc));
+        m_stat_beg_us = 0;
+        m_last_done_us = 0;
+
+        m_detect_interval = 1;
+        m_since_detect = 0;
+        m_motion_gate = false;
+
+        m_cpu_post = post != NULL;
+        memset(&m_post_cfg,0,sizeof(m_post_cfg));
+        if(post)
+        {
+            m_post_cfg = *post;
+        }
+        m_dump_left = 0;
+        if(track_interval > 0)
+        {
+            ceanic::tracker::mot_tracker_param param = ceanic::tracker::mot_tracker::default_param();
+            param.max_interval = track_interval;
+            m_tracker = std::make_shared<ceanic::tracker::mot_tracker>(&param);
+        }
+
         m_max_rgn_w = 0;
         char str[255];
         int rgn_w;
@@ -99,12 +126,9 @@ static std::vector<std::string> g_yolov5_class_str = {"person", "bicycle", "car"
         char* es_buf = NULL;
         int es_len = 0;
         int es_type = 0;
-        int nalu_cnt = 0;
         unsigned long long time_stamp = 0;
 
         ceanic::util::stream_head sh;
-
-        memset(&sh,0,sizeof(sh));
         sh.type = STREAM_NALU_SLICE;    
 
         for(unsigned int i = 0; i < pstream->pack_cnt; i++)
@@ -119,13 +143,8 @@ static std::vector<std::string> g_yolov5_class_str = {"person", "bicycle", "car"
                     || es_type == 0x1 /*p*/
                     || es_type == 0x5 /*i*/)
             {
-                sh.nalu[nalu_cnt].data = (uint8_t*)es_buf;
-                sh.nalu[nalu_cnt].size = es_len; 
-                sh.nalu[nalu_cnt].time_stamp = time_stamp;
-
-                nalu_cnt++;
+                sh.nalu.push_back((uint8_t*)es_buf,es_len,time_stamp);
             }
-            sh.nalu_count = nalu_cnt;
         }
         post_stream_to_observer(shared_from_this(),&sh,NULL,0);
     }
@@ -168,7 +187,7 @@ static std::vector<std::string> g_yolov5_class_str = {"person", "bicycle", "car"
         return true;
     }
 
-    bool yolov5::create_svp_output()
+    bool yolov5::create_svp_output(svp_npu_task_info_t* task)
     {
         td_s32 ret;
         svp_acl_data_buffer *output_data = TD_NULL;
@@ -198,16 +217,16 @@ static std::vector<std::string> g_yolov5_class_str = {"person", "bicycle", "car"
             }
         }
 
-        m_task_info.output_dataset = output_dataset;
+        task->output_dataset = output_dataset;
         return true;
     }
 
-    void yolov5::destroy_svp_output_buffer(int index)
+    void yolov5::destroy_svp_output_buffer(svp_npu_task_info_t* task,int index)
     {
         td_void *data = TD_NULL;
         svp_acl_data_buffer *data_buffer = TD_NULL;
 
-        data_buffer = svp_acl_mdl_get_dataset_buffer(m_task_info.output_dataset,index);
+        data_buffer = svp_acl_mdl_get_dataset_buffer(task->output_dataset,index);
         if(data_buffer)
         {
             data = svp_acl_get_data_buffer_addr(data_buffer);
@@ -216,55 +235,55 @@ static std::vector<std::string> g_yolov5_class_str = {"person", "bicycle", "car"
         }
     }
 
-    void yolov5::destroy_svp_output()
+    void yolov5::destroy_svp_output(svp_npu_task_info_t* task)
     {
         size_t i;
         size_t output_num;
 
-        if(m_task_info.output_dataset)
+        if(task->output_dataset)
         {
-            output_num = svp_acl_mdl_get_dataset_num_buffers(m_task_info.output_dataset);
+            output_num = svp_acl_mdl_get_dataset_num_buffers(task->output_dataset);
             for (i = 0; i < output_num; i++)
             {
-                destroy_svp_output_buffer(i);
+                destroy_svp_output_buffer(task,i);
             }
 
-            svp_acl_mdl_destroy_dataset(m_task_info.output_dataset);
-            m_task_info.output_dataset = NULL;
+            svp_acl_mdl_destroy_dataset(task->output_dataset);
+            task->output_dataset = NULL;
         }
     }
 
-    void yolov5::destroy_svp_input()
+    void yolov5::destroy_svp_input(svp_npu_task_info_t* task)
     {
         size_t i;
         size_t input_num;
 
-        if(m_task_info.input_dataset)
+        if(task->input_dataset)
         {
-            input_num = svp_acl_mdl_get_dataset_num_buffers(m_task_info.input_dataset);
+            input_num = svp_acl_mdl_get_dataset_num_buffers(task->input_dataset);
             for (i = 0; i < input_num; i++)
             {
-                destroy_svp_input_buffer(i);
+                destroy_svp_input_buffer(task,i);
             }
 
-            m_task_info.task_buf_ptr = NULL;
-            m_task_info.task_buf_size = 0;
-            m_task_info.task_buf_stride = 0;
-            m_task_info.work_buf_ptr = NULL;
-            m_task_info.work_buf_size = 0;
-            m_task_info.work_buf_stride = 0;
+            task->task_buf_ptr = NULL;
+            task->task_buf_size = 0;
+            task->task_buf_stride = 0;
+            task->work_buf_ptr = NULL;
+            task->work_buf_size = 0;
+            task->work_buf_stride = 0;
 
-            svp_acl_mdl_destroy_dataset(m_task_info.input_dataset);
-            m_task_info.input_dataset = NULL;
+            svp_acl_mdl_destroy_dataset(task->input_dataset);
+            task->input_dataset = NULL;
         }
     }
 
-    void yolov5::destroy_svp_input_buffer(int index)
+    void yolov5::destroy_svp_input_buffer(svp_npu_task_info_t* task,int index)
     {
         td_void *data = TD_NULL;
         svp_acl_data_buffer *data_buffer = TD_NULL;
 
-        data_buffer = svp_acl_mdl_get_dataset_buffer(m_task_info.input_dataset,index);
+        data_buffer = svp_acl_mdl_get_dataset_buffer(task->input_dataset,index);
         if(data_buffer)
         {
             data = svp_acl_get_data_buffer_addr(data_buffer);
@@ -307,7 +326,7 @@ static std::vector<std::string> g_yolov5_class_str = {"person", "bicycle", "car"
         return output_data;
     }
 
-    svp_acl_data_buffer* yolov5::create_svp_input_buffer(int index)
+    svp_acl_data_buffer* yolov5::create_svp_input_buffer(svp_npu_task_info_t* task,int index)
     {
         td_s32 ret;
         svp_acl_data_buffer *input_data = TD_NULL;
@@ -340,20 +359,20 @@ static std::vector<std::string> g_yolov5_class_str = {"person", "bicycle", "car"
 
         if((size_t)index == m_input_num - SAMPLE_SVP_NPU_EXTRA_INPUT_NUM)
         {
-            m_task_info.task_buf_ptr = input_buffer;
-            m_task_info.task_buf_size = buffer_size;
-            m_task_info.task_buf_stride = stride;
+            task->task_buf_ptr = input_buffer;
+            task->task_buf_size = buffer_size;
+            task->task_buf_stride = stride;
         }else if((size_t)index == m_input_num - 1)
         {
-            m_task_info.work_buf_ptr = input_buffer;
-            m_task_info.work_buf_size = buffer_size;
-            m_task_info.work_buf_stride = stride;
+            task->work_buf_ptr = input_buffer;
+            task->work_buf_size = buffer_size;
+            task->work_buf_stride = stride;
         }
 
         return input_data;
     }
 
-    bool yolov5::create_svp_input()
+    bool yolov5::create_svp_input(svp_npu_task_info_t* task)
     {
         td_s32 ret;
         size_t i;
@@ -368,7 +387,7 @@ static std::vector<std::string> g_yolov5_class_str = {"person", "bicycle", "car"
 
         for(i = 0; i < m_input_num - 2; i++)
         {
-            input_data = create_svp_input_buffer(i);
+            input_data = create_svp_input_buffer(task,i);
             if(input_data == NULL)
             {
                 svp_acl_mdl_destroy_dataset(input_dataset);
@@ -385,16 +404,16 @@ static std::vector<std::string> g_yolov5_class_str = {"person", "bicycle", "car"
         }
 
         //taskbuf
-        input_data =  create_svp_input_buffer(m_input_num - 2);
+        input_data =  create_svp_input_buffer(task,m_input_num - 2);
         assert(input_data != NULL);
         svp_acl_mdl_add_dataset_buffer(input_dataset,input_data);
 
         //workbuf
-        input_data = create_svp_input_buffer(m_input_num - 1);
+        input_data = create_svp_input_buffer(task,m_input_num - 1);
         assert(input_data != NULL);
         svp_acl_mdl_add_dataset_buffer(input_dataset,input_data);
 
-        m_task_info.input_dataset = input_dataset;
+        task->input_dataset = input_dataset;
         return true;
     }
 
@@ -475,7 +494,7 @@ static std::vector<std::string> g_yolov5_class_str = {"person", "bicycle", "car"
         destroy_vb_pool();
     }
 
-    bool yolov5::set_svp_threshold()
+    bool yolov5::set_svp_threshold(svp_npu_task_info_t* task)
     {
         td_u32 n;
         svp_acl_error ret;
@@ -490,7 +509,7 @@ static std::vector<std::string> g_yolov5_class_str = {"person", "bicycle", "car"
             return false;
         }
 
-        data_buffer = svp_acl_mdl_get_dataset_buffer(m_task_info.input_dataset, idx);
+        data_buffer = svp_acl_mdl_get_dataset_buffer(task->input_dataset, idx);
         if(data_buffer == TD_NULL)
         {
             DEV_WRITE_LOG_ERROR("svp_acl_mdl_get_dataset_buffer failed");
@@ -544,7 +563,7 @@ static std::vector<std::string> g_yolov5_class_str = {"person", "bicycle", "car"
         return true;
     }
 
-    bool yolov5::get_svp_rio(svp_npu_rect_info_t* rect_info)
+    bool yolov5::get_svp_rio(svp_npu_task_info_t* task,svp_npu_rect_info_t* rect_info)
     {
         svp_acl_error ret;
         size_t roi_idx, stride;
@@ -558,7 +577,7 @@ static std::vector<std::string> g_yolov5_class_str = {"person", "bicycle", "car"
         td_float *score = TD_NULL;
         td_float *class_id = TD_NULL;
 
-        if(!get_svp_roi_num(&rect_info->num))
+        if(!get_svp_roi_num(task,&rect_info->num))
         {
             return false;
         }
@@ -570,7 +589,7 @@ static std::vector<std::string> g_yolov5_class_str = {"person", "bicycle", "car"
             return false;
         }
 
-        data_buffer = svp_acl_mdl_get_dataset_buffer(m_task_info.output_dataset, roi_idx);
+        data_buffer = svp_acl_mdl_get_dataset_buffer(task->output_dataset, roi_idx);
         if(data_buffer == TD_NULL)
         {
             DEV_WRITE_LOG_ERROR("svp_acl_mdl_get_dataset_buffer failed");
@@ -613,6 +632,7 @@ static std::vector<std::string> g_yolov5_class_str = {"person", "bicycle", "car"
 
              rect_info->rect[i].score = score[roi_offset];
              rect_info->rect[i].class_id = (td_u32)class_id[roi_offset];
+             rect_info->rect[i].id = i;
 
              roi_offset++;
          }
@@ -620,7 +640,110 @@ static std::vector<std::string> g_yolov5_class_str = {"person", "bicycle", "car"
          return true;
     }
 
-    bool yolov5::get_svp_roi_num(td_u16* pnum)
+    bool yolov5::create_yolo_post()
+    {
+        svp_acl_error ret;
+        svp_acl_mdl_io_dims dims;
+
+        //one view per output,[..,c][h][w],rows at the default stride
+        m_tensors.clear();
+        for(size_t i = 0; i < m_output_num; i++)
+        {
+            ret = svp_acl_mdl_get_output_dims(m_model_desc,i,&dims);
+            if(ret != SVP_ACL_SUCCESS || dims.dim_count < 1)
+            {
+                DEV_WRITE_LOG_ERROR("svp_acl_mdl_get_output_dims failed with error 0x%x",ret);
+                return false;
+            }
+
+            ceanic::yolo::yolo_tensor t;
+            t.data = NULL;
+            t.w = dims.dims[dims.dim_count - 1];
+            t.h = dims.dim_count >= 2 ? dims.dims[dims.dim_count - 2] : 1;
+            t.c = 1;
+            for(size_t d = 0; d + 2 < dims.dim_count; d++)
+            {
+                t.c *= dims.dims[d];
+            }
+            t.stride = svp_acl_mdl_get_output_default_stride(m_model_desc,i) / sizeof(float);
+            if(t.stride < t.w)
+            {
+                DEV_WRITE_LOG_ERROR("yolo post:output %d stride %d below width %d",i,t.stride,t.w);
+                return false;
+            }
+            DEV_WRITE_LOG_INFO("yolo post:output %d,c %d,h %d,w %d,stride %d",i,t.c,t.h,t.w,t.stride);
+            m_tensors.push_back(t);
+        }
+
+        ceanic::yolo::yolo_post_param param = m_post_cfg.param;
+        param.input_w = m_pic_size.width;
+        param.input_h = m_pic_size.height;
+        param.max_det = std::min(param.max_det,(uint32_t)SVP_RECT_NUM);
+        m_post = std::make_shared<ceanic::yolo::yolo_post>(&param);
+        m_dump_left = m_post_cfg.dump_file[0] ? m_post_cfg.dump_frames : 0;
+        return true;
+    }
+
+    bool yolov5::decode_svp_output(svp_npu_task_info_t* task,svp_npu_rect_info_t* rect_info)
+    {
+        uint64_t beg = now_us();
+        for(size_t i = 0; i < m_tensors.size(); i++)
+        {
+            svp_acl_data_buffer* data_buffer = svp_acl_mdl_get_dataset_buffer(task->output_dataset,i);
+            m_tensors[i].data = data_buffer ? (const float*)svp_acl_get_data_buffer_addr(data_buffer) : NULL;
+            if(m_tensors[i].data == NULL)
+            {
+                DEV_WRITE_LOG_ERROR("svp_acl_get_data_buffer_addr failed");
+                return false;
+            }
+        }
+
+        if(m_dump_left > 0)
+        {
+            m_dump_left--;
+            if(!ceanic::yolo::yolo_post::save_tensors(m_post_cfg.dump_file,m_tensors))
+            {
+                DEV_WRITE_LOG_ERROR("yolo post:save tensors to %s failed",m_post_cfg.dump_file);
+                m_dump_left = 0;
+            }
+        }
+
+        if(!m_post->process(m_tensors,m_boxes))
+        {
+            DEV_WRITE_LOG_ERROR("yolo post:the model outputs do not fit head %d with %d classes",
+                    m_post_cfg.param.head,m_post_cfg.param.num_classes);
+            return false;
+        }
+
+        //even for the vgs,like the npu layers give them
+        rect_info->num = std::min((int)m_boxes.size(),SVP_RECT_NUM);
+        for(int i = 0; i < rect_info->num; i++)
+        {
+            const ceanic::yolo::yolo_box& b = m_boxes[i];
+            svp_npu_rect_t& r = rect_info->rect[i];
+            td_u32 x1 = (td_u32)b.x1 & (~1);
+            td_u32 y1 = (td_u32)b.y1 & (~1);
+            td_u32 x2 = (td_u32)b.x2 & (~1);
+            td_u32 y2 = (td_u32)b.y2 & (~1);
+            r.point[SAMPLE_SVP_NPU_RECT_LEFT_TOP].x = x1;
+            r.point[SAMPLE_SVP_NPU_RECT_LEFT_TOP].y = y1;
+            r.point[SAMPLE_SVP_NPU_RECT_RIGHT_TOP].x = x2;
+            r.point[SAMPLE_SVP_NPU_RECT_RIGHT_TOP].y = y1;
+            r.point[SAMPLE_SVP_NPU_RECT_RIGHT_BOTTOM].x = x2;
+            r.point[SAMPLE_SVP_NPU_RECT_RIGHT_BOTTOM].y = y2;
+            r.point[SAMPLE_SVP_NPU_RECT_LEFT_BOTTOM].x = x1;
+            r.point[SAMPLE_SVP_NPU_RECT_LEFT_BOTTOM].y = y2;
+            r.score = b.score;
+            r.class_id = b.class_id;
+            r.id = i;
+        }
+
+        std::unique_lock<std::mutex> lock(m_stat_mu);
+        m_stat_acc.decode_us += now_us() - beg;
+        return true;
+    }
+
+    bool yolov5::get_svp_roi_num(svp_npu_task_info_t* task,td_u16* pnum)
     {
         svp_acl_error ret;
         const char* NUM_NAME = "output0";
@@ -645,7 +768,7 @@ static std::vector<std::string> g_yolov5_class_str = {"person", "bicycle", "car"
             return false;
         }
 
-        data_buffer = svp_acl_mdl_get_dataset_buffer(m_task_info.output_dataset, num_idx);
+        data_buffer = svp_acl_mdl_get_dataset_buffer(task->output_dataset, num_idx);
         if(data_buffer == TD_NULL)
         {
             DEV_WRITE_LOG_ERROR("svp_acl_mdl_get_dataset_buffer failed");
@@ -734,22 +857,26 @@ static std::vector<std::string> g_yolov5_class_str = {"person", "bicycle", "car"
         DEV_WRITE_LOG_INFO("thread exit!");
     }
 
+    uint64_t yolov5::now_us()
+    {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC,&ts);
+        return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+    }
+
     void yolov5::on_process()
     {
         svp_acl_error ret;
         svp_acl_data_buffer *data_buffer = TD_NULL;
-        ot_video_frame_info frame;
         const td_s32 milli_sec = 1000;
-        svp_npu_rect_info_t rect_info;
         int i;
         td_void *virt_addr = TD_NULL;
-        td_void *ori_data = TD_NULL;
-        size_t ori_size,ori_stride;
         
         ret = svp_acl_rt_set_device(0);
         if(ret != SVP_ACL_SUCCESS)
         {
             DEV_WRITE_LOG_ERROR("svp_acl_rt_set_device failed with error 0x%x",ret);
+            finish_capture();
             return;
         }
 
@@ -757,77 +884,230 @@ static std::vector<std::string> g_yolov5_class_str = {"person", "bicycle", "car"
         if(virt_addr == NULL)
         {
             DEV_WRITE_LOG_ERROR("svp_mpi_ss_mmap failed");
+            finish_capture();
+            svp_acl_rt_reset_device(0);
             return;
         }
 
-        data_buffer = svp_acl_mdl_get_dataset_buffer(m_task_info.input_dataset, 0);
-        ori_data = svp_acl_get_data_buffer_addr(data_buffer);
-        ori_size = svp_acl_get_data_buffer_size(data_buffer);
-        ori_stride = svp_acl_get_data_buffer_stride(data_buffer);
+        //the vpss frame is handed to the npu in place,the own input buffers come back at the end
+        for(i = 0; i < YOLOV5_PIPE_DEPTH; i++)
+        {
+            data_buffer = svp_acl_mdl_get_dataset_buffer(m_slots[i].task.input_dataset, 0);
+            m_slots[i].ori_data = svp_acl_get_data_buffer_addr(data_buffer);
+            m_slots[i].ori_size = svp_acl_get_data_buffer_size(data_buffer);
+            m_slots[i].ori_stride = svp_acl_get_data_buffer_stride(data_buffer);
+        }
 
-        ceanic::util::check_interval ci;
         while(m_is_start)
         {
-            ret = ss_mpi_vpss_get_chn_frame(m_vpss_grp,m_vpss_chn,&frame,milli_sec);
+            int idx;
+            {
+                std::unique_lock<std::mutex> lock(m_pipe_mu);
+                if(m_free_slots.empty())
+                {
+                    //npu and post processing are behind,the vpss chn drops for us
+                    std::unique_lock<std::mutex> stat_lock(m_stat_mu);
+                    m_stat_acc.stall_cnt++;
+                }
+                m_pipe_cv.wait(lock,[this]{return !m_free_slots.empty() || !m_is_start;});
+                if(!m_is_start)
+                {
+                    break;
+                }
+                idx = m_free_slots.front();
+                m_free_slots.pop_front();
+            }
+
+            yolov5_slot_t& slot = m_slots[idx];
+            uint64_t beg = now_us();
+            ret = ss_mpi_vpss_get_chn_frame(m_vpss_grp,m_vpss_chn,&slot.frame,milli_sec);
             if(ret != TD_SUCCESS)
             {
                 DEV_WRITE_LOG_ERROR("svp_mpi_vpss_get_chn_frame failed with error 0x%x",ret);
+                release_slot(idx);
                 break;
             }
+            slot.get_us = now_us();
+            bool gated = process_motion(&slot.frame,virt_addr);
 
-            td_u32 frame_size = frame.video_frame.height * frame.video_frame.stride[0] * 3 / 2;
-            td_void* frame_virt_addr = (td_u8*)virt_addr + (frame.video_frame.phys_addr[0] - m_vb_pool_info.pool_phy_addr);
-            ret = svp_acl_update_data_buffer(data_buffer,frame_virt_addr,frame_size,frame.video_frame.stride[0]);
+            //the tracker extrapolates the frames in between,they only pass through the pipe
+            slot.detect = m_since_detect + 1 >= m_detect_interval && !gated;
+            if(!slot.detect)
+            {
+                m_since_detect++;
+                slot.submit_us = slot.get_us;
+                {
+                    std::unique_lock<std::mutex> lock(m_pipe_mu);
+                    m_busy_slots.push_back(idx);
+                }
+                m_pipe_cv.notify_all();
+                continue;
+            }
+            m_since_detect = 0;
+
+            data_buffer = svp_acl_mdl_get_dataset_buffer(slot.task.input_dataset, 0);
+            td_u32 frame_size = slot.frame.video_frame.height * slot.frame.video_frame.stride[0] * 3 / 2;
+            td_void* frame_virt_addr = (td_u8*)virt_addr + (slot.frame.video_frame.phys_addr[0] - m_vb_pool_info.pool_phy_addr);
+            ret = svp_acl_update_data_buffer(data_buffer,frame_virt_addr,frame_size,slot.frame.video_frame.stride[0]);
             if(ret != TD_SUCCESS)
             {
                 DEV_WRITE_LOG_ERROR("svp_acl_update_data_buffer failed with error 0x%x",ret);
-                ss_mpi_vpss_release_chn_frame(m_vpss_grp,m_vpss_chn,&frame);
+                ss_mpi_vpss_release_chn_frame(m_vpss_grp,m_vpss_chn,&slot.frame);
+                release_slot(idx);
                 break;
             }
 
-            //ci.set_beg();
-            ret = svp_acl_mdl_execute(m_model_id, m_task_info.input_dataset, m_task_info.output_dataset);
+            ret = svp_acl_mdl_execute_async(m_model_id, slot.task.input_dataset, slot.task.output_dataset, slot.stream);
             if(ret != TD_SUCCESS)
             {
-                DEV_WRITE_LOG_ERROR("svp_acl_mdl_execute failed with error 0x%x",ret);
-                ss_mpi_vpss_release_chn_frame(m_vpss_grp,m_vpss_chn,&frame);
+                DEV_WRITE_LOG_ERROR("svp_acl_mdl_execute_async failed with error 0x%x",ret);
+                ss_mpi_vpss_release_chn_frame(m_vpss_grp,m_vpss_chn,&slot.frame);
+                release_slot(idx);
                 break;
             }
-            //printf("interval=%lld\n",ci.interval());
+            slot.submit_us = now_us();
 
-            memset(&rect_info,0,sizeof(rect_info));
-            if(!get_svp_rio(&rect_info))
             {
-                ss_mpi_vpss_release_chn_frame(m_vpss_grp,m_vpss_chn,&frame);
-                break;
+                std::unique_lock<std::mutex> lock(m_stat_mu);
+                m_stat_acc.capture_us += slot.get_us - beg;
+                m_stat_acc.capture_cnt++;
             }
 
-            if(rect_info.num > 0)
             {
-#if 0
-                printf("----------ROI Data----------\n");
-                printf("\tnum:%d\n",rect_info.num);
-                for(i = 0; i < rect_info.num; i++)
-                {
-                    printf("\trect[%d],score:%f,class_id:%d,lt(%d,%d),rt(%d,%d),rb(%d,%d),lb(%d,%d)\n",
-                            i,
-                            rect_info.rect[i].score,
-                            rect_info.rect[i].class_id,
-                            rect_info.rect[i].point[SAMPLE_SVP_NPU_RECT_LEFT_TOP].x,rect_info.rect[i].point[SAMPLE_SVP_NPU_RECT_LEFT_TOP].y,
-                            rect_info.rect[i].point[SAMPLE_SVP_NPU_RECT_RIGHT_TOP].x,rect_info.rect[i].point[SAMPLE_SVP_NPU_RECT_RIGHT_TOP].y,
-                            rect_info.rect[i].point[SAMPLE_SVP_NPU_RECT_RIGHT_BOTTOM].x,rect_info.rect[i].point[SAMPLE_SVP_NPU_RECT_RIGHT_BOTTOM].y,
-                            rect_info.rect[i].point[SAMPLE_SVP_NPU_RECT_LEFT_BOTTOM].x,rect_info.rect[i].point[SAMPLE_SVP_NPU_RECT_LEFT_BOTTOM].y);
-                }
-#endif
-                svp_vgs_fill_rect(&frame, &rect_info,0x0000FF00);
+                std::unique_lock<std::mutex> lock(m_pipe_mu);
+                m_busy_slots.push_back(idx);
             }
-            ss_mpi_venc_send_frame(m_venc_chn,&frame,1000);
-            ss_mpi_vpss_release_chn_frame(m_vpss_grp,m_vpss_chn,&frame);
+            m_pipe_cv.notify_all();
         }
 
-        svp_acl_update_data_buffer(data_buffer,ori_data,ori_size,ori_stride);
+        //the post stage drains what is still on the npu before the buffers go back
+        finish_capture();
+        {
+            std::unique_lock<std::mutex> lock(m_pipe_mu);
+            m_pipe_cv.wait(lock,[this]{return m_free_slots.size() == YOLOV5_PIPE_DEPTH;});
+        }
+
+        for(i = 0; i < YOLOV5_PIPE_DEPTH; i++)
+        {
+            data_buffer = svp_acl_mdl_get_dataset_buffer(m_slots[i].task.input_dataset, 0);
+            svp_acl_update_data_buffer(data_buffer,m_slots[i].ori_data,m_slots[i].ori_size,m_slots[i].ori_stride);
+        }
         ss_mpi_sys_munmap(virt_addr,m_vb_pool_info.pool_size);
         svp_acl_rt_reset_device(0);
+    }
+
+    void yolov5::finish_capture()
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_pipe_mu);
+            m_capture_done = true;
+        }
+        m_pipe_cv.notify_all();
+    }
+
+    void yolov5::release_slot(int idx)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_pipe_mu);
+            m_free_slots.push_back(idx);
+        }
+        m_pipe_cv.notify_all();
+    }
+
+    void yolov5::on_post_process()
+    {
+        svp_acl_error ret;
+        svp_npu_rect_info_t rect_info;
+        int i;
+
+        ret = svp_acl_rt_set_device(0);
+        if(ret != SVP_ACL_SUCCESS)
+        {
+            DEV_WRITE_LOG_ERROR("svp_acl_rt_set_device failed with error 0x%x",ret);
+        }
+
+        while(true)
+        {
+            int idx;
+            {
+                std::unique_lock<std::mutex> lock(m_pipe_mu);
+                m_pipe_cv.wait(lock,[this]{return !m_busy_slots.empty() || m_capture_done;});
+                if(m_busy_slots.empty())
+                {
+                    break;
+                }
+                idx = m_busy_slots.front();
+                m_busy_slots.pop_front();
+            }
+
+            //slots finish in submit order,waiting on the oldest keeps the frames in order
+            yolov5_slot_t& slot = m_slots[idx];
+            ret = slot.detect ? svp_acl_rt_synchronize_stream(slot.stream) : SVP_ACL_SUCCESS;
+            uint64_t done_us = now_us();
+            if(ret != SVP_ACL_SUCCESS)
+            {
+                DEV_WRITE_LOG_ERROR("svp_acl_rt_synchronize_stream failed with error 0x%x",ret);
+            }
+            else
+            {
+                memset(&rect_info,0,sizeof(rect_info));
+                bool got = true;
+                if(slot.detect)
+                {
+                    got = m_post ? decode_svp_output(&slot.task,&rect_info) : get_svp_rio(&slot.task,&rect_info);
+                }
+
+                if(got)
+                {
+                    if(m_tracker)
+                    {
+                        track_rect(slot.detect,&rect_info);
+                    }
+
+                    if(rect_info.num > 0 && m_burn_in)
+                    {
+                        svp_vgs_fill_rect(&slot.frame, &rect_info,0x0000FF00);
+                    }
+
+                    update_roi(&rect_info);
+
+                    if(m_metadata)
+                    {
+                        //empty documents too,so clients drop the boxes of the last frame
+                        post_metadata(&rect_info,slot.frame.video_frame.pts);
+                    }
+
+                    if(m_burn_in)
+                    {
+                        ss_mpi_venc_send_frame(m_venc_chn,&slot.frame,1000);
+                    }
+                }
+            }
+            ss_mpi_vpss_release_chn_frame(m_vpss_grp,m_vpss_chn,&slot.frame);
+            uint64_t end_us = now_us();
+
+            //the npu runs one task at a time,this one started when the previous was done
+            uint64_t exec_beg = slot.submit_us > m_last_done_us ? slot.submit_us : m_last_done_us;
+            if(slot.detect)
+            {
+                m_last_done_us = done_us;
+            }
+
+            {
+                std::unique_lock<std::mutex> lock(m_stat_mu);
+                if(slot.detect)
+                {
+                    m_stat_acc.infer_us += done_us > exec_beg ? done_us - exec_beg : 0;
+                    m_stat_acc.detects++;
+                }
+                m_stat_acc.post_us += end_us - done_us;
+                m_stat_acc.latency_us += end_us - slot.get_us;
+                m_stat_acc.frames++;
+                update_stat(end_us);
+            }
+
+            release_slot(idx);
+        }
 
         for(i = 0; i < SVP_RECT_NUM; i++)
         {
@@ -837,6 +1117,253 @@ static std::vector<std::string> g_yolov5_class_str = {"person", "bicycle", "car"
                 m_rgn[i] = OT_INVALID_HANDLE;
             }
         }
+
+        svp_acl_rt_reset_device(0);
+    }
+
+    void yolov5::update_stat(uint64_t now)
+    {
+        if(m_stat_beg_us == 0)
+        {
+            m_stat_beg_us = now;
+            return;
+        }
+
+        uint64_t elapse = now - m_stat_beg_us;
+        if(elapse < 1000000)
+        {
+            return;
+        }
+
+        //averages over the last second,m_stat_mu held
+        stat_acc_t& a = m_stat_acc;
+        m_stat.frames += a.frames;
+        m_stat.fps = (uint32_t)((a.frames * 1000000 + elapse / 2) / elapse);
+        m_stat.detect_fps = (uint32_t)((a.detects * 1000000 + elapse / 2) / elapse);
+        m_stat.capture_us = a.capture_cnt ? (uint32_t)(a.capture_us / a.capture_cnt) : 0;
+        m_stat.infer_us = a.detects ? (uint32_t)(a.infer_us / a.detects) : 0;
+        m_stat.post_us = a.frames ? (uint32_t)(a.post_us / a.frames) : 0;
+        m_stat.decode_us = a.detects ? (uint32_t)(a.decode_us / a.detects) : 0;
+        m_stat.motion_us = a.motion_cnt ? (uint32_t)(a.motion_us / a.motion_cnt) : 0;
+        m_stat.latency_us = a.frames ? (uint32_t)(a.latency_us / a.frames) : 0;
+        m_stat.npu_busy = (uint32_t)(a.infer_us * 100 / elapse);
+        m_stat.stall_cnt += a.stall_cnt;
+
+        memset(&a,0,sizeof(a));
+        m_stat_beg_us = now;
+    }
+
+    void yolov5::track_rect(bool detect,svp_npu_rect_info_t* rect_info)
+    {
+        const std::vector<ceanic::tracker::track>* tracks;
+        if(detect)
+        {
+            m_dets.resize(std::min((int)rect_info->num,SVP_RECT_NUM));
+            for(size_t i = 0; i < m_dets.size(); i++)
+            {
+                const svp_npu_rect_t& r = rect_info->rect[i];
+                m_dets[i].x1 = r.point[SAMPLE_SVP_NPU_RECT_LEFT_TOP].x;
+                m_dets[i].y1 = r.point[SAMPLE_SVP_NPU_RECT_LEFT_TOP].y;
+                m_dets[i].x2 = r.point[SAMPLE_SVP_NPU_RECT_RIGHT_BOTTOM].x;
+                m_dets[i].y2 = r.point[SAMPLE_SVP_NPU_RECT_RIGHT_BOTTOM].y;
+                m_dets[i].score = r.score;
+                m_dets[i].class_id = r.class_id;
+            }
+            tracks = &m_tracker->update(m_dets);
+            m_detect_interval = m_tracker->interval();
+        }
+        else
+        {
+            tracks = &m_tracker->predict();
+        }
+
+        //back to frame coordinates,even for the vgs and inside the picture
+        int max_x = (m_pic_size.width - 2) & (~1);
+        int max_y = (m_pic_size.height - 2) & (~1);
+        rect_info->num = 0;
+        for(size_t i = 0; i < tracks->size() && rect_info->num < SVP_RECT_NUM; i++)
+        {
+            const ceanic::tracker::track& t = (*tracks)[i];
+            int x1 = std::min(std::max((int)t.x1,0),max_x) & (~1);
+            int y1 = std::min(std::max((int)t.y1,0),max_y) & (~1);
+            int x2 = std::min(std::max((int)t.x2,0),max_x) & (~1);
+            int y2 = std::min(std::max((int)t.y2,0),max_y) & (~1);
+            if(x2 <= x1 || y2 <= y1)
+            {
+                continue;
+            }
+
+            svp_npu_rect_t& r = rect_info->rect[rect_info->num++];
+            r.class_id = t.class_id;
+            r.score = t.score;
+            r.id = t.id;
+            r.point[SAMPLE_SVP_NPU_RECT_LEFT_TOP].x = x1;
+            r.point[SAMPLE_SVP_NPU_RECT_LEFT_TOP].y = y1;
+            r.point[SAMPLE_SVP_NPU_RECT_RIGHT_TOP].x = x2;
+            r.point[SAMPLE_SVP_NPU_RECT_RIGHT_TOP].y = y1;
+            r.point[SAMPLE_SVP_NPU_RECT_RIGHT_BOTTOM].x = x2;
+            r.point[SAMPLE_SVP_NPU_RECT_RIGHT_BOTTOM].y = y2;
+            r.point[SAMPLE_SVP_NPU_RECT_LEFT_BOTTOM].x = x1;
+            r.point[SAMPLE_SVP_NPU_RECT_LEFT_BOTTOM].y = y2;
+        }
+    }
+
+    void yolov5::add_roi_venc(venc_ptr v)
+    {
+        std::unique_lock<std::mutex> lock(m_roi_mu);
+        m_roi_vencs.push_back(v);
+    }
+
+    void yolov5::clear_roi_venc()
+    {
+        std::unique_lock<std::mutex> lock(m_roi_mu);
+        m_roi_vencs.clear();
+    }
+
+    void yolov5::update_roi(const svp_npu_rect_info_t* rect_info)
+    {
+        std::unique_lock<std::mutex> lock(m_roi_mu);
+        if(m_roi_vencs.empty())
+        {
+            return;
+        }
+
+        //empty frames too,the regions of gone objects expire
+        m_roi_boxes.resize(std::min((int)rect_info->num,SVP_RECT_NUM));
+        for(size_t i = 0; i < m_roi_boxes.size(); i++)
+        {
+            const svp_npu_rect_t& r = rect_info->rect[i];
+            m_roi_boxes[i].x1 = r.point[SAMPLE_SVP_NPU_RECT_LEFT_TOP].x;
+            m_roi_boxes[i].y1 = r.point[SAMPLE_SVP_NPU_RECT_LEFT_TOP].y;
+            m_roi_boxes[i].x2 = r.point[SAMPLE_SVP_NPU_RECT_RIGHT_BOTTOM].x;
+            m_roi_boxes[i].y2 = r.point[SAMPLE_SVP_NPU_RECT_RIGHT_BOTTOM].y;
+            m_roi_boxes[i].score = r.score;
+        }
+
+        for(size_t i = 0; i < m_roi_vencs.size(); i++)
+        {
+            m_roi_vencs[i]->update_roi(m_roi_boxes);
+        }
+    }
+
+    bool yolov5::start_motion(const ceanic::motion::motion_param* param,bool gate)
+    {
+        std::unique_lock<std::mutex> lock(m_motion_mu);
+        m_motion = std::make_shared<ceanic::motion::motion_detect>(m_pic_size.width,m_pic_size.height,param);
+        m_motion_gate = gate;
+        DEV_WRITE_LOG_INFO("yolov5 motion start,grid %dx%d,neon %d,gate %d",
+                m_motion->grid_w(),m_motion->grid_h(),ceanic::motion::motion_detect::has_neon(),gate);
+        return true;
+    }
+
+    void yolov5::stop_motion()
+    {
+        std::unique_lock<std::mutex> lock(m_motion_mu);
+        m_motion = nullptr;
+        m_motion_gate = false;
+    }
+
+    bool yolov5::get_motion_event(ceanic::motion::motion_event* event)
+    {
+        std::unique_lock<std::mutex> lock(m_motion_mu);
+        return m_motion && m_motion->get_event(event);
+    }
+
+    bool yolov5::process_motion(const ot_video_frame_info* frame,td_void* virt_addr)
+    {
+        std::unique_lock<std::mutex> lock(m_motion_mu);
+        if(!m_motion)
+        {
+            return false;
+        }
+
+        //luma plane of the vpss frame,read once by the first pyramid level
+        const ot_video_frame& vf = frame->video_frame;
+        if(vf.width != (td_u32)m_pic_size.width || vf.height != (td_u32)m_pic_size.height)
+        {
+            return false;
+        }
+
+        uint64_t beg = now_us();
+        const td_u8* luma = (const td_u8*)virt_addr + (vf.phys_addr[0] - m_vb_pool_info.pool_phy_addr);
+        uint32_t blocks = m_motion->process(luma,vf.stride[0]);
+        uint64_t end = now_us();
+
+        {
+            std::unique_lock<std::mutex> stat_lock(m_stat_mu);
+            m_stat_acc.motion_us += end - beg;
+            m_stat_acc.motion_cnt++;
+        }
+
+        return m_motion_gate && blocks == 0 && !m_motion->in_motion();
+    }
+
+    bool yolov5::get_stat(yolov5_stat_t* stat)
+    {
+        if(!m_is_start)
+        {
+            return false;
+        }
+
+        std::unique_lock<std::mutex> lock(m_stat_mu);
+        *stat = m_stat;
+        return true;
+    }
+
+    bool yolov5::create_svp_slots()
+    {
+        svp_acl_error ret;
+        int i;
+
+        for(i = 0; i < YOLOV5_PIPE_DEPTH; i++)
+        {
+            yolov5_slot_t& slot = m_slots[i];
+            if(!create_svp_input(&slot.task)
+                    || !create_svp_output(&slot.task)
+                    || (!m_cpu_post && !set_svp_threshold(&slot.task)))
+            {
+                destroy_svp_slots();
+                return false;
+            }
+
+            ret = svp_acl_rt_create_stream(&slot.stream);
+            if(ret != SVP_ACL_SUCCESS)
+            {
+                DEV_WRITE_LOG_ERROR("svp_acl_rt_create_stream failed with error 0x%x",ret);
+                slot.stream = NULL;
+                destroy_svp_slots();
+                return false;
+            }
+        }
+
+        m_free_slots.clear();
+        m_busy_slots.clear();
+        for(i = 0; i < YOLOV5_PIPE_DEPTH; i++)
+        {
+            m_free_slots.push_back(i);
+        }
+        m_capture_done = false;
+
+        memset(&m_stat,0,sizeof(m_stat));
+        memset(&m_stat_acc,0,sizeof(m_stat_acc));
+        m_stat_beg_us = 0;
+        m_last_done_us = 0;
+        return true;
+    }
+
+    void yolov5::destroy_svp_slots()
+    {
+        for(int i = 0; i < YOLOV5_PIPE_DEPTH; i++)
+        {
+            yolov5_slot_t& slot = m_slots[i];
+            if(slot.stream)
+            {
+                svp_acl_rt_destroy_stream(slot.stream);
+                slot.stream = NULL;
+            }
+            destroy_svp_output(&slot.task);
+            destroy_svp_input(&slot.task);
+        }
     }
 
     bool yolov5::start()
@@ -942,6 +1469,11 @@ static std::vector<std::string> g_yolov5_class_str = {"person", "bicycle", "car"
         m_pic_size.width = dims.dims[dims.dim_count - 1]; // NCHW
         DEV_WRITE_LOG_INFO("input_num = %d,yolov5 pic size=(%d,%d)",m_input_num,m_pic_size.width,m_pic_size.height);
 
+        if(m_cpu_post && !create_yolo_post())
+        {
+            goto end0;
+        }
+
         m_vpss_chn_attr.width = m_pic_size.width;
         m_vpss_chn_attr.height = m_pic_size.height;
         m_vpss_grp = m_vi_ptr->vpss_grp();
@@ -953,27 +1485,35 @@ static std::vector<std::string> g_yolov5_class_str = {"person", "bicycle", "car"
         m_venc_chn_attr.venc_attr.pic_height    = m_pic_size.height;
         m_venc_chn_attr.venc_attr.buf_size      = m_pic_size.width * m_pic_size.height * 3 / 2;
 
-        if(!create_vpss_grp_chn()
-                || !create_venc_chn())
+        if(!create_vpss_grp_chn())
+        {
+            goto end0;
+        }
+
+        if(m_burn_in && !create_venc_chn())
         {
+            destroy_vpss_grp_chn();
             goto end0;
         }
 
-        if(!create_svp_input()
-                || !create_svp_output()
-                || !set_svp_threshold())
+        if(!create_svp_slots())
         {
             goto end3;
         }
 
         m_is_start = true;
-        m_venc_thread = std::thread(&yolov5::on_venc_process,this);
+        if(m_burn_in)
+        {
+            m_venc_thread = std::thread(&yolov5::on_venc_process,this);
+        }
+        m_post_thread = std::thread(&yolov5::on_post_process,this);
         m_thread = std::thread(&yolov5::on_process,this);
         return true;
 end3:
-        destroy_svp_input();
-        destroy_svp_output();
-        destroy_venc_chn();
+        if(m_burn_in)
+        {
+            destroy_venc_chn();
+        }
         destroy_vpss_grp_chn();
 end0:
         svp_acl_mdl_destroy_desc(m_model_desc);
@@ -993,14 +1533,21 @@ end1:
             return ;
         }
 
-        m_is_start = false;
+        {
+            std::unique_lock<std::mutex> lock(m_pipe_mu);
+            m_is_start = false;
+        }
+        m_pipe_cv.notify_all();
         m_thread.join();
-        m_venc_thread.join();
+        m_post_thread.join();
+        if(m_burn_in)
+        {
+            m_venc_thread.join();
+            destroy_venc_chn();
+        }
 
-        destroy_venc_chn();
         destroy_vpss_grp_chn();
-        destroy_svp_output();
-        destroy_svp_input();
+        destroy_svp_slots();
 
         svp_acl_mdl_unload(m_model_id);
         svp_acl_mdl_destroy_desc(m_model_desc);
@@ -1020,6 +1567,62 @@ end1:
         return m_pic_size.height;
     }
 
+    bool yolov5::burn_in()
+    {
+        return m_burn_in;
+    }
+
+    bool yolov5::metadata()
+    {
+        return m_metadata;
+    }
+
+    void yolov5::post_metadata(const svp_npu_rect_info_t* rect_info,td_u64 pts)
+    {
+        struct timeval tv;
+        struct tm tm_now;
+        char str[512];
+
+        gettimeofday(&tv,NULL);
+        gmtime_r(&tv.tv_sec,&tm_now);
+
+        //the boxes are in pixels of the model input,the transformation maps them
+        //to the normalized [-1,1] space of onvif so they fit every stream of the chn
+        std::string& xml = m_metadata_xml;
+        xml = "<?xml version=\"1.0\" encoding=\"UTF-8\"?>";
+        xml += "<tt:MetadataStream xmlns:tt=\"http://www.onvif.org/ver10/schema\"><tt:VideoAnalytics>";
+        snprintf(str,sizeof(str),"<tt:Frame UtcTime=\"%04d-%02d-%02dT%02d:%02d:%02d.%03dZ\">"
+                "<tt:Transformation><tt:Translate x=\"-1.0\" y=\"1.0\"/><tt:Scale x=\"%.6f\" y=\"%.6f\"/></tt:Transformation>",
+                tm_now.tm_year + 1900,tm_now.tm_mon + 1,tm_now.tm_mday,tm_now.tm_hour,tm_now.tm_min,tm_now.tm_sec,(int)(tv.tv_usec / 1000),
+                2.0 / m_pic_size.width,-2.0 / m_pic_size.height);
+        xml += str;
+
+        for(int i = 0; i < rect_info->num && i < SVP_RECT_NUM; i++)
+        {
+            const svp_npu_rect_t& r = rect_info->rect[i];
+            int left = r.point[SAMPLE_SVP_NPU_RECT_LEFT_TOP].x;
+            int top = r.point[SAMPLE_SVP_NPU_RECT_LEFT_TOP].y;
+            int right = r.point[SAMPLE_SVP_NPU_RECT_RIGHT_BOTTOM].x;
+            int bottom = r.point[SAMPLE_SVP_NPU_RECT_RIGHT_BOTTOM].y;
+            const char* cls = r.class_id < g_yolov5_class_str.size() ? g_yolov5_class_str[r.class_id].c_str() : "unknown";
+
+            snprintf(str,sizeof(str),"<tt:Object ObjectId=\"%u\"><tt:Appearance><tt:Shape>"
+                    "<tt:BoundingBox left=\"%d\" top=\"%d\" right=\"%d\" bottom=\"%d\"/>"
+                    "<tt:CenterOfGravity x=\"%d\" y=\"%d\"/></tt:Shape>"
+                    "<tt:Class><tt:Type Likelihood=\"%.2f\">%s</tt:Type></tt:Class></tt:Appearance></tt:Object>",
+                    r.id,left,top,right,bottom,(left + right) / 2,(top + bottom) / 2,r.score,cls);
+            xml += str;
+        }
+        xml += "</tt:Frame></tt:VideoAnalytics></tt:MetadataStream>";
+
+        ceanic::util::stream_head sh;
+        sh.type = STREAM_META_FRAME;
+        sh.len = xml.size();
+        //same ms clock as the venc packs,so the rtp timestamps equal the video ones
+        sh.time_stamp = pts / 1000;
+        post_stream_to_observer(shared_from_this(),&sh,xml.c_str(),xml.size());
+    }
+
     void yolov5::svp_vgs_fill_rect(const ot_video_frame_info *frame_info,svp_npu_rect_info_t* rect,td_u32 color)
     {
         ot_vgs_handle vgs_handle = -1;
@@ -1082,7 +1685,9 @@ end1:
             vgs_add_osd.phys_addr = canvas_info.phys_addr;
             vgs_add_osd.stride = canvas_info.stride;
 
-            sprintf(str,"%s %.2f",g_yolov5_class_str[rect->rect[i].class_id].c_str(),rect->rect[i].score);
+            //custom class sets of the cpu post processing may go past the coco names
+            const char* cls = rect->rect[i].class_id < g_yolov5_class_str.size() ? g_yolov5_class_str[rect->rect[i].class_id].c_str() : "unknown";
+            sprintf(str,"%s %.2f",cls,rect->rect[i].score);
             unsigned short* p = (unsigned short*)canvas_info.virt_addr;
             for(unsigned int j = 0; j < canvas_info.size.width * canvas_info.size.height; j++)
             {
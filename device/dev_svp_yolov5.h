@@ -4,7 +4,15 @@
 #include "dev_svp.h"
 #include "dev_std.h"
 #include "dev_vi_isp.h"
+#include "dev_venc.h"
 #include <stream_observer.h>
+#include <mot_tracker.h>
+#include <motion/motion_detect.h>
+#include <yolo/yolo_post.h>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
 
 namespace hisilicon{namespace dev{
 
@@ -25,6 +33,7 @@ namespace hisilicon{namespace dev{
     {
         td_u16 class_id;
         float score;
+        td_u32 id;      //track id,the index in the frame without tracker
         ot_point point[SVP_RECT_POINT_NUM];
     }svp_npu_rect_t;
 
@@ -35,13 +44,58 @@ namespace hisilicon{namespace dev{
         svp_npu_rect_t rect[SVP_RECT_NUM];
     }svp_npu_rect_info_t;
 
+    //cpu post processing for models without the npu roi/nms layers
+    typedef struct
+    {
+        ceanic::yolo::yolo_post_param param;   //input_w/input_h come from the model
+        char dump_file[255];                    //raw outputs of the first dump_frames detections are appended here,"":off
+        uint32_t dump_frames;
+    }yolov5_post_t;
+
+//frames in flight:one waiting for vpss,one on the npu,one in post processing
+#define YOLOV5_PIPE_DEPTH 3
+    typedef struct
+    {
+        svp_npu_task_info_t task;
+        svp_acl_rt_stream stream;
+        ot_video_frame_info frame;
+        //own input buffer,swapped for the vpss frame while the slot is in use
+        td_void* ori_data;
+        size_t ori_size;
+        size_t ori_stride;
+        uint64_t get_us;
+        uint64_t submit_us;
+        bool detect;    //false:the tracker extrapolates this frame,nothing on the npu
+    }yolov5_slot_t;
+
+    //averages over the last second
+    typedef struct
+    {
+        uint64_t frames;     //frames through all stages since start
+        uint32_t fps;
+        uint32_t detect_fps; //frames the npu ran,below fps while the tracker skips
+        uint32_t capture_us; //waiting for the vpss frame
+        uint32_t infer_us;   //npu execution,queueing behind the previous frame excluded
+        uint32_t post_us;    //rois,metadata,boxes and venc
+        uint32_t decode_us;  //cpu decode and nms of the raw heads,0 with the npu layers
+        uint32_t motion_us;  //motion analysis of a frame,0 without
+        uint32_t latency_us; //vpss frame to release
+        uint32_t npu_busy;   //percent of the second the npu had work
+        uint32_t stall_cnt;  //capture found no free slot,since start
+    }yolov5_stat_t;
+
     class yolov5 
         :public ceanic::util::stream_obj
         ,public ceanic::util::stream_post
         ,public std::enable_shared_from_this<yolov5>
     {
         public:
-            yolov5(int32_t chn,int32_t stream,std::shared_ptr<vi> vi_ptr,const char* model_path);
+            //burn_in:draw the boxes into the frame and encode it as the ai stream
+            //metadata:post the detections of every frame as STREAM_META_FRAME(onvif xml)
+            //track_interval:0 raw detections,N tracked boxes with inference on up to every Nth frame while the scene is static
+            //post:NULL the model ends in the npu roi/nms layers,otherwise its raw heads are decoded on the cpu
+            yolov5(int32_t chn,int32_t stream,std::shared_ptr<vi> vi_ptr,const char* model_path,bool burn_in = true,bool metadata = true,uint32_t track_interval = 0,
+                    const yolov5_post_t* post = NULL);
             ~yolov5();
 
             bool start();
@@ -50,6 +104,20 @@ namespace hisilicon{namespace dev{
             int venc_w();
             int venc_h();
 
+            bool burn_in();
+            bool metadata();
+
+            bool get_stat(yolov5_stat_t* stat);
+
+            //the roi of these vencs(start_roi done) follow the boxes of every frame
+            void add_roi_venc(venc_ptr v);
+            void clear_roi_venc();
+
+            //cpu motion analysis of the frames,gate:no inference while nothing moves
+            bool start_motion(const ceanic::motion::motion_param* param,bool gate);
+            void stop_motion();
+            bool get_motion_event(ceanic::motion::motion_event* event);
+
         private:
             bool create_vpss_grp_chn();
             void destroy_vpss_grp_chn();
@@ -57,28 +125,45 @@ namespace hisilicon{namespace dev{
             void destroy_venc_chn();
             void process_video_stream(ot_venc_stream* pstream);
 
-            bool create_svp_input();
-            svp_acl_data_buffer* create_svp_input_buffer(int index);
-            void destroy_svp_input();
-            void destroy_svp_input_buffer(int index);
+            bool create_svp_slots();
+            void destroy_svp_slots();
+
+            bool create_svp_input(svp_npu_task_info_t* task);
+            svp_acl_data_buffer* create_svp_input_buffer(svp_npu_task_info_t* task,int index);
+            void destroy_svp_input(svp_npu_task_info_t* task);
+            void destroy_svp_input_buffer(svp_npu_task_info_t* task,int index);
 
-            bool create_svp_output();
+            bool create_svp_output(svp_npu_task_info_t* task);
             svp_acl_data_buffer* create_svp_output_buffer(int index);
-            void destroy_svp_output();
-            void destroy_svp_output_buffer(int index);
+            void destroy_svp_output(svp_npu_task_info_t* task);
+            void destroy_svp_output_buffer(svp_npu_task_info_t* task,int index);
 
-            bool set_svp_threshold();
+            bool set_svp_threshold(svp_npu_task_info_t* task);
             bool create_vb_pool();
             void destroy_vb_pool();
 
-            bool get_svp_roi_num(td_u16* pnum);
-            bool get_svp_rio(svp_npu_rect_info_t* rect_info);
+            bool get_svp_roi_num(svp_npu_task_info_t* task,td_u16* pnum);
+            bool get_svp_rio(svp_npu_task_info_t* task,svp_npu_rect_info_t* rect_info);
             bool create_svp_rgn(int idx);
+            bool create_yolo_post();
+            bool decode_svp_output(svp_npu_task_info_t* task,svp_npu_rect_info_t* rect_info);
 
+            //capture and submit stage
             void on_process();
+            //waits for the npu,then rois,metadata,boxes and venc
+            void on_post_process();
             void on_venc_process();
+            void finish_capture();
+            void release_slot(int idx);
+            void update_stat(uint64_t now);
+            void track_rect(bool detect,svp_npu_rect_info_t* rect_info);
+            void update_roi(const svp_npu_rect_info_t* rect_info);
+            //true when the gate holds the frame back from the npu
+            bool process_motion(const ot_video_frame_info* frame,td_void* virt_addr);
+            static uint64_t now_us();
 
             void svp_vgs_fill_rect(const ot_video_frame_info *frame_info,svp_npu_rect_info_t* rect,td_u32 color);
+            void post_metadata(const svp_npu_rect_info_t* rect_info,td_u64 pts);
 
         private:
             bool m_is_start;
@@ -96,7 +181,33 @@ namespace hisilicon{namespace dev{
             ot_vpss_grp m_vpss_grp;
             ot_vpss_chn m_vpss_chn;
 
-            svp_npu_task_info_t m_task_info;
+            yolov5_slot_t m_slots[YOLOV5_PIPE_DEPTH];
+            std::mutex m_pipe_mu;
+            std::condition_variable m_pipe_cv;
+            std::deque<int> m_free_slots;
+            std::deque<int> m_busy_slots; //on the npu,in submit order
+            bool m_capture_done;
+            std::thread m_post_thread;
+
+            typedef struct
+            {
+                uint64_t frames;
+                uint64_t detects;
+                uint64_t capture_cnt;
+                uint64_t capture_us;
+                uint64_t infer_us;
+                uint64_t post_us;
+                uint64_t decode_us;
+                uint64_t motion_cnt;
+                uint64_t motion_us;
+                uint64_t latency_us;
+                uint32_t stall_cnt;
+            }stat_acc_t;
+            std::mutex m_stat_mu;
+            stat_acc_t m_stat_acc;
+            yolov5_stat_t m_stat;
+            uint64_t m_stat_beg_us;
+            uint64_t m_last_done_us;
             ot_vb_pool m_vb_poolid;
             ot_vb_pool_info m_vb_pool_info;
 
@@ -107,6 +218,31 @@ namespace hisilicon{namespace dev{
             std::thread m_venc_thread;
             ot_rgn_handle m_rgn[SVP_RECT_NUM];
             int m_max_rgn_w;
+
+            bool m_burn_in;
+            bool m_metadata;
+            std::string m_metadata_xml;
+
+            std::shared_ptr<ceanic::tracker::mot_tracker> m_tracker; //null:raw detections
+            std::vector<ceanic::tracker::detection> m_dets;
+            //set by the post stage after each tracker update,read by the capture stage
+            std::atomic<uint32_t> m_detect_interval;
+            uint32_t m_since_detect;
+
+            std::mutex m_roi_mu;
+            std::vector<venc_ptr> m_roi_vencs;
+            std::vector<ceanic::roi::roi_box> m_roi_boxes;
+
+            bool m_cpu_post;
+            yolov5_post_t m_post_cfg;
+            std::shared_ptr<ceanic::yolo::yolo_post> m_post;
+            std::vector<ceanic::yolo::yolo_tensor> m_tensors;  //data set per frame
+            std::vector<ceanic::yolo::yolo_box> m_boxes;
+            uint32_t m_dump_left;
+
+            std::mutex m_motion_mu;
+            std::shared_ptr<ceanic::motion::motion_detect> m_motion; //null:no motion analysis
+            bool m_motion_gate;
     };
 
 }}//namespace
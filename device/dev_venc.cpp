@@ -1,15 +1,26 @@
 #include "dev_sys.h"
 #include "dev_venc.h"
 #include "dev_log.h"
+#include <errno.h>
+#include <sys/eventfd.h>
 
 namespace hisilicon{namespace dev{
 
     bool venc::g_is_capturing = false;
     std::thread venc::g_capture_thread;
+    int venc::g_wake_fd = -1;
+    std::mutex venc::g_vencs_mu;
     std::list<venc_ptr> venc::g_vencs;
 
+    static uint64_t now_ms()
+    {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC,&ts);
+        return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+    }
+
     venc::venc(int32_t chn,int32_t stream,int w,int h,int src_fr,int venc_fr,ot_vpss_grp vpss_grp,ot_vpss_chn vpss_chn)
-        :stream_obj("venc_stream",chn,stream),m_venc_w(w),m_venc_h(h),m_src_fr(src_fr),m_venc_fr(venc_fr),m_vpss_grp(vpss_grp),m_vpss_chn(vpss_chn)
+        :stream_obj("venc_stream",chn,stream),m_venc_w(w),m_venc_h(h),m_src_fr(src_fr),m_venc_fr(venc_fr),m_vpss_grp(vpss_grp),m_vpss_chn(vpss_chn),m_slice_lines(0),m_roi_on(false),m_roi_src_w(0),m_roi_src_h(0)
     {
         m_venc_chn = sys::alloc_venc_chn();
     }
@@ -64,13 +75,145 @@ namespace hisilicon{namespace dev{
         return m_venc_fr;
     }
 
+    void venc::set_slice_lines(uint32_t lines)
+    {
+        m_slice_lines = lines;
+    }
+
+    uint32_t venc::slice_lines()
+    {
+        return m_slice_lines;
+    }
+
+    bool venc::start_roi(const ceanic::roi::roi_qp_param* param,uint32_t src_w,uint32_t src_h,uint32_t ab_period_ms)
+    {
+        std::unique_lock<std::mutex> lock(m_roi_mu);
+        if(param->max_num > OT_VENC_MAX_ROI_NUM)
+        {
+            DEV_WRITE_LOG_ERROR("venc[%d] supports %d roi regions,%d requested",m_venc_chn,OT_VENC_MAX_ROI_NUM,param->max_num);
+            return false;
+        }
+
+        m_roi_map = std::make_shared<ceanic::roi::roi_qp_map>(src_w,src_h,m_venc_w,m_venc_h,param);
+        m_roi_param = *param;
+        m_roi_src_w = src_w;
+        m_roi_src_h = src_h;
+        m_roi_ab = ab_period_ms > 0 ? std::make_shared<ceanic::roi::roi_ab_report>(ab_period_ms) : nullptr;
+        m_roi_on = false;
+        return true;
+    }
+
+    void venc::stop_roi()
+    {
+        std::unique_lock<std::mutex> lock(m_roi_mu);
+        if(!m_roi_map)
+        {
+            return;
+        }
+
+        apply_roi(false);
+        m_roi_map = nullptr;
+        m_roi_ab = nullptr;
+    }
+
+    void venc::update_roi(const std::vector<ceanic::roi::roi_box>& boxes)
+    {
+        std::unique_lock<std::mutex> lock(m_roi_mu);
+        if(!m_roi_map)
+        {
+            return;
+        }
+
+        //the map follows the objects in the off half too,so the on half starts right
+        bool changed = m_roi_map->update(boxes);
+        bool on = m_roi_ab ? m_roi_ab->roi_on(now_ms()) : true;
+        if(on != m_roi_on || (on && changed))
+        {
+            apply_roi(on);
+        }
+    }
+
+    bool venc::apply_roi(bool on)
+    {
+        //m_roi_mu held
+        const std::vector<ceanic::roi::roi_region>& regions = m_roi_map->regions();
+        bool ok = true;
+        for(size_t i = 0; i < regions.size(); i++)
+        {
+            const ceanic::roi::roi_region& r = regions[i];
+            ot_venc_roi_attr attr;
+            memset(&attr,0,sizeof(attr));
+            attr.idx = r.index;
+            attr.enable = (on && r.enable) ? TD_TRUE : TD_FALSE;
+            attr.is_abs_qp = TD_FALSE;
+            attr.qp = r.qp;
+            attr.rect.x = r.x;
+            attr.rect.y = r.y;
+            attr.rect.width = r.w;
+            attr.rect.height = r.h;
+
+            td_s32 ret = ss_mpi_venc_set_roi_attr(m_venc_chn,&attr);
+            if(ret != TD_SUCCESS)
+            {
+                DEV_WRITE_LOG_ERROR("ss_mpi_venc_set_roi_attr[%d] idx %d faild with %#x!",m_venc_chn,r.index,ret);
+                ok = false;
+            }
+        }
+        m_roi_on = on;
+        return ok;
+    }
+
+    void venc::post_video_frame(venc_frame_ptr frame)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_roi_mu);
+            ceanic::roi::roi_ab_result result;
+            if(m_roi_ab)
+            {
+                m_roi_ab->add_bytes(frame->head()->len,now_ms());
+                if(m_roi_ab->get_result(&result))
+                {
+                    DEV_WRITE_LOG_INFO("venc[%d] roi a/b:on %dkbps,off %dkbps,saving %d%%",m_venc_chn,result.on_kbps,result.off_kbps,result.saving);
+                }
+            }
+        }
+
+        if(m_slice_lines == 0)
+        {
+            post_frame_to_observer(shared_from_this(),frame);
+            return;
+        }
+
+        ot_venc_stream* pstream = frame->stream();
+        bool frame_end = pstream->pack_cnt > 0 && pstream->pack[pstream->pack_cnt - 1].is_frame_end;
+        ceanic::util::stream_head* sh = frame->head();
+        if(!frame_end)
+        {
+            sh->flags |= STREAM_FLAG_MORE_SLICES;
+        }
+        post_slice_to_observer(shared_from_this(),sh);
+
+        //recorders and rtmp still take whole frames
+        if(!m_au_frame)
+        {
+            m_au_frame = std::make_shared<venc_au_frame>();
+        }
+        m_au_frame->add(frame);
+        if(frame_end)
+        {
+            venc_au_frame_ptr au_frame = m_au_frame;
+            m_au_frame = nullptr;
+            au_frame->head()->flags |= STREAM_FLAG_SLICE_SENT;
+            post_frame_to_observer(shared_from_this(),au_frame);
+        }
+    }
+
     void venc::on_capturing()
     {
         fd_set read_fds;
         td_s32 maxfd = 0;
         struct timeval time_val;
         td_s32 ret;
-        ot_venc_stream stream;
         ot_venc_chn_status stat;
         ot_venc_chn venc_chn;
         int venc_fd;
@@ -78,21 +221,31 @@ namespace hisilicon{namespace dev{
         while(g_is_capturing)
         {
             FD_ZERO(&read_fds);
+            FD_SET(g_wake_fd, &read_fds);
+            maxfd = g_wake_fd;
 
-            for(auto it = g_vencs.begin(); it != g_vencs.end(); it++)
             {
-                venc_fd = (*it)->venc_fd();
-                FD_SET(venc_fd, &read_fds);
-                if(venc_fd > maxfd)
+                std::unique_lock<std::mutex> lock(g_vencs_mu);
+                for(auto it = g_vencs.begin(); it != g_vencs.end(); it++)
                 {
-                    maxfd = venc_fd;
+                    venc_fd = (*it)->venc_fd();
+                    FD_SET(venc_fd, &read_fds);
+                    if(venc_fd > maxfd)
+                    {
+                        maxfd = venc_fd;
+                    }
                 }
             }
 
             time_val.tv_sec  = 2;
             time_val.tv_usec = 0;
             ret = select(maxfd + 1, &read_fds, NULL, NULL, &time_val);
-            if (ret < 0)
+            if (ret < 0 && (errno == EBADF || errno == EINTR))
+            {
+                //a channel rebuilt by set_size closed its fd meanwhile
+                continue;
+            }
+            else if (ret < 0)
             {
                 DEV_WRITE_LOG_ERROR("select faild with %#x!", ret);
                 break;
@@ -103,8 +256,26 @@ namespace hisilicon{namespace dev{
                 continue;
             }
 
-            for(auto it = g_vencs.begin(); it != g_vencs.end(); it++)
+            if(FD_ISSET(g_wake_fd,&read_fds))
             {
+                uint64_t val;
+                if(read(g_wake_fd,&val,sizeof(val)) < 0)
+                {
+                    //nonblocking,another wake may have taken it
+                }
+                continue;
+            }
+
+            std::list<venc_ptr> vencs;
+            {
+                std::unique_lock<std::mutex> lock(g_vencs_mu);
+                vencs = g_vencs;
+            }
+
+            //the observers run without g_vencs_mu,a slow one holds up only its own channel
+            for(auto it = vencs.begin(); it != vencs.end(); it++)
+            {
+                std::unique_lock<std::mutex> lock((*it)->m_capture_mu);
                 venc_fd = (*it)->venc_fd();
                 if(!FD_ISSET(venc_fd,&read_fds))
                 {
@@ -112,7 +283,6 @@ namespace hisilicon{namespace dev{
                 }
 
                 venc_chn = (*it)->venc_chn();
-                memset(&stream, 0, sizeof(stream));
                 ret = ss_mpi_venc_query_status(venc_chn, &stat);
                 if (ret != TD_SUCCESS)
                 {
@@ -125,27 +295,14 @@ namespace hisilicon{namespace dev{
                     continue;
                 }
 
-                stream.pack = (ot_venc_pack*)malloc(sizeof(ot_venc_pack) * stat.cur_packs);
-                if (stream.pack == NULL)
+                //the frame holds the stream until every observer has dropped it
+                venc_frame_ptr frame = (*it)->m_frame_pool->get(stat);
+                if (!frame)
                 {
-                    DEV_WRITE_LOG_ERROR("malloc memory failed!");
                     break;
                 }
-                stream.pack_cnt = stat.cur_packs;
-                ret = ss_mpi_venc_get_stream(venc_chn, &stream, TD_TRUE);
-                if (ret != TD_SUCCESS)
-                {
-                    free(stream.pack);
-                    stream.pack = NULL;
-                    DEV_WRITE_LOG_ERROR("ss_mpi_venc_get_stream failed with %#x", ret);
-                    break;
-                }
-
-                (*it)->process_video_stream(&stream);
 
-                ss_mpi_venc_release_stream(venc_chn, &stream);
-                free(stream.pack);
-                stream.pack = NULL;
+                (*it)->process_video_stream(frame);
             }
         }
         DEV_WRITE_LOG_INFO("venc thread exit");
@@ -158,11 +315,27 @@ namespace hisilicon{namespace dev{
             return false;
         }
 
+        g_wake_fd = eventfd(0,EFD_NONBLOCK | EFD_CLOEXEC);
+        if(g_wake_fd < 0)
+        {
+            DEV_WRITE_LOG_ERROR("eventfd failed,errno %d",errno);
+            return false;
+        }
+
         g_is_capturing = true;
         g_capture_thread = std::thread(&on_capturing);
         return true;
     }
 
+    void venc::wake_capture()
+    {
+        uint64_t val = 1;
+        if(g_wake_fd >= 0 && write(g_wake_fd,&val,sizeof(val)) < 0)
+        {
+            DEV_WRITE_LOG_ERROR("wake capture failed,errno %d",errno);
+        }
+    }
+
     void venc::stop_capture()
     {
         if(!g_is_capturing)
@@ -171,19 +344,45 @@ namespace hisilicon{namespace dev{
         }
 
         g_is_capturing = false;
+        wake_capture();
         g_capture_thread.join();
+        close(g_wake_fd);
+        g_wake_fd = -1;
     }
 
     bool venc::start(ot_vpss_grp vpss_grp, ot_vpss_chn vpss_chn)
     {
         td_s32 ret;
+        if(m_slice_lines > 0)
+        {
+            //get_stream returns each slice as soon as it is encoded
+            m_venc_chn_attr.venc_attr.is_by_frame = TD_FALSE;
+        }
+
         ret = ss_mpi_venc_create_chn(m_venc_chn,&m_venc_chn_attr);
         if(ret != TD_SUCCESS)
         {
             DEV_WRITE_LOG_ERROR("ss_mpi_venc_create_chn[%d] faild with %#x!",m_venc_chn, ret);
             return false;
         }
+
+        if(m_slice_lines > 0)
+        {
+            ot_venc_slice_split slice_split;
+            slice_split.enable = TD_TRUE;
+            slice_split.split_mode = 1; //by macroblock(ctu) rows
+            slice_split.split_size = m_slice_lines;
+            ret = ss_mpi_venc_set_slice_split(m_venc_chn,&slice_split);
+            if(ret != TD_SUCCESS)
+            {
+                DEV_WRITE_LOG_ERROR("ss_mpi_venc_set_slice_split[%d] faild with %#x!",m_venc_chn, ret);
+                ss_mpi_venc_destroy_chn(m_venc_chn);
+                return false;
+            }
+        }
+
         m_venc_fd = ss_mpi_venc_get_fd(m_venc_chn);
+        m_frame_pool = std::make_shared<venc_frame_pool>(m_venc_chn,m_venc_chn_attr.venc_attr.buf_size,frame_max_ref());
 
         DEV_WRITE_LOG_INFO("venc::start input grp[%d] chn[%d] VS m grp[%d] chn[%d]",
             vpss_grp, vpss_chn, m_vpss_grp, m_vpss_chn);
@@ -220,12 +419,37 @@ namespace hisilicon{namespace dev{
             return false;
         }
 
-        g_vencs.push_back(shared_from_this());
+        {
+            std::unique_lock<std::mutex> lock(g_vencs_mu);
+            g_vencs.push_back(shared_from_this());
+        }
+        wake_capture();
         return true;
     }
 
     void venc::stop()
     {
+        {
+            std::unique_lock<std::mutex> lock(g_vencs_mu);
+            for (auto it = g_vencs.begin();it != g_vencs.end(); it++)
+            {
+                if((*it)->venc_chn() == m_venc_chn)
+                {
+                    g_vencs.erase(it);
+                    break;
+                }
+            }
+        }
+        //waits for a frame being posted,a copy of the list taken before may still hold the channel
+        std::unique_lock<std::mutex> capture_lock(m_capture_mu);
+
+        {
+            //the regions go with the channel
+            std::unique_lock<std::mutex> lock(m_roi_mu);
+            m_roi_map = nullptr;
+            m_roi_ab = nullptr;
+        }
+
         ot_mpp_chn src_chn;
         ot_mpp_chn dest_chn;
         src_chn.mod_id = OT_ID_VPSS;
@@ -237,16 +461,294 @@ namespace hisilicon{namespace dev{
 
         ss_mpi_sys_unbind(&src_chn, &dest_chn);
         ss_mpi_venc_stop_chn(m_venc_chn);
+        //a frame cut short by stop is never posted
+        m_au_frame = nullptr;
+        if(m_frame_pool)
+        {
+            //observers may still queue frames that point into the stream buffer
+            m_frame_pool->drain(1000);
+        }
         ss_mpi_venc_destroy_chn(m_venc_chn);
+    }
 
-        for (auto it = g_vencs.begin();it != g_vencs.end(); it++)
+    uint32_t venc::frame_max_ref()
+    {
+        uint32_t max_ref = VENC_FRAME_MAX_REF;
+        if(m_slice_lines > 0)
         {
-            if((*it)->venc_chn() == m_venc_chn)
-            {
-                g_vencs.erase(it);
+            //slices are held until the frame is complete,a macroblock row is 16 lines
+            max_ref *= (m_venc_h + m_slice_lines * 16 - 1) / (m_slice_lines * 16);
+        }
+        return max_ref;
+    }
+
+    int venc::venc_bitrate()
+    {
+        switch(m_venc_chn_attr.rc_attr.rc_mode)
+        {
+            case OT_VENC_RC_MODE_H264_CBR:
+                return m_venc_chn_attr.rc_attr.h264_cbr.bit_rate;
+            case OT_VENC_RC_MODE_H264_AVBR:
+                return m_venc_chn_attr.rc_attr.h264_avbr.max_bit_rate;
+            case OT_VENC_RC_MODE_H265_CBR:
+                return m_venc_chn_attr.rc_attr.h265_cbr.bit_rate;
+            case OT_VENC_RC_MODE_H265_AVBR:
+                return m_venc_chn_attr.rc_attr.h265_avbr.max_bit_rate;
+            default:
+                return 0;
+        }
+    }
+
+    int venc::venc_gop()
+    {
+        switch(m_venc_chn_attr.rc_attr.rc_mode)
+        {
+            case OT_VENC_RC_MODE_H264_CBR:
+                return m_venc_chn_attr.rc_attr.h264_cbr.gop;
+            case OT_VENC_RC_MODE_H264_AVBR:
+                return m_venc_chn_attr.rc_attr.h264_avbr.gop;
+            case OT_VENC_RC_MODE_H265_CBR:
+                return m_venc_chn_attr.rc_attr.h265_cbr.gop;
+            case OT_VENC_RC_MODE_H265_AVBR:
+                return m_venc_chn_attr.rc_attr.h265_avbr.gop;
+            default:
+                //every mjpeg frame is a key frame
+                return 1;
+        }
+    }
+
+    bool venc::set_rc(int venc_fr,int bitrate,int gop)
+    {
+        if(venc_fr <= 0 || venc_fr > m_src_fr || bitrate < 0 || gop < 0)
+        {
+            DEV_WRITE_LOG_ERROR("venc[%d] invalid rc,fr %d(src %d),bitrate %d,gop %d",m_venc_chn,venc_fr,m_src_fr,bitrate,gop);
+            return false;
+        }
+
+        if(gop == 0)
+        {
+            gop = venc_fr;
+        }
+
+        ot_venc_chn_attr attr = m_venc_chn_attr;
+        switch(attr.rc_attr.rc_mode)
+        {
+            case OT_VENC_RC_MODE_H264_CBR:
+                attr.rc_attr.h264_cbr.gop = gop;
+                attr.rc_attr.h264_cbr.dst_frame_rate = venc_fr;
+                attr.rc_attr.h264_cbr.bit_rate = bitrate;
+                break;
+            case OT_VENC_RC_MODE_H264_AVBR:
+                attr.rc_attr.h264_avbr.gop = gop;
+                attr.rc_attr.h264_avbr.dst_frame_rate = venc_fr;
+                attr.rc_attr.h264_avbr.max_bit_rate = bitrate;
+                break;
+            case OT_VENC_RC_MODE_H265_CBR:
+                attr.rc_attr.h265_cbr.gop = gop;
+                attr.rc_attr.h265_cbr.dst_frame_rate = venc_fr;
+                attr.rc_attr.h265_cbr.bit_rate = bitrate;
+                break;
+            case OT_VENC_RC_MODE_H265_AVBR:
+                attr.rc_attr.h265_avbr.gop = gop;
+                attr.rc_attr.h265_avbr.dst_frame_rate = venc_fr;
+                attr.rc_attr.h265_avbr.max_bit_rate = bitrate;
                 break;
+            case OT_VENC_RC_MODE_MJPEG_FIXQP:
+                //the quality is fixed,only the frame rate changes
+                attr.rc_attr.mjpeg_fixqp.dst_frame_rate = venc_fr;
+                break;
+            default:
+                DEV_WRITE_LOG_ERROR("venc[%d] rc mode %d can not be changed",m_venc_chn,attr.rc_attr.rc_mode);
+                return false;
+        }
+
+        td_s32 ret = ss_mpi_venc_set_chn_attr(m_venc_chn,&attr);
+        if(ret != TD_SUCCESS)
+        {
+            DEV_WRITE_LOG_ERROR("ss_mpi_venc_set_chn_attr[%d] faild with %#x!",m_venc_chn,ret);
+            return false;
+        }
+
+        m_venc_chn_attr = attr;
+        m_venc_fr = venc_fr;
+        DEV_WRITE_LOG_INFO("venc[%d] rc changed,fr %d,bitrate %d,gop %d",m_venc_chn,venc_fr,bitrate,gop);
+        return true;
+    }
+
+    bool venc::rebuild_chn(const ot_venc_chn_attr* attr)
+    {
+        ot_mpp_chn src_chn;
+        ot_mpp_chn dest_chn;
+        src_chn.mod_id = OT_ID_VPSS;
+        src_chn.dev_id = m_vpss_grp;
+        src_chn.chn_id = m_vpss_chn;
+        dest_chn.mod_id = OT_ID_VENC;
+        dest_chn.dev_id = 0;
+        dest_chn.chn_id = m_venc_chn;
+
+        ss_mpi_sys_unbind(&src_chn, &dest_chn);
+        ss_mpi_venc_destroy_chn(m_venc_chn);
+
+        td_s32 ret = ss_mpi_venc_create_chn(m_venc_chn,attr);
+        if(ret != TD_SUCCESS)
+        {
+            DEV_WRITE_LOG_ERROR("ss_mpi_venc_create_chn[%d] faild with %#x!",m_venc_chn, ret);
+            return false;
+        }
+
+        if(m_slice_lines > 0)
+        {
+            ot_venc_slice_split slice_split;
+            slice_split.enable = TD_TRUE;
+            slice_split.split_mode = 1; //by macroblock(ctu) rows
+            slice_split.split_size = m_slice_lines;
+            ret = ss_mpi_venc_set_slice_split(m_venc_chn,&slice_split);
+            if(ret != TD_SUCCESS)
+            {
+                DEV_WRITE_LOG_ERROR("ss_mpi_venc_set_slice_split[%d] faild with %#x!",m_venc_chn, ret);
+                return false;
             }
         }
+
+        ret = ss_mpi_sys_bind(&src_chn, &dest_chn);
+        if(ret != TD_SUCCESS)
+        {
+            DEV_WRITE_LOG_ERROR("ss_mpi_sys_bind failed with %#x",ret);
+            return false;
+        }
+
+        return true;
+    }
+
+    bool venc::set_size(int w,int h)
+    {
+        if(w == m_venc_w && h == m_venc_h)
+        {
+            return true;
+        }
+        if(w <= 0 || h <= 0)
+        {
+            return false;
+        }
+
+        uint64_t begin = now_ms();
+        {
+            //off the capture list,the fd and the frame pool change below
+            std::unique_lock<std::mutex> lock(g_vencs_mu);
+            for (auto it = g_vencs.begin();it != g_vencs.end(); it++)
+            {
+                if((*it)->venc_chn() == m_venc_chn)
+                {
+                    g_vencs.erase(it);
+                    break;
+                }
+            }
+        }
+        std::unique_lock<std::mutex> capture_lock(m_capture_mu);
+
+        ot_venc_start_param venc_start_param;
+        venc_start_param.recv_pic_num = -1;
+
+        ss_mpi_venc_stop_chn(m_venc_chn);
+        m_au_frame = nullptr;
+        if(m_frame_pool && !m_frame_pool->drain(1000))
+        {
+            //the held frames point into the stream buffer,it must not be reset or rebuilt.
+            //the channel goes on unchanged with the same pool
+            DEV_WRITE_LOG_ERROR("venc[%d] frames still held,the size stays %dx%d",m_venc_chn,m_venc_w,m_venc_h);
+            td_s32 ret = ss_mpi_venc_start_chn(m_venc_chn,&venc_start_param);
+            if(ret != TD_SUCCESS)
+            {
+                DEV_WRITE_LOG_ERROR("ss_mpi_venc_start_chn[%d] faild with %#x!",m_venc_chn,ret);
+                return false;
+            }
+
+            {
+                std::unique_lock<std::mutex> lock(g_vencs_mu);
+                g_vencs.push_back(shared_from_this());
+            }
+            wake_capture();
+            return false;
+        }
+
+        ot_venc_chn_attr attr = m_venc_chn_attr;
+        attr.venc_attr.pic_width = w;
+        attr.venc_attr.pic_height = h;
+        bool rebuild = (uint32_t)w > attr.venc_attr.max_pic_width || (uint32_t)h > attr.venc_attr.max_pic_height;
+
+        {
+            //the old regions may lie outside the new picture
+            std::unique_lock<std::mutex> lock(m_roi_mu);
+            if(m_roi_map && !rebuild)
+            {
+                apply_roi(false);
+            }
+        }
+
+        bool ok;
+        if(rebuild)
+        {
+            attr.venc_attr.max_pic_width = w;
+            attr.venc_attr.max_pic_height = h;
+            attr.venc_attr.buf_size = w * h * 3 / 2;
+            ok = rebuild_chn(&attr);
+        }
+        else
+        {
+            td_s32 ret = ss_mpi_venc_reset_chn(m_venc_chn);
+            if(ret == TD_SUCCESS)
+            {
+                ret = ss_mpi_venc_set_chn_attr(m_venc_chn,&attr);
+            }
+            if(ret != TD_SUCCESS)
+            {
+                DEV_WRITE_LOG_ERROR("venc[%d] resize faild with %#x!",m_venc_chn,ret);
+            }
+            ok = (ret == TD_SUCCESS);
+        }
+
+        if(ok)
+        {
+            m_venc_chn_attr = attr;
+            m_venc_w = w;
+            m_venc_h = h;
+        }
+        else if(rebuild)
+        {
+            //back to the old channel,so the stream goes on at the old size
+            rebuild_chn(&m_venc_chn_attr);
+        }
+
+        m_venc_fd = ss_mpi_venc_get_fd(m_venc_chn);
+        m_frame_pool = std::make_shared<venc_frame_pool>(m_venc_chn,m_venc_chn_attr.venc_attr.buf_size,frame_max_ref());
+
+        {
+            std::unique_lock<std::mutex> lock(m_roi_mu);
+            if(m_roi_map)
+            {
+                m_roi_map = std::make_shared<ceanic::roi::roi_qp_map>(m_roi_src_w,m_roi_src_h,m_venc_w,m_venc_h,&m_roi_param);
+                m_roi_on = false;
+            }
+        }
+
+        td_s32 ret = ss_mpi_venc_start_chn(m_venc_chn,&venc_start_param);
+        if(ret != TD_SUCCESS)
+        {
+            DEV_WRITE_LOG_ERROR("ss_mpi_venc_start_chn[%d] faild with %#x!",m_venc_chn,ret);
+            return false;
+        }
+        //the first frame at the new size carries the parameter sets for every consumer
+        request_i_frame();
+
+        {
+            std::unique_lock<std::mutex> lock(g_vencs_mu);
+            g_vencs.push_back(shared_from_this());
+        }
+        wake_capture();
+
+        DEV_WRITE_LOG_INFO("venc[%d] size %dx%d %s%s,%llums",m_venc_chn,m_venc_w,m_venc_h,
+            ok ? "ok" : "failed",rebuild ? ",channel rebuilt" : "",(unsigned long long)(now_ms() - begin));
+        return ok;
     }
 
     venc_h264::venc_h264(int32_t chn,int32_t stream,int w,int h,int src_fr,int venc_fr,ot_vpss_grp vpss_grp,ot_vpss_chn vpss_chn)
@@ -271,17 +773,17 @@ namespace hisilicon{namespace dev{
     {
     }
 
-    void venc_h264::process_video_stream(ot_venc_stream* pstream)
+    void venc_h264::process_video_stream(venc_frame_ptr frame)
     {
+        ot_venc_stream* pstream = frame->stream();
         char* es_buf = NULL;
         int es_len = 0;
         int es_type = 0;
-        int nalu_cnt = 0;
         unsigned long long time_stamp = 0;
 
-        ceanic::util::stream_head sh;
+        ceanic::util::stream_head& sh = *frame->head();
 
-        memset(&sh,0,sizeof(sh));
+        sh.reset();
         sh.type = STREAM_NALU_SLICE;    
 
         for(unsigned int i = 0; i < pstream->pack_cnt; i++)
@@ -299,17 +801,12 @@ namespace hisilicon{namespace dev{
                     || es_type == 0x1 /*p*/
                     || es_type == 0x5 /*i*/)
             {
-                sh.nalu[nalu_cnt].data = (uint8_t*)es_buf;
-                sh.nalu[nalu_cnt].size = es_len; 
-                sh.nalu[nalu_cnt].time_stamp = time_stamp;
-
-                nalu_cnt++;
+                sh.nalu.push_back((uint8_t*)es_buf,es_len,time_stamp);
             }
-            sh.nalu_count = nalu_cnt;
             //g_stream_fun(chn,stream,es_type,time_stamp,es_buf,es_len,g_stream_fun_usr);
         }
 
-        post_stream_to_observer(shared_from_this(),&sh,NULL,0);
+        post_video_frame(frame);
     }
 
     venc_h264_cbr::venc_h264_cbr(int32_t chn,int32_t stream,int w,int h,int src_fr,int venc_fr,ot_vpss_grp vpss_grp,ot_vpss_chn vpss_chn,int bitrate)
@@ -364,17 +861,17 @@ namespace hisilicon{namespace dev{
     {
     }
 
-    void venc_h265::process_video_stream(ot_venc_stream* pstream)
+    void venc_h265::process_video_stream(venc_frame_ptr frame)
     {
+        ot_venc_stream* pstream = frame->stream();
         char* es_buf = NULL;
         int es_len = 0;
         unsigned long long time_stamp = 0;
 
-        ceanic::util::stream_head sh;
+        ceanic::util::stream_head& sh = *frame->head();
 
-        memset(&sh,0,sizeof(sh));
+        sh.reset();
         sh.type = STREAM_NALU_SLICE;    
-        sh.nalu_count = pstream->pack_cnt;         
 
         for(unsigned int i = 0; i < pstream->pack_cnt; i++)
         {
@@ -384,13 +881,11 @@ namespace hisilicon{namespace dev{
 
             //printf("packet%d,len=%d,%02x,%02x,%02x,%02x,%02x\n",i,es_len,es_buf[0],es_buf[1],es_buf[2],es_buf[3],es_buf[4]);
 
-            sh.nalu[i].data = (uint8_t*)es_buf;
-            sh.nalu[i].size = es_len; 
-            sh.nalu[i].time_stamp = time_stamp;
+            sh.nalu.push_back((uint8_t*)es_buf,es_len,time_stamp);
             //g_stream_fun(chn,stream,es_type,time_stamp,es_buf,es_len,g_stream_fun_usr);
         }
 
-        post_stream_to_observer(shared_from_this(),&sh,NULL,0);
+        post_video_frame(frame);
     }
 
     venc_h265_cbr::venc_h265_cbr(int32_t chn,int32_t stream,int w,int h,int src_fr,int venc_fr,ot_vpss_grp vpss_grp,ot_vpss_chn vpss_chn,int bitrate)
@@ -423,6 +918,47 @@ namespace hisilicon{namespace dev{
     {
     }
 
+    venc_mjpeg::venc_mjpeg(int32_t chn,int32_t stream,int w,int h,int src_fr,int venc_fr,ot_vpss_grp vpss_grp,ot_vpss_chn vpss_chn,int quality)
+        :venc(chn,stream,w,h,src_fr,venc_fr,vpss_grp,vpss_chn),m_quality(quality)
+    {
+        memset(&m_venc_chn_attr,0,sizeof(m_venc_chn_attr));
+        m_venc_chn_attr.venc_attr.type = OT_PT_MJPEG;
+        m_venc_chn_attr.venc_attr.max_pic_width = m_venc_w;
+        m_venc_chn_attr.venc_attr.max_pic_height = m_venc_h;
+        m_venc_chn_attr.venc_attr.pic_width = m_venc_w;/*the picture width*/
+        m_venc_chn_attr.venc_attr.pic_height    = m_venc_h;/*the picture height*/
+        m_venc_chn_attr.venc_attr.buf_size      = m_venc_w * m_venc_h  *3 / 2;/*stream buffer size*/
+        m_venc_chn_attr.venc_attr.is_by_frame      = TD_TRUE;/*get stream mode is slice mode or frame mode?*/
+        m_venc_chn_attr.venc_attr.profile = 0;
+        m_venc_chn_attr.rc_attr.rc_mode = OT_VENC_RC_MODE_MJPEG_FIXQP;
+        m_venc_chn_attr.rc_attr.mjpeg_fixqp.src_frame_rate = m_src_fr; /* input (vi) frame rate */
+        m_venc_chn_attr.rc_attr.mjpeg_fixqp.dst_frame_rate = m_venc_fr; /* target frame rate */
+        m_venc_chn_attr.rc_attr.mjpeg_fixqp.qfactor = m_quality;
+    }
+
+    venc_mjpeg::~venc_mjpeg()
+    {
+    }
+
+    void venc_mjpeg::process_video_stream(venc_frame_ptr frame)
+    {
+        ot_venc_stream* pstream = frame->stream();
+        ceanic::util::stream_head& sh = *frame->head();
+
+        sh.reset();
+        sh.type = STREAM_MJPEG_FRAME;
+
+        //the packs of one picture make up the jpeg from soi to eoi
+        for(unsigned int i = 0; i < pstream->pack_cnt; i++)
+        {
+            char* es_buf = (char*)(pstream->pack[i].addr + pstream->pack[i].offset);
+            int es_len = pstream->pack[i].len - pstream->pack[i].offset;
+            sh.nalu.push_back((uint8_t*)es_buf,es_len,pstream->pack[i].pts / 1000);
+        }
+
+        post_video_frame(frame);
+    }
+
 }}//namespace
 
 
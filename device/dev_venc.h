@@ -2,7 +2,10 @@
 #define dev_venc_include_h
 
 #include "dev_std.h"
+#include "dev_venc_frame.h"
 #include <stream_observer.h>
+#include <roi/roi_qp_map.h>
+#include <mutex>
 
 namespace hisilicon{namespace dev{
 
@@ -26,8 +29,30 @@ namespace hisilicon{namespace dev{
             int venc_w();
             int venc_h();
             int venc_fr();
-            virtual void process_video_stream(ot_venc_stream* pstream) = 0;
+            int venc_bitrate();
+            int venc_gop();
+            virtual void process_video_stream(venc_frame_ptr frame) = 0;
             bool request_i_frame();
+
+            //low latency mode,call before start.the frame is split into slices of lines
+            //macroblock(ctu) rows and each slice is posted by on_slice_come as soon as venc
+            //emits it,whole frames follow as usual.0 gets whole frames only
+            void set_slice_lines(uint32_t lines);
+            uint32_t slice_lines();
+
+            //detection driven roi qp,call after start.boxes come in src_w x src_h(the analysis picture).
+            //ab_period_ms>0 switches the roi on and off every period and logs the bitrate of both halves
+            bool start_roi(const ceanic::roi::roi_qp_param* param,uint32_t src_w,uint32_t src_h,uint32_t ab_period_ms = 0);
+            void stop_roi();
+            void update_roi(const std::vector<ceanic::roi::roi_box>& boxes);
+
+            //live changes on a started channel,the observers stay registered.
+            //frame rate,bitrate(max bitrate for avbr) and gop go to the running channel,gop 0 is one per second
+            bool set_rc(int venc_fr,int bitrate,int gop);
+            //the channel stops,drops what was not got yet and starts with an idr carrying the new sps/pps.
+            //above the size it was created for it is destroyed and created again on the same vpss chn,
+            //overlay regions attached to the channel(osd) have to be attached again then
+            bool set_size(int w,int h);
             
             static bool start_capture();
             static void stop_capture();
@@ -37,6 +62,12 @@ namespace hisilicon{namespace dev{
 
         protected:
             static void on_capturing();
+            //select picks up a changed list at once
+            static void wake_capture();
+            void post_video_frame(venc_frame_ptr frame);
+            bool apply_roi(bool on);
+            uint32_t frame_max_ref();
+            bool rebuild_chn(const ot_venc_chn_attr* attr);
 
         protected:
             int m_venc_w;
@@ -48,9 +79,27 @@ namespace hisilicon{namespace dev{
             ot_vpss_grp m_vpss_grp;
             ot_vpss_chn m_vpss_chn;
             int m_venc_fd;
+            venc_frame_pool_ptr m_frame_pool;
+            uint32_t m_slice_lines;
+            venc_au_frame_ptr m_au_frame;
+            //held by the capture thread while it posts a frame of this channel,
+            //stop/set_size hold it while they change the fd,the pool and m_au_frame
+            std::mutex m_capture_mu;
+
+            std::mutex m_roi_mu;
+            std::shared_ptr<ceanic::roi::roi_qp_map> m_roi_map;
+            std::shared_ptr<ceanic::roi::roi_ab_report> m_roi_ab;
+            bool m_roi_on;
+            //kept to map the boxes again after set_size
+            ceanic::roi::roi_qp_param m_roi_param;
+            uint32_t m_roi_src_w;
+            uint32_t m_roi_src_h;
             
             static bool g_is_capturing;
             static std::thread g_capture_thread;
+            static int g_wake_fd;
+            //guards the list,the capture thread copies it and posts the frames without it
+            static std::mutex g_vencs_mu;
             static std::list<venc_ptr> g_vencs;
     };
 
@@ -61,7 +110,7 @@ namespace hisilicon{namespace dev{
             venc_h264(int32_t chn,int32_t stream,int w,int h,int src_fr,int venc_fr,ot_vpss_grp vpss_grp,ot_vpss_chn vpss_chn);
             virtual ~venc_h264();
 
-            virtual void process_video_stream(ot_venc_stream* pstream);
+            virtual void process_video_stream(venc_frame_ptr frame);
     };
 
     class venc_h264_cbr
@@ -93,7 +142,7 @@ namespace hisilicon{namespace dev{
             venc_h265(int32_t chn,int32_t stream,int w,int h,int src_fr,int venc_fr,ot_vpss_grp vpss_grp,ot_vpss_chn vpss_chn);
             virtual ~venc_h265();
 
-            virtual void process_video_stream(ot_venc_stream* pstream);
+            virtual void process_video_stream(venc_frame_ptr frame);
     };
 
     class venc_h265_cbr
@@ -118,6 +167,20 @@ namespace hisilicon{namespace dev{
             int m_max_bitrate;
     };
 
+    //every frame is a complete jpeg(fixed qfactor),for low rate mjpeg viewers
+    class venc_mjpeg
+        :public venc
+    {
+        public:
+            venc_mjpeg(int32_t chn,int32_t stream,int w,int h,int src_fr,int venc_fr,ot_vpss_grp vpss_grp,ot_vpss_chn vpss_chn,int quality);
+            virtual ~venc_mjpeg();
+
+            virtual void process_video_stream(venc_frame_ptr frame);
+
+        protected:
+            int m_quality;
+    };
+
 }}//namespace
 
 #endif
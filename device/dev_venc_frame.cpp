@@ -0,0 +1,275 @@
+#include "dev_venc_frame.h"
+#include "dev_log.h"
+#include <chrono>
+
+namespace hisilicon{namespace dev{
+
+#define VENC_FRAME_MAX_FREE_DATA 4
+
+    venc_frame::venc_frame(venc_frame_pool_ptr pool,int32_t slot,const ot_venc_stream* stream)
+        :m_pool(pool),m_slot(slot),m_stream(*stream)
+    {
+    }
+
+    venc_frame::venc_frame(venc_frame_pool_ptr pool,const ot_venc_stream* stream,std::vector<uint8_t>&& data)
+        :m_pool(pool),m_slot(-1),m_stream(*stream),m_packs(stream->pack,stream->pack + stream->pack_cnt),m_data(std::move(data))
+    {
+        //packs are laid out back to back in m_data,keep the offsets as they were
+        uint32_t pos = 0;
+        for(uint32_t i = 0; i < m_stream.pack_cnt; i++)
+        {
+            m_packs[i].addr = m_data.data() + pos;
+            pos += m_packs[i].len;
+        }
+        m_stream.pack = m_packs.data();
+    }
+
+    venc_frame::~venc_frame()
+    {
+        if(m_slot >= 0)
+        {
+            m_pool->on_slot_done(m_slot);
+        }
+        else
+        {
+            m_pool->free_data(std::move(m_data));
+        }
+    }
+
+    ot_venc_stream* venc_frame::stream()
+    {
+        return &m_stream;
+    }
+
+    bool venc_frame::is_ref()
+    {
+        return m_slot >= 0;
+    }
+
+    venc_au_frame::venc_au_frame()
+    {
+    }
+
+    venc_au_frame::~venc_au_frame()
+    {
+    }
+
+    void venc_au_frame::add(venc_frame_ptr slice)
+    {
+        ceanic::util::stream_head* sh = slice->head();
+        m_head.type = sh->type;
+        for(uint32_t i = 0; i < sh->nalu.size(); i++)
+        {
+            m_head.nalu.push_back(sh->nalu[i]);
+        }
+        m_slices.push_back(slice);
+    }
+
+    uint32_t venc_au_frame::slice_count()
+    {
+        return m_slices.size();
+    }
+
+    bool venc_au_frame::is_ref()
+    {
+        for(auto it = m_slices.begin(); it != m_slices.end(); it++)
+        {
+            if((*it)->is_ref())
+            {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    venc_frame_pool::venc_frame_pool(ot_venc_chn venc_chn,uint32_t buf_size,uint32_t max_ref,uint32_t copy_percent)
+        :m_venc_chn(venc_chn),m_buf_size(buf_size),m_max_ref(max_ref),m_copy_percent(copy_percent),
+        m_ref_cnt(0),m_held_bytes(0),m_ref_frames(0),m_copy_frames(0)
+    {
+        //one slot per ref frame plus the one being copied,pack arrays sized for a key frame
+        m_slots.resize(m_max_ref + 1);
+        for(uint32_t i = 0; i < m_slots.size(); i++)
+        {
+            m_slots[i].packs.resize(STREAM_NALU_INLINE_COUNT);
+            m_free_slots.push_back(i);
+        }
+    }
+
+    venc_frame_pool::~venc_frame_pool()
+    {
+    }
+
+    int32_t venc_frame_pool::alloc_slot(uint32_t pack_cnt)
+    {
+        int32_t slot;
+        if(m_free_slots.empty())
+        {
+            //every slot waits behind an older frame,grow instead of blocking the capture thread
+            slot = m_slots.size();
+            m_slots.resize(m_slots.size() + 1);
+        }
+        else
+        {
+            slot = m_free_slots.back();
+            m_free_slots.pop_back();
+        }
+
+        slot_t& s = m_slots[slot];
+        if(s.packs.size() < pack_cnt)
+        {
+            s.packs.resize(pack_cnt);
+        }
+        memset(&s.stream,0,sizeof(s.stream));
+        s.stream.pack = s.packs.data();
+        s.stream.pack_cnt = s.packs.size();
+        s.bytes = 0;
+        s.done = false;
+        return slot;
+    }
+
+    venc_frame_ptr venc_frame_pool::get(const ot_venc_chn_status& stat)
+    {
+        std::unique_lock<std::mutex> lock(m_mu);
+
+        int32_t slot = alloc_slot(stat.cur_packs);
+        slot_t& s = m_slots[slot];
+        td_s32 ret = ss_mpi_venc_get_stream(m_venc_chn,&s.stream,TD_TRUE);
+        if(ret != TD_SUCCESS)
+        {
+            m_free_slots.push_back(slot);
+            DEV_WRITE_LOG_ERROR("ss_mpi_venc_get_stream failed with %#x", ret);
+            return nullptr;
+        }
+
+        for(uint32_t i = 0; i < s.stream.pack_cnt; i++)
+        {
+            s.bytes += s.stream.pack[i].len;
+        }
+        m_held_bytes += s.bytes;
+        m_order.push_back(slot);
+
+        //keep the stream in venc while there is room,otherwise copy it out so venc is not starved
+        uint64_t used = m_held_bytes + stat.left_stream_bytes;
+        if(m_ref_cnt < m_max_ref
+                && used * 100 < (uint64_t)m_buf_size * m_copy_percent)
+        {
+            m_ref_cnt++;
+            m_ref_frames++;
+            ot_venc_stream stream = s.stream;
+            lock.unlock();
+            return std::make_shared<venc_frame>(shared_from_this(),slot,&stream);
+        }
+
+        std::vector<uint8_t> data = alloc_data(s.bytes);
+        uint32_t pos = 0;
+        for(uint32_t i = 0; i < s.stream.pack_cnt; i++)
+        {
+            memcpy(data.data() + pos,s.stream.pack[i].addr,s.stream.pack[i].len);
+            pos += s.stream.pack[i].len;
+        }
+        ot_venc_stream stream = s.stream;
+        m_copy_frames++;
+
+        //the copy keeps its own packs,the slot only waits for its turn to be released
+        venc_frame_ptr frame = std::make_shared<venc_frame>(shared_from_this(),&stream,std::move(data));
+        s.done = true;
+        release_done();
+        return frame;
+    }
+
+    //m_mu held
+    void venc_frame_pool::release_done()
+    {
+        while(!m_order.empty() && m_slots[m_order.front()].done)
+        {
+            int32_t slot = m_order.front();
+            m_order.pop_front();
+
+            slot_t& s = m_slots[slot];
+            td_s32 ret = ss_mpi_venc_release_stream(m_venc_chn,&s.stream);
+            if(ret != TD_SUCCESS)
+            {
+                DEV_WRITE_LOG_ERROR("ss_mpi_venc_release_stream failed with %#x", ret);
+            }
+            m_held_bytes -= s.bytes;
+            m_free_slots.push_back(slot);
+        }
+
+        if(m_order.empty())
+        {
+            m_cond.notify_all();
+        }
+    }
+
+    void venc_frame_pool::on_slot_done(int32_t slot)
+    {
+        std::unique_lock<std::mutex> lock(m_mu);
+        m_slots[slot].done = true;
+        m_ref_cnt--;
+        release_done();
+    }
+
+    std::vector<uint8_t> venc_frame_pool::alloc_data(uint32_t len)
+    {
+        std::vector<uint8_t> data;
+        for(auto it = m_free_data.begin(); it != m_free_data.end(); it++)
+        {
+            if(it->capacity() >= len)
+            {
+                data = std::move(*it);
+                m_free_data.erase(it);
+                break;
+            }
+        }
+
+        data.resize(len);
+        return data;
+    }
+
+    void venc_frame_pool::free_data(std::vector<uint8_t>&& data)
+    {
+        std::unique_lock<std::mutex> lock(m_mu);
+        if(m_free_data.size() < VENC_FRAME_MAX_FREE_DATA)
+        {
+            m_free_data.push_back(std::move(data));
+        }
+    }
+
+    bool venc_frame_pool::drain(int32_t timeout_ms)
+    {
+        std::unique_lock<std::mutex> lock(m_mu);
+        if(!m_cond.wait_for(lock,std::chrono::milliseconds(timeout_ms),[this](){ return m_order.empty(); }))
+        {
+            DEV_WRITE_LOG_ERROR("venc chn %d still has %u frames held", m_venc_chn, (uint32_t)m_order.size());
+            return false;
+        }
+
+        return true;
+    }
+
+    uint32_t venc_frame_pool::held_count()
+    {
+        std::unique_lock<std::mutex> lock(m_mu);
+        return m_order.size();
+    }
+
+    uint64_t venc_frame_pool::held_bytes()
+    {
+        std::unique_lock<std::mutex> lock(m_mu);
+        return m_held_bytes;
+    }
+
+    uint64_t venc_frame_pool::ref_frames()
+    {
+        std::unique_lock<std::mutex> lock(m_mu);
+        return m_ref_frames;
+    }
+
+    uint64_t venc_frame_pool::copy_frames()
+    {
+        std::unique_lock<std::mutex> lock(m_mu);
+        return m_copy_frames;
+    }
+
+}}//namespace
@@ -0,0 +1,118 @@
+#ifndef dev_venc_frame_include_h
+#define dev_venc_frame_include_h
+
+#include "dev_std.h"
+#include <util/stream_frame.h>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+
+namespace hisilicon{namespace dev{
+
+//frames that may reference the venc buffer at the same time,more are copied
+#define VENC_FRAME_MAX_REF 8
+//venc buffer usage(percent) from which new frames are copied out and the stream released at once
+#define VENC_FRAME_COPY_PERCENT 75
+
+    class venc_frame_pool;
+    typedef std::shared_ptr<venc_frame_pool> venc_frame_pool_ptr;
+
+    //a venc stream kept until the last reference drops.
+    //a ref frame points into the venc buffer,a copied frame into pooled memory
+    class venc_frame
+        :public ceanic::util::stream_frame
+    {
+        public:
+            venc_frame(venc_frame_pool_ptr pool,int32_t slot,const ot_venc_stream* stream);
+            venc_frame(venc_frame_pool_ptr pool,const ot_venc_stream* stream,std::vector<uint8_t>&& data);
+            virtual ~venc_frame();
+
+            ot_venc_stream* stream();
+            bool is_ref() override;
+
+        private:
+            venc_frame_pool_ptr m_pool;
+            int32_t m_slot;
+            ot_venc_stream m_stream;
+            std::vector<ot_venc_pack> m_packs;
+            std::vector<uint8_t> m_data;
+    };
+    typedef std::shared_ptr<venc_frame> venc_frame_ptr;
+
+    //a frame got slice by slice in low latency mode,keeps every slice until dropped
+    class venc_au_frame
+        :public ceanic::util::stream_frame
+    {
+        public:
+            venc_au_frame();
+            virtual ~venc_au_frame();
+
+            //append the slice and its nalus
+            void add(venc_frame_ptr slice);
+            uint32_t slice_count();
+            bool is_ref() override;
+
+        private:
+            std::vector<venc_frame_ptr> m_slices;
+    };
+    typedef std::shared_ptr<venc_au_frame> venc_au_frame_ptr;
+
+    //per channel,owns the pack arrays handed to ss_mpi_venc_get_stream and
+    //releases the streams back to venc in the order they were got
+    class venc_frame_pool
+        :public std::enable_shared_from_this<venc_frame_pool>
+    {
+        public:
+            venc_frame_pool(ot_venc_chn venc_chn,uint32_t buf_size,uint32_t max_ref = VENC_FRAME_MAX_REF,uint32_t copy_percent = VENC_FRAME_COPY_PERCENT);
+            ~venc_frame_pool();
+
+            //get the stream described by stat,nullptr when get_stream fails
+            venc_frame_ptr get(const ot_venc_chn_status& stat);
+
+            //wait until every stream got from the channel is released,call before destroying the channel
+            bool drain(int32_t timeout_ms);
+
+            uint32_t held_count();
+            uint64_t held_bytes();
+            uint64_t ref_frames();
+            uint64_t copy_frames();
+
+        private:
+            friend class venc_frame;
+
+            typedef struct
+            {
+                std::vector<ot_venc_pack> packs;
+                ot_venc_stream stream;
+                uint32_t bytes;
+                bool done;
+            }slot_t;
+
+            int32_t alloc_slot(uint32_t pack_cnt);
+            void on_slot_done(int32_t slot);
+            void release_done();
+            std::vector<uint8_t> alloc_data(uint32_t len);
+            void free_data(std::vector<uint8_t>&& data);
+
+        private:
+            ot_venc_chn m_venc_chn;
+            uint32_t m_buf_size;
+            uint32_t m_max_ref;
+            uint32_t m_copy_percent;
+
+            std::mutex m_mu;
+            std::condition_variable m_cond;
+            std::vector<slot_t> m_slots;
+            std::vector<int32_t> m_free_slots;
+            std::deque<int32_t> m_order;
+            uint32_t m_ref_cnt;
+            uint64_t m_held_bytes;
+            uint64_t m_ref_frames;
+            uint64_t m_copy_frames;
+            std::vector<std::vector<uint8_t>> m_free_data;
+    };
+
+}}//namespace
+
+#endif
@@ -0,0 +1,89 @@
+#include "dev_vi_sim.h"
+#include "dev_log.h"
+
+namespace hisilicon{namespace dev{
+
+    vi_sim::vi_sim(int w,int h,int src_fr)
+        :vi(w,h,src_fr,0)
+    {
+        //init vpss grp attr
+        memset(&m_vpss_grp_attr,0,sizeof(m_vpss_grp_attr));
+        m_vpss_grp_attr.max_width                 = m_w;
+        m_vpss_grp_attr.max_height                = m_h;
+        m_vpss_grp_attr.dynamic_range             = OT_DYNAMIC_RANGE_SDR8;
+        m_vpss_grp_attr.pixel_format              = OT_PIXEL_FORMAT_YVU_SEMIPLANAR_420;
+        m_vpss_grp_attr.dei_mode                  = OT_VPSS_DEI_MODE_OFF;
+        m_vpss_grp_attr.buf_share_chn             = OT_VPSS_CHN0;
+        m_vpss_grp_attr.frame_rate.src_frame_rate = -1;
+        m_vpss_grp_attr.frame_rate.dst_frame_rate = m_src_fr;
+
+        //init vpss chn attr
+        memset(&m_vpss_chn_attr,0,sizeof(m_vpss_chn_attr));
+        m_vpss_chn_attr.width                     = m_w;
+        m_vpss_chn_attr.height                    = m_h;
+        m_vpss_chn_attr.chn_mode                  = OT_VPSS_CHN_MODE_USER;
+        m_vpss_chn_attr.video_format              = OT_VIDEO_FORMAT_LINEAR;
+        m_vpss_chn_attr.dynamic_range             = OT_DYNAMIC_RANGE_SDR8;
+        m_vpss_chn_attr.pixel_format              = OT_PIXEL_FORMAT_YVU_SEMIPLANAR_420;
+        m_vpss_chn_attr.compress_mode             = OT_COMPRESS_MODE_NONE;
+        m_vpss_chn_attr.aspect_ratio.mode         = OT_ASPECT_RATIO_NONE;
+        m_vpss_chn_attr.frame_rate.src_frame_rate = -1;
+        m_vpss_chn_attr.frame_rate.dst_frame_rate = -1;
+    }
+
+    vi_sim::~vi_sim()
+    {
+    }
+
+    bool vi_sim::start()
+    {
+        if(m_is_start)
+        {
+            return false;
+        }
+
+        td_s32 ret = ss_mpi_vpss_create_grp(m_vpss_grp,&m_vpss_grp_attr);
+        if(ret != TD_SUCCESS)
+        {
+            DEV_WRITE_LOG_ERROR("ss_mpi_vpss_create_grp failed with %#x", ret);
+            return false;
+        }
+        ret = ss_mpi_vpss_start_grp(m_vpss_grp);
+        if(ret != TD_SUCCESS)
+        {
+            DEV_WRITE_LOG_ERROR("ss_mpi_vpss_start_grp failed with %#x", ret);
+            ss_mpi_vpss_destroy_grp(m_vpss_grp);
+            return false;
+        }
+
+        ret = ss_mpi_vpss_set_chn_attr(m_vpss_grp,m_vpss_chn,&m_vpss_chn_attr);
+        if(ret == TD_SUCCESS)
+        {
+            ret = ss_mpi_vpss_enable_chn(m_vpss_grp,m_vpss_chn);
+        }
+        if(ret != TD_SUCCESS)
+        {
+            DEV_WRITE_LOG_ERROR("ss_mpi_vpss_enable_chn failed with %#x", ret);
+            ss_mpi_vpss_stop_grp(m_vpss_grp);
+            ss_mpi_vpss_destroy_grp(m_vpss_grp);
+            return false;
+        }
+
+        m_is_start = true;
+        return true;
+    }
+
+    void vi_sim::stop()
+    {
+        if(!m_is_start)
+        {
+            return;
+        }
+
+        ss_mpi_vpss_disable_chn(m_vpss_grp,m_vpss_chn);
+        ss_mpi_vpss_stop_grp(m_vpss_grp);
+        ss_mpi_vpss_destroy_grp(m_vpss_grp);
+        m_is_start = false;
+    }
+
+}}//namespace
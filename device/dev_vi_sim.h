@@ -0,0 +1,27 @@
+#ifndef dev_vi_sim_include_h
+#define dev_vi_sim_include_h
+
+#include "dev_vi.h"
+
+//to support the x86 sdk stand-in,frames come from the emulated vpss instead of a sensor
+namespace hisilicon{namespace dev{
+
+    class vi_sim
+        :public vi
+    {
+        public:
+            vi_sim(int w = 1920,int h = 1080,int src_fr = 30);
+            virtual ~vi_sim();
+
+            bool start() override;
+
+            void stop() override;
+
+        protected:
+            ot_vpss_grp_attr m_vpss_grp_attr;
+            ot_vpss_chn_attr m_vpss_chn_attr;
+    };
+
+}}//namespace
+
+#endif
@@ -0,0 +1,218 @@
+#pragma once
+
+//software stand-in for the ss_mpi sdk,only the subset used by the app.
+//types keep the sdk field names so the device code builds unchanged,layouts are not binary compatible
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+typedef unsigned char td_u8;
+typedef unsigned short td_u16;
+typedef unsigned int td_u32;
+typedef unsigned long long td_u64;
+typedef signed char td_s8;
+typedef short td_s16;
+typedef int td_s32;
+typedef long long td_s64;
+typedef char td_char;
+typedef float td_float;
+typedef double td_double;
+typedef void td_void;
+typedef td_u64 td_phys_addr_t;
+typedef unsigned long td_ulong;
+typedef td_u32 td_handle;
+
+typedef enum
+{
+    TD_FALSE = 0,
+    TD_TRUE = 1,
+}td_bool;
+
+#define TD_NULL NULL
+#define TD_SUCCESS 0
+#define TD_FAILURE (-1)
+
+#define OT_INVALID_HANDLE (-1)
+
+typedef enum
+{
+    OT_ID_SYS = 2,
+    OT_ID_VB = 3,
+    OT_ID_VENC = 5,
+    OT_ID_VPSS = 7,
+    OT_ID_RGN = 9,
+    OT_ID_VI = 16,
+    OT_ID_VO = 17,
+    OT_ID_VDEC = 19,
+    OT_ID_BUTT,
+}ot_mod_id;
+
+typedef struct
+{
+    ot_mod_id mod_id;
+    td_s32 dev_id;
+    td_s32 chn_id;
+}ot_mpp_chn;
+
+//error code layout of the sdk: 0xa0000000|mod<<16|level<<13|errno
+#define OT_ERR_APPID 0x80000000L
+#define OT_ERR_LEVEL_ERROR 4
+#define OT_DEF_ERR(mod,level,err) ((td_s32)(OT_ERR_APPID | 0x20000000L | ((mod) << 16) | ((level) << 13) | (err)))
+
+typedef enum
+{
+    OT_ERR_INVALID_DEV_ID = 1,
+    OT_ERR_INVALID_CHN_ID = 2,
+    OT_ERR_ILLEGAL_PARAM = 3,
+    OT_ERR_EXIST = 4,
+    OT_ERR_UNEXIST = 5,
+    OT_ERR_NULL_PTR = 6,
+    OT_ERR_NOT_CFG = 7,
+    OT_ERR_NOT_SUPPORT = 8,
+    OT_ERR_NOT_PERM = 9,
+    OT_ERR_NO_MEM = 12,
+    OT_ERR_NO_BUF = 13,
+    OT_ERR_BUF_EMPTY = 14,
+    OT_ERR_BUF_FULL = 15,
+    OT_ERR_NOT_READY = 16,
+    OT_ERR_BUSY = 18,
+    OT_ERR_TIMEOUT = 19,
+}ot_errno;
+
+typedef struct
+{
+    td_u32 width;
+    td_u32 height;
+}ot_size;
+
+typedef struct
+{
+    td_s32 x;
+    td_s32 y;
+}ot_point;
+
+typedef struct
+{
+    td_s32 x;
+    td_s32 y;
+    td_u32 width;
+    td_u32 height;
+}ot_rect;
+
+typedef enum
+{
+    OT_PT_JPEG = 26,
+    OT_PT_H264 = 96,
+    OT_PT_H265 = 265,
+    OT_PT_MJPEG = 1002,
+}ot_payload_type;
+
+typedef enum
+{
+    OT_PIXEL_FORMAT_RGB_BAYER_12BPP = 10,
+    OT_PIXEL_FORMAT_ARGB_1555 = 20,
+    OT_PIXEL_FORMAT_YVU_SEMIPLANAR_420 = 31,
+    OT_PIXEL_FORMAT_YUV_SEMIPLANAR_420 = 32,
+    OT_PIXEL_FORMAT_BUTT,
+}ot_pixel_format;
+
+typedef enum
+{
+    OT_VIDEO_FORMAT_LINEAR = 0,
+    OT_VIDEO_FORMAT_TILE_16x8,
+    OT_VIDEO_FORMAT_BUTT,
+}ot_video_format;
+
+typedef enum
+{
+    OT_COMPRESS_MODE_NONE = 0,
+    OT_COMPRESS_MODE_SEG,
+    OT_COMPRESS_MODE_LINE,
+    OT_COMPRESS_MODE_FRAME,
+    OT_COMPRESS_MODE_BUTT,
+}ot_compress_mode;
+
+typedef enum
+{
+    OT_DYNAMIC_RANGE_SDR8 = 0,
+    OT_DYNAMIC_RANGE_SDR10,
+    OT_DYNAMIC_RANGE_HDR10,
+    OT_DYNAMIC_RANGE_BUTT,
+}ot_dynamic_range;
+
+typedef enum
+{
+    OT_ASPECT_RATIO_NONE = 0,
+    OT_ASPECT_RATIO_AUTO,
+    OT_ASPECT_RATIO_MANUAL,
+    OT_ASPECT_RATIO_BUTT,
+}ot_aspect_ratio_type;
+
+typedef struct
+{
+    ot_aspect_ratio_type mode;
+    td_u32 bg_color;
+    ot_rect video_rect;
+}ot_aspect_ratio;
+
+typedef struct
+{
+    td_s32 src_frame_rate;
+    td_s32 dst_frame_rate;
+}ot_frame_rate_ctrl;
+
+typedef struct
+{
+    td_u32 width;
+    td_u32 height;
+    ot_pixel_format pixel_format;
+    ot_video_format video_format;
+    ot_compress_mode compress_mode;
+    ot_dynamic_range dynamic_range;
+    td_u32 stride[3];
+    td_phys_addr_t phys_addr[3];
+    td_void* virt_addr[3];
+    td_u32 time_ref;
+    td_u64 pts;
+    td_u32 frame_flag;
+}ot_video_frame;
+
+typedef struct
+{
+    ot_video_frame video_frame;
+    td_u32 pool_id;
+    ot_mod_id mod_id;
+}ot_video_frame_info;
+
+typedef struct
+{
+    td_bool enable;
+    td_u32 line_cnt;
+    td_bool one_buf_en;
+}ot_low_delay_info;
+
+typedef td_s32 ot_vi_dev;
+typedef td_s32 ot_vi_pipe;
+typedef td_s32 ot_vi_chn;
+typedef td_s32 ot_vpss_grp;
+typedef td_s32 ot_vpss_chn;
+typedef td_s32 ot_venc_chn;
+typedef td_s32 ot_rgn_handle;
+typedef td_u32 ot_vb_pool;
+
+#define OT_VPSS_CHN0 0
+#define OT_VPSS_MAX_PHYS_CHN_NUM 4
+#define OT_VPSS_MAX_GRP_NUM 32
+#define OT_VENC_MAX_CHN_NUM 16
+#define OT_RGN_HANDLE_MAX 1024
+#define OT_VI_MAX_PIPE_NUM 4
+#define OT_VB_MAX_COMMON_POOLS 16
+#define OT_VB_INVALID_POOL_ID (-1U)
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,3 @@
+#pragma once
+
+#include "ot_common.h"
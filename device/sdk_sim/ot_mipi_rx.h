@@ -0,0 +1,18 @@
+#pragma once
+
+#include "ot_common.h"
+
+//mipi rx is not emulated,dev_vi_sim replaces the sensor input
+
+typedef enum
+{
+    LANE_DIVIDE_MODE_0 = 0,
+    LANE_DIVIDE_MODE_1 = 1,
+    LANE_DIVIDE_MODE_BUTT,
+}lane_divide_mode_t;
+
+typedef struct
+{
+    td_u32 devno;
+    ot_rect img_rect;
+}combo_dev_attr_t;
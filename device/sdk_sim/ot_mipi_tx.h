@@ -0,0 +1,5 @@
+#pragma once
+
+#include "ot_common.h"
+
+//mipi tx is not emulated
@@ -0,0 +1,10 @@
+#pragma once
+
+#include "ot_common.h"
+
+//sensor drivers are not emulated,the object only exists so dev_vi_isp.h builds
+
+typedef struct
+{
+    td_void* reserved;
+}ot_isp_sns_obj;
@@ -0,0 +1,59 @@
+#pragma once
+
+//bounded memory/string helpers of the sdk's securec library
+
+#include <string.h>
+#include <stdio.h>
+#include <stdarg.h>
+
+#ifndef EOK
+#define EOK 0
+#endif
+
+typedef int errno_t;
+
+static inline errno_t memcpy_s(void* dest,size_t dest_max,const void* src,size_t count)
+{
+    if(dest == NULL || src == NULL || count > dest_max)
+    {
+        return -1;
+    }
+    memcpy(dest,src,count);
+    return EOK;
+}
+
+static inline errno_t memset_s(void* dest,size_t dest_max,int c,size_t count)
+{
+    if(dest == NULL || count > dest_max)
+    {
+        return -1;
+    }
+    memset(dest,c,count);
+    return EOK;
+}
+
+static inline errno_t strncpy_s(char* dest,size_t dest_max,const char* src,size_t count)
+{
+    if(dest == NULL || src == NULL || dest_max == 0)
+    {
+        return -1;
+    }
+    size_t len = strnlen(src,count);
+    if(len >= dest_max)
+    {
+        dest[0] = '\0';
+        return -1;
+    }
+    memcpy(dest,src,len);
+    dest[len] = '\0';
+    return EOK;
+}
+
+static inline int snprintf_s(char* dest,size_t dest_max,size_t count,const char* format,...)
+{
+    va_list args;
+    va_start(args,format);
+    int ret = vsnprintf(dest,dest_max < count + 1 ? dest_max : count + 1,format,args);
+    va_end(args);
+    return ret;
+}
@@ -0,0 +1,39 @@
+#ifndef sim_common_include_h
+#define sim_common_include_h
+
+#include "ot_common.h"
+#include <stdint.h>
+#include <string>
+
+//shared by the sdk_sim modules,not part of the sdk api
+namespace ceanic{namespace sdk_sim{
+
+//directory of the replayed streams,CEANIC_SIM_DIR overrides it
+#define SIM_DEFAULT_DIR "/opt/ceanic/sim"
+#define SIM_DEFAULT_FRAME_RATE 30
+
+    //us,CLOCK_MONOTONIC like the pts of the sdk
+    uint64_t now_us();
+
+    std::string source_dir();
+
+    //there is no iommu,the "physical" address of a buffer is its virtual address
+    inline td_phys_addr_t to_phys(const void* virt)
+    {
+        return (td_phys_addr_t)(uintptr_t)virt;
+    }
+
+    inline void* to_virt(td_phys_addr_t phys)
+    {
+        return (void*)(uintptr_t)phys;
+    }
+
+    //vb blocks for modules that hand out frames
+    bool vb_get_block(ot_vb_pool pool,td_phys_addr_t* phys_addr,void** virt_addr);
+    void vb_release_block(td_phys_addr_t phys_addr);
+    ot_vb_pool vb_create_private_pool(uint64_t blk_size,uint32_t blk_cnt);
+    void vb_destroy_private_pool(ot_vb_pool pool);
+
+}}//namespace
+
+#endif
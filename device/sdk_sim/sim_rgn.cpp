@@ -0,0 +1,204 @@
+#include "sim_common.h"
+#include "ss_mpi_region.h"
+#include <string.h>
+#include <map>
+#include <mutex>
+#include <vector>
+
+namespace ceanic{namespace sdk_sim{
+
+    typedef struct
+    {
+        ot_mpp_chn chn;
+        ot_rgn_chn_attr attr;
+    }rgn_attach_t;
+
+    typedef struct
+    {
+        ot_rgn_attr attr;
+        std::vector<std::vector<uint8_t>> canvas;
+        uint32_t show;
+        uint32_t update_cnt;
+        std::vector<rgn_attach_t> attach;
+    }rgn_t;
+
+    static std::mutex g_rgn_mu;
+    static std::map<ot_rgn_handle,rgn_t> g_rgns;
+
+    static bool same_chn(const ot_mpp_chn& a,const ot_mpp_chn& b)
+    {
+        return a.mod_id == b.mod_id && a.dev_id == b.dev_id && a.chn_id == b.chn_id;
+    }
+
+    //overlay pixel formats used by the app are 16 bits
+    static uint32_t canvas_stride(const ot_rgn_attr& attr)
+    {
+        return attr.attr.overlay.size.width * 2;
+    }
+
+}}//namespace
+
+using namespace ceanic::sdk_sim;
+
+td_s32 ss_mpi_rgn_create(ot_rgn_handle handle,const ot_rgn_attr* rgn_attr)
+{
+    if(handle < 0 || handle >= OT_RGN_HANDLE_MAX)
+    {
+        return OT_ERR_RGN_INVALID_CHN_ID;
+    }
+    if(!rgn_attr)
+    {
+        return OT_ERR_RGN_NULL_PTR;
+    }
+    if(rgn_attr->type != OT_RGN_OVERLAY && rgn_attr->type != OT_RGN_OVERLAYEX)
+    {
+        return OT_ERR_RGN_NOT_SUPPORT;
+    }
+
+    const ot_rgn_overlay_attr& overlay = rgn_attr->attr.overlay;
+    if(overlay.size.width == 0 || overlay.size.height == 0 || overlay.canvas_num == 0)
+    {
+        return OT_ERR_RGN_ILLEGAL_PARAM;
+    }
+
+    std::unique_lock<std::mutex> lock(g_rgn_mu);
+    if(g_rgns.count(handle))
+    {
+        return OT_ERR_RGN_EXIST;
+    }
+
+    rgn_t& rgn = g_rgns[handle];
+    rgn.attr = *rgn_attr;
+    rgn.show = 0;
+    rgn.update_cnt = 0;
+    rgn.canvas.resize(overlay.canvas_num);
+    for(auto it = rgn.canvas.begin(); it != rgn.canvas.end(); it++)
+    {
+        it->assign((size_t)canvas_stride(*rgn_attr) * overlay.size.height,0);
+    }
+    return TD_SUCCESS;
+}
+
+td_s32 ss_mpi_rgn_destroy(ot_rgn_handle handle)
+{
+    std::unique_lock<std::mutex> lock(g_rgn_mu);
+    return g_rgns.erase(handle) ? TD_SUCCESS : OT_ERR_RGN_UNEXIST;
+}
+
+td_s32 ss_mpi_rgn_attach_to_chn(ot_rgn_handle handle,const ot_mpp_chn* chn,const ot_rgn_chn_attr* chn_attr)
+{
+    if(!chn || !chn_attr)
+    {
+        return OT_ERR_RGN_NULL_PTR;
+    }
+
+    std::unique_lock<std::mutex> lock(g_rgn_mu);
+    auto it = g_rgns.find(handle);
+    if(it == g_rgns.end())
+    {
+        return OT_ERR_RGN_UNEXIST;
+    }
+
+    for(auto a = it->second.attach.begin(); a != it->second.attach.end(); a++)
+    {
+        if(same_chn(a->chn,*chn))
+        {
+            return OT_ERR_RGN_EXIST;
+        }
+    }
+
+    it->second.attach.push_back(rgn_attach_t{*chn,*chn_attr});
+    return TD_SUCCESS;
+}
+
+td_s32 ss_mpi_rgn_detach_from_chn(ot_rgn_handle handle,const ot_mpp_chn* chn)
+{
+    if(!chn)
+    {
+        return OT_ERR_RGN_NULL_PTR;
+    }
+
+    std::unique_lock<std::mutex> lock(g_rgn_mu);
+    auto it = g_rgns.find(handle);
+    if(it == g_rgns.end())
+    {
+        return OT_ERR_RGN_UNEXIST;
+    }
+
+    for(auto a = it->second.attach.begin(); a != it->second.attach.end(); a++)
+    {
+        if(same_chn(a->chn,*chn))
+        {
+            it->second.attach.erase(a);
+            return TD_SUCCESS;
+        }
+    }
+
+    return OT_ERR_RGN_UNEXIST;
+}
+
+td_s32 ss_mpi_rgn_set_display_attr(ot_rgn_handle handle,const ot_mpp_chn* chn,const ot_rgn_chn_attr* chn_attr)
+{
+    if(!chn || !chn_attr)
+    {
+        return OT_ERR_RGN_NULL_PTR;
+    }
+
+    std::unique_lock<std::mutex> lock(g_rgn_mu);
+    auto it = g_rgns.find(handle);
+    if(it == g_rgns.end())
+    {
+        return OT_ERR_RGN_UNEXIST;
+    }
+
+    for(auto a = it->second.attach.begin(); a != it->second.attach.end(); a++)
+    {
+        if(same_chn(a->chn,*chn))
+        {
+            a->attr = *chn_attr;
+            return TD_SUCCESS;
+        }
+    }
+
+    return OT_ERR_RGN_UNEXIST;
+}
+
+td_s32 ss_mpi_rgn_get_canvas_info(ot_rgn_handle handle,ot_rgn_canvas_info* canvas_info)
+{
+    if(!canvas_info)
+    {
+        return OT_ERR_RGN_NULL_PTR;
+    }
+
+    std::unique_lock<std::mutex> lock(g_rgn_mu);
+    auto it = g_rgns.find(handle);
+    if(it == g_rgns.end())
+    {
+        return OT_ERR_RGN_UNEXIST;
+    }
+
+    rgn_t& rgn = it->second;
+    std::vector<uint8_t>& back = rgn.canvas[(rgn.show + 1) % rgn.canvas.size()];
+    memset(canvas_info,0,sizeof(*canvas_info));
+    canvas_info->virt_addr = back.data();
+    canvas_info->phys_addr = to_phys(back.data());
+    canvas_info->size = rgn.attr.attr.overlay.size;
+    canvas_info->stride = canvas_stride(rgn.attr);
+    canvas_info->pixel_format = rgn.attr.attr.overlay.pixel_format;
+    return TD_SUCCESS;
+}
+
+td_s32 ss_mpi_rgn_update_canvas(ot_rgn_handle handle)
+{
+    std::unique_lock<std::mutex> lock(g_rgn_mu);
+    auto it = g_rgns.find(handle);
+    if(it == g_rgns.end())
+    {
+        return OT_ERR_RGN_UNEXIST;
+    }
+
+    rgn_t& rgn = it->second;
+    rgn.show = (rgn.show + 1) % rgn.canvas.size();
+    rgn.update_cnt++;
+    return TD_SUCCESS;
+}
@@ -0,0 +1,402 @@
+#include "sim_common.h"
+#include "ss_mpi_sys.h"
+#include "ss_mpi_sys_bind.h"
+#include "ss_mpi_vb.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <map>
+#include <mutex>
+#include <vector>
+
+namespace ceanic{namespace sdk_sim{
+
+    uint64_t now_us()
+    {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC,&ts);
+        return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+    }
+
+    std::string source_dir()
+    {
+        const char* dir = getenv("CEANIC_SIM_DIR");
+        return (dir && dir[0]) ? dir : SIM_DEFAULT_DIR;
+    }
+
+    typedef struct
+    {
+        uint64_t blk_size;
+        uint32_t blk_cnt;
+        uint8_t* base;
+        std::vector<bool> used;
+    }vb_pool_t;
+
+    static std::mutex g_vb_mu;
+    static std::map<ot_vb_pool,vb_pool_t> g_vb_pools;
+    static ot_vb_pool g_vb_next_pool = 0;
+    static ot_vb_cfg g_vb_cfg;
+    static bool g_vb_inited = false;
+
+    ot_vb_pool vb_create_private_pool(uint64_t blk_size,uint32_t blk_cnt)
+    {
+        if(blk_size == 0 || blk_cnt == 0)
+        {
+            return OT_VB_INVALID_POOL_ID;
+        }
+
+        //4K aligned blocks,as the sdk
+        blk_size = (blk_size + 4095) & ~(uint64_t)4095;
+        void* base = NULL;
+        if(posix_memalign(&base,4096,blk_size * blk_cnt) != 0)
+        {
+            return OT_VB_INVALID_POOL_ID;
+        }
+
+        std::unique_lock<std::mutex> lock(g_vb_mu);
+        ot_vb_pool id = g_vb_next_pool++;
+        vb_pool_t& pool = g_vb_pools[id];
+        pool.blk_size = blk_size;
+        pool.blk_cnt = blk_cnt;
+        pool.base = (uint8_t*)base;
+        pool.used.assign(blk_cnt,false);
+        return id;
+    }
+
+    void vb_destroy_private_pool(ot_vb_pool pool)
+    {
+        ss_mpi_vb_destroy_pool(pool);
+    }
+
+    bool vb_get_block(ot_vb_pool id,td_phys_addr_t* phys_addr,void** virt_addr)
+    {
+        std::unique_lock<std::mutex> lock(g_vb_mu);
+        auto it = g_vb_pools.find(id);
+        if(it == g_vb_pools.end())
+        {
+            return false;
+        }
+
+        vb_pool_t& pool = it->second;
+        for(uint32_t i = 0; i < pool.blk_cnt; i++)
+        {
+            if(!pool.used[i])
+            {
+                pool.used[i] = true;
+                *virt_addr = pool.base + pool.blk_size * i;
+                *phys_addr = to_phys(*virt_addr);
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    void vb_release_block(td_phys_addr_t phys_addr)
+    {
+        std::unique_lock<std::mutex> lock(g_vb_mu);
+        uint8_t* addr = (uint8_t*)to_virt(phys_addr);
+        for(auto it = g_vb_pools.begin(); it != g_vb_pools.end(); it++)
+        {
+            vb_pool_t& pool = it->second;
+            if(addr >= pool.base && addr < pool.base + pool.blk_size * pool.blk_cnt)
+            {
+                pool.used[(addr - pool.base) / pool.blk_size] = false;
+                return;
+            }
+        }
+    }
+
+}}//namespace
+
+using namespace ceanic::sdk_sim;
+
+static std::mutex g_sys_mu;
+static bool g_sys_inited = false;
+static std::vector<std::pair<ot_mpp_chn,ot_mpp_chn>> g_binds;
+static std::map<const void*,td_u32> g_mmz;
+
+static bool same_chn(const ot_mpp_chn& a,const ot_mpp_chn& b)
+{
+    return a.mod_id == b.mod_id && a.dev_id == b.dev_id && a.chn_id == b.chn_id;
+}
+
+td_s32 ss_mpi_sys_init(td_void)
+{
+    std::unique_lock<std::mutex> lock(g_sys_mu);
+    g_sys_inited = true;
+    return TD_SUCCESS;
+}
+
+td_s32 ss_mpi_sys_exit(td_void)
+{
+    std::unique_lock<std::mutex> lock(g_sys_mu);
+    g_sys_inited = false;
+    g_binds.clear();
+    return TD_SUCCESS;
+}
+
+td_s32 ss_mpi_sys_set_vi_vpss_mode(const ot_vi_vpss_mode* vi_vpss_mode)
+{
+    return vi_vpss_mode ? TD_SUCCESS : OT_ERR_SYS_NULL_PTR;
+}
+
+td_s32 ss_mpi_sys_set_vi_aiisp_mode(ot_vi_pipe vi_pipe,ot_vi_aiisp_mode mode)
+{
+    if(vi_pipe < 0 || vi_pipe >= OT_VI_MAX_PIPE_NUM || mode >= OT_VI_AIISP_MODE_BUTT)
+    {
+        return OT_ERR_SYS_ILLEGAL_PARAM;
+    }
+
+    return TD_SUCCESS;
+}
+
+td_s32 ss_mpi_sys_set_3dnr_pos(ot_3dnr_pos_type pos)
+{
+    return pos < OT_3DNR_POS_BUTT ? TD_SUCCESS : OT_ERR_SYS_ILLEGAL_PARAM;
+}
+
+td_s32 ss_mpi_sys_bind(const ot_mpp_chn* src_chn,const ot_mpp_chn* dest_chn)
+{
+    if(!src_chn || !dest_chn)
+    {
+        return OT_ERR_SYS_NULL_PTR;
+    }
+
+    std::unique_lock<std::mutex> lock(g_sys_mu);
+    if(!g_sys_inited)
+    {
+        return OT_ERR_SYS_NOT_READY;
+    }
+
+    //a receiver has one source
+    for(auto it = g_binds.begin(); it != g_binds.end(); it++)
+    {
+        if(same_chn(it->second,*dest_chn))
+        {
+            return OT_ERR_SYS_EXIST;
+        }
+    }
+
+    g_binds.push_back(std::make_pair(*src_chn,*dest_chn));
+    return TD_SUCCESS;
+}
+
+td_s32 ss_mpi_sys_unbind(const ot_mpp_chn* src_chn,const ot_mpp_chn* dest_chn)
+{
+    if(!src_chn || !dest_chn)
+    {
+        return OT_ERR_SYS_NULL_PTR;
+    }
+
+    std::unique_lock<std::mutex> lock(g_sys_mu);
+    for(auto it = g_binds.begin(); it != g_binds.end(); it++)
+    {
+        if(same_chn(it->first,*src_chn) && same_chn(it->second,*dest_chn))
+        {
+            g_binds.erase(it);
+            return TD_SUCCESS;
+        }
+    }
+
+    return OT_ERR_SYS_UNEXIST;
+}
+
+td_s32 ss_mpi_sys_get_bind_by_dest(const ot_mpp_chn* dest_chn,ot_mpp_chn* src_chn)
+{
+    if(!src_chn || !dest_chn)
+    {
+        return OT_ERR_SYS_NULL_PTR;
+    }
+
+    std::unique_lock<std::mutex> lock(g_sys_mu);
+    for(auto it = g_binds.begin(); it != g_binds.end(); it++)
+    {
+        if(same_chn(it->second,*dest_chn))
+        {
+            *src_chn = it->first;
+            return TD_SUCCESS;
+        }
+    }
+
+    return OT_ERR_SYS_UNEXIST;
+}
+
+td_s32 ss_mpi_sys_mmz_alloc(td_phys_addr_t* phys_addr,td_void** virt_addr,const td_char* mmb,const td_char* zone,td_u32 len)
+{
+    (void)mmb;
+    (void)zone;
+
+    if(!phys_addr || !virt_addr)
+    {
+        return OT_ERR_SYS_NULL_PTR;
+    }
+    if(len == 0)
+    {
+        return OT_ERR_SYS_ILLEGAL_PARAM;
+    }
+
+    void* addr = NULL;
+    if(posix_memalign(&addr,4096,len) != 0)
+    {
+        return OT_ERR_SYS_NO_MEM;
+    }
+
+    std::unique_lock<std::mutex> lock(g_sys_mu);
+    g_mmz[addr] = len;
+    *virt_addr = addr;
+    *phys_addr = to_phys(addr);
+    return TD_SUCCESS;
+}
+
+td_s32 ss_mpi_sys_mmz_alloc_cached(td_phys_addr_t* phys_addr,td_void** virt_addr,const td_char* mmb,const td_char* zone,td_u32 len)
+{
+    return ss_mpi_sys_mmz_alloc(phys_addr,virt_addr,mmb,zone,len);
+}
+
+td_s32 ss_mpi_sys_mmz_free(td_phys_addr_t phys_addr,const td_void* virt_addr)
+{
+    std::unique_lock<std::mutex> lock(g_sys_mu);
+    auto it = g_mmz.find(virt_addr);
+    if(it == g_mmz.end() || to_phys(virt_addr) != phys_addr)
+    {
+        return OT_ERR_SYS_ILLEGAL_PARAM;
+    }
+
+    g_mmz.erase(it);
+    free((void*)virt_addr);
+    return TD_SUCCESS;
+}
+
+td_s32 ss_mpi_sys_mmz_flush_cache(td_phys_addr_t phys_addr,td_void* virt_addr,td_u32 size)
+{
+    (void)phys_addr;
+    (void)virt_addr;
+    (void)size;
+    return TD_SUCCESS;
+}
+
+td_void* ss_mpi_sys_mmap(td_phys_addr_t phys_addr,td_u32 size)
+{
+    (void)size;
+    return to_virt(phys_addr);
+}
+
+td_void* ss_mpi_sys_mmap_cached(td_phys_addr_t phys_addr,td_u32 size)
+{
+    return ss_mpi_sys_mmap(phys_addr,size);
+}
+
+td_s32 ss_mpi_sys_munmap(const td_void* virt_addr,td_u32 size)
+{
+    (void)virt_addr;
+    (void)size;
+    return TD_SUCCESS;
+}
+
+td_s32 ss_mpi_vb_set_cfg(const ot_vb_cfg* vb_cfg)
+{
+    if(!vb_cfg)
+    {
+        return OT_ERR_VB_NULL_PTR;
+    }
+    if(vb_cfg->max_pool_cnt > OT_VB_MAX_COMMON_POOLS)
+    {
+        return OT_ERR_VB_ILLEGAL_PARAM;
+    }
+
+    std::unique_lock<std::mutex> lock(g_vb_mu);
+    if(g_vb_inited)
+    {
+        return OT_ERR_VB_NOT_PERM;
+    }
+    g_vb_cfg = *vb_cfg;
+    return TD_SUCCESS;
+}
+
+td_s32 ss_mpi_vb_set_supplement_cfg(const ot_vb_supplement_cfg* supplement_cfg)
+{
+    return supplement_cfg ? TD_SUCCESS : OT_ERR_VB_NULL_PTR;
+}
+
+//common pools are only recorded,the emulated modules allocate from private pools
+//so a workstation does not have to back the full board configuration
+td_s32 ss_mpi_vb_init(td_void)
+{
+    std::unique_lock<std::mutex> lock(g_vb_mu);
+    g_vb_inited = true;
+    return TD_SUCCESS;
+}
+
+td_s32 ss_mpi_vb_exit(td_void)
+{
+    std::unique_lock<std::mutex> lock(g_vb_mu);
+    g_vb_inited = false;
+    return TD_SUCCESS;
+}
+
+td_s32 ss_mpi_vb_exit_mod_common_pool(ot_vb_uid vb_uid)
+{
+    return vb_uid < OT_VB_UID_BUTT ? TD_SUCCESS : OT_ERR_VB_ILLEGAL_PARAM;
+}
+
+ot_vb_pool ss_mpi_vb_create_pool(const ot_vb_pool_cfg* vb_pool_cfg)
+{
+    if(!vb_pool_cfg)
+    {
+        return OT_VB_INVALID_POOL_ID;
+    }
+
+    return vb_create_private_pool(vb_pool_cfg->blk_size,vb_pool_cfg->blk_cnt);
+}
+
+td_s32 ss_mpi_vb_destroy_pool(ot_vb_pool pool)
+{
+    std::unique_lock<std::mutex> lock(g_vb_mu);
+    auto it = g_vb_pools.find(pool);
+    if(it == g_vb_pools.end())
+    {
+        return OT_ERR_VB_UNEXIST;
+    }
+
+    for(uint32_t i = 0; i < it->second.blk_cnt; i++)
+    {
+        if(it->second.used[i])
+        {
+            return OT_ERR_VB_NOT_PERM;
+        }
+    }
+
+    free(it->second.base);
+    g_vb_pools.erase(it);
+    return TD_SUCCESS;
+}
+
+td_s32 ss_mpi_vb_pool_share_all(ot_vb_pool pool)
+{
+    std::unique_lock<std::mutex> lock(g_vb_mu);
+    return g_vb_pools.count(pool) ? TD_SUCCESS : OT_ERR_VB_UNEXIST;
+}
+
+td_s32 ss_mpi_vb_get_pool_info(ot_vb_pool pool,ot_vb_pool_info* pool_info)
+{
+    if(!pool_info)
+    {
+        return OT_ERR_VB_NULL_PTR;
+    }
+
+    std::unique_lock<std::mutex> lock(g_vb_mu);
+    auto it = g_vb_pools.find(pool);
+    if(it == g_vb_pools.end())
+    {
+        return OT_ERR_VB_UNEXIST;
+    }
+
+    pool_info->pool_id = pool;
+    pool_info->blk_cnt = it->second.blk_cnt;
+    pool_info->blk_size = it->second.blk_size;
+    pool_info->pool_size = it->second.blk_size * it->second.blk_cnt;
+    pool_info->pool_phy_addr = to_phys(it->second.base);
+    pool_info->pool_virt_addr = it->second.base;
+    return TD_SUCCESS;
+}
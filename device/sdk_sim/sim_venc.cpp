@@ -0,0 +1,1016 @@
+#include "sim_common.h"
+#include "ss_mpi_venc.h"
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ceanic{namespace sdk_sim{
+
+    //an encoder channel that replays an annex-b file instead of encoding.
+    //nalus are stored with 4 bytes start codes as the hardware emits them,packs point into that
+    //buffer and stay valid until release_stream.frames are produced at the rc frame rate,
+    //the fd counts waiting frames like the driver's
+    class venc_sim
+    {
+        public:
+            venc_sim(ot_venc_chn chn,const ot_venc_chn_attr* attr)
+                :m_chn(chn),m_attr(*attr),m_fd(-1),m_loaded_w(0),m_loaded_h(0),m_first_key(0),m_next_au(0),
+                m_got(0),m_seq(0),m_queued_bytes(0),m_dropped(0),m_running(false),m_idr(false)
+            {
+                memset(&m_jpeg_param,0,sizeof(m_jpeg_param));
+                m_jpeg_param.qfactor = 90;
+                memset(&m_slice_split,0,sizeof(m_slice_split));
+                memset(m_roi,0,sizeof(m_roi));
+                for(td_u32 i = 0; i < OT_VENC_MAX_ROI_NUM; i++)
+                {
+                    m_roi[i].idx = i;
+                }
+            }
+
+            ~venc_sim()
+            {
+                stop();
+                if(m_fd >= 0)
+                {
+                    ::close(m_fd);
+                }
+            }
+
+            bool init()
+            {
+                m_fd = eventfd(0,EFD_NONBLOCK | EFD_SEMAPHORE | EFD_CLOEXEC);
+                if(m_fd < 0)
+                {
+                    return false;
+                }
+
+                //jpeg is loaded on the first snap,it may be added after start
+                return is_snap() || load();
+            }
+
+            int fd()
+            {
+                return m_fd;
+            }
+
+            bool is_jpeg()
+            {
+                return m_attr.venc_attr.type == OT_PT_JPEG || m_attr.venc_attr.type == OT_PT_MJPEG;
+            }
+
+            //a jpeg channel encodes the frames sent to it,mjpeg replays at its frame rate like h264
+            bool is_snap()
+            {
+                return m_attr.venc_attr.type == OT_PT_JPEG;
+            }
+
+            td_s32 start()
+            {
+                std::unique_lock<std::mutex> lock(m_mu);
+                if(m_running)
+                {
+                    return TD_SUCCESS;
+                }
+
+                if(!is_snap()
+                        && (m_loaded_w != m_attr.venc_attr.pic_width || m_loaded_h != m_attr.venc_attr.pic_height))
+                {
+                    if(m_got > 0)
+                    {
+                        return OT_ERR_VENC_NOT_PERM;
+                    }
+                    clear_frames();
+                    lock.unlock();
+                    if(!load())
+                    {
+                        return OT_ERR_VENC_NOT_SUPPORT;
+                    }
+                    lock.lock();
+                }
+
+                m_running = true;
+                m_idr = true;
+                if(!is_snap())
+                {
+                    m_thd = std::thread(&venc_sim::on_produce,this);
+                }
+                return TD_SUCCESS;
+            }
+
+            void stop()
+            {
+                {
+                    std::unique_lock<std::mutex> lock(m_mu);
+                    if(!m_running)
+                    {
+                        return;
+                    }
+                    m_running = false;
+                }
+                m_cv.notify_all();
+
+                if(m_thd.joinable())
+                {
+                    m_thd.join();
+                }
+            }
+
+            td_s32 get_attr(ot_venc_chn_attr* attr)
+            {
+                std::unique_lock<std::mutex> lock(m_mu);
+                *attr = m_attr;
+                return TD_SUCCESS;
+            }
+
+            td_s32 set_attr(const ot_venc_chn_attr* attr)
+            {
+                std::unique_lock<std::mutex> lock(m_mu);
+                if(attr->venc_attr.type != m_attr.venc_attr.type
+                        || attr->venc_attr.max_pic_width != m_attr.venc_attr.max_pic_width
+                        || attr->venc_attr.max_pic_height != m_attr.venc_attr.max_pic_height)
+                {
+                    return OT_ERR_VENC_NOT_PERM;
+                }
+                if(attr->venc_attr.pic_width > attr->venc_attr.max_pic_width
+                        || attr->venc_attr.pic_height > attr->venc_attr.max_pic_height)
+                {
+                    return OT_ERR_VENC_ILLEGAL_PARAM;
+                }
+                if(m_running
+                        && (attr->venc_attr.pic_width != m_attr.venc_attr.pic_width
+                            || attr->venc_attr.pic_height != m_attr.venc_attr.pic_height))
+                {
+                    return OT_ERR_VENC_NOT_PERM;
+                }
+
+                m_attr = *attr;
+                m_cv.notify_all();
+                return TD_SUCCESS;
+            }
+
+            td_s32 query(ot_venc_chn_status* status)
+            {
+                std::unique_lock<std::mutex> lock(m_mu);
+                memset(status,0,sizeof(*status));
+                status->left_stream_frames = m_frames.size() - m_got;
+                status->left_stream_bytes = m_queued_bytes;
+                if(m_frames.size() > m_got)
+                {
+                    status->cur_packs = m_frames[m_got].count;
+                }
+                status->is_jpeg_snap_end = (is_snap() && m_frames.size() == m_got) ? TD_TRUE : TD_FALSE;
+                return TD_SUCCESS;
+            }
+
+            td_s32 get_stream(ot_venc_stream* stream,td_s32 milli_sec)
+            {
+                std::unique_lock<std::mutex> lock(m_mu);
+                if(m_frames.size() <= m_got)
+                {
+                    if(milli_sec == 0)
+                    {
+                        return OT_ERR_VENC_BUF_EMPTY;
+                    }
+
+                    auto ready = [this](){ return m_frames.size() > m_got; };
+                    if(milli_sec < 0)
+                    {
+                        m_cv.wait(lock,ready);
+                    }
+                    else if(!m_cv.wait_for(lock,std::chrono::milliseconds(milli_sec),ready))
+                    {
+                        return OT_ERR_VENC_BUF_EMPTY;
+                    }
+                }
+
+                const frame_t& f = m_frames[m_got];
+                const au_t& au = m_aus[f.au];
+                if(stream->pack_cnt < f.count)
+                {
+                    return OT_ERR_VENC_ILLEGAL_PARAM;
+                }
+
+                for(uint32_t i = 0; i < f.count; i++)
+                {
+                    const nalu_t& nalu = au.nalus[f.first + i];
+                    ot_venc_pack& pack = stream->pack[i];
+                    memset(&pack,0,sizeof(pack));
+                    pack.addr = &m_es[nalu.offset];
+                    pack.phys_addr = to_phys(pack.addr);
+                    pack.len = nalu.len;
+                    pack.pts = f.pts;
+                    pack.offset = 0;
+                    pack.is_frame_end = (f.end && i + 1 == f.count) ? TD_TRUE : TD_FALSE;
+                    if(is_jpeg())
+                    {
+                        pack.data_type.jpeg_type = OT_VENC_JPEG_PACK_ECS;
+                    }
+                    else if(m_attr.venc_attr.type == OT_PT_H265)
+                    {
+                        pack.data_type.h265_type = (ot_venc_h265_nalu_type)nalu.type;
+                    }
+                    else
+                    {
+                        pack.data_type.h264_type = (ot_venc_h264_nalu_type)nalu.type;
+                    }
+                }
+                stream->pack_cnt = f.count;
+                stream->seq = f.seq;
+                m_got++;
+
+                uint64_t val;
+                if(read(m_fd,&val,sizeof(val)) < 0)
+                {
+                    //counter and queue are updated together,only a signal can leave it empty
+                }
+                return TD_SUCCESS;
+            }
+
+            td_s32 release_stream(const ot_venc_stream* stream)
+            {
+                std::unique_lock<std::mutex> lock(m_mu);
+                if(m_got == 0 || m_frames.front().seq != stream->seq)
+                {
+                    return OT_ERR_VENC_ILLEGAL_PARAM;
+                }
+
+                m_queued_bytes -= m_frames.front().bytes;
+                m_frames.pop_front();
+                m_got--;
+                return TD_SUCCESS;
+            }
+
+            td_s32 reset()
+            {
+                std::unique_lock<std::mutex> lock(m_mu);
+                if(m_running || m_got > 0)
+                {
+                    return OT_ERR_VENC_NOT_PERM;
+                }
+
+                clear_frames();
+                m_idr = true;
+                return TD_SUCCESS;
+            }
+
+            void request_idr()
+            {
+                std::unique_lock<std::mutex> lock(m_mu);
+                m_idr = true;
+            }
+
+            td_s32 send_frame(const ot_video_frame_info* frame)
+            {
+                if(!is_snap())
+                {
+                    //the replayed stream does not depend on the input
+                    return TD_SUCCESS;
+                }
+
+                std::unique_lock<std::mutex> lock(m_mu);
+                if(!m_running)
+                {
+                    return OT_ERR_VENC_NOT_PERM;
+                }
+                if(m_aus.empty())
+                {
+                    lock.unlock();
+                    if(!load())
+                    {
+                        return OT_ERR_VENC_NOT_SUPPORT;
+                    }
+                    lock.lock();
+                }
+
+                push_frame(0,frame->video_frame.pts ? frame->video_frame.pts : now_us());
+                return TD_SUCCESS;
+            }
+
+            td_s32 get_jpeg_param(ot_venc_jpeg_param* param)
+            {
+                if(!is_jpeg())
+                {
+                    return OT_ERR_VENC_NOT_SUPPORT;
+                }
+
+                std::unique_lock<std::mutex> lock(m_mu);
+                *param = m_jpeg_param;
+                return TD_SUCCESS;
+            }
+
+            td_s32 get_slice_split(ot_venc_slice_split* slice_split)
+            {
+                if(is_jpeg())
+                {
+                    return OT_ERR_VENC_NOT_SUPPORT;
+                }
+
+                std::unique_lock<std::mutex> lock(m_mu);
+                *slice_split = m_slice_split;
+                return TD_SUCCESS;
+            }
+
+            td_s32 set_slice_split(const ot_venc_slice_split* slice_split)
+            {
+                if(is_jpeg())
+                {
+                    return OT_ERR_VENC_NOT_SUPPORT;
+                }
+                if(slice_split->enable && (slice_split->split_mode > 1 || slice_split->split_size == 0))
+                {
+                    return OT_ERR_VENC_ILLEGAL_PARAM;
+                }
+
+                std::unique_lock<std::mutex> lock(m_mu);
+                m_slice_split = *slice_split;
+                return TD_SUCCESS;
+            }
+
+            td_s32 get_roi_attr(td_u32 idx,ot_venc_roi_attr* roi_attr)
+            {
+                if(is_jpeg())
+                {
+                    return OT_ERR_VENC_NOT_SUPPORT;
+                }
+                if(idx >= OT_VENC_MAX_ROI_NUM)
+                {
+                    return OT_ERR_VENC_ILLEGAL_PARAM;
+                }
+
+                std::unique_lock<std::mutex> lock(m_mu);
+                *roi_attr = m_roi[idx];
+                return TD_SUCCESS;
+            }
+
+            td_s32 set_roi_attr(const ot_venc_roi_attr* roi_attr)
+            {
+                if(is_jpeg())
+                {
+                    return OT_ERR_VENC_NOT_SUPPORT;
+                }
+                if(roi_attr->idx >= OT_VENC_MAX_ROI_NUM)
+                {
+                    return OT_ERR_VENC_ILLEGAL_PARAM;
+                }
+
+                if(roi_attr->enable)
+                {
+                    const ot_rect& r = roi_attr->rect;
+                    bool qp_ok = roi_attr->is_abs_qp ? (roi_attr->qp >= 0 && roi_attr->qp <= 51) : (roi_attr->qp >= -51 && roi_attr->qp <= 51);
+                    bool aligned = r.x % 16 == 0 && r.y % 16 == 0 && r.width % 16 == 0 && r.height % 16 == 0;
+                    bool inside = r.x >= 0 && r.y >= 0 && r.width > 0 && r.height > 0
+                        && r.x + r.width <= m_attr.venc_attr.pic_width && r.y + r.height <= m_attr.venc_attr.pic_height;
+                    if(!qp_ok || !aligned || !inside)
+                    {
+                        return OT_ERR_VENC_ILLEGAL_PARAM;
+                    }
+                }
+
+                std::unique_lock<std::mutex> lock(m_mu);
+                m_roi[roi_attr->idx] = *roi_attr;
+                return TD_SUCCESS;
+            }
+
+            td_s32 set_jpeg_param(const ot_venc_jpeg_param* param)
+            {
+                if(!is_jpeg())
+                {
+                    return OT_ERR_VENC_NOT_SUPPORT;
+                }
+                if(param->qfactor < 1 || param->qfactor > 99)
+                {
+                    return OT_ERR_VENC_ILLEGAL_PARAM;
+                }
+
+                std::unique_lock<std::mutex> lock(m_mu);
+                m_jpeg_param = *param;
+                return TD_SUCCESS;
+            }
+
+        private:
+            typedef struct
+            {
+                uint32_t offset;
+                uint32_t len;
+                uint8_t type;
+                bool vcl;
+            }nalu_t;
+
+            typedef struct
+            {
+                std::vector<nalu_t> nalus;
+                uint32_t bytes;
+                bool key;
+            }au_t;
+
+            //what one get_stream returns,the whole access unit or in slice mode
+            //one slice with the parameter sets/sei ahead of it
+            typedef struct
+            {
+                size_t au;
+                uint32_t first;
+                uint32_t count;
+                uint32_t bytes;
+                bool end;
+                uint64_t pts;
+                uint32_t seq;
+            }frame_t;
+
+            uint32_t frame_rate()
+            {
+                td_u32 fr = 0;
+                switch(m_attr.rc_attr.rc_mode)
+                {
+                    case OT_VENC_RC_MODE_H264_CBR:
+                        fr = m_attr.rc_attr.h264_cbr.dst_frame_rate;
+                        break;
+                    case OT_VENC_RC_MODE_H264_AVBR:
+                        fr = m_attr.rc_attr.h264_avbr.dst_frame_rate;
+                        break;
+                    case OT_VENC_RC_MODE_H265_CBR:
+                        fr = m_attr.rc_attr.h265_cbr.dst_frame_rate;
+                        break;
+                    case OT_VENC_RC_MODE_H265_AVBR:
+                        fr = m_attr.rc_attr.h265_avbr.dst_frame_rate;
+                        break;
+                    case OT_VENC_RC_MODE_MJPEG_FIXQP:
+                        fr = m_attr.rc_attr.mjpeg_fixqp.dst_frame_rate;
+                        break;
+                    default:
+                        break;
+                }
+
+                return fr > 0 ? fr : SIM_DEFAULT_FRAME_RATE;
+            }
+
+            std::string find_file()
+            {
+                const char* ext = "h264";
+                if(is_jpeg())
+                {
+                    ext = "jpg";
+                }
+                else if(m_attr.venc_attr.type == OT_PT_H265)
+                {
+                    ext = "h265";
+                }
+
+                std::string dir = source_dir();
+                char file[512];
+                snprintf(file,sizeof(file),"%s/%ux%u.%s",dir.c_str(),m_attr.venc_attr.pic_width,m_attr.venc_attr.pic_height,ext);
+                if(access(file,R_OK) == 0)
+                {
+                    return file;
+                }
+
+                snprintf(file,sizeof(file),"%s/%s.%s",dir.c_str(),is_jpeg() ? "snap" : "stream",ext);
+                if(access(file,R_OK) == 0)
+                {
+                    return file;
+                }
+
+                printf("[%s]: venc chn %d has no %s source in %s\n",__FUNCTION__,m_chn,ext,dir.c_str());
+                return "";
+            }
+
+            bool load()
+            {
+                std::string file = find_file();
+                if(file.empty())
+                {
+                    return false;
+                }
+
+                FILE* f = fopen(file.c_str(),"rb");
+                if(!f)
+                {
+                    return false;
+                }
+                std::vector<uint8_t> raw;
+                uint8_t buf[65536];
+                size_t n;
+                while((n = fread(buf,1,sizeof(buf),f)) > 0)
+                {
+                    raw.insert(raw.end(),buf,buf + n);
+                }
+                fclose(f);
+
+                std::vector<uint8_t> es;
+                std::vector<au_t> aus;
+                size_t first_key = 0;
+                if(is_jpeg())
+                {
+                    if(raw.size() < 4 || raw[0] != 0xff || raw[1] != 0xd8)
+                    {
+                        printf("[%s]: %s is not a jpeg\n",__FUNCTION__,file.c_str());
+                        return false;
+                    }
+
+                    au_t au;
+                    au.nalus.push_back(nalu_t{0,(uint32_t)raw.size(),0,true});
+                    au.bytes = raw.size();
+                    au.key = true;
+                    aus.push_back(au);
+                    es.swap(raw);
+                }
+                else if(!split(raw,es,aus,&first_key))
+                {
+                    printf("[%s]: %s has no key frame\n",__FUNCTION__,file.c_str());
+                    return false;
+                }
+
+                std::unique_lock<std::mutex> lock(m_mu);
+                m_es.swap(es);
+                m_aus.swap(aus);
+                m_first_key = first_key;
+                m_next_au = first_key;
+                m_loaded_w = m_attr.venc_attr.pic_width;
+                m_loaded_h = m_attr.venc_attr.pic_height;
+                printf("[%s]: venc chn %d replays %s,%zu frames\n",__FUNCTION__,m_chn,file.c_str(),m_aus.size());
+                return true;
+            }
+
+            //split annex-b into access units,a vcl nalu that starts a picture or a
+            //parameter set/sei/aud after a vcl nalu begins the next unit
+            bool split(const std::vector<uint8_t>& raw,std::vector<uint8_t>& es,std::vector<au_t>& aus,size_t* first_key)
+            {
+                bool h265 = m_attr.venc_attr.type == OT_PT_H265;
+                std::vector<std::pair<size_t,size_t>> nals;
+                size_t i = 0;
+                size_t beg = SIZE_MAX;
+                while(i + 3 <= raw.size())
+                {
+                    if(raw[i] == 0 && raw[i + 1] == 0 && raw[i + 2] == 1)
+                    {
+                        if(beg != SIZE_MAX)
+                        {
+                            size_t end = i;
+                            while(end > beg && raw[end - 1] == 0)
+                            {
+                                end--;
+                            }
+                            nals.push_back(std::make_pair(beg,end));
+                        }
+                        i += 3;
+                        beg = i;
+                        continue;
+                    }
+                    i++;
+                }
+                if(beg != SIZE_MAX && beg < raw.size())
+                {
+                    nals.push_back(std::make_pair(beg,raw.size()));
+                }
+
+                au_t cur;
+                cur.bytes = 0;
+                cur.key = false;
+                bool has_vcl = false;
+                for(auto it = nals.begin(); it != nals.end(); it++)
+                {
+                    const uint8_t* p = &raw[it->first];
+                    size_t len = it->second - it->first;
+                    if(len < 3)
+                    {
+                        continue;
+                    }
+
+                    uint8_t type = h265 ? ((p[0] >> 1) & 0x3f) : (p[0] & 0x1f);
+                    bool vcl = h265 ? (type < 32) : (type >= 1 && type <= 5);
+                    bool first_slice = h265 ? ((p[2] & 0x80) != 0) : ((p[1] & 0x80) != 0);
+                    bool prefix = h265 ? (type >= 32 && type <= 39) : (type == 6 || type == 7 || type == 8 || type == 9);
+                    if(has_vcl && ((vcl && first_slice) || prefix))
+                    {
+                        aus.push_back(cur);
+                        cur.nalus.clear();
+                        cur.bytes = 0;
+                        cur.key = false;
+                        has_vcl = false;
+                    }
+
+                    nalu_t nalu;
+                    nalu.offset = es.size();
+                    nalu.len = len + 4;
+                    nalu.type = type;
+                    nalu.vcl = vcl;
+                    static const uint8_t start_code[4] = {0,0,0,1};
+                    es.insert(es.end(),start_code,start_code + 4);
+                    es.insert(es.end(),p,p + len);
+
+                    cur.nalus.push_back(nalu);
+                    cur.bytes += nalu.len;
+                    has_vcl = has_vcl || vcl;
+                    if(vcl && (h265 ? (type >= 16 && type <= 21) : (type == 5)))
+                    {
+                        cur.key = true;
+                    }
+                }
+                if(has_vcl)
+                {
+                    aus.push_back(cur);
+                }
+
+                for(size_t j = 0; j < aus.size(); j++)
+                {
+                    if(aus[j].key)
+                    {
+                        *first_key = j;
+                        return true;
+                    }
+                }
+
+                return false;
+            }
+
+            void clear_frames()
+            {
+                m_frames.clear();
+                m_queued_bytes = 0;
+                uint64_t val;
+                while(read(m_fd,&val,sizeof(val)) > 0)
+                {
+                }
+            }
+
+            //m_mu held
+            void push_frame(size_t au,uint64_t pts)
+            {
+                //the stream buffer is full,the frame is lost and the next one restarts the gop
+                if(m_queued_bytes + m_aus[au].bytes > m_attr.venc_attr.buf_size
+                        && !m_frames.empty())
+                {
+                    m_dropped++;
+                    m_idr = true;
+                    return;
+                }
+
+                const au_t& cur = m_aus[au];
+                bool by_slice = !m_attr.venc_attr.is_by_frame && !is_jpeg();
+                uint32_t first = 0;
+                uint32_t bytes = 0;
+                uint64_t units = 0;
+                for(uint32_t i = 0; i < cur.nalus.size(); i++)
+                {
+                    bytes += cur.nalus[i].len;
+                    bool last = i + 1 == cur.nalus.size();
+                    if(last || (by_slice && cur.nalus[i].vcl))
+                    {
+                        m_frames.push_back(frame_t{au,first,i + 1 - first,bytes,last,pts,m_seq++});
+                        first = i + 1;
+                        bytes = 0;
+                        units++;
+                    }
+                }
+                m_queued_bytes += cur.bytes;
+
+                if(write(m_fd,&units,sizeof(units)) < 0)
+                {
+                    printf("[%s]: venc chn %d eventfd write failed\n",__FUNCTION__,m_chn);
+                }
+                m_cv.notify_all();
+            }
+
+            void on_produce()
+            {
+                uint64_t next = now_us();
+
+                std::unique_lock<std::mutex> lock(m_mu);
+                while(m_running)
+                {
+                    uint64_t now = now_us();
+                    if(now < next)
+                    {
+                        m_cv.wait_for(lock,std::chrono::microseconds(next - now));
+                        continue;
+                    }
+
+                    size_t au = m_next_au;
+                    if(m_idr && !m_aus[au].key)
+                    {
+                        do
+                        {
+                            au = (au + 1) % m_aus.size();
+                        }while(!m_aus[au].key);
+                    }
+                    m_idr = false;
+
+                    push_frame(au,next);
+                    m_next_au = au + 1 < m_aus.size() ? au + 1 : m_first_key;
+
+                    uint64_t period = 1000000 / frame_rate();
+                    next += period;
+                    if(now_us() > next + period)
+                    {
+                        //stalled,do not burst to catch up
+                        next = now_us();
+                    }
+                }
+            }
+
+        private:
+            ot_venc_chn m_chn;
+            ot_venc_chn_attr m_attr;
+            ot_venc_jpeg_param m_jpeg_param;
+            ot_venc_slice_split m_slice_split;
+            ot_venc_roi_attr m_roi[OT_VENC_MAX_ROI_NUM];
+            int m_fd;
+
+            std::vector<uint8_t> m_es;
+            std::vector<au_t> m_aus;
+            td_u32 m_loaded_w;
+            td_u32 m_loaded_h;
+            size_t m_first_key;
+            size_t m_next_au;
+
+            std::deque<frame_t> m_frames;
+            uint32_t m_got;
+            uint32_t m_seq;
+            uint64_t m_queued_bytes;
+            uint64_t m_dropped;
+
+            bool m_running;
+            bool m_idr;
+            std::mutex m_mu;
+            std::condition_variable m_cv;
+            std::thread m_thd;
+    };
+
+    typedef std::shared_ptr<venc_sim> venc_sim_ptr;
+
+    static std::mutex g_venc_mu;
+    static std::map<ot_venc_chn,venc_sim_ptr> g_vencs;
+
+    static venc_sim_ptr find_venc(ot_venc_chn chn)
+    {
+        std::unique_lock<std::mutex> lock(g_venc_mu);
+        auto it = g_vencs.find(chn);
+        return it == g_vencs.end() ? nullptr : it->second;
+    }
+
+}}//namespace
+
+using namespace ceanic::sdk_sim;
+
+td_s32 ss_mpi_venc_create_chn(ot_venc_chn chn,const ot_venc_chn_attr* attr)
+{
+    if(chn < 0 || chn >= OT_VENC_MAX_CHN_NUM)
+    {
+        return OT_ERR_VENC_INVALID_CHN_ID;
+    }
+    if(!attr)
+    {
+        return OT_ERR_VENC_NULL_PTR;
+    }
+    if(attr->venc_attr.type != OT_PT_H264
+            && attr->venc_attr.type != OT_PT_H265
+            && attr->venc_attr.type != OT_PT_JPEG
+            && attr->venc_attr.type != OT_PT_MJPEG)
+    {
+        return OT_ERR_VENC_NOT_SUPPORT;
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(g_venc_mu);
+        if(g_vencs.count(chn))
+        {
+            return OT_ERR_VENC_EXIST;
+        }
+    }
+
+    venc_sim_ptr venc = std::make_shared<venc_sim>(chn,attr);
+    if(!venc->init())
+    {
+        return OT_ERR_VENC_NOT_SUPPORT;
+    }
+
+    std::unique_lock<std::mutex> lock(g_venc_mu);
+    if(g_vencs.count(chn))
+    {
+        return OT_ERR_VENC_EXIST;
+    }
+    g_vencs[chn] = venc;
+    return TD_SUCCESS;
+}
+
+td_s32 ss_mpi_venc_destroy_chn(ot_venc_chn chn)
+{
+    venc_sim_ptr venc;
+    {
+        std::unique_lock<std::mutex> lock(g_venc_mu);
+        auto it = g_vencs.find(chn);
+        if(it == g_vencs.end())
+        {
+            return OT_ERR_VENC_UNEXIST;
+        }
+        venc = it->second;
+        g_vencs.erase(it);
+    }
+
+    venc->stop();
+    return TD_SUCCESS;
+}
+
+td_s32 ss_mpi_venc_start_chn(ot_venc_chn chn,const ot_venc_start_param* recv_param)
+{
+    venc_sim_ptr venc = find_venc(chn);
+    if(!venc)
+    {
+        return OT_ERR_VENC_UNEXIST;
+    }
+    if(!recv_param)
+    {
+        return OT_ERR_VENC_NULL_PTR;
+    }
+
+    return venc->start();
+}
+
+td_s32 ss_mpi_venc_stop_chn(ot_venc_chn chn)
+{
+    venc_sim_ptr venc = find_venc(chn);
+    if(!venc)
+    {
+        return OT_ERR_VENC_UNEXIST;
+    }
+
+    venc->stop();
+    return TD_SUCCESS;
+}
+
+td_s32 ss_mpi_venc_get_chn_attr(ot_venc_chn chn,ot_venc_chn_attr* attr)
+{
+    venc_sim_ptr venc = find_venc(chn);
+    if(!venc)
+    {
+        return OT_ERR_VENC_UNEXIST;
+    }
+
+    return attr ? venc->get_attr(attr) : OT_ERR_VENC_NULL_PTR;
+}
+
+td_s32 ss_mpi_venc_set_chn_attr(ot_venc_chn chn,const ot_venc_chn_attr* attr)
+{
+    venc_sim_ptr venc = find_venc(chn);
+    if(!venc)
+    {
+        return OT_ERR_VENC_UNEXIST;
+    }
+
+    return attr ? venc->set_attr(attr) : OT_ERR_VENC_NULL_PTR;
+}
+
+td_s32 ss_mpi_venc_reset_chn(ot_venc_chn chn)
+{
+    venc_sim_ptr venc = find_venc(chn);
+    if(!venc)
+    {
+        return OT_ERR_VENC_UNEXIST;
+    }
+
+    return venc->reset();
+}
+
+td_s32 ss_mpi_venc_get_fd(ot_venc_chn chn)
+{
+    venc_sim_ptr venc = find_venc(chn);
+    return venc ? venc->fd() : OT_ERR_VENC_UNEXIST;
+}
+
+td_s32 ss_mpi_venc_query_status(ot_venc_chn chn,ot_venc_chn_status* status)
+{
+    venc_sim_ptr venc = find_venc(chn);
+    if(!venc)
+    {
+        return OT_ERR_VENC_UNEXIST;
+    }
+
+    return status ? venc->query(status) : OT_ERR_VENC_NULL_PTR;
+}
+
+td_s32 ss_mpi_venc_get_stream(ot_venc_chn chn,ot_venc_stream* stream,td_s32 milli_sec)
+{
+    venc_sim_ptr venc = find_venc(chn);
+    if(!venc)
+    {
+        return OT_ERR_VENC_UNEXIST;
+    }
+    if(!stream || !stream->pack)
+    {
+        return OT_ERR_VENC_NULL_PTR;
+    }
+
+    return venc->get_stream(stream,milli_sec);
+}
+
+td_s32 ss_mpi_venc_release_stream(ot_venc_chn chn,const ot_venc_stream* stream)
+{
+    venc_sim_ptr venc = find_venc(chn);
+    if(!venc)
+    {
+        return OT_ERR_VENC_UNEXIST;
+    }
+
+    return stream ? venc->release_stream(stream) : OT_ERR_VENC_NULL_PTR;
+}
+
+td_s32 ss_mpi_venc_request_idr(ot_venc_chn chn,td_bool instant)
+{
+    (void)instant;
+
+    venc_sim_ptr venc = find_venc(chn);
+    if(!venc)
+    {
+        return OT_ERR_VENC_UNEXIST;
+    }
+
+    venc->request_idr();
+    return TD_SUCCESS;
+}
+
+td_s32 ss_mpi_venc_send_frame(ot_venc_chn chn,const ot_video_frame_info* frame,td_s32 milli_sec)
+{
+    (void)milli_sec;
+
+    venc_sim_ptr venc = find_venc(chn);
+    if(!venc)
+    {
+        return OT_ERR_VENC_UNEXIST;
+    }
+
+    return frame ? venc->send_frame(frame) : OT_ERR_VENC_NULL_PTR;
+}
+
+td_s32 ss_mpi_venc_get_jpeg_param(ot_venc_chn chn,ot_venc_jpeg_param* jpeg_param)
+{
+    venc_sim_ptr venc = find_venc(chn);
+    if(!venc)
+    {
+        return OT_ERR_VENC_UNEXIST;
+    }
+
+    return jpeg_param ? venc->get_jpeg_param(jpeg_param) : OT_ERR_VENC_NULL_PTR;
+}
+
+td_s32 ss_mpi_venc_set_jpeg_param(ot_venc_chn chn,const ot_venc_jpeg_param* jpeg_param)
+{
+    venc_sim_ptr venc = find_venc(chn);
+    if(!venc)
+    {
+        return OT_ERR_VENC_UNEXIST;
+    }
+
+    return jpeg_param ? venc->set_jpeg_param(jpeg_param) : OT_ERR_VENC_NULL_PTR;
+}
+
+td_s32 ss_mpi_venc_get_slice_split(ot_venc_chn chn,ot_venc_slice_split* slice_split)
+{
+    venc_sim_ptr venc = find_venc(chn);
+    if(!venc)
+    {
+        return OT_ERR_VENC_UNEXIST;
+    }
+
+    return slice_split ? venc->get_slice_split(slice_split) : OT_ERR_VENC_NULL_PTR;
+}
+
+td_s32 ss_mpi_venc_set_slice_split(ot_venc_chn chn,const ot_venc_slice_split* slice_split)
+{
+    venc_sim_ptr venc = find_venc(chn);
+    if(!venc)
+    {
+        return OT_ERR_VENC_UNEXIST;
+    }
+
+    return slice_split ? venc->set_slice_split(slice_split) : OT_ERR_VENC_NULL_PTR;
+}
+
+td_s32 ss_mpi_venc_get_roi_attr(ot_venc_chn chn,td_u32 idx,ot_venc_roi_attr* roi_attr)
+{
+    venc_sim_ptr venc = find_venc(chn);
+    if(!venc)
+    {
+        return OT_ERR_VENC_UNEXIST;
+    }
+
+    return roi_attr ? venc->get_roi_attr(idx,roi_attr) : OT_ERR_VENC_NULL_PTR;
+}
+
+td_s32 ss_mpi_venc_set_roi_attr(ot_venc_chn chn,const ot_venc_roi_attr* roi_attr)
+{
+    venc_sim_ptr venc = find_venc(chn);
+    if(!venc)
+    {
+        return OT_ERR_VENC_UNEXIST;
+    }
+
+    return roi_attr ? venc->set_roi_attr(roi_attr) : OT_ERR_VENC_NULL_PTR;
+}
@@ -0,0 +1,486 @@
+#include "sim_common.h"
+#include "ss_mpi_vpss.h"
+#include <string.h>
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace ceanic{namespace sdk_sim{
+
+#define SIM_VPSS_PRIVATE_BLK_CNT 4
+#define SIM_ROUND_UP(x,a) (((x) + (a) - 1) / (a) * (a))
+
+    typedef struct
+    {
+        bool is_set;
+        bool is_enable;
+        ot_vpss_chn_attr attr;
+        ot_low_delay_info low_delay;
+        ot_vb_src vb_src;
+        ot_vb_pool user_pool;
+        ot_vb_pool private_pool;
+        uint64_t private_blk_size;
+        uint64_t next_us;
+        uint32_t frame_cnt;
+    }vpss_chn_t;
+
+    typedef struct
+    {
+        ot_vpss_grp_attr attr;
+        bool is_start;
+        vpss_chn_t chn[OT_VPSS_MAX_PHYS_CHN_NUM];
+        vpss_chn_t grp_chn;
+    }vpss_grp_t;
+
+    static std::mutex g_vpss_mu;
+    static std::map<ot_vpss_grp,vpss_grp_t> g_vpss_grps;
+
+    static void init_chn(vpss_chn_t& c)
+    {
+        memset(&c,0,sizeof(c));
+        c.vb_src = OT_VB_SRC_COMMON;
+        c.user_pool = OT_VB_INVALID_POOL_ID;
+        c.private_pool = OT_VB_INVALID_POOL_ID;
+    }
+
+    static void free_chn_pool(vpss_chn_t& c)
+    {
+        if(c.private_pool != OT_VB_INVALID_POOL_ID)
+        {
+            vb_destroy_private_pool(c.private_pool);
+            c.private_pool = OT_VB_INVALID_POOL_ID;
+        }
+    }
+
+    static uint32_t dst_frame_rate(const ot_frame_rate_ctrl& grp,const ot_frame_rate_ctrl& chn)
+    {
+        int32_t fr = grp.dst_frame_rate > 0 ? grp.dst_frame_rate : SIM_DEFAULT_FRAME_RATE;
+        if(chn.dst_frame_rate > 0 && chn.dst_frame_rate < fr)
+        {
+            fr = chn.dst_frame_rate;
+        }
+        return fr;
+    }
+
+    //moving luma gradient with a white box crossing the picture,so motion and scene
+    //consumers have something to look at
+    static void draw_pattern(uint8_t* y,uint8_t* uv,uint32_t w,uint32_t h,uint32_t stride,uint32_t n)
+    {
+        for(uint32_t i = 0; i < h; i++)
+        {
+            uint8_t* line = y + (uint64_t)i * stride;
+            for(uint32_t j = 0; j < w; j++)
+            {
+                line[j] = (uint8_t)(16 + ((j + i + n * 4) & 0x7f));
+            }
+        }
+
+        uint32_t box = h / 8 > 0 ? h / 8 : 1;
+        uint32_t span = w > box ? w - box : 1;
+        uint32_t x0 = (n * 8) % span;
+        uint32_t y0 = (h - box) / 2;
+        for(uint32_t i = y0; i < y0 + box && i < h; i++)
+        {
+            memset(y + (uint64_t)i * stride + x0,235,box < w ? box : w);
+        }
+
+        memset(uv,128,(uint64_t)stride * (h / 2));
+    }
+
+    //g_vpss_mu held,waits outside the lock until the channel's next frame time
+    static td_s32 get_frame(ot_vpss_grp grp,vpss_chn_t* c,uint32_t w,uint32_t h,uint32_t fr,
+            std::unique_lock<std::mutex>& lock,ot_video_frame_info* frame_info,td_s32 milli_sec)
+    {
+        uint64_t now = now_us();
+        uint64_t period = 1000000 / fr;
+        if(c->next_us == 0 || now > c->next_us + period)
+        {
+            //first frame or the consumer fell behind,do not burst
+            c->next_us = now;
+        }
+
+        if(c->next_us > now)
+        {
+            uint64_t wait = c->next_us - now;
+            if(milli_sec >= 0 && wait > (uint64_t)milli_sec * 1000)
+            {
+                lock.unlock();
+                std::this_thread::sleep_for(std::chrono::milliseconds(milli_sec));
+                lock.lock();
+                return OT_ERR_VPSS_BUF_EMPTY;
+            }
+
+            lock.unlock();
+            std::this_thread::sleep_for(std::chrono::microseconds(wait));
+            lock.lock();
+
+            //the group may be gone while sleeping
+            auto it = g_vpss_grps.find(grp);
+            if(it == g_vpss_grps.end() || !it->second.is_start
+                    || (c != &it->second.grp_chn && (c < it->second.chn || c >= it->second.chn + OT_VPSS_MAX_PHYS_CHN_NUM)))
+            {
+                return OT_ERR_VPSS_NOT_PERM;
+            }
+        }
+
+        uint32_t stride = SIM_ROUND_UP(w,16);
+        uint64_t blk_size = (uint64_t)stride * h * 3 / 2;
+        ot_vb_pool pool = c->user_pool;
+        if(pool == OT_VB_INVALID_POOL_ID)
+        {
+            if(c->private_pool != OT_VB_INVALID_POOL_ID && c->private_blk_size < blk_size)
+            {
+                free_chn_pool(*c);
+            }
+            if(c->private_pool == OT_VB_INVALID_POOL_ID)
+            {
+                c->private_pool = vb_create_private_pool(blk_size,SIM_VPSS_PRIVATE_BLK_CNT);
+                c->private_blk_size = blk_size;
+            }
+            pool = c->private_pool;
+        }
+
+        td_phys_addr_t phys;
+        void* virt;
+        if(!vb_get_block(pool,&phys,&virt))
+        {
+            return OT_ERR_VPSS_NO_BUF;
+        }
+
+        uint8_t* y = (uint8_t*)virt;
+        uint8_t* uv = y + (uint64_t)stride * h;
+        draw_pattern(y,uv,w,h,stride,c->frame_cnt);
+
+        memset(frame_info,0,sizeof(*frame_info));
+        ot_video_frame& f = frame_info->video_frame;
+        f.width = w;
+        f.height = h;
+        f.pixel_format = OT_PIXEL_FORMAT_YVU_SEMIPLANAR_420;
+        f.video_format = OT_VIDEO_FORMAT_LINEAR;
+        f.compress_mode = OT_COMPRESS_MODE_NONE;
+        f.dynamic_range = OT_DYNAMIC_RANGE_SDR8;
+        f.stride[0] = stride;
+        f.stride[1] = stride;
+        f.phys_addr[0] = phys;
+        f.phys_addr[1] = phys + (uint64_t)stride * h;
+        f.virt_addr[0] = y;
+        f.virt_addr[1] = uv;
+        f.time_ref = c->frame_cnt * 2;
+        f.pts = c->next_us;
+        frame_info->pool_id = pool;
+        frame_info->mod_id = OT_ID_VPSS;
+
+        c->frame_cnt++;
+        c->next_us += period;
+        return TD_SUCCESS;
+    }
+
+}}//namespace
+
+using namespace ceanic::sdk_sim;
+
+static vpss_chn_t* find_chn(ot_vpss_grp grp,ot_vpss_chn chn,td_s32* err)
+{
+    auto it = g_vpss_grps.find(grp);
+    if(it == g_vpss_grps.end())
+    {
+        *err = OT_ERR_VPSS_UNEXIST;
+        return nullptr;
+    }
+    if(chn < 0 || chn >= OT_VPSS_MAX_PHYS_CHN_NUM)
+    {
+        *err = OT_ERR_VPSS_INVALID_CHN_ID;
+        return nullptr;
+    }
+
+    return &it->second.chn[chn];
+}
+
+td_s32 ss_mpi_vpss_create_grp(ot_vpss_grp grp,const ot_vpss_grp_attr* grp_attr)
+{
+    if(grp < 0 || grp >= OT_VPSS_MAX_GRP_NUM)
+    {
+        return OT_ERR_VPSS_INVALID_DEV_ID;
+    }
+    if(!grp_attr)
+    {
+        return OT_ERR_VPSS_NULL_PTR;
+    }
+    if(grp_attr->max_width == 0 || grp_attr->max_height == 0)
+    {
+        return OT_ERR_VPSS_ILLEGAL_PARAM;
+    }
+
+    std::unique_lock<std::mutex> lock(g_vpss_mu);
+    if(g_vpss_grps.count(grp))
+    {
+        return OT_ERR_VPSS_EXIST;
+    }
+
+    vpss_grp_t& g = g_vpss_grps[grp];
+    g.attr = *grp_attr;
+    g.is_start = false;
+    for(int i = 0; i < OT_VPSS_MAX_PHYS_CHN_NUM; i++)
+    {
+        init_chn(g.chn[i]);
+    }
+    init_chn(g.grp_chn);
+    return TD_SUCCESS;
+}
+
+td_s32 ss_mpi_vpss_destroy_grp(ot_vpss_grp grp)
+{
+    std::unique_lock<std::mutex> lock(g_vpss_mu);
+    auto it = g_vpss_grps.find(grp);
+    if(it == g_vpss_grps.end())
+    {
+        return OT_ERR_VPSS_UNEXIST;
+    }
+    if(it->second.is_start)
+    {
+        return OT_ERR_VPSS_NOT_PERM;
+    }
+
+    for(int i = 0; i < OT_VPSS_MAX_PHYS_CHN_NUM; i++)
+    {
+        free_chn_pool(it->second.chn[i]);
+    }
+    free_chn_pool(it->second.grp_chn);
+    g_vpss_grps.erase(it);
+    return TD_SUCCESS;
+}
+
+td_s32 ss_mpi_vpss_start_grp(ot_vpss_grp grp)
+{
+    std::unique_lock<std::mutex> lock(g_vpss_mu);
+    auto it = g_vpss_grps.find(grp);
+    if(it == g_vpss_grps.end())
+    {
+        return OT_ERR_VPSS_UNEXIST;
+    }
+
+    it->second.is_start = true;
+    return TD_SUCCESS;
+}
+
+td_s32 ss_mpi_vpss_stop_grp(ot_vpss_grp grp)
+{
+    std::unique_lock<std::mutex> lock(g_vpss_mu);
+    auto it = g_vpss_grps.find(grp);
+    if(it == g_vpss_grps.end())
+    {
+        return OT_ERR_VPSS_UNEXIST;
+    }
+
+    it->second.is_start = false;
+    return TD_SUCCESS;
+}
+
+td_s32 ss_mpi_vpss_set_chn_attr(ot_vpss_grp grp,ot_vpss_chn chn,const ot_vpss_chn_attr* chn_attr)
+{
+    if(!chn_attr)
+    {
+        return OT_ERR_VPSS_NULL_PTR;
+    }
+
+    std::unique_lock<std::mutex> lock(g_vpss_mu);
+    td_s32 ret = TD_SUCCESS;
+    vpss_chn_t* c = find_chn(grp,chn,&ret);
+    if(!c)
+    {
+        return ret;
+    }
+    if(chn_attr->width == 0 || chn_attr->height == 0)
+    {
+        return OT_ERR_VPSS_ILLEGAL_PARAM;
+    }
+
+    c->attr = *chn_attr;
+    c->is_set = true;
+    return TD_SUCCESS;
+}
+
+td_s32 ss_mpi_vpss_get_chn_attr(ot_vpss_grp grp,ot_vpss_chn chn,ot_vpss_chn_attr* chn_attr)
+{
+    if(!chn_attr)
+    {
+        return OT_ERR_VPSS_NULL_PTR;
+    }
+
+    std::unique_lock<std::mutex> lock(g_vpss_mu);
+    td_s32 ret = TD_SUCCESS;
+    vpss_chn_t* c = find_chn(grp,chn,&ret);
+    if(!c)
+    {
+        return ret;
+    }
+    if(!c->is_set)
+    {
+        return OT_ERR_VPSS_NOT_PERM;
+    }
+
+    *chn_attr = c->attr;
+    return TD_SUCCESS;
+}
+
+td_s32 ss_mpi_vpss_enable_chn(ot_vpss_grp grp,ot_vpss_chn chn)
+{
+    std::unique_lock<std::mutex> lock(g_vpss_mu);
+    td_s32 ret = TD_SUCCESS;
+    vpss_chn_t* c = find_chn(grp,chn,&ret);
+    if(!c)
+    {
+        return ret;
+    }
+    if(!c->is_set)
+    {
+        return OT_ERR_VPSS_NOT_PERM;
+    }
+
+    c->is_enable = true;
+    c->next_us = 0;
+    return TD_SUCCESS;
+}
+
+td_s32 ss_mpi_vpss_disable_chn(ot_vpss_grp grp,ot_vpss_chn chn)
+{
+    std::unique_lock<std::mutex> lock(g_vpss_mu);
+    td_s32 ret = TD_SUCCESS;
+    vpss_chn_t* c = find_chn(grp,chn,&ret);
+    if(!c)
+    {
+        return ret;
+    }
+
+    c->is_enable = false;
+    return TD_SUCCESS;
+}
+
+td_s32 ss_mpi_vpss_set_chn_low_delay(ot_vpss_grp grp,ot_vpss_chn chn,const ot_low_delay_info* low_delay_info)
+{
+    if(!low_delay_info)
+    {
+        return OT_ERR_VPSS_NULL_PTR;
+    }
+
+    std::unique_lock<std::mutex> lock(g_vpss_mu);
+    td_s32 ret = TD_SUCCESS;
+    vpss_chn_t* c = find_chn(grp,chn,&ret);
+    if(!c)
+    {
+        return ret;
+    }
+
+    c->low_delay = *low_delay_info;
+    return TD_SUCCESS;
+}
+
+td_s32 ss_mpi_vpss_set_chn_vb_src(ot_vpss_grp grp,ot_vpss_chn chn,ot_vb_src vb_src)
+{
+    std::unique_lock<std::mutex> lock(g_vpss_mu);
+    td_s32 ret = TD_SUCCESS;
+    vpss_chn_t* c = find_chn(grp,chn,&ret);
+    if(!c)
+    {
+        return ret;
+    }
+
+    c->vb_src = vb_src;
+    return TD_SUCCESS;
+}
+
+td_s32 ss_mpi_vpss_attach_chn_vb_pool(ot_vpss_grp grp,ot_vpss_chn chn,ot_vb_pool vb_pool)
+{
+    std::unique_lock<std::mutex> lock(g_vpss_mu);
+    td_s32 ret = TD_SUCCESS;
+    vpss_chn_t* c = find_chn(grp,chn,&ret);
+    if(!c)
+    {
+        return ret;
+    }
+    if(c->vb_src != OT_VB_SRC_USER)
+    {
+        return OT_ERR_VPSS_NOT_PERM;
+    }
+
+    c->user_pool = vb_pool;
+    return TD_SUCCESS;
+}
+
+td_s32 ss_mpi_vpss_get_chn_frame(ot_vpss_grp grp,ot_vpss_chn chn,ot_video_frame_info* frame_info,td_s32 milli_sec)
+{
+    if(!frame_info)
+    {
+        return OT_ERR_VPSS_NULL_PTR;
+    }
+
+    std::unique_lock<std::mutex> lock(g_vpss_mu);
+    td_s32 ret = TD_SUCCESS;
+    vpss_chn_t* c = find_chn(grp,chn,&ret);
+    if(!c)
+    {
+        return ret;
+    }
+
+    vpss_grp_t& g = g_vpss_grps[grp];
+    if(!g.is_start || !c->is_enable)
+    {
+        return OT_ERR_VPSS_NOT_PERM;
+    }
+
+    return get_frame(grp,c,c->attr.width,c->attr.height,dst_frame_rate(g.attr.frame_rate,c->attr.frame_rate),
+            lock,frame_info,milli_sec);
+}
+
+td_s32 ss_mpi_vpss_release_chn_frame(ot_vpss_grp grp,ot_vpss_chn chn,const ot_video_frame_info* frame_info)
+{
+    (void)grp;
+    (void)chn;
+
+    if(!frame_info)
+    {
+        return OT_ERR_VPSS_NULL_PTR;
+    }
+
+    vb_release_block(frame_info->video_frame.phys_addr[0]);
+    return TD_SUCCESS;
+}
+
+td_s32 ss_mpi_vpss_get_grp_frame(ot_vpss_grp grp,ot_video_frame_info* frame_info,td_s32 milli_sec)
+{
+    if(!frame_info)
+    {
+        return OT_ERR_VPSS_NULL_PTR;
+    }
+
+    std::unique_lock<std::mutex> lock(g_vpss_mu);
+    auto it = g_vpss_grps.find(grp);
+    if(it == g_vpss_grps.end())
+    {
+        return OT_ERR_VPSS_UNEXIST;
+    }
+    if(!it->second.is_start)
+    {
+        return OT_ERR_VPSS_NOT_PERM;
+    }
+
+    vpss_grp_t& g = it->second;
+    return get_frame(grp,&g.grp_chn,g.attr.max_width,g.attr.max_height,dst_frame_rate(g.attr.frame_rate,g.attr.frame_rate),
+            lock,frame_info,milli_sec);
+}
+
+td_s32 ss_mpi_vpss_release_grp_frame(ot_vpss_grp grp,const ot_video_frame_info* frame_info)
+{
+    (void)grp;
+
+    if(!frame_info)
+    {
+        return OT_ERR_VPSS_NULL_PTR;
+    }
+
+    vb_release_block(frame_info->video_frame.phys_addr[0]);
+    return TD_SUCCESS;
+}
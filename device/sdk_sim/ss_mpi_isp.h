@@ -0,0 +1,12 @@
+#pragma once
+
+#include "ot_common.h"
+
+//isp is not emulated,only the attributes kept by dev_vi_isp.h are declared
+
+typedef struct
+{
+    ot_rect wnd_rect;
+    ot_size sns_size;
+    td_float frame_rate;
+}ot_isp_pub_attr;
@@ -0,0 +1,107 @@
+#pragma once
+
+#include "ot_common.h"
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+#define OT_ERR_RGN_INVALID_CHN_ID OT_DEF_ERR(OT_ID_RGN,OT_ERR_LEVEL_ERROR,OT_ERR_INVALID_CHN_ID)
+#define OT_ERR_RGN_ILLEGAL_PARAM OT_DEF_ERR(OT_ID_RGN,OT_ERR_LEVEL_ERROR,OT_ERR_ILLEGAL_PARAM)
+#define OT_ERR_RGN_EXIST OT_DEF_ERR(OT_ID_RGN,OT_ERR_LEVEL_ERROR,OT_ERR_EXIST)
+#define OT_ERR_RGN_UNEXIST OT_DEF_ERR(OT_ID_RGN,OT_ERR_LEVEL_ERROR,OT_ERR_UNEXIST)
+#define OT_ERR_RGN_NULL_PTR OT_DEF_ERR(OT_ID_RGN,OT_ERR_LEVEL_ERROR,OT_ERR_NULL_PTR)
+#define OT_ERR_RGN_NOT_SUPPORT OT_DEF_ERR(OT_ID_RGN,OT_ERR_LEVEL_ERROR,OT_ERR_NOT_SUPPORT)
+#define OT_ERR_RGN_NO_MEM OT_DEF_ERR(OT_ID_RGN,OT_ERR_LEVEL_ERROR,OT_ERR_NO_MEM)
+
+typedef enum
+{
+    OT_RGN_OVERLAY = 0,
+    OT_RGN_COVER,
+    OT_RGN_OVERLAYEX,
+    OT_RGN_COVEREX,
+    OT_RGN_LINE,
+    OT_RGN_MOSAIC,
+    OT_RGN_MOSAICEX,
+    OT_RGN_CORNER_RECTEX,
+    OT_RGN_BUTT,
+}ot_rgn_type;
+
+typedef enum
+{
+    OT_RGN_ATTACH_JPEG_MAIN = 0,
+    OT_RGN_ATTACH_JPEG_MPF0,
+    OT_RGN_ATTACH_JPEG_MPF1,
+    OT_RGN_ATTACH_JPEG_BUTT,
+}ot_rgn_attach_dst;
+
+typedef struct
+{
+    ot_pixel_format pixel_format;
+    td_u32 bg_color;
+    ot_size size;
+    td_u32 canvas_num;
+}ot_rgn_overlay_attr;
+
+typedef union
+{
+    ot_rgn_overlay_attr overlay;
+}ot_rgn_type_attr;
+
+typedef struct
+{
+    ot_rgn_type type;
+    ot_rgn_type_attr attr;
+}ot_rgn_attr;
+
+typedef struct
+{
+    td_bool enable;
+    td_bool is_abs_qp;
+    td_s32 qp_val;
+}ot_rgn_overlay_qp_info;
+
+typedef struct
+{
+    ot_point point;
+    td_u32 fg_alpha;
+    td_u32 bg_alpha;
+    td_u32 layer;
+    ot_rgn_overlay_qp_info qp_info;
+    ot_rgn_attach_dst dst;
+}ot_rgn_overlay_chn_attr;
+
+typedef union
+{
+    ot_rgn_overlay_chn_attr overlay_chn;
+}ot_rgn_type_chn_attr;
+
+typedef struct
+{
+    td_bool is_show;
+    ot_rgn_type type;
+    ot_rgn_type_chn_attr attr;
+}ot_rgn_chn_attr;
+
+typedef struct
+{
+    td_phys_addr_t phys_addr;
+    td_void* virt_addr;
+    ot_size size;
+    td_u32 stride;
+    ot_pixel_format pixel_format;
+}ot_rgn_canvas_info;
+
+td_s32 ss_mpi_rgn_create(ot_rgn_handle handle,const ot_rgn_attr* rgn_attr);
+td_s32 ss_mpi_rgn_destroy(ot_rgn_handle handle);
+td_s32 ss_mpi_rgn_attach_to_chn(ot_rgn_handle handle,const ot_mpp_chn* chn,const ot_rgn_chn_attr* chn_attr);
+td_s32 ss_mpi_rgn_detach_from_chn(ot_rgn_handle handle,const ot_mpp_chn* chn);
+td_s32 ss_mpi_rgn_set_display_attr(ot_rgn_handle handle,const ot_mpp_chn* chn,const ot_rgn_chn_attr* chn_attr);
+
+//canvases are plain memory,get returns the back canvas and update makes it the shown one
+td_s32 ss_mpi_rgn_get_canvas_info(ot_rgn_handle handle,ot_rgn_canvas_info* canvas_info);
+td_s32 ss_mpi_rgn_update_canvas(ot_rgn_handle handle);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "ot_common.h"
+#include "ss_mpi_vi.h"
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+#define OT_ERR_SYS_NULL_PTR OT_DEF_ERR(OT_ID_SYS,OT_ERR_LEVEL_ERROR,OT_ERR_NULL_PTR)
+#define OT_ERR_SYS_ILLEGAL_PARAM OT_DEF_ERR(OT_ID_SYS,OT_ERR_LEVEL_ERROR,OT_ERR_ILLEGAL_PARAM)
+#define OT_ERR_SYS_NOT_READY OT_DEF_ERR(OT_ID_SYS,OT_ERR_LEVEL_ERROR,OT_ERR_NOT_READY)
+#define OT_ERR_SYS_NO_MEM OT_DEF_ERR(OT_ID_SYS,OT_ERR_LEVEL_ERROR,OT_ERR_NO_MEM)
+#define OT_ERR_SYS_EXIST OT_DEF_ERR(OT_ID_SYS,OT_ERR_LEVEL_ERROR,OT_ERR_EXIST)
+#define OT_ERR_SYS_UNEXIST OT_DEF_ERR(OT_ID_SYS,OT_ERR_LEVEL_ERROR,OT_ERR_UNEXIST)
+
+typedef enum
+{
+    OT_3DNR_POS_VI = 0,
+    OT_3DNR_POS_VPSS,
+    OT_3DNR_POS_BUTT,
+}ot_3dnr_pos_type;
+
+td_s32 ss_mpi_sys_init(td_void);
+td_s32 ss_mpi_sys_exit(td_void);
+td_s32 ss_mpi_sys_set_vi_vpss_mode(const ot_vi_vpss_mode* vi_vpss_mode);
+td_s32 ss_mpi_sys_set_vi_aiisp_mode(ot_vi_pipe vi_pipe,ot_vi_aiisp_mode mode);
+td_s32 ss_mpi_sys_set_3dnr_pos(ot_3dnr_pos_type pos);
+
+//mmz is plain heap memory,the "physical" address is the virtual one
+td_s32 ss_mpi_sys_mmz_alloc(td_phys_addr_t* phys_addr,td_void** virt_addr,const td_char* mmb,const td_char* zone,td_u32 len);
+td_s32 ss_mpi_sys_mmz_alloc_cached(td_phys_addr_t* phys_addr,td_void** virt_addr,const td_char* mmb,const td_char* zone,td_u32 len);
+td_s32 ss_mpi_sys_mmz_free(td_phys_addr_t phys_addr,const td_void* virt_addr);
+td_s32 ss_mpi_sys_mmz_flush_cache(td_phys_addr_t phys_addr,td_void* virt_addr,td_u32 size);
+td_void* ss_mpi_sys_mmap(td_phys_addr_t phys_addr,td_u32 size);
+td_void* ss_mpi_sys_mmap_cached(td_phys_addr_t phys_addr,td_u32 size);
+td_s32 ss_mpi_sys_munmap(const td_void* virt_addr,td_u32 size);
+
+#ifdef __cplusplus
+}
+#endif
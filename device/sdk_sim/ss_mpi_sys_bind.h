@@ -0,0 +1,15 @@
+#pragma once
+
+#include "ot_common.h"
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+td_s32 ss_mpi_sys_bind(const ot_mpp_chn* src_chn,const ot_mpp_chn* dest_chn);
+td_s32 ss_mpi_sys_unbind(const ot_mpp_chn* src_chn,const ot_mpp_chn* dest_chn);
+td_s32 ss_mpi_sys_get_bind_by_dest(const ot_mpp_chn* dest_chn,ot_mpp_chn* src_chn);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,3 @@
+#pragma once
+
+#include "ss_mpi_sys.h"
@@ -0,0 +1,88 @@
+#pragma once
+
+#include "ot_common.h"
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+#define OT_ERR_VB_NULL_PTR OT_DEF_ERR(OT_ID_VB,OT_ERR_LEVEL_ERROR,OT_ERR_NULL_PTR)
+#define OT_ERR_VB_ILLEGAL_PARAM OT_DEF_ERR(OT_ID_VB,OT_ERR_LEVEL_ERROR,OT_ERR_ILLEGAL_PARAM)
+#define OT_ERR_VB_UNEXIST OT_DEF_ERR(OT_ID_VB,OT_ERR_LEVEL_ERROR,OT_ERR_UNEXIST)
+#define OT_ERR_VB_NO_MEM OT_DEF_ERR(OT_ID_VB,OT_ERR_LEVEL_ERROR,OT_ERR_NO_MEM)
+#define OT_ERR_VB_NOT_PERM OT_DEF_ERR(OT_ID_VB,OT_ERR_LEVEL_ERROR,OT_ERR_NOT_PERM)
+
+#define OT_VB_SUPPLEMENT_JPEG_MASK 0x1
+#define OT_VB_SUPPLEMENT_BNR_MOT_MASK 0x2
+
+typedef enum
+{
+    OT_VB_REMAP_MODE_NONE = 0,
+    OT_VB_REMAP_MODE_NOCACHE,
+    OT_VB_REMAP_MODE_CACHED,
+    OT_VB_REMAP_MODE_BUTT,
+}ot_vb_remap_mode;
+
+typedef enum
+{
+    OT_VB_SRC_COMMON = 0,
+    OT_VB_SRC_MOD,
+    OT_VB_SRC_PRIVATE,
+    OT_VB_SRC_USER,
+    OT_VB_SRC_BUTT,
+}ot_vb_src;
+
+typedef enum
+{
+    OT_VB_UID_VI = 0,
+    OT_VB_UID_VO,
+    OT_VB_UID_VGS,
+    OT_VB_UID_VENC,
+    OT_VB_UID_VDEC,
+    OT_VB_UID_BUTT,
+}ot_vb_uid;
+
+typedef struct
+{
+    td_u64 blk_size;
+    td_u32 blk_cnt;
+    ot_vb_remap_mode remap_mode;
+    td_char mmz_name[32];
+}ot_vb_pool_cfg;
+
+typedef struct
+{
+    td_u32 max_pool_cnt;
+    ot_vb_pool_cfg common_pool[OT_VB_MAX_COMMON_POOLS];
+}ot_vb_cfg;
+
+typedef struct
+{
+    td_u32 supplement_cfg;
+}ot_vb_supplement_cfg;
+
+typedef struct
+{
+    td_u32 pool_id;
+    td_u32 blk_cnt;
+    td_u64 blk_size;
+    td_u64 pool_size;
+    td_phys_addr_t pool_phy_addr;
+    td_void* pool_virt_addr;
+}ot_vb_pool_info;
+
+td_s32 ss_mpi_vb_set_cfg(const ot_vb_cfg* vb_cfg);
+td_s32 ss_mpi_vb_set_supplement_cfg(const ot_vb_supplement_cfg* supplement_cfg);
+td_s32 ss_mpi_vb_init(td_void);
+td_s32 ss_mpi_vb_exit(td_void);
+td_s32 ss_mpi_vb_exit_mod_common_pool(ot_vb_uid vb_uid);
+
+//blocks of a pool are one contiguous allocation,as the sdk guarantees for pool_phy_addr
+ot_vb_pool ss_mpi_vb_create_pool(const ot_vb_pool_cfg* vb_pool_cfg);
+td_s32 ss_mpi_vb_destroy_pool(ot_vb_pool pool);
+td_s32 ss_mpi_vb_pool_share_all(ot_vb_pool pool);
+td_s32 ss_mpi_vb_get_pool_info(ot_vb_pool pool,ot_vb_pool_info* pool_info);
+
+#ifdef __cplusplus
+}
+#endif
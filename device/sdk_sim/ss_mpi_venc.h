@@ -0,0 +1,298 @@
+#pragma once
+
+#include "ot_common.h"
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+#define OT_ERR_VENC_INVALID_CHN_ID OT_DEF_ERR(OT_ID_VENC,OT_ERR_LEVEL_ERROR,OT_ERR_INVALID_CHN_ID)
+#define OT_ERR_VENC_ILLEGAL_PARAM OT_DEF_ERR(OT_ID_VENC,OT_ERR_LEVEL_ERROR,OT_ERR_ILLEGAL_PARAM)
+#define OT_ERR_VENC_EXIST OT_DEF_ERR(OT_ID_VENC,OT_ERR_LEVEL_ERROR,OT_ERR_EXIST)
+#define OT_ERR_VENC_UNEXIST OT_DEF_ERR(OT_ID_VENC,OT_ERR_LEVEL_ERROR,OT_ERR_UNEXIST)
+#define OT_ERR_VENC_NULL_PTR OT_DEF_ERR(OT_ID_VENC,OT_ERR_LEVEL_ERROR,OT_ERR_NULL_PTR)
+#define OT_ERR_VENC_NOT_SUPPORT OT_DEF_ERR(OT_ID_VENC,OT_ERR_LEVEL_ERROR,OT_ERR_NOT_SUPPORT)
+#define OT_ERR_VENC_NOT_PERM OT_DEF_ERR(OT_ID_VENC,OT_ERR_LEVEL_ERROR,OT_ERR_NOT_PERM)
+#define OT_ERR_VENC_NO_MEM OT_DEF_ERR(OT_ID_VENC,OT_ERR_LEVEL_ERROR,OT_ERR_NO_MEM)
+#define OT_ERR_VENC_BUF_EMPTY OT_DEF_ERR(OT_ID_VENC,OT_ERR_LEVEL_ERROR,OT_ERR_BUF_EMPTY)
+#define OT_ERR_VENC_BUF_FULL OT_DEF_ERR(OT_ID_VENC,OT_ERR_LEVEL_ERROR,OT_ERR_BUF_FULL)
+
+typedef enum
+{
+    OT_VENC_H264_NALU_B_SLICE = 0,
+    OT_VENC_H264_NALU_P_SLICE = 1,
+    OT_VENC_H264_NALU_I_SLICE = 2,
+    OT_VENC_H264_NALU_IDR_SLICE = 5,
+    OT_VENC_H264_NALU_SEI = 6,
+    OT_VENC_H264_NALU_SPS = 7,
+    OT_VENC_H264_NALU_PPS = 8,
+    OT_VENC_H264_NALU_BUTT,
+}ot_venc_h264_nalu_type;
+
+typedef enum
+{
+    OT_VENC_H265_NALU_B_SLICE = 0,
+    OT_VENC_H265_NALU_P_SLICE = 1,
+    OT_VENC_H265_NALU_I_SLICE = 2,
+    OT_VENC_H265_NALU_IDR_SLICE = 19,
+    OT_VENC_H265_NALU_VPS = 32,
+    OT_VENC_H265_NALU_SPS = 33,
+    OT_VENC_H265_NALU_PPS = 34,
+    OT_VENC_H265_NALU_SEI = 39,
+    OT_VENC_H265_NALU_BUTT,
+}ot_venc_h265_nalu_type;
+
+typedef enum
+{
+    OT_VENC_JPEG_PACK_ECS = 5,
+    OT_VENC_JPEG_PACK_APP = 6,
+    OT_VENC_JPEG_PACK_VDO = 7,
+    OT_VENC_JPEG_PACK_PIC = 8,
+    OT_VENC_JPEG_PACK_BUTT,
+}ot_venc_jpeg_pack_type;
+
+typedef union
+{
+    ot_venc_h264_nalu_type h264_type;
+    ot_venc_h265_nalu_type h265_type;
+    ot_venc_jpeg_pack_type jpeg_type;
+}ot_venc_data_type;
+
+typedef struct
+{
+    td_phys_addr_t phys_addr;
+    td_u8* addr;
+    td_u32 len;
+    td_u64 pts;
+    td_bool is_frame_end;
+    ot_venc_data_type data_type;
+    td_u32 offset;
+    td_u32 data_num;
+}ot_venc_pack;
+
+typedef struct
+{
+    ot_venc_pack* pack;
+    td_u32 pack_cnt;
+    td_u32 seq;
+}ot_venc_stream;
+
+typedef struct
+{
+    td_u32 left_pics;
+    td_u32 left_stream_bytes;
+    td_u32 left_stream_frames;
+    td_u32 cur_packs;
+    td_u32 left_recv_pics;
+    td_u32 left_enc_pics;
+    td_bool is_jpeg_snap_end;
+}ot_venc_chn_status;
+
+typedef struct
+{
+    td_bool rcn_ref_share_buf_en;
+    td_u32 frame_buf_ratio;
+}ot_venc_h264_attr;
+
+typedef struct
+{
+    td_bool rcn_ref_share_buf_en;
+    td_u32 frame_buf_ratio;
+}ot_venc_h265_attr;
+
+typedef struct
+{
+    td_u8 large_thumbnail_num;
+    ot_size large_thumbnail_size[2];
+}ot_venc_mpf_cfg;
+
+typedef enum
+{
+    OT_VENC_PIC_RECV_SINGLE = 0,
+    OT_VENC_PIC_RECV_MULTI,
+    OT_VENC_PIC_RECV_BUTT,
+}ot_venc_pic_recv_mode;
+
+typedef struct
+{
+    td_bool dcf_en;
+    ot_venc_mpf_cfg mpf_cfg;
+    ot_venc_pic_recv_mode recv_mode;
+}ot_venc_jpeg_attr;
+
+typedef struct
+{
+    ot_payload_type type;
+    td_u32 max_pic_width;
+    td_u32 max_pic_height;
+    td_u32 buf_size;
+    td_u32 profile;
+    td_bool is_by_frame;
+    td_u32 pic_width;
+    td_u32 pic_height;
+    union
+    {
+        ot_venc_h264_attr h264_attr;
+        ot_venc_h265_attr h265_attr;
+        ot_venc_jpeg_attr jpeg_attr;
+    };
+}ot_venc_attr;
+
+typedef enum
+{
+    OT_VENC_RC_MODE_H264_CBR = 1,
+    OT_VENC_RC_MODE_H264_VBR,
+    OT_VENC_RC_MODE_H264_AVBR,
+    OT_VENC_RC_MODE_H264_QVBR,
+    OT_VENC_RC_MODE_H264_CVBR,
+    OT_VENC_RC_MODE_H264_FIXQP,
+    OT_VENC_RC_MODE_H264_QPMAP,
+    OT_VENC_RC_MODE_MJPEG_CBR,
+    OT_VENC_RC_MODE_MJPEG_VBR,
+    OT_VENC_RC_MODE_MJPEG_FIXQP,
+    OT_VENC_RC_MODE_H265_CBR,
+    OT_VENC_RC_MODE_H265_VBR,
+    OT_VENC_RC_MODE_H265_AVBR,
+    OT_VENC_RC_MODE_H265_QVBR,
+    OT_VENC_RC_MODE_H265_CVBR,
+    OT_VENC_RC_MODE_H265_FIXQP,
+    OT_VENC_RC_MODE_H265_QPMAP,
+    OT_VENC_RC_MODE_BUTT,
+}ot_venc_rc_mode;
+
+typedef struct
+{
+    td_u32 gop;
+    td_u32 stats_time;
+    td_u32 src_frame_rate;
+    td_u32 dst_frame_rate;
+    td_u32 bit_rate;
+}ot_venc_h264_cbr;
+
+typedef struct
+{
+    td_u32 gop;
+    td_u32 stats_time;
+    td_u32 src_frame_rate;
+    td_u32 dst_frame_rate;
+    td_u32 max_bit_rate;
+}ot_venc_h264_avbr;
+
+typedef ot_venc_h264_cbr ot_venc_h265_cbr;
+typedef ot_venc_h264_avbr ot_venc_h265_avbr;
+
+typedef struct
+{
+    td_u32 src_frame_rate;
+    td_u32 dst_frame_rate;
+    td_u32 qfactor;
+}ot_venc_mjpeg_fixqp;
+
+typedef struct
+{
+    ot_venc_rc_mode rc_mode;
+    union
+    {
+        ot_venc_h264_cbr h264_cbr;
+        ot_venc_h264_avbr h264_avbr;
+        ot_venc_h265_cbr h265_cbr;
+        ot_venc_h265_avbr h265_avbr;
+        ot_venc_mjpeg_fixqp mjpeg_fixqp;
+    };
+}ot_venc_rc_attr;
+
+typedef enum
+{
+    OT_VENC_GOP_MODE_NORMAL_P = 0,
+    OT_VENC_GOP_MODE_DUAL_P,
+    OT_VENC_GOP_MODE_SMART_P,
+    OT_VENC_GOP_MODE_BUTT,
+}ot_venc_gop_mode;
+
+typedef struct
+{
+    td_s32 ip_qp_delta;
+}ot_venc_gop_normal_p;
+
+typedef struct
+{
+    ot_venc_gop_mode gop_mode;
+    union
+    {
+        ot_venc_gop_normal_p normal_p;
+    };
+}ot_venc_gop_attr;
+
+typedef struct
+{
+    ot_venc_attr venc_attr;
+    ot_venc_rc_attr rc_attr;
+    ot_venc_gop_attr gop_attr;
+}ot_venc_chn_attr;
+
+typedef struct
+{
+    td_s32 recv_pic_num;
+}ot_venc_start_param;
+
+typedef struct
+{
+    td_bool enable;
+    td_u32 split_mode; //0:by bits,1:by macroblock(ctu) rows
+    td_u32 split_size;
+}ot_venc_slice_split;
+
+typedef struct
+{
+    td_u32 qfactor;
+    td_u8 y_qt[64];
+    td_u8 cb_qt[64];
+    td_u8 cr_qt[64];
+    td_u32 mcu_per_ecs;
+}ot_venc_jpeg_param;
+
+#define OT_VENC_MAX_ROI_NUM 8
+typedef struct
+{
+    td_u32 idx;          //regions with a higher idx win where they overlap
+    td_bool enable;
+    td_bool is_abs_qp;
+    td_s32 qp;           //absolute 0..51 or relative -51..51
+    ot_rect rect;        //16 aligned,inside the picture
+}ot_venc_roi_attr;
+
+td_s32 ss_mpi_venc_create_chn(ot_venc_chn chn,const ot_venc_chn_attr* attr);
+td_s32 ss_mpi_venc_destroy_chn(ot_venc_chn chn);
+td_s32 ss_mpi_venc_start_chn(ot_venc_chn chn,const ot_venc_start_param* recv_param);
+td_s32 ss_mpi_venc_stop_chn(ot_venc_chn chn);
+td_s32 ss_mpi_venc_get_chn_attr(ot_venc_chn chn,ot_venc_chn_attr* attr);
+//rc and frame rate change on the fly,a new picture size needs the channel stopped and reset
+//and stays within max_pic_width/height
+td_s32 ss_mpi_venc_set_chn_attr(ot_venc_chn chn,const ot_venc_chn_attr* attr);
+//drops the frames not got yet,stopped channels only and after every got frame was released
+td_s32 ss_mpi_venc_reset_chn(ot_venc_chn chn);
+
+//readable while encoded frames are waiting,one get_stream consumes one frame(one slice when is_by_frame is false)
+td_s32 ss_mpi_venc_get_fd(ot_venc_chn chn);
+td_s32 ss_mpi_venc_query_status(ot_venc_chn chn,ot_venc_chn_status* status);
+//milli_sec: -1 block,0 no wait,>0 timeout
+td_s32 ss_mpi_venc_get_stream(ot_venc_chn chn,ot_venc_stream* stream,td_s32 milli_sec);
+td_s32 ss_mpi_venc_release_stream(ot_venc_chn chn,const ot_venc_stream* stream);
+td_s32 ss_mpi_venc_request_idr(ot_venc_chn chn,td_bool instant);
+td_s32 ss_mpi_venc_send_frame(ot_venc_chn chn,const ot_video_frame_info* frame,td_s32 milli_sec);
+
+td_s32 ss_mpi_venc_get_jpeg_param(ot_venc_chn chn,ot_venc_jpeg_param* jpeg_param);
+td_s32 ss_mpi_venc_set_jpeg_param(ot_venc_chn chn,const ot_venc_jpeg_param* jpeg_param);
+
+//the replayed stream keeps the slices of its file,the split is only recorded.
+//with is_by_frame false get_stream returns one slice at a time
+td_s32 ss_mpi_venc_get_slice_split(ot_venc_chn chn,ot_venc_slice_split* slice_split);
+td_s32 ss_mpi_venc_set_slice_split(ot_venc_chn chn,const ot_venc_slice_split* slice_split);
+
+//the regions are only recorded,the replayed stream does not change
+td_s32 ss_mpi_venc_get_roi_attr(ot_venc_chn chn,td_u32 idx,ot_venc_roi_attr* roi_attr);
+td_s32 ss_mpi_venc_set_roi_attr(ot_venc_chn chn,const ot_venc_roi_attr* roi_attr);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "ot_common.h"
+
+//vi is not emulated,only the attributes kept by dev_vi_isp.h are declared
+
+typedef enum
+{
+    OT_VI_OFFLINE_VPSS_OFFLINE = 0,
+    OT_VI_OFFLINE_VPSS_ONLINE,
+    OT_VI_ONLINE_VPSS_OFFLINE,
+    OT_VI_ONLINE_VPSS_ONLINE,
+    OT_VI_VPSS_MODE_BUTT,
+}ot_vi_vpss_mode_type;
+
+typedef struct
+{
+    ot_vi_vpss_mode_type mode[OT_VI_MAX_PIPE_NUM];
+}ot_vi_vpss_mode;
+
+typedef enum
+{
+    OT_VI_AIISP_MODE_DEFAULT = 0,
+    OT_VI_AIISP_MODE_AIBNR,
+    OT_VI_AIISP_MODE_AIDRC,
+    OT_VI_AIISP_MODE_BUTT,
+}ot_vi_aiisp_mode;
+
+typedef struct
+{
+    ot_size in_size;
+}ot_vi_dev_attr;
+
+typedef struct
+{
+    ot_vi_pipe pipe_id[OT_VI_MAX_PIPE_NUM];
+}ot_vi_wdr_fusion_grp_attr;
+
+typedef struct
+{
+    ot_size size;
+    ot_pixel_format pixel_format;
+    ot_compress_mode compress_mode;
+    ot_frame_rate_ctrl frame_rate_ctrl;
+}ot_vi_pipe_attr;
+
+typedef struct
+{
+    ot_size size;
+    ot_pixel_format pixel_format;
+    ot_dynamic_range dynamic_range;
+    ot_video_format video_format;
+    ot_compress_mode compress_mode;
+    td_bool mirror_en;
+    td_bool flip_en;
+    td_u32 depth;
+    ot_frame_rate_ctrl frame_rate_ctrl;
+}ot_vi_chn_attr;
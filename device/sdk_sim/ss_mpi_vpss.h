@@ -0,0 +1,90 @@
+#pragma once
+
+#include "ot_common.h"
+#include "ss_mpi_vb.h"
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+#define OT_ERR_VPSS_INVALID_DEV_ID OT_DEF_ERR(OT_ID_VPSS,OT_ERR_LEVEL_ERROR,OT_ERR_INVALID_DEV_ID)
+#define OT_ERR_VPSS_INVALID_CHN_ID OT_DEF_ERR(OT_ID_VPSS,OT_ERR_LEVEL_ERROR,OT_ERR_INVALID_CHN_ID)
+#define OT_ERR_VPSS_ILLEGAL_PARAM OT_DEF_ERR(OT_ID_VPSS,OT_ERR_LEVEL_ERROR,OT_ERR_ILLEGAL_PARAM)
+#define OT_ERR_VPSS_EXIST OT_DEF_ERR(OT_ID_VPSS,OT_ERR_LEVEL_ERROR,OT_ERR_EXIST)
+#define OT_ERR_VPSS_UNEXIST OT_DEF_ERR(OT_ID_VPSS,OT_ERR_LEVEL_ERROR,OT_ERR_UNEXIST)
+#define OT_ERR_VPSS_NULL_PTR OT_DEF_ERR(OT_ID_VPSS,OT_ERR_LEVEL_ERROR,OT_ERR_NULL_PTR)
+#define OT_ERR_VPSS_NOT_PERM OT_DEF_ERR(OT_ID_VPSS,OT_ERR_LEVEL_ERROR,OT_ERR_NOT_PERM)
+#define OT_ERR_VPSS_NO_BUF OT_DEF_ERR(OT_ID_VPSS,OT_ERR_LEVEL_ERROR,OT_ERR_NO_BUF)
+#define OT_ERR_VPSS_BUF_EMPTY OT_DEF_ERR(OT_ID_VPSS,OT_ERR_LEVEL_ERROR,OT_ERR_BUF_EMPTY)
+
+typedef enum
+{
+    OT_VPSS_DEI_MODE_OFF = 0,
+    OT_VPSS_DEI_MODE_ON,
+    OT_VPSS_DEI_MODE_AUTO,
+    OT_VPSS_DEI_MODE_BUTT,
+}ot_vpss_dei_mode;
+
+typedef enum
+{
+    OT_VPSS_CHN_MODE_AUTO = 0,
+    OT_VPSS_CHN_MODE_USER,
+    OT_VPSS_CHN_MODE_BUTT,
+}ot_vpss_chn_mode;
+
+typedef struct
+{
+    td_bool ie_en;
+    td_bool dci_en;
+    td_bool buf_share_en;
+    td_bool mcf_en;
+    td_u32 max_width;
+    td_u32 max_height;
+    td_u32 max_dei_width;
+    td_u32 max_dei_height;
+    ot_dynamic_range dynamic_range;
+    ot_pixel_format pixel_format;
+    ot_vpss_dei_mode dei_mode;
+    ot_vpss_chn buf_share_chn;
+    ot_frame_rate_ctrl frame_rate;
+}ot_vpss_grp_attr;
+
+typedef struct
+{
+    td_bool mirror_en;
+    td_bool flip_en;
+    td_bool border_en;
+    td_u32 width;
+    td_u32 height;
+    td_u32 depth;
+    ot_vpss_chn_mode chn_mode;
+    ot_video_format video_format;
+    ot_dynamic_range dynamic_range;
+    ot_pixel_format pixel_format;
+    ot_compress_mode compress_mode;
+    ot_frame_rate_ctrl frame_rate;
+    ot_aspect_ratio aspect_ratio;
+}ot_vpss_chn_attr;
+
+td_s32 ss_mpi_vpss_create_grp(ot_vpss_grp grp,const ot_vpss_grp_attr* grp_attr);
+td_s32 ss_mpi_vpss_destroy_grp(ot_vpss_grp grp);
+td_s32 ss_mpi_vpss_start_grp(ot_vpss_grp grp);
+td_s32 ss_mpi_vpss_stop_grp(ot_vpss_grp grp);
+
+td_s32 ss_mpi_vpss_set_chn_attr(ot_vpss_grp grp,ot_vpss_chn chn,const ot_vpss_chn_attr* chn_attr);
+td_s32 ss_mpi_vpss_get_chn_attr(ot_vpss_grp grp,ot_vpss_chn chn,ot_vpss_chn_attr* chn_attr);
+td_s32 ss_mpi_vpss_enable_chn(ot_vpss_grp grp,ot_vpss_chn chn);
+td_s32 ss_mpi_vpss_disable_chn(ot_vpss_grp grp,ot_vpss_chn chn);
+td_s32 ss_mpi_vpss_set_chn_low_delay(ot_vpss_grp grp,ot_vpss_chn chn,const ot_low_delay_info* low_delay_info);
+td_s32 ss_mpi_vpss_set_chn_vb_src(ot_vpss_grp grp,ot_vpss_chn chn,ot_vb_src vb_src);
+td_s32 ss_mpi_vpss_attach_chn_vb_pool(ot_vpss_grp grp,ot_vpss_chn chn,ot_vb_pool vb_pool);
+
+//frames are a synthetic nv21 test pattern paced at the group frame rate
+td_s32 ss_mpi_vpss_get_chn_frame(ot_vpss_grp grp,ot_vpss_chn chn,ot_video_frame_info* frame_info,td_s32 milli_sec);
+td_s32 ss_mpi_vpss_release_chn_frame(ot_vpss_grp grp,ot_vpss_chn chn,const ot_video_frame_info* frame_info);
+td_s32 ss_mpi_vpss_get_grp_frame(ot_vpss_grp grp,ot_video_frame_info* frame_info,td_s32 milli_sec);
+td_s32 ss_mpi_vpss_release_grp_frame(ot_vpss_grp grp,const ot_video_frame_info* frame_info);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,187 @@
+#ifndef JSON_SAX_H_INCLUDED
+# define JSON_SAX_H_INCLUDED
+
+# include "forwards.h"
+# include <string>
+
+namespace Json {
+
+   /** \brief Writes a <a HREF="http://www.json.org">JSON</a> document event by event, without a Value tree.
+    *
+    * The document is appended to a string owned by the caller. Clearing and reusing that string
+    * keeps its capacity, so a writer used for every frame allocates nothing once the string has
+    * grown to the largest document. Strings are escaped through a lookup table and numbers are
+    * formatted without the C locale, a ',' decimal point never reaches the output.
+    *
+    * Commas and colons are added by the writer. Calls that break the structure (a key outside of an
+    * object, a value where a key is expected, too many closes or more than maxDepth levels) are
+    * ignored and make isValid() return false.
+    *
+    * \code
+    * std::string buf;
+    * Json::SaxWriter w( buf );
+    * w.startObject().key( "frame" ).value( 42 ).key( "score" ).value( 0.87, 3 ).endObject();
+    * \endcode
+    * \sa PullParser, FastWriter
+    */
+   class JSON_API SaxWriter
+   {
+   public:
+      enum { maxDepth = 64 };
+
+      SaxWriter( std::string &out );
+
+      /// Clears the output (its capacity stays) and the state, for the next document.
+      void reset();
+
+      SaxWriter &startObject();
+      SaxWriter &endObject();
+      SaxWriter &startArray();
+      SaxWriter &endArray();
+
+      SaxWriter &key( const char *name );
+      SaxWriter &key( const char *name, size_t length );
+      SaxWriter &key( const std::string &name );
+
+      SaxWriter &value( const char *str );
+      SaxWriter &value( const char *str, size_t length );
+      SaxWriter &value( const std::string &str );
+      SaxWriter &value( bool b );
+      SaxWriter &value( int i );
+      SaxWriter &value( unsigned int u );
+      SaxWriter &value( long i );
+      SaxWriter &value( unsigned long u );
+      SaxWriter &value( long long i );
+      SaxWriter &value( unsigned long long u );
+      /// Shortest text that reads back to the same double, NaN and infinity are written as null.
+      SaxWriter &value( double d );
+      /// Fixed number of digits after the point (0-9), for scores, coordinates and rates.
+      SaxWriter &value( double d, int decimals );
+      SaxWriter &null();
+      /// An already serialized value, copied as it is.
+      SaxWriter &rawValue( const char *json, size_t length );
+
+      /// \c true once the top level value is closed and no call broke the structure.
+      bool isComplete() const;
+      bool isValid() const;
+      const std::string &output() const;
+
+   private:
+      bool beginValue();
+      void endValue();
+      void writeString( const char *str, size_t length );
+      void writeUInt( unsigned long long u, bool negative );
+
+      std::string &out_;
+      unsigned long long objectBits_;   // bit n set:level n is an object
+      unsigned long long countBits_;    // bit n set:level n has a member
+      int depth_;
+      bool afterKey_;
+      bool done_;
+      bool valid_;
+   };
+
+   /** \brief Iterates the tokens of a <a HREF="http://www.json.org">JSON</a> document without building a Value tree.
+    *
+    * The document is not copied, it has to stay valid while the parser is used. Keys and strings
+    * without escapes point into the document, the others are decoded into a buffer of the parser
+    * which is reused for every token. Numbers are converted on request, without the C locale.
+    *
+    * \code
+    * Json::PullParser p( doc, doc + len );
+    * while ( p.next() == Json::PullParser::tokenKey )
+    * {
+    *    if ( p.isKey( "frame" ) && p.next() == Json::PullParser::tokenNumber )
+    *       frame = p.asInt64();
+    *    else
+    *       p.skipValue();
+    * }
+    * \endcode
+    * \sa SaxWriter, Reader
+    */
+   class JSON_API PullParser
+   {
+   public:
+      enum TokenType
+      {
+         tokenEnd = 0,        ///< the document is complete
+         tokenError,          ///< see error(), every later next() returns it too
+         tokenObjectBegin,
+         tokenObjectEnd,
+         tokenArrayBegin,
+         tokenArrayEnd,
+         tokenKey,
+         tokenString,
+         tokenNumber,
+         tokenTrue,
+         tokenFalse,
+         tokenNull
+      };
+
+      enum { maxDepth = 64 };
+
+      PullParser( const char *begin, const char *end );
+
+      TokenType next();
+      TokenType token() const;
+
+      /// After a key, skips its value, after tokenObjectBegin/tokenArrayBegin, skips to the matching end.
+      /// Otherwise skips the next value. \c false on an error.
+      bool skipValue();
+
+      /// Text of a tokenKey or tokenString without the quotes, escapes decoded.
+      const char *string() const;
+      size_t stringLength() const;
+      std::string asString() const;
+      bool isKey( const char *name ) const;
+
+      /// Value of a tokenNumber. The integer ones give 0 for a fraction, an exponent or an overflow.
+      bool isInteger() const;
+      long long asInt64() const;
+      unsigned long long asUInt64() const;
+      double asDouble() const;
+
+      /// Nesting level of the current token, 0 for the top level value.
+      int depth() const;
+      /// Offset in the document of the current token.
+      size_t offset() const;
+      const char *error() const;
+
+   private:
+      TokenType fail( const char *message );
+      TokenType readValue( char c );
+      TokenType readString( bool isKey );
+      TokenType readNumber();
+      TokenType readLiteral( const char *literal, size_t length, TokenType type );
+      void skipSpaces();
+
+      const char *begin_;
+      const char *end_;
+      const char *current_;
+      const char *tokenStart_;
+      const char *tokenEnd_;
+      const char *string_;
+      size_t stringLength_;
+      std::string decoded_;
+      const char *error_;
+      unsigned long long objectBits_;
+      int depth_;
+      int tokenDepth_;
+      TokenType token_;
+      enum State
+      {
+         stateValue,          // a value is next(the top level or after ':')
+         stateFirstMember,    // '}' or a key
+         stateMember,         // a key after ','
+         stateColon,
+         stateFirstElement,   // ']' or a value
+         stateAfter,          // ',' or the end of the container
+         stateDone
+      } state_;
+      bool integer_;
+      bool negative_;
+   };
+
+} // namespace Json
+
+#endif // JSON_SAX_H_INCLUDED
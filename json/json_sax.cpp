@@ -0,0 +1,1012 @@
+#include <json/sax.h>
+#include <locale.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+namespace Json {
+
+// 0:copied as is, 'u':\u00XX, otherwise the letter after the backslash
+static const char escapeTable[256] =
+{
+   'u','u','u','u','u','u','u','u','b','t','n','u','f','r','u','u',
+   'u','u','u','u','u','u','u','u','u','u','u','u','u','u','u','u',
+   0,  0,  '"',0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+   0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+   0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+   0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  '\\',0, 0,  0,
+   0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+   0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+   // 0x80-0xff, utf-8 goes through unchanged
+};
+
+static const char digitPairs[201] =
+   "00010203040506070809"
+   "10111213141516171819"
+   "20212223242526272829"
+   "30313233343536373839"
+   "40414243444546474849"
+   "50515253545556575859"
+   "60616263646566676869"
+   "70717273747576777879"
+   "80818283848586878889"
+   "90919293949596979899";
+
+static const double exactPow10[23] =
+{
+   1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+   1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+static const unsigned long long intPow10[10] =
+{
+   1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL,
+   10000000ULL, 100000000ULL, 1000000000ULL
+};
+
+// the decimal point of the C library's current locale, for snprintf and strtod
+static char localeDecimalPoint()
+{
+   const struct lconv *lc = localeconv();
+   return lc && lc->decimal_point && lc->decimal_point[0] ? lc->decimal_point[0] : '.';
+}
+
+
+// //////////////////////////////////////////////////////////////////
+// class SaxWriter
+// //////////////////////////////////////////////////////////////////
+
+SaxWriter::SaxWriter( std::string &out )
+   : out_( out )
+{
+   reset();
+}
+
+
+void
+SaxWriter::reset()
+{
+   out_.clear();
+   objectBits_ = 0;
+   countBits_ = 0;
+   depth_ = 0;
+   afterKey_ = false;
+   done_ = false;
+   valid_ = true;
+}
+
+
+bool
+SaxWriter::beginValue()
+{
+   if ( !valid_ || done_ )
+   {
+      valid_ = false;
+      return false;
+   }
+   if ( depth_ > 0 )
+   {
+      unsigned long long bit = 1ULL << (depth_ - 1);
+      if ( objectBits_ & bit )
+      {
+         // a member value needs its key first
+         if ( !afterKey_ )
+         {
+            valid_ = false;
+            return false;
+         }
+      }
+      else if ( countBits_ & bit )
+      {
+         out_ += ',';
+      }
+   }
+   afterKey_ = false;
+   return true;
+}
+
+
+void
+SaxWriter::endValue()
+{
+   if ( depth_ == 0 )
+      done_ = true;
+   else
+      countBits_ |= 1ULL << (depth_ - 1);
+}
+
+
+SaxWriter &
+SaxWriter::startObject()
+{
+   if ( depth_ >= maxDepth )
+      valid_ = false;
+   if ( beginValue() )
+   {
+      out_ += '{';
+      ++depth_;
+      objectBits_ |= 1ULL << (depth_ - 1);
+      countBits_ &= ~(1ULL << (depth_ - 1));
+   }
+   return *this;
+}
+
+
+SaxWriter &
+SaxWriter::endObject()
+{
+   if ( !valid_ || depth_ == 0 || afterKey_ || !(objectBits_ & (1ULL << (depth_ - 1))) )
+   {
+      valid_ = false;
+      return *this;
+   }
+   out_ += '}';
+   --depth_;
+   endValue();
+   return *this;
+}
+
+
+SaxWriter &
+SaxWriter::startArray()
+{
+   if ( depth_ >= maxDepth )
+      valid_ = false;
+   if ( beginValue() )
+   {
+      out_ += '[';
+      ++depth_;
+      objectBits_ &= ~(1ULL << (depth_ - 1));
+      countBits_ &= ~(1ULL << (depth_ - 1));
+   }
+   return *this;
+}
+
+
+SaxWriter &
+SaxWriter::endArray()
+{
+   if ( !valid_ || depth_ == 0 || (objectBits_ & (1ULL << (depth_ - 1))) )
+   {
+      valid_ = false;
+      return *this;
+   }
+   out_ += ']';
+   --depth_;
+   endValue();
+   return *this;
+}
+
+
+SaxWriter &
+SaxWriter::key( const char *name )
+{
+   return key( name, strlen( name ) );
+}
+
+
+SaxWriter &
+SaxWriter::key( const std::string &name )
+{
+   return key( name.data(), name.size() );
+}
+
+
+SaxWriter &
+SaxWriter::key( const char *name, size_t length )
+{
+   unsigned long long bit = depth_ > 0 ? 1ULL << (depth_ - 1) : 0;
+   if ( !valid_ || !(objectBits_ & bit) || afterKey_ )
+   {
+      valid_ = false;
+      return *this;
+   }
+   if ( countBits_ & bit )
+      out_ += ',';
+   countBits_ |= bit;
+   writeString( name, length );
+   out_ += ':';
+   afterKey_ = true;
+   return *this;
+}
+
+
+void
+SaxWriter::writeString( const char *str, size_t length )
+{
+   out_.reserve( out_.size() + length + 2 );
+   out_ += '"';
+   const unsigned char *cur = (const unsigned char *)str;
+   const unsigned char *end = cur + length;
+   while ( cur < end )
+   {
+      // the plain run is copied in one go
+      const unsigned char *run = cur;
+      while ( cur < end && escapeTable[*cur] == 0 )
+         ++cur;
+      if ( cur > run )
+         out_.append( (const char *)run, cur - run );
+      if ( cur == end )
+         break;
+
+      char esc = escapeTable[*cur];
+      if ( esc == 'u' )
+      {
+         char buf[6] = { '\\', 'u', '0', '0', "0123456789abcdef"[*cur >> 4], "0123456789abcdef"[*cur & 0xf] };
+         out_.append( buf, 6 );
+      }
+      else
+      {
+         char buf[2] = { '\\', esc };
+         out_.append( buf, 2 );
+      }
+      ++cur;
+   }
+   out_ += '"';
+}
+
+
+void
+SaxWriter::writeUInt( unsigned long long u, bool negative )
+{
+   char buffer[24];
+   char *current = buffer + sizeof(buffer);
+   while ( u >= 100 )
+   {
+      unsigned int pair = (unsigned int)(u % 100) * 2;
+      u /= 100;
+      *--current = digitPairs[pair + 1];
+      *--current = digitPairs[pair];
+   }
+   if ( u >= 10 )
+   {
+      *--current = digitPairs[u * 2 + 1];
+      *--current = digitPairs[u * 2];
+   }
+   else
+   {
+      *--current = char('0' + u);
+   }
+   if ( negative )
+      *--current = '-';
+   out_.append( current, buffer + sizeof(buffer) - current );
+}
+
+
+SaxWriter &
+SaxWriter::value( const char *str )
+{
+   return value( str, strlen( str ) );
+}
+
+
+SaxWriter &
+SaxWriter::value( const std::string &str )
+{
+   return value( str.data(), str.size() );
+}
+
+
+SaxWriter &
+SaxWriter::value( const char *str, size_t length )
+{
+   if ( beginValue() )
+   {
+      writeString( str, length );
+      endValue();
+   }
+   return *this;
+}
+
+
+SaxWriter &
+SaxWriter::value( bool b )
+{
+   if ( beginValue() )
+   {
+      if ( b )
+         out_.append( "true", 4 );
+      else
+         out_.append( "false", 5 );
+      endValue();
+   }
+   return *this;
+}
+
+
+SaxWriter &
+SaxWriter::value( int i )
+{
+   return value( (long long)i );
+}
+
+
+SaxWriter &
+SaxWriter::value( unsigned int u )
+{
+   return value( (unsigned long long)u );
+}
+
+
+SaxWriter &
+SaxWriter::value( long i )
+{
+   return value( (long long)i );
+}
+
+
+SaxWriter &
+SaxWriter::value( unsigned long u )
+{
+   return value( (unsigned long long)u );
+}
+
+
+SaxWriter &
+SaxWriter::value( long long i )
+{
+   if ( beginValue() )
+   {
+      // negated as unsigned, LLONG_MIN has no positive counterpart
+      writeUInt( i < 0 ? 0ULL - (unsigned long long)i : (unsigned long long)i, i < 0 );
+      endValue();
+   }
+   return *this;
+}
+
+
+SaxWriter &
+SaxWriter::value( unsigned long long u )
+{
+   if ( beginValue() )
+   {
+      writeUInt( u, false );
+      endValue();
+   }
+   return *this;
+}
+
+
+SaxWriter &
+SaxWriter::value( double d )
+{
+   if ( !isfinite( d ) )
+      return null();
+   if ( beginValue() )
+   {
+      // 15 digits are enough for most values, 17 always read back the same
+      char buffer[32];
+      int len = snprintf( buffer, sizeof(buffer), "%.15g", d );
+      if ( strtod( buffer, NULL ) != d )
+         len = snprintf( buffer, sizeof(buffer), "%.17g", d );
+      char point = localeDecimalPoint();
+      if ( point != '.' )
+      {
+         char *p = (char *)memchr( buffer, point, len );
+         if ( p )
+            *p = '.';
+      }
+      out_.append( buffer, len );
+      endValue();
+   }
+   return *this;
+}
+
+
+SaxWriter &
+SaxWriter::value( double d, int decimals )
+{
+   if ( !isfinite( d ) )
+      return null();
+   if ( decimals < 0 )
+      decimals = 0;
+   if ( decimals > 9 )
+      decimals = 9;
+   double scaled = fabs( d ) * (double)intPow10[decimals] + 0.5;
+   if ( scaled >= 9e18 )
+      return value( d );
+   if ( beginValue() )
+   {
+      unsigned long long s = (unsigned long long)scaled;
+      unsigned long long whole = s / intPow10[decimals];
+      unsigned long long fraction = s % intPow10[decimals];
+      writeUInt( whole, d < 0 && s != 0 );
+      if ( decimals > 0 )
+      {
+         char buffer[10];
+         buffer[0] = '.';
+         for ( int i = decimals; i > 0; --i )
+         {
+            buffer[i] = char('0' + fraction % 10);
+            fraction /= 10;
+         }
+         out_.append( buffer, decimals + 1 );
+      }
+      endValue();
+   }
+   return *this;
+}
+
+
+SaxWriter &
+SaxWriter::null()
+{
+   if ( beginValue() )
+   {
+      out_.append( "null", 4 );
+      endValue();
+   }
+   return *this;
+}
+
+
+SaxWriter &
+SaxWriter::rawValue( const char *json, size_t length )
+{
+   if ( beginValue() )
+   {
+      out_.append( json, length );
+      endValue();
+   }
+   return *this;
+}
+
+
+bool
+SaxWriter::isComplete() const
+{
+   return valid_ && done_;
+}
+
+
+bool
+SaxWriter::isValid() const
+{
+   return valid_;
+}
+
+
+const std::string &
+SaxWriter::output() const
+{
+   return out_;
+}
+
+
+// //////////////////////////////////////////////////////////////////
+// class PullParser
+// //////////////////////////////////////////////////////////////////
+
+PullParser::PullParser( const char *begin, const char *end )
+   : begin_( begin )
+   , end_( end )
+   , current_( begin )
+   , tokenStart_( begin )
+   , tokenEnd_( begin )
+   , string_( 0 )
+   , stringLength_( 0 )
+   , error_( 0 )
+   , objectBits_( 0 )
+   , depth_( 0 )
+   , tokenDepth_( 0 )
+   , token_( tokenEnd )
+   , state_( stateValue )
+   , integer_( false )
+   , negative_( false )
+{
+}
+
+
+PullParser::TokenType
+PullParser::fail( const char *message )
+{
+   if ( token_ != tokenError )
+   {
+      error_ = message;
+      tokenStart_ = current_;
+      token_ = tokenError;
+   }
+   return token_;
+}
+
+
+void
+PullParser::skipSpaces()
+{
+   while ( current_ < end_
+           && (*current_ == ' ' || *current_ == '\t' || *current_ == '\n' || *current_ == '\r') )
+      ++current_;
+}
+
+
+PullParser::TokenType
+PullParser::next()
+{
+   if ( token_ == tokenError )
+      return token_;
+
+   skipSpaces();
+   if ( state_ == stateDone )
+   {
+      if ( current_ < end_ )
+         return fail( "data after the document" );
+      tokenStart_ = tokenEnd_ = current_;
+      token_ = tokenEnd;
+      return token_;
+   }
+   if ( current_ >= end_ )
+      return fail( "unexpected end of the document" );
+
+   bool inObject = depth_ > 0 && (objectBits_ & (1ULL << (depth_ - 1)));
+   char c = *current_;
+   switch ( state_ )
+   {
+   case stateFirstMember:
+      if ( c == '}' )
+         break;
+      // fall through
+   case stateMember:
+      if ( c != '"' )
+         return fail( "missing a key" );
+      return readString( true );
+   case stateColon:
+      if ( c != ':' )
+         return fail( "missing ':' after a key" );
+      ++current_;
+      skipSpaces();
+      if ( current_ >= end_ )
+         return fail( "unexpected end of the document" );
+      return readValue( *current_ );
+   case stateFirstElement:
+      if ( c == ']' )
+         break;
+      return readValue( c );
+   case stateAfter:
+      if ( c == ',' )
+      {
+         ++current_;
+         skipSpaces();
+         if ( current_ >= end_ )
+            return fail( "unexpected end of the document" );
+         if ( inObject )
+         {
+            if ( *current_ != '"' )
+               return fail( "missing a key" );
+            return readString( true );
+         }
+         return readValue( *current_ );
+      }
+      break;
+   default:
+      return readValue( c );
+   }
+
+   // the end of the current container
+   if ( (c == '}' && !inObject) || (c == ']' && inObject) || (c != '}' && c != ']') )
+      return fail( inObject ? "missing ',' or '}'" : "missing ',' or ']'" );
+   tokenStart_ = current_++;
+   tokenEnd_ = current_;
+   --depth_;
+   tokenDepth_ = depth_;
+   state_ = depth_ == 0 ? stateDone : stateAfter;
+   token_ = c == '}' ? tokenObjectEnd : tokenArrayEnd;
+   return token_;
+}
+
+
+PullParser::TokenType
+PullParser::readValue( char c )
+{
+   tokenStart_ = current_;
+   tokenDepth_ = depth_;
+   TokenType type;
+   switch ( c )
+   {
+   case '{':
+   case '[':
+      if ( depth_ >= maxDepth )
+         return fail( "nested too deep" );
+      ++current_;
+      tokenEnd_ = current_;
+      ++depth_;
+      if ( c == '{' )
+         objectBits_ |= 1ULL << (depth_ - 1);
+      else
+         objectBits_ &= ~(1ULL << (depth_ - 1));
+      state_ = c == '{' ? stateFirstMember : stateFirstElement;
+      token_ = c == '{' ? tokenObjectBegin : tokenArrayBegin;
+      return token_;
+   case '"':
+      type = readString( false );
+      break;
+   case 't':
+      type = readLiteral( "true", 4, tokenTrue );
+      break;
+   case 'f':
+      type = readLiteral( "false", 5, tokenFalse );
+      break;
+   case 'n':
+      type = readLiteral( "null", 4, tokenNull );
+      break;
+   default:
+      type = readNumber();
+      break;
+   }
+   if ( type != tokenError )
+      state_ = depth_ == 0 ? stateDone : stateAfter;
+   return type;
+}
+
+
+PullParser::TokenType
+PullParser::readLiteral( const char *literal, size_t length, TokenType type )
+{
+   if ( (size_t)(end_ - current_) < length || memcmp( current_, literal, length ) != 0 )
+      return fail( "unknown literal" );
+   tokenStart_ = current_;
+   current_ += length;
+   tokenEnd_ = current_;
+   token_ = type;
+   return token_;
+}
+
+
+static void appendUtf8( std::string &out, unsigned int cp )
+{
+   if ( cp < 0x80 )
+   {
+      out += char(cp);
+   }
+   else if ( cp < 0x800 )
+   {
+      out += char(0xc0 | (cp >> 6));
+      out += char(0x80 | (cp & 0x3f));
+   }
+   else if ( cp < 0x10000 )
+   {
+      out += char(0xe0 | (cp >> 12));
+      out += char(0x80 | ((cp >> 6) & 0x3f));
+      out += char(0x80 | (cp & 0x3f));
+   }
+   else
+   {
+      out += char(0xf0 | (cp >> 18));
+      out += char(0x80 | ((cp >> 12) & 0x3f));
+      out += char(0x80 | ((cp >> 6) & 0x3f));
+      out += char(0x80 | (cp & 0x3f));
+   }
+}
+
+
+static bool readHex4( const char *p, const char *end, unsigned int &cp )
+{
+   if ( end - p < 4 )
+      return false;
+   cp = 0;
+   for ( int i = 0; i < 4; ++i )
+   {
+      char c = p[i];
+      cp <<= 4;
+      if ( c >= '0' && c <= '9' )
+         cp += c - '0';
+      else if ( c >= 'a' && c <= 'f' )
+         cp += c - 'a' + 10;
+      else if ( c >= 'A' && c <= 'F' )
+         cp += c - 'A' + 10;
+      else
+         return false;
+   }
+   return true;
+}
+
+
+PullParser::TokenType
+PullParser::readString( bool isKey )
+{
+   tokenStart_ = current_;
+   tokenDepth_ = depth_;
+   const char *start = ++current_;
+
+   // the common case, no escape: the text stays in the document
+   while ( current_ < end_ && *current_ != '"' && *current_ != '\\' && (unsigned char)*current_ >= 0x20 )
+      ++current_;
+   if ( current_ >= end_ )
+      return fail( "missing '\"' at the end of a string" );
+
+   if ( *current_ == '"' )
+   {
+      string_ = start;
+      stringLength_ = current_ - start;
+   }
+   else
+   {
+      decoded_.assign( start, current_ - start );
+      while ( current_ < end_ && *current_ != '"' )
+      {
+         unsigned char c = (unsigned char)*current_;
+         if ( c < 0x20 )
+            return fail( "control character in a string" );
+         if ( c != '\\' )
+         {
+            decoded_ += char(c);
+            ++current_;
+            continue;
+         }
+         if ( ++current_ >= end_ )
+            break;
+         unsigned int cp;
+         switch ( *current_++ )
+         {
+         case '"': decoded_ += '"'; break;
+         case '\\': decoded_ += '\\'; break;
+         case '/': decoded_ += '/'; break;
+         case 'b': decoded_ += '\b'; break;
+         case 'f': decoded_ += '\f'; break;
+         case 'n': decoded_ += '\n'; break;
+         case 'r': decoded_ += '\r'; break;
+         case 't': decoded_ += '\t'; break;
+         case 'u':
+            if ( !readHex4( current_, end_, cp ) )
+               return fail( "bad \\u escape" );
+            current_ += 4;
+            if ( cp >= 0xd800 && cp <= 0xdbff )
+            {
+               // a surrogate pair makes one code point
+               unsigned int low;
+               if ( end_ - current_ < 6 || current_[0] != '\\' || current_[1] != 'u'
+                    || !readHex4( current_ + 2, end_, low ) || low < 0xdc00 || low > 0xdfff )
+                  return fail( "bad surrogate pair" );
+               current_ += 6;
+               cp = 0x10000 + ((cp - 0xd800) << 10) + (low - 0xdc00);
+            }
+            appendUtf8( decoded_, cp );
+            break;
+         default:
+            return fail( "bad escape" );
+         }
+      }
+      if ( current_ >= end_ )
+         return fail( "missing '\"' at the end of a string" );
+      string_ = decoded_.data();
+      stringLength_ = decoded_.size();
+   }
+
+   tokenEnd_ = ++current_;
+   if ( isKey )
+      state_ = stateColon;
+   token_ = isKey ? tokenKey : tokenString;
+   return token_;
+}
+
+
+PullParser::TokenType
+PullParser::readNumber()
+{
+   tokenStart_ = current_;
+   const char *p = current_;
+   negative_ = p < end_ && *p == '-';
+   if ( negative_ )
+      ++p;
+   if ( p >= end_ || *p < '0' || *p > '9' )
+      return fail( "bad value" );
+   if ( *p == '0' )
+      ++p;
+   else
+      while ( p < end_ && *p >= '0' && *p <= '9' )
+         ++p;
+   integer_ = true;
+   if ( p < end_ && *p == '.' )
+   {
+      integer_ = false;
+      if ( ++p >= end_ || *p < '0' || *p > '9' )
+         return fail( "bad fraction" );
+      while ( p < end_ && *p >= '0' && *p <= '9' )
+         ++p;
+   }
+   if ( p < end_ && (*p == 'e' || *p == 'E') )
+   {
+      integer_ = false;
+      ++p;
+      if ( p < end_ && (*p == '+' || *p == '-') )
+         ++p;
+      if ( p >= end_ || *p < '0' || *p > '9' )
+         return fail( "bad exponent" );
+      while ( p < end_ && *p >= '0' && *p <= '9' )
+         ++p;
+   }
+   current_ = tokenEnd_ = p;
+   token_ = tokenNumber;
+   return token_;
+}
+
+
+bool
+PullParser::skipValue()
+{
+   if ( token_ == tokenKey )
+      next();
+   if ( token_ == tokenObjectBegin || token_ == tokenArrayBegin )
+   {
+      int level = tokenDepth_;
+      while ( next() != tokenError )
+      {
+         if ( (token_ == tokenObjectEnd || token_ == tokenArrayEnd) && tokenDepth_ == level )
+            return true;
+      }
+   }
+   return token_ != tokenError;
+}
+
+
+PullParser::TokenType
+PullParser::token() const
+{
+   return token_;
+}
+
+
+const char *
+PullParser::string() const
+{
+   return (token_ == tokenKey || token_ == tokenString) ? string_ : "";
+}
+
+
+size_t
+PullParser::stringLength() const
+{
+   return (token_ == tokenKey || token_ == tokenString) ? stringLength_ : 0;
+}
+
+
+std::string
+PullParser::asString() const
+{
+   return std::string( string(), stringLength() );
+}
+
+
+bool
+PullParser::isKey( const char *name ) const
+{
+   size_t length = strlen( name );
+   return token_ == tokenKey && stringLength_ == length && memcmp( string_, name, length ) == 0;
+}
+
+
+bool
+PullParser::isInteger() const
+{
+   return token_ == tokenNumber && integer_;
+}
+
+
+unsigned long long
+PullParser::asUInt64() const
+{
+   if ( !isInteger() || negative_ )
+      return 0;
+   unsigned long long u = 0;
+   for ( const char *p = tokenStart_; p < tokenEnd_; ++p )
+   {
+      unsigned int digit = *p - '0';
+      if ( u > (~0ULL - digit) / 10 )
+         return 0;
+      u = u * 10 + digit;
+   }
+   return u;
+}
+
+
+long long
+PullParser::asInt64() const
+{
+   if ( !isInteger() )
+      return 0;
+   unsigned long long u = 0;
+   const unsigned long long limit = negative_ ? 0x8000000000000000ULL : 0x7fffffffffffffffULL;
+   for ( const char *p = tokenStart_ + (negative_ ? 1 : 0); p < tokenEnd_; ++p )
+   {
+      unsigned int digit = *p - '0';
+      if ( u > (limit - digit) / 10 )
+         return 0;
+      u = u * 10 + digit;
+   }
+   return negative_ ? (long long)(0ULL - u) : (long long)u;
+}
+
+
+double
+PullParser::asDouble() const
+{
+   if ( token_ != tokenNumber )
+      return 0.0;
+
+   // up to 15 significant digits and a power of ten below 1e23 are exact in a double,
+   // so one multiplication or division gives the correctly rounded value
+   unsigned long long mantissa = 0;
+   int digits = 0;
+   int exponent = 0;
+   const char *p = tokenStart_ + (negative_ ? 1 : 0);
+   for ( ; p < tokenEnd_ && *p >= '0' && *p <= '9'; ++p )
+   {
+      if ( digits > 0 || *p != '0' )
+         ++digits;
+      mantissa = mantissa * 10 + (*p - '0');
+      if ( digits > 15 )
+         break;
+   }
+   if ( digits <= 15 && p < tokenEnd_ && *p == '.' )
+   {
+      for ( ++p; p < tokenEnd_ && *p >= '0' && *p <= '9'; ++p )
+      {
+         if ( digits > 0 || *p != '0' )
+            ++digits;
+         mantissa = mantissa * 10 + (*p - '0');
+         --exponent;
+         if ( digits > 15 )
+            break;
+      }
+   }
+   if ( digits <= 15 && p < tokenEnd_ && (*p == 'e' || *p == 'E') )
+   {
+      ++p;
+      bool negativeExponent = *p == '-';
+      if ( *p == '+' || *p == '-' )
+         ++p;
+      int e = 0;
+      for ( ; p < tokenEnd_ && e < 10000; ++p )
+         e = e * 10 + (*p - '0');
+      exponent += negativeExponent ? -e : e;
+   }
+   if ( digits <= 15 && p == tokenEnd_ && exponent >= -22 && exponent <= 22 )
+   {
+      double d = (double)mantissa;
+      d = exponent < 0 ? d / exactPow10[-exponent] : d * exactPow10[exponent];
+      return negative_ ? -d : d;
+   }
+
+   // long mantissas and large exponents go to strtod, with the decimal point it expects
+   char buffer[64];
+   std::string longText;
+   size_t length = tokenEnd_ - tokenStart_;
+   char *text = buffer;
+   if ( length >= sizeof(buffer) )
+   {
+      longText.assign( tokenStart_, length );
+      text = &longText[0];
+   }
+   else
+   {
+      memcpy( buffer, tokenStart_, length );
+      buffer[length] = 0;
+   }
+   char *point = (char *)memchr( text, '.', length );
+   if ( point )
+      *point = localeDecimalPoint();
+   return strtod( text, NULL );
+}
+
+
+int
+PullParser::depth() const
+{
+   return tokenDepth_;
+}
+
+
+size_t
+PullParser::offset() const
+{
+   return tokenStart_ - begin_;
+}
+
+
+const char *
+PullParser::error() const
+{
+   return token_ == tokenError ? error_ : "";
+}
+
+} // namespace Json
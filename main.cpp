@@ -1,11 +1,16 @@
 #include <app_std.h>
 #include <dev_chn_wrapper.h>
 #include <json/json.h>
-#include <fstream>
 #include <rtsp/server.h>
+#include <rtsp/http_server.h>
 #include <rtsp/stream/stream_manager.h>
 #include <rtmp/session_manager.h>
 #include <execinfo.h>
+#include <startup/startup_dag.h>
+#include <config/config_service.h>
+
+//boot steps run on this many threads,they mostly wait on the sdk and the flash
+#define STARTUP_THREADS 4
 
 LOG_HANDLE g_app_log;
 LOG_HANDLE g_rtsp_log;
@@ -16,73 +21,72 @@ using namespace hisilicon::dev;
 using chn_type = chn_wrapper;
 std::shared_ptr<chn_type> g_chn;
 
+//the json files below are parsed once into their structs by g_config,which reloads a file
+//written while running and tells the subsystems whose settings changed,see subscribe_config().
+//the g_*_info structs are what the boot steps started with
+static ceanic::config::config_service g_config;
+
+//a string that does not fit its buffer refuses the file
+static bool get_str(const Json::Value& v,char* buf,size_t size)
+{
+    if(!v.isString() || v.asString().size() >= size)
+    {
+        return false;
+    }
+
+    snprintf(buf,size,"%s",v.asCString());
+    return true;
+}
+
 #define NET_SERVICE_FILE_PATH "/opt/ceanic/etc/net_service.json"
 typedef struct
 {
     int rtsp_port;
+    char rtsp_playback_dir[255];
+    int http_port;
     int rtmp_enable;
     char rtmp_main_url[255];
     char rtmp_sub_url[255];
 }net_service_t;
 static net_service_t g_net_service_info;
-static void init_net_service_info()
-{
-    Json::Value root;
-
-    root["net_service"]["rtsp"]["port"] = 554;
-    root["net_service"]["rtmp"]["enable"] = 0;
-    root["net_service"]["rtmp"]["main_url"] = "rtmp://192.168.10.97/live/stream1" ;
-    root["net_service"]["rtmp"]["sub_url"] = "rtmp://192.168.10.97/live/stream2" ;
-    std::string str= root.toStyledString();
-    std::ofstream ofs;
-    ofs.open(NET_SERVICE_FILE_PATH);
-    ofs << str;
-    ofs.close();
+static const char* g_net_service_default = R"({
+   "net_service" : {
+      "http" : {
+         "port" : 8080
+      },
+      "rtmp" : {
+         "enable" : 0,
+         "main_url" : "rtmp://192.168.10.97/live/stream1",
+         "sub_url" : "rtmp://192.168.10.97/live/stream2"
+      },
+      "rtsp" : {
+         "playback_dir" : "/mnt",
+         "port" : 554
+      }
+   }
 }
+)";
 
-static int get_net_service_info()
+static bool parse_net_service_info(const Json::Value& root,net_service_t* info)
 {
-    try
+    const Json::Value& net = root["net_service"];
+    info->rtsp_port = net["rtsp"]["port"].asInt();
+    snprintf(info->rtsp_playback_dir,sizeof(info->rtsp_playback_dir),"/mnt");
+    if(net["rtsp"].isMember("playback_dir")
+            && !get_str(net["rtsp"]["playback_dir"],info->rtsp_playback_dir,sizeof(info->rtsp_playback_dir)))
     {
-        if(access(NET_SERVICE_FILE_PATH,F_OK) < 0)
-        {
-            init_net_service_info();
-
-            if(access(NET_SERVICE_FILE_PATH,F_OK) < 0)
-            {
-                return -1;
-            }
-        }
-
-        std::ifstream ifs;
-        ifs.open(NET_SERVICE_FILE_PATH);
-        if(!ifs.is_open())
-        {
-            return -1;
-        }
-        Json::Reader reader;  
-        Json::Value root; 
-        if (!reader.parse(ifs, root, false)) 
-        {
-            return -1;
-        }
-
-        Json::Value node; 
-        g_net_service_info.rtsp_port= root["net_service"]["rtsp"]["port"].asInt();
-        g_net_service_info.rtmp_enable = root["net_service"]["rtmp"]["enable"].asInt();
-        sprintf(g_net_service_info.rtmp_main_url,"%s",root["net_service"]["rtmp"]["main_url"].asCString());
-        sprintf(g_net_service_info.rtmp_sub_url,"%s",root["net_service"]["rtmp"]["sub_url"].asCString());
-
-        ifs.close();
-
-        return 0;
-    }
-    catch(...)
-    {
-        return -1;
+        return false;
     }
+    info->http_port = net.isMember("http") ? net["http"]["port"].asInt() : 8080;
+    info->rtmp_enable = net["rtmp"]["enable"].asInt();
+
+    //http 0 disables it
+    return info->rtsp_port > 0 && info->rtsp_port <= 65535
+        && info->http_port >= 0 && info->http_port <= 65535
+        && get_str(net["rtmp"]["main_url"],info->rtmp_main_url,sizeof(info->rtmp_main_url))
+        && get_str(net["rtmp"]["sub_url"],info->rtmp_sub_url,sizeof(info->rtmp_sub_url));
 }
-
+static auto g_net_service_cfg = g_config.add<net_service_t>("net",NET_SERVICE_FILE_PATH,g_net_service_default,parse_net_service_info);
 
 #define VENC_FILE_PATH "/opt/ceanic/etc/venc.json"
 typedef struct
@@ -92,155 +96,114 @@ typedef struct
     int h;
     int fr;
     int bitrate;
+    int slice_lines;
+    //jpeg stream for rtsp mjpeg<n> and http mjpeg<n>
+    int mjpeg_enable;
+    int mjpeg_w;
+    int mjpeg_h;
+    int mjpeg_fr;
+    int mjpeg_quality;
 }venc_t;
-static venc_t g_venc_info[MAX_CHANNEL];
-static void init_venc_info()
+typedef struct
 {
-    Json::Value root;
-    for(auto i = 0; i < MAX_CHANNEL; i++)
-    {
-        std::string venc = "venc" + std::to_string(i + 1);
-
-        sprintf(g_venc_info[i].name,"H264_CBR");
-        g_venc_info[i].w = 2688;
-        g_venc_info[i].h = 1520;
-        g_venc_info[i].fr = 30;
-        g_venc_info[i].bitrate = 4000;
-
-        root[venc]["name"] = g_venc_info[i].name;
-        root[venc]["w"] = g_venc_info[i].w;
-        root[venc]["h"] = g_venc_info[i].h;
-        root[venc]["fr"] = g_venc_info[i].fr;
-        root[venc]["bitrate"] = g_venc_info[i].bitrate;
-    }
-
-    std::string str= root.toStyledString();
-    std::ofstream ofs;
-    ofs.open(VENC_FILE_PATH);
-    ofs << str;
-    ofs.close();
+    venc_t chn[MAX_CHANNEL];
+}venc_info_t;
+static venc_info_t g_venc_info;
+//a missing vencN runs as venc1
+static const char* g_venc_default = R"({
+   "venc1" : {
+      "bitrate" : 4000,
+      "fr" : 30,
+      "h" : 1520,
+      "mjpeg" : {
+         "enable" : 0,
+         "fr" : 5,
+         "h" : 720,
+         "quality" : 60,
+         "w" : 1280
+      },
+      "name" : "H264_CBR",
+      "slice_lines" : 0,
+      "w" : 2688
+   }
 }
+)";
 
-static int get_venc_info()
+static bool parse_venc_info(const Json::Value& root,venc_info_t* info)
 {
-    try
+    for(auto i = 0; i < MAX_CHANNEL; i++)
     {
-        if(access(VENC_FILE_PATH,F_OK) < 0)
-        {
-            init_venc_info();
-
-            if(access(VENC_FILE_PATH,F_OK) < 0)
-            {
-                return -1;
-            }
-        }
+        std::string venc = "venc" + std::to_string(i + 1);
+        const Json::Value& node = root.isMember(venc) ? root[venc] : root["venc1"];
+        venc_t& v = info->chn[i];
 
-        std::ifstream ifs;
-        ifs.open(VENC_FILE_PATH);
-        if(!ifs.is_open())
+        if(!get_str(node["name"],v.name,sizeof(v.name)))
         {
-            return -1;
+            return false;
         }
-        Json::Reader reader;  
-        Json::Value root; 
-        if (!reader.parse(ifs, root, false)) 
+        v.w = node["w"].asInt();
+        v.h = node["h"].asInt();
+        v.fr = node["fr"].asInt();
+        v.bitrate = node["bitrate"].asInt();
+        v.slice_lines = node.isMember("slice_lines") ? node["slice_lines"].asInt() : 0;
+        v.mjpeg_enable = 0;
+        if(node.isMember("mjpeg"))
         {
-            return -1;
+            v.mjpeg_enable = node["mjpeg"]["enable"].asInt();
+            v.mjpeg_w = node["mjpeg"]["w"].asInt();
+            v.mjpeg_h = node["mjpeg"]["h"].asInt();
+            v.mjpeg_fr = node["mjpeg"]["fr"].asInt();
+            v.mjpeg_quality = node["mjpeg"]["quality"].asInt();
         }
 
-        Json::Value node; 
-        for(auto i = 0; i < MAX_CHANNEL; i++)
+        if(v.w <= 0 || v.h <= 0 || v.w % 2 || v.h % 2
+                || v.fr <= 0 || v.bitrate <= 0 || v.slice_lines < 0)
         {
-            std::string venc= "venc" + std::to_string(i + 1);
-            node = root[venc];
-
-            sprintf(g_venc_info[i].name,"%s",node["name"].asCString());
-            g_venc_info[i].w = node["w"].asInt();
-            g_venc_info[i].h = node["h"].asInt();
-            g_venc_info[i].fr = node["fr"].asInt();
-            g_venc_info[i].bitrate = node["bitrate"].asInt();
+            return false;
+        }
+        if(v.mjpeg_enable
+                && (v.mjpeg_w <= 0 || v.mjpeg_h <= 0 || v.mjpeg_fr <= 0 || v.mjpeg_quality < 1 || v.mjpeg_quality > 99))
+        {
+            return false;
         }
-
-        ifs.close();
-
-        return 0;
-    }
-    catch(...)
-    {
-        return -1;
     }
+    return true;
 }
+static auto g_venc_cfg = g_config.add<venc_info_t>("venc",VENC_FILE_PATH,g_venc_default,parse_venc_info);
 
 #define VI_FILE_PATH "/opt/ceanic/etc/vi.json"
 typedef struct
 {
     char name[32];
 }vi_t;
-static vi_t g_vi_info[MAX_CHANNEL];
-static void init_vi_info()
+typedef struct
 {
-    Json::Value root;
-    for(auto i = 0; i < MAX_CHANNEL; i++)
-    {
-        std::string sns = "sensor" + std::to_string(i + 1);
-
-        sprintf(g_vi_info[i].name,"OS04A10");
-
-        root[sns]["name"] = g_vi_info[i].name;
-    }
-
-    std::string str= root.toStyledString();
-    std::ofstream ofs;
-    ofs.open(VI_FILE_PATH);
-    ofs << str;
-    ofs.close();
+    vi_t chn[MAX_CHANNEL];
+}vi_info_t;
+static vi_info_t g_vi_info;
+//a missing sensorN runs as sensor1
+static const char* g_vi_default = R"({
+   "sensor1" : {
+      "name" : "OS04A10"
+   }
 }
+)";
 
-static int get_vi_info()
+static bool parse_vi_info(const Json::Value& root,vi_info_t* info)
 {
-    try
+    for(auto i = 0; i < MAX_CHANNEL; i++)
     {
-        if(access(VI_FILE_PATH,F_OK) < 0)
-        {
-            init_vi_info();
-
-            if(access(VI_FILE_PATH,F_OK) < 0)
-            {
-                return -1;
-            }
-        }
-
-        std::ifstream ifs;
-        ifs.open(VI_FILE_PATH);
-        if(!ifs.is_open())
-        {
-            return -1;
-        }
-        Json::Reader reader;  
-        Json::Value root; 
-        if (!reader.parse(ifs, root, false)) 
-        {
-            return -1;
-        }
+        std::string sns = "sensor" + std::to_string(i + 1);
+        const Json::Value& node = root.isMember(sns) ? root[sns] : root["sensor1"];
 
-        Json::Value node; 
-        for(auto i = 0; i < MAX_CHANNEL; i++)
+        if(!get_str(node["name"],info->chn[i].name,sizeof(info->chn[i].name)))
         {
-            std::string sns = "sensor" + std::to_string(i + 1);
-            node = root[sns];
-
-            sprintf(g_vi_info[i].name,"%s",node["name"].asCString());
+            return false;
         }
-
-        ifs.close();
-
-        return 0;
-    }
-    catch(...)
-    {
-        return -1;
     }
+    return true;
 }
+static auto g_vi_cfg = g_config.add<vi_info_t>("vi",VI_FILE_PATH,g_vi_default,parse_vi_info);
 
 typedef struct
 {
@@ -250,125 +213,61 @@ typedef struct
 }scene_info_t;
 static scene_info_t g_scene_info;
 #define SCENE_FILE_PATH "/opt/ceanic/scene/scene.json"
-static void init_scene_info()
-{
-    Json::Value root;
-
-    root["scene"]["enable"] = 1;
-    root["scene"]["mode"] = 0;
-    root["scene"]["dir_path"] = "/opt/ceanic/scene/param/sensor_os04a10";
-    std::string str= root.toStyledString();
-    std::ofstream ofs;
-    ofs.open(SCENE_FILE_PATH);
-    ofs << str;
-    ofs.close();
+static const char* g_scene_default = R"({
+   "scene" : {
+      "dir_path" : "/opt/ceanic/scene/param/sensor_os04a10",
+      "enable" : 1,
+      "mode" : 0
+   }
 }
+)";
 
-static int get_scene_info()
+static bool parse_scene_info(const Json::Value& root,scene_info_t* info)
 {
-    try
-    {
-        if(access(SCENE_FILE_PATH,F_OK) < 0)
-        {
-            init_scene_info();
-
-            if(access(SCENE_FILE_PATH,F_OK) < 0)
-            {
-                return -1;
-            }
-        }
-
-        std::ifstream ifs;
-        ifs.open(SCENE_FILE_PATH);
-        if(!ifs.is_open())
-        {
-            return -1;
-        }
-        Json::Reader reader;  
-        Json::Value root; 
-        if (!reader.parse(ifs, root, false)) 
-        {
-            return -1;
-        }
-
-        Json::Value node; 
-        g_scene_info.enable = root["scene"]["enable"].asInt();
-        g_scene_info.mode = root["scene"]["mode"].asInt();
-        sprintf(g_scene_info.dir_path,"%s",root["scene"]["dir_path"].asCString());
-
-        ifs.close();
-
-        return 0;
-    }
-    catch(...)
-    {
-        return -1;
-    }
+    info->enable = root["scene"]["enable"].asInt();
+    info->mode = root["scene"]["mode"].asInt();
+    return info->mode >= 0
+        && get_str(root["scene"]["dir_path"],info->dir_path,sizeof(info->dir_path));
 }
+static auto g_scene_cfg = g_config.add<scene_info_t>("scene",SCENE_FILE_PATH,g_scene_default,parse_scene_info);
 
 typedef struct
 {
     int enable;
     int mode; //0:bnr 1:drc 2:3dnr
     char model_file[255];
+    int cache_mb; //mmz the idle models may keep,0:no limit
+    std::vector<std::string> preload; //models read ahead for a fast aiisp_switch
 }aiisp_info_t;
 static aiisp_info_t g_aiisp_info;
 #define AIISP_FILE_PATH "/opt/ceanic/aiisp/aiisp.json"
-static void init_aiisp_info()
-{
-    Json::Value root;
-
-    root["aiisp"]["enable"] = 1;
-    root["aiisp"]["mode"] = 0;
-    root["aiisp"]["model_file"] = "/opt/ceanic/aiisp/aibnr/model/aibnr_model_denoise_priority_lite.bin";
-    std::string str= root.toStyledString();
-    std::ofstream ofs;
-    ofs.open(AIISP_FILE_PATH);
-    ofs << str;
-    ofs.close();
+static const char* g_aiisp_default = R"({
+   "aiisp" : {
+      "enable" : 1,
+      "mode" : 0,
+      "model_file" : "/opt/ceanic/aiisp/aibnr/model/aibnr_model_denoise_priority_lite.bin"
+   }
 }
+)";
 
-static int get_aiisp_info()
+static bool parse_aiisp_info(const Json::Value& root,aiisp_info_t* info)
 {
-    try
+    const Json::Value& aiisp = root["aiisp"];
+    info->enable = aiisp["enable"].asInt();
+    info->mode = aiisp["mode"].asInt();
+    if(!get_str(aiisp["model_file"],info->model_file,sizeof(info->model_file)))
     {
-        if(access(AIISP_FILE_PATH,F_OK) < 0)
-        {
-            init_aiisp_info();
-
-            if(access(AIISP_FILE_PATH,F_OK) < 0)
-            {
-                return -1;
-            }
-        }
-
-        std::ifstream ifs;
-        ifs.open(AIISP_FILE_PATH);
-        if(!ifs.is_open())
-        {
-            return -1;
-        }
-        Json::Reader reader;  
-        Json::Value root; 
-        if (!reader.parse(ifs, root, false)) 
-        {
-            return -1;
-        }
-
-        Json::Value node; 
-        g_aiisp_info.enable = root["aiisp"]["enable"].asInt();
-        g_aiisp_info.mode = root["aiisp"]["mode"].asInt();
-        sprintf(g_aiisp_info.model_file,"%s",root["aiisp"]["model_file"].asCString());
-
-        ifs.close();
-
-        return 0;
+        return false;
     }
-    catch(...)
+    info->cache_mb = aiisp.isMember("cache_mb") ? aiisp["cache_mb"].asInt() : 0;
+    for(unsigned int i = 0; aiisp.isMember("preload") && i < aiisp["preload"].size(); i++)
     {
-        return -1;
+        info->preload.push_back(aiisp["preload"][i].asString());
     }
+
+    return info->mode >= 0 && info->mode <= 2 && info->cache_mb >= 0;
 }
+static auto g_aiisp_cfg = g_config.add<aiisp_info_t>("aiisp",AIISP_FILE_PATH,g_aiisp_default,parse_aiisp_info);
 
 typedef struct
 {
@@ -377,120 +276,112 @@ typedef struct
 }rate_auto_info_t;
 static rate_auto_info_t g_rate_auto_info;
 #define RATE_AUTO_FILE_PATH "/opt/ceanic/etc/rate_auto.json"
-static void init_rate_auto_info()
-{
-    Json::Value root;
-
-    root["rate_auto"]["enable"] = 1;
-    root["rate_auto"]["file"] = "/opt/ceanic/etc/config_rate_auto_base_param.ini";
-    std::string str= root.toStyledString();
-    std::ofstream ofs;
-    ofs.open(RATE_AUTO_FILE_PATH);
-    ofs << str;
-    ofs.close();
+static const char* g_rate_auto_default = R"({
+   "rate_auto" : {
+      "enable" : 1,
+      "file" : "/opt/ceanic/etc/config_rate_auto_base_param.ini"
+   }
 }
+)";
 
-static int get_rate_auto_info()
+static bool parse_rate_auto_info(const Json::Value& root,rate_auto_info_t* info)
 {
-    try
-    {
-        if(access(RATE_AUTO_FILE_PATH,F_OK) < 0)
-        {
-            init_rate_auto_info();
-
-            if(access(RATE_AUTO_FILE_PATH,F_OK) < 0)
-            {
-                return -1;
-            }
-        }
-
-        std::ifstream ifs;
-        ifs.open(RATE_AUTO_FILE_PATH);
-        if(!ifs.is_open())
-        {
-            return -1;
-        }
-        Json::Reader reader;  
-        Json::Value root; 
-        if (!reader.parse(ifs, root, false)) 
-        {
-            return -1;
-        }
-
-        Json::Value node; 
-        g_rate_auto_info.enable = root["rate_auto"]["enable"].asInt();
-        sprintf(g_rate_auto_info.file,"%s",root["rate_auto"]["file"].asCString());
-
-        ifs.close();
-
-        return 0;
-    }
-    catch(...)
-    {
-        return -1;
-    }
+    info->enable = root["rate_auto"]["enable"].asInt();
+    return get_str(root["rate_auto"]["file"],info->file,sizeof(info->file));
 }
+static auto g_rate_auto_cfg = g_config.add<rate_auto_info_t>("rate_auto",RATE_AUTO_FILE_PATH,g_rate_auto_default,parse_rate_auto_info);
 
 typedef struct
 {
     int enable;
     char file[255];
+    ceanic::stream_save::mp4_save_param param;
+    int mode;//0:continuous 1:event
+    int format;//0:mp4(vendor muxer) 1:fragmented mp4 2:fragmented mp4 in segment pool
+    ceanic::stream_save::event_save_param event;
+    ceanic::stream_save::segment_pool_param pool;
 }mp4_save_info_t;
 static mp4_save_info_t g_mp4_save_info;
 #define MP4_SAVE_INFO_PATH "/opt/ceanic/etc/mp4_save_info.json"
-static void init_mp4_save_info()
-{
-    Json::Value root;
-
-    root["mp4_save"]["enable"] = 0;
-    root["mp4_save"]["file"] = "/mnt/test.mp4";
-    std::string str= root.toStyledString();
-    std::ofstream ofs;
-    ofs.open(MP4_SAVE_INFO_PATH);
-    ofs << str;
-    ofs.close();
+static const char* g_mp4_save_default = R"({
+   "mp4_save" : {
+      "enable" : 0,
+      "event" : {
+         "dir_path" : "/mnt/event",
+         "max_segments" : 100,
+         "post_time" : 20,
+         "pre_time" : 10,
+         "ring_size" : 16384,
+         "segment_time" : 300
+      },
+      "file" : "/mnt/test.mp4",
+      "format" : 0,
+      "mode" : 0,
+      "pool" : {
+         "count" : 64,
+         "dir_path" : "/mnt/pool",
+         "max_keys" : 1024,
+         "segment_size" : 262144
+      },
+      "prealloc_size" : 20480,
+      "queue_size" : 4096,
+      "stat_interval" : 60,
+      "sync_interval" : 5000,
+      "write_unit" : 1024
+   }
 }
+)";
 
-static int get_mp4_save_info()
+static bool parse_mp4_save_info(const Json::Value& root,mp4_save_info_t* info)
 {
-    try
-    {
-        if(access(MP4_SAVE_INFO_PATH,F_OK) < 0)
-        {
-            init_mp4_save_info();
+    const Json::Value& mp4 = root["mp4_save"];
+    info->param = ceanic::stream_save::mp4_save::default_param();
+    info->event = ceanic::stream_save::event_save::default_param();
+    info->pool = ceanic::stream_save::segment_pool::default_param();
 
-            if(access(MP4_SAVE_INFO_PATH,F_OK) < 0)
-            {
-                return -1;
-            }
-        }
+    info->enable = mp4["enable"].asInt();
+    if(!get_str(mp4["file"],info->file,sizeof(info->file)))
+    {
+        return false;
+    }
 
-        std::ifstream ifs;
-        ifs.open(MP4_SAVE_INFO_PATH);
-        if(!ifs.is_open())
-        {
-            return -1;
-        }
-        Json::Reader reader;  
-        Json::Value root; 
-        if (!reader.parse(ifs, root, false)) 
+    //optional,older files keep the defaults
+    info->param.queue_size = mp4.isMember("queue_size") ? mp4["queue_size"].asUInt() * 1024 : info->param.queue_size;
+    info->param.write_unit = mp4.isMember("write_unit") ? mp4["write_unit"].asUInt() * 1024 : info->param.write_unit;
+    info->param.prealloc_size = mp4.isMember("prealloc_size") ? mp4["prealloc_size"].asUInt() * 1024 : info->param.prealloc_size;
+    info->param.sync_interval = mp4.isMember("sync_interval") ? mp4["sync_interval"].asUInt() : info->param.sync_interval;
+    info->param.stat_interval = mp4.isMember("stat_interval") ? mp4["stat_interval"].asUInt() : info->param.stat_interval;
+    info->mode = mp4.isMember("mode") ? mp4["mode"].asInt() : 0;
+    info->format = mp4.isMember("format") ? mp4["format"].asInt() : 0;
+    if(mp4.isMember("event"))
+    {
+        const Json::Value& event = mp4["event"];
+        if(!get_str(event["dir_path"],info->event.dir_path,sizeof(info->event.dir_path)))
         {
-            return -1;
+            return false;
         }
-
-        Json::Value node; 
-        g_mp4_save_info.enable = root["mp4_save"]["enable"].asInt();
-        sprintf(g_mp4_save_info.file,"%s",root["mp4_save"]["file"].asCString());
-
-        ifs.close();
-
-        return 0;
+        info->event.pre_time = event["pre_time"].asUInt();
+        info->event.post_time = event["post_time"].asUInt();
+        info->event.segment_time = event["segment_time"].asUInt();
+        info->event.max_segments = event["max_segments"].asUInt();
+        info->event.ring_size = event["ring_size"].asUInt() * 1024;
     }
-    catch(...)
+    if(mp4.isMember("pool"))
     {
-        return -1;
+        const Json::Value& pool = mp4["pool"];
+        if(!get_str(pool["dir_path"],info->pool.dir_path,sizeof(info->pool.dir_path)))
+        {
+            return false;
+        }
+        info->pool.count = pool["count"].asUInt();
+        info->pool.segment_size = (uint64_t)pool["segment_size"].asUInt() * 1024;
+        info->pool.max_keys = pool["max_keys"].asUInt();
     }
+    info->event.mp4 = info->param;
+
+    return info->mode >= 0 && info->mode <= 1 && info->format >= 0 && info->format <= 2;
 }
+static auto g_mp4_save_cfg = g_config.add<mp4_save_info_t>("mp4_save",MP4_SAVE_INFO_PATH,g_mp4_save_default,parse_mp4_save_info);
 
 typedef struct
 {
@@ -501,127 +392,144 @@ typedef struct
 }jpg_save_info_t;
 static jpg_save_info_t g_jpg_save_info;
 #define JPG_SAVE_INFO_PATH "/opt/ceanic/etc/jpg_save_info.json"
-static void init_jpg_save_info()
-{
-    Json::Value root;
-
-    root["jpg_save"]["enable"] = 0;
-    root["jpg_save"]["quality"] = 90;
-    root["jpg_save"]["interval"] = 60;
-    root["jpg_save"]["dir_path"] = "/mnt/";
-    std::string str= root.toStyledString();
-    std::ofstream ofs;
-    ofs.open(JPG_SAVE_INFO_PATH);
-    ofs << str;
-    ofs.close();
+static const char* g_jpg_save_default = R"({
+   "jpg_save" : {
+      "dir_path" : "/mnt/",
+      "enable" : 0,
+      "interval" : 60,
+      "quality" : 90
+   }
 }
+)";
 
-static int get_jpg_save_info()
+static bool parse_jpg_save_info(const Json::Value& root,jpg_save_info_t* info)
 {
-    try
-    {
-        if(access(JPG_SAVE_INFO_PATH,F_OK) < 0)
-        {
-            init_jpg_save_info();
-
-            if(access(JPG_SAVE_INFO_PATH,F_OK) < 0)
-            {
-                return -1;
-            }
-        }
-
-        std::ifstream ifs;
-        ifs.open(JPG_SAVE_INFO_PATH);
-        if(!ifs.is_open())
-        {
-            return -1;
-        }
-        Json::Reader reader;  
-        Json::Value root; 
-        if (!reader.parse(ifs, root, false)) 
-        {
-            return -1;
-        }
-
-        Json::Value node; 
-        g_jpg_save_info.enable = root["jpg_save"]["enable"].asInt();
-        g_jpg_save_info.quality = root["jpg_save"]["quality"].asInt();
-        g_jpg_save_info.interval = root["jpg_save"]["interval"].asInt();
-        sprintf(g_jpg_save_info.dir_path,"%s",root["jpg_save"]["dir_path"].asCString());
-
-        ifs.close();
-
-        return 0;
-    }
-    catch(...)
-    {
-        return -1;
-    }
+    const Json::Value& jpg = root["jpg_save"];
+    info->enable = jpg["enable"].asInt();
+    info->quality = jpg["quality"].asInt();
+    info->interval = jpg["interval"].asInt();
+
+    //thread_1s takes the interval modulo the time
+    return info->quality >= 1 && info->quality <= 99 && info->interval > 0
+        && get_str(jpg["dir_path"],info->dir_path,sizeof(info->dir_path));
 }
+static auto g_jpg_save_cfg = g_config.add<jpg_save_info_t>("jpg_save",JPG_SAVE_INFO_PATH,g_jpg_save_default,parse_jpg_save_info);
 
 typedef struct
 {
     int enable;
     char model_file[255];
     char cfg_file[255];
+    int burn_in;
+    int metadata;
+    int track_interval;
+    int roi_enable;
+    int roi_object_qp;
+    int roi_background_qp;
+    int roi_hold;
+    int roi_ab_period;
+    int motion_enable;
+    int motion_threshold;
+    int motion_min_blocks;
+    int motion_gate;
+    char post_type[32];
+    hisilicon::dev::yolov5_post_t post;
 }yolov5_info_t;
 static yolov5_info_t g_yolov5_info;
 #define YOLOV5_INFO_PATH "/opt/ceanic/yolov5/yolov5.json"
-static void init_yolov5_info()
-{
-    Json::Value root;
-
-    root["yolov5"]["enable"] = 0;
-    root["yolov5"]["model_file"] = "/opt/ceanic/yolov5/yolov5.om";
-    root["yolov5"]["cfg_file"] = "/opt/ceanic/yolov5/acl.json";
-    std::string str= root.toStyledString();
-    std::ofstream ofs;
-    ofs.open(YOLOV5_INFO_PATH);
-    ofs << str;
-    ofs.close();
+static const char* g_yolov5_default = R"({
+   "yolov5" : {
+      "burn_in" : 1,
+      "cfg_file" : "/opt/ceanic/yolov5/acl.json",
+      "enable" : 0,
+      "metadata" : 1,
+      "model_file" : "/opt/ceanic/yolov5/yolov5.om",
+      "motion" : {
+         "enable" : 0,
+         "gate" : 0,
+         "min_blocks" : 2,
+         "threshold" : 15
+      },
+      "post" : {
+         "type" : "npu"
+      },
+      "roi" : {
+         "ab_period" : 0,
+         "background_qp" : 4,
+         "enable" : 0,
+         "hold" : 25,
+         "object_qp" : -4
+      },
+      "track_interval" : 0
+   }
 }
+)";
 
-static int get_yolov5_info()
+static bool parse_yolov5_info(const Json::Value& root,yolov5_info_t* info)
 {
-    try
+    const Json::Value& yolov5 = root["yolov5"];
+    info->enable = yolov5["enable"].asInt();
+    if(!get_str(yolov5["model_file"],info->model_file,sizeof(info->model_file))
+            || !get_str(yolov5["cfg_file"],info->cfg_file,sizeof(info->cfg_file)))
+    {
+        return false;
+    }
+    //older files lack these,keep the burnt in stream3 and add the metadata track
+    info->burn_in = yolov5.isMember("burn_in") ? yolov5["burn_in"].asInt() : 1;
+    info->metadata = yolov5.isMember("metadata") ? yolov5["metadata"].asInt() : 1;
+    info->track_interval = yolov5.isMember("track_interval") ? yolov5["track_interval"].asInt() : 0;
+
+    const Json::Value& roi = yolov5["roi"];
+    info->roi_enable = roi["enable"].asInt();
+    info->roi_object_qp = roi.isMember("object_qp") ? roi["object_qp"].asInt() : -4;
+    info->roi_background_qp = roi.isMember("background_qp") ? roi["background_qp"].asInt() : 4;
+    info->roi_hold = roi.isMember("hold") ? roi["hold"].asInt() : 25;
+    info->roi_ab_period = roi.isMember("ab_period") ? roi["ab_period"].asInt() : 0;
+
+    const Json::Value& motion = yolov5["motion"];
+    info->motion_enable = motion["enable"].asInt();
+    info->motion_threshold = motion.isMember("threshold") ? motion["threshold"].asInt() : 15;
+    info->motion_min_blocks = motion.isMember("min_blocks") ? motion["min_blocks"].asInt() : 2;
+    info->motion_gate = motion.isMember("gate") ? motion["gate"].asInt() : 0;
+
+    //npu:the model ends in the roi/nms layers,yolov5/yolov8:raw heads decoded on the cpu
+    snprintf(info->post_type,sizeof(info->post_type),"npu");
+    info->post.param = ceanic::yolo::yolo_post::default_param();
+    if(yolov5.isMember("post"))
     {
-        if(access(YOLOV5_INFO_PATH,F_OK) < 0)
+        const Json::Value& post = yolov5["post"];
+        ceanic::yolo::yolo_post_param& param = info->post.param;
+        if(post.isMember("type") && !get_str(post["type"],info->post_type,sizeof(info->post_type)))
         {
-            init_yolov5_info();
-
-            if(access(YOLOV5_INFO_PATH,F_OK) < 0)
+            return false;
+        }
+        param.head = strcmp(info->post_type,"yolov8") == 0 ? ceanic::yolo::YOLO_HEAD_V8 : ceanic::yolo::YOLO_HEAD_V5;
+        param.num_classes = post.isMember("num_classes") ? post["num_classes"].asUInt() : param.num_classes;
+        param.score_threshold = post.isMember("score_threshold") ? (float)post["score_threshold"].asDouble() : param.score_threshold;
+        param.nms_threshold = post.isMember("nms_threshold") ? (float)post["nms_threshold"].asDouble() : param.nms_threshold;
+        param.score_logits = post.isMember("score_logits") ? post["score_logits"].asInt() : 0;
+        param.class_agnostic = post.isMember("class_agnostic") ? post["class_agnostic"].asInt() : 0;
+
+        //[[w,h,w,h,w,h],...] finest level first
+        const Json::Value& anchors = post["anchors"];
+        for(Json::Value::UInt l = 0; anchors.isArray() && l < anchors.size() && l < YOLO_MAX_LEVEL; l++)
+        {
+            for(Json::Value::UInt k = 0; k < anchors[l].size() && k < YOLO_ANCHOR_NUM * 2; k++)
             {
-                return -1;
+                param.anchors[l][k] = (float)anchors[l][k].asDouble();
             }
         }
 
-        std::ifstream ifs;
-        ifs.open(YOLOV5_INFO_PATH);
-        if(!ifs.is_open())
+        if(post.isMember("dump_file") && !get_str(post["dump_file"],info->post.dump_file,sizeof(info->post.dump_file)))
         {
-            return -1;
+            return false;
         }
-        Json::Reader reader;  
-        Json::Value root; 
-        if (!reader.parse(ifs, root, false)) 
-        {
-            return -1;
-        }
-
-        Json::Value node; 
-        g_yolov5_info.enable = root["yolov5"]["enable"].asInt();
-        sprintf(g_yolov5_info.model_file,"%s",root["yolov5"]["model_file"].asCString());
-        sprintf(g_yolov5_info.cfg_file,"%s",root["yolov5"]["cfg_file"].asCString());
-
-        ifs.close();
-
-        return 0;
-    }
-    catch(...)
-    {
-        return -1;
+        info->post.dump_frames = post.isMember("dump_frames") ? post["dump_frames"].asUInt() : 0;
     }
+
+    return strcmp(info->post_type,"npu") == 0 || strcmp(info->post_type,"yolov5") == 0 || strcmp(info->post_type,"yolov8") == 0;
 }
+static auto g_yolov5_cfg = g_config.add<yolov5_info_t>("yolov5",YOLOV5_INFO_PATH,g_yolov5_default,parse_yolov5_info);
 
 typedef struct
 {
@@ -631,62 +539,330 @@ typedef struct
 }vo_info_t;
 static vo_info_t g_vo_info;
 #define VO_INFO_PATH "/opt/ceanic/etc/vo.json"
-static void init_vo_info()
-{
-    Json::Value root;
+static const char* g_vo_default = R"({
+   "vo" : {
+      "enable" : 0,
+      "intf_sync" : "1080P60",
+      "intf_type" : "BT1120"
+   }
+}
+)";
 
-    root["vo"]["enable"] = 0;
-    root["vo"]["intf_type"] = "BT1120";
-    root["vo"]["intf_sync"] = "1080P60";
-    std::string str= root.toStyledString();
-    std::ofstream ofs;
-    ofs.open(VO_INFO_PATH);
-    ofs << str;
-    ofs.close();
+static bool parse_vo_info(const Json::Value& root,vo_info_t* info)
+{
+    info->enable = root["vo"]["enable"].asInt();
+    return get_str(root["vo"]["intf_type"],info->intf_type,sizeof(info->intf_type))
+        && get_str(root["vo"]["intf_sync"],info->intf_sync,sizeof(info->intf_sync));
 }
+static auto g_vo_cfg = g_config.add<vo_info_t>("vo",VO_INFO_PATH,g_vo_default,parse_vo_info);
 
-static int get_vo_info()
+static void show_info()
 {
-    try
+    printf("net service info\n");
+    printf("\trtsp port:%d\n",g_net_service_info.rtsp_port);
+    printf("\trtsp playback dir:%s\n",g_net_service_info.rtsp_playback_dir);
+    printf("\thttp port:%d\n",g_net_service_info.http_port);
+    printf("\trtmp enable:%d\n",g_net_service_info.rtmp_enable);
+    printf("\trtmp main url:%s\n",g_net_service_info.rtmp_main_url);
+    printf("\trtmp sub url:%s\n",g_net_service_info.rtmp_sub_url);
+
+    printf("jpg save info\n");
+    printf("\tenable:%d\n",g_jpg_save_info.enable);
+    printf("\tquality:%d\n",g_jpg_save_info.quality);
+    printf("\tinterval:%d\n",g_jpg_save_info.interval);
+    printf("\tdir_path:%s\n",g_jpg_save_info.dir_path);
+
+    printf("aiisp info\n");
+    printf("\tenable:%d\n",g_aiisp_info.enable);
+    printf("\tmode:%d\n",g_aiisp_info.mode);
+    printf("\tmodel_file:%s\n",g_aiisp_info.model_file);
+    printf("\tcache_mb:%d\n",g_aiisp_info.cache_mb);
+    for(unsigned int i = 0; i < g_aiisp_info.preload.size(); i++)
     {
-        if(access(VO_INFO_PATH,F_OK) < 0)
-        {
-            init_vo_info();
+        printf("\tpreload:%s\n",g_aiisp_info.preload[i].c_str());
+    }
 
-            if(access(VO_INFO_PATH,F_OK) < 0)
-            {
-                return -1;
-            }
-        }
+    for(auto i = 0; i < MAX_CHANNEL; i++)
+    {
+        printf("sensor%d:\n",i + 1);
+        printf("\tname:%s\n",g_vi_info.chn[i].name);
+    }
 
-        std::ifstream ifs;
-        ifs.open(VO_INFO_PATH);
-        if(!ifs.is_open())
-        {
-            return -1;
-        }
-        Json::Reader reader;  
-        Json::Value root; 
-        if (!reader.parse(ifs, root, false)) 
-        {
-            return -1;
-        }
+    for(auto i = 0; i < MAX_CHANNEL; i++)
+    {
+        printf("venc%d:\n",i + 1);
+        printf("\tname:%s\n",g_venc_info.chn[i].name);
+        printf("\tw:%d\n",g_venc_info.chn[i].w);
+        printf("\th:%d\n",g_venc_info.chn[i].h);
+        printf("\tfr:%d\n",g_venc_info.chn[i].fr);
+        printf("\tbitrate:%d\n",g_venc_info.chn[i].bitrate);
+        printf("\tmjpeg:%d %dx%d fr:%d quality:%d\n",g_venc_info.chn[i].mjpeg_enable,
+                g_venc_info.chn[i].mjpeg_w,g_venc_info.chn[i].mjpeg_h,g_venc_info.chn[i].mjpeg_fr,g_venc_info.chn[i].mjpeg_quality);
+    }
 
-        Json::Value node; 
-        g_vo_info.enable = root["vo"]["enable"].asInt();
-        sprintf(g_vo_info.intf_type,"%s",root["vo"]["intf_type"].asCString());
-        sprintf(g_vo_info.intf_sync,"%s",root["vo"]["intf_sync"].asCString());
+    printf("scene info\n");
+    printf("\tenable:%d\n",g_scene_info.enable);
+    printf("\tmode:%d\n",g_scene_info.mode);
+    printf("\tdir_path:%s\n",g_scene_info.dir_path);
 
-        ifs.close();
+    printf("rate auto info\n");
+    printf("\tenable:%d\n",g_rate_auto_info.enable);
+    printf("\tfile:%s\n",g_rate_auto_info.file);
 
-        return 0;
+    printf("mp4 save info\n");
+    printf("\tenable:%d\n",g_mp4_save_info.enable);
+    printf("\tfile:%s\n",g_mp4_save_info.file);
+    printf("\tqueue_size:%u\n",g_mp4_save_info.param.queue_size);
+    printf("\twrite_unit:%u\n",g_mp4_save_info.param.write_unit);
+    printf("\tprealloc_size:%u\n",g_mp4_save_info.param.prealloc_size);
+    printf("\tsync_interval:%u\n",g_mp4_save_info.param.sync_interval);
+    printf("\tmode:%d\n",g_mp4_save_info.mode);
+    printf("\tformat:%d\n",g_mp4_save_info.format);
+    if(g_mp4_save_info.enable && g_mp4_save_info.mode == 1)
+    {
+        printf("\tevent dir_path:%s\n",g_mp4_save_info.event.dir_path);
+        printf("\tevent pre_time:%u,post_time:%u\n",g_mp4_save_info.event.pre_time,g_mp4_save_info.event.post_time);
+        printf("\tevent segment_time:%u,max_segments:%u\n",g_mp4_save_info.event.segment_time,g_mp4_save_info.event.max_segments);
     }
-    catch(...)
+    else if(g_mp4_save_info.enable && g_mp4_save_info.format == 2)
     {
-        return -1;
+        printf("\tpool dir_path:%s\n",g_mp4_save_info.pool.dir_path);
+        printf("\tpool count:%u,segment_size:%llu,max_keys:%u\n",g_mp4_save_info.pool.count,(unsigned long long)g_mp4_save_info.pool.segment_size,g_mp4_save_info.pool.max_keys);
+    }
+
+    printf("yolov5 info\n");
+    printf("\tenable:%d\n",g_yolov5_info.enable);
+    printf("\tmodel_file:%s\n",g_yolov5_info.model_file);
+    printf("\tcfg_file:%s\n",g_yolov5_info.cfg_file);
+    printf("\tburn_in:%d\n",g_yolov5_info.burn_in);
+    printf("\tmetadata:%d\n",g_yolov5_info.metadata);
+    printf("\ttrack_interval:%d\n",g_yolov5_info.track_interval);
+    printf("\troi:enable %d,object_qp %d,background_qp %d,hold %d,ab_period %d\n",
+            g_yolov5_info.roi_enable,g_yolov5_info.roi_object_qp,g_yolov5_info.roi_background_qp,g_yolov5_info.roi_hold,g_yolov5_info.roi_ab_period);
+    printf("\tmotion:enable %d,threshold %d,min_blocks %d,gate %d\n",
+            g_yolov5_info.motion_enable,g_yolov5_info.motion_threshold,g_yolov5_info.motion_min_blocks,g_yolov5_info.motion_gate);
+    printf("\tpost:type %s,num_classes %d,score_threshold %.2f,nms_threshold %.2f\n",
+            g_yolov5_info.post_type,g_yolov5_info.post.param.num_classes,g_yolov5_info.post.param.score_threshold,g_yolov5_info.post.param.nms_threshold);
+    if(g_aiisp_info.enable && g_yolov5_info.enable)
+    {
+        printf("Warning:ai power is shared by aiisp and yolov5,which both are enabled!\n");
+    }
+
+    printf("vo info\n");
+    printf("\tenable:%d\n",g_vo_info.enable);
+    printf("\tintf_type:%s\n",g_vo_info.intf_type);
+    printf("\tintf_sync:%s\n",g_vo_info.intf_sync);
+}
+
+//a broken or refused file runs with the built-in default,the step fails so the dag reports it
+template<typename T>
+static bool read_info(const std::shared_ptr<ceanic::config::typed_file<T>>& file,T* info)
+{
+    bool ret = file->load();
+    if(!ret)
+    {
+        APP_WRITE_LOG_ERROR("read %s info failed,using the default",file->name().c_str());
+        if(!file->load_default())
+        {
+            APP_WRITE_LOG_ERROR("%s default refused",file->name().c_str());
+        }
     }
+    *info = *file->get();
+    return ret;
 }
 
+static std::shared_ptr<ceanic::rtsp::rtsp_server> g_rtsp_server;
+static std::shared_ptr<ceanic::rtsp::http_server> g_http_server;
+
+//what a file written while running changes,on the config watch thread.
+//the settings without a live path are logged and taken on the next start
+template<typename T>
+static void restart_needed(const std::shared_ptr<ceanic::config::typed_file<T>>& file,const char* what,
+        typename ceanic::config::typed_file<T>::diff_fun changed)
+{
+    std::string name = file->name();
+    file->subscribe("restart",changed,[name,what](const T&,const T&){
+            APP_WRITE_LOG_WARN("%s %s changed,applied on the next start",name.c_str(),what);
+            });
+}
+
+//for the structs of plain fields,zeroed before parsing
+template<typename T>
+static bool differ(const T& a,const T& b)
+{
+    return memcmp(&a,&b,sizeof(T)) != 0;
+}
+
+static void subscribe_config(int chn)
+{
+    //a new port is bound before the old server goes,a failed bind keeps the old one.
+    //the clients of the old port are dropped
+    g_net_service_cfg->subscribe("rtsp",
+            [](const net_service_t& o,const net_service_t& n){return o.rtsp_port != n.rtsp_port;},
+            [](const net_service_t& o,const net_service_t& n){
+                std::shared_ptr<ceanic::rtsp::rtsp_server> rs = std::make_shared<ceanic::rtsp::rtsp_server>(n.rtsp_port);
+                if(!rs->run())
+                {
+                    APP_WRITE_LOG_ERROR("rtsp port %d failed,stay on %d",n.rtsp_port,o.rtsp_port);
+                    return;
+                }
+                g_rtsp_server = rs;
+            });
+    g_net_service_cfg->subscribe("http",
+            [](const net_service_t& o,const net_service_t& n){return o.http_port != n.http_port;},
+            [](const net_service_t& o,const net_service_t& n){
+                std::shared_ptr<ceanic::rtsp::http_server> hs = std::make_shared<ceanic::rtsp::http_server>(n.http_port);
+                if(n.http_port > 0 && !hs->run())
+                {
+                    APP_WRITE_LOG_ERROR("http port %d failed,stay on %d",n.http_port,o.http_port);
+                    return;
+                }
+                g_http_server = hs;
+            });
+    g_net_service_cfg->subscribe("playback",
+            [](const net_service_t& o,const net_service_t& n){return strcmp(o.rtsp_playback_dir,n.rtsp_playback_dir) != 0;},
+            [](const net_service_t&,const net_service_t& n){
+                ceanic::rtsp::stream_manager::instance()->set_playback_dir(n.rtsp_playback_dir);
+            });
+    g_net_service_cfg->subscribe("rtmp",
+            [](const net_service_t& o,const net_service_t& n){
+                return o.rtmp_enable != n.rtmp_enable
+                    || strcmp(o.rtmp_main_url,n.rtmp_main_url) != 0
+                    || strcmp(o.rtmp_sub_url,n.rtmp_sub_url) != 0;
+            },
+            [chn](const net_service_t& o,const net_service_t& n){
+                if(o.rtmp_enable)
+                {
+                    ceanic::rtmp::session_manager::instance()->delete_session(chn,0,o.rtmp_main_url);
+                    ceanic::rtmp::session_manager::instance()->delete_session(chn,1,o.rtmp_sub_url);
+                }
+                if(n.rtmp_enable)
+                {
+                    ceanic::rtmp::session_manager::instance()->create_session(chn,0,n.rtmp_main_url);
+                    ceanic::rtmp::session_manager::instance()->create_session(chn,1,n.rtmp_sub_url);
+                }
+            });
+
+    //size,frame rate and bitrate go through reconfigure_stream,the consumers stay attached
+    g_venc_cfg->subscribe("venc",
+            [chn](const venc_info_t& o,const venc_info_t& n){
+                const venc_t& a = o.chn[chn];
+                const venc_t& b = n.chn[chn];
+                return a.w != b.w || a.h != b.h || a.fr != b.fr || a.bitrate != b.bitrate;
+            },
+            [chn](const venc_info_t&,const venc_info_t& n){
+                const venc_t& v = n.chn[chn];
+                if(!g_chn || !g_chn->reconfigure_stream(MAIN_STREAM_ID,v.w,v.h,v.fr,v.bitrate))
+                {
+                    APP_WRITE_LOG_ERROR("venc%d reconfigure %dx%d fr %d bitrate %d failed",chn + 1,v.w,v.h,v.fr,v.bitrate);
+                }
+            });
+    restart_needed<venc_info_t>(g_venc_cfg,"name/slice_lines/mjpeg",
+            [chn](const venc_info_t& o,const venc_info_t& n){
+                const venc_t& a = o.chn[chn];
+                const venc_t& b = n.chn[chn];
+                return strcmp(a.name,b.name) != 0 || a.slice_lines != b.slice_lines
+                    || a.mjpeg_enable != b.mjpeg_enable || a.mjpeg_w != b.mjpeg_w || a.mjpeg_h != b.mjpeg_h
+                    || a.mjpeg_fr != b.mjpeg_fr || a.mjpeg_quality != b.mjpeg_quality;
+            });
+
+    g_scene_cfg->subscribe("scene",
+            [](const scene_info_t& o,const scene_info_t& n){return o.mode != n.mode;},
+            [](const scene_info_t&,const scene_info_t& n){
+                if(g_scene_info.enable)
+                {
+                    chn_type::scene_set_mode(n.mode);
+                }
+            });
+    restart_needed<scene_info_t>(g_scene_cfg,"enable/dir_path",
+            [](const scene_info_t& o,const scene_info_t& n){return o.enable != n.enable || strcmp(o.dir_path,n.dir_path) != 0;});
+
+    //another model or mode while aiisp runs,its model cache makes the switch fast
+    g_aiisp_cfg->subscribe("aiisp",
+            [](const aiisp_info_t& o,const aiisp_info_t& n){return o.mode != n.mode || strcmp(o.model_file,n.model_file) != 0;},
+            [](const aiisp_info_t&,const aiisp_info_t& n){
+                if(g_aiisp_info.enable && g_chn && !g_chn->aiisp_switch(n.model_file,n.mode))
+                {
+                    APP_WRITE_LOG_ERROR("aiisp switch to %s mode %d failed",n.model_file,n.mode);
+                }
+            });
+    restart_needed<aiisp_info_t>(g_aiisp_cfg,"enable/cache_mb/preload",
+            [](const aiisp_info_t& o,const aiisp_info_t& n){return o.enable != n.enable || o.cache_mb != n.cache_mb || o.preload != n.preload;});
+
+    g_yolov5_cfg->subscribe("roi",
+            [](const yolov5_info_t& o,const yolov5_info_t& n){
+                return o.roi_enable != n.roi_enable || o.roi_object_qp != n.roi_object_qp || o.roi_background_qp != n.roi_background_qp
+                    || o.roi_hold != n.roi_hold || o.roi_ab_period != n.roi_ab_period;
+            },
+            [](const yolov5_info_t&,const yolov5_info_t& n){
+                if(!g_yolov5_info.enable || !g_chn)
+                {
+                    return;
+                }
+
+                g_chn->yolov5_roi_stop();
+                ceanic::roi::roi_qp_param roi_param = ceanic::roi::roi_qp_map::default_param();
+                roi_param.object_qp = n.roi_object_qp;
+                roi_param.background_qp = n.roi_background_qp;
+                roi_param.hold = n.roi_hold < 0 ? 0 : n.roi_hold;
+                uint32_t ab_period_ms = n.roi_ab_period > 0 ? n.roi_ab_period * 1000 : 0;
+                if(n.roi_enable && !g_chn->yolov5_roi_start(&roi_param,ab_period_ms))
+                {
+                    APP_WRITE_LOG_ERROR("yolov5 roi start failed");
+                }
+            });
+    g_yolov5_cfg->subscribe("motion",
+            [](const yolov5_info_t& o,const yolov5_info_t& n){
+                return o.motion_enable != n.motion_enable || o.motion_threshold != n.motion_threshold
+                    || o.motion_min_blocks != n.motion_min_blocks || o.motion_gate != n.motion_gate;
+            },
+            [](const yolov5_info_t&,const yolov5_info_t& n){
+                //thread_1s reads the motion events by the enable it started with
+                if(!g_yolov5_info.enable || !g_yolov5_info.motion_enable || !g_chn)
+                {
+                    return;
+                }
+
+                g_chn->yolov5_motion_stop();
+                ceanic::motion::motion_param motion_param = ceanic::motion::motion_detect::default_param();
+                motion_param.threshold = n.motion_threshold < 1 ? 1 : n.motion_threshold;
+                motion_param.min_blocks = n.motion_min_blocks < 1 ? 1 : n.motion_min_blocks;
+                if(n.motion_enable && !g_chn->yolov5_motion_start(&motion_param,n.motion_gate))
+                {
+                    APP_WRITE_LOG_ERROR("yolov5 motion start failed");
+                }
+            });
+    restart_needed<yolov5_info_t>(g_yolov5_cfg,"model/post",
+            [](const yolov5_info_t& o,const yolov5_info_t& n){
+                return o.enable != n.enable || strcmp(o.model_file,n.model_file) != 0 || strcmp(o.cfg_file,n.cfg_file) != 0
+                    || o.burn_in != n.burn_in || o.metadata != n.metadata || o.track_interval != n.track_interval
+                    || strcmp(o.post_type,n.post_type) != 0 || differ(o.post,n.post);
+            });
+
+    //thread_1s takes quality,interval and dir_path of the file each second,
+    //the vi/vpss mode of the snap is set up by the enable at the start
+    restart_needed<jpg_save_info_t>(g_jpg_save_cfg,"enable",
+            [](const jpg_save_info_t& o,const jpg_save_info_t& n){return o.enable != n.enable;});
+    restart_needed<vi_info_t>(g_vi_cfg,"sensor",differ<vi_info_t>);
+    restart_needed<rate_auto_info_t>(g_rate_auto_cfg,"settings",differ<rate_auto_info_t>);
+    restart_needed<mp4_save_info_t>(g_mp4_save_cfg,"settings",differ<mp4_save_info_t>);
+    restart_needed<vo_info_t>(g_vo_cfg,"settings",differ<vo_info_t>);
+
+    g_config.set_observer([](const ceanic::config::reload_result& r){
+            if(!r.ok)
+            {
+                APP_WRITE_LOG_ERROR("config %s reload refused,the old settings stay",r.name.c_str());
+                return;
+            }
+
+            std::string applied;
+            for(size_t i = 0; i < r.applied.size(); i++)
+            {
+                applied += (i ? "," : "") + r.applied[i];
+            }
+            APP_WRITE_LOG_INFO("config %s reloaded,changed:%s",r.name.c_str(),applied.empty() ? "none" : applied.c_str());
+            });
+}
 
 static std::thread g_thread_1s;
 static bool g_thread_run = false;
@@ -720,12 +896,40 @@ static void thread_1s()
                     v.is_exposure_stable);
         }
 
-        if(g_jpg_save_info.enable 
-                && cur_tm % g_jpg_save_info.interval == 0)
+        hisilicon::dev::yolov5_stat_t ys;
+        if(g_yolov5_info.enable
+                && cur_tm % 10 == 0
+                && g_chn->get_yolov5_stat(&ys))
+        {
+            APP_WRITE_LOG_DEBUG("yolov5 fps=%d,detect_fps=%d,frames=%llu,capture=%dus,infer=%dus,post=%dus,decode=%dus,motion=%dus,latency=%dus,npu_busy=%d%%,stall=%d",
+                    ys.fps,ys.detect_fps,(unsigned long long)ys.frames,ys.capture_us,ys.infer_us,ys.post_us,ys.decode_us,ys.motion_us,ys.latency_us,ys.npu_busy,ys.stall_cnt);
+        }
+
+        ceanic::motion::motion_event me;
+        while(g_yolov5_info.enable
+                && g_yolov5_info.motion_enable
+                && g_chn->get_yolov5_motion_event(&me))
+        {
+            if(me.type == ceanic::motion::MOTION_EVENT_START)
+            {
+                APP_WRITE_LOG_INFO("motion start,frame=%llu,blocks=%d,area=(%d,%d)-(%d,%d)",
+                        (unsigned long long)me.frame,me.blocks,me.x1,me.y1,me.x2,me.y2);
+            }
+            else
+            {
+                APP_WRITE_LOG_INFO("motion stop,frame=%llu",(unsigned long long)me.frame);
+            }
+        }
+
+        //the jpg settings of the file as it is now,a reload takes effect at the next second
+        std::shared_ptr<const jpg_save_info_t> jpg = g_jpg_save_cfg->get();
+        if(g_jpg_save_info.enable
+                && jpg->enable
+                && cur_tm % jpg->interval == 0)
         {
             char snap_file[512];
-            sprintf(snap_file,"%s/snap%d.jpg",g_jpg_save_info.dir_path,(uint32_t)cur_tm);
-            g_chn->trigger_jpg(snap_file,g_jpg_save_info.quality,"抓拍测试");
+            sprintf(snap_file,"%s/snap%d.jpg",jpg->dir_path,(uint32_t)cur_tm);
+            g_chn->trigger_jpg(snap_file,jpg->quality,"抓拍测试");
         }
     }
 
@@ -736,34 +940,38 @@ static void do_exit()
 {
     try
     {
+        g_config.stop_watch();
         g_thread_run = false;
         g_thread_1s.join();
 
         int chn = 0;
 
-        if(g_vo_info.enable)
+        if(g_vo_info.enable && g_chn)
         {
             g_chn->vo_stop();
         }
 
         if(g_yolov5_info.enable)
         {
-            g_chn->yolov5_stop();
+            if(g_chn)
+            {
+                g_chn->yolov5_stop();
+            }
             hisilicon::dev::svp::release();
         }
 
-        if(g_mp4_save_info.enable)
+        if(g_mp4_save_info.enable && g_chn)
         {
             g_chn->stop_save();
         }
 
         if(g_rate_auto_info.enable
-                && strstr(g_venc_info[chn].name,"AVBR") != NULL)
+                && strstr(g_venc_info.chn[chn].name,"AVBR") != NULL)
         {
             chn_type::rate_auto_release();
         }
 
-        if(g_aiisp_info.enable)
+        if(g_aiisp_info.enable && g_chn)
         {
             g_chn->aiisp_stop();
         }
@@ -837,152 +1045,269 @@ int main(int argc,char* argv[])
     g_rtmp_log = ceanic_start_log("ceanic_rtmp",CEANIC_LOG_MODE_CONSOLE,CEANIC_LOG_INFO,NULL,0);
     g_dev_log = ceanic_start_log("ceanic_dev",CEANIC_LOG_MODE_CONSOLE,CEANIC_LOG_INFO,NULL,0);
 
-    get_net_service_info();
-    printf("net service info\n");
-    printf("\trtsp port:%d\n",g_net_service_info.rtsp_port);
-    printf("\trtmp enable:%d\n",g_net_service_info.rtmp_enable);
-    printf("\trtmp main url:%s\n",g_net_service_info.rtmp_main_url);
-    printf("\trtmp sub url:%s\n",g_net_service_info.rtmp_sub_url);
-    ceanic::rtsp::stream_ops ops;
-    ops.request_i_frame_fun = chn_type::request_i_frame;
-    ops.get_stream_head_fun = chn_type::get_stream_head;
-    ceanic::rtsp::stream_manager::instance()->register_stream_ops(ops);
-    ceanic::rtsp::rtsp_server rs(g_net_service_info.rtsp_port);
-    if(!rs.run())
-    {
-        APP_WRITE_LOG_ERROR("Start rtsp server failed!!!");
-        return -1;
-    }
+    //boot steps and what they wait for,see doc/debug_log.md.
+    //the config files are read in parallel,the model files are read while vi/isp comes up,
+    //rtsp accepts connections at once and serves the main stream when the chn step is done
+    bool rtsp_ok = false;
+    ceanic::startup::startup_dag dag;
+
+    dag.add("cfg_net",{},[]{return read_info(g_net_service_cfg,&g_net_service_info);});
+    dag.add("cfg_jpg_save",{},[]{return read_info(g_jpg_save_cfg,&g_jpg_save_info);});
+    dag.add("cfg_aiisp",{},[]{return read_info(g_aiisp_cfg,&g_aiisp_info);});
+    dag.add("cfg_vi",{},[]{return read_info(g_vi_cfg,&g_vi_info);});
+    dag.add("cfg_venc",{},[]{return read_info(g_venc_cfg,&g_venc_info);});
+    dag.add("cfg_scene",{},[]{return read_info(g_scene_cfg,&g_scene_info);});
+    dag.add("cfg_rate_auto",{},[]{return read_info(g_rate_auto_cfg,&g_rate_auto_info);});
+    dag.add("cfg_mp4_save",{},[]{return read_info(g_mp4_save_cfg,&g_mp4_save_info);});
+    dag.add("cfg_yolov5",{},[]{return read_info(g_yolov5_cfg,&g_yolov5_info);});
+    dag.add("cfg_vo",{},[]{return read_info(g_vo_cfg,&g_vo_info);});
+    dag.add("show_info",{"cfg_net","cfg_jpg_save","cfg_aiisp","cfg_vi","cfg_venc","cfg_scene","cfg_rate_auto","cfg_mp4_save","cfg_yolov5","cfg_vo"},
+            []{show_info(); return true;});
+
+    dag.add("rtsp",{"cfg_net"},[&rtsp_ok,chn]{
+            ceanic::rtsp::stream_ops ops;
+            ops.request_i_frame_fun = chn_type::request_i_frame;
+            ops.get_stream_head_fun = chn_type::get_stream_head;
+            ceanic::rtsp::stream_manager::instance()->register_stream_ops(ops);
+            ceanic::rtsp::stream_manager::instance()->set_playback_dir(g_net_service_info.rtsp_playback_dir);
+            g_rtsp_server = std::make_shared<ceanic::rtsp::rtsp_server>(g_net_service_info.rtsp_port);
+            if(!g_rtsp_server->run())
+            {
+                APP_WRITE_LOG_ERROR("Start rtsp server failed!!!");
+                return false;
+            }
 
-    //rtmp
-    if(g_net_service_info.rtmp_enable)
-    {
-        ceanic::rtmp::session_manager::instance()->create_session(chn,0,g_net_service_info.rtmp_main_url);
-        ceanic::rtmp::session_manager::instance()->create_session(chn,1,g_net_service_info.rtmp_sub_url);
-    }
+            //http mjpeg,0 disables it
+            g_http_server = std::make_shared<ceanic::rtsp::http_server>(g_net_service_info.http_port);
+            if(g_net_service_info.http_port > 0 && !g_http_server->run())
+            {
+                APP_WRITE_LOG_ERROR("Start http server failed!!!");
+            }
 
-    //jpg save
-    get_jpg_save_info();
-    printf("jpg save info\n");
-    printf("\tenable:%d\n",g_jpg_save_info.enable);
-    printf("\tquality:%d\n",g_jpg_save_info.quality);
-    printf("\tinterval:%d\n",g_jpg_save_info.interval);
-    printf("\tdir_path:%s\n",g_jpg_save_info.dir_path);
+            //rtmp
+            if(g_net_service_info.rtmp_enable)
+            {
+                ceanic::rtmp::session_manager::instance()->create_session(chn,0,g_net_service_info.rtmp_main_url);
+                ceanic::rtmp::session_manager::instance()->create_session(chn,1,g_net_service_info.rtmp_sub_url);
+            }
+            rtsp_ok = true;
+            return true;
+            });
 
-    //aiisp
-    get_aiisp_info();
-    printf("aiisp info\n");
-    printf("\tenable:%d\n",g_aiisp_info.enable);
-    printf("\tmode:%d\n",g_aiisp_info.mode);
-    printf("\tmodel_file:%s\n",g_aiisp_info.model_file);
+    dag.add("sys",{"cfg_aiisp","cfg_jpg_save"},[]{
+            ot_vi_vpss_mode_type mode = OT_VI_ONLINE_VPSS_ONLINE;
+            if(g_aiisp_info.enable)
+            {
+                mode = OT_VI_OFFLINE_VPSS_OFFLINE;
+            }
+            else if(g_jpg_save_info.enable)
+            {
+                mode = OT_VI_ONLINE_VPSS_OFFLINE;
+            }
 
-    //chn init
-    ot_vi_vpss_mode_type mode = OT_VI_ONLINE_VPSS_ONLINE;
-    if(g_aiisp_info.enable)
-    {
-        mode = OT_VI_OFFLINE_VPSS_OFFLINE;
-    }
-    else if(g_jpg_save_info.enable)
-    {
-        mode = OT_VI_ONLINE_VPSS_OFFLINE;
-    }
+            return chn_type::init(mode);
+            });
 
-    chn_type::init(mode);
+    dag.add("chn",{"sys","cfg_vi","cfg_venc"},[chn]{
+            g_chn = std::make_shared<chn_type>(g_vi_info.chn[chn].name,g_venc_info.chn[chn].name,chn);
+            if(!g_chn->start(g_venc_info.chn[chn].w,g_venc_info.chn[chn].h,g_venc_info.chn[chn].fr,g_venc_info.chn[chn].bitrate,g_venc_info.chn[chn].slice_lines))
+            {
+                APP_WRITE_LOG_ERROR("Start chn failed!!!");
+                return false;
+            }
+            if(g_venc_info.chn[chn].mjpeg_enable
+                    && !g_chn->start_mjpeg(g_venc_info.chn[chn].mjpeg_w,g_venc_info.chn[chn].mjpeg_h,g_venc_info.chn[chn].mjpeg_fr,g_venc_info.chn[chn].mjpeg_quality))
+            {
+                APP_WRITE_LOG_ERROR("Start mjpeg failed!!!");
+            }
+            chn_type::start_capture(true);
+            return true;
+            });
 
-    //vi
-    get_vi_info();
-    for(auto i = 0; i < MAX_CHANNEL; i++)
-    {
-        printf("sensor%d:\n",i + 1);
-        printf("\tname:%s\n",g_vi_info[i].name);
-    }
+    //the model files come to mmz while vi/isp starts
+    dag.add("aiisp_model",{"sys","cfg_aiisp"},[]{
+            if(!g_aiisp_info.enable)
+            {
+                return true;
+            }
 
-    //venc
-    get_venc_info();
-    for(auto i = 0; i < MAX_CHANNEL; i++)
-    {
-        printf("venc%d:\n",i + 1);
-        printf("\tname:%s\n",g_venc_info[i].name);
-        printf("\tw:%d\n",g_venc_info[i].w);
-        printf("\th:%d\n",g_venc_info[i].h);
-        printf("\tfr:%d\n",g_venc_info[i].fr);
-        printf("\tbitrate:%d\n",g_venc_info[i].bitrate);
-    }
+            aiisp_model_cache::set_budget((td_u64)g_aiisp_info.cache_mb * 1024 * 1024);
+            aiisp_model_cache::preload(g_aiisp_info.model_file);
+            for(unsigned int i = 0; i < g_aiisp_info.preload.size(); i++)
+            {
+                aiisp_model_cache::preload(g_aiisp_info.preload[i].c_str());
+            }
+            return true;
+            });
 
-    g_chn = std::make_shared<chn_type>(g_vi_info[chn].name,g_venc_info[chn].name,chn);
-    g_chn->start(g_venc_info[chn].w,g_venc_info[chn].h,g_venc_info[chn].fr,g_venc_info[chn].bitrate);
-    chn_type::start_capture(true);
+    dag.add("aiisp",{"chn","aiisp_model"},[]{
+            if(!g_aiisp_info.enable)
+            {
+                return true;
+            }
 
-    //scene
-    get_scene_info();
-    printf("scene info\n");
-    printf("\tenable:%d\n",g_scene_info.enable);
-    printf("\tmode:%d\n",g_scene_info.mode);
-    printf("\tdir_path:%s\n",g_scene_info.dir_path);
-    if(g_scene_info.enable)
-    {
-        chn_type::scene_init(g_scene_info.dir_path);
-        chn_type::scene_set_mode(g_scene_info.mode);
-    }
+            bool ret = g_chn->aiisp_start(g_aiisp_info.model_file,g_aiisp_info.mode);
+            aiisp_model_cache_stat stat;
+            aiisp_model_cache::get_stat(&stat);
+            printf("aiisp model cache:%u models,%llu bytes,last load %lluus\n",
+                    stat.models,(unsigned long long)stat.bytes,(unsigned long long)stat.last_load_us);
+            if(!ret)
+            {
+                //scene and rate_auto only wait for aiisp to keep the isp order,
+                //a failed aiisp must not skip them
+                printf("aiisp start failed\n");
+            }
+            return true;
+            });
 
-    //aiisp
-    if(g_aiisp_info.enable)
-    {
-        g_chn->aiisp_start(g_aiisp_info.model_file,g_aiisp_info.mode);
-    }
+    dag.add("scene",{"chn","aiisp","cfg_scene"},[]{
+            if(g_scene_info.enable)
+            {
+                chn_type::scene_init(g_scene_info.dir_path);
+                chn_type::scene_set_mode(g_scene_info.mode);
+            }
+            return true;
+            });
 
-    //rate auto
-    get_rate_auto_info();
-    printf("rate auto info\n");
-    printf("\tenable:%d\n",g_rate_auto_info.enable);
-    printf("\tfile:%s\n",g_rate_auto_info.file);
-    if(g_rate_auto_info.enable
-            && strstr(g_venc_info[chn].name,"AVBR") != NULL)
-    {
-        //only avbr support rate auto
-        chn_type::rate_auto_init(g_rate_auto_info.file);
-    }
+    dag.add("rate_auto",{"chn","scene","cfg_rate_auto"},[chn]{
+            if(g_rate_auto_info.enable
+                    && strstr(g_venc_info.chn[chn].name,"AVBR") != NULL)
+            {
+                //only avbr support rate auto
+                chn_type::rate_auto_init(g_rate_auto_info.file);
+            }
+            return true;
+            });
 
-    //mp4 save
-    get_mp4_save_info();
-    printf("mp4 save info\n");
-    printf("\tenable:%d\n",g_mp4_save_info.enable);
-    printf("\tfile:%s\n",g_mp4_save_info.file);
-    if(g_mp4_save_info.enable)
-    {
-        g_chn->start_save(g_mp4_save_info.file);
-    }
+    dag.add("mp4_save",{"chn","cfg_mp4_save"},[]{
+            if(g_mp4_save_info.enable && g_mp4_save_info.mode == 1)
+            {
+                g_chn->start_event_save(&g_mp4_save_info.event);
+            }
+            else if(g_mp4_save_info.enable && g_mp4_save_info.format == 1)
+            {
+                ceanic::stream_save::fmp4_save_param param = ceanic::stream_save::fmp4_save::default_param();
+                param.queue_size = g_mp4_save_info.param.queue_size;
+                param.sync_interval = g_mp4_save_info.param.sync_interval;
+                param.stat_interval = g_mp4_save_info.param.stat_interval;
+                g_chn->start_fmp4_save(g_mp4_save_info.file,&param);
+            }
+            else if(g_mp4_save_info.enable && g_mp4_save_info.format == 2)
+            {
+                ceanic::stream_save::fmp4_save_param param = ceanic::stream_save::fmp4_save::default_param();
+                param.queue_size = g_mp4_save_info.param.queue_size;
+                param.sync_interval = g_mp4_save_info.param.sync_interval;
+                param.stat_interval = g_mp4_save_info.param.stat_interval;
+                g_chn->start_pool_save(&g_mp4_save_info.pool,&param);
+            }
+            else if(g_mp4_save_info.enable)
+            {
+                g_chn->start_save(g_mp4_save_info.file,&g_mp4_save_info.param);
+            }
+            return true;
+            });
 
-    //yolov5
-    get_yolov5_info();
-    printf("yolov5 info\n");
-    printf("\tenable:%d\n",g_yolov5_info.enable);
-    printf("\tmodel_file:%s\n",g_yolov5_info.model_file);
-    printf("\tcfg_file:%s\n",g_yolov5_info.cfg_file);
-    if(g_aiisp_info.enable && g_yolov5_info.enable)
-    {
-        printf("Warning:ai power is shared by aiisp and yolov5,which both are enabled!\n");
-    }
-    if(g_yolov5_info.enable)
+    //the yolov5 model does not wait for the isp,its file is read to the page cache meanwhile
+    dag.add("yolov5_model",{"cfg_yolov5"},[]{
+            if(g_yolov5_info.enable)
+            {
+                ceanic::startup::prefetch_file(g_yolov5_info.model_file);
+            }
+            return true;
+            });
+
+    dag.add("svp",{"sys","cfg_yolov5"},[]{
+            if(g_yolov5_info.enable)
+            {
+                return hisilicon::dev::svp::init(g_yolov5_info.cfg_file);
+            }
+            return true;
+            });
+
+    dag.add("yolov5",{"chn","svp","yolov5_model"},[]{
+            if(!g_yolov5_info.enable)
+            {
+                return true;
+            }
+
+            bool cpu_post = strcmp(g_yolov5_info.post_type,"npu") != 0;
+            if(!g_chn->yolov5_start(g_yolov5_info.model_file,g_yolov5_info.burn_in,g_yolov5_info.metadata,g_yolov5_info.track_interval < 0 ? 0 : g_yolov5_info.track_interval,
+                        cpu_post ? &g_yolov5_info.post : NULL))
+            {
+                return false;
+            }
+
+            if(g_yolov5_info.roi_enable)
+            {
+                ceanic::roi::roi_qp_param roi_param = ceanic::roi::roi_qp_map::default_param();
+                roi_param.object_qp = g_yolov5_info.roi_object_qp;
+                roi_param.background_qp = g_yolov5_info.roi_background_qp;
+                roi_param.hold = g_yolov5_info.roi_hold < 0 ? 0 : g_yolov5_info.roi_hold;
+                uint32_t ab_period_ms = g_yolov5_info.roi_ab_period > 0 ? g_yolov5_info.roi_ab_period * 1000 : 0;
+                if(!g_chn->yolov5_roi_start(&roi_param,ab_period_ms))
+                {
+                    printf("yolov5 roi start failed\n");
+                }
+            }
+
+            if(g_yolov5_info.motion_enable)
+            {
+                ceanic::motion::motion_param motion_param = ceanic::motion::motion_detect::default_param();
+                motion_param.threshold = g_yolov5_info.motion_threshold < 1 ? 1 : g_yolov5_info.motion_threshold;
+                motion_param.min_blocks = g_yolov5_info.motion_min_blocks < 1 ? 1 : g_yolov5_info.motion_min_blocks;
+                if(!g_chn->yolov5_motion_start(&motion_param,g_yolov5_info.motion_gate))
+                {
+                    printf("yolov5 motion start failed\n");
+                }
+            }
+            return true;
+            });
+
+    dag.add("vo",{"chn","cfg_vo"},[]{
+            if(g_vo_info.enable)
+            {
+                return g_chn->vo_start(g_vo_info.intf_type,g_vo_info.intf_sync);
+            }
+            return true;
+            });
+
+    dag.set_observer([](const ceanic::startup::step_result& r){
+            if(r.skipped)
+            {
+                APP_WRITE_LOG_ERROR("startup %s skipped",r.name.c_str());
+            }
+            else
+            {
+                APP_WRITE_LOG_INFO("startup %s %s,%llu-%lluus(%lluus),worker %u",r.name.c_str(),r.ok ? "ok" : "failed",
+                        (unsigned long long)r.begin_us,(unsigned long long)r.end_us,(unsigned long long)(r.end_us - r.begin_us),r.worker);
+            }
+            });
+
+    dag.run(STARTUP_THREADS);
+
+    std::string path;
+    std::vector<std::string> critical = dag.critical_path();
+    for(size_t i = 0; i < critical.size(); i++)
     {
-        hisilicon::dev::svp::init(g_yolov5_info.cfg_file);
-        g_chn->yolov5_start(g_yolov5_info.model_file);
+        path += (i ? "->" : "") + critical[i];
     }
+    APP_WRITE_LOG_INFO("startup %lluus,critical path %s",(unsigned long long)dag.total_us(),path.c_str());
 
-    //vo
-    get_vo_info();
-    printf("vo info\n");
-    printf("\tenable:%d\n",g_vo_info.enable);
-    printf("\tintf_type:%s\n",g_vo_info.intf_type);
-    printf("\tintf_sync:%s\n",g_vo_info.intf_sync);
-    if(g_vo_info.enable)
+    if(!rtsp_ok)
     {
-        g_chn->vo_start(g_vo_info.intf_type,g_vo_info.intf_sync);
+        do_exit();
+        return -1;
     }
 
     g_thread_run = true;
     g_thread_1s = std::thread(thread_1s);
 
+    subscribe_config(chn);
+    if(!g_config.start_watch())
+    {
+        APP_WRITE_LOG_ERROR("config watch failed,the files are read at the start only");
+    }
+
     while(1)
     {
         sleep(1);
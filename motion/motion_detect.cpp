@@ -0,0 +1,337 @@
+#include "motion_detect.h"
+#include <string.h>
+#include <algorithm>
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace ceanic{namespace motion{
+
+//events nobody fetched,the oldest are dropped
+#define MOTION_MAX_EVENTS 64
+
+    motion_param motion_detect::default_param()
+    {
+        motion_param param;
+        memset(&param,0,sizeof(param));
+        param.scale = 4;
+        param.block = 8;
+        param.threshold = 15;
+        param.bg_shift = 5;
+        param.min_blocks = 2;
+        param.trigger_frames = 3;
+        param.release_frames = 25;
+        param.use_neon = true;
+        return param;
+    }
+
+    bool motion_detect::has_neon()
+    {
+#if defined(__ARM_NEON)
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    motion_detect::motion_detect(uint32_t w,uint32_t h,const motion_param* param)
+        :m_param(param ? *param : default_param()),m_w(w),m_h(h),m_small(NULL)
+    {
+        if(m_param.scale != 1 && m_param.scale != 2 && m_param.scale != 4 && m_param.scale != 8)
+        {
+            m_param.scale = 4;
+        }
+        //the row sums are 16 bits
+        m_param.block = std::min(std::max(m_param.block,1u),256u);
+        m_param.bg_shift = std::min(m_param.bg_shift,14u);
+        m_neon = m_param.use_neon && has_neon();
+
+        m_small_w = m_w / m_param.scale;
+        m_small_h = m_h / m_param.scale;
+        m_grid_w = m_small_w / m_param.block;
+        m_grid_h = m_small_h / m_param.block;
+
+        m_pyramid[0].resize((m_w / 2 + 1) * (m_h / 2 + 1));
+        m_pyramid[1].resize((m_w / 4 + 1) * (m_h / 4 + 1));
+        m_bg.resize(m_small_w * m_small_h);
+        m_acc.resize(m_small_w);
+        m_grid.resize(m_grid_w * m_grid_h);
+        m_level.resize(m_grid_w * m_grid_h);
+        reset();
+    }
+
+    motion_detect::~motion_detect()
+    {
+    }
+
+    void motion_detect::reset()
+    {
+        m_has_bg = false;
+        m_frame = 0;
+        m_motion_run = 0;
+        m_still_run = 0;
+        m_in_motion = false;
+        m_events.clear();
+        std::fill(m_grid.begin(),m_grid.end(),0);
+        std::fill(m_level.begin(),m_level.end(),0);
+    }
+
+    const std::vector<uint8_t>& motion_detect::grid()
+    {
+        return m_grid;
+    }
+
+    const std::vector<uint8_t>& motion_detect::level()
+    {
+        return m_level;
+    }
+
+    uint32_t motion_detect::grid_w()
+    {
+        return m_grid_w;
+    }
+
+    uint32_t motion_detect::grid_h()
+    {
+        return m_grid_h;
+    }
+
+    bool motion_detect::in_motion()
+    {
+        return m_in_motion;
+    }
+
+    bool motion_detect::get_event(motion_event* event)
+    {
+        if(m_events.empty())
+        {
+            return false;
+        }
+
+        *event = m_events.front();
+        m_events.pop_front();
+        return true;
+    }
+
+    void motion_detect::halve_scalar(const uint8_t* src0,const uint8_t* src1,uint32_t w,uint8_t* dst)
+    {
+        for(uint32_t x = 0; x + 1 < w; x += 2)
+        {
+            dst[x / 2] = (src0[x] + src0[x + 1] + src1[x] + src1[x + 1] + 2) >> 2;
+        }
+    }
+
+    void motion_detect::diff_scalar(const uint8_t* cur,uint16_t* bg,uint16_t* acc,uint32_t w,uint32_t shift)
+    {
+        for(uint32_t x = 0; x < w; x++)
+        {
+            int32_t d = cur[x] - (bg[x] >> 7);
+            acc[x] += d < 0 ? -d : d;
+
+            int16_t delta = (int16_t)((cur[x] << 7) - bg[x]);
+            bg[x] = (uint16_t)(bg[x] + (delta >> shift));
+        }
+    }
+
+#if defined(__ARM_NEON)
+    void motion_detect::halve_neon(const uint8_t* src0,const uint8_t* src1,uint32_t w,uint8_t* dst)
+    {
+        uint32_t x = 0;
+        for(; x + 32 <= w; x += 32)
+        {
+            //pairwise sums of the top row,plus the bottom row,then a rounding /4
+            uint16x8_t s0 = vpadalq_u8(vpaddlq_u8(vld1q_u8(src0 + x)),vld1q_u8(src1 + x));
+            uint16x8_t s1 = vpadalq_u8(vpaddlq_u8(vld1q_u8(src0 + x + 16)),vld1q_u8(src1 + x + 16));
+            vst1q_u8(dst + x / 2,vcombine_u8(vrshrn_n_u16(s0,2),vrshrn_n_u16(s1,2)));
+        }
+        halve_scalar(src0 + x,src1 + x,w - x,dst + x / 2);
+    }
+
+    void motion_detect::diff_neon(const uint8_t* cur,uint16_t* bg,uint16_t* acc,uint32_t w,uint32_t shift)
+    {
+        int16x8_t vshift = vdupq_n_s16(-(int16_t)shift);
+        uint32_t x = 0;
+        for(; x + 16 <= w; x += 16)
+        {
+            uint8x16_t c = vld1q_u8(cur + x);
+            uint16x8_t b0 = vld1q_u16(bg + x);
+            uint16x8_t b1 = vld1q_u16(bg + x + 8);
+
+            uint8x16_t d = vabdq_u8(c,vcombine_u8(vshrn_n_u16(b0,7),vshrn_n_u16(b1,7)));
+            vst1q_u16(acc + x,vaddw_u8(vld1q_u16(acc + x),vget_low_u8(d)));
+            vst1q_u16(acc + x + 8,vaddw_u8(vld1q_u16(acc + x + 8),vget_high_u8(d)));
+
+            int16x8_t d0 = vsubq_s16(vreinterpretq_s16_u16(vshll_n_u8(vget_low_u8(c),7)),vreinterpretq_s16_u16(b0));
+            int16x8_t d1 = vsubq_s16(vreinterpretq_s16_u16(vshll_n_u8(vget_high_u8(c),7)),vreinterpretq_s16_u16(b1));
+            vst1q_u16(bg + x,vreinterpretq_u16_s16(vaddq_s16(vreinterpretq_s16_u16(b0),vshlq_s16(d0,vshift))));
+            vst1q_u16(bg + x + 8,vreinterpretq_u16_s16(vaddq_s16(vreinterpretq_s16_u16(b1),vshlq_s16(d1,vshift))));
+        }
+        diff_scalar(cur + x,bg + x,acc + x,w - x,shift);
+    }
+#endif
+
+    void motion_detect::halve(const uint8_t* src0,const uint8_t* src1,uint32_t w,uint8_t* dst)
+    {
+#if defined(__ARM_NEON)
+        if(m_neon)
+        {
+            halve_neon(src0,src1,w,dst);
+            return;
+        }
+#endif
+        halve_scalar(src0,src1,w,dst);
+    }
+
+    void motion_detect::diff(const uint8_t* cur,uint16_t* bg,uint16_t* acc,uint32_t w)
+    {
+#if defined(__ARM_NEON)
+        if(m_neon)
+        {
+            diff_neon(cur,bg,acc,w,m_param.bg_shift);
+            return;
+        }
+#endif
+        diff_scalar(cur,bg,acc,w,m_param.bg_shift);
+    }
+
+    void motion_detect::downsample(const uint8_t* luma,uint32_t stride)
+    {
+        if(m_param.scale == 1)
+        {
+            m_small = luma;
+            return;
+        }
+
+        //2x2 averages level by level,the levels alternate between the two buffers
+        const uint8_t* src = luma;
+        uint32_t src_stride = stride;
+        uint32_t w = m_w;
+        uint32_t h = m_h;
+        int out = 0;
+        for(uint32_t s = m_param.scale; s > 1; s /= 2)
+        {
+            uint8_t* dst = m_pyramid[out].data();
+            uint32_t dst_w = w / 2;
+            for(uint32_t y = 0; y < h / 2; y++)
+            {
+                const uint8_t* row = src + 2 * y * src_stride;
+                halve(row,row + src_stride,dst_w * 2,dst + y * dst_w);
+            }
+
+            src = dst;
+            src_stride = dst_w;
+            w = dst_w;
+            h /= 2;
+            out ^= 1;
+        }
+        m_small = src;
+    }
+
+    uint32_t motion_detect::process(const uint8_t* luma,uint32_t stride)
+    {
+        downsample(luma,stride);
+        uint32_t small_stride = m_param.scale == 1 ? stride : m_small_w;
+
+        if(!m_has_bg)
+        {
+            for(uint32_t y = 0; y < m_small_h; y++)
+            {
+                const uint8_t* row = m_small + y * small_stride;
+                for(uint32_t x = 0; x < m_small_w; x++)
+                {
+                    m_bg[y * m_small_w + x] = row[x] << 7;
+                }
+            }
+            m_has_bg = true;
+            m_frame++;
+            return 0;
+        }
+
+        uint32_t blocks = 0;
+        uint32_t gx1 = m_grid_w,gy1 = m_grid_h,gx2 = 0,gy2 = 0;
+        uint32_t cell_area = m_param.block * m_param.block;
+        for(uint32_t y = 0; y < m_small_h; y++)
+        {
+            if(y % m_param.block == 0)
+            {
+                std::fill(m_acc.begin(),m_acc.end(),0);
+            }
+            diff(m_small + y * small_stride,&m_bg[y * m_small_w],m_acc.data(),m_small_w);
+
+            uint32_t gy = y / m_param.block;
+            if((y + 1) % m_param.block != 0 || gy >= m_grid_h)
+            {
+                continue;
+            }
+
+            for(uint32_t gx = 0; gx < m_grid_w; gx++)
+            {
+                uint32_t sum = 0;
+                const uint16_t* acc = &m_acc[gx * m_param.block];
+                for(uint32_t i = 0; i < m_param.block; i++)
+                {
+                    sum += acc[i];
+                }
+
+                uint32_t level = sum / cell_area;
+                uint32_t idx = gy * m_grid_w + gx;
+                m_level[idx] = level;
+                m_grid[idx] = level >= m_param.threshold ? 1 : 0;
+                if(m_grid[idx])
+                {
+                    blocks++;
+                    gx1 = std::min(gx1,gx);
+                    gy1 = std::min(gy1,gy);
+                    gx2 = std::max(gx2,gx + 1);
+                    gy2 = std::max(gy2,gy + 1);
+                }
+            }
+        }
+
+        if(blocks >= m_param.min_blocks && blocks > 0)
+        {
+            m_motion_run++;
+            m_still_run = 0;
+            if(!m_in_motion && m_motion_run >= m_param.trigger_frames)
+            {
+                m_in_motion = true;
+                push_event(MOTION_EVENT_START,blocks);
+                uint32_t cell = m_param.block * m_param.scale;
+                motion_event& e = m_events.back();
+                e.x1 = gx1 * cell;
+                e.y1 = gy1 * cell;
+                e.x2 = gx2 * cell;
+                e.y2 = gy2 * cell;
+            }
+        }
+        else
+        {
+            m_still_run++;
+            m_motion_run = 0;
+            if(m_in_motion && m_still_run >= m_param.release_frames)
+            {
+                m_in_motion = false;
+                push_event(MOTION_EVENT_STOP,blocks);
+            }
+        }
+
+        m_frame++;
+        return blocks;
+    }
+
+    void motion_detect::push_event(uint32_t type,uint32_t blocks)
+    {
+        if(m_events.size() >= MOTION_MAX_EVENTS)
+        {
+            m_events.pop_front();
+        }
+
+        motion_event e;
+        memset(&e,0,sizeof(e));
+        e.type = type;
+        e.frame = m_frame;
+        e.blocks = blocks;
+        m_events.push_back(e);
+    }
+
+}}//namespace
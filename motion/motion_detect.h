@@ -0,0 +1,112 @@
+#ifndef motion_detect_include_h
+#define motion_detect_include_h
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+#include <deque>
+
+namespace ceanic{namespace motion{
+
+    typedef struct
+    {
+        uint32_t scale;             //luma is averaged over scale x scale pixels first,1,2,4 or 8
+        uint32_t block;             //grid cell in downsampled pixels
+        uint32_t threshold;         //mean difference to the background(0..255) of a moving cell
+        uint32_t bg_shift;          //the background moves 1/2^bg_shift of the way to each frame
+        uint32_t min_blocks;        //moving cells of a motion frame
+        uint32_t trigger_frames;    //motion frames in a row that start an event
+        uint32_t release_frames;    //still frames in a row that end it
+        bool use_neon;              //false forces the scalar kernels,ignored without neon
+    }motion_param;
+
+    enum
+    {
+        MOTION_EVENT_START = 0,
+        MOTION_EVENT_STOP,
+    };
+
+    typedef struct
+    {
+        uint32_t type;      //MOTION_EVENT_START/STOP
+        uint64_t frame;     //index of the frame that raised it
+        uint32_t blocks;    //moving cells of that frame
+        uint32_t x1;        //moving area,pixels of the source luma(start only)
+        uint32_t y1;
+        uint32_t x2;
+        uint32_t y2;
+    }motion_event;
+
+    //motion from downsampled luma against a running background.
+    //per frame:a 2x2 averaging pyramid down to 1/scale,then per cell the sum of
+    //absolute differences to the background,which follows the picture slowly so
+    //light changes and parked objects fade in.not thread safe
+    class motion_detect
+    {
+        public:
+            motion_detect(uint32_t w,uint32_t h,const motion_param* param = NULL);
+            virtual ~motion_detect();
+
+        public:
+            //one frame of luma(w x h),returns the moving cells
+            uint32_t process(const uint8_t* luma,uint32_t stride);
+
+            //grid_w() x grid_h(),1 for a moving cell
+            const std::vector<uint8_t>& grid();
+            //mean difference per cell
+            const std::vector<uint8_t>& level();
+            uint32_t grid_w();
+            uint32_t grid_h();
+
+            bool in_motion();
+            //oldest pending event
+            bool get_event(motion_event* event);
+
+            void reset();
+
+            static motion_param default_param();
+            static bool has_neon();
+
+        public:
+            //kernels,public for the bit exactness tests and the benchmark.
+            //halve:dst[x] = (a + b + c + d + 2) >> 2 over 2x2 pixels,w even
+            static void halve_scalar(const uint8_t* src0,const uint8_t* src1,uint32_t w,uint8_t* dst);
+            //diff:acc[x] += |cur[x] - (bg[x] >> 7)|,bg[x] += ((cur[x] << 7) - bg[x]) >> shift
+            static void diff_scalar(const uint8_t* cur,uint16_t* bg,uint16_t* acc,uint32_t w,uint32_t shift);
+#if defined(__ARM_NEON)
+            static void halve_neon(const uint8_t* src0,const uint8_t* src1,uint32_t w,uint8_t* dst);
+            static void diff_neon(const uint8_t* cur,uint16_t* bg,uint16_t* acc,uint32_t w,uint32_t shift);
+#endif
+
+        private:
+            void downsample(const uint8_t* luma,uint32_t stride);
+            void halve(const uint8_t* src0,const uint8_t* src1,uint32_t w,uint8_t* dst);
+            void diff(const uint8_t* cur,uint16_t* bg,uint16_t* acc,uint32_t w);
+            void push_event(uint32_t type,uint32_t blocks);
+
+        private:
+            motion_param m_param;
+            bool m_neon;
+            uint32_t m_w;
+            uint32_t m_h;
+            uint32_t m_small_w;
+            uint32_t m_small_h;
+            uint32_t m_grid_w;
+            uint32_t m_grid_h;
+            std::vector<uint8_t> m_pyramid[2];
+            const uint8_t* m_small;
+            std::vector<uint16_t> m_bg;    //q7
+            std::vector<uint16_t> m_acc;
+            std::vector<uint8_t> m_grid;
+            std::vector<uint8_t> m_level;
+            bool m_has_bg;
+            uint64_t m_frame;
+            uint32_t m_motion_run;
+            uint32_t m_still_run;
+            bool m_in_motion;
+            std::deque<motion_event> m_events;
+    };
+
+}}//namespace
+
+#endif
@@ -0,0 +1,348 @@
+#include "roi_qp_map.h"
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+
+namespace ceanic{namespace roi{
+
+    roi_qp_param roi_qp_map::default_param()
+    {
+        roi_qp_param param;
+        memset(&param,0,sizeof(param));
+        param.object_qp = -4;
+        param.background_qp = 4;
+        param.max_num = 8;
+        param.align = 16;
+        param.margin = 0.1f;
+        param.min_score = 0.3f;
+        param.hold = 25;
+        param.shrink_ratio = 0.5f;
+        return param;
+    }
+
+    roi_qp_map::roi_qp_map(uint32_t src_w,uint32_t src_h,uint32_t dst_w,uint32_t dst_h,const roi_qp_param* param)
+        :m_param(param ? *param : default_param()),m_src_w(src_w ? src_w : 1),m_src_h(src_h ? src_h : 1)
+    {
+        if(m_param.align == 0)
+        {
+            m_param.align = 1;
+        }
+
+        //regions stay inside the aligned picture,a partial macroblock row keeps the rc qp
+        m_dst_w = dst_w / m_param.align * m_param.align;
+        m_dst_h = dst_h / m_param.align * m_param.align;
+        make_regions();
+    }
+
+    roi_qp_map::~roi_qp_map()
+    {
+    }
+
+    void roi_qp_map::reset()
+    {
+        m_held.clear();
+        make_regions();
+    }
+
+    const std::vector<roi_region>& roi_qp_map::regions()
+    {
+        return m_regions;
+    }
+
+    uint32_t roi_qp_map::object_count()
+    {
+        return m_held.size();
+    }
+
+    int64_t roi_qp_map::area(const rect_t& r)
+    {
+        return (int64_t)(r.x2 - r.x1) * (r.y2 - r.y1);
+    }
+
+    bool roi_qp_map::overlap(const rect_t& a,const rect_t& b)
+    {
+        return a.x1 < b.x2 && b.x1 < a.x2 && a.y1 < b.y2 && b.y1 < a.y2;
+    }
+
+    bool roi_qp_map::contain(const rect_t& outer,const rect_t& inner)
+    {
+        return outer.x1 <= inner.x1 && outer.y1 <= inner.y1 && outer.x2 >= inner.x2 && outer.y2 >= inner.y2;
+    }
+
+    roi_qp_map::rect_t roi_qp_map::unite(const rect_t& a,const rect_t& b)
+    {
+        rect_t r;
+        r.x1 = std::min(a.x1,b.x1);
+        r.y1 = std::min(a.y1,b.y1);
+        r.x2 = std::max(a.x2,b.x2);
+        r.y2 = std::max(a.y2,b.y2);
+        return r;
+    }
+
+    bool roi_qp_map::to_rect(const roi_box& box,rect_t* r)
+    {
+        float sx = (float)m_dst_w / m_src_w;
+        float sy = (float)m_dst_h / m_src_h;
+        float mx = (box.x2 - box.x1) * m_param.margin;
+        float my = (box.y2 - box.y1) * m_param.margin;
+        float x1 = (box.x1 - mx) * sx;
+        float y1 = (box.y1 - my) * sy;
+        float x2 = (box.x2 + mx) * sx;
+        float y2 = (box.y2 + my) * sy;
+
+        //outwards to the alignment,then into the picture
+        int32_t a = m_param.align;
+        r->x1 = std::max((int32_t)floorf(x1 / a) * a,0);
+        r->y1 = std::max((int32_t)floorf(y1 / a) * a,0);
+        r->x2 = std::min((int32_t)ceilf(x2 / a) * a,m_dst_w);
+        r->y2 = std::min((int32_t)ceilf(y2 / a) * a,m_dst_h);
+        return r->x2 > r->x1 && r->y2 > r->y1;
+    }
+
+    bool roi_qp_map::merge_overlapped(std::vector<held_t>& held)
+    {
+        bool merged = false;
+        bool again = true;
+        while(again)
+        {
+            again = false;
+            for(size_t i = 0; i < held.size() && !again; i++)
+            {
+                for(size_t j = i + 1; j < held.size(); j++)
+                {
+                    if(!overlap(held[i].r,held[j].r))
+                    {
+                        continue;
+                    }
+
+                    held[i].r = unite(held[i].r,held[j].r);
+                    held[i].hold = std::max(held[i].hold,held[j].hold);
+                    held.erase(held.begin() + j);
+                    merged = again = true;
+                    break;
+                }
+            }
+        }
+        return merged;
+    }
+
+    bool roi_qp_map::update(const std::vector<roi_box>& boxes)
+    {
+        std::vector<held_t> dets;
+        for(size_t i = 0; i < boxes.size(); i++)
+        {
+            held_t h;
+            if(boxes[i].score >= m_param.min_score && to_rect(boxes[i],&h.r))
+            {
+                h.hold = m_param.hold;
+                dets.push_back(h);
+            }
+        }
+        merge_overlapped(dets);
+
+        std::vector<bool> used(dets.size(),false);
+        for(size_t i = 0; i < m_held.size();)
+        {
+            held_t& h = m_held[i];
+            bool hit = false;
+            rect_t need = h.r;
+            for(size_t j = 0; j < dets.size(); j++)
+            {
+                if(!overlap(h.r,dets[j].r))
+                {
+                    continue;
+                }
+
+                need = hit ? unite(need,dets[j].r) : dets[j].r;
+                hit = true;
+                used[j] = true;
+            }
+
+            if(!hit)
+            {
+                if(h.hold == 0)
+                {
+                    m_held.erase(m_held.begin() + i);
+                    continue;
+                }
+                h.hold--;
+                i++;
+                continue;
+            }
+
+            //grow at once,shrink only when clearly too big
+            h.hold = m_param.hold;
+            if(!contain(h.r,need))
+            {
+                h.r = unite(h.r,need);
+            }
+            else if(area(need) < area(h.r) * m_param.shrink_ratio)
+            {
+                h.r = need;
+            }
+            i++;
+        }
+
+        for(size_t j = 0; j < dets.size(); j++)
+        {
+            if(!used[j])
+            {
+                m_held.push_back(dets[j]);
+            }
+        }
+        merge_overlapped(m_held);
+
+        //too many for the encoder,merge the pairs that add the least area
+        uint32_t cap = m_param.max_num;
+        if(m_param.background_qp != 0 && cap > 0)
+        {
+            cap--;
+        }
+        while(m_held.size() > cap)
+        {
+            if(cap == 0)
+            {
+                m_held.clear();
+                break;
+            }
+
+            size_t bi = 0,bj = 1;
+            int64_t best = -1;
+            for(size_t i = 0; i < m_held.size(); i++)
+            {
+                for(size_t j = i + 1; j < m_held.size(); j++)
+                {
+                    int64_t cost = area(unite(m_held[i].r,m_held[j].r)) - area(m_held[i].r) - area(m_held[j].r);
+                    if(best < 0 || cost < best)
+                    {
+                        best = cost;
+                        bi = i;
+                        bj = j;
+                    }
+                }
+            }
+
+            m_held[bi].r = unite(m_held[bi].r,m_held[bj].r);
+            m_held[bi].hold = std::max(m_held[bi].hold,m_held[bj].hold);
+            m_held.erase(m_held.begin() + bj);
+            merge_overlapped(m_held);
+        }
+
+        std::vector<roi_region> old;
+        old.swap(m_regions);
+        make_regions();
+        for(size_t i = 0; i < m_regions.size(); i++)
+        {
+            const roi_region& a = m_regions[i];
+            const roi_region& b = old[i];
+            if(a.enable != b.enable || a.qp != b.qp || a.x != b.x || a.y != b.y || a.w != b.w || a.h != b.h)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void roi_qp_map::make_regions()
+    {
+        //a stable order,so unchanged regions keep their index
+        std::sort(m_held.begin(),m_held.end(),[](const held_t& a,const held_t& b)
+                {
+                    return a.r.y1 != b.r.y1 ? a.r.y1 < b.r.y1 : a.r.x1 < b.r.x1;
+                });
+
+        m_regions.clear();
+        for(uint32_t i = 0; i < m_param.max_num; i++)
+        {
+            roi_region r;
+            memset(&r,0,sizeof(r));
+            r.index = i;
+            m_regions.push_back(r);
+        }
+
+        //the background is index 0,every object region overrides it
+        uint32_t idx = 0;
+        if(m_param.background_qp != 0 && m_param.max_num > 0 && m_dst_w > 0 && m_dst_h > 0)
+        {
+            roi_region& r = m_regions[idx++];
+            r.enable = true;
+            r.qp = m_param.background_qp;
+            r.w = m_dst_w;
+            r.h = m_dst_h;
+        }
+
+        for(size_t i = 0; i < m_held.size() && idx < m_param.max_num; i++)
+        {
+            roi_region& r = m_regions[idx++];
+            r.enable = true;
+            r.qp = m_param.object_qp;
+            r.x = m_held[i].r.x1;
+            r.y = m_held[i].r.y1;
+            r.w = m_held[i].r.x2 - m_held[i].r.x1;
+            r.h = m_held[i].r.y2 - m_held[i].r.y1;
+        }
+    }
+
+    roi_ab_report::roi_ab_report(uint32_t period_ms)
+        :m_period_ms(period_ms ? period_ms : 1),m_started(false),m_start_ms(0),m_cycle(0),m_ready(false)
+    {
+        memset(m_bytes,0,sizeof(m_bytes));
+        memset(&m_result,0,sizeof(m_result));
+    }
+
+    roi_ab_report::~roi_ab_report()
+    {
+    }
+
+    void roi_ab_report::advance(uint64_t now_ms)
+    {
+        if(!m_started)
+        {
+            m_started = true;
+            m_start_ms = now_ms;
+            return;
+        }
+
+        uint64_t cycle = (now_ms - m_start_ms) / m_period_ms / 2;
+        if(cycle == m_cycle)
+        {
+            return;
+        }
+
+        //a gap of more than a cycle leaves no comparable halves
+        if(cycle == m_cycle + 1)
+        {
+            m_result.on_kbps = (uint32_t)(m_bytes[0] * 8 / m_period_ms);
+            m_result.off_kbps = (uint32_t)(m_bytes[1] * 8 / m_period_ms);
+            m_result.saving = m_bytes[1] ? (int32_t)(100 - (int64_t)m_bytes[0] * 100 / (int64_t)m_bytes[1]) : 0;
+            m_ready = true;
+        }
+        memset(m_bytes,0,sizeof(m_bytes));
+        m_cycle = cycle;
+    }
+
+    bool roi_ab_report::roi_on(uint64_t now_ms)
+    {
+        advance(now_ms);
+        return (now_ms - m_start_ms) / m_period_ms % 2 == 0;
+    }
+
+    void roi_ab_report::add_bytes(uint32_t bytes,uint64_t now_ms)
+    {
+        advance(now_ms);
+        m_bytes[(now_ms - m_start_ms) / m_period_ms % 2] += bytes;
+    }
+
+    bool roi_ab_report::get_result(roi_ab_result* result)
+    {
+        if(!m_ready)
+        {
+            return false;
+        }
+
+        *result = m_result;
+        m_ready = false;
+        return true;
+    }
+
+}}//namespace
@@ -0,0 +1,141 @@
+#ifndef roi_qp_map_include_h
+#define roi_qp_map_include_h
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+namespace ceanic{namespace roi{
+
+    //a detection in the analysis picture
+    typedef struct
+    {
+        float x1;
+        float y1;
+        float x2;
+        float y2;
+        float score;
+    }roi_box;
+
+    //one encoder roi region,pixels of the encoded picture
+    typedef struct
+    {
+        uint32_t index;     //higher indexes win where regions overlap
+        bool enable;
+        int32_t qp;         //relative to the rate control qp
+        uint32_t x;
+        uint32_t y;
+        uint32_t w;
+        uint32_t h;
+    }roi_region;
+
+    typedef struct
+    {
+        int32_t object_qp;      //negative:more bits for the objects
+        int32_t background_qp;  //positive:fewer bits for the rest of the picture,0:no background region
+        uint32_t max_num;       //regions of the encoder,background included(8 on 3519dv500)
+        uint32_t align;         //region position and size granularity,16 for h264 macroblocks
+        float margin;           //boxes grow by this part of their size on every side
+        float min_score;        //weaker detections get no region
+        uint32_t hold;          //updates an object region outlives its last detection
+        float shrink_ratio;     //a region shrinks once its objects cover less than this part of it
+    }roi_qp_param;
+
+    //turns detection boxes into encoder roi regions.
+    //regions grow at once and shrink or vanish late,so the encoder is not reprogrammed
+    //on every jitter of the boxes.overlapping regions are merged and the cheapest pairs
+    //are merged until the regions fit the encoder.not thread safe
+    class roi_qp_map
+    {
+        public:
+            roi_qp_map(uint32_t src_w,uint32_t src_h,uint32_t dst_w,uint32_t dst_h,const roi_qp_param* param = NULL);
+            virtual ~roi_qp_map();
+
+        public:
+            //boxes in src_w x src_h,true when regions() changed
+            bool update(const std::vector<roi_box>& boxes);
+
+            //always max_num entries,the unused ones disabled
+            const std::vector<roi_region>& regions();
+
+            //object regions currently held
+            uint32_t object_count();
+
+            void reset();
+
+            static roi_qp_param default_param();
+
+        private:
+            typedef struct
+            {
+                int32_t x1;
+                int32_t y1;
+                int32_t x2;
+                int32_t y2;
+            }rect_t;
+
+            typedef struct
+            {
+                rect_t r;
+                uint32_t hold;
+            }held_t;
+
+            static int64_t area(const rect_t& r);
+            static bool overlap(const rect_t& a,const rect_t& b);
+            static bool contain(const rect_t& outer,const rect_t& inner);
+            static rect_t unite(const rect_t& a,const rect_t& b);
+
+            bool to_rect(const roi_box& box,rect_t* r);
+            bool merge_overlapped(std::vector<held_t>& held);
+            void make_regions();
+
+        private:
+            roi_qp_param m_param;
+            uint32_t m_src_w;
+            uint32_t m_src_h;
+            int32_t m_dst_w;
+            int32_t m_dst_h;
+            std::vector<held_t> m_held;
+            std::vector<roi_region> m_regions;
+    };
+
+    typedef struct
+    {
+        uint32_t on_kbps;   //bitrate with the roi regions
+        uint32_t off_kbps;  //bitrate without
+        int32_t saving;     //percent,negative when the roi costs bits
+    }roi_ab_result;
+
+    //alternates roi on and off every period and compares the bitrates of the two halves
+    class roi_ab_report
+    {
+        public:
+            explicit roi_ab_report(uint32_t period_ms);
+            virtual ~roi_ab_report();
+
+        public:
+            //whether the roi regions should be applied now
+            bool roi_on(uint64_t now_ms);
+
+            //an encoded frame
+            void add_bytes(uint32_t bytes,uint64_t now_ms);
+
+            //true once per completed on/off cycle
+            bool get_result(roi_ab_result* result);
+
+        private:
+            void advance(uint64_t now_ms);
+
+        private:
+            uint32_t m_period_ms;
+            bool m_started;
+            uint64_t m_start_ms;
+            uint64_t m_cycle;
+            uint64_t m_bytes[2];
+            bool m_ready;
+            roi_ab_result m_result;
+    };
+
+}}//namespace
+
+#endif
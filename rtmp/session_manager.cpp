@@ -5,7 +5,22 @@
 namespace ceanic{namespace rtmp{
 
     session_manager::session_manager()
+        :m_reap_run(true)
     {
+        m_reap_thread = std::thread(&session_manager::on_reap,this);
+    }
+
+    session_manager::~session_manager()
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_reap_mu);
+            m_reap_run = false;
+        }
+        m_reap_cond.notify_one();
+        if(m_reap_thread.joinable())
+        {
+            m_reap_thread.join();
+        }
     }
 
     session_manager* session_manager::instance()
@@ -19,30 +34,30 @@ namespace ceanic{namespace rtmp{
         return g_sm;
     }
 
-    bool session_manager::session_exists(int32_t chn,int32_t stream_id,std::string url)
+    void session_manager::stop_sessions(const sess_registry::item_list& entries)
     {
-        for(auto it = m_sess.begin(); it != m_sess.end(); it++)
+        for(size_t i = 0; i < entries.size(); i++)
         {
-            sess_key_ptr key = it->first;
-            sess_ptr sess = it->second;
-
-            if(key->chn == chn 
-                    && key->stream_id == stream_id
-                    && key->url == url)
+            if(!sess_registry::wait_unused(entries[i]))
             {
-                return true;
+                RTMP_WRITE_LOG_WARN("session %s still in use,stop it anyway",entries[i]->url.c_str());
             }
+            entries[i]->sess->stop();
         }
-
-        return false;
     }
 
     bool session_manager::create_session(int32_t chn,int32_t stream_id,std::string url)
     {
         std::unique_lock<std::mutex> lock(m_sess_mu);
 
-        if(session_exists(chn,stream_id,url))
+        if(m_sess.find_if(chn,stream_id,[&url](const sess_entry_ptr& e){return e->url == url;}))
+        {
+            return false;
+        }
+
+        if(!sess_registry::valid(chn,stream_id))
         {
+            RTMP_WRITE_LOG_ERROR("invalid chn %d stream %d",chn,stream_id);
             return false;
         }
 
@@ -53,97 +68,108 @@ namespace ceanic{namespace rtmp{
             return false;
         }
 
-        sess_key_ptr sess_key = std::make_shared<sess_key_t>();
-        sess_key->chn = chn;
-        sess_key->stream_id = stream_id;
-        sess_key->url = url;
+        sess_entry_ptr entry = std::make_shared<sess_entry_t>();
+        entry->url = url;
+        entry->sess = sess;
+        entry->failed = false;
 
-        m_sess.insert(std::make_pair(sess_key,sess));
+        m_sess.add(chn,stream_id,entry);
         return true;
     }
 
     void session_manager::delete_session(int32_t chn,int32_t stream_id,std::string url)
     {
         std::unique_lock<std::mutex> lock(m_sess_mu);
-        for(auto it = m_sess.begin(); it != m_sess.end();)
-        {
-            sess_key_ptr key = it->first;
-            sess_ptr sess = it->second;
-
-            if(key->chn == chn 
-                    && key->stream_id == stream_id
-                    && key->url == url)
-            {
-                sess->stop();
-                it = m_sess.erase(it);
-            }
-            else
-            {
-                it++;
-            }
-        }
+        sess_registry::item_list removed;
+        m_sess.remove_if(chn,stream_id,[&url](const sess_entry_ptr& e){return e->url == url;},&removed);
+        stop_sessions(removed);
     }
 
     void session_manager::delete_session(int32_t chn,int32_t stream_id)
     {
         std::unique_lock<std::mutex> lock(m_sess_mu);
-        for(auto it = m_sess.begin(); it != m_sess.end();)
+        sess_registry::item_list removed;
+        m_sess.remove_if(chn,stream_id,[](const sess_entry_ptr&){return true;},&removed);
+        stop_sessions(removed);
+    }
+
+    void session_manager::process_data(int32_t chn,int32_t stream_id,util::stream_head* head,uint8_t* buf,int32_t len)
+    {
+        sess_registry::snapshot entries = m_sess.get(chn,stream_id);
+        if(!entries)
         {
-            sess_key_ptr key = it->first;
-            sess_ptr sess = it->second;
+            return;
+        }
+
+        for(size_t i = 0; i < entries->size(); i++)
+        {
+            const sess_entry_ptr& entry = (*entries)[i];
+            if(entry->failed)
+            {
+                continue;
+            }
+
+            const sess_ptr& sess = entry->sess;
+            bool send_success = true;
 
-            if(key->chn == chn 
-                    && key->stream_id == stream_id)
+            if(IS_VIDEO_FRAME(head->type))
             {
-                sess->stop();
-                it = m_sess.erase(it);
+                for(uint32_t n = 0; n < head->nalu.size(); n++)
+                {
+                    if(!sess->input_one_nalu((uint8_t*)head->nalu[n].data,head->nalu[n].size,head->nalu[n].time_stamp))
+                    {
+                        send_success = false;
+                        break;
+                    }
+                }
+            }else if(IS_AUDIO_FRAME(head->type))
+            {
+                send_success = sess->input_audio_frame(buf,len,head->time_stamp);
             }
-            else
+
+            if(!send_success && !entry->failed.exchange(true))
             {
-                it++;
+                RTMP_WRITE_LOG_ERROR("send failed");
+                //m_sess_mu may be held by a delete_session waiting for this snapshot,
+                //so the frame thread only queues the session
+                std::unique_lock<std::mutex> lock(m_reap_mu);
+                m_reap.push_back({chn,stream_id,entry});
+                m_reap_cond.notify_one();
             }
         }
     }
 
-    void session_manager::process_data(int32_t chn,int32_t stream_id,util::stream_head* head,uint8_t* buf,int32_t len)
+    void session_manager::on_reap()
     {
-        std::unique_lock<std::mutex> lock(m_sess_mu);
-
-        for(auto it = m_sess.begin();it != m_sess.end();)
+        std::unique_lock<std::mutex> lock(m_reap_mu);
+        while(m_reap_run)
         {
-            sess_key_ptr key = it->first;
-            sess_ptr sess = it->second;
-
-            if(key->chn == chn
-                    && key->stream_id == stream_id)
+            if(m_reap.empty())
             {
-                bool send_success = true;
+                m_reap_cond.wait(lock);
+                continue;
+            }
+
+            std::vector<reap_item_t> items;
+            items.swap(m_reap);
+            lock.unlock();
 
-                if(IS_VIDEO_FRAME(head->type))
+            {
+                std::unique_lock<std::mutex> sess_lock(m_sess_mu);
+                sess_registry::item_list removed;
+                for(size_t i = 0; i < items.size(); i++)
                 {
-                    for(uint32_t i = 0; i < head->nalu_count; i++)
+                    //gone when delete_session stopped it already
+                    sess_entry_ptr entry = items[i].entry.lock();
+                    if(entry)
                     {
-                        if(!sess->input_one_nalu((uint8_t*)head->nalu[i].data,head->nalu[i].size,head->nalu[i].time_stamp))
-                        {
-                            send_success = false;
-                            break;
-                        }
+                        m_sess.remove_if(items[i].chn,items[i].stream_id,[&entry](const sess_entry_ptr& e){return e == entry;},&removed);
                     }
-                }else if(IS_AUDIO_FRAME(head->type))
-                {
-                    send_success = sess->input_audio_frame(buf,len,head->time_stamp);
-                }
-
-                if(!send_success)
-                {
-                    RTMP_WRITE_LOG_ERROR("send failed");
-                    sess->stop();
-                    it = m_sess.erase(it);
-                    continue;
                 }
+                stop_sessions(removed);
             }
 
-            it++;
+            lock.lock();
         }
     }
 
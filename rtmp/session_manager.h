@@ -1,9 +1,13 @@
 #ifndef session_manager_include_h
-#include <map>
+#define session_manager_include_h
+
 #include <thread>
 #include <mutex>
+#include <atomic>
+#include <condition_variable>
 #include <rtmp/session.h>
 #include <util/stream_type.h>
+#include <util/stream_registry.h>
 
 namespace ceanic{namespace rtmp{
 
@@ -22,24 +26,45 @@ namespace ceanic{namespace rtmp{
             void delete_session(int32_t chn,int32_t stream_id,std::string url);
             void delete_session(int32_t chn,int32_t stream_id);
 
+            //the frame path,takes no lock.a session failing to send is queued,
+            //the reap thread takes it out and stops it
             void process_data(int32_t chn,int32_t stream_id,util::stream_head* head,uint8_t* buf,int32_t len);
 
         private:
-            session_manager();
-            bool session_exists(int32_t chn,int32_t stream_id,std::string url);
+            typedef struct
+            {
+                std::string url;
+                sess_ptr sess;
+                std::atomic<bool> failed;   //queued for the reap thread,not sent to anymore
+            }sess_entry_t;
+
+            using sess_entry_ptr = std::shared_ptr<sess_entry_t>;
+            using sess_registry = util::stream_registry<sess_entry_t>;
 
-        private:
             typedef struct
             {
                 int32_t chn;
                 int32_t stream_id;
-                std::string url;
-            }sess_key_t;
+                //weak,a delete_session waiting for the session to be unused must not wait for the queue
+                std::weak_ptr<sess_entry_t> entry;
+            }reap_item_t;
+
+            session_manager();
+            //removed sessions may still be sent to by process_data,stop them once it let go
+            void stop_sessions(const sess_registry::item_list& entries);
+            void on_reap();
 
-            using sess_key_ptr = std::shared_ptr<sess_key_t>;
-            
+        private:
+            //serializes create/delete,process_data reads m_sess without it
             std::mutex m_sess_mu;
-            std::map<sess_key_ptr,sess_ptr> m_sess;
+            sess_registry m_sess;
+
+            //failed sessions,removed off the frame threads
+            std::mutex m_reap_mu;
+            std::condition_variable m_reap_cond;
+            std::vector<reap_item_t> m_reap;
+            bool m_reap_run;
+            std::thread m_reap_thread;
     };
 
 }}//namespace
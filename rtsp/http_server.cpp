@@ -0,0 +1,22 @@
+#include <http_server.h>
+#include <http_session.h>
+
+namespace ceanic{namespace rtsp{
+
+    http_server::http_server(int16_t port)
+        :rtsp_server(port)
+    {
+    }
+
+    http_server::~http_server()
+    {
+        //the accept thread must not create sessions once this part is gone
+        stop();
+    }
+
+    session_ptr http_server::create_session(int32_t s)
+    {
+        return session_ptr(new http_session(s, MAX_SESSION_TIMEOUT + 3));
+    }
+
+}}//namespace
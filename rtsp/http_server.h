@@ -0,0 +1,22 @@
+#ifndef http_server_include_h
+#define http_server_include_h
+
+#include <server.h>
+
+namespace ceanic{namespace rtsp{
+
+    //mjpeg over http for browsers,they refuse to connect to port 554
+    class http_server
+        :public rtsp_server
+    {
+        public:
+            http_server(int16_t port = 8080);
+            virtual ~http_server();
+
+        protected:
+            virtual session_ptr create_session(int32_t s);
+    };
+
+}}//namespace
+
+#endif
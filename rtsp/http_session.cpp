@@ -0,0 +1,201 @@
+#include "http_session.h"
+#include <stream_mjpeg_handler.h>
+#include <rtsp_log.h>
+
+namespace ceanic{namespace rtsp{
+
+    http_session::http_session(int32_t s, int32_t timeout)
+        :session(s, timeout)
+    {
+    }
+
+    http_session::~http_session()
+    {
+        stop();
+    }
+
+    void http_session::reduce_session_timeout()
+    {
+        if (m_timeout > 0)
+        {
+            m_timeout--;
+        }
+    }
+
+    int32_t http_session::get_session_timeout()
+    {
+        return m_timeout;
+    }
+
+    void http_session::reduce_rtcp_timeout()
+    {
+        if (m_handler && m_handler->get_rtcp_timeout() > 0)
+        {
+            m_handler->get_rtcp_timeout()--;
+        }
+    }
+
+    int32_t http_session::get_rtcp_timeout()
+    {
+        if (m_handler)
+        {
+            return m_handler->get_rtcp_timeout();
+        }
+        return 0;
+    }
+
+    bool http_session::start()
+    {
+        m_start = true;
+
+        return true;
+    }
+
+    void http_session::stop()
+    {
+        if (!is_start())
+        {
+            return;
+        }
+
+        stop_play();
+        m_start = false;
+    }
+
+    void http_session::stop_play()
+    {
+        if (!m_stream)
+        {
+            return;
+        }
+
+        if (m_handler)
+        {
+            m_handler->stop();
+            m_stream->unregister_stream_observer(m_handler);
+        }
+
+        stream_manager::instance()->del_stream(m_stream->chn(),m_stream->stream_id());
+        m_stream = nullptr;
+    }
+
+    void http_session::handle_reset()
+    {
+        m_parser.reset();
+        m_request.data_len = 0;
+        m_request.head_flag = false;
+        m_request.content_len = 0;
+        m_request.method.clear();
+        m_request.uri.clear();
+        m_request.headers.clear();
+    }
+
+    bool http_session::get_channel(const std::string& uri, int32_t& chn)
+    {
+        std::string::size_type pos = uri.rfind(std::string("/mjpeg"));
+        if (pos == std::string::npos)
+        {
+            return false;
+        }
+
+        int32_t ch;
+        if (sscanf(uri.c_str() + pos,"/mjpeg%d",&ch) == 1)
+        {
+            chn = ch - 1;
+            return (chn >= 0);
+        }
+
+        return false;
+    }
+
+    void http_session::send_status(const char* status)
+    {
+        std::string str = "HTTP/1.0 ";
+        str += status;
+        str += "\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+        send_packet_n(str.c_str(), str.size());
+
+        //closed after the reply is flushed
+        m_timeout = 2;
+    }
+
+    void http_session::process_http_request()
+    {
+        int32_t chn;
+        if (m_request.method != "GET")
+        {
+            send_status("405 Method Not Allowed");
+            return;
+        }
+
+        if (m_stream)
+        {
+            //one stream per connection
+            send_status("409 Conflict");
+            return;
+        }
+
+        if (!get_channel(m_request.uri, chn))
+        {
+            RTSP_WRITE_LOG_ERROR("get channel from url(%s)failed",m_request.uri.c_str());
+            send_status("404 Not Found");
+            return;
+        }
+
+        util::media_head mh;
+        if (!stream_manager::instance()->get_stream_head(chn,HTTP_MJPEG_STREAM_ID,&mh)
+                || mh.video_info.vcode != util::STREAM_VIDEO_ENCODE_MJPEG)
+        {
+            send_status("404 Not Found");
+            return;
+        }
+
+        if (!stream_manager::instance()->get_stream(chn,HTTP_MJPEG_STREAM_ID,m_stream))
+        {
+            send_status("503 Service Unavailable");
+            return;
+        }
+
+        std::string str = "HTTP/1.0 200 OK\r\n";
+        str += "Cache-Control: no-cache\r\n";
+        str += "Pragma: no-cache\r\n";
+        str += "Connection: close\r\n";
+        str += "Content-Type: multipart/x-mixed-replace;boundary=" MJPEG_BOUNDARY "\r\n";
+        str += "\r\n";
+        send_packet_n(str.c_str(), str.size());
+
+        RTSP_WRITE_LOG_INFO("http mjpeg(chn=%d) to %s",chn,m_ip.c_str());
+        m_handler = stream_handler_ptr(new stream_mjpeg_handler(*this));
+        m_handler->start();
+        m_stream->register_stream_observer(m_handler);
+        m_timeout = 0;
+    }
+
+    std::optional<bool> http_session::handle_read(const char* data, int32_t len)
+    {
+        int32_t left = len;
+        std::optional<bool> result;
+        while (left > 0)
+        {
+            result = m_parser.parse(m_request, data, len,&left);
+            if (result.has_value() && result.value())
+            {
+                m_timeout = MAX_SESSION_TIMEOUT;
+                process_http_request();
+                handle_reset();
+
+                data += (len - left);
+                len = left;
+            }
+            else if (result.has_value() && !result.value())
+            {
+                RTSP_WRITE_LOG_ERROR("protocol error, shutdown socket(%d)",m_socket);
+                shutdown(m_socket, SHUT_RDWR);
+                return result;
+            }
+        }
+
+        return result;
+    }
+
+}}//namespace
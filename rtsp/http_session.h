@@ -0,0 +1,51 @@
+#ifndef http_session_include_h
+#define http_session_include_h
+
+#include "session.h"
+#include "request.h"
+#include "request_parser.h"
+#include <stream_manager.h>
+#include <stream_handler.h>
+
+namespace ceanic{namespace rtsp{
+
+//http://ip:port/mjpeg<n> plays the jpeg stream of chn n-1
+#define HTTP_MJPEG_STREAM_ID 3
+
+    class http_session
+        :public session
+    {
+        public:
+            http_session(int32_t s, int32_t timeout);
+
+            virtual ~http_session();
+
+            virtual std::optional<bool> handle_read(const char* data, int32_t len);
+
+            virtual void handle_reset();
+
+            virtual bool start();
+
+            virtual void stop();
+
+            virtual void reduce_session_timeout();
+            virtual int32_t get_session_timeout();
+            virtual void reduce_rtcp_timeout();
+            virtual int32_t get_rtcp_timeout();
+
+        protected:
+            void process_http_request();
+            bool get_channel(const std::string& uri, int32_t& chn);
+            void send_status(const char* status);
+            void stop_play();
+
+        protected:
+            request_parser m_parser;
+            request m_request;
+            stream_ptr m_stream;
+            stream_handler_ptr m_handler;
+    };
+
+}}//namespace
+
+#endif
@@ -11,7 +11,7 @@ namespace ceanic{namespace rtsp{
     {
     }
 
-    void h264_rtp_serialize::process_nalu(util::nalu_t*nalu,rtp_session_ptr rs)
+    void h264_rtp_serialize::process_nalu(util::nalu_t*nalu,bool last,rtp_session_ptr rs)
     {
         rtp_packet_t packet;
         RTP_FIXED_HEADER* rtp_hdr = packet.phdr;
@@ -31,7 +31,7 @@ namespace ceanic{namespace rtsp{
         {
             //signal nlau packet
             rtp_hdr->seq_no = htons(m_seq++);
-            rtp_hdr->marker = 1;
+            rtp_hdr->marker = last ? 1 : 0;
 
             packet.rtp_data_len = nalu_size + sizeof(RTP_FIXED_HEADER);
             packet.outside_cnt = 1;
@@ -70,7 +70,7 @@ namespace ceanic{namespace rtsp{
             }
 
             rtp_hdr->seq_no = htons(m_seq++);
-            rtp_hdr->marker = is_end ? 1 : 0;
+            rtp_hdr->marker = (last && is_end) ? 1 : 0;
 
             packet.rtp_data_len = sizeof(RTP_FIXED_HEADER) + fu_head_size + size;
             packet.outside_cnt = 1;
@@ -86,6 +86,15 @@ namespace ceanic{namespace rtsp{
         }
     }
 
+    bool h264_rtp_serialize::is_send_nalu(const util::nalu_t& nalu)
+    {
+        uint8_t nalu_type = nalu.data[4] & 0x1f;
+        return nalu_type == 0x7/*sps*/
+            || nalu_type == 0x8/*pps*/
+            || nalu_type == 0x1/*p*/
+            || nalu_type == 0x5/*i*/;
+    }
+
     bool h264_rtp_serialize::serialize(util::stream_head& head,const char* buf,int32_t len,rtp_session_ptr rs)
     {
         if(head.type != STREAM_NALU_SLICE)
@@ -93,16 +102,24 @@ namespace ceanic{namespace rtsp{
             return false;
         }
 
-        uint8_t nalu_type;
-        for(uint32_t i = 0; i < head.nalu_count; i++)
+        //only the last slice of a frame ends the access unit
+        int32_t last = -1;
+        if(!(head.flags & STREAM_FLAG_MORE_SLICES))
+        {
+            for(uint32_t i = 0; i < head.nalu.size(); i++)
+            {
+                if(is_send_nalu(head.nalu[i]))
+                {
+                    last = i;
+                }
+            }
+        }
+
+        for(uint32_t i = 0; i < head.nalu.size(); i++)
         {
-            nalu_type = head.nalu[i].data[4] & 0x1f;
-            if(nalu_type == 0x7/*sps*/
-                    || nalu_type == 0x8/*pps*/
-                    || nalu_type == 0x1/*p*/
-                    || nalu_type == 0x5/*i*/)
+            if(is_send_nalu(head.nalu[i]))
             {
-                process_nalu(&head.nalu[i],rs);
+                process_nalu(&head.nalu[i],(int32_t)i == last,rs);
             }
         }
 
@@ -17,7 +17,9 @@ namespace ceanic{namespace rtsp{
             bool serialize(util::stream_head& head,const char* buf,int32_t len,rtp_session_ptr rs);
 
         private:
-            void process_nalu(util::nalu_t*nalu,rtp_session_ptr rs);
+            bool is_send_nalu(const util::nalu_t& nalu);
+            //last:the final nalu of the frame,its last packet carries the marker bit
+            void process_nalu(util::nalu_t*nalu,bool last,rtp_session_ptr rs);
     };
 
 }}//namespace
@@ -11,7 +11,7 @@ namespace ceanic{namespace rtsp{
     {
     }
 
-    void h265_rtp_serialize::process_nalu(util::nalu_t*nalu,rtp_session_ptr rs)
+    void h265_rtp_serialize::process_nalu(util::nalu_t*nalu,bool last,rtp_session_ptr rs)
     {
         rtp_packet_t packet;
         RTP_FIXED_HEADER* rtp_hdr = packet.phdr;
@@ -31,7 +31,7 @@ namespace ceanic{namespace rtsp{
         {
             //signal nlau packet
             rtp_hdr->seq_no = htons(m_seq++);
-            rtp_hdr->marker = 1;
+            rtp_hdr->marker = last ? 1 : 0;
 
             packet.rtp_data_len = nalu_size + sizeof(RTP_FIXED_HEADER);
             packet.outside_cnt = 1;
@@ -73,7 +73,7 @@ namespace ceanic{namespace rtsp{
             }
 
             rtp_hdr->seq_no = htons(m_seq++);
-            rtp_hdr->marker = is_end ? 1 : 0;
+            rtp_hdr->marker = (last && is_end) ? 1 : 0;
 
             packet.rtp_data_len = sizeof(RTP_FIXED_HEADER) + fu_head_size + size;
             packet.outside_cnt = 1;
@@ -96,9 +96,11 @@ namespace ceanic{namespace rtsp{
             return false;
         }
         
-        for(uint32_t i = 0; i < head.nalu_count; i++)
+        //only the last slice of a frame ends the access unit
+        bool frame_end = !(head.flags & STREAM_FLAG_MORE_SLICES);
+        for(uint32_t i = 0; i < head.nalu.size(); i++)
         {
-            process_nalu(&head.nalu[i],rs);
+            process_nalu(&head.nalu[i],frame_end && i + 1 == head.nalu.size(),rs);
         }
 
         return true;
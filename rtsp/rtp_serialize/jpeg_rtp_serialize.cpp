@@ -0,0 +1,330 @@
+#include "jpeg_rtp_serialize.h"
+
+namespace ceanic{namespace rtsp{
+
+#define JPEG_MAIN_HEAD_SIZE 8
+#define JPEG_RESTART_HEAD_SIZE 4
+#define JPEG_QT_HEAD_SIZE 4
+//restart count that tells the intervals are not aligned to the packets
+#define JPEG_RESTART_COUNT_UNALIGNED 0x3fff
+
+    jpeg_rtp_serialize::jpeg_rtp_serialize(int32_t payload)
+        :rtp_serialize(payload)
+    {
+    }
+
+    jpeg_rtp_serialize::~jpeg_rtp_serialize()
+    {
+    }
+
+    bool jpeg_rtp_serialize::parse(const uint8_t* data,uint32_t len,jpeg_info_t* info)
+    {
+        const uint8_t* tables[4] = {NULL,NULL,NULL,NULL};
+        uint16_t table_len[4] = {0,0,0,0};
+        uint8_t comp_tq[2] = {0,0};
+        bool has_sof = false;
+
+        info->restart_interval = 0;
+        info->restarts.clear();
+        info->scan = NULL;
+
+        if(len < 4 || data[0] != 0xff || data[1] != 0xd8)
+        {
+            return false;
+        }
+
+        uint32_t p = 2;
+        while(p + 4 <= len)
+        {
+            if(data[p] != 0xff)
+            {
+                return false;
+            }
+
+            uint8_t m = data[p + 1];
+            if(m == 0xff)
+            {
+                //fill byte
+                p++;
+                continue;
+            }
+
+            uint32_t seg_len = (data[p + 2] << 8) | data[p + 3];
+            if(seg_len < 2 || p + 2 + seg_len > len)
+            {
+                return false;
+            }
+
+            const uint8_t* seg = data + p + 4;
+            uint32_t n = seg_len - 2;
+            if(m == 0xdb)
+            {
+                //dqt,one or more tables
+                uint32_t q = 0;
+                while(q < n)
+                {
+                    uint8_t tq = seg[q] & 0x0f;
+                    uint16_t tl = (seg[q] >> 4) ? 128 : 64;
+                    if(tq > 3 || q + 1 + tl > n)
+                    {
+                        return false;
+                    }
+
+                    tables[tq] = seg + q + 1;
+                    table_len[tq] = tl;
+                    q += 1 + tl;
+                }
+            }
+            else if(m == 0xc0)
+            {
+                //baseline sof,y with cb/cr at 1x1
+                if(n < 15 || seg[5] != 3 || seg[10] != 0x11 || seg[13] != 0x11)
+                {
+                    return false;
+                }
+
+                uint16_t h = (seg[1] << 8) | seg[2];
+                uint16_t w = (seg[3] << 8) | seg[4];
+                if(seg[7] == 0x21)
+                {
+                    info->type = 0;
+                }
+                else if(seg[7] == 0x22)
+                {
+                    info->type = 1;
+                }
+                else
+                {
+                    return false;
+                }
+
+                info->w = w;
+                info->h = h;
+                comp_tq[0] = seg[8] & 0x03;
+                comp_tq[1] = seg[11] & 0x03;
+                has_sof = true;
+            }
+            else if(m >= 0xc1 && m <= 0xcf && m != 0xc4 && m != 0xc8 && m != 0xcc)
+            {
+                //progressive,lossless or arithmetic coded
+                return false;
+            }
+            else if(m == 0xdd)
+            {
+                if(n < 2)
+                {
+                    return false;
+                }
+                info->restart_interval = (seg[0] << 8) | seg[1];
+            }
+            else if(m == 0xda)
+            {
+                //the entropy coded data follows the sos header up to eoi
+                info->scan = seg + n;
+                info->scan_len = len - (info->scan - data);
+                if(info->scan_len >= 2 && info->scan[info->scan_len - 2] == 0xff && info->scan[info->scan_len - 1] == 0xd9)
+                {
+                    info->scan_len -= 2;
+                }
+                break;
+            }
+
+            p += 2 + seg_len;
+        }
+
+        if(!has_sof || !info->scan || info->scan_len == 0)
+        {
+            return false;
+        }
+
+        if(info->w == 0 || info->h == 0 || (info->w + 7) / 8 > 255 || (info->h + 7) / 8 > 255)
+        {
+            return false;
+        }
+
+        for(int i = 0; i < 2; i++)
+        {
+            if(!tables[comp_tq[i]])
+            {
+                return false;
+            }
+            info->qt[i] = tables[comp_tq[i]];
+            info->qt_len[i] = table_len[comp_tq[i]];
+        }
+
+        if(info->restart_interval > 0)
+        {
+            info->type |= 64;
+
+            //0xff in the coded data is stuffed with 0x00,so ff d0..d7 is always a marker
+            info->restarts.push_back(0);
+            for(uint32_t i = 0; i + 1 < info->scan_len; i++)
+            {
+                if(info->scan[i] == 0xff && info->scan[i + 1] >= 0xd0 && info->scan[i + 1] <= 0xd7)
+                {
+                    info->restarts.push_back(i + 2);
+                    i++;
+                }
+            }
+        }
+
+        return true;
+    }
+
+    void jpeg_rtp_serialize::send_fragment(const jpeg_info_t& info,uint32_t offset,uint32_t size,uint16_t restart_count,bool first,bool last,bool marker,uint32_t ts,rtp_session_ptr rs)
+    {
+        rtp_packet_t packet;
+        RTP_FIXED_HEADER* rtp_hdr = packet.phdr;
+
+        memset(rtp_hdr,0,12);
+        rtp_hdr->version = 2;
+        rtp_hdr->payload = m_payload;
+        rtp_hdr->marker = marker ? 1 : 0;
+        rtp_hdr->seq_no = htons(m_seq++);
+        rtp_hdr->ssrc = htonl(m_ssrc);
+        rtp_hdr->timestamp = htonl(ts);
+
+        uint8_t* p = packet._inter_buf + TCP_TAG_SIZE + sizeof(RTP_FIXED_HEADER);
+        uint8_t* beg = p;
+
+        //main jpeg header,type-specific 0
+        p[0] = 0;
+        p[1] = (offset >> 16) & 0xff;
+        p[2] = (offset >> 8) & 0xff;
+        p[3] = offset & 0xff;
+        p[4] = info.type;
+        p[5] = 255;
+        p[6] = (info.w + 7) / 8;
+        p[7] = (info.h + 7) / 8;
+        p += JPEG_MAIN_HEAD_SIZE;
+
+        if(info.type & 64)
+        {
+            p[0] = info.restart_interval >> 8;
+            p[1] = info.restart_interval & 0xff;
+            p[2] = (first ? 0x80 : 0) | (last ? 0x40 : 0) | ((restart_count >> 8) & 0x3f);
+            p[3] = restart_count & 0xff;
+            p += JPEG_RESTART_HEAD_SIZE;
+        }
+
+        if(offset == 0)
+        {
+            uint16_t qt_len = info.qt_len[0] + info.qt_len[1];
+            p[0] = 0;
+            p[1] = (info.qt_len[0] == 128 ? 1 : 0) | (info.qt_len[1] == 128 ? 2 : 0);
+            p[2] = qt_len >> 8;
+            p[3] = qt_len & 0xff;
+            p += JPEG_QT_HEAD_SIZE;
+            memcpy(p,info.qt[0],info.qt_len[0]);
+            p += info.qt_len[0];
+            memcpy(p,info.qt[1],info.qt_len[1]);
+            p += info.qt_len[1];
+        }
+
+        uint32_t head_len = p - beg;
+        packet.rtp_data_len = sizeof(RTP_FIXED_HEADER) + head_len + size;
+        packet.outside_cnt = 1;
+        packet.outside_info[0].len = size;
+        packet.outside_info[0].data = (uint8_t*)info.scan + offset;
+        packet._inter_len = TCP_TAG_SIZE + sizeof(RTP_FIXED_HEADER) + head_len;
+
+        rs->send_packet(&packet);
+    }
+
+    bool jpeg_rtp_serialize::serialize(util::stream_head& head,const char* buf,int32_t len,rtp_session_ptr rs)
+    {
+        if(head.type != STREAM_MJPEG_FRAME)
+        {
+            return false;
+        }
+
+        //the jpeg is in the nalus of the venc stream,or in buf when it was
+        //given as one piece(e.g. a file)
+        const uint8_t* data = (const uint8_t*)buf;
+        uint32_t size = len > 0 ? len : 0;
+        if(head.nalu.size() == 1)
+        {
+            data = head.nalu[0].data;
+            size = head.nalu[0].size;
+        }
+        else if(head.nalu.size() > 1)
+        {
+            m_frame.clear();
+            for(uint32_t i = 0; i < head.nalu.size(); i++)
+            {
+                m_frame.insert(m_frame.end(),head.nalu[i].data,head.nalu[i].data + head.nalu[i].size);
+            }
+            data = m_frame.data();
+            size = m_frame.size();
+        }
+
+        //progressive or 4:4:4 jpegs can not be carried
+        if(!parse(data,size,&m_info))
+        {
+            return false;
+        }
+
+        const jpeg_info_t& info = m_info;
+        uint32_t ts = (head.nalu.empty() ? head.time_stamp : head.nalu[0].time_stamp) * 90;
+        uint32_t max_data_len = MAX_PACKET_LEN - sizeof(RTP_FIXED_HEADER) - JPEG_MAIN_HEAD_SIZE;
+        if(info.type & 64)
+        {
+            max_data_len -= JPEG_RESTART_HEAD_SIZE;
+        }
+        uint32_t qt_head_len = JPEG_QT_HEAD_SIZE + info.qt_len[0] + info.qt_len[1];
+
+        //more intervals than the restart count holds,cut by size
+        uint32_t interval_cnt = info.restarts.size();
+        if(!(info.type & 64) || interval_cnt >= JPEG_RESTART_COUNT_UNALIGNED)
+        {
+            uint32_t offset = 0;
+            while(offset < info.scan_len)
+            {
+                uint32_t cap = max_data_len - (offset == 0 ? qt_head_len : 0);
+                uint32_t n = std::min(cap,info.scan_len - offset);
+                send_fragment(info,offset,n,JPEG_RESTART_COUNT_UNALIGNED,true,true,offset + n == info.scan_len,ts,rs);
+                offset += n;
+            }
+            return true;
+        }
+
+        //whole intervals per packet,an interval larger than a packet is split with the first/last bits
+        uint32_t i = 0;
+        while(i < interval_cnt)
+        {
+            uint32_t start = info.restarts[i];
+            uint32_t cap = max_data_len - (start == 0 ? qt_head_len : 0);
+            uint32_t j = i;
+            while(j < interval_cnt)
+            {
+                uint32_t end = (j + 1 < interval_cnt) ? info.restarts[j + 1] : info.scan_len;
+                if(end - start > cap)
+                {
+                    break;
+                }
+                j++;
+            }
+
+            if(j > i)
+            {
+                uint32_t end = (j < interval_cnt) ? info.restarts[j] : info.scan_len;
+                send_fragment(info,start,end - start,i,true,true,end == info.scan_len,ts,rs);
+                i = j;
+                continue;
+            }
+
+            uint32_t end = (i + 1 < interval_cnt) ? info.restarts[i + 1] : info.scan_len;
+            uint32_t pos = start;
+            while(pos < end)
+            {
+                uint32_t n = std::min(max_data_len - (pos == 0 ? qt_head_len : 0),end - pos);
+                send_fragment(info,pos,n,i,pos == start,pos + n == end,pos + n == info.scan_len,ts,rs);
+                pos += n;
+            }
+            i++;
+        }
+
+        return true;
+    }
+
+}}//namespace
@@ -0,0 +1,54 @@
+#ifndef jpeg_rtp_serialize_include_h
+#define jpeg_rtp_serialize_include_h
+
+#include <rtp_serialize.h>
+#include <util/std.h>
+
+namespace ceanic{namespace rtsp{
+
+//static payload type of jpeg(rfc3551)
+#define RTP_JPEG_PAYLOAD 26
+
+    //rfc2435,baseline yuv420/yuv422 jpegs up to 2040x2040 with the quantization
+    //tables sent in band(Q=255).with a restart interval the packets are cut at the
+    //restart markers so a lost packet only loses its own intervals
+    class jpeg_rtp_serialize
+        :public rtp_serialize
+    {
+        public:
+            explicit jpeg_rtp_serialize(int32_t payload = RTP_JPEG_PAYLOAD);
+
+            virtual ~jpeg_rtp_serialize();
+
+            bool serialize(util::stream_head& head,const char* buf,int32_t len,rtp_session_ptr rs);
+
+            typedef struct
+            {
+                uint8_t type;
+                uint16_t w;
+                uint16_t h;
+                uint16_t restart_interval;
+                //tables of the luma and the chroma component,64 or 128 bytes each
+                const uint8_t* qt[2];
+                uint16_t qt_len[2];
+                const uint8_t* scan;
+                uint32_t scan_len;
+                //scan offsets where the restart intervals begin
+                std::vector<uint32_t> restarts;
+            }jpeg_info_t;
+
+            //walk the markers once,false for jpegs rfc2435 can not carry
+            static bool parse(const uint8_t* data,uint32_t len,jpeg_info_t* info);
+
+        private:
+            void send_fragment(const jpeg_info_t& info,uint32_t offset,uint32_t size,uint16_t restart_count,bool first,bool last,bool marker,uint32_t ts,rtp_session_ptr rs);
+
+        private:
+            //the packs of a frame joined when venc returned more than one
+            std::vector<uint8_t> m_frame;
+            jpeg_info_t m_info;
+    };
+
+}}//namespace
+
+#endif
@@ -0,0 +1,62 @@
+#include <metadata_rtp_serialize.h>
+
+namespace ceanic{namespace rtsp{
+
+    metadata_rtp_serialize::metadata_rtp_serialize(int32_t payload)
+        :rtp_serialize(payload)
+    {
+    }
+
+    metadata_rtp_serialize::~metadata_rtp_serialize()
+    {
+    }
+
+    bool metadata_rtp_serialize::serialize(util::stream_head& head,const char* buf,int32_t len,rtp_session_ptr rs)
+    {
+        if(!IS_META_FRAME(head.type))
+        {
+            return false;
+        }
+
+        if(len <= 0)
+        {
+            return false;
+        }
+
+        const int32_t max_len = MAX_PACKET_LEN - sizeof(RTP_FIXED_HEADER);
+        uint32_t time_stamp = head.time_stamp * 90;
+        int32_t offset = 0;
+
+        while(offset < len)
+        {
+            int32_t size = len - offset;
+            if(size > max_len)
+            {
+                size = max_len;
+            }
+
+            rtp_packet_t packet;
+            RTP_FIXED_HEADER* rtp_hdr = packet.phdr;
+
+            memset(rtp_hdr,0,12);
+            rtp_hdr->version = 2;
+            rtp_hdr->payload = m_payload;
+            rtp_hdr->ssrc = htonl(m_ssrc);
+            rtp_hdr->timestamp = htonl(time_stamp);
+            rtp_hdr->seq_no = htons(m_seq++);
+            rtp_hdr->marker = (offset + size == len) ? 1 : 0;
+
+            packet.rtp_data_len = size + sizeof(RTP_FIXED_HEADER);
+            packet.outside_cnt = 1;
+            packet.outside_info[0].len = size;
+            packet.outside_info[0].data = (uint8_t*)buf + offset;
+            packet._inter_len = TCP_TAG_SIZE + sizeof(RTP_FIXED_HEADER);
+
+            rs->send_packet(&packet);
+            offset += size;
+        }
+
+        return true;
+    }
+
+}}//namespace
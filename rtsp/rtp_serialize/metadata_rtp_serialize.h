@@ -0,0 +1,28 @@
+#ifndef metadata_rtp_serialize_include_h
+#define metadata_rtp_serialize_include_h
+
+#include <rtp_serialize.h>
+#include <util/std.h>
+
+namespace ceanic{namespace rtsp{
+
+//dynamic payload type of the metadata track,must match the sdp
+#define RTP_METADATA_PAYLOAD 107
+
+    //onvif streaming spec 5.2.1.1,one xml document per analysed frame,
+    //split over as many packets as needed with the marker on the last one.
+    //the timestamp uses the 90khz clock of the video so both tracks line up
+    class metadata_rtp_serialize
+        :public rtp_serialize
+    {
+        public:
+            explicit metadata_rtp_serialize(int32_t payload = RTP_METADATA_PAYLOAD);
+
+            virtual ~metadata_rtp_serialize();
+
+            bool serialize(util::stream_head& head,const char* buf,int32_t len,rtp_session_ptr rs);
+    };
+
+}}//namespace
+
+#endif
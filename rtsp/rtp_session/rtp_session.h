@@ -3,6 +3,7 @@
 #include "rtp_type.h"
 #include <util/std.h>
 #include <thread>
+#include <memory>
 
 namespace ceanic{namespace rtsp{
 
@@ -3,10 +3,13 @@
 #include <request.h>
 #include <stream_video_handler.h>
 #include <stream_audio_handler.h>
+#include <stream_meta_handler.h>
 #include <h264_rtp_serialize.h>
 #include <h265_rtp_serialize.h>
 #include <pcmu_rtp_serialize.h>
 #include <aac_rtp_serialize.h>
+#include <jpeg_rtp_serialize.h>
+#include <metadata_rtp_serialize.h>
 #include <rtp_udp_session.h>
 #include <rtp_tcp_session.h>
 #include <rtsp_log.h>
@@ -59,14 +62,14 @@ namespace ceanic{namespace rtsp{
     }
 
     rtsp_request_handler::rtsp_request_handler()
-        :request_handler(), m_state(RTSP_STATE_IDLE)
+        :request_handler(), m_chn(0), m_stream_id(0), m_state(RTSP_STATE_IDLE), m_is_playback(false)
     {
         memset(&m_mh, 0, sizeof(m_mh));
     }
 
     rtsp_request_handler::~rtsp_request_handler()
     {
-        if (m_stream)
+        if (m_stream || m_playback)
         {
             stop_play();
         }
@@ -79,7 +82,7 @@ namespace ceanic{namespace rtsp{
 
     void rtsp_request_handler::stop_play()
     {
-        if (!m_stream)
+        if (!m_stream && !m_playback)
         {
             return;
         }
@@ -87,43 +90,236 @@ namespace ceanic{namespace rtsp{
         if (m_video_handler)
         {
             m_video_handler->stop();
-            m_stream->unregister_stream_observer(m_video_handler);
+            if (m_playback)
+            {
+                m_playback->unregister_stream_observer(m_video_handler);
+            }
+            else
+            {
+                m_stream->unregister_stream_observer(m_video_handler);
+            }
             m_video_handler = nullptr;
         }
 
         if(m_audio_handler)
         {
             m_audio_handler->stop();
-            m_stream->unregister_stream_observer(m_audio_handler);
+            if (m_playback)
+            {
+                m_playback->unregister_stream_observer(m_audio_handler);
+            }
+            else
+            {
+                m_stream->unregister_stream_observer(m_audio_handler);
+            }
             m_audio_handler = nullptr;
         }
 
+        if(m_meta_handler)
+        {
+            m_meta_handler->stop();
+            m_stream->unregister_stream_observer(m_meta_handler);
+            m_meta_handler = nullptr;
+        }
+
+        if (m_playback)
+        {
+            m_playback->stop();
+            m_playback = nullptr;
+            return;
+        }
+
         stream_manager::instance()->del_stream(m_stream->chn(),m_stream->stream_id());
 
         m_stream = nullptr;
     }
 
-    bool rtsp_request_handler::get_channel(std::string& uri, int& chn)
+    void rtsp_request_handler::register_handler(stream_handler_ptr handler)
     {
-        std::string::size_type pos = uri.rfind(std::string("/stream"));
-        if (pos == std::string::npos) 
+        if (m_playback)
+        {
+            m_playback->register_stream_observer(handler);
+        }
+        else
+        {
+            m_stream->register_stream_observer(handler);
+        }
+    }
+
+    bool rtsp_request_handler::open_playback()
+    {
+        if (m_playback)
+        {
+            return true;
+        }
+
+        if (m_playback_file.empty())
+        {
             return false;
+        }
 
-        const char *p = uri.c_str()+pos+1;
+        std::shared_ptr<stream_playback> playback = std::make_shared<stream_playback>(m_playback_file);
+        if (!playback->start())
+        {
+            return false;
+        }
+
+        playback->get_media_head(&m_mh);
+        m_playback = playback;
+        return true;
+    }
+
+    bool rtsp_request_handler::get_playback_file(std::string& uri, std::string& file)
+    {
+        std::string::size_type pos = uri.find(std::string("/playback/"));
+        if (pos == std::string::npos)
+            return false;
+
+        std::string name = uri.substr(pos + strlen("/playback/"));
+
+        pos = name.find('?');
+        if (pos != std::string::npos)
+            name = name.substr(0, pos);
+
+        //setup uses the control url,<file>/video or <file>/audio
+        const char* tracks[] = {"/video", "/audio"};
+        for (uint32_t i = 0; i < sizeof(tracks) / sizeof(tracks[0]); i++)
+        {
+            size_t len = strlen(tracks[i]);
+            if (name.size() > len
+                    && name.compare(name.size() - len, len, tracks[i]) == 0)
+            {
+                name = name.substr(0, name.size() - len);
+                break;
+            }
+        }
+
+        file.clear();
+        if (name.empty() || name.find("..") != std::string::npos)
+        {
+            RTSP_WRITE_LOG_ERROR("bad playback file(%s)",name.c_str());
+            return true;
+        }
+
+        file = stream_manager::instance()->playback_dir() + "/" + name;
+        return true;
+    }
+
+    bool rtsp_request_handler::get_range(const request& req, int32_t& beg)
+    {
+        for (uint32_t i = 0; i < req.headers.size(); i++)
+        {
+            if (strcasecmp(req.headers[i].name.c_str(),"Range") != 0)
+            {
+                continue;
+            }
+
+            const char* p = req.headers[i].value.c_str();
+            while (*p == ' ')
+            {
+                p++;
+            }
+
+            if (strncasecmp(p,"npt=",4) == 0)
+            {
+                p += 4;
+
+                int32_t h, m;
+                double sec;
+                if (sscanf(p,"%d:%d:%lf",&h,&m,&sec) == 3)
+                {
+                    beg = (int32_t)(((h * 60 + m) * 60 + sec) * 1000);
+                    return true;
+                }
+
+                //npt=now- and npt=- keep the current position
+                if (sscanf(p,"%lf",&sec) == 1 && sec >= 0)
+                {
+                    beg = (int32_t)(sec * 1000);
+                    return true;
+                }
+
+                return false;
+            }
+
+            if (strncasecmp(p,"clock=",6) == 0 && m_playback)
+            {
+                struct tm tm;
+                double sec;
+                memset(&tm,0,sizeof(tm));
+                if (sscanf(p + 6,"%4d%2d%2dT%2d%2d%lf",&tm.tm_year,&tm.tm_mon,&tm.tm_mday,&tm.tm_hour,&tm.tm_min,&sec) != 6)
+                {
+                    return false;
+                }
+
+                //utc,as the recorder stamps frames with gettimeofday
+                tm.tm_year -= 1900;
+                tm.tm_mon -= 1;
+                tm.tm_sec = (int)sec;
+                int64_t us = (int64_t)timegm(&tm) * 1000000 + (int64_t)((sec - tm.tm_sec) * 1000000);
+                int64_t start = m_playback->start_time();
+                if (start == 0)
+                {
+                    RTSP_WRITE_LOG_WARN("no wall clock for %s,clock range ignored",m_playback_file.c_str());
+                    return false;
+                }
+
+                beg = us > start ? (int32_t)((us - start) / 1000) : 0;
+                return true;
+            }
 
+            return false;
+        }
+
+        return false;
+    }
+
+    bool rtsp_request_handler::get_scale(const request& req, double& scale)
+    {
+        for (uint32_t i = 0; i < req.headers.size(); i++)
+        {
+            if (strcasecmp(req.headers[i].name.c_str(),"Scale") == 0)
+            {
+                scale = std::atof(req.headers[i].value.c_str());
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    bool rtsp_request_handler::get_channel(std::string& uri, int& chn, int& stream_id)
+    {
         int32_t ch;
+        std::string::size_type pos = uri.rfind(std::string("/mjpeg"));
+        if (pos != std::string::npos) {
+            if (sscanf(uri.c_str() + pos,"/mjpeg%d",&ch) == 1) {
+                chn = ch - 1;
+                stream_id = RTSP_MJPEG_STREAM_ID;
+                return (chn >= 0);
+            }
+            return false;
+        }
+
+        pos = uri.rfind(std::string("/stream"));
+        if (pos == std::string::npos) 
+            return false;
+
+        const char *p = uri.c_str()+pos+1;
 
         std::string::size_type pos_ext = uri.rfind(std::string("/stream="));
         if (pos_ext == pos) {
             if (sscanf(p,"stream=%d",&ch)== 1) {
-                chn = ch;
-                return (chn >= 0);
+                chn = ch / RTSP_STREAMS_PER_CHN;
+                stream_id = ch % RTSP_STREAMS_PER_CHN;
+                return (ch >= 0);
             }
         }
 
         if (sscanf(p,"stream%d",&ch)== 1) {
-            chn = ch-1;
-            return (chn >= 0);
+            chn = (ch - 1) / RTSP_STREAMS_PER_CHN;
+            stream_id = (ch - 1) % RTSP_STREAMS_PER_CHN;
+            return (ch >= 1);
         }
 
         return false;
@@ -143,7 +339,8 @@ namespace ceanic{namespace rtsp{
 #endif
 
         std::string uri = req.uri;
-        if (!get_channel(uri, m_chn))
+        m_is_playback = get_playback_file(uri, m_playback_file);
+        if (!m_is_playback && !get_channel(uri, m_chn, m_stream_id))
         {
             RTSP_WRITE_LOG_ERROR("get channel from url(%s)failed",uri.c_str());
             send_faild(sess);
@@ -171,6 +368,10 @@ namespace ceanic{namespace rtsp{
         {
             RTSP_WRITE_LOG_INFO("play");
             process_method_play(req, sess);
+        }else if (req.method == "PAUSE")
+        {
+            RTSP_WRITE_LOG_INFO("pause");
+            process_method_pause(req, sess);
         }else if (req.method == "TEARDOWN")
         {
             RTSP_WRITE_LOG_INFO("teardown");
@@ -241,7 +442,7 @@ namespace ceanic{namespace rtsp{
         str += std::to_string(m_seq);
         str += "\r\n";
 
-        str += "Public: OPTIONS, DESCRIBE, SETUP, TEARDOWN, PLAY, GET_PARAMETER, SET_PARAMETER\r\n";
+        str += "Public: OPTIONS, DESCRIBE, SETUP, TEARDOWN, PLAY, PAUSE, GET_PARAMETER, SET_PARAMETER\r\n";
         str += "\r\n";
 
         sess.send_packet_n(str.c_str(), str.size());
@@ -249,13 +450,21 @@ namespace ceanic{namespace rtsp{
 
     void rtsp_request_handler::process_method_describe(const request& req, session& sess)
     {
-        if (!stream_manager::instance()->get_stream(m_chn / 3, m_chn % 3,m_stream))
+        if (m_is_playback)
+        {
+            if (!open_playback())
+            {
+                send_faild(sess);
+                return;
+            }
+        }
+        else if (!stream_manager::instance()->get_stream(m_chn, m_stream_id, m_stream))
         {
             send_faild(sess);
             return;
         }
 
-        if(!stream_manager::instance()->get_stream_head(m_stream->chn(),m_stream->stream_id(),&m_mh))
+        if(!m_is_playback && !stream_manager::instance()->get_stream_head(m_stream->chn(),m_stream->stream_id(),&m_mh))
         {
             send_faild(sess);
             return;
@@ -269,7 +478,16 @@ namespace ceanic{namespace rtsp{
         sdp_desc += "s=Streamed by Ceanic Simple Rtsp Server\r\n";
         sdp_desc += "t=0 0\r\n";
 
-        sdp_desc += "a=range:npt= 0-\r\n";
+        if (m_is_playback)
+        {
+            char range[64];
+            snprintf(range,sizeof(range),"a=range:npt=0-%.3f\r\n",m_playback->duration() / 1000.0);
+            sdp_desc += range;
+        }
+        else
+        {
+            sdp_desc += "a=range:npt= 0-\r\n";
+        }
         if (m_mh.video_info.vcode == util::STREAM_VIDEO_ENCODE_H264)
         {
             sdp_desc += "m=video 0 RTP/AVP 96\r\n";
@@ -282,6 +500,12 @@ namespace ceanic{namespace rtsp{
             sdp_desc += "c=IN IP4 0.0.0.0\r\n";
             sdp_desc += "a=rtpmap:96 H265/90000\r\n";
         }
+        else if (m_mh.video_info.vcode == util::STREAM_VIDEO_ENCODE_MJPEG)
+        {
+            sdp_desc += "m=video 0 RTP/AVP 26\r\n";
+            sdp_desc += "c=IN IP4 0.0.0.0\r\n";
+            sdp_desc += "a=rtpmap:26 JPEG/90000\r\n";
+        }
         else
         {
             send_faild(sess);
@@ -308,6 +532,14 @@ namespace ceanic{namespace rtsp{
             sdp_desc += "a=fmtp:97 stream_type=5;profile-level-id=1;mode=AAC-hbr;sizeLength=13;indexLength=3;config=" + str_audio_cfg + ";constantDuration=1024\r\n";
         }
 
+        if(!m_is_playback && m_mh.meta_info.mcode == util::STREAM_META_ENCODE_ONVIF)
+        {
+            sdp_desc += "m=application 0 RTP/AVP " + std::to_string(RTP_METADATA_PAYLOAD) + "\r\n";
+            sdp_desc += "c=IN IP4 0.0.0.0\r\n";
+            sdp_desc += "a=rtpmap:" + std::to_string(RTP_METADATA_PAYLOAD) + " vnd.onvif.metadata/90000\r\n";
+            sdp_desc = sdp_desc + std::string("a=control:") + req.uri + std::string("/metadata\r\n");
+        }
+
         sdp_desc += "\r\n";
 
         std::string str = "RTSP/1.0 200 OK\r\n";
@@ -374,27 +606,43 @@ namespace ceanic{namespace rtsp{
 
     void rtsp_request_handler::process_method_setup(const request& req, session& sess)
     {
-        if (m_state == RTSP_STATE_PLAYING)
+        if (m_state == RTSP_STATE_PLAYING
+                || m_state == RTSP_STATE_PAUSED)
         {
             send_faild(sess);
             return;
         }
 
-        if (!stream_manager::instance()->get_stream(m_chn / 3,m_chn % 3, m_stream))
+        if (m_is_playback)
+        {
+            if (!open_playback())
+            {
+                send_faild(sess);
+                return;
+            }
+        }
+        else if (!stream_manager::instance()->get_stream(m_chn, m_stream_id, m_stream))
         {
             send_faild(sess);
             return;
         }
 
-        std::string::size_type pos = req.uri.rfind(std::string("/audio"));
-        bool is_video = (pos == std::string::npos);
+        bool is_audio = (req.uri.rfind(std::string("/audio")) != std::string::npos);
+        bool is_meta = !m_is_playback && (req.uri.rfind(std::string("/metadata")) != std::string::npos);
+        bool is_video = !is_audio && !is_meta;
+        if (is_meta && m_mh.meta_info.mcode != util::STREAM_META_ENCODE_ONVIF)
+        {
+            RTSP_WRITE_LOG_ERROR("no metadata on stream(chn=%d,stream=%d)",m_chn,m_stream_id);
+            send_faild(sess);
+            return;
+        }
 
         transport_info transport;
         get_transport(req, transport, sess);
 
         std::string transport_str;
         int16_t server_port = transport.client_port[0];
-        int32_t interleaved = is_video ? 0 : 2;
+        int32_t interleaved = is_video ? 0 : (is_audio ? 2 : 4);
 
         if (transport.mode == UDP_MODE)
         {
@@ -475,6 +723,10 @@ namespace ceanic{namespace rtsp{
             {
                 rtp_serialize = rtp_serialize_ptr(new h265_rtp_serialize(96));
             }
+            else if(m_mh.video_info.vcode == util::STREAM_VIDEO_ENCODE_MJPEG)
+            {
+                rtp_serialize = rtp_serialize_ptr(new jpeg_rtp_serialize(RTP_JPEG_PAYLOAD));
+            }
             else 
             {
                 RTSP_WRITE_LOG_ERROR("unsupported vdec code:%d",m_mh.video_info.vcode);
@@ -482,7 +734,13 @@ namespace ceanic{namespace rtsp{
                 return;
             }
             m_video_handler = stream_handler_ptr(new stream_video_handler(rtp_session, rtp_serialize));
-            m_stream->register_stream_observer(m_video_handler);
+            register_handler(m_video_handler);
+        }
+        else if (is_meta)
+        {
+            rtp_serialize = rtp_serialize_ptr(new metadata_rtp_serialize(RTP_METADATA_PAYLOAD));
+            m_meta_handler = stream_handler_ptr(new stream_meta_handler(rtp_session,rtp_serialize));
+            register_handler(m_meta_handler);
         }
         else
         {
@@ -492,7 +750,8 @@ namespace ceanic{namespace rtsp{
             }
             else if(m_mh.audio_info.acode == util::STREAM_AUDIO_ENCODE_AAC)
             {
-                rtp_serialize = rtp_serialize_ptr(new aac_rtp_serialize(97,m_mh.audio_info.sample_rate));
+                //recordings keep raw aac frames,the adts header is already stripped
+                rtp_serialize = rtp_serialize_ptr(new aac_rtp_serialize(97,m_mh.audio_info.sample_rate,!m_playback));
             }
             else
             {
@@ -501,7 +760,7 @@ namespace ceanic{namespace rtsp{
                 return;
             }
             m_audio_handler = stream_handler_ptr(new stream_audio_handler(rtp_session,rtp_serialize));
-            m_stream->register_stream_observer(m_audio_handler);
+            register_handler(m_audio_handler);
         }
 
         m_state = RTSP_STATE_SETUPED;
@@ -509,6 +768,12 @@ namespace ceanic{namespace rtsp{
 
     void rtsp_request_handler::process_method_play(const request& req, session& sess)
     {
+        if (m_is_playback)
+        {
+            process_playback_play(req, sess);
+            return;
+        }
+
         if (m_state != RTSP_STATE_SETUPED)
         {
             send_faild(sess);
@@ -539,9 +804,112 @@ namespace ceanic{namespace rtsp{
             m_audio_handler->start();
         }
 
+        if(m_meta_handler)
+        {
+            m_meta_handler->start();
+        }
+
         stream_manager::instance()->request_i_frame(m_stream->chn(),m_stream->stream_id());
     }
 
+    void rtsp_request_handler::process_playback_play(const request& req, session& sess)
+    {
+        if (!m_playback
+                || (m_state != RTSP_STATE_SETUPED
+                    && m_state != RTSP_STATE_PLAYING
+                    && m_state != RTSP_STATE_PAUSED))
+        {
+            send_faild(sess);
+            return;
+        }
+
+        int32_t beg = -1;
+        double scale = 1.0;
+        get_range(req, beg);
+        bool has_scale = get_scale(req, scale);
+        if (scale <= 0)
+        {
+            RTSP_WRITE_LOG_ERROR("unsupported scale %f",scale);
+            send_faild(sess);
+            return;
+        }
+
+        if (beg < 0 && m_state == RTSP_STATE_SETUPED)
+        {
+            beg = 0;
+        }
+
+        char range[64];
+        snprintf(range,sizeof(range),"npt=%.3f-%.3f",
+                (beg >= 0 ? beg : m_playback->position()) / 1000.0,
+                m_playback->duration() / 1000.0);
+
+        std::string str = "RTSP/1.0 200 OK\r\n";
+        str += "CSeq: ";
+        str += std::to_string(m_seq);
+        str += "\r\n";
+
+        str += "Range: ";
+        str += range;
+        str += "\r\n";
+        if (has_scale)
+        {
+            char scale_str[32];
+            snprintf(scale_str,sizeof(scale_str),"Scale: %.2f\r\n",scale);
+            str += scale_str;
+        }
+        str += "Session: ";
+        str += std::to_string(m_session_no);
+        str += "\r\n";
+        str += "\r\n";
+
+        sess.send_packet_n(str.c_str(), str.size());
+        m_state = RTSP_STATE_PLAYING;
+
+        if (m_video_handler)
+        {
+            m_video_handler->start();
+        }
+
+        if(m_audio_handler)
+        {
+            m_audio_handler->start();
+        }
+
+        //starts with the key frame at or before beg
+        m_playback->play(beg, scale);
+    }
+
+    void rtsp_request_handler::process_method_pause(const request& req, session& sess)
+    {
+        if (!m_is_playback)
+        {
+            process_method_unsupport(req, sess);
+            return;
+        }
+
+        if (!m_playback
+                || (m_state != RTSP_STATE_PLAYING && m_state != RTSP_STATE_PAUSED))
+        {
+            send_faild(sess);
+            return;
+        }
+
+        m_playback->pause();
+
+        std::string str = "RTSP/1.0 200 OK\r\n";
+        str += "CSeq: ";
+        str += std::to_string(m_seq);
+        str += "\r\n";
+        str += "Session: ";
+        str += std::to_string(m_session_no);
+        str += "\r\n";
+        str += "\r\n";
+
+        sess.send_packet_n(str.c_str(), str.size());
+        m_state = RTSP_STATE_PAUSED;
+    }
+
     void rtsp_request_handler::process_method_teardown(const request& req, session& sess)
     {
         std::string str = "RTSP/1.0 200 SUCCESS\r\n";
@@ -550,7 +918,8 @@ namespace ceanic{namespace rtsp{
         str += "\r\n";
         str += "\r\n";
 
-        if (m_state == RTSP_STATE_PLAYING)
+        if (m_state == RTSP_STATE_PLAYING
+                || m_state == RTSP_STATE_PAUSED)
         {
             m_state = RTSP_STATE_IDLE;
             stop_play();
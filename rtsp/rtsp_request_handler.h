@@ -4,9 +4,15 @@
 #include <request_handler.h>
 #include <stream_manager.h>
 #include <stream_handler.h>
+#include <stream_playback.h>
 
 namespace ceanic{namespace rtsp{
 
+//rtsp://ip/stream<n>,n-1 = chn * RTSP_STREAMS_PER_CHN + stream id(main,sub,ai)
+#define RTSP_STREAMS_PER_CHN 3
+//rtsp://ip/mjpeg<n> plays the jpeg stream of chn n-1,as http://ip:port/mjpeg<n>
+#define RTSP_MJPEG_STREAM_ID 3
+
     enum
     {
         TCP_MODE = 0,
@@ -26,6 +32,7 @@ namespace ceanic{namespace rtsp{
         RTSP_STATE_DESCRIBED,
         RTSP_STATE_SETUPED,
         RTSP_STATE_PLAYING,
+        RTSP_STATE_PAUSED,
     }RtspState;
 
     class rtsp_request_handler
@@ -46,6 +53,8 @@ namespace ceanic{namespace rtsp{
 
             void process_method_play(const request& req, session& sess);
 
+            void process_method_pause(const request& req, session& sess);
+
             void process_method_teardown(const request& req, session& sess);
 
             void process_method_unsupport(const request& req, session& sess);
@@ -57,7 +66,10 @@ namespace ceanic{namespace rtsp{
             bool get_transport(const request& req, transport_info& transport, session& sess);
 
             uint32_t get_session_no();
-            bool get_channel(std::string& uri, int& chn);
+            bool get_channel(std::string& uri, int& chn, int& stream_id);
+            bool get_playback_file(std::string& uri, std::string& file);
+            bool get_range(const request& req, int32_t& beg);
+            bool get_scale(const request& req, double& scale);
 
             RtspState state();
 
@@ -74,19 +86,29 @@ namespace ceanic{namespace rtsp{
 
         private:
             void stop_play();
+            bool open_playback();
+            void process_playback_play(const request& req, session& sess);
+            void register_handler(stream_handler_ptr handler);
 
             void send_faild(session& sess);
             int32_t m_session_no;
             int32_t m_seq;
             int32_t m_chn;
+            int32_t m_stream_id;
             RtspState m_state;
 
             stream_handler_ptr m_video_handler;
             stream_handler_ptr m_audio_handler;
+            stream_handler_ptr m_meta_handler;
 
             stream_ptr m_stream;
             util::media_head m_mh;
 
+            //rtsp://ip/playback/<file>,served from a recording instead of a live stream
+            bool m_is_playback;
+            std::string m_playback_file;
+            std::shared_ptr<stream_playback> m_playback;
+
         private:
             static std::mutex udp_port_mutex;
             static int16_t udp_base_port;
@@ -103,7 +103,8 @@ namespace ceanic{namespace rtsp{
             else if (result.has_value() && !result.value())
             {
                 RtspState state = m_handler.state();
-                if (state == RTSP_STATE_PLAYING)
+                if (state == RTSP_STATE_PLAYING
+                        || state == RTSP_STATE_PAUSED)
                 {
                     if (!m_request.method.empty()
                             && m_request.method[0] == '$')
@@ -87,9 +87,22 @@ namespace ceanic{namespace rtsp{
     {
         m_is_run = false;
 
-        m_thread.join();
+        //a derived server stops in its own destructor,the base one comes here again
+        if (m_thread.joinable())
+        {
+            m_thread.join();
+        }
         m_session_ptrs.clear();
-        close(m_listen_s);
+        if (m_listen_s >= 0)
+        {
+            close(m_listen_s);
+            m_listen_s = -1;
+        }
+    }
+
+    session_ptr rtsp_server::create_session(int32_t s)
+    {
+        return session_ptr(new rtsp_session(s, MAX_SESSION_TIMEOUT + 3));
     }
 
     void rtsp_server::on_run()
@@ -194,7 +207,7 @@ namespace ceanic{namespace rtsp{
                 int32_t val = fcntl(s, F_GETFL, 0);
                 fcntl(s, F_SETFL, val | O_NONBLOCK);
 
-                session_ptr sess(new rtsp_session(s, MAX_SESSION_TIMEOUT + 3));
+                session_ptr sess = create_session(s);
                 sess->start();
 
                 m_session_ptrs.push_back(sess);
@@ -19,6 +19,9 @@ namespace ceanic{namespace rtsp{
         protected:
             void on_run();
 
+            //the protocol spoken on the accepted socket
+            virtual session_ptr create_session(int32_t s);
+
         protected:
             int32_t m_listen_s;
             int16_t m_port;
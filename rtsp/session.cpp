@@ -109,5 +109,34 @@ namespace ceanic{namespace rtsp{
         return true;
     }
 
+    bool session::send_packet_v(const struct iovec* iov, int32_t iov_cnt)
+    {
+        std::unique_lock<std::mutex> lock(m_out_buf_mu);
+
+        if (m_out_buf == NULL)
+        {
+            m_out_buf = evbuffer_new();
+        }
+
+        int32_t total = 0;
+        for (int32_t i = 0; i < iov_cnt; i++)
+        {
+            total += iov[i].iov_len;
+        }
+
+        int32_t evlen = evbuffer_get_length(m_out_buf);
+        if (evlen + total >= MAX_EVBUFFER_LEN)
+        {
+            return false;
+        }
+
+        for (int32_t i = 0; i < iov_cnt; i++)
+        {
+            evbuffer_add(m_out_buf, iov[i].iov_base, iov[i].iov_len);
+        }
+
+        return true;
+    }
+
 }}//namespace
 
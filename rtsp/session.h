@@ -8,6 +8,7 @@
 #include <thread>
 #include <optional>
 #include <list>
+#include <sys/uio.h>
 #include <rtp_type.h>
 
 namespace ceanic{namespace rtsp{
@@ -45,6 +46,8 @@ namespace ceanic{namespace rtsp{
 
             void on_idle();
             bool send_packet_n(const char* buf, int32_t buf_len);
+            //all the pieces or none of them,so a frame is never cut when the buffer is full
+            bool send_packet_v(const struct iovec* iov, int32_t iov_cnt);
             bool send_rtp_packet(rtp_packet_t* packet);
 
         protected:
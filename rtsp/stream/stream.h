@@ -2,6 +2,7 @@
 #define stream_include_h
 
 #include "stream_observer.h"
+#include <atomic>
 
 namespace ceanic{namespace rtsp{
 
@@ -12,7 +13,7 @@ namespace ceanic{namespace rtsp{
     {
         public:
             stream(int32_t chn,int32_t stream_id)
-                :stream_obj("rtsp_stream",chn,stream_id),m_is_start(false), m_per_sec_len(0)
+                :stream_obj("rtsp_stream",chn,stream_id),m_is_start(false), m_per_sec_len(0),m_last_stream_time(0)
             {
             }
 
@@ -41,7 +42,7 @@ namespace ceanic{namespace rtsp{
 
             int32_t per_sec_len()
             {
-                return m_is_start ? m_per_sec_len : 0;
+                return m_is_start ? (int32_t)m_per_sec_len.load() : 0;
             }
 
             time_t last_stream_time()
@@ -50,9 +51,10 @@ namespace ceanic{namespace rtsp{
             }
 
         protected:
-            bool m_is_start;
-            uint32_t m_per_sec_len;
-            time_t m_last_stream_time;
+            //written by the frame thread,read by the stream check and the stats
+            std::atomic<bool> m_is_start;
+            std::atomic<uint32_t> m_per_sec_len;
+            std::atomic<time_t> m_last_stream_time;
     };
 
 }}//namespace
@@ -8,7 +8,7 @@ namespace ceanic{namespace rtsp{
     stream_manager* stream_manager::g_instance = NULL;
 
     stream_manager::stream_manager()
-        :m_stream_checking(false)
+        :m_stream_checking(false),m_playback_dir("/mnt")
     {
         memset(&m_ops,0,sizeof(m_ops));
     }
@@ -77,13 +77,13 @@ namespace ceanic{namespace rtsp{
                 t = now;
 
                 std::unique_lock<std::mutex> lock(m_stream_mu);
-                std::list<stream_ptr>::iterator it;
-                for (it = m_streams.begin();it != m_streams.end(); it++)
+                util::stream_registry<stream_stock>::item_list streams = m_streams.all();
+                for (size_t i = 0; i < streams.size(); i++)
                 {
-                    if (abs((*it)->last_stream_time() - now) > 5)
+                    if (abs(streams[i]->last_stream_time() - now) > 5)
                     {
-                        RTSP_WRITE_LOG_WARN("stream(chn=%d,stream=%d) dead",(*it)->chn(),(*it)->stream_id());
-                        m_streams.erase(it);
+                        RTSP_WRITE_LOG_WARN("stream(chn=%d,stream=%d) dead",streams[i]->chn(),streams[i]->stream_id());
+                        m_streams.remove(streams[i]->chn(),streams[i]->stream_id(),streams[i]);
                         break;
                     }
                 }
@@ -99,23 +99,18 @@ namespace ceanic{namespace rtsp{
     {
         std::unique_lock<std::mutex> lock(m_stream_mu);
 
-        std::list<stream_ptr>::iterator it;
-        for (it = m_streams.begin();it != m_streams.end(); it++)
+        stream = m_streams.find_if(chn,stream_id,[](const stream_ptr&){return true;});
+        if (stream)
         {
-            if ((*it)->chn() == chn 
-                    && (*it)->stream_id() == stream_id)
-            {
-                stream = *it;
-                RTSP_WRITE_LOG_INFO("get_stream(chn=%d,stream=%d) success,observer size=%d",chn,stream_id,(*it)->get_observer_size());
-                return true;
-            }
+            RTSP_WRITE_LOG_INFO("get_stream(chn=%d,stream=%d) success,observer size=%d",chn,stream_id,stream->get_observer_size());
+            return true;
         }
 
         stream = std::make_shared<stream_stock>(chn,stream_id);
-        if (stream->start())
+        if (stream->start()
+                && m_streams.add(chn,stream_id,stream))
         {
             RTSP_WRITE_LOG_INFO("get_stream(chn=%d,stream=%d) success",chn,stream_id);
-            m_streams.push_back(stream);
             return true;
         }
 
@@ -127,29 +122,38 @@ namespace ceanic{namespace rtsp{
     {
         std::unique_lock<std::mutex> lock(m_stream_mu);
 
-        std::list<stream_ptr>::iterator it;
-        for (it = m_streams.begin();it != m_streams.end(); it++)
+        stream_ptr stream = m_streams.find_if(chn,stream_id,[](const stream_ptr&){return true;});
+        if (!stream)
         {
-            if ((*it)->chn() == chn 
-                    && (*it)->stream_id() == stream_id)
-            {
-                if ((*it)->get_observer_size() == 0)
-                {
-                    (*it)->stop();
-                    m_streams.erase(it);
-                    RTSP_WRITE_LOG_INFO("del_stream(chn=%d,stream=%d) success",chn,stream_id);
-                    return true;
-                }
+            RTSP_WRITE_LOG_WARN("del_stream(chn=%d,stream=%d) failed (stream not found)",chn,stream_id);
+            return false;
+        }
 
-                RTSP_WRITE_LOG_INFO("del_stream(chn=%d,stream=%d) failed (observer size=%d)",chn,stream_id,(*it)->get_observer_size());
-                return false;
-            }
+        if (stream->get_observer_size() == 0)
+        {
+            //a frame still in process_data sees the stock stopped and drops it
+            stream->stop();
+            m_streams.remove(chn,stream_id,stream);
+            RTSP_WRITE_LOG_INFO("del_stream(chn=%d,stream=%d) success",chn,stream_id);
+            return true;
         }
 
-        RTSP_WRITE_LOG_WARN("del_stream(chn=%d,stream=%d) failed (stream not found)",chn,stream_id);
+        RTSP_WRITE_LOG_INFO("del_stream(chn=%d,stream=%d) failed (observer size=%d)",chn,stream_id,stream->get_observer_size());
         return false;
     }
 
+    void stream_manager::set_playback_dir(std::string dir)
+    {
+        std::unique_lock<std::mutex> lock(m_stream_mu);
+        m_playback_dir = dir;
+    }
+
+    std::string stream_manager::playback_dir()
+    {
+        std::unique_lock<std::mutex> lock(m_stream_mu);
+        return m_playback_dir;
+    }
+
     stream_manager* stream_manager::instance()
     {
         if (g_instance == NULL)
@@ -163,15 +167,12 @@ namespace ceanic{namespace rtsp{
 
     bool stream_manager::process_data(int32_t chn,int32_t stream_id,util::stream_head* head,const char* buf,int32_t len)
     {
-        std::unique_lock<std::mutex> lock(m_stream_mu);
-
-        std::list<stream_ptr>::iterator it;
-        for(it = m_streams.begin();it != m_streams.end(); it++)
+        util::stream_registry<stream_stock>::snapshot streams = m_streams.get(chn,stream_id);
+        if(streams)
         {
-            if((*it)->chn() == chn
-                    && (*it)->stream_id() == stream_id)
+            for(size_t i = 0; i < streams->size(); i++)
             {
-                (*it)->process_data(head,buf,len);
+                (*streams)[i]->process_data(head,buf,len);
             }
         }
 
@@ -2,7 +2,7 @@
 #define stream_manager_include_h
 
 #include "stream_stock.h"
-#include <list>
+#include <util/stream_registry.h>
 #include <mutex>
 #include <thread>
 
@@ -28,8 +28,13 @@ namespace ceanic{namespace rtsp{
 
             static stream_manager* instance();
 
+            //the frame path,takes no lock
             bool process_data(int32_t chn,int32_t stream_id,util::stream_head* head,const char*buf,int32_t len);
 
+            //recordings under this dir are served as rtsp://ip/playback/<file>
+            void set_playback_dir(std::string dir);
+            std::string playback_dir();
+
         private:
             bool start_stream_check();
             void stop_stream_check();
@@ -38,13 +43,15 @@ namespace ceanic{namespace rtsp{
             stream_manager();
             ~stream_manager();
 
-            std::list<stream_ptr> m_streams;
+            util::stream_registry<stream_stock> m_streams;
             static stream_manager* g_instance;
+            //serializes the writers(get/del/check),process_data reads m_streams without it
             std::mutex m_stream_mu;
 
             bool m_stream_checking;
             std::thread m_thread;
             stream_ops m_ops;
+            std::string m_playback_dir;
     };
 
 }}//namespace
@@ -0,0 +1,34 @@
+#ifndef stream_meta_handler_include_h
+#define stream_meta_handler_include_h
+#include <stream_handler.h>
+#include <rtp_session.h>
+#include <rtp_serialize.h>
+
+namespace ceanic{namespace rtsp{
+
+    //analytics metadata track,fed with STREAM_META_FRAME heads of the live stream
+    class stream_meta_handler
+        : public stream_handler
+    {
+        public:
+            stream_meta_handler(rtp_session_ptr session_ptr, rtp_serialize_ptr serial_ptr);
+
+            virtual ~stream_meta_handler();
+
+            bool start();
+
+            void stop();
+
+            int& get_rtcp_timeout();
+
+        protected:
+            virtual bool process_stream(util::stream_obj_ptr sobj,util::stream_head* head, const char* data, int32_t len);
+
+        protected:
+            rtp_session_ptr m_rtp_session;
+            rtp_serialize_ptr m_rtp_serialize;
+    };
+
+}}//namespace
+
+#endif
@@ -0,0 +1,85 @@
+#include "stream_mjpeg_handler.h"
+#include <rtsp_log.h>
+
+namespace ceanic{namespace rtsp{
+
+    stream_mjpeg_handler::stream_mjpeg_handler(session& sess)
+        :m_sess(sess), m_timeout(MAX_SESSION_TIMEOUT), m_drop_cnt(0)
+    {
+    }
+
+    stream_mjpeg_handler::~stream_mjpeg_handler()
+    {
+        stop();
+    }
+
+    bool stream_mjpeg_handler::start()
+    {
+        if (is_start())
+        {
+            return false;
+        }
+
+        m_timeout = MAX_SESSION_TIMEOUT;
+        m_beg = time(NULL);
+        m_start = true;
+        return true;
+    }
+
+    void stream_mjpeg_handler::stop()
+    {
+        if (is_start())
+        {
+            m_start = false;
+        }
+    }
+
+    int& stream_mjpeg_handler::get_rtcp_timeout()
+    {
+        return m_timeout;
+    }
+
+    bool stream_mjpeg_handler::process_stream(util::stream_obj_ptr sobj,util::stream_head* head, const char* data, int32_t len)
+    {
+        if (!is_start())
+        {
+            return false;
+        }
+
+        if (head->type != STREAM_MJPEG_FRAME || head->nalu.empty())
+        {
+            return false;
+        }
+
+        uint32_t jpg_len = 0;
+        for (uint32_t i = 0; i < head->nalu.size(); i++)
+        {
+            jpg_len += head->nalu[i].size;
+        }
+
+        char part_head[128];
+        int32_t head_len = snprintf(part_head, sizeof(part_head),
+                "--" MJPEG_BOUNDARY "\r\nContent-Type: image/jpeg\r\nContent-Length: %u\r\n\r\n", jpg_len);
+
+        m_iov.clear();
+        m_iov.push_back({part_head, (size_t)head_len});
+        for (uint32_t i = 0; i < head->nalu.size(); i++)
+        {
+            m_iov.push_back({head->nalu[i].data, head->nalu[i].size});
+        }
+        m_iov.push_back({(void*)"\r\n", 2});
+
+        if (!m_sess.send_packet_v(m_iov.data(), m_iov.size()))
+        {
+            if (m_drop_cnt++ % 100 == 0)
+            {
+                RTSP_WRITE_LOG_WARN("mjpeg viewer %s too slow,%u frames dropped", m_sess.ip().c_str(), m_drop_cnt);
+            }
+            return false;
+        }
+
+        m_timeout = MAX_SESSION_TIMEOUT;
+        return true;
+    }
+
+}}//namespace
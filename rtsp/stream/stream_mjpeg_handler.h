@@ -0,0 +1,45 @@
+#ifndef stream_mjpeg_handler_include_h
+#define stream_mjpeg_handler_include_h
+#include <stream_handler.h>
+#include <session.h>
+
+namespace ceanic{namespace rtsp{
+
+#define MJPEG_BOUNDARY "ceanicboundary"
+
+    //multipart/x-mixed-replace parts for one http viewer,every viewer gets the
+    //same encoded jpeg.a frame that does not fit the socket buffer is skipped as a
+    //whole,so a slow viewer drops frames without holding the others back
+    class stream_mjpeg_handler
+        : public stream_handler
+    {
+        public:
+            stream_mjpeg_handler(session& sess);
+
+            virtual ~stream_mjpeg_handler();
+
+            bool start();
+
+            void stop();
+
+            //refreshed by every frame queued,runs out when the viewer stops reading
+            int& get_rtcp_timeout();
+
+            uint32_t drop_count()
+            {
+                return m_drop_cnt;
+            }
+
+        protected:
+            virtual bool process_stream(util::stream_obj_ptr sobj,util::stream_head* head, const char* data, int32_t len);
+
+        protected:
+            session& m_sess;
+            int m_timeout;
+            uint32_t m_drop_cnt;
+            std::vector<struct iovec> m_iov;
+    };
+
+}}//namespace
+
+#endif
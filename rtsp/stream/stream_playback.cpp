@@ -0,0 +1,263 @@
+#include "stream_playback.h"
+#include <util/std.h>
+#include <chrono>
+#include <rtsp_log.h>
+
+namespace ceanic{namespace rtsp{
+
+//a client stalled longer than this is not caught up with a burst,pacing restarts from the next frame
+#define PLAYBACK_MAX_LAG 1000
+
+    static int64_t now_ms()
+    {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    stream_playback::stream_playback(std::string file)
+        :stream(-1,0),m_file(file),m_playing(false),m_seek(false),m_seek_time(0),m_scale(1.0)
+         ,m_base_set(false),m_base_wall(0),m_base_time(0),m_position(0),m_has_sample(false)
+    {
+        m_name = "rtsp_playback";
+        memset(&m_sample,0,sizeof(m_sample));
+    }
+
+    stream_playback::~stream_playback()
+    {
+        stop();
+    }
+
+    bool stream_playback::start()
+    {
+        if (is_start())
+        {
+            return false;
+        }
+
+        if (!m_reader.open(m_file.c_str()))
+        {
+            RTSP_WRITE_LOG_ERROR("open playback file %s failed",m_file.c_str());
+            return false;
+        }
+
+        m_last_stream_time = time(NULL);
+        m_playing = false;
+        m_seek = true;
+        m_seek_time = 0;
+        m_scale = 1.0;
+        m_has_sample = false;
+        m_position = 0;
+
+        m_is_start = true;
+        m_thread = std::thread(&stream_playback::on_process,this);
+
+        RTSP_WRITE_LOG_INFO("playback %s,duration %u ms",m_file.c_str(),m_reader.duration());
+        return true;
+    }
+
+    void stream_playback::stop()
+    {
+        if (!m_is_start)
+        {
+            return;
+        }
+
+        {
+            std::unique_lock<std::mutex> lock(m_mu);
+            m_is_start = false;
+            m_cond.notify_one();
+        }
+        m_thread.join();
+
+        m_reader.close();
+    }
+
+    bool stream_playback::get_media_head(util::media_head* mh)
+    {
+        if (!m_reader.is_open())
+        {
+            return false;
+        }
+
+        *mh = m_reader.get_media_head();
+        return true;
+    }
+
+    uint32_t stream_playback::duration()
+    {
+        return m_reader.duration();
+    }
+
+    uint64_t stream_playback::start_time()
+    {
+        return m_reader.start_time();
+    }
+
+    bool stream_playback::play(int32_t beg,double scale)
+    {
+        std::unique_lock<std::mutex> lock(m_mu);
+
+        if (!m_is_start || scale <= 0)
+        {
+            return false;
+        }
+
+        if (beg >= 0)
+        {
+            m_seek = true;
+            m_seek_time = beg;
+        }
+
+        if (scale > 1.0
+                && m_has_sample
+                && !(m_sample.video && m_sample.key))
+        {
+            m_has_sample = false;
+        }
+
+        m_scale = scale;
+        m_base_set = false;
+        m_playing = true;
+        m_cond.notify_one();
+        return true;
+    }
+
+    void stream_playback::pause()
+    {
+        std::unique_lock<std::mutex> lock(m_mu);
+
+        m_playing = false;
+        m_cond.notify_one();
+    }
+
+    uint32_t stream_playback::position()
+    {
+        std::unique_lock<std::mutex> lock(m_mu);
+
+        if (m_seek)
+        {
+            return m_seek_time;
+        }
+
+        return m_has_sample ? m_sample.time : m_position;
+    }
+
+    void stream_playback::on_process()
+    {
+        std::unique_lock<std::mutex> lock(m_mu);
+
+        while (m_is_start)
+        {
+            if (!m_playing)
+            {
+                m_cond.wait(lock);
+                continue;
+            }
+
+            if (m_seek)
+            {
+                uint32_t key_time = 0;
+                m_reader.seek(m_seek_time,&key_time);
+                m_seek = false;
+                m_has_sample = false;
+                m_base_set = false;
+            }
+
+            if (!m_has_sample)
+            {
+                if (!m_reader.next_sample(m_sample))
+                {
+                    RTSP_WRITE_LOG_INFO("playback %s end",m_file.c_str());
+                    m_playing = false;
+                    continue;
+                }
+
+                //fast forward sends key frames only,audio is dropped.
+                //slow motion plays every sample,stretched by the pacing below
+                if (m_scale > 1.0
+                        && !(m_sample.video && m_sample.key))
+                {
+                    continue;
+                }
+
+                m_has_sample = true;
+            }
+
+            int64_t now = now_ms();
+            if (!m_base_set)
+            {
+                m_base_wall = now;
+                m_base_time = m_sample.time;
+                m_base_set = true;
+            }
+
+            int64_t due = m_base_wall + (int64_t)(((int64_t)m_sample.time - (int64_t)m_base_time) / m_scale);
+            if (due > now)
+            {
+                m_cond.wait_for(lock,std::chrono::milliseconds(due - now));
+                continue;
+            }
+
+            if (now - due > PLAYBACK_MAX_LAG)
+            {
+                m_base_set = false;
+            }
+
+            stream_save::fmp4_reader::sample_t s = m_sample;
+            m_has_sample = false;
+            m_position = s.time;
+
+            //the samples live in the mapping until stop(),send without the lock so pause/seek are not blocked
+            lock.unlock();
+            send_sample(s);
+            lock.lock();
+        }
+    }
+
+    void stream_playback::send_sample(stream_save::fmp4_reader::sample_t& s)
+    {
+        util::stream_head head;
+        head.time_stamp = s.time;
+        m_last_stream_time = time(NULL);
+
+        if (!s.video)
+        {
+            head.type = STREAM_AUDIO_FRAME;
+            head.len = s.len;
+            post_stream_to_observer(shared_from_this(),&head,(const char*)s.data,s.len);
+            return;
+        }
+
+        //the 4 bytes length prefix stands in for the start code the rtp serializers skip
+        head.type = STREAM_NALU_SLICE;
+        auto add_nalus = [&](const uint8_t* data,uint32_t len)
+        {
+            uint32_t pos = 0;
+            while (pos + 4 <= len)
+            {
+                uint32_t size = ((uint32_t)data[pos] << 24) | ((uint32_t)data[pos + 1] << 16) | ((uint32_t)data[pos + 2] << 8) | data[pos + 3];
+                if (size == 0 || size > len - pos - 4)
+                {
+                    break;
+                }
+
+                head.nalu.push_back((uint8_t*)data + pos,size + 4,s.time);
+                head.len += size + 4;
+                pos += size + 4;
+            }
+        };
+
+        //parameter sets are only in the sample entry,resend them ahead of every key frame
+        if (s.key)
+        {
+            const std::vector<uint8_t>& ps = m_reader.param_sets();
+            add_nalus(ps.data(),ps.size());
+        }
+        add_nalus(s.data,s.len);
+
+        if (!head.nalu.empty())
+        {
+            post_stream_to_observer(shared_from_this(),&head,(const char*)s.data,s.len);
+        }
+    }
+
+}}//namespace
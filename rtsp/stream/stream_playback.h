@@ -0,0 +1,67 @@
+#ifndef stream_playback_include_h
+#define stream_playback_include_h
+
+#include <stream.h>
+#include <fmp4_reader.h>
+#include <condition_variable>
+
+namespace ceanic{namespace rtsp{
+
+    //one recorded file played back for one rtsp session.
+    //frames are paced by their own thread and never touch the live streams or the encoder
+    class stream_playback
+        :public stream
+    {
+        public:
+            explicit stream_playback(std::string file);
+
+            virtual ~stream_playback();
+
+            virtual bool start();
+
+            virtual void stop();
+
+            virtual bool get_media_head(util::media_head* mh);
+
+            //ms
+            uint32_t duration();
+            //us,wall clock of media time 0,0 if unknown
+            uint64_t start_time();
+
+            //beg: ms,-1 resumes from the current position.scale > 1 sends key frames only
+            bool play(int32_t beg,double scale);
+
+            void pause();
+
+            //ms,media time of the last frame sent
+            uint32_t position();
+
+        private:
+            void on_process();
+            void send_sample(stream_save::fmp4_reader::sample_t& s);
+
+        private:
+            std::string m_file;
+            stream_save::fmp4_reader m_reader;
+
+            std::mutex m_mu;
+            std::condition_variable m_cond;
+            std::thread m_thread;
+            bool m_playing;
+            bool m_seek;
+            uint32_t m_seek_time;
+            double m_scale;
+
+            //pacing: a frame is due at m_base_wall + (time - m_base_time) / scale
+            bool m_base_set;
+            int64_t m_base_wall;
+            uint32_t m_base_time;
+            uint32_t m_position;
+
+            stream_save::fmp4_reader::sample_t m_sample;
+            bool m_has_sample;
+    };
+
+}}//namespace
+
+#endif
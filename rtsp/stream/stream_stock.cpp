@@ -6,7 +6,7 @@
 namespace ceanic{namespace rtsp{
 
     stream_stock::stream_stock(int32_t chn,int32_t stream_id)
-        :stream(chn,stream_id)
+        :stream(chn,stream_id),m_stream_len(0)
     {
     }
 
@@ -31,20 +31,17 @@ namespace ceanic{namespace rtsp{
 
     void stream_stock::stop()
     {
-        if (m_is_start)
-        {
-            m_is_start = false;
-        }
+        m_is_start = false;
     }
 
     void stream_stock::process_data(util::stream_head* head,const char* buf,int32_t len)
     {
+        //the stream check and the stats read the counters from their own threads
         time_t now = time(NULL);
-        if(now != m_last_stream_time)
+        time_t last = m_last_stream_time;
+        if(now != last && m_last_stream_time.compare_exchange_strong(last,now))
         {
-            m_last_stream_time = now;
-            m_per_sec_len = m_stream_len / 1024;
-            m_stream_len = 0;
+            m_per_sec_len = m_stream_len.exchange(0) / 1024;
         }
         m_stream_len += len;
 
@@ -23,7 +23,7 @@ namespace ceanic{namespace rtsp{
             void process_data(util::stream_head* head,const char* buf,int32_t len);
 
         protected:
-            uint32_t m_stream_len;
+            std::atomic<uint32_t> m_stream_len;
     };
 
 }}//namespace
@@ -0,0 +1,306 @@
+#include "startup_dag.h"
+#include <stdio.h>
+#include <thread>
+#include <chrono>
+#include <exception>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace ceanic{namespace startup{
+
+    static uint64_t now_us()
+    {
+        return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    startup_dag::startup_dag()
+        :m_total_us(0),m_finished(0),m_begin_us(0)
+    {
+    }
+
+    startup_dag::~startup_dag()
+    {
+    }
+
+    bool startup_dag::add(const char* name,const std::vector<std::string>& deps,step_fun fun)
+    {
+        if(m_index.find(name) != m_index.end())
+        {
+            printf("[%s]: step %s added twice\n",__FUNCTION__,name);
+            return false;
+        }
+
+        m_index[name] = m_names.size();
+        m_names.push_back(name);
+        m_dep_names.push_back(deps);
+
+        step_t step;
+        step.fun = fun;
+        m_steps.push_back(step);
+        return true;
+    }
+
+    void startup_dag::set_observer(step_observer observer)
+    {
+        m_observer = observer;
+    }
+
+    const std::vector<step_result>& startup_dag::results()
+    {
+        return m_results;
+    }
+
+    uint64_t startup_dag::total_us()
+    {
+        return m_total_us;
+    }
+
+    uint64_t startup_dag::elapsed_us()
+    {
+        return now_us() - m_begin_us;
+    }
+
+    bool startup_dag::build()
+    {
+        for(uint32_t i = 0; i < m_steps.size(); i++)
+        {
+            m_steps[i].deps.clear();
+            m_steps[i].dependents.clear();
+        }
+
+        for(uint32_t i = 0; i < m_steps.size(); i++)
+        {
+            for(size_t d = 0; d < m_dep_names[i].size(); d++)
+            {
+                auto it = m_index.find(m_dep_names[i][d]);
+                if(it == m_index.end())
+                {
+                    printf("[%s]: %s depends on the unknown step %s\n",__FUNCTION__,m_names[i].c_str(),m_dep_names[i][d].c_str());
+                    return false;
+                }
+                m_steps[i].deps.push_back(it->second);
+                m_steps[it->second].dependents.push_back(i);
+            }
+        }
+
+        //kahn:every step is reached only without a cycle
+        std::vector<uint32_t> waiting(m_steps.size());
+        std::vector<uint32_t> ready;
+        for(uint32_t i = 0; i < m_steps.size(); i++)
+        {
+            waiting[i] = m_steps[i].deps.size();
+            if(waiting[i] == 0)
+            {
+                ready.push_back(i);
+            }
+        }
+
+        size_t reached = 0;
+        while(!ready.empty())
+        {
+            uint32_t idx = ready.back();
+            ready.pop_back();
+            reached++;
+            for(size_t d = 0; d < m_steps[idx].dependents.size(); d++)
+            {
+                uint32_t dep = m_steps[idx].dependents[d];
+                if(--waiting[dep] == 0)
+                {
+                    ready.push_back(dep);
+                }
+            }
+        }
+
+        if(reached != m_steps.size())
+        {
+            printf("[%s]: the steps have a cycle\n",__FUNCTION__);
+            return false;
+        }
+
+        return true;
+    }
+
+    void startup_dag::finish(uint32_t idx)
+    {
+        m_finished++;
+        if(m_observer)
+        {
+            m_observer(m_results[idx]);
+        }
+
+        bool ok = m_results[idx].ok;
+        for(size_t d = 0; d < m_steps[idx].dependents.size(); d++)
+        {
+            uint32_t dep = m_steps[idx].dependents[d];
+            step_result& r = m_results[dep];
+            if(r.skipped)
+            {
+                continue;
+            }
+
+            if(!ok)
+            {
+                r.skipped = true;
+                r.begin_us = r.end_us = elapsed_us();
+                finish(dep);
+            }
+            else if(--m_waiting[dep] == 0)
+            {
+                m_ready.insert(dep);
+            }
+        }
+    }
+
+    void startup_dag::worker(uint32_t id)
+    {
+        std::unique_lock<std::mutex> lock(m_mu);
+        while(true)
+        {
+            m_cond.wait(lock,[this]{return !m_ready.empty() || m_finished == m_steps.size();});
+            if(m_ready.empty())
+            {
+                return;
+            }
+
+            uint32_t idx = *m_ready.begin();
+            m_ready.erase(m_ready.begin());
+            m_results[idx].worker = id;
+            m_results[idx].begin_us = elapsed_us();
+            lock.unlock();
+
+            bool ok = false;
+            try
+            {
+                ok = m_steps[idx].fun();
+            }
+            catch(const std::exception& e)
+            {
+                printf("[%s]: step %s threw %s\n",__FUNCTION__,m_names[idx].c_str(),e.what());
+            }
+
+            lock.lock();
+            m_results[idx].ok = ok;
+            m_results[idx].end_us = elapsed_us();
+            finish(idx);
+            m_cond.notify_all();
+        }
+    }
+
+    bool startup_dag::run(uint32_t threads)
+    {
+        m_results.clear();
+        m_total_us = 0;
+        if(!build())
+        {
+            return false;
+        }
+
+        m_results.resize(m_steps.size());
+        m_waiting.resize(m_steps.size());
+        m_ready.clear();
+        m_finished = 0;
+        for(uint32_t i = 0; i < m_steps.size(); i++)
+        {
+            m_results[i].name = m_names[i];
+            m_results[i].ok = false;
+            m_results[i].skipped = false;
+            m_results[i].begin_us = 0;
+            m_results[i].end_us = 0;
+            m_results[i].worker = 0;
+            m_waiting[i] = m_steps[i].deps.size();
+            if(m_waiting[i] == 0)
+            {
+                m_ready.insert(i);
+            }
+        }
+
+        if(threads == 0)
+        {
+            threads = 1;
+        }
+        if(threads > m_steps.size())
+        {
+            threads = m_steps.size();
+        }
+
+        m_begin_us = now_us();
+        std::vector<std::thread> pool;
+        for(uint32_t i = 1; i < threads; i++)
+        {
+            pool.push_back(std::thread(&startup_dag::worker,this,i));
+        }
+        //the caller is worker 0
+        worker(0);
+        for(size_t i = 0; i < pool.size(); i++)
+        {
+            pool[i].join();
+        }
+        m_total_us = elapsed_us();
+
+        for(size_t i = 0; i < m_results.size(); i++)
+        {
+            if(!m_results[i].ok)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    std::vector<std::string> startup_dag::critical_path()
+    {
+        std::vector<std::string> path;
+        if(m_results.empty())
+        {
+            return path;
+        }
+
+        uint32_t idx = 0;
+        for(uint32_t i = 1; i < m_results.size(); i++)
+        {
+            if(m_results[i].end_us > m_results[idx].end_us)
+            {
+                idx = i;
+            }
+        }
+
+        while(true)
+        {
+            path.insert(path.begin(),m_results[idx].name);
+            if(m_steps[idx].deps.empty())
+            {
+                break;
+            }
+
+            uint32_t last = m_steps[idx].deps[0];
+            for(size_t d = 1; d < m_steps[idx].deps.size(); d++)
+            {
+                if(m_results[m_steps[idx].deps[d]].end_us > m_results[last].end_us)
+                {
+                    last = m_steps[idx].deps[d];
+                }
+            }
+            idx = last;
+        }
+        return path;
+    }
+
+    bool prefetch_file(const char* path)
+    {
+        int fd = open(path,O_RDONLY);
+        if(fd < 0)
+        {
+            printf("[%s]: open %s failed\n",__FUNCTION__,path);
+            return false;
+        }
+
+        posix_fadvise(fd,0,0,POSIX_FADV_SEQUENTIAL);
+        std::vector<char> buf(1024 * 1024);
+        while(read(fd,buf.data(),buf.size()) > 0)
+        {
+        }
+        close(fd);
+        return true;
+    }
+
+}}//namespace
@@ -0,0 +1,93 @@
+#ifndef startup_dag_include_h
+#define startup_dag_include_h
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+
+namespace ceanic{namespace startup{
+
+    typedef struct
+    {
+        std::string name;
+        bool ok;
+        bool skipped;       //a dependency failed,the step did not run
+        uint64_t begin_us;  //from the start of run()
+        uint64_t end_us;
+        uint32_t worker;
+    }step_result;
+
+    typedef std::function<bool()> step_fun;
+    typedef std::function<void(const step_result&)> step_observer;
+
+    //boot steps and what they wait for,run on a small pool of threads.
+    //a step starts once all of its dependencies succeeded,the ready ones in the order
+    //they were added,so the chain that matters most(the main stream) goes first.
+    //the dependents of a failed step are skipped,the other branches go on
+    class startup_dag
+    {
+        public:
+            startup_dag();
+            virtual ~startup_dag();
+
+        public:
+            //false for a duplicate name,the dependencies may be added later
+            bool add(const char* name,const std::vector<std::string>& deps,step_fun fun);
+
+            //called from the worker for every finished or skipped step,with the steps locked
+            void set_observer(step_observer observer);
+
+            //blocks until every step finished.false when a dependency is unknown or the
+            //steps have a cycle(nothing runs then) or when a step failed or was skipped
+            bool run(uint32_t threads);
+
+            //in the order of add()
+            const std::vector<step_result>& results();
+            uint64_t total_us();
+            //the chain of steps that ended last,each waiting on its latest dependency
+            std::vector<std::string> critical_path();
+
+        private:
+            typedef struct
+            {
+                std::vector<uint32_t> deps;
+                std::vector<uint32_t> dependents;
+                step_fun fun;
+            }step_t;
+
+            bool build();
+            void worker(uint32_t id);
+            //under m_mu:releases the dependents of idx,or skips them when it did not succeed
+            void finish(uint32_t idx);
+            uint64_t elapsed_us();
+
+        private:
+            std::vector<std::string> m_names;
+            std::vector<std::vector<std::string>> m_dep_names;
+            std::map<std::string,uint32_t> m_index;
+            std::vector<step_t> m_steps;
+            std::vector<step_result> m_results;
+            step_observer m_observer;
+            uint64_t m_total_us;
+
+            //state of a run
+            std::mutex m_mu;
+            std::condition_variable m_cond;
+            std::set<uint32_t> m_ready;
+            std::vector<uint32_t> m_waiting;
+            uint32_t m_finished;
+            uint64_t m_begin_us;
+    };
+
+    //reads path once,so the page cache holds it when the real load comes.
+    //for the model files of steps that have to wait for others
+    bool prefetch_file(const char* path);
+
+}}//namespace
+
+#endif
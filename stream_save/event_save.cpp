@@ -0,0 +1,428 @@
+#include "event_save.h"
+#include <dirent.h>
+#include <time.h>
+#include <vector>
+#include <algorithm>
+
+namespace ceanic{namespace stream_save{
+
+#define EVENT_SAVE_PREFIX "event_"
+#define EVENT_SAVE_SUFFIX ".mp4"
+#define EVENT_SAVE_US (1000000ULL)
+
+    event_save_param event_save::default_param()
+    {
+        event_save_param param;
+        memset(&param,0,sizeof(param));
+        sprintf(param.dir_path,"%s","/mnt/event");
+        param.pre_time = 10;
+        param.post_time = 20;
+        param.segment_time = 300;
+        param.max_segments = 100;
+        param.ring_size = 16 * 1024 * 1024;
+        param.mp4 = mp4_save::default_param();
+        return param;
+    }
+
+    event_save::event_save(ceanic::util::media_head mh,const event_save_param* param)
+        :m_bopen(false),m_mh(mh),m_param(param ? *param : default_param()),m_pool(m_param.ring_size)
+         ,m_ring_bytes(0),m_record_end(0),m_last_pts(0),m_job_exit(false)
+    {
+        if(m_param.max_segments == 0)
+        {
+            m_param.max_segments = 1;
+        }
+    }
+
+    event_save::~event_save()
+    {
+        assert(!m_bopen);
+    }
+
+    bool event_save::open()
+    {
+        std::unique_lock<std::mutex> lock(m_interface_mu);
+
+        if(m_bopen)
+        {
+            return false;
+        }
+
+        if(access(m_param.dir_path,F_OK) < 0
+                && mkdir(m_param.dir_path,0755) < 0)
+        {
+            printf("[%s]:mkdir %s failed,errno:%d\n",__FUNCTION__,m_param.dir_path,errno);
+            return false;
+        }
+
+        m_job_exit = false;
+        m_job_thread = std::thread(&event_save::on_process,this);
+
+        std::unique_lock<std::mutex> sl(m_mu);
+        m_last_pts = 0;
+        m_bopen = true;
+        return true;
+    }
+
+    void event_save::close()
+    {
+        std::unique_lock<std::mutex> lock(m_interface_mu);
+
+        if(!m_bopen)
+        {
+            return ;
+        }
+
+        {
+            std::unique_lock<std::mutex> sl(m_mu);
+            m_bopen = false;
+            close_segment();
+            m_ring.clear();
+            m_ring_bytes = 0;
+        }
+
+        {
+            std::unique_lock<std::mutex> jl(m_job_mu);
+            m_job_exit = true;
+            m_job_cond.notify_one();
+        }
+        m_job_thread.join();
+
+        m_pool.clear();
+    }
+
+    bool event_save::is_open()
+    {
+        std::unique_lock<std::mutex> lock(m_interface_mu);
+
+        return m_bopen;
+    }
+
+    bool event_save::is_recording()
+    {
+        std::unique_lock<std::mutex> lock(m_mu);
+
+        return m_segment != nullptr;
+    }
+
+    bool event_save::input_data(ceanic::util::stream_head* head,const char* buf,int32_t len)
+    {
+        if(IS_AUDIO_FRAME(head->type)
+                && m_mh.audio_info.acode == ceanic::util::STREAM_AUDIO_ENCODE_NONE)
+        {
+            return false;
+        }
+
+        save_frame_ptr frame = m_pool.make_frame(m_mh.video_info.vcode,head,buf,len);
+        if(!frame)
+        {
+            return IS_VIDEO_FRAME(head->type) ? false : true;
+        }
+
+        std::unique_lock<std::mutex> lock(m_mu);
+        if(!m_bopen)
+        {
+            return false;
+        }
+
+        push_ring(frame);
+
+        //segments always start and stop on a key frame
+        if(m_segment
+                && frame->type == 0
+                && frame->key)
+        {
+            if(frame->pts >= m_record_end)
+            {
+                printf("[%s]:event record end,%s\n",__FUNCTION__,m_segment->file.c_str());
+                close_segment();
+            }
+            else if(frame->pts - m_segment->beg_pts >= (uint64_t)m_param.segment_time * EVENT_SAVE_US)
+            {
+                close_segment();
+                open_segment(frame->pts);
+            }
+        }
+
+        if(m_segment)
+        {
+            write_frame(frame);
+        }
+
+        m_pool.release(frame);
+        return true;
+    }
+
+    bool event_save::trigger(const char* reason)
+    {
+        std::unique_lock<std::mutex> lock(m_mu);
+
+        if(!m_bopen)
+        {
+            return false;
+        }
+
+        struct timeval tv;
+        gettimeofday(&tv, NULL);
+        uint64_t now = (uint64_t)tv.tv_sec * EVENT_SAVE_US + (uint64_t)tv.tv_usec;
+
+        m_record_end = now + (uint64_t)m_param.post_time * EVENT_SAVE_US;
+        if(m_segment)
+        {
+            return true;
+        }
+
+        //pre-event footage the last segment did not get,from a key frame on.
+        //the frames are shared with the ring,no copy
+        uint64_t last_pts = m_last_pts;
+        size_t first = 0;
+        while(first < m_ring.size()
+                && !(m_ring[first]->type == 0 && m_ring[first]->key && m_ring[first]->pts > last_pts))
+        {
+            first++;
+        }
+
+        open_segment(first < m_ring.size() ? m_ring[first]->pts : now);
+
+        uint32_t pre_bytes = 0;
+        for(size_t i = first; i < m_ring.size(); i++)
+        {
+            if(m_ring[i]->pts > last_pts)
+            {
+                pre_bytes += m_ring[i]->len();
+                write_frame(m_ring[i]);
+            }
+        }
+
+        printf("[%s]:event(%s) record start,pre-event %u KB\n",__FUNCTION__,reason ? reason : "",pre_bytes / 1024);
+        return true;
+    }
+
+    void event_save::push_ring(save_frame_ptr& frame)
+    {
+        //the ring always starts with a key frame
+        if(m_ring.empty()
+                && !(frame->type == 0 && frame->key))
+        {
+            return;
+        }
+
+        m_ring.push_back(frame);
+        m_ring_bytes += frame->len();
+
+        if((frame->type == 0 && frame->key)
+                || m_ring_bytes > m_param.ring_size)
+        {
+            trim_ring();
+        }
+    }
+
+    void event_save::trim_ring()
+    {
+        uint64_t pre_us = (uint64_t)m_param.pre_time * EVENT_SAVE_US;
+
+        //drop whole GOPs from the front while the rest still covers pre_time,
+        //or the ring is over its memory limit.the newest GOP is always kept
+        while(true)
+        {
+            size_t next = 1;
+            while(next < m_ring.size()
+                    && !(m_ring[next]->type == 0 && m_ring[next]->key))
+            {
+                next++;
+            }
+
+            if(next >= m_ring.size())
+            {
+                break;
+            }
+
+            if(m_ring.back()->pts - m_ring[next]->pts < pre_us
+                    && m_ring_bytes <= m_param.ring_size)
+            {
+                break;
+            }
+
+            for(size_t i = 0; i < next; i++)
+            {
+                m_ring_bytes -= m_ring.front()->len();
+                m_pool.release(m_ring.front());
+                m_ring.pop_front();
+            }
+        }
+    }
+
+    void event_save::open_segment(uint64_t beg_pts)
+    {
+        m_segment = std::make_shared<segment_t>();
+        m_segment->beg_pts = beg_pts;
+        m_segment->failed = false;
+        queue_job(m_segment,true);
+    }
+
+    void event_save::close_segment()
+    {
+        if(!m_segment)
+        {
+            return;
+        }
+
+        queue_job(m_segment,false);
+        m_segment = nullptr;
+    }
+
+    void event_save::write_frame(save_frame_ptr& frame)
+    {
+        if(m_segment->mp4)
+        {
+            m_segment->mp4->input_frame(frame);
+        }
+        else if(!m_segment->failed)
+        {
+            m_segment->pending.push_back(frame);
+        }
+
+        if(frame->pts > m_last_pts)
+        {
+            m_last_pts = frame->pts;
+        }
+    }
+
+    void event_save::queue_job(const segment_ptr& segment,bool open)
+    {
+        std::unique_lock<std::mutex> lock(m_job_mu);
+        m_jobs.push_back({segment,open});
+        m_job_cond.notify_one();
+    }
+
+    void event_save::open_segment_file(const segment_ptr& segment)
+    {
+        char file[512];
+        char tm_str[64];
+        struct tm tm_now;
+        time_t t = time(NULL);
+
+        localtime_r(&t,&tm_now);
+        strftime(tm_str,sizeof(tm_str),"%Y%m%d_%H%M%S",&tm_now);
+        snprintf(file,sizeof(file),"%s/%s%s%s",m_param.dir_path,EVENT_SAVE_PREFIX,tm_str,EVENT_SAVE_SUFFIX);
+        for(int i = 1; access(file,F_OK) == 0; i++)
+        {
+            snprintf(file,sizeof(file),"%s/%s%s_%d%s",m_param.dir_path,EVENT_SAVE_PREFIX,tm_str,i,EVENT_SAVE_SUFFIX);
+        }
+
+        //the pre-event ring and the frames waiting for the open are queued at once,make room for them.
+        //frames are shared,so this costs no memory
+        mp4_save_param mp4 = m_param.mp4;
+        mp4.queue_size += m_param.ring_size;
+
+        std::shared_ptr<mp4_save> save = std::make_shared<mp4_save>(m_mh,file,&mp4);
+        bool ok = save->open();
+        if(!ok)
+        {
+            printf("[%s]:open %s failed\n",__FUNCTION__,file);
+        }
+
+        std::unique_lock<std::mutex> lock(m_mu);
+        segment->file = file;
+        for(auto& f : segment->pending)
+        {
+            if(ok)
+            {
+                save->input_frame(f);
+            }
+            m_pool.release(f);
+        }
+        segment->pending.clear();
+
+        if(ok)
+        {
+            segment->mp4 = save;
+        }
+        else
+        {
+            segment->failed = true;
+        }
+    }
+
+    void event_save::remove_old_segments()
+    {
+        std::string cur_file;
+        {
+            std::unique_lock<std::mutex> lock(m_mu);
+            if(m_segment)
+            {
+                cur_file = m_segment->file;
+            }
+        }
+
+        DIR* dir = opendir(m_param.dir_path);
+        if(dir == NULL)
+        {
+            return;
+        }
+
+        std::vector<std::string> files;
+        struct dirent* ent;
+        size_t prefix_len = strlen(EVENT_SAVE_PREFIX);
+        size_t suffix_len = strlen(EVENT_SAVE_SUFFIX);
+        while((ent = readdir(dir)) != NULL)
+        {
+            size_t name_len = strlen(ent->d_name);
+            if(name_len > prefix_len + suffix_len
+                    && strncmp(ent->d_name,EVENT_SAVE_PREFIX,prefix_len) == 0
+                    && strcmp(ent->d_name + name_len - suffix_len,EVENT_SAVE_SUFFIX) == 0)
+            {
+                files.push_back(std::string(m_param.dir_path) + "/" + ent->d_name);
+            }
+        }
+        closedir(dir);
+
+        //names carry the start time,so the oldest sort first
+        std::sort(files.begin(),files.end());
+        for(size_t i = 0; i + m_param.max_segments < files.size(); i++)
+        {
+            if(files[i] == cur_file)
+            {
+                continue;
+            }
+
+            printf("[%s]:remove %s\n",__FUNCTION__,files[i].c_str());
+            unlink(files[i].c_str());
+        }
+    }
+
+    void event_save::on_process()
+    {
+        while(true)
+        {
+            segment_job_t job;
+            {
+                std::unique_lock<std::mutex> lock(m_job_mu);
+                m_job_cond.wait(lock,[this]{ return !m_jobs.empty() || m_job_exit; });
+                if(m_jobs.empty())
+                {
+                    break;
+                }
+
+                job = m_jobs.front();
+                m_jobs.pop_front();
+            }
+
+            if(job.open)
+            {
+                open_segment_file(job.segment);
+                continue;
+            }
+
+            //the open job of a segment always runs before its close job,mp4 is only set here
+            if(job.segment->mp4)
+            {
+                job.segment->mp4->close();
+            }
+            job.segment = nullptr;
+
+            remove_old_segments();
+        }
+    }
+
+}}//namespace
@@ -0,0 +1,105 @@
+#ifndef event_save_include_h
+#define event_save_include_h
+
+#include <util/std.h>
+#include <string>
+#include <deque>
+#include <list>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include "stream_save.h"
+#include "frame_queue.h"
+#include "mp4_save.h"
+
+namespace ceanic{namespace stream_save{
+
+    typedef struct
+    {
+        char dir_path[255];     //segments are saved as dir_path/event_YYYYmmdd_HHMMSS.mp4
+        uint32_t pre_time;      //s,footage kept before the trigger
+        uint32_t post_time;     //s,footage saved after the last trigger
+        uint32_t segment_time;  //s,max length of one segment
+        uint32_t max_segments;  //oldest segments are removed beyond this count
+        uint32_t ring_size;     //bytes,memory limit of the pre-event ring
+        mp4_save_param mp4;
+    }event_save_param;
+
+    //keeps the last pre_time seconds of stream in memory(whole GOPs),
+    //and writes pre-event + post-event footage to rolling mp4 segments when triggered
+    class event_save
+        :public stream_save
+    {
+        public:
+            event_save(ceanic::util::media_head mh,const event_save_param* param);
+            virtual ~event_save();
+
+        public:
+            bool open() override;
+            void close() override;
+            bool is_open() override;
+            bool input_data(ceanic::util::stream_head* head,const char* buf,int32_t len) override;
+
+            //start recording,or extend the running one by post_time.
+            //the segment is opened on the worker thread,frames wait in memory until then
+            bool trigger(const char* reason);
+            bool is_recording();
+
+            static event_save_param default_param();
+
+        private:
+            typedef struct
+            {
+                uint64_t beg_pts;
+                std::string file;                   //set by the worker,guarded by m_mu
+                std::shared_ptr<mp4_save> mp4;      //set by the worker once opened,guarded by m_mu
+                std::deque<save_frame_ptr> pending; //frames until then,guarded by m_mu
+                bool failed;                        //the open failed,frames are dropped
+            }segment_t;
+            typedef std::shared_ptr<segment_t> segment_ptr;
+
+            typedef struct
+            {
+                segment_ptr segment;
+                bool open;          //true:create and open the mp4,false:close it
+            }segment_job_t;
+
+        private:
+            void push_ring(save_frame_ptr& frame);
+            void trim_ring();
+            //under m_mu,the mp4 is created and opened by the worker
+            void open_segment(uint64_t beg_pts);
+            void close_segment();
+            void write_frame(save_frame_ptr& frame);
+            void queue_job(const segment_ptr& segment,bool open);
+            void open_segment_file(const segment_ptr& segment);
+            void remove_old_segments();
+            void on_process();
+
+        private:
+            bool m_bopen;
+            ceanic::util::media_head m_mh;
+            event_save_param m_param;
+
+            std::mutex m_interface_mu;
+
+            //ring and recording state,guarded by m_mu
+            std::mutex m_mu;
+            frame_queue m_pool;
+            std::deque<save_frame_ptr> m_ring;
+            uint32_t m_ring_bytes;
+            segment_ptr m_segment;
+            uint64_t m_record_end;
+            uint64_t m_last_pts;    //latest frame given to a segment,a new trigger does not repeat the ring before it
+
+            //segments to open and close,creating,preallocating and finalizing the file must not block the stream thread
+            std::mutex m_job_mu;
+            std::condition_variable m_job_cond;
+            std::list<segment_job_t> m_jobs;
+            bool m_job_exit;
+            std::thread m_job_thread;
+    };
+
+}}//namespace
+
+#endif
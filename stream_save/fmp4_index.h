@@ -0,0 +1,44 @@
+#ifndef fmp4_index_include_h
+#define fmp4_index_include_h
+
+#include <stdint.h>
+
+namespace ceanic{namespace stream_save{
+
+//sidecar key frame index of a fragmented mp4,saved as <file>.idx next to the recording.
+//one head,then one entry for every fragment that starts with a key frame
+#define FMP4_INDEX_TAG 0x58444e49
+#define FMP4_INDEX_VERSION 1
+#define FMP4_INDEX_SUFFIX ".idx"
+
+    typedef struct
+    {
+        uint32_t tag;
+        uint32_t version;
+        uint64_t start_time;    //us,wall clock of media time 0
+    }fmp4_index_head;
+
+    typedef struct
+    {
+        uint32_t time;          //ms,media time of the key frame
+        uint32_t reserved;
+        uint64_t offset;        //file offset of the moof
+    }fmp4_index_entry;
+
+    //receives the index instead of the sidecar file,used when the file is a preallocated container
+    class fmp4_index_sink
+    {
+        public:
+            virtual ~fmp4_index_sink()
+            {
+            }
+
+            virtual void on_index_start(uint64_t start_time) = 0;
+            virtual void on_index_entry(const fmp4_index_entry& entry) = 0;
+            //after every fragment: valid bytes in the file,media time(ms) of the fragment end
+            virtual void on_index_update(uint64_t bytes,uint32_t end_time) = 0;
+    };
+
+}}//namespace
+
+#endif
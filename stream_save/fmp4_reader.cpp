@@ -0,0 +1,892 @@
+#include "fmp4_reader.h"
+#include "segment_pool.h"
+#include <util/std.h>
+#include <sys/mman.h>
+#include <algorithm>
+
+namespace ceanic{namespace stream_save{
+
+#define FMP4_FOURCC(a,b,c,d) (((uint32_t)(a) << 24) | ((uint32_t)(b) << 16) | ((uint32_t)(c) << 8) | (uint32_t)(d))
+#define FMP4_BOX_MOOV FMP4_FOURCC('m','o','o','v')
+#define FMP4_BOX_TRAK FMP4_FOURCC('t','r','a','k')
+#define FMP4_BOX_TKHD FMP4_FOURCC('t','k','h','d')
+#define FMP4_BOX_MDIA FMP4_FOURCC('m','d','i','a')
+#define FMP4_BOX_MDHD FMP4_FOURCC('m','d','h','d')
+#define FMP4_BOX_HDLR FMP4_FOURCC('h','d','l','r')
+#define FMP4_BOX_MINF FMP4_FOURCC('m','i','n','f')
+#define FMP4_BOX_STBL FMP4_FOURCC('s','t','b','l')
+#define FMP4_BOX_STSD FMP4_FOURCC('s','t','s','d')
+#define FMP4_BOX_AVC1 FMP4_FOURCC('a','v','c','1')
+#define FMP4_BOX_AVCC FMP4_FOURCC('a','v','c','C')
+#define FMP4_BOX_HVC1 FMP4_FOURCC('h','v','c','1')
+#define FMP4_BOX_HEV1 FMP4_FOURCC('h','e','v','1')
+#define FMP4_BOX_HVCC FMP4_FOURCC('h','v','c','C')
+#define FMP4_BOX_MP4A FMP4_FOURCC('m','p','4','a')
+#define FMP4_BOX_ULAW FMP4_FOURCC('u','l','a','w')
+#define FMP4_BOX_MOOF FMP4_FOURCC('m','o','o','f')
+#define FMP4_BOX_TRAF FMP4_FOURCC('t','r','a','f')
+#define FMP4_BOX_TFHD FMP4_FOURCC('t','f','h','d')
+#define FMP4_BOX_TFDT FMP4_FOURCC('t','f','d','t')
+#define FMP4_BOX_TRUN FMP4_FOURCC('t','r','u','n')
+#define FMP4_HANDLER_VIDE FMP4_FOURCC('v','i','d','e')
+#define FMP4_HANDLER_SOUN FMP4_FOURCC('s','o','u','n')
+
+//sample_is_non_sync_sample
+#define FMP4_SAMPLE_NON_SYNC_FLAG 0x00010000
+
+    static uint16_t rd_u16(const uint8_t* p)
+    {
+        return ((uint16_t)p[0] << 8) | p[1];
+    }
+
+    static uint32_t rd_u24(const uint8_t* p)
+    {
+        return ((uint32_t)p[0] << 16) | ((uint32_t)p[1] << 8) | p[2];
+    }
+
+    static uint32_t rd_u32(const uint8_t* p)
+    {
+        return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+    }
+
+    static uint64_t rd_u64(const uint8_t* p)
+    {
+        return ((uint64_t)rd_u32(p) << 32) | rd_u32(p + 4);
+    }
+
+    static void put_param_set(std::vector<uint8_t>& b,const uint8_t* data,uint32_t len)
+    {
+        b.push_back(len >> 24);
+        b.push_back((len >> 16) & 0xff);
+        b.push_back((len >> 8) & 0xff);
+        b.push_back(len & 0xff);
+        b.insert(b.end(),data,data + len);
+    }
+
+    fmp4_reader::fmp4_reader()
+        :m_fd(-1),m_map(NULL),m_size(0),m_first_moof(0),m_start_time(0),m_duration(0)
+         ,m_sample_pos(0),m_next_pos(0)
+    {
+        memset(&m_mh,0,sizeof(m_mh));
+        memset(&m_video,0,sizeof(m_video));
+        memset(&m_audio,0,sizeof(m_audio));
+    }
+
+    fmp4_reader::~fmp4_reader()
+    {
+        close();
+    }
+
+    bool fmp4_reader::open(const char* file)
+    {
+        if(m_fd >= 0)
+        {
+            return false;
+        }
+
+        m_fd = ::open(file,O_RDONLY);
+        if(m_fd < 0)
+        {
+            printf("[%s]:open %s failed,errno:%d\n",__FUNCTION__,file,errno);
+            return false;
+        }
+
+        struct stat st;
+        if(fstat(m_fd,&st) < 0
+                || st.st_size <= 0
+                || (uint64_t)st.st_size > (uint64_t)SIZE_MAX)
+        {
+            printf("[%s]:%s bad size\n",__FUNCTION__,file);
+            close();
+            return false;
+        }
+
+        //a file still being recorded is served up to its size at open
+        m_size = st.st_size;
+        void* map = mmap(NULL,m_size,PROT_READ,MAP_SHARED,m_fd,0);
+        if(map == MAP_FAILED)
+        {
+            printf("[%s]:mmap %s failed,errno:%d\n",__FUNCTION__,file,errno);
+            m_map = NULL;
+            close();
+            return false;
+        }
+        m_map = (uint8_t*)map;
+
+        memset(&m_mh,0,sizeof(m_mh));
+        memset(&m_video,0,sizeof(m_video));
+        memset(&m_audio,0,sizeof(m_audio));
+        m_param_sets.clear();
+        m_first_moof = 0;
+
+        uint64_t pos = 0;
+        uint64_t size;
+        uint32_t type;
+        uint32_t head_len;
+        while(m_first_moof == 0
+                && read_box(pos,m_size,&size,&type,&head_len))
+        {
+            if(type == FMP4_BOX_MOOV)
+            {
+                parse_moov(pos + head_len,pos + size);
+            }
+            else if(type == FMP4_BOX_MOOF)
+            {
+                m_first_moof = pos;
+            }
+
+            pos += size;
+        }
+
+        if(m_video.id == 0
+                || m_param_sets.empty()
+                || m_first_moof == 0)
+        {
+            printf("[%s]:%s is not a playable fragmented mp4\n",__FUNCTION__,file);
+            close();
+            return false;
+        }
+
+        if(!load_index(file))
+        {
+            build_index();
+        }
+        calc_duration();
+
+        //frame rate from the first fragment,only used for the media head
+        m_mh.video_info.fr = 25;
+        std::vector<sample_t> samples;
+        if(read_box(m_first_moof,m_size,&size,&type,&head_len)
+                && parse_moof(m_first_moof,m_first_moof + size,samples))
+        {
+            uint32_t cnt = 0;
+            uint32_t beg = 0;
+            uint32_t end = 0;
+            for(auto& s : samples)
+            {
+                if(s.video)
+                {
+                    if(cnt == 0)
+                    {
+                        beg = s.time;
+                    }
+                    end = s.time;
+                    cnt++;
+                }
+            }
+
+            if(cnt > 1 && end > beg)
+            {
+                m_mh.video_info.fr = ((cnt - 1) * 1000 + (end - beg) / 2) / (end - beg);
+            }
+        }
+
+        uint32_t key_time;
+        seek(0,&key_time);
+        return true;
+    }
+
+    void fmp4_reader::close()
+    {
+        if(m_map)
+        {
+            munmap(m_map,m_size);
+            m_map = NULL;
+        }
+
+        if(m_fd >= 0)
+        {
+            ::close(m_fd);
+            m_fd = -1;
+        }
+
+        m_size = 0;
+        m_index.clear();
+        m_samples.clear();
+        m_sample_pos = 0;
+        m_next_pos = 0;
+    }
+
+    bool fmp4_reader::is_open()
+    {
+        return m_fd >= 0;
+    }
+
+    ceanic::util::media_head fmp4_reader::get_media_head()
+    {
+        return m_mh;
+    }
+
+    uint32_t fmp4_reader::duration()
+    {
+        return m_duration;
+    }
+
+    uint64_t fmp4_reader::start_time()
+    {
+        return m_start_time;
+    }
+
+    const std::vector<uint8_t>& fmp4_reader::param_sets()
+    {
+        return m_param_sets;
+    }
+
+    bool fmp4_reader::read_box(uint64_t pos,uint64_t end,uint64_t* size,uint32_t* type,uint32_t* head_len)
+    {
+        if(pos + 8 > end)
+        {
+            return false;
+        }
+
+        *size = rd_u32(m_map + pos);
+        *type = rd_u32(m_map + pos + 4);
+        *head_len = 8;
+        if(*size == 1)
+        {
+            if(pos + 16 > end)
+            {
+                return false;
+            }
+
+            *size = rd_u64(m_map + pos + 8);
+            *head_len = 16;
+        }
+        else if(*size == 0)
+        {
+            *size = end - pos;
+        }
+
+        return *size >= *head_len && *size <= end - pos;
+    }
+
+    bool fmp4_reader::parse_moov(uint64_t pos,uint64_t end)
+    {
+        uint64_t size;
+        uint32_t type;
+        uint32_t head_len;
+        while(read_box(pos,end,&size,&type,&head_len))
+        {
+            if(type == FMP4_BOX_TRAK)
+            {
+                parse_trak(pos + head_len,pos + size);
+            }
+
+            pos += size;
+        }
+
+        return m_video.id != 0;
+    }
+
+    bool fmp4_reader::parse_trak(uint64_t pos,uint64_t end)
+    {
+        //the boxes a track needs,as payload ranges
+        uint64_t tkhd = 0,tkhd_end = 0;
+        uint64_t mdhd = 0,mdhd_end = 0;
+        uint64_t hdlr = 0,hdlr_end = 0;
+        uint64_t stsd = 0,stsd_end = 0;
+
+        uint64_t size;
+        uint32_t type;
+        uint32_t head_len;
+        //trak/mdia/minf/stbl
+        uint64_t stack[4][2] = {{pos,end},{0,0},{0,0},{0,0}};
+        int depth = 0;
+        while(depth >= 0)
+        {
+            uint64_t& cur = stack[depth][0];
+            if(!read_box(cur,stack[depth][1],&size,&type,&head_len))
+            {
+                depth--;
+                continue;
+            }
+
+            uint64_t beg = cur + head_len;
+            uint64_t box_end = cur + size;
+            cur = box_end;
+
+            if(type == FMP4_BOX_TKHD)
+            {
+                tkhd = beg;
+                tkhd_end = box_end;
+            }
+            else if(type == FMP4_BOX_MDHD)
+            {
+                mdhd = beg;
+                mdhd_end = box_end;
+            }
+            else if(type == FMP4_BOX_HDLR)
+            {
+                hdlr = beg;
+                hdlr_end = box_end;
+            }
+            else if(type == FMP4_BOX_STSD)
+            {
+                stsd = beg;
+                stsd_end = box_end;
+            }
+            else if((type == FMP4_BOX_MDIA || type == FMP4_BOX_MINF || type == FMP4_BOX_STBL)
+                    && depth < 3)
+            {
+                depth++;
+                stack[depth][0] = beg;
+                stack[depth][1] = box_end;
+            }
+        }
+
+        if(tkhd_end < tkhd + 24
+                || mdhd_end < mdhd + 24
+                || hdlr_end < hdlr + 12
+                || stsd_end < stsd + 8)
+        {
+            return false;
+        }
+
+        bool v1 = (m_map[tkhd] == 1);
+        track_t track;
+        track.id = rd_u32(m_map + tkhd + (v1 ? 20 : 12));
+        v1 = (m_map[mdhd] == 1);
+        track.timescale = rd_u32(m_map + mdhd + (v1 ? 20 : 12));
+        if(track.id == 0 || track.timescale == 0)
+        {
+            return false;
+        }
+
+        uint32_t handler = rd_u32(m_map + hdlr + 8);
+        if(handler == FMP4_HANDLER_VIDE && m_video.id == 0)
+        {
+            if(!parse_stsd(stsd,stsd_end,true))
+            {
+                return false;
+            }
+
+            m_video = track;
+            if(tkhd_end >= tkhd + 8)
+            {
+                m_mh.video_info.w = rd_u32(m_map + tkhd_end - 8) >> 16;
+                m_mh.video_info.h = rd_u32(m_map + tkhd_end - 4) >> 16;
+            }
+        }
+        else if(handler == FMP4_HANDLER_SOUN && m_audio.id == 0)
+        {
+            if(!parse_stsd(stsd,stsd_end,false))
+            {
+                return false;
+            }
+
+            m_audio = track;
+            m_mh.audio_info.sample_rate = track.timescale;
+        }
+
+        return true;
+    }
+
+    bool fmp4_reader::parse_stsd(uint64_t pos,uint64_t end,bool video)
+    {
+        uint64_t size;
+        uint32_t type;
+        uint32_t head_len;
+
+        //version,flags and entry_count,then the first sample entry
+        pos += 8;
+        if(!read_box(pos,end,&size,&type,&head_len))
+        {
+            return false;
+        }
+
+        uint64_t entry = pos + head_len;
+        uint64_t entry_end = pos + size;
+
+        if(!video)
+        {
+            if(entry + 20 > entry_end)
+            {
+                return false;
+            }
+
+            if(type == FMP4_BOX_MP4A)
+            {
+                m_mh.audio_info.acode = ceanic::util::STREAM_AUDIO_ENCODE_AAC;
+            }
+            else if(type == FMP4_BOX_ULAW)
+            {
+                m_mh.audio_info.acode = ceanic::util::STREAM_AUDIO_ENCODE_G711U;
+            }
+            else
+            {
+                return false;
+            }
+
+            m_mh.audio_info.chn = rd_u16(m_map + entry + 16);
+            m_mh.audio_info.bit_width = 16;
+            return true;
+        }
+
+        bool h264 = (type == FMP4_BOX_AVC1);
+        if(!h264 && type != FMP4_BOX_HVC1 && type != FMP4_BOX_HEV1)
+        {
+            return false;
+        }
+        m_mh.video_info.vcode = h264 ? ceanic::util::STREAM_VIDEO_ENCODE_H264 : ceanic::util::STREAM_VIDEO_ENCODE_H265;
+
+        //visual sample entry is 78 bytes,then the codec config box
+        pos = entry + 78;
+        while(read_box(pos,entry_end,&size,&type,&head_len))
+        {
+            const uint8_t* p = m_map + pos + head_len;
+            const uint8_t* p_end = m_map + pos + size;
+            pos += size;
+
+            if(h264 && type == FMP4_BOX_AVCC)
+            {
+                if(p + 6 > p_end)
+                {
+                    return false;
+                }
+
+                uint32_t cnt = p[5] & 0x1f;
+                p += 6;
+                for(int set = 0; set < 2; set++)
+                {
+                    for(uint32_t i = 0; i < cnt && p + 2 <= p_end; i++)
+                    {
+                        uint16_t len = rd_u16(p);
+                        if(p + 2 + len > p_end)
+                        {
+                            return false;
+                        }
+                        put_param_set(m_param_sets,p + 2,len);
+                        p += 2 + len;
+                    }
+
+                    //pps count follows the sps
+                    if(set == 0)
+                    {
+                        if(p >= p_end)
+                        {
+                            break;
+                        }
+                        cnt = *p++;
+                    }
+                }
+
+                return !m_param_sets.empty();
+            }
+            else if(!h264 && type == FMP4_BOX_HVCC)
+            {
+                if(p + 23 > p_end)
+                {
+                    return false;
+                }
+
+                uint32_t arrays = p[22];
+                p += 23;
+                for(uint32_t a = 0; a < arrays && p + 3 <= p_end; a++)
+                {
+                    uint16_t cnt = rd_u16(p + 1);
+                    p += 3;
+                    for(uint16_t i = 0; i < cnt && p + 2 <= p_end; i++)
+                    {
+                        uint16_t len = rd_u16(p);
+                        if(p + 2 + len > p_end)
+                        {
+                            return false;
+                        }
+                        put_param_set(m_param_sets,p + 2,len);
+                        p += 2 + len;
+                    }
+                }
+
+                return !m_param_sets.empty();
+            }
+        }
+
+        return false;
+    }
+
+    bool fmp4_reader::parse_moof(uint64_t pos,uint64_t end,std::vector<sample_t>& samples)
+    {
+        uint64_t moof = pos;
+        uint64_t size;
+        uint32_t type;
+        uint32_t head_len;
+
+        samples.clear();
+        if(!read_box(pos,end,&size,&type,&head_len) || type != FMP4_BOX_MOOF)
+        {
+            return false;
+        }
+
+        pos += head_len;
+        while(read_box(pos,end,&size,&type,&head_len))
+        {
+            if(type == FMP4_BOX_TRAF)
+            {
+                parse_traf(moof,pos + head_len,pos + size,samples);
+            }
+
+            pos += size;
+        }
+
+        //video and audio trafs are stored one after the other,play them interleaved
+        std::stable_sort(samples.begin(),samples.end(),[](const sample_t& a,const sample_t& b)
+        {
+            return a.time < b.time;
+        });
+
+        return true;
+    }
+
+    bool fmp4_reader::parse_traf(uint64_t moof,uint64_t pos,uint64_t end,std::vector<sample_t>& samples)
+    {
+        uint64_t size;
+        uint32_t type;
+        uint32_t head_len;
+
+        const track_t* track = NULL;
+        uint64_t base = moof;
+        uint32_t def_duration = 0;
+        uint32_t def_size = 0;
+        uint32_t def_flags = 0;
+        uint64_t dts = 0;
+        uint64_t data_pos = 0;
+        bool data_pos_set = false;
+
+        while(read_box(pos,end,&size,&type,&head_len))
+        {
+            const uint8_t* p = m_map + pos + head_len;
+            const uint8_t* p_end = m_map + pos + size;
+            pos += size;
+
+            if(type == FMP4_BOX_TFHD)
+            {
+                if(p + 8 > p_end)
+                {
+                    return false;
+                }
+
+                uint32_t flags = rd_u24(p + 1);
+                uint32_t id = rd_u32(p + 4);
+                if(id == m_video.id)
+                {
+                    track = &m_video;
+                }
+                else if(id == m_audio.id && m_audio.id != 0)
+                {
+                    track = &m_audio;
+                }
+                else
+                {
+                    return false;
+                }
+
+                p += 8;
+                if((flags & 0x01) && p + 8 <= p_end)
+                {
+                    base = rd_u64(p);
+                    p += 8;
+                }
+                if(flags & 0x02)
+                {
+                    p += 4;
+                }
+                if((flags & 0x08) && p + 4 <= p_end)
+                {
+                    def_duration = rd_u32(p);
+                    p += 4;
+                }
+                if((flags & 0x10) && p + 4 <= p_end)
+                {
+                    def_size = rd_u32(p);
+                    p += 4;
+                }
+                if((flags & 0x20) && p + 4 <= p_end)
+                {
+                    def_flags = rd_u32(p);
+                }
+            }
+            else if(type == FMP4_BOX_TFDT && p + 8 <= p_end)
+            {
+                dts = (p[0] == 1 && p + 12 <= p_end) ? rd_u64(p + 4) : rd_u32(p + 4);
+            }
+            else if(type == FMP4_BOX_TRUN && track != NULL && p + 8 <= p_end)
+            {
+                uint32_t flags = rd_u24(p + 1);
+                uint32_t cnt = rd_u32(p + 4);
+                p += 8;
+
+                if(flags & 0x01)
+                {
+                    if(p + 4 > p_end)
+                    {
+                        return false;
+                    }
+                    data_pos = base + (int32_t)rd_u32(p);
+                    data_pos_set = true;
+                    p += 4;
+                }
+                else if(!data_pos_set)
+                {
+                    data_pos = base;
+                    data_pos_set = true;
+                }
+
+                uint32_t first_flags = def_flags;
+                bool has_first_flags = false;
+                if(flags & 0x04)
+                {
+                    if(p + 4 > p_end)
+                    {
+                        return false;
+                    }
+                    first_flags = rd_u32(p);
+                    has_first_flags = true;
+                    p += 4;
+                }
+
+                uint32_t entry_len = ((flags & 0x100) ? 4 : 0) + ((flags & 0x200) ? 4 : 0)
+                    + ((flags & 0x400) ? 4 : 0) + ((flags & 0x800) ? 4 : 0);
+                if((uint64_t)cnt * entry_len > (uint64_t)(p_end - p))
+                {
+                    return false;
+                }
+
+                for(uint32_t i = 0; i < cnt; i++)
+                {
+                    uint32_t duration = def_duration;
+                    uint32_t sample_size = def_size;
+                    uint32_t sample_flags = (i == 0 && has_first_flags) ? first_flags : def_flags;
+                    if(flags & 0x100)
+                    {
+                        duration = rd_u32(p);
+                        p += 4;
+                    }
+                    if(flags & 0x200)
+                    {
+                        sample_size = rd_u32(p);
+                        p += 4;
+                    }
+                    if(flags & 0x400)
+                    {
+                        sample_flags = rd_u32(p);
+                        p += 4;
+                    }
+                    if(flags & 0x800)
+                    {
+                        p += 4;
+                    }
+
+                    if(data_pos + sample_size > m_size)
+                    {
+                        //truncated by a power cut or still being written
+                        return false;
+                    }
+
+                    sample_t s;
+                    s.video = (track == &m_video);
+                    s.key = s.video ? !(sample_flags & FMP4_SAMPLE_NON_SYNC_FLAG) : true;
+                    s.time = dts * 1000 / track->timescale;
+                    s.data = m_map + data_pos;
+                    s.len = sample_size;
+                    samples.push_back(s);
+
+                    data_pos += sample_size;
+                    dts += duration;
+                }
+            }
+        }
+
+        return true;
+    }
+
+    bool fmp4_reader::load_fragment()
+    {
+        uint64_t size;
+        uint32_t type;
+        uint32_t head_len;
+
+        m_samples.clear();
+        m_sample_pos = 0;
+        while(read_box(m_next_pos,m_size,&size,&type,&head_len))
+        {
+            uint64_t pos = m_next_pos;
+            m_next_pos += size;
+
+            if(type == FMP4_BOX_MOOF
+                    && parse_moof(pos,pos + size,m_samples)
+                    && !m_samples.empty())
+            {
+                return true;
+            }
+        }
+
+        m_next_pos = m_size;
+        return false;
+    }
+
+    bool fmp4_reader::load_index(const char* file)
+    {
+        m_index.clear();
+        m_start_time = 0;
+
+        //sidecar of a plain recording,or the pool index of a preallocated segment
+        if(!load_sidecar_index(file)
+                && !segment_pool::load_segment_index(file,&m_start_time,m_index))
+        {
+            return false;
+        }
+
+        //drop entries past the mapped size,or out of order
+        size_t n = 0;
+        for(size_t i = 0; i < m_index.size(); i++)
+        {
+            if(m_index[i].offset < m_first_moof
+                    || m_index[i].offset >= m_size
+                    || (n > 0 && m_index[i].time < m_index[n - 1].time))
+            {
+                break;
+            }
+            m_index[n++] = m_index[i];
+        }
+        m_index.resize(n);
+
+        return !m_index.empty();
+    }
+
+    bool fmp4_reader::load_sidecar_index(const char* file)
+    {
+        std::string index_file = std::string(file) + FMP4_INDEX_SUFFIX;
+        int fd = ::open(index_file.c_str(),O_RDONLY);
+        if(fd < 0)
+        {
+            return false;
+        }
+
+        fmp4_index_head head;
+        if(::read(fd,&head,sizeof(head)) != sizeof(head)
+                || head.tag != FMP4_INDEX_TAG
+                || head.version != FMP4_INDEX_VERSION)
+        {
+            ::close(fd);
+            return false;
+        }
+
+        struct stat st;
+        if(fstat(fd,&st) == 0 && st.st_size > (off_t)sizeof(head))
+        {
+            m_index.resize((st.st_size - sizeof(head)) / sizeof(fmp4_index_entry));
+            ssize_t len = ::read(fd,m_index.data(),m_index.size() * sizeof(fmp4_index_entry));
+            m_index.resize(len > 0 ? len / sizeof(fmp4_index_entry) : 0);
+        }
+        ::close(fd);
+
+        m_start_time = head.start_time;
+        return true;
+    }
+
+    void fmp4_reader::build_index()
+    {
+        //no index from the recorder,walk all fragments once
+        uint64_t pos = m_first_moof;
+        uint64_t size;
+        uint32_t type;
+        uint32_t head_len;
+        std::vector<sample_t> samples;
+
+        m_index.clear();
+        while(read_box(pos,m_size,&size,&type,&head_len))
+        {
+            if(type == FMP4_BOX_MOOF
+                    && parse_moof(pos,pos + size,samples))
+            {
+                for(auto& s : samples)
+                {
+                    if(s.video)
+                    {
+                        if(s.key)
+                        {
+                            fmp4_index_entry entry;
+                            entry.time = s.time;
+                            entry.reserved = 0;
+                            entry.offset = pos;
+                            m_index.push_back(entry);
+                        }
+                        break;
+                    }
+                }
+            }
+
+            pos += size;
+        }
+    }
+
+    void fmp4_reader::calc_duration()
+    {
+        //only the fragments after the last seek point need parsing
+        uint64_t pos = m_index.empty() ? m_first_moof : m_index.back().offset;
+        uint64_t size;
+        uint32_t type;
+        uint32_t head_len;
+        std::vector<sample_t> samples;
+
+        m_duration = m_index.empty() ? 0 : m_index.back().time;
+        while(read_box(pos,m_size,&size,&type,&head_len))
+        {
+            if(type == FMP4_BOX_MOOF
+                    && parse_moof(pos,pos + size,samples)
+                    && !samples.empty()
+                    && samples.back().time > m_duration)
+            {
+                m_duration = samples.back().time;
+            }
+
+            pos += size;
+        }
+    }
+
+    bool fmp4_reader::seek(uint32_t time,uint32_t* key_time)
+    {
+        if(m_fd < 0)
+        {
+            return false;
+        }
+
+        m_samples.clear();
+        m_sample_pos = 0;
+
+        if(m_index.empty())
+        {
+            m_next_pos = m_first_moof;
+            *key_time = 0;
+            return true;
+        }
+
+        auto it = std::upper_bound(m_index.begin(),m_index.end(),time,[](uint32_t t,const fmp4_index_entry& e)
+        {
+            return t < e.time;
+        });
+        if(it != m_index.begin())
+        {
+            it--;
+        }
+
+        m_next_pos = it->offset;
+        *key_time = it->time;
+        return true;
+    }
+
+    bool fmp4_reader::next_sample(sample_t& s)
+    {
+        while(m_sample_pos >= m_samples.size())
+        {
+            if(!load_fragment())
+            {
+                return false;
+            }
+        }
+
+        s = m_samples[m_sample_pos++];
+        return true;
+    }
+
+}}//namespace
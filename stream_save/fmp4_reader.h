@@ -0,0 +1,94 @@
+#ifndef fmp4_reader_include_h
+#define fmp4_reader_include_h
+
+#include <util/stream_type.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "fmp4_index.h"
+
+namespace ceanic{namespace stream_save{
+
+    //reads back the fragmented mp4 written by fmp4_writer.
+    //the file is mmapped,samples point into the mapping and are only paged in when touched
+    class fmp4_reader
+    {
+        public:
+            typedef struct
+            {
+                bool video;
+                bool key;
+                uint32_t time;          //ms,media time
+                const uint8_t* data;    //video: 4 bytes length prefixed nalus,audio: raw frame
+                uint32_t len;
+            }sample_t;
+
+        public:
+            fmp4_reader();
+            virtual ~fmp4_reader();
+
+        public:
+            bool open(const char* file);
+            void close();
+            bool is_open();
+
+            ceanic::util::media_head get_media_head();
+
+            //ms
+            uint32_t duration();
+            //us,wall clock of media time 0,0 if unknown
+            uint64_t start_time();
+
+            //vps/sps/pps,4 bytes length prefixed as the video samples
+            const std::vector<uint8_t>& param_sets();
+
+            //move to the last key frame at or before time(ms),key_time returns its media time
+            bool seek(uint32_t time,uint32_t* key_time);
+
+            //next sample in time order,false at the end of file
+            bool next_sample(sample_t& s);
+
+        private:
+            typedef struct
+            {
+                uint32_t id;
+                uint32_t timescale;
+            }track_t;
+
+            bool read_box(uint64_t pos,uint64_t end,uint64_t* size,uint32_t* type,uint32_t* head_len);
+            bool parse_moov(uint64_t pos,uint64_t end);
+            bool parse_trak(uint64_t pos,uint64_t end);
+            bool parse_stsd(uint64_t pos,uint64_t end,bool video);
+            bool parse_moof(uint64_t pos,uint64_t end,std::vector<sample_t>& samples);
+            bool parse_traf(uint64_t moof,uint64_t pos,uint64_t end,std::vector<sample_t>& samples);
+            bool load_fragment();
+
+            bool load_index(const char* file);
+            bool load_sidecar_index(const char* file);
+            void build_index();
+            void calc_duration();
+
+        private:
+            int m_fd;
+            uint8_t* m_map;
+            uint64_t m_size;
+
+            ceanic::util::media_head m_mh;
+            track_t m_video;
+            track_t m_audio;
+            std::vector<uint8_t> m_param_sets;
+
+            uint64_t m_first_moof;
+            uint64_t m_start_time;
+            uint32_t m_duration;
+            std::vector<fmp4_index_entry> m_index;
+
+            //current fragment
+            std::vector<sample_t> m_samples;
+            size_t m_sample_pos;
+            uint64_t m_next_pos;
+    };
+
+}}//namespace
+
+#endif
@@ -0,0 +1,341 @@
+#include "fmp4_save.h"
+
+namespace ceanic{namespace stream_save{
+
+    fmp4_save_param fmp4_save::default_param()
+    {
+        fmp4_save_param param;
+        param.queue_size = 4 * 1024 * 1024;
+        param.fragment_time = 1000;
+        param.fragment_size = 2 * 1024 * 1024;
+        param.sync_interval = 5000;
+        param.stat_interval = 60;
+        return param;
+    }
+
+    fmp4_save::fmp4_save(ceanic::util::media_head mh,const char* file_path,const fmp4_save_param* param)
+        :m_bopen(false),m_mh(mh),m_file_path(file_path)
+         ,m_param(param ? *param : default_param()),m_queue(m_param.queue_size),m_writer(mh,m_param.fragment_time,m_param.fragment_size)
+         ,m_sync_ms(0),m_slot(-1),m_rotated_bytes(0),m_stat_ms(0),m_stat_bytes(0),m_stat_frames(0),m_max_latency(0)
+    {
+    }
+
+    fmp4_save::fmp4_save(ceanic::util::media_head mh,std::shared_ptr<segment_pool> pool,const fmp4_save_param* param)
+        :m_bopen(false),m_mh(mh)
+         ,m_param(param ? *param : default_param()),m_queue(m_param.queue_size),m_writer(mh,m_param.fragment_time,m_param.fragment_size)
+         ,m_sync_ms(0),m_pool(pool),m_slot(-1),m_rotated_bytes(0),m_stat_ms(0),m_stat_bytes(0),m_stat_frames(0),m_max_latency(0)
+    {
+    }
+
+    fmp4_save::~fmp4_save()
+    {
+        assert(!m_bopen);
+    }
+
+    bool fmp4_save::open()
+    {
+        std::unique_lock<std::mutex> lock(m_interface_mu);
+
+        if(m_bopen)
+        {
+            return false;
+        }
+
+        m_rotated_bytes = 0;
+        if(m_pool)
+        {
+            if((!m_pool->is_open() && !m_pool->open())
+                    || !open_segment())
+            {
+                return false;
+            }
+        }
+        else if(!m_writer.open(m_file_path.c_str()))
+        {
+            return false;
+        }
+
+        m_sync_ms = frame_queue::now_ms();
+        m_stat_ms = frame_queue::now_ms();
+        m_stat_bytes = 0;
+        m_stat_frames = 0;
+        m_max_latency = 0;
+
+        m_bopen = true;
+        m_process_thread = std::thread(&fmp4_save::on_process,this);
+
+        return true;
+    }
+
+    bool fmp4_save::open_segment()
+    {
+        m_slot = m_pool->acquire(m_mh.video_info.vcode,m_mh.audio_info.acode,m_file_path);
+        if(m_slot < 0)
+        {
+            printf("[%s]:no segment available\n",__FUNCTION__);
+            return false;
+        }
+
+        if(!m_writer.open(m_file_path.c_str(),this))
+        {
+            m_pool->release(m_slot);
+            m_slot = -1;
+            return false;
+        }
+
+        return true;
+    }
+
+    void fmp4_save::close_segment()
+    {
+        if(m_slot < 0)
+        {
+            return;
+        }
+
+        //close flushes the last fragment,which still reports to the slot
+        m_writer.close();
+        m_rotated_bytes += m_writer.bytes();
+        m_pool->release(m_slot);
+        m_slot = -1;
+    }
+
+    bool fmp4_save::need_rotate(save_frame_ptr& frame)
+    {
+        uint64_t used = m_writer.bytes();
+        uint64_t limit = m_pool->segment_size();
+
+        //switch on a key frame while the fragment being built still fits,
+        //any frame that could overflow the file forces a switch and the new segment waits for a key frame
+        if(frame->key)
+        {
+            return used + 2ULL * m_param.fragment_size >= limit;
+        }
+
+        return used + m_param.fragment_size + frame->len() >= limit;
+    }
+
+    uint64_t fmp4_save::written_bytes()
+    {
+        //the writer keeps its count until reopened,a closed segment is already in m_rotated_bytes
+        if(m_pool && m_slot < 0)
+        {
+            return m_rotated_bytes;
+        }
+
+        return m_rotated_bytes + m_writer.bytes();
+    }
+
+    void fmp4_save::on_index_start(uint64_t start_time)
+    {
+        m_pool->set_start_time(m_slot,start_time);
+    }
+
+    void fmp4_save::on_index_entry(const fmp4_index_entry& entry)
+    {
+        m_pool->add_key(m_slot,entry);
+    }
+
+    void fmp4_save::on_index_update(uint64_t bytes,uint32_t end_time)
+    {
+        m_pool->update(m_slot,bytes,end_time);
+    }
+
+    void fmp4_save::write_frame(save_frame_ptr& frame)
+    {
+        if(m_pool
+                && frame->type == 0
+                && (m_slot < 0 || need_rotate(frame)))
+        {
+            close_segment();
+            open_segment();
+        }
+
+        if(frame->type == 0)
+        {
+            m_writer.write_video((const uint8_t*)frame->data(),frame->len(),frame->pts,frame->key);
+        }
+        else
+        {
+            m_writer.write_audio((const uint8_t*)frame->data(),frame->len(),frame->pts);
+        }
+
+        int64_t latency = frame_queue::now_ms() - frame->in_ms;
+        if(latency > m_max_latency)
+        {
+            m_max_latency = latency;
+        }
+        m_stat_frames++;
+
+        m_queue.release(frame);
+    }
+
+    void fmp4_save::sync_file()
+    {
+        if(m_param.sync_interval == 0)
+        {
+            return;
+        }
+
+        int64_t now = frame_queue::now_ms();
+        if(now - m_sync_ms < (int64_t)m_param.sync_interval)
+        {
+            return;
+        }
+
+        m_writer.sync();
+        if(m_pool)
+        {
+            m_pool->sync();
+        }
+        m_sync_ms = now;
+    }
+
+    void fmp4_save::report_stat(bool force)
+    {
+        int64_t now = frame_queue::now_ms();
+        int64_t elapse = now - m_stat_ms;
+
+        if(!force
+                && (m_param.stat_interval == 0 || elapse < (int64_t)m_param.stat_interval * 1000))
+        {
+            return;
+        }
+
+        if(elapse > 0)
+        {
+            printf("[%s]:%s,write %.1f KB/s,frames:%u,max latency:%lld ms,queue peak:%u KB,drop:%u,fragments:%u,total:%llu KB\n",
+                    __FUNCTION__,
+                    m_file_path.c_str(),
+                    (written_bytes() - m_stat_bytes) * 1000.0 / 1024 / elapse,
+                    m_stat_frames,
+                    (long long)m_max_latency,
+                    m_queue.peak_bytes() / 1024,
+                    m_queue.drop_count(),
+                    m_writer.fragments(),
+                    (unsigned long long)written_bytes() / 1024);
+        }
+
+        m_stat_ms = now;
+        m_stat_bytes = written_bytes();
+        m_stat_frames = 0;
+        m_max_latency = 0;
+    }
+
+    void fmp4_save::on_process()
+    {
+        save_frame_ptr frame;
+
+        while(m_bopen)
+        {
+            frame = m_queue.pop(100);
+            if(frame)
+            {
+                write_frame(frame);
+            }
+
+            sync_file();
+            report_stat(false);
+        }
+
+        while((frame = m_queue.pop(0)) != nullptr)
+        {
+            write_frame(frame);
+        }
+    }
+
+    void fmp4_save::close()
+    {
+        std::unique_lock<std::mutex> lock(m_interface_mu);
+
+        if(!m_bopen)
+        {
+            return ;
+        }
+
+        m_bopen = false;
+        m_queue.wakeup();
+        m_process_thread.join();
+
+        if(m_pool)
+        {
+            close_segment();
+        }
+        else
+        {
+            m_writer.close();
+        }
+        report_stat(true);
+        m_queue.clear();
+    }
+
+    bool fmp4_save::is_open()
+    {
+        std::unique_lock<std::mutex> lock(m_interface_mu);
+
+        return m_bopen;
+    }
+
+    bool fmp4_save::input_data(ceanic::util::stream_head* head,const char* buf,int32_t len)
+    {
+        if(IS_AUDIO_FRAME(head->type)
+                && m_mh.audio_info.acode == ceanic::util::STREAM_AUDIO_ENCODE_NONE)
+        {
+            return false;
+        }
+
+        if(!is_open())
+        {
+            return false;
+        }
+
+        save_frame_ptr frame = m_queue.make_frame(m_mh.video_info.vcode,head,buf,len);
+        if(!frame)
+        {
+            return IS_VIDEO_FRAME(head->type) ? false : true;
+        }
+
+        return input_frame(frame);
+    }
+
+    bool fmp4_save::input_stream_frame(ceanic::util::stream_frame_ptr sframe)
+    {
+        if(!is_open())
+        {
+            return false;
+        }
+
+        save_frame_ptr frame = m_queue.make_frame(m_mh.video_info.vcode,sframe);
+        if(!frame)
+        {
+            return false;
+        }
+
+        return input_frame(frame);
+    }
+
+    bool fmp4_save::input_frame(save_frame_ptr frame)
+    {
+        std::unique_lock<std::mutex> lock(m_interface_mu);
+
+        if(!m_bopen)
+        {
+            return false;
+        }
+
+        if(frame->type == 1
+                && m_mh.audio_info.acode == ceanic::util::STREAM_AUDIO_ENCODE_NONE)
+        {
+            return false;
+        }
+
+        if(!m_queue.push(frame))
+        {
+            m_queue.release(frame);
+            return false;
+        }
+
+        return true;
+    }
+
+}}//namespace
@@ -0,0 +1,90 @@
+#ifndef fmp4_save_include_h
+#define fmp4_save_include_h
+
+#include <util/std.h>
+#include <string>
+#include <mutex>
+#include <thread>
+#include "stream_save.h"
+#include "frame_queue.h"
+#include "fmp4_writer.h"
+#include "segment_pool.h"
+
+namespace ceanic{namespace stream_save{
+
+    typedef struct
+    {
+        uint32_t queue_size;    //bytes,frames waiting to be written
+        uint32_t fragment_time; //ms,a fragment is closed on the first key frame after this,0:every GOP
+        uint32_t fragment_size; //bytes,a fragment is closed once its payload reaches this
+        uint32_t sync_interval; //ms,fdatasync interval,0:disable
+        uint32_t stat_interval; //s,throughput/latency report interval,0:disable
+    }fmp4_save_param;
+
+    //fragmented mp4 saver,same queue/thread model as mp4_save but without the vendor muxer.
+    //a power cut only loses the fragment being built.
+    //with a segment_pool the recording goes round the pool's preallocated files instead of one growing file
+    class fmp4_save
+        :public stream_save
+        ,public fmp4_index_sink
+    {
+        public:
+            fmp4_save(ceanic::util::media_head mh,const char* file_path,const fmp4_save_param* param = NULL);
+            fmp4_save(ceanic::util::media_head mh,std::shared_ptr<segment_pool> pool,const fmp4_save_param* param = NULL);
+            virtual ~fmp4_save();
+
+        public:
+            bool open() override;
+            void close() override;
+            bool is_open() override;
+            bool input_data(ceanic::util::stream_head* head,const char* buf,int32_t len) override;
+            bool input_stream_frame(ceanic::util::stream_frame_ptr frame) override;
+
+            //queue a frame that is already built,the frame may be shared with other savers
+            bool input_frame(save_frame_ptr frame);
+
+            static fmp4_save_param default_param();
+
+            //fmp4_index_sink,segment index updates in pool mode
+            void on_index_start(uint64_t start_time) override;
+            void on_index_entry(const fmp4_index_entry& entry) override;
+            void on_index_update(uint64_t bytes,uint32_t end_time) override;
+
+        private:
+            bool open_segment();
+            void close_segment();
+            bool need_rotate(save_frame_ptr& frame);
+            uint64_t written_bytes();
+            void write_frame(save_frame_ptr& frame);
+            void sync_file();
+            void report_stat(bool force);
+            void on_process();
+
+        private:
+            bool m_bopen;
+            ceanic::util::media_head m_mh;
+            std::string m_file_path;
+
+            std::mutex m_interface_mu;
+            std::thread m_process_thread;
+
+            fmp4_save_param m_param;
+            frame_queue m_queue;
+            fmp4_writer m_writer;
+            int64_t m_sync_ms;
+
+            //pool mode,m_file_path is the segment being written
+            std::shared_ptr<segment_pool> m_pool;
+            int32_t m_slot;
+            uint64_t m_rotated_bytes;//bytes of the segments already closed
+
+            //stat,only touched by the process thread
+            int64_t m_stat_ms;
+            uint64_t m_stat_bytes;//writer bytes at the last report
+            uint32_t m_stat_frames;
+            int64_t m_max_latency;
+    };
+
+}}//namespace
+
+#endif
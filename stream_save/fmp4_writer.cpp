@@ -0,0 +1,967 @@
+#include "fmp4_writer.h"
+#include <util/std.h>
+#include <sys/uio.h>
+
+namespace ceanic{namespace stream_save{
+
+#define FMP4_VIDEO_TRACK_ID 1
+#define FMP4_AUDIO_TRACK_ID 2
+#define FMP4_VIDEO_TIMESCALE 90000
+
+//sample_depends_on=2(I),or sample_depends_on=1 + sample_is_non_sync_sample
+#define FMP4_SAMPLE_SYNC 0x02000000
+#define FMP4_SAMPLE_NON_SYNC 0x01010000
+
+    static void put_u8(std::vector<uint8_t>& b,uint8_t v)
+    {
+        b.push_back(v);
+    }
+
+    static void put_u16(std::vector<uint8_t>& b,uint16_t v)
+    {
+        b.push_back(v >> 8);
+        b.push_back(v & 0xff);
+    }
+
+    static void put_u24(std::vector<uint8_t>& b,uint32_t v)
+    {
+        b.push_back((v >> 16) & 0xff);
+        b.push_back((v >> 8) & 0xff);
+        b.push_back(v & 0xff);
+    }
+
+    static void put_u32(std::vector<uint8_t>& b,uint32_t v)
+    {
+        b.push_back(v >> 24);
+        b.push_back((v >> 16) & 0xff);
+        b.push_back((v >> 8) & 0xff);
+        b.push_back(v & 0xff);
+    }
+
+    static void put_u64(std::vector<uint8_t>& b,uint64_t v)
+    {
+        put_u32(b,v >> 32);
+        put_u32(b,v & 0xffffffff);
+    }
+
+    static void put_tag(std::vector<uint8_t>& b,const char* tag)
+    {
+        b.insert(b.end(),tag,tag + 4);
+    }
+
+    static void put_zero(std::vector<uint8_t>& b,size_t n)
+    {
+        b.insert(b.end(),n,0);
+    }
+
+    static void set_u32(std::vector<uint8_t>& b,size_t pos,uint32_t v)
+    {
+        b[pos] = v >> 24;
+        b[pos + 1] = (v >> 16) & 0xff;
+        b[pos + 2] = (v >> 8) & 0xff;
+        b[pos + 3] = v & 0xff;
+    }
+
+    static size_t box_begin(std::vector<uint8_t>& b,const char* tag)
+    {
+        size_t pos = b.size();
+        put_u32(b,0);
+        put_tag(b,tag);
+        return pos;
+    }
+
+    static size_t full_box_begin(std::vector<uint8_t>& b,const char* tag,uint8_t version,uint32_t flags)
+    {
+        size_t pos = box_begin(b,tag);
+        put_u8(b,version);
+        put_u24(b,flags);
+        return pos;
+    }
+
+    static void box_end(std::vector<uint8_t>& b,size_t pos)
+    {
+        set_u32(b,pos,b.size() - pos);
+    }
+
+    static void put_matrix(std::vector<uint8_t>& b)
+    {
+        static const uint32_t matrix[9] = {0x00010000,0,0,0,0x00010000,0,0,0,0x40000000};
+        for(int i = 0; i < 9; i++)
+        {
+            put_u32(b,matrix[i]);
+        }
+    }
+
+    //find next start code(00 00 01 or 00 00 00 01) from pos,return its offset or len
+    static int32_t find_start_code(const uint8_t* data,int32_t len,int32_t pos,int32_t* sc_len)
+    {
+        for(int32_t i = pos; i + 3 <= len; i++)
+        {
+            if(data[i] == 0 && data[i + 1] == 0)
+            {
+                if(data[i + 2] == 1)
+                {
+                    *sc_len = 3;
+                    return i;
+                }
+
+                if(i + 4 <= len && data[i + 2] == 0 && data[i + 3] == 1)
+                {
+                    *sc_len = 4;
+                    return i;
+                }
+            }
+        }
+
+        *sc_len = 0;
+        return len;
+    }
+
+    //call fn(nalu,nalu_len) for every nalu of an annex-b buffer
+    template<typename FN>
+    static void for_each_nalu(const uint8_t* data,int32_t len,FN fn)
+    {
+        int32_t sc_len = 0;
+        int32_t pos = find_start_code(data,len,0,&sc_len);
+        while(pos < len)
+        {
+            int32_t beg = pos + sc_len;
+            int32_t next_sc_len = 0;
+            int32_t next = find_start_code(data,len,beg,&next_sc_len);
+            if(next > beg)
+            {
+                fn(data + beg,next - beg);
+            }
+
+            pos = next;
+            sc_len = next_sc_len;
+        }
+    }
+
+    static bool is_param_set(uint8_t vcode,const uint8_t* nalu)
+    {
+        if(vcode == ceanic::util::STREAM_VIDEO_ENCODE_H264)
+        {
+            int type = nalu[0] & 0x1f;
+            return type == 7 || type == 8 || type == 9;//sps,pps,aud
+        }
+
+        int type = (nalu[0] >> 1) & 0x3f;
+        return type == 32 || type == 33 || type == 34 || type == 35;//vps,sps,pps,aud
+    }
+
+    fmp4_writer::fmp4_writer(ceanic::util::media_head mh,uint32_t fragment_time,uint32_t fragment_size)
+        :m_mh(mh),m_fragment_time(fragment_time),m_fragment_size(fragment_size),m_fd(-1),m_index_fd(-1),m_sink(NULL)
+         ,m_has_audio(mh.audio_info.acode != ceanic::util::STREAM_AUDIO_ENCODE_NONE),m_audio_timescale(mh.audio_info.sample_rate)
+         ,m_init_written(false),m_video_start_pts(0),m_last_video_dts(0),m_frag_start_dts(0),m_audio_next_dts(0),m_audio_started(false)
+         ,m_sequence(0),m_bytes(0)
+    {
+        if(m_audio_timescale == 0)
+        {
+            m_has_audio = false;
+        }
+
+        if(m_mh.video_info.fr == 0)
+        {
+            m_mh.video_info.fr = 25;
+        }
+    }
+
+    fmp4_writer::~fmp4_writer()
+    {
+        close();
+    }
+
+    bool fmp4_writer::open(const char* file,fmp4_index_sink* sink)
+    {
+        if(m_fd >= 0)
+        {
+            return false;
+        }
+
+        m_fd = ::open(file,sink ? O_WRONLY : O_WRONLY | O_CREAT | O_TRUNC,0644);
+        if(m_fd < 0)
+        {
+            printf("[%s]:open %s failed,errno:%d\n",__FUNCTION__,file,errno);
+            return false;
+        }
+
+        m_sink = sink;
+        if(!m_sink)
+        {
+            //the index is only a seek aid,recording goes on without it
+            m_index_file = std::string(file) + FMP4_INDEX_SUFFIX;
+            m_index_fd = ::open(m_index_file.c_str(),O_WRONLY | O_CREAT | O_TRUNC,0644);
+            if(m_index_fd < 0)
+            {
+                printf("[%s]:open %s failed,errno:%d\n",__FUNCTION__,m_index_file.c_str(),errno);
+            }
+        }
+
+        m_init_written = false;
+        m_audio_started = false;
+        m_sequence = 0;
+        m_bytes = 0;
+        m_video.samples.clear();
+        m_video.payload.clear();
+        m_audio.samples.clear();
+        m_audio.payload.clear();
+        return true;
+    }
+
+    void fmp4_writer::close()
+    {
+        if(m_fd < 0)
+        {
+            return;
+        }
+
+        //no next frame,the last sample gets the nominal duration
+        flush_fragment(0);
+
+        ::close(m_fd);
+        m_fd = -1;
+
+        if(m_index_fd >= 0)
+        {
+            ::close(m_index_fd);
+            m_index_fd = -1;
+        }
+
+        m_sink = NULL;
+    }
+
+    bool fmp4_writer::is_open()
+    {
+        return m_fd >= 0;
+    }
+
+    void fmp4_writer::sync()
+    {
+        if(m_fd >= 0)
+        {
+            fdatasync(m_fd);
+        }
+
+        if(m_index_fd >= 0)
+        {
+            fdatasync(m_index_fd);
+        }
+    }
+
+    uint64_t fmp4_writer::bytes()
+    {
+        return m_bytes;
+    }
+
+    uint32_t fmp4_writer::fragments()
+    {
+        return m_sequence;
+    }
+
+    bool fmp4_writer::write_buf(const uint8_t* data,size_t len)
+    {
+        while(len > 0)
+        {
+            ssize_t ret = ::write(m_fd,data,len);
+            if(ret < 0)
+            {
+                if(errno == EINTR)
+                {
+                    continue;
+                }
+
+                printf("[%s]:write failed,errno:%d\n",__FUNCTION__,errno);
+                return false;
+            }
+
+            data += ret;
+            len -= ret;
+            m_bytes += ret;
+        }
+
+        return true;
+    }
+
+    void fmp4_writer::write_index(uint32_t time,uint64_t offset)
+    {
+        fmp4_index_entry entry;
+        entry.time = time;
+        entry.reserved = 0;
+        entry.offset = offset;
+
+        if(m_sink)
+        {
+            m_sink->on_index_entry(entry);
+            return;
+        }
+
+        if(m_index_fd < 0)
+        {
+            return;
+        }
+
+        if(::write(m_index_fd,&entry,sizeof(entry)) != sizeof(entry))
+        {
+            printf("[%s]:write %s failed,errno:%d,index disabled\n",__FUNCTION__,m_index_file.c_str(),errno);
+            ::close(m_index_fd);
+            m_index_fd = -1;
+        }
+    }
+
+    void fmp4_writer::write_end_mark()
+    {
+        //a reused container still holds the fragments of its previous recording after our data.
+        //a box running to the end of file hides them from readers,the next fragment overwrites it
+        static const uint8_t mark[8] = {0,0,0,0,'f','r','e','e'};
+        if(pwrite(m_fd,mark,sizeof(mark),m_bytes) != sizeof(mark))
+        {
+            printf("[%s]:pwrite failed,errno:%d\n",__FUNCTION__,errno);
+        }
+    }
+
+    bool fmp4_writer::parse_param_sets(const uint8_t* data,int32_t len)
+    {
+        uint8_t vcode = m_mh.video_info.vcode;
+        for_each_nalu(data,len,[&](const uint8_t* nalu,int32_t nalu_len)
+        {
+            if(vcode == ceanic::util::STREAM_VIDEO_ENCODE_H264)
+            {
+                int type = nalu[0] & 0x1f;
+                if(type == 7)
+                {
+                    m_sps.assign(nalu,nalu + nalu_len);
+                }
+                else if(type == 8)
+                {
+                    m_pps.assign(nalu,nalu + nalu_len);
+                }
+            }
+            else
+            {
+                int type = (nalu[0] >> 1) & 0x3f;
+                if(type == 32)
+                {
+                    m_vps.assign(nalu,nalu + nalu_len);
+                }
+                else if(type == 33)
+                {
+                    m_sps.assign(nalu,nalu + nalu_len);
+                }
+                else if(type == 34)
+                {
+                    m_pps.assign(nalu,nalu + nalu_len);
+                }
+            }
+        });
+
+        if(vcode == ceanic::util::STREAM_VIDEO_ENCODE_H264)
+        {
+            return m_sps.size() >= 4 && !m_pps.empty();
+        }
+
+        return !m_vps.empty() && m_sps.size() >= 3 && !m_pps.empty();
+    }
+
+    void fmp4_writer::put_video_entry(std::vector<uint8_t>& b)
+    {
+        bool h264 = (m_mh.video_info.vcode == ceanic::util::STREAM_VIDEO_ENCODE_H264);
+
+        size_t entry = box_begin(b,h264 ? "avc1" : "hvc1");
+        put_zero(b,6);
+        put_u16(b,1);//data_reference_index
+        put_zero(b,16);//pre_defined,reserved
+        put_u16(b,m_mh.video_info.w);
+        put_u16(b,m_mh.video_info.h);
+        put_u32(b,0x00480000);//72 dpi
+        put_u32(b,0x00480000);
+        put_u32(b,0);
+        put_u16(b,1);//frame_count
+        put_zero(b,32);//compressorname
+        put_u16(b,0x0018);
+        put_u16(b,0xffff);
+
+        if(h264)
+        {
+            size_t avcc = box_begin(b,"avcC");
+            put_u8(b,1);
+            put_u8(b,m_sps[1]);//profile
+            put_u8(b,m_sps[2]);//compatibility
+            put_u8(b,m_sps[3]);//level
+            put_u8(b,0xff);//4 bytes nalu length
+            put_u8(b,0xe1);//1 sps
+            put_u16(b,m_sps.size());
+            b.insert(b.end(),m_sps.begin(),m_sps.end());
+            put_u8(b,1);//1 pps
+            put_u16(b,m_pps.size());
+            b.insert(b.end(),m_pps.begin(),m_pps.end());
+            box_end(b,avcc);
+        }
+        else
+        {
+            //profile_tier_level from sps rbsp: 2 bytes nalu header,1 byte ids,then 12 bytes ptl
+            std::vector<uint8_t> rbsp;
+            for(size_t i = 0; i < m_sps.size(); i++)
+            {
+                if(i >= 2 && m_sps[i] == 3 && m_sps[i - 1] == 0 && m_sps[i - 2] == 0)
+                {
+                    continue;
+                }
+                rbsp.push_back(m_sps[i]);
+            }
+            rbsp.resize(15 > rbsp.size() ? 15 : rbsp.size(),0);
+            uint8_t max_sub_layers = ((rbsp[2] >> 1) & 0x07) + 1;
+            uint8_t nesting = rbsp[2] & 0x01;
+
+            size_t hvcc = box_begin(b,"hvcC");
+            put_u8(b,1);
+            b.insert(b.end(),rbsp.begin() + 3,rbsp.begin() + 15);//profile,compatibility,constraint,level
+            put_u16(b,0xf000);//min_spatial_segmentation_idc
+            put_u8(b,0xfc);//parallelismType
+            put_u8(b,0xfd);//chroma 4:2:0,the encoder only outputs 8bit 4:2:0
+            put_u8(b,0xf8);//luma 8bit
+            put_u8(b,0xf8);//chroma 8bit
+            put_u16(b,0);//avgFrameRate
+            put_u8(b,(max_sub_layers << 3) | (nesting << 2) | 0x03);
+            put_u8(b,3);//vps,sps,pps arrays
+
+            const std::vector<uint8_t>* sets[3] = {&m_vps,&m_sps,&m_pps};
+            const uint8_t types[3] = {32,33,34};
+            for(int i = 0; i < 3; i++)
+            {
+                put_u8(b,0x80 | types[i]);
+                put_u16(b,1);
+                put_u16(b,sets[i]->size());
+                b.insert(b.end(),sets[i]->begin(),sets[i]->end());
+            }
+            box_end(b,hvcc);
+        }
+
+        box_end(b,entry);
+    }
+
+    void fmp4_writer::put_audio_entry(std::vector<uint8_t>& b)
+    {
+        bool aac = (m_mh.audio_info.acode == ceanic::util::STREAM_AUDIO_ENCODE_AAC);
+        uint16_t chn = m_mh.audio_info.chn ? m_mh.audio_info.chn : 1;
+
+        size_t entry = box_begin(b,aac ? "mp4a" : "ulaw");
+        put_zero(b,6);
+        put_u16(b,1);//data_reference_index
+        put_zero(b,8);
+        put_u16(b,chn);
+        put_u16(b,16);
+        put_zero(b,4);
+        put_u32(b,m_audio_timescale << 16);
+
+        if(aac)
+        {
+            static const uint32_t rates[] = {96000,88200,64000,48000,44100,32000,24000,22050,16000,12000,11025,8000,7350};
+            uint8_t idx = 4;
+            for(uint8_t i = 0; i < sizeof(rates) / sizeof(rates[0]); i++)
+            {
+                if(rates[i] == m_audio_timescale)
+                {
+                    idx = i;
+                    break;
+                }
+            }
+            uint16_t asc = (2 << 11) | (idx << 7) | (chn << 3);//aac lc
+
+            size_t esds = full_box_begin(b,"esds",0,0);
+            put_u8(b,0x03);//ES_Descriptor
+            put_u8(b,25);
+            put_u16(b,FMP4_AUDIO_TRACK_ID);
+            put_u8(b,0);
+            put_u8(b,0x04);//DecoderConfigDescriptor
+            put_u8(b,17);
+            put_u8(b,0x40);//aac
+            put_u8(b,0x15);//audio stream
+            put_u24(b,0);
+            put_u32(b,0);
+            put_u32(b,0);
+            put_u8(b,0x05);//DecoderSpecificInfo
+            put_u8(b,2);
+            put_u16(b,asc);
+            put_u8(b,0x06);//SLConfigDescriptor
+            put_u8(b,1);
+            put_u8(b,0x02);
+            box_end(b,esds);
+        }
+
+        box_end(b,entry);
+    }
+
+    void fmp4_writer::put_trak(std::vector<uint8_t>& b,bool video)
+    {
+        size_t trak = box_begin(b,"trak");
+
+        size_t tkhd = full_box_begin(b,"tkhd",0,0x03);//enabled,in movie
+        put_u32(b,0);
+        put_u32(b,0);
+        put_u32(b,video ? FMP4_VIDEO_TRACK_ID : FMP4_AUDIO_TRACK_ID);
+        put_u32(b,0);
+        put_u32(b,0);//duration,unknown
+        put_zero(b,8);
+        put_u16(b,0);//layer
+        put_u16(b,video ? 0 : 1);//alternate_group
+        put_u16(b,video ? 0 : 0x0100);//volume
+        put_u16(b,0);
+        put_matrix(b);
+        put_u32(b,video ? (uint32_t)m_mh.video_info.w << 16 : 0);
+        put_u32(b,video ? (uint32_t)m_mh.video_info.h << 16 : 0);
+        box_end(b,tkhd);
+
+        size_t mdia = box_begin(b,"mdia");
+        size_t mdhd = full_box_begin(b,"mdhd",0,0);
+        put_u32(b,0);
+        put_u32(b,0);
+        put_u32(b,video ? FMP4_VIDEO_TIMESCALE : m_audio_timescale);
+        put_u32(b,0);
+        put_u16(b,0x55c4);//und
+        put_u16(b,0);
+        box_end(b,mdhd);
+
+        size_t hdlr = full_box_begin(b,"hdlr",0,0);
+        put_u32(b,0);
+        put_tag(b,video ? "vide" : "soun");
+        put_zero(b,12);
+        const char* name = video ? "VideoHandler" : "SoundHandler";
+        b.insert(b.end(),name,name + strlen(name) + 1);
+        box_end(b,hdlr);
+
+        size_t minf = box_begin(b,"minf");
+        if(video)
+        {
+            size_t vmhd = full_box_begin(b,"vmhd",0,1);
+            put_zero(b,8);
+            box_end(b,vmhd);
+        }
+        else
+        {
+            size_t smhd = full_box_begin(b,"smhd",0,0);
+            put_zero(b,4);
+            box_end(b,smhd);
+        }
+
+        size_t dinf = box_begin(b,"dinf");
+        size_t dref = full_box_begin(b,"dref",0,0);
+        put_u32(b,1);
+        size_t url = full_box_begin(b,"url ",0,1);//media in the same file
+        box_end(b,url);
+        box_end(b,dref);
+        box_end(b,dinf);
+
+        //samples live in the fragments,the sample tables are empty
+        size_t stbl = box_begin(b,"stbl");
+        size_t stsd = full_box_begin(b,"stsd",0,0);
+        put_u32(b,1);
+        if(video)
+        {
+            put_video_entry(b);
+        }
+        else
+        {
+            put_audio_entry(b);
+        }
+        box_end(b,stsd);
+
+        size_t stts = full_box_begin(b,"stts",0,0);
+        put_u32(b,0);
+        box_end(b,stts);
+        size_t stsc = full_box_begin(b,"stsc",0,0);
+        put_u32(b,0);
+        box_end(b,stsc);
+        size_t stsz = full_box_begin(b,"stsz",0,0);
+        put_u32(b,0);
+        put_u32(b,0);
+        box_end(b,stsz);
+        size_t stco = full_box_begin(b,"stco",0,0);
+        put_u32(b,0);
+        box_end(b,stco);
+        box_end(b,stbl);
+
+        box_end(b,minf);
+        box_end(b,mdia);
+        box_end(b,trak);
+    }
+
+    bool fmp4_writer::write_init()
+    {
+        std::vector<uint8_t> b;
+        b.reserve(1024);
+
+        size_t ftyp = box_begin(b,"ftyp");
+        put_tag(b,"isom");
+        put_u32(b,0x200);
+        put_tag(b,"isom");
+        put_tag(b,"iso6");
+        put_tag(b,"mp41");
+        box_end(b,ftyp);
+
+        size_t moov = box_begin(b,"moov");
+        size_t mvhd = full_box_begin(b,"mvhd",0,0);
+        put_u32(b,0);
+        put_u32(b,0);
+        put_u32(b,1000);
+        put_u32(b,0);
+        put_u32(b,0x00010000);//rate
+        put_u16(b,0x0100);//volume
+        put_zero(b,10);
+        put_matrix(b);
+        put_zero(b,24);
+        put_u32(b,m_has_audio ? FMP4_AUDIO_TRACK_ID + 1 : FMP4_VIDEO_TRACK_ID + 1);
+        box_end(b,mvhd);
+
+        put_trak(b,true);
+        if(m_has_audio)
+        {
+            put_trak(b,false);
+        }
+
+        size_t mvex = box_begin(b,"mvex");
+        for(uint32_t id = FMP4_VIDEO_TRACK_ID; id <= (m_has_audio ? FMP4_AUDIO_TRACK_ID : FMP4_VIDEO_TRACK_ID); id++)
+        {
+            size_t trex = full_box_begin(b,"trex",0,0);
+            put_u32(b,id);
+            put_u32(b,1);
+            put_u32(b,0);
+            put_u32(b,0);
+            put_u32(b,0);
+            box_end(b,trex);
+        }
+        box_end(b,mvex);
+        box_end(b,moov);
+
+        if(!write_buf(b.data(),b.size()))
+        {
+            return false;
+        }
+
+        if(m_sink)
+        {
+            write_end_mark();
+            m_sink->on_index_start(m_video_start_pts);
+        }
+        else if(m_index_fd >= 0)
+        {
+            fmp4_index_head head;
+            head.tag = FMP4_INDEX_TAG;
+            head.version = FMP4_INDEX_VERSION;
+            head.start_time = m_video_start_pts;
+            if(::write(m_index_fd,&head,sizeof(head)) != sizeof(head))
+            {
+                ::close(m_index_fd);
+                m_index_fd = -1;
+            }
+        }
+
+        m_init_written = true;
+        return true;
+    }
+
+    uint64_t fmp4_writer::video_dts(uint64_t pts)
+    {
+        uint64_t dts = pts > m_video_start_pts ? (pts - m_video_start_pts) * 9 / 100 : 0;
+        if(!m_video.samples.empty() || m_sequence > 0)
+        {
+            //keep decode time strictly increasing even if the clock steps back
+            if(dts <= m_last_video_dts)
+            {
+                dts = m_last_video_dts + 1;
+            }
+        }
+
+        return dts;
+    }
+
+    void fmp4_writer::put_traf(std::vector<uint8_t>& b,bool video,std::vector<size_t>& offset_pos)
+    {
+        track_frag_t& t = video ? m_video : m_audio;
+
+        size_t traf = box_begin(b,"traf");
+        size_t tfhd = full_box_begin(b,"tfhd",0,0x020000);//default-base-is-moof
+        put_u32(b,video ? FMP4_VIDEO_TRACK_ID : FMP4_AUDIO_TRACK_ID);
+        box_end(b,tfhd);
+
+        size_t tfdt = full_box_begin(b,"tfdt",1,0);
+        put_u64(b,t.samples[0].dts);
+        box_end(b,tfdt);
+
+        size_t trun = full_box_begin(b,"trun",0,0x000701);//data offset,duration,size,flags
+        put_u32(b,t.samples.size());
+        offset_pos.push_back(b.size());
+        put_u32(b,0);
+        for(auto& s : t.samples)
+        {
+            put_u32(b,s.duration);
+            put_u32(b,s.size);
+            put_u32(b,s.flags);
+        }
+        box_end(b,trun);
+        box_end(b,traf);
+    }
+
+    bool fmp4_writer::flush_fragment(uint64_t next_video_dts)
+    {
+        if(m_video.samples.empty() && m_audio.samples.empty())
+        {
+            return true;
+        }
+
+        size_t n = m_video.samples.size();
+        for(size_t i = 0; i + 1 < n; i++)
+        {
+            m_video.samples[i].duration = m_video.samples[i + 1].dts - m_video.samples[i].dts;
+        }
+        if(n > 0)
+        {
+            if(next_video_dts > m_video.samples[n - 1].dts)
+            {
+                m_video.samples[n - 1].duration = next_video_dts - m_video.samples[n - 1].dts;
+            }
+            else
+            {
+                m_video.samples[n - 1].duration = FMP4_VIDEO_TIMESCALE / m_mh.video_info.fr;
+            }
+        }
+
+        std::vector<uint8_t> moof;
+        std::vector<size_t> offset_pos;
+        moof.reserve(64 + (m_video.samples.size() + m_audio.samples.size()) * 12 + 128);
+
+        size_t moof_pos = box_begin(moof,"moof");
+        size_t mfhd = full_box_begin(moof,"mfhd",0,0);
+        put_u32(moof,++m_sequence);
+        box_end(moof,mfhd);
+        if(!m_video.samples.empty())
+        {
+            put_traf(moof,true,offset_pos);
+        }
+        if(!m_audio.samples.empty())
+        {
+            put_traf(moof,false,offset_pos);
+        }
+        box_end(moof,moof_pos);
+
+        //data offsets are relative to the moof start
+        size_t i = 0;
+        uint32_t offset = moof.size() + 8;
+        if(!m_video.samples.empty())
+        {
+            set_u32(moof,offset_pos[i++],offset);
+            offset += m_video.payload.size();
+        }
+        if(!m_audio.samples.empty())
+        {
+            set_u32(moof,offset_pos[i++],offset);
+        }
+
+        uint8_t mdat[8];
+        uint32_t mdat_size = 8 + m_video.payload.size() + m_audio.payload.size();
+        mdat[0] = mdat_size >> 24;
+        mdat[1] = (mdat_size >> 16) & 0xff;
+        mdat[2] = (mdat_size >> 8) & 0xff;
+        mdat[3] = mdat_size & 0xff;
+        memcpy(mdat + 4,"mdat",4);
+
+        //one syscall for the whole fragment
+        struct iovec iov[4];
+        int iov_cnt = 0;
+        iov[iov_cnt].iov_base = moof.data();
+        iov[iov_cnt++].iov_len = moof.size();
+        iov[iov_cnt].iov_base = mdat;
+        iov[iov_cnt++].iov_len = 8;
+        if(!m_video.payload.empty())
+        {
+            iov[iov_cnt].iov_base = m_video.payload.data();
+            iov[iov_cnt++].iov_len = m_video.payload.size();
+        }
+        if(!m_audio.payload.empty())
+        {
+            iov[iov_cnt].iov_base = m_audio.payload.data();
+            iov[iov_cnt++].iov_len = m_audio.payload.size();
+        }
+
+        uint64_t moof_offset = m_bytes;
+        size_t total = moof.size() + mdat_size;
+        ssize_t ret = writev(m_fd,iov,iov_cnt);
+        bool ok = true;
+        if(ret < 0)
+        {
+            printf("[%s]:writev failed,errno:%d\n",__FUNCTION__,errno);
+            ok = false;
+        }
+        else
+        {
+            m_bytes += ret;
+            if((size_t)ret < total)
+            {
+                //short write,fall back to plain writes for the rest
+                std::vector<uint8_t> rest;
+                rest.reserve(total);
+                for(int j = 0; j < iov_cnt; j++)
+                {
+                    rest.insert(rest.end(),(uint8_t*)iov[j].iov_base,(uint8_t*)iov[j].iov_base + iov[j].iov_len);
+                }
+                ok = write_buf(rest.data() + ret,total - ret);
+            }
+        }
+
+        //only fragments starting with a key frame are seek points,entries follow the data they point to
+        if(ok
+                && !m_video.samples.empty()
+                && m_video.samples[0].flags == FMP4_SAMPLE_SYNC)
+        {
+            write_index(m_video.samples[0].dts / (FMP4_VIDEO_TIMESCALE / 1000),moof_offset);
+        }
+
+        if(ok && m_sink)
+        {
+            uint32_t end_time;
+            if(!m_video.samples.empty())
+            {
+                end_time = (m_video.samples.back().dts + m_video.samples.back().duration) / (FMP4_VIDEO_TIMESCALE / 1000);
+            }
+            else
+            {
+                end_time = (m_audio.samples.back().dts + m_audio.samples.back().duration) * 1000 / m_audio_timescale;
+            }
+
+            write_end_mark();
+            m_sink->on_index_update(m_bytes,end_time);
+        }
+
+        //keep the capacity,the next fragment is about the same size
+        m_video.samples.clear();
+        m_video.payload.clear();
+        m_audio.samples.clear();
+        m_audio.payload.clear();
+        return ok;
+    }
+
+    bool fmp4_writer::write_video(const uint8_t* data,int32_t len,uint64_t pts,bool key)
+    {
+        if(m_fd < 0 || len <= 0)
+        {
+            return false;
+        }
+
+        if(!m_init_written)
+        {
+            //the init segment needs the parameter sets of the first key frame
+            if(!key || !parse_param_sets(data,len))
+            {
+                return false;
+            }
+
+            m_video_start_pts = pts;
+            m_last_video_dts = 0;
+            if(!write_init())
+            {
+                return false;
+            }
+        }
+
+        uint64_t dts = video_dts(pts);
+        if(!m_video.samples.empty())
+        {
+            uint64_t frag_ms = (dts - m_frag_start_dts) / (FMP4_VIDEO_TIMESCALE / 1000);
+            if((key && frag_ms >= m_fragment_time)
+                    || m_video.payload.size() + m_audio.payload.size() >= m_fragment_size)
+            {
+                if(!flush_fragment(dts))
+                {
+                    return false;
+                }
+            }
+        }
+
+        if(m_video.samples.empty())
+        {
+            m_frag_start_dts = dts;
+        }
+
+        //annex-b to 4 bytes length prefix,parameter sets are already in the sample entry
+        uint8_t vcode = m_mh.video_info.vcode;
+        size_t beg = m_video.payload.size();
+        for_each_nalu(data,len,[&](const uint8_t* nalu,int32_t nalu_len)
+        {
+            if(is_param_set(vcode,nalu))
+            {
+                return;
+            }
+
+            put_u32(m_video.payload,nalu_len);
+            m_video.payload.insert(m_video.payload.end(),nalu,nalu + nalu_len);
+        });
+
+        if(m_video.payload.size() == beg)
+        {
+            return false;
+        }
+
+        sample_t s;
+        s.size = m_video.payload.size() - beg;
+        s.duration = 0;
+        s.flags = key ? FMP4_SAMPLE_SYNC : FMP4_SAMPLE_NON_SYNC;
+        s.dts = dts;
+        m_video.samples.push_back(s);
+        m_last_video_dts = dts;
+        return true;
+    }
+
+    bool fmp4_writer::write_audio(const uint8_t* data,int32_t len,uint64_t pts)
+    {
+        if(m_fd < 0 || !m_has_audio || !m_init_written || len <= 0)
+        {
+            return false;
+        }
+
+        uint32_t duration;
+        if(m_mh.audio_info.acode == ceanic::util::STREAM_AUDIO_ENCODE_AAC)
+        {
+            //strip adts header
+            if(len > 7 && data[0] == 0xff && (data[1] & 0xf0) == 0xf0)
+            {
+                int32_t hdr_len = (data[1] & 0x01) ? 7 : 9;
+                data += hdr_len;
+                len -= hdr_len;
+                if(len <= 0)
+                {
+                    return false;
+                }
+            }
+            duration = 1024;
+        }
+        else
+        {
+            duration = len / (m_mh.audio_info.chn ? m_mh.audio_info.chn : 1);
+        }
+
+        //video normally closes fragments,this only bounds memory if video stalls
+        if(m_video.samples.empty()
+                && m_audio.payload.size() >= m_fragment_size
+                && !flush_fragment(0))
+        {
+            return false;
+        }
+
+        if(!m_audio_started)
+        {
+            m_audio_next_dts = pts > m_video_start_pts ? (pts - m_video_start_pts) * m_audio_timescale / 1000000 : 0;
+            m_audio_started = true;
+        }
+
+        sample_t s;
+        s.size = len;
+        s.duration = duration;
+        s.flags = FMP4_SAMPLE_SYNC;
+        s.dts = m_audio_next_dts;
+        m_audio.samples.push_back(s);
+        m_audio.payload.insert(m_audio.payload.end(),data,data + len);
+        m_audio_next_dts += duration;
+        return true;
+    }
+
+}}//namespace
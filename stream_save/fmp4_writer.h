@@ -0,0 +1,101 @@
+#ifndef fmp4_writer_include_h
+#define fmp4_writer_include_h
+
+#include <util/stream_type.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "fmp4_index.h"
+
+namespace ceanic{namespace stream_save{
+
+    //fragmented mp4 (ftyp+moov,then moof+mdat per fragment) muxer,no thread and no SDK dependency.
+    //memory is bounded by one fragment,the file is playable up to the last written fragment.
+    //a key frame index(fmp4_index.h) is written next to the file for seeking
+    class fmp4_writer
+    {
+        public:
+            //fragment_time: ms,a fragment is closed on the first key frame after this
+            //fragment_size: bytes,a fragment is closed at any frame once its payload reaches this
+            fmp4_writer(ceanic::util::media_head mh,uint32_t fragment_time,uint32_t fragment_size);
+            virtual ~fmp4_writer();
+
+        public:
+            //sink: the file is a preallocated container,it is overwritten in place(not truncated)
+            //and the index goes to the sink instead of the sidecar file
+            bool open(const char* file,fmp4_index_sink* sink = NULL);
+            void close();
+            bool is_open();
+
+            //annex-b frame(start code + nalus),pts in us
+            bool write_video(const uint8_t* data,int32_t len,uint64_t pts,bool key);
+            //one aac(raw or adts) or g711u frame,pts in us
+            bool write_audio(const uint8_t* data,int32_t len,uint64_t pts);
+
+            //fdatasync written fragments
+            void sync();
+
+            //payload and box bytes written so far
+            uint64_t bytes();
+            uint32_t fragments();
+
+        private:
+            typedef struct
+            {
+                uint32_t size;
+                uint32_t duration;
+                uint32_t flags;
+                uint64_t dts;
+            }sample_t;
+
+            typedef struct
+            {
+                std::vector<sample_t> samples;
+                std::vector<uint8_t> payload;
+            }track_frag_t;
+
+            bool parse_param_sets(const uint8_t* data,int32_t len);
+            bool write_init();
+            bool flush_fragment(uint64_t next_video_dts);
+            bool write_buf(const uint8_t* data,size_t len);
+            void write_index(uint32_t time,uint64_t offset);
+            void write_end_mark();
+            uint64_t video_dts(uint64_t pts);
+
+            void put_video_entry(std::vector<uint8_t>& b);
+            void put_audio_entry(std::vector<uint8_t>& b);
+            void put_trak(std::vector<uint8_t>& b,bool video);
+            void put_traf(std::vector<uint8_t>& b,bool video,std::vector<size_t>& offset_pos);
+
+        private:
+            ceanic::util::media_head m_mh;
+            uint32_t m_fragment_time;
+            uint32_t m_fragment_size;
+            int m_fd;
+            int m_index_fd;
+            fmp4_index_sink* m_sink;
+            std::string m_index_file;
+
+            bool m_has_audio;
+            uint32_t m_audio_timescale;
+
+            std::vector<uint8_t> m_vps;
+            std::vector<uint8_t> m_sps;
+            std::vector<uint8_t> m_pps;
+            bool m_init_written;
+
+            uint64_t m_video_start_pts;
+            uint64_t m_last_video_dts;
+            uint64_t m_frag_start_dts;
+            uint64_t m_audio_next_dts;
+            bool m_audio_started;
+
+            track_frag_t m_video;
+            track_frag_t m_audio;
+            uint32_t m_sequence;
+            uint64_t m_bytes;
+    };
+
+}}//namespace
+
+#endif
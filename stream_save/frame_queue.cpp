@@ -0,0 +1,291 @@
+#include "frame_queue.h"
+#include <time.h>
+
+namespace ceanic{namespace stream_save{
+
+#define FRAME_QUEUE_MAX_FREE 32
+//queued frames above which shared frames are copied,so a slow writer does not hold encoder memory
+#define FRAME_QUEUE_MAX_REF 4
+
+    frame_queue::frame_queue(uint32_t max_bytes)
+        :m_max_bytes(max_bytes),m_bytes(0),m_peak_bytes(0),m_drop_count(0),m_wait_key(false),m_wakeup(false)
+    {
+    }
+
+    frame_queue::~frame_queue()
+    {
+        clear();
+    }
+
+    int64_t frame_queue::now_ms()
+    {
+        struct timespec spec_now;
+        clock_gettime(CLOCK_MONOTONIC,&spec_now);
+
+        return (int64_t)spec_now.tv_sec * 1000 + (int64_t)spec_now.tv_nsec / 1000000;
+    }
+
+    save_frame_ptr frame_queue::alloc(int32_t len)
+    {
+        save_frame_ptr frame;
+
+        {
+            std::unique_lock<std::mutex> lock(m_free_mu);
+            for(auto it = m_free_frames.begin(); it != m_free_frames.end(); it++)
+            {
+                if((*it)->buf.capacity() >= (size_t)len)
+                {
+                    frame = *it;
+                    m_free_frames.erase(it);
+                    break;
+                }
+            }
+
+            //no frame big enough,grow the oldest one instead of keeping small ones forever
+            if(!frame && !m_free_frames.empty())
+            {
+                frame = m_free_frames.front();
+                m_free_frames.pop_front();
+            }
+        }
+
+        if(!frame)
+        {
+            frame = std::make_shared<save_frame>();
+        }
+
+        frame->type = 0;
+        frame->key = false;
+        frame->pts = 0;
+        frame->in_ms = 0;
+        frame->buf.resize(len);
+        frame->ref = nullptr;
+        frame->ref_data = NULL;
+        frame->ref_len = 0;
+        return frame;
+    }
+
+    static bool is_key(uint8_t vcode,const char* data)
+    {
+        if(vcode == ceanic::util::STREAM_VIDEO_ENCODE_H264)
+        {
+            return ((data[4] & 0x1f) == 0x7);//sps
+        }
+
+        int32_t h265_nalu_type = (data[4] >> 1) & 0x3f;
+        return (h265_nalu_type == 32);//vps
+    }
+
+    save_frame_ptr frame_queue::make_frame(uint8_t vcode,ceanic::util::stream_frame_ptr sframe)
+    {
+        ceanic::util::stream_head* head = sframe->head();
+        if(!IS_VIDEO_FRAME(head->type) || head->nalu.size() == 0)
+        {
+            return make_frame(vcode,head,NULL,0);
+        }
+
+        bool contiguous = true;
+        int32_t frame_len = head->nalu[0].size;
+        for(uint32_t i = 1; i < head->nalu.size(); i++)
+        {
+            if(head->nalu[i - 1].data + head->nalu[i - 1].size != head->nalu[i].data)
+            {
+                contiguous = false;
+                break;
+            }
+            frame_len += head->nalu[i].size;
+        }
+
+        {
+            std::unique_lock<std::mutex> lock(m_mu);
+            if(m_frames.size() >= FRAME_QUEUE_MAX_REF)
+            {
+                contiguous = false;
+            }
+        }
+
+        if(!contiguous || frame_len <= 4)
+        {
+            return make_frame(vcode,head,NULL,0);
+        }
+
+        struct timeval tv;
+        gettimeofday(&tv, NULL);
+
+        save_frame_ptr frame = alloc(0);
+        frame->ref = sframe;
+        frame->ref_data = (const char*)head->nalu[0].data;
+        frame->ref_len = frame_len;
+        frame->type = 0;
+        frame->key = is_key(vcode,frame->ref_data);
+        frame->pts = (uint64_t)tv.tv_sec * 1000000 + (uint64_t)tv.tv_usec;
+        return frame;
+    }
+
+    save_frame_ptr frame_queue::make_frame(uint8_t vcode,ceanic::util::stream_head* head,const char* buf,int32_t len)
+    {
+        struct timeval tv;
+        gettimeofday(&tv, NULL);
+
+        save_frame_ptr frame;
+        if(IS_VIDEO_FRAME(head->type))
+        {
+            int32_t frame_len = 0;
+            for(uint32_t i = 0; i < head->nalu.size(); i++)
+            {
+                frame_len += head->nalu[i].size;
+            }
+
+            if(frame_len <= 4)
+            {
+                return nullptr;
+            }
+
+            //the only copy,nalus go straight from the encoder buffer into the frame
+            frame = alloc(frame_len);
+            char* p = frame->buf.data();
+            for(uint32_t i = 0; i < head->nalu.size(); i++)
+            {
+                memcpy(p,head->nalu[i].data,head->nalu[i].size);
+                p += head->nalu[i].size;
+            }
+
+            frame->type = 0;
+            frame->key = is_key(vcode,frame->buf.data());
+        }
+        else if(IS_AUDIO_FRAME(head->type))
+        {
+            if(len <= 0)
+            {
+                return nullptr;
+            }
+
+            frame = alloc(len);
+            memcpy(frame->buf.data(),buf,len);
+            frame->type = 1;
+            frame->key = false;
+        }
+        else
+        {
+            return nullptr;
+        }
+
+        frame->pts = (uint64_t)tv.tv_sec * 1000000 + (uint64_t)tv.tv_usec;
+        return frame;
+    }
+
+    void frame_queue::release(save_frame_ptr& frame)
+    {
+        if(!frame)
+        {
+            return;
+        }
+
+        std::unique_lock<std::mutex> lock(m_free_mu);
+        if(frame.use_count() == 1)
+        {
+            //drop the encoder frame now,not when the save_frame is reused
+            frame->ref = nullptr;
+        }
+        if(frame.use_count() == 1
+                && m_free_frames.size() < FRAME_QUEUE_MAX_FREE
+                && frame->buf.capacity() <= m_max_bytes)
+        {
+            m_free_frames.push_back(frame);
+        }
+        frame = nullptr;
+    }
+
+    bool frame_queue::push(save_frame_ptr frame)
+    {
+        std::unique_lock<std::mutex> lock(m_mu);
+
+        if(frame->type == 0)
+        {
+            if(m_wait_key && !frame->key)
+            {
+                m_drop_count++;
+                return false;
+            }
+            m_wait_key = false;
+        }
+
+        if(!m_frames.empty()
+                && m_bytes + frame->len() > m_max_bytes)
+        {
+            m_drop_count++;
+            if(frame->type == 0)
+            {
+                m_wait_key = true;
+            }
+            return false;
+        }
+
+        frame->in_ms = now_ms();
+        m_frames.push_back(frame);
+        m_bytes += frame->len();
+        if(m_bytes > m_peak_bytes)
+        {
+            m_peak_bytes = m_bytes;
+        }
+
+        m_cond.notify_one();
+        return true;
+    }
+
+    save_frame_ptr frame_queue::pop(int32_t timeout_ms)
+    {
+        std::unique_lock<std::mutex> lock(m_mu);
+
+        m_cond.wait_for(lock,std::chrono::milliseconds(timeout_ms),[this]{ return !m_frames.empty() || m_wakeup; });
+        m_wakeup = false;
+        if(m_frames.empty())
+        {
+            return nullptr;
+        }
+
+        save_frame_ptr frame = m_frames.front();
+        m_frames.pop_front();
+        m_bytes -= frame->len();
+        return frame;
+    }
+
+    void frame_queue::wakeup()
+    {
+        std::unique_lock<std::mutex> lock(m_mu);
+        m_wakeup = true;
+        m_cond.notify_all();
+    }
+
+    void frame_queue::clear()
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_mu);
+            m_frames.clear();
+            m_bytes = 0;
+            m_wait_key = false;
+        }
+
+        std::unique_lock<std::mutex> lock(m_free_mu);
+        m_free_frames.clear();
+    }
+
+    uint32_t frame_queue::bytes()
+    {
+        std::unique_lock<std::mutex> lock(m_mu);
+        return m_bytes;
+    }
+
+    uint32_t frame_queue::peak_bytes()
+    {
+        std::unique_lock<std::mutex> lock(m_mu);
+        return m_peak_bytes;
+    }
+
+    uint32_t frame_queue::drop_count()
+    {
+        std::unique_lock<std::mutex> lock(m_mu);
+        return m_drop_count;
+    }
+
+}}//namespace
@@ -0,0 +1,91 @@
+#ifndef frame_queue_include_h
+#define frame_queue_include_h
+
+#include <util/std.h>
+#include <util/stream_type.h>
+#include <util/stream_frame.h>
+#include <deque>
+#include <list>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+
+namespace ceanic{namespace stream_save{
+
+    //one encoded frame (all nalus of a video frame joined, or one audio frame)
+    //shared between producer and writer, so the data is copied exactly once.
+    //a frame made from a stream_frame whose nalus are contiguous keeps a reference instead of a copy
+    struct save_frame
+    {
+        int32_t type;//0-video 1-audio
+        bool key;
+        uint64_t pts;//us
+        int64_t in_ms;//monotonic ms when queued,used for latency stat
+        std::vector<char> buf;
+        ceanic::util::stream_frame_ptr ref;
+        const char* ref_data;
+        int32_t ref_len;
+
+        const char* data() const { return ref ? ref_data : buf.data(); }
+        int32_t len() const { return ref ? ref_len : (int32_t)buf.size(); }
+    };
+    typedef std::shared_ptr<save_frame> save_frame_ptr;
+
+    class frame_queue
+    {
+        public:
+            //max_bytes: queued payload limit,a single frame larger than this is still accepted when the queue is empty
+            frame_queue(uint32_t max_bytes);
+            virtual ~frame_queue();
+
+        public:
+            //get an empty frame with at least len bytes,reuse released frames when possible
+            save_frame_ptr alloc(int32_t len);
+
+            //copy one stream_head into a new frame,vcode is used to detect key frames.
+            //return nullptr if the head carries nothing to save
+            save_frame_ptr make_frame(uint8_t vcode,ceanic::util::stream_head* head,const char* buf,int32_t len);
+
+            //reference a shared video frame without copying when its nalus are contiguous and
+            //the queue is short,otherwise copy it like make_frame
+            save_frame_ptr make_frame(uint8_t vcode,ceanic::util::stream_frame_ptr sframe);
+
+            //queue a frame,drop it when the queue is full.
+            //after a video drop,all video frames are dropped until next key frame
+            bool push(save_frame_ptr frame);
+
+            //wait at most timeout_ms for a frame,return nullptr when timeout or wakeup
+            save_frame_ptr pop(int32_t timeout_ms);
+
+            //drop the reference,the frame is kept for reuse if nobody else holds it
+            void release(save_frame_ptr& frame);
+
+            void wakeup();
+            void clear();
+
+            uint32_t bytes();
+            uint32_t peak_bytes();
+            uint32_t drop_count();
+
+            static int64_t now_ms();
+
+        private:
+            uint32_t m_max_bytes;
+            uint32_t m_bytes;
+            uint32_t m_peak_bytes;
+            uint32_t m_drop_count;
+            bool m_wait_key;
+            bool m_wakeup;
+
+            std::mutex m_mu;
+            std::condition_variable m_cond;
+            std::deque<save_frame_ptr> m_frames;
+
+            std::mutex m_free_mu;
+            std::list<save_frame_ptr> m_free_frames;
+    };
+
+}}//namespace
+
+#endif
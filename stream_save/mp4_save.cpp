@@ -2,8 +2,25 @@
 
 namespace ceanic{namespace stream_save{
 
-    mp4_save::mp4_save(ceanic::util::media_head mh,const char* file_path)
-        :m_bopen(false),m_mh(mh),m_file_path(file_path),m_mp4_fh(NULL),m_mp4_video_track_h(NULL),m_mp4_audio_track_h(NULL),m_sbuf(512 * 1024)
+#define MP4_SAVE_WRITE_ALIGN (4 * 1024)
+#define MP4_SAVE_MAX_WRITE_UNIT (5 * 1024 * 1024)
+#define MP4_SAVE_MAX_PREALLOC (100 * 1024 * 1024)
+
+    mp4_save_param mp4_save::default_param()
+    {
+        mp4_save_param param;
+        param.queue_size = 4 * 1024 * 1024;
+        param.write_unit = 1024 * 1024;
+        param.prealloc_size = 20 * 1024 * 1024;
+        param.sync_interval = 5000;
+        param.stat_interval = 60;
+        return param;
+    }
+
+    mp4_save::mp4_save(ceanic::util::media_head mh,const char* file_path,const mp4_save_param* param)
+        :m_bopen(false),m_mh(mh),m_file_path(file_path),m_mp4_fh(NULL),m_mp4_video_track_h(NULL),m_mp4_audio_track_h(NULL)
+         ,m_param(param ? *param : default_param()),m_queue(m_param.queue_size),m_sync_fd(-1),m_sync_ms(0)
+         ,m_stat_ms(0),m_stat_bytes(0),m_stat_frames(0),m_max_latency(0),m_total_bytes(0)
     {
         memset(&m_mp4_cfg,0,sizeof(m_mp4_cfg));
 
@@ -13,8 +30,18 @@ namespace ceanic{namespace stream_save{
 
        /* 1024 * 1024 : set the vbuf size for fwrite
         * set (0,5M] unit :byte
+        * frames are gathered here and reach the card in write_unit sized,4K aligned writes
        */
-        m_mp4_cfg.stMuxerConfig.u32VBufSize = 512 * 1024; 
+        uint32_t write_unit = (m_param.write_unit + MP4_SAVE_WRITE_ALIGN - 1) / MP4_SAVE_WRITE_ALIGN * MP4_SAVE_WRITE_ALIGN;
+        if(write_unit == 0)
+        {
+            write_unit = MP4_SAVE_WRITE_ALIGN;
+        }
+        else if(write_unit > MP4_SAVE_MAX_WRITE_UNIT)
+        {
+            write_unit = MP4_SAVE_MAX_WRITE_UNIT;
+        }
+        m_mp4_cfg.stMuxerConfig.u32VBufSize = write_unit; 
 
         m_mp4_cfg.stMuxerConfig.bConstantFps = TD_TRUE;
 
@@ -22,7 +49,7 @@ namespace ceanic{namespace stream_save{
          * 0 for not use pre allocate function
          * suggest 20M, unit :byte
          */
-        m_mp4_cfg.stMuxerConfig.u32PreAllocUnit = 0;
+        m_mp4_cfg.stMuxerConfig.u32PreAllocUnit = m_param.prealloc_size > MP4_SAVE_MAX_PREALLOC ? MP4_SAVE_MAX_PREALLOC : m_param.prealloc_size;
 
         m_mp4_cfg.stMuxerConfig.bCo64Flag = TD_FALSE;
 
@@ -111,24 +138,31 @@ namespace ceanic{namespace stream_save{
             }
         }
 
+        //only used for fdatasync,the muxer owns the real writing
+        m_sync_fd = ::open(m_file_path.c_str(),O_WRONLY);
+        m_sync_ms = frame_queue::now_ms();
+
+        m_stat_ms = frame_queue::now_ms();
+        m_stat_bytes = 0;
+        m_stat_frames = 0;
+        m_max_latency = 0;
+        m_total_bytes = 0;
+
         m_bopen = true;
         m_process_thread = std::thread(&mp4_save::on_process,this);
 
         return true;
     }
 
-    void mp4_save::process_audio_frame(const char* frame_buf,int32_t frame_len)
+    void mp4_save::process_audio_frame(save_frame_ptr frame)
     {
         OT_MP4_FRAME_DATA_S frame_info;
         memset(&frame_info,0,sizeof(frame_info));
 
-        struct timeval tv;
-        gettimeofday(&tv, NULL);
-
-        frame_info.pu8DataBuffer = (TD_U8*)frame_buf;
-        frame_info.u32DataLength = frame_len;
+        frame_info.pu8DataBuffer = (TD_U8*)frame->data();
+        frame_info.u32DataLength = frame->len();
         frame_info.bKeyFrameFlag = TD_FALSE;
-        frame_info.u64TimeStamp = (TD_U64)tv.tv_sec * 1000000 + (TD_U64)tv.tv_usec;
+        frame_info.u64TimeStamp = frame->pts;
 
         TD_S32 ret = SS_MP4_WriteFrame(m_mp4_fh, m_mp4_audio_track_h, &frame_info);
         if(ret != TD_SUCCESS)
@@ -137,80 +171,116 @@ namespace ceanic{namespace stream_save{
         }
     }
 
-    void mp4_save::process_video_frame(const char* frame_buf,int32_t frame_len)
+    void mp4_save::process_video_frame(save_frame_ptr frame)
     {
         OT_MP4_FRAME_DATA_S frame_info;
         memset(&frame_info,0,sizeof(frame_info));
 
-        struct timeval tv;
-        gettimeofday(&tv, NULL);
+        frame_info.pu8DataBuffer = (TD_U8*)frame->data();
+        frame_info.u32DataLength = frame->len();
+        frame_info.bKeyFrameFlag = frame->key ? TD_TRUE : TD_FALSE;
+        frame_info.u64TimeStamp = frame->pts;
 
-        TD_BOOL key_frame = TD_FALSE;
-        if(m_mh.video_info.vcode == ceanic::util::STREAM_VIDEO_ENCODE_H264)
+        TD_S32 ret = SS_MP4_WriteFrame(m_mp4_fh, m_mp4_video_track_h, &frame_info);
+        if(ret != TD_SUCCESS)
         {
-            key_frame = ((frame_buf[4] & 0x1f) == 0x7) ? TD_TRUE: TD_FALSE;//sps
+            printf("[%s]:SS_MP4_WriteFrame failed with 0x%x\n",__FUNCTION__,ret);
+        }
+    }
+
+    void mp4_save::write_frame(save_frame_ptr& frame)
+    {
+        if(frame->type == 0)
+        {
+            process_video_frame(frame);
         }
         else
         {
-            int32_t h265_nalu_type = (frame_buf[4] >> 1) & 0x3f;
-            key_frame = (h265_nalu_type == 32) ? TD_TRUE: TD_FALSE;
+            process_audio_frame(frame);
         }
 
-        frame_info.pu8DataBuffer = (TD_U8*)frame_buf;
-        frame_info.u32DataLength = frame_len;
-        frame_info.bKeyFrameFlag = key_frame;
-        frame_info.u64TimeStamp = (TD_U64)tv.tv_sec * 1000000 + (TD_U64)tv.tv_usec;
+        int64_t latency = frame_queue::now_ms() - frame->in_ms;
+        if(latency > m_max_latency)
+        {
+            m_max_latency = latency;
+        }
+        m_stat_bytes += frame->len();
+        m_total_bytes += frame->len();
+        m_stat_frames++;
 
-        TD_S32 ret = SS_MP4_WriteFrame(m_mp4_fh, m_mp4_video_track_h, &frame_info);
-        if(ret != TD_SUCCESS)
+        m_queue.release(frame);
+    }
+
+    void mp4_save::sync_file()
+    {
+        if(m_sync_fd < 0 || m_param.sync_interval == 0)
         {
-            printf("[%s]:SS_MP4_WriteFrame failed with 0x%x\n",__FUNCTION__,ret);
+            return;
         }
+
+        int64_t now = frame_queue::now_ms();
+        if(now - m_sync_ms < (int64_t)m_param.sync_interval)
+        {
+            return;
+        }
+
+        //flush what the muxer has handed to the kernel,so a power cut loses at most sync_interval of data
+        fdatasync(m_sync_fd);
+        m_sync_ms = now;
     }
 
-    void mp4_save::on_process()
+    void mp4_save::report_stat(bool force)
     {
-        bool get_data = false;
-        int32_t frame_len = 0;
-        int32_t frame_type = 0;
-        char* frame_buf= new char[512*1024];
+        int64_t now = frame_queue::now_ms();
+        int64_t elapse = now - m_stat_ms;
 
-        while(m_bopen)
+        if(!force
+                && (m_param.stat_interval == 0 || elapse < (int64_t)m_param.stat_interval * 1000))
         {
-            get_data = false;
+            return;
+        }
 
-            {
-                std::unique_lock<std::mutex> sl(m_buf_mu);
-                if(m_sbuf.get_stream_len() >= 8 
-                        && m_sbuf.copy_data(&frame_len,4)
-                        && m_sbuf.copy_data(&frame_type,4)
-                        && m_sbuf.get_stream_len() > 8 + frame_len)
-                {
-                    m_sbuf.get_data(&frame_len,4);
-                    m_sbuf.get_data(&frame_type,4);
-                    m_sbuf.get_data(frame_buf,frame_len);
-                    get_data = true;
-                }
-            }
+        if(elapse > 0)
+        {
+            printf("[%s]:%s,write %.1f KB/s,frames:%u,max latency:%lld ms,queue peak:%u KB,drop:%u,total:%llu KB\n",
+                    __FUNCTION__,
+                    m_file_path.c_str(),
+                    m_stat_bytes * 1000.0 / 1024 / elapse,
+                    m_stat_frames,
+                    (long long)m_max_latency,
+                    m_queue.peak_bytes() / 1024,
+                    m_queue.drop_count(),
+                    (unsigned long long)m_total_bytes / 1024);
+        }
 
-            if(!get_data)
-            {
-                usleep(10000);
-                continue;
-            }
+        m_stat_ms = now;
+        m_stat_bytes = 0;
+        m_stat_frames = 0;
+        m_max_latency = 0;
+    }
 
-            //printf("[%s]:get frame len:%d\n)",__FUNCTION__,frame_len);
-            if(frame_type == 0)
-            {
-                process_video_frame(frame_buf,frame_len);
-            }
-            else
+    void mp4_save::on_process()
+    {
+        save_frame_ptr frame;
+
+        while(m_bopen)
+        {
+            frame = m_queue.pop(100);
+            if(frame)
             {
-                process_audio_frame(frame_buf,frame_len);
+                write_frame(frame);
             }
+
+            sync_file();
+            report_stat(false);
         }
 
-        delete[] frame_buf;
+        //write what is left in the queue before the muxer is destroyed
+        while((frame = m_queue.pop(0)) != nullptr)
+        {
+            write_frame(frame);
+        }
+        report_stat(true);
     }
 
     void mp4_save::close()
@@ -226,6 +296,7 @@ namespace ceanic{namespace stream_save{
         }
 
         m_bopen = false;
+        m_queue.wakeup();
         m_process_thread.join();
 
         ret = SS_MP4_DestroyAllTracks(m_mp4_fh, NULL);
@@ -242,6 +313,14 @@ namespace ceanic{namespace stream_save{
 
         m_mp4_fh = NULL;
         m_mp4_video_track_h = NULL;
+        m_mp4_audio_track_h = NULL;
+
+        if(m_sync_fd >= 0)
+        {
+            ::close(m_sync_fd);
+            m_sync_fd = -1;
+        }
+        m_queue.clear();
     }
 
     bool mp4_save::is_open()
@@ -252,6 +331,44 @@ namespace ceanic{namespace stream_save{
     }
 
     bool mp4_save::input_data(ceanic::util::stream_head* head,const char* buf,int32_t len)
+    {
+        if(IS_AUDIO_FRAME(head->type)
+                && m_mh.audio_info.acode == ceanic::util::STREAM_AUDIO_ENCODE_NONE)
+        {
+            return false;
+        }
+
+        if(!is_open())
+        {
+            return false;
+        }
+
+        save_frame_ptr frame = m_queue.make_frame(m_mh.video_info.vcode,head,buf,len);
+        if(!frame)
+        {
+            return IS_VIDEO_FRAME(head->type) ? false : true;
+        }
+
+        return input_frame(frame);
+    }
+
+    bool mp4_save::input_stream_frame(ceanic::util::stream_frame_ptr sframe)
+    {
+        if(!is_open())
+        {
+            return false;
+        }
+
+        save_frame_ptr frame = m_queue.make_frame(m_mh.video_info.vcode,sframe);
+        if(!frame)
+        {
+            return false;
+        }
+
+        return input_frame(frame);
+    }
+
+    bool mp4_save::input_frame(save_frame_ptr frame)
     {
         std::unique_lock<std::mutex> lock(m_interface_mu);
 
@@ -260,58 +377,19 @@ namespace ceanic{namespace stream_save{
             return false;
         }
 
+        if(frame->type == 1
+                && m_mh.audio_info.acode == ceanic::util::STREAM_AUDIO_ENCODE_NONE)
         {
-            int32_t frame_len = 0;
-            int32_t frame_type = 0;//0-video 1-audio
+            return false;
+        }
 
-            std::unique_lock<std::mutex> sl(m_buf_mu);
-            if(IS_VIDEO_FRAME(head->type))
-            {
-                for(uint32_t i = 0; i < head->nalu_count; i++)
-                {
-                    frame_len += head->nalu[i].size;
-                }
-
-                if(m_sbuf.get_remain_len() < 8 + frame_len)
-                {
-                    printf("[%s]:buf is full\n",__FUNCTION__);
-                    return false;
-                }
-
-                m_sbuf.input_data(&frame_len,4);
-                m_sbuf.input_data(&frame_type,4);
-                for(uint32_t i = 0; i < head->nalu_count; i++)
-                {
-                    m_sbuf.input_data((void*)head->nalu[i].data,head->nalu[i].size);
-                }
-
-                return true;
-            }
-            else if(IS_AUDIO_FRAME(head->type))
-            {
-                if(m_mh.audio_info.acode == ceanic::util::STREAM_AUDIO_ENCODE_NONE)
-                {
-                    return false;
-                }
-
-                frame_len = len;
-                frame_type = 1;
-
-                if(m_sbuf.get_remain_len() < 8 + frame_len)
-                {
-                    printf("[%s]:buf is full\n",__FUNCTION__);
-                    return false;
-                }
-                m_sbuf.input_data(&frame_len,4);
-                m_sbuf.input_data(&frame_type,4);
-                m_sbuf.input_data((void*)buf,len);
-
-                return true;
-            }
+        if(!m_queue.push(frame))
+        {
+            m_queue.release(frame);
+            return false;
         }
 
         return true;
     }
 
 }}//namespace
-
@@ -2,19 +2,29 @@
 #define mp4_save_include_h
 
 #include <util/std.h>
-#include <util/stream_buf.h>
 #include <string>
 #include <mutex>
 #include <thread>
 #include "stream_save.h"
+#include "frame_queue.h"
 #include <ss_mp4_format.h>
 
 namespace ceanic{namespace stream_save{
+
+    typedef struct
+    {
+        uint32_t queue_size;    //bytes,frames waiting to be written,key frames larger than this are still accepted
+        uint32_t write_unit;    //bytes,muxer write cache,aligned to 4K,(0,5M]
+        uint32_t prealloc_size; //bytes,file pre allocate unit,0:disable
+        uint32_t sync_interval; //ms,fdatasync interval,0:disable
+        uint32_t stat_interval; //s,throughput/latency report interval,0:disable
+    }mp4_save_param;
+
     class mp4_save
         :public stream_save
     {
         public:
-            mp4_save(ceanic::util::media_head mh,const char* file_path);
+            mp4_save(ceanic::util::media_head mh,const char* file_path,const mp4_save_param* param = NULL);
             virtual ~mp4_save();
 
         public:
@@ -22,10 +32,19 @@ namespace ceanic{namespace stream_save{
             void close() override;
             bool is_open() override;
             bool input_data(ceanic::util::stream_head* head,const char* buf,int32_t len) override;
+            bool input_stream_frame(ceanic::util::stream_frame_ptr frame) override;
+
+            //queue a frame that is already built,the frame may be shared with other savers
+            bool input_frame(save_frame_ptr frame);
+
+            static mp4_save_param default_param();
 
         private:
-            void process_video_frame(const char* frame_buf,int32_t frame_len);
-            void process_audio_frame(const char* frame_buf,int32_t frame_len);
+            void process_video_frame(save_frame_ptr frame);
+            void process_audio_frame(save_frame_ptr frame);
+            void write_frame(save_frame_ptr& frame);
+            void sync_file();
+            void report_stat(bool force);
             void on_process();
 
         private:
@@ -43,8 +62,17 @@ namespace ceanic{namespace stream_save{
             std::mutex m_interface_mu;
             std::thread m_process_thread;
 
-            std::mutex m_buf_mu;
-            ceanic::util::stream_buf m_sbuf;
+            mp4_save_param m_param;
+            frame_queue m_queue;
+            int m_sync_fd;
+            int64_t m_sync_ms;
+
+            //stat,only touched by the process thread
+            int64_t m_stat_ms;
+            uint64_t m_stat_bytes;
+            uint32_t m_stat_frames;
+            int64_t m_max_latency;
+            uint64_t m_total_bytes;
     };
 
 }}//namespace
@@ -0,0 +1,475 @@
+#include "segment_pool.h"
+#include <libgen.h>
+
+namespace ceanic{namespace stream_save{
+
+#define SEGMENT_POOL_ALIGN 4096
+#define SEGMENT_POOL_ALIGN_UP(x) (((x) + SEGMENT_POOL_ALIGN - 1) / SEGMENT_POOL_ALIGN * SEGMENT_POOL_ALIGN)
+
+    segment_pool_param segment_pool::default_param()
+    {
+        segment_pool_param param;
+        memset(&param,0,sizeof(param));
+        sprintf(param.dir_path,"%s","/mnt/pool");
+        param.count = 64;
+        param.segment_size = 256ULL * 1024 * 1024;
+        param.max_keys = 1024;
+        return param;
+    }
+
+    segment_pool::segment_pool(const segment_pool_param* param)
+        :m_param(param ? *param : default_param()),m_index_fd(-1),m_seq(0)
+    {
+        if(m_param.count == 0)
+        {
+            m_param.count = 1;
+        }
+
+        m_slot_size = SEGMENT_POOL_ALIGN_UP(sizeof(segment_info) + m_param.max_keys * sizeof(fmp4_index_entry));
+    }
+
+    segment_pool::~segment_pool()
+    {
+        close();
+    }
+
+    uint64_t segment_pool::slot_offset(uint32_t slot)
+    {
+        return SEGMENT_POOL_ALIGN + (uint64_t)slot * m_slot_size;
+    }
+
+    std::string segment_pool::segment_file(uint32_t slot)
+    {
+        char name[64];
+        snprintf(name,sizeof(name),SEGMENT_POOL_FILE,slot);
+        return std::string(m_param.dir_path) + "/" + name;
+    }
+
+    uint32_t segment_pool::count()
+    {
+        return m_param.count;
+    }
+
+    uint64_t segment_pool::segment_size()
+    {
+        return m_param.segment_size;
+    }
+
+    bool segment_pool::is_open()
+    {
+        std::unique_lock<std::mutex> lock(m_mu);
+
+        return m_index_fd >= 0;
+    }
+
+    bool segment_pool::preallocate(const char* file,uint64_t size)
+    {
+        int fd = ::open(file,O_WRONLY | O_CREAT,0644);
+        if(fd < 0)
+        {
+            printf("[%s]:open %s failed,errno:%d\n",__FUNCTION__,file,errno);
+            return false;
+        }
+
+        struct stat st;
+        if(fstat(fd,&st) == 0 && (uint64_t)st.st_size >= size)
+        {
+            ::close(fd);
+            return true;
+        }
+
+        //fallocate reserves the clusters at once,posix_fallocate writes zeros where it is not supported
+        int ret = fallocate(fd,0,0,size);
+        if(ret < 0)
+        {
+            ret = posix_fallocate(fd,0,size);
+        }
+        ::close(fd);
+
+        if(ret != 0)
+        {
+            printf("[%s]:preallocate %s(%llu bytes) failed,errno:%d\n",__FUNCTION__,file,(unsigned long long)size,errno);
+            return false;
+        }
+
+        return true;
+    }
+
+    bool segment_pool::format()
+    {
+        std::unique_lock<std::mutex> lock(m_mu);
+
+        if(m_index_fd >= 0)
+        {
+            ::close(m_index_fd);
+            m_index_fd = -1;
+        }
+
+        printf("[%s]:format %s,%u x %llu KB\n",__FUNCTION__,m_param.dir_path,m_param.count,(unsigned long long)m_param.segment_size / 1024);
+        for(uint32_t i = 0; i < m_param.count; i++)
+        {
+            if(!preallocate(segment_file(i).c_str(),m_param.segment_size))
+            {
+                return false;
+            }
+        }
+
+        std::string index_file = std::string(m_param.dir_path) + "/" + SEGMENT_POOL_INDEX;
+        int fd = ::open(index_file.c_str(),O_RDWR | O_CREAT | O_TRUNC,0644);
+        if(fd < 0)
+        {
+            printf("[%s]:open %s failed,errno:%d\n",__FUNCTION__,index_file.c_str(),errno);
+            return false;
+        }
+
+        //the index is preallocated as well,updates are in-place writes
+        uint64_t index_size = slot_offset(m_param.count);
+        if(fallocate(fd,0,0,index_size) < 0 && ftruncate(fd,index_size) < 0)
+        {
+            printf("[%s]:preallocate %s failed,errno:%d\n",__FUNCTION__,index_file.c_str(),errno);
+            ::close(fd);
+            return false;
+        }
+
+        m_index_fd = fd;
+        m_infos.assign(m_param.count,segment_info());
+        memset(m_infos.data(),0,m_infos.size() * sizeof(segment_info));
+        m_seq = 0;
+        for(uint32_t i = 0; i < m_param.count; i++)
+        {
+            write_info(i);
+        }
+
+        segment_pool_head head;
+        memset(&head,0,sizeof(head));
+        head.tag = SEGMENT_POOL_TAG;
+        head.version = SEGMENT_POOL_VERSION;
+        head.count = m_param.count;
+        head.max_keys = m_param.max_keys;
+        head.segment_size = m_param.segment_size;
+
+        //the head goes last,an interrupted format is formatted again
+        if(pwrite(m_index_fd,&head,sizeof(head),0) != sizeof(head)
+                || fdatasync(m_index_fd) < 0)
+        {
+            printf("[%s]:write %s failed,errno:%d\n",__FUNCTION__,index_file.c_str(),errno);
+            ::close(m_index_fd);
+            m_index_fd = -1;
+            return false;
+        }
+
+        return true;
+    }
+
+    bool segment_pool::open()
+    {
+        if(access(m_param.dir_path,F_OK) < 0
+                && mkdir(m_param.dir_path,0755) < 0)
+        {
+            printf("[%s]:mkdir %s failed,errno:%d\n",__FUNCTION__,m_param.dir_path,errno);
+            return false;
+        }
+
+        {
+            std::unique_lock<std::mutex> lock(m_mu);
+
+            if(m_index_fd >= 0)
+            {
+                return false;
+            }
+
+            std::string index_file = std::string(m_param.dir_path) + "/" + SEGMENT_POOL_INDEX;
+            int fd = ::open(index_file.c_str(),O_RDWR);
+            segment_pool_head head;
+            bool valid = (fd >= 0
+                    && pread(fd,&head,sizeof(head),0) == sizeof(head)
+                    && head.tag == SEGMENT_POOL_TAG
+                    && head.version == SEGMENT_POOL_VERSION
+                    && head.count == m_param.count
+                    && head.max_keys == m_param.max_keys
+                    && head.segment_size == m_param.segment_size);
+
+            m_infos.assign(m_param.count,segment_info());
+            memset(m_infos.data(),0,m_infos.size() * sizeof(segment_info));
+            m_seq = 0;
+            for(uint32_t i = 0; valid && i < m_param.count; i++)
+            {
+                struct stat st;
+                if(pread(fd,&m_infos[i],sizeof(segment_info),slot_offset(i)) != sizeof(segment_info)
+                        || stat(segment_file(i).c_str(),&st) < 0
+                        || (uint64_t)st.st_size < m_param.segment_size)
+                {
+                    valid = false;
+                    break;
+                }
+
+                if(m_infos[i].seq > m_seq)
+                {
+                    m_seq = m_infos[i].seq;
+                }
+            }
+
+            if(valid)
+            {
+                m_index_fd = fd;
+
+                //a segment left recording was cut by a power loss,it is valid up to its last update
+                for(uint32_t i = 0; i < m_param.count; i++)
+                {
+                    if(m_infos[i].state == SEGMENT_RECORDING)
+                    {
+                        m_infos[i].state = SEGMENT_CLOSED;
+                        write_info(i);
+                    }
+                }
+
+                printf("[%s]:%s,%u segments,seq %llu\n",__FUNCTION__,m_param.dir_path,m_param.count,(unsigned long long)m_seq);
+                return true;
+            }
+
+            if(fd >= 0)
+            {
+                ::close(fd);
+            }
+        }
+
+        return format();
+    }
+
+    void segment_pool::close()
+    {
+        std::unique_lock<std::mutex> lock(m_mu);
+
+        if(m_index_fd < 0)
+        {
+            return;
+        }
+
+        fdatasync(m_index_fd);
+        ::close(m_index_fd);
+        m_index_fd = -1;
+    }
+
+    bool segment_pool::write_info(uint32_t slot)
+    {
+        if(pwrite(m_index_fd,&m_infos[slot],sizeof(segment_info),slot_offset(slot)) != sizeof(segment_info))
+        {
+            printf("[%s]:write slot %u failed,errno:%d\n",__FUNCTION__,slot,errno);
+            return false;
+        }
+
+        return true;
+    }
+
+    int32_t segment_pool::acquire(uint8_t vcode,uint8_t acode,std::string& file)
+    {
+        std::unique_lock<std::mutex> lock(m_mu);
+
+        if(m_index_fd < 0)
+        {
+            return -1;
+        }
+
+        //never used slots have seq 0 and go first,then the oldest recording
+        int32_t slot = -1;
+        for(uint32_t i = 0; i < m_param.count; i++)
+        {
+            if(m_infos[i].state == SEGMENT_RECORDING)
+            {
+                continue;
+            }
+
+            if(slot < 0 || m_infos[i].seq < m_infos[slot].seq)
+            {
+                slot = i;
+            }
+        }
+
+        if(slot < 0)
+        {
+            return -1;
+        }
+
+        if(m_infos[slot].seq != 0)
+        {
+            printf("[%s]:recycle %s\n",__FUNCTION__,segment_file(slot).c_str());
+        }
+
+        segment_info& info = m_infos[slot];
+        memset(&info,0,sizeof(info));
+        info.seq = ++m_seq;
+        info.state = SEGMENT_RECORDING;
+        info.vcode = vcode;
+        info.acode = acode;
+        if(!write_info(slot))
+        {
+            return -1;
+        }
+
+        file = segment_file(slot);
+        return slot;
+    }
+
+    void segment_pool::release(int32_t slot)
+    {
+        std::unique_lock<std::mutex> lock(m_mu);
+
+        if(m_index_fd < 0 || slot < 0 || (uint32_t)slot >= m_param.count)
+        {
+            return;
+        }
+
+        m_infos[slot].state = SEGMENT_CLOSED;
+        write_info(slot);
+        fdatasync(m_index_fd);
+    }
+
+    void segment_pool::set_start_time(int32_t slot,uint64_t start_time)
+    {
+        std::unique_lock<std::mutex> lock(m_mu);
+
+        if(m_index_fd < 0 || slot < 0 || (uint32_t)slot >= m_param.count)
+        {
+            return;
+        }
+
+        m_infos[slot].start_time = start_time;
+        m_infos[slot].end_time = start_time;
+        write_info(slot);
+    }
+
+    void segment_pool::add_key(int32_t slot,const fmp4_index_entry& entry)
+    {
+        std::unique_lock<std::mutex> lock(m_mu);
+
+        if(m_index_fd < 0 || slot < 0 || (uint32_t)slot >= m_param.count)
+        {
+            return;
+        }
+
+        //a full table still plays,seeks past the last entry read forward from it
+        segment_info& info = m_infos[slot];
+        if(info.key_count >= m_param.max_keys)
+        {
+            return;
+        }
+
+        uint64_t pos = slot_offset(slot) + sizeof(segment_info) + (uint64_t)info.key_count * sizeof(fmp4_index_entry);
+        if(pwrite(m_index_fd,&entry,sizeof(entry),pos) == sizeof(entry))
+        {
+            //the count is persisted by the next update
+            info.key_count++;
+        }
+    }
+
+    void segment_pool::update(int32_t slot,uint64_t used,uint32_t end_time)
+    {
+        std::unique_lock<std::mutex> lock(m_mu);
+
+        if(m_index_fd < 0 || slot < 0 || (uint32_t)slot >= m_param.count)
+        {
+            return;
+        }
+
+        m_infos[slot].used = used;
+        m_infos[slot].end_time = m_infos[slot].start_time + (uint64_t)end_time * 1000;
+        write_info(slot);
+    }
+
+    void segment_pool::sync()
+    {
+        std::unique_lock<std::mutex> lock(m_mu);
+
+        if(m_index_fd >= 0)
+        {
+            fdatasync(m_index_fd);
+        }
+    }
+
+    bool segment_pool::get_info(uint32_t slot,segment_info* info)
+    {
+        std::unique_lock<std::mutex> lock(m_mu);
+
+        if(m_index_fd < 0 || slot >= m_param.count)
+        {
+            return false;
+        }
+
+        *info = m_infos[slot];
+        return true;
+    }
+
+    int32_t segment_pool::find(uint64_t time)
+    {
+        std::unique_lock<std::mutex> lock(m_mu);
+
+        int32_t slot = -1;
+        for(uint32_t i = 0; i < m_infos.size(); i++)
+        {
+            const segment_info& info = m_infos[i];
+            if(info.state != SEGMENT_EMPTY
+                    && info.start_time != 0
+                    && time >= info.start_time
+                    && time <= info.end_time
+                    && (slot < 0 || info.seq > m_infos[slot].seq))
+            {
+                slot = i;
+            }
+        }
+
+        return slot;
+    }
+
+    bool segment_pool::load_segment_index(const char* file,uint64_t* start_time,std::vector<fmp4_index_entry>& index)
+    {
+        char path[512];
+        snprintf(path,sizeof(path),"%s",file);
+        std::string name = basename(path);
+        snprintf(path,sizeof(path),"%s",file);
+        std::string dir = dirname(path);
+
+        uint32_t slot;
+        char tail;
+        if(sscanf(name.c_str(),"rec_%u.mp%c",&slot,&tail) != 2)
+        {
+            return false;
+        }
+
+        std::string index_file = dir + "/" + SEGMENT_POOL_INDEX;
+        int fd = ::open(index_file.c_str(),O_RDONLY);
+        if(fd < 0)
+        {
+            return false;
+        }
+
+        segment_pool_head head;
+        segment_info info;
+        if(pread(fd,&head,sizeof(head),0) != sizeof(head)
+                || head.tag != SEGMENT_POOL_TAG
+                || head.version != SEGMENT_POOL_VERSION
+                || slot >= head.count)
+        {
+            ::close(fd);
+            return false;
+        }
+
+        uint64_t slot_size = SEGMENT_POOL_ALIGN_UP(sizeof(segment_info) + head.max_keys * sizeof(fmp4_index_entry));
+        uint64_t pos = SEGMENT_POOL_ALIGN + slot * slot_size;
+        if(pread(fd,&info,sizeof(info),pos) != sizeof(info)
+                || info.state == SEGMENT_EMPTY
+                || info.key_count > head.max_keys)
+        {
+            ::close(fd);
+            return false;
+        }
+
+        index.resize(info.key_count);
+        ssize_t len = pread(fd,index.data(),index.size() * sizeof(fmp4_index_entry),pos + sizeof(info));
+        index.resize(len > 0 ? len / sizeof(fmp4_index_entry) : 0);
+        ::close(fd);
+
+        *start_time = info.start_time;
+        return !index.empty();
+    }
+
+}}//namespace
@@ -0,0 +1,114 @@
+#ifndef segment_pool_include_h
+#define segment_pool_include_h
+
+#include <util/std.h>
+#include <string>
+#include <vector>
+#include <mutex>
+#include "fmp4_index.h"
+
+namespace ceanic{namespace stream_save{
+
+//on-disk index of the pool,dir_path/pool.idx: head,then one fixed size slot per segment file.
+//a slot is the segment_info followed by max_keys fmp4_index_entry,slots are 4K aligned
+#define SEGMENT_POOL_TAG 0x4c4f4f50
+#define SEGMENT_POOL_VERSION 1
+#define SEGMENT_POOL_INDEX "pool.idx"
+#define SEGMENT_POOL_FILE "rec_%04u.mp4"
+
+    enum
+    {
+        SEGMENT_EMPTY = 0,
+        SEGMENT_RECORDING = 1,
+        SEGMENT_CLOSED = 2,
+    };
+
+    typedef struct
+    {
+        uint32_t tag;
+        uint32_t version;
+        uint32_t count;
+        uint32_t max_keys;
+        uint64_t segment_size;
+        uint64_t reserved;
+    }segment_pool_head;
+
+    typedef struct
+    {
+        uint64_t seq;           //recording order,0:never used
+        uint32_t state;
+        uint8_t vcode;
+        uint8_t acode;
+        uint16_t reserved;
+        uint64_t start_time;    //us,wall clock of media time 0
+        uint64_t end_time;      //us,wall clock of the end of the last fragment
+        uint64_t used;          //bytes of valid data from the file start
+        uint32_t key_count;
+        uint32_t reserved2;
+    }segment_info;
+
+    typedef struct
+    {
+        char dir_path[255];
+        uint32_t count;         //segment files
+        uint64_t segment_size;  //bytes,preallocated size of each file
+        uint32_t max_keys;      //key frame entries kept per segment
+    }segment_pool_param;
+
+    //a fixed set of preallocated segment files written in a circle,the oldest segment is
+    //recycled when all are used.files are never created,grown or deleted while recording,
+    //so the filesystem does not fragment and write latency does not drift with age
+    class segment_pool
+    {
+        public:
+            explicit segment_pool(const segment_pool_param* param);
+            virtual ~segment_pool();
+
+        public:
+            //load the pool,format it if the index is missing or the layout changed
+            bool open();
+            void close();
+            bool is_open();
+
+            //create and preallocate all segment files and an empty index
+            bool format();
+
+            //start a new recording in the oldest segment,returns the slot,-1 on failure
+            int32_t acquire(uint8_t vcode,uint8_t acode,std::string& file);
+            void release(int32_t slot);
+
+            void set_start_time(int32_t slot,uint64_t start_time);
+            void add_key(int32_t slot,const fmp4_index_entry& entry);
+            void update(int32_t slot,uint64_t used,uint32_t end_time);
+            void sync();
+
+            uint32_t count();
+            uint64_t segment_size();
+            std::string segment_file(uint32_t slot);
+            bool get_info(uint32_t slot,segment_info* info);
+
+            //slot recorded at wall clock time(us),-1 if none
+            int32_t find(uint64_t time);
+
+            static segment_pool_param default_param();
+
+            //key frame index of a segment file by its path,for readers that do not own the pool
+            static bool load_segment_index(const char* file,uint64_t* start_time,std::vector<fmp4_index_entry>& index);
+
+        private:
+            uint64_t slot_offset(uint32_t slot);
+            bool write_info(uint32_t slot);
+            bool preallocate(const char* file,uint64_t size);
+
+        private:
+            segment_pool_param m_param;
+            int m_index_fd;
+            uint32_t m_slot_size;
+            std::vector<segment_info> m_infos;
+            uint64_t m_seq;
+            std::mutex m_mu;
+    };
+
+}}//namespace
+
+#endif
@@ -2,6 +2,7 @@
 #define stream_save_include_h
 
 #include <util/stream_type.h>
+#include <util/stream_frame.h>
 namespace ceanic{namespace stream_save{
 
     class stream_save
@@ -15,6 +16,12 @@ namespace ceanic{namespace stream_save{
             virtual void close() = 0;
             virtual bool is_open() = 0;
             virtual bool input_data(ceanic::util::stream_head* head,const char* buf,int32_t len) = 0;
+
+            //savers that queue frames can keep the reference instead of copying the payload
+            virtual bool input_stream_frame(ceanic::util::stream_frame_ptr frame)
+            {
+                return input_data(frame->head(),NULL,0);
+            }
     };
 
 }}//namespace
@@ -0,0 +1,389 @@
+#include "mot_tracker.h"
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+
+namespace ceanic{namespace tracker{
+
+//process noise relative to the box height,as in deep sort
+#define MOT_WEIGHT_POS (1.0f / 20)
+#define MOT_WEIGHT_VEL (1.0f / 160)
+//cost of pairs that must not match
+#define MOT_NO_MATCH 1e6f
+
+    mot_tracker_param mot_tracker::default_param()
+    {
+        mot_tracker_param param;
+        memset(&param,0,sizeof(param));
+        param.iou_threshold = 0.3f;
+        param.high_score = 0.5f;
+        param.low_score = 0.1f;
+        param.min_hits = 2;
+        param.max_age = 5;
+        param.max_interval = 1;
+        param.static_speed = 1.0f;
+        return param;
+    }
+
+    mot_tracker::mot_tracker(const mot_tracker_param* param)
+        :m_param(param ? *param : default_param()),m_next_id(1),m_interval(1),m_since_detect(0)
+    {
+        if(m_param.max_interval == 0)
+        {
+            m_param.max_interval = 1;
+        }
+
+        if(m_param.min_hits == 0)
+        {
+            m_param.min_hits = 1;
+        }
+    }
+
+    mot_tracker::~mot_tracker()
+    {
+    }
+
+    void mot_tracker::reset()
+    {
+        m_tracks.clear();
+        m_output.clear();
+        m_interval = 1;
+        m_since_detect = 0;
+    }
+
+    float mot_tracker::iou(float ax1,float ay1,float ax2,float ay2,float bx1,float by1,float bx2,float by2)
+    {
+        float w = std::min(ax2,bx2) - std::max(ax1,bx1);
+        float h = std::min(ay2,by2) - std::max(ay1,by1);
+        if(w <= 0 || h <= 0)
+        {
+            return 0;
+        }
+
+        float inter = w * h;
+        float uni = (ax2 - ax1) * (ay2 - ay1) + (bx2 - bx1) * (by2 - by1) - inter;
+        return uni > 0 ? inter / uni : 0;
+    }
+
+    void mot_tracker::hungarian(const std::vector<float>& cost,int32_t rows,int32_t cols,std::vector<int32_t>& row_to_col)
+    {
+        row_to_col.assign(rows,-1);
+        if(rows == 0 || cols == 0)
+        {
+            return;
+        }
+
+        //the potentials method needs n <= m,work on the transposed matrix otherwise
+        bool trans = rows > cols;
+        int32_t n = trans ? cols : rows;
+        int32_t m = trans ? rows : cols;
+        auto a = [&](int32_t i,int32_t j) -> double
+        {
+            return trans ? cost[j * cols + i] : cost[i * cols + j];
+        };
+
+        const double inf = 1e18;
+        std::vector<double> u(n + 1,0),v(m + 1,0);
+        std::vector<int32_t> p(m + 1,0),way(m + 1,0);
+        for(int32_t i = 1; i <= n; i++)
+        {
+            p[0] = i;
+            int32_t j0 = 0;
+            std::vector<double> minv(m + 1,inf);
+            std::vector<bool> used(m + 1,false);
+            do
+            {
+                used[j0] = true;
+                int32_t i0 = p[j0];
+                int32_t j1 = 0;
+                double delta = inf;
+                for(int32_t j = 1; j <= m; j++)
+                {
+                    if(used[j])
+                    {
+                        continue;
+                    }
+
+                    double cur = a(i0 - 1,j - 1) - u[i0] - v[j];
+                    if(cur < minv[j])
+                    {
+                        minv[j] = cur;
+                        way[j] = j0;
+                    }
+                    if(minv[j] < delta)
+                    {
+                        delta = minv[j];
+                        j1 = j;
+                    }
+                }
+
+                for(int32_t j = 0; j <= m; j++)
+                {
+                    if(used[j])
+                    {
+                        u[p[j]] += delta;
+                        v[j] -= delta;
+                    }
+                    else
+                    {
+                        minv[j] -= delta;
+                    }
+                }
+                j0 = j1;
+            }while(p[j0] != 0);
+
+            do
+            {
+                int32_t j1 = way[j0];
+                p[j0] = p[j1];
+                j0 = j1;
+            }while(j0);
+        }
+
+        for(int32_t j = 1; j <= m; j++)
+        {
+            if(p[j] == 0)
+            {
+                continue;
+            }
+
+            if(trans)
+            {
+                row_to_col[j - 1] = p[j] - 1;
+            }
+            else
+            {
+                row_to_col[p[j] - 1] = j - 1;
+            }
+        }
+    }
+
+    void mot_tracker::kf_init(kalman_t& kf,const detection& det)
+    {
+        float z[4] = {(det.x1 + det.x2) / 2,(det.y1 + det.y2) / 2,det.x2 - det.x1,det.y2 - det.y1};
+        float h = std::max(z[3],1.0f);
+        float sp = 2 * MOT_WEIGHT_POS * h;
+        float sv = 10 * MOT_WEIGHT_VEL * h;
+        for(int i = 0; i < 4; i++)
+        {
+            kf.x[i] = z[i];
+            kf.v[i] = 0;
+            kf.p00[i] = sp * sp;
+            kf.p01[i] = 0;
+            kf.p11[i] = sv * sv;
+        }
+    }
+
+    void mot_tracker::kf_predict(kalman_t& kf)
+    {
+        float h = std::max(kf.x[3],1.0f);
+        float qp = MOT_WEIGHT_POS * h;
+        float qv = MOT_WEIGHT_VEL * h;
+        for(int i = 0; i < 4; i++)
+        {
+            kf.x[i] += kf.v[i];
+            kf.p00[i] += 2 * kf.p01[i] + kf.p11[i] + qp * qp;
+            kf.p01[i] += kf.p11[i];
+            kf.p11[i] += qv * qv;
+        }
+    }
+
+    void mot_tracker::kf_update(kalman_t& kf,const detection& det)
+    {
+        float z[4] = {(det.x1 + det.x2) / 2,(det.y1 + det.y2) / 2,det.x2 - det.x1,det.y2 - det.y1};
+        float h = std::max(kf.x[3],1.0f);
+        float r = MOT_WEIGHT_POS * h;
+        for(int i = 0; i < 4; i++)
+        {
+            float s = kf.p00[i] + r * r;
+            float k0 = kf.p00[i] / s;
+            float k1 = kf.p01[i] / s;
+            float y = z[i] - kf.x[i];
+            kf.x[i] += k0 * y;
+            kf.v[i] += k1 * y;
+
+            float p00 = kf.p00[i];
+            float p01 = kf.p01[i];
+            kf.p00[i] = (1 - k0) * p00;
+            kf.p01[i] = (1 - k0) * p01;
+            kf.p11[i] -= k1 * p01;
+        }
+    }
+
+    void mot_tracker::sync_box(kalman_track& kt)
+    {
+        float w = std::max(kt.kf.x[2],1.0f);
+        float h = std::max(kt.kf.x[3],1.0f);
+        kt.t.x1 = kt.kf.x[0] - w / 2;
+        kt.t.y1 = kt.kf.x[1] - h / 2;
+        kt.t.x2 = kt.kf.x[0] + w / 2;
+        kt.t.y2 = kt.kf.x[1] + h / 2;
+        kt.t.vx = kt.kf.v[0];
+        kt.t.vy = kt.kf.v[1];
+    }
+
+    void mot_tracker::predict_all()
+    {
+        for(size_t i = 0; i < m_tracks.size(); i++)
+        {
+            kf_predict(m_tracks[i].kf);
+            m_tracks[i].t.age++;
+            sync_box(m_tracks[i]);
+        }
+    }
+
+    void mot_tracker::associate(const std::vector<detection>& dets,const std::vector<int32_t>& det_idx,std::vector<int32_t>& track_idx,std::vector<bool>& det_used)
+    {
+        int32_t rows = track_idx.size();
+        int32_t cols = det_idx.size();
+        if(rows == 0 || cols == 0)
+        {
+            return;
+        }
+
+        std::vector<float> cost(rows * cols);
+        for(int32_t r = 0; r < rows; r++)
+        {
+            const track& t = m_tracks[track_idx[r]].t;
+            for(int32_t c = 0; c < cols; c++)
+            {
+                const detection& d = dets[det_idx[c]];
+                float v = iou(t.x1,t.y1,t.x2,t.y2,d.x1,d.y1,d.x2,d.y2);
+                cost[r * cols + c] = (d.class_id == t.class_id && v >= m_param.iou_threshold) ? 1 - v : MOT_NO_MATCH;
+            }
+        }
+
+        std::vector<int32_t> row_to_col;
+        hungarian(cost,rows,cols,row_to_col);
+
+        std::vector<int32_t> unmatched;
+        for(int32_t r = 0; r < rows; r++)
+        {
+            int32_t c = row_to_col[r];
+            if(c < 0 || cost[r * cols + c] >= MOT_NO_MATCH)
+            {
+                unmatched.push_back(track_idx[r]);
+                continue;
+            }
+
+            kalman_track& kt = m_tracks[track_idx[r]];
+            const detection& d = dets[det_idx[c]];
+            kf_update(kt.kf,d);
+            sync_box(kt);
+            kt.t.score = d.score;
+            kt.t.hits++;
+            kt.t.misses = 0;
+            det_used[det_idx[c]] = true;
+        }
+        track_idx.swap(unmatched);
+    }
+
+    const std::vector<track>& mot_tracker::update(const std::vector<detection>& dets)
+    {
+        predict_all();
+        m_since_detect = 0;
+
+        std::vector<int32_t> high,low;
+        for(size_t i = 0; i < dets.size(); i++)
+        {
+            if(dets[i].score >= m_param.high_score)
+            {
+                high.push_back(i);
+            }
+            else if(dets[i].score >= m_param.low_score)
+            {
+                low.push_back(i);
+            }
+        }
+
+        std::vector<int32_t> track_idx;
+        for(size_t i = 0; i < m_tracks.size(); i++)
+        {
+            track_idx.push_back(i);
+        }
+
+        //confident detections first,the weak ones may only rescue the tracks left over
+        std::vector<bool> det_used(dets.size(),false);
+        associate(dets,high,track_idx,det_used);
+        associate(dets,low,track_idx,det_used);
+
+        for(size_t i = 0; i < track_idx.size(); i++)
+        {
+            m_tracks[track_idx[i]].t.misses++;
+        }
+
+        size_t count = m_tracks.size();
+        m_tracks.erase(std::remove_if(m_tracks.begin(),m_tracks.end(),
+                    [this](const kalman_track& kt){return kt.t.misses > m_param.max_age;}),m_tracks.end());
+        bool active = m_tracks.size() != count;
+
+        for(size_t i = 0; i < high.size(); i++)
+        {
+            if(det_used[high[i]])
+            {
+                continue;
+            }
+
+            const detection& d = dets[high[i]];
+            kalman_track kt;
+            memset(&kt,0,sizeof(kt));
+            kt.t.id = m_next_id++;
+            kt.t.class_id = d.class_id;
+            kt.t.score = d.score;
+            kt.t.hits = 1;
+            kf_init(kt.kf,d);
+            sync_box(kt);
+            m_tracks.push_back(kt);
+            active = true;
+        }
+
+        //objects moving,coming or going keep inference on every frame
+        for(size_t i = 0; i < m_tracks.size() && !active; i++)
+        {
+            const track& t = m_tracks[i].t;
+            active = t.hits < m_param.min_hits
+                || t.misses > 0
+                || sqrtf(t.vx * t.vx + t.vy * t.vy) > m_param.static_speed;
+        }
+        m_interval = active ? 1 : std::min(m_interval * 2,m_param.max_interval);
+
+        report();
+        return m_output;
+    }
+
+    const std::vector<track>& mot_tracker::predict()
+    {
+        predict_all();
+        m_since_detect++;
+        report();
+        return m_output;
+    }
+
+    bool mot_tracker::need_detect()
+    {
+        return m_since_detect + 1 >= m_interval;
+    }
+
+    uint32_t mot_tracker::interval()
+    {
+        return m_interval;
+    }
+
+    const std::vector<track>& mot_tracker::tracks()
+    {
+        return m_output;
+    }
+
+    void mot_tracker::report()
+    {
+        m_output.clear();
+        for(size_t i = 0; i < m_tracks.size(); i++)
+        {
+            if(m_tracks[i].t.hits >= m_param.min_hits)
+            {
+                m_output.push_back(m_tracks[i].t);
+            }
+        }
+    }
+
+}}//namespace
@@ -0,0 +1,119 @@
+#ifndef mot_tracker_include_h
+#define mot_tracker_include_h
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+namespace ceanic{namespace tracker{
+
+    typedef struct
+    {
+        float x1;
+        float y1;
+        float x2;
+        float y2;
+        float score;
+        int32_t class_id;
+    }detection;
+
+    typedef struct
+    {
+        uint32_t id;        //stable while the object is tracked,never reused
+        int32_t class_id;
+        float score;        //of the last matched detection
+        float x1;
+        float y1;
+        float x2;
+        float y2;
+        float vx;           //center speed,px per frame
+        float vy;
+        uint32_t hits;      //detect frames with a match
+        uint32_t misses;    //detect frames since the last match
+        uint32_t age;       //frames since the track was born
+    }track;
+
+    typedef struct
+    {
+        float iou_threshold;    //a detection and a predicted box match from this iou on
+        float high_score;       //detections that may start tracks,they are matched first
+        float low_score;        //weaker detections only keep existing tracks alive(bytetrack)
+        uint32_t min_hits;      //matches before a track is reported
+        uint32_t max_age;       //detect frames a track coasts without a match before it is dropped
+        uint32_t max_interval;  //1:detect every frame,N:up to every Nth frame while the scene is static
+        float static_speed;     //px per frame,slower tracks count as static
+    }mot_tracker_param;
+
+    //sort style multi object tracker:a constant velocity kalman filter per track,
+    //iou cost and hungarian assignment between the predicted boxes and the detections.
+    //frames without inference only run the prediction,so boxes keep moving between detections.
+    //not thread safe,one thread feeds it frame by frame
+    class mot_tracker
+    {
+        public:
+            explicit mot_tracker(const mot_tracker_param* param = NULL);
+            virtual ~mot_tracker();
+
+        public:
+            //frame with inference,returns the reported tracks
+            const std::vector<track>& update(const std::vector<detection>& dets);
+
+            //frame without inference,the boxes are extrapolated
+            const std::vector<track>& predict();
+
+            //whether the next frame should run inference
+            bool need_detect();
+
+            //current detect interval in frames,1 while objects move
+            uint32_t interval();
+
+            //reported tracks of the last frame
+            const std::vector<track>& tracks();
+
+            void reset();
+
+            static mot_tracker_param default_param();
+
+            static float iou(float ax1,float ay1,float ax2,float ay2,float bx1,float by1,float bx2,float by2);
+
+            //min cost assignment of a rows x cols matrix(row major),row_to_col[r] is -1 when unassigned
+            static void hungarian(const std::vector<float>& cost,int32_t rows,int32_t cols,std::vector<int32_t>& row_to_col);
+
+        private:
+            //per box coordinate(cx,cy,w,h) a position/velocity filter,the model keeps them independent
+            typedef struct
+            {
+                float x[4];
+                float v[4];
+                float p00[4];
+                float p01[4];
+                float p11[4];
+            }kalman_t;
+
+            typedef struct
+            {
+                track t;
+                kalman_t kf;
+            }kalman_track;
+
+            void kf_init(kalman_t& kf,const detection& det);
+            void kf_predict(kalman_t& kf);
+            void kf_update(kalman_t& kf,const detection& det);
+            void sync_box(kalman_track& kt);
+
+            void predict_all();
+            void associate(const std::vector<detection>& dets,const std::vector<int32_t>& det_idx,std::vector<int32_t>& track_idx,std::vector<bool>& det_used);
+            void report();
+
+        private:
+            mot_tracker_param m_param;
+            std::vector<kalman_track> m_tracks;
+            std::vector<track> m_output;
+            uint32_t m_next_id;
+            uint32_t m_interval;
+            uint32_t m_since_detect;
+    };
+
+}}//namespace
+
+#endif
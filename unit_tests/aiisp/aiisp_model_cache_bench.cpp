@@ -0,0 +1,99 @@
+// Model load cost of an aiisp init:the old fopen/ftell/fread into mmz on every start,
+// a cache miss(one mapped sequential pass) and a cache hit(the copy of a preloaded model).
+// The page cache is warm after the first pass,on the board drop it(echo 3 > /proc/sys/vm/drop_caches)
+// between runs to see the flash read.
+//
+// usage: aiisp_model_cache_bench [model_file] [iterations]
+#include "../../aiisp/aiisp_model_cache.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include <unistd.h>
+
+static uint64_t now_us() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// what aiisp::read_model did before the cache
+static bool legacy_read(const char* path) {
+    FILE* fp = fopen(path, "rb");
+    if (!fp) {
+        return false;
+    }
+    fseek(fp, 0L, SEEK_END);
+    long size = ftell(fp);
+    fseek(fp, 0L, SEEK_SET);
+
+    td_phys_addr_t phys;
+    td_void* virt;
+    if (size <= 0 || ss_mpi_sys_mmz_alloc(&phys, &virt, "aibnr_cfg", NULL, size) != TD_SUCCESS) {
+        fclose(fp);
+        return false;
+    }
+    bool ok = fread(virt, size, 1, fp) == 1;
+    fclose(fp);
+    ss_mpi_sys_mmz_free(phys, virt);
+    return ok;
+}
+
+int main(int argc, char** argv) {
+    std::string path = "/tmp/aiisp_model_cache_bench.bin";
+    bool own_file = true;
+    int iterations = 20;
+    if (argc > 1) {
+        path = argv[1];
+        own_file = false;
+    }
+    if (argc > 2) {
+        iterations = atoi(argv[2]);
+    }
+
+    if (own_file) {
+        // about the size of aibnr_model_detail_priority.bin
+        std::vector<uint8_t> data(1100 * 1024);
+        for (size_t i = 0; i < data.size(); i++) {
+            data[i] = (uint8_t)(i * 2654435761u >> 24);
+        }
+        FILE* f = fopen(path.c_str(), "wb");
+        if (!f) {
+            printf("can not write %s\n", path.c_str());
+            return 1;
+        }
+        fwrite(data.data(), 1, data.size(), f);
+        fclose(f);
+    }
+
+    uint64_t legacy = 0, miss = 0, hit = 0;
+    for (int i = 0; i < iterations; i++) {
+        uint64_t beg = now_us();
+        if (!legacy_read(path.c_str())) {
+            printf("can not read %s\n", path.c_str());
+            return 1;
+        }
+        legacy += now_us() - beg;
+
+        aiisp_model_mem mem;
+        aiisp_model_cache::clear();
+        beg = now_us();
+        aiisp_model_cache::acquire(path.c_str(), &mem);
+        miss += now_us() - beg;
+        aiisp_model_cache::release(mem.virt_addr);
+
+        beg = now_us();
+        aiisp_model_cache::acquire(path.c_str(), &mem);
+        hit += now_us() - beg;
+        aiisp_model_cache::release(mem.virt_addr);
+    }
+    aiisp_model_cache::clear();
+
+    printf("%s,%d iterations\n", path.c_str(), iterations);
+    printf("  fread   %8.1f us\n", (double)legacy / iterations);
+    printf("  miss    %8.1f us\n", (double)miss / iterations);
+    printf("  hit     %8.1f us\n", (double)hit / iterations);
+
+    if (own_file) {
+        unlink(path.c_str());
+    }
+    return 0;
+}
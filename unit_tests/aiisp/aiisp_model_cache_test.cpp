@@ -0,0 +1,202 @@
+#include "../../aiisp/aiisp_model_cache.h"
+#include <iostream>
+#include <string>
+#include <vector>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+// Test helper
+#define TEST_ASSERT(condition, message) \
+    if (!(condition)) { \
+        std::cerr << "FAILED: " << message << std::endl; \
+        return false; \
+    }
+
+#define RUN_TEST(test_func) \
+    std::cout << "Running " << #test_func << "..." << std::endl; \
+    if (test_func()) { \
+        std::cout << "  PASSED" << std::endl; \
+        passed++; \
+    } else { \
+        std::cout << "  FAILED" << std::endl; \
+        failed++; \
+    }
+
+#define MODEL_SIZE (100 * 1024)
+
+// model files of MODEL_SIZE bytes,the content depends on the index
+static std::string model_path(int i) {
+    char path[64];
+    snprintf(path, sizeof(path), "/tmp/aiisp_model_cache_test_%d_%d.bin", (int)getpid(), i);
+    return path;
+}
+
+static std::vector<uint8_t> model_data(int i) {
+    std::vector<uint8_t> data(MODEL_SIZE);
+    for (size_t k = 0; k < data.size(); k++) {
+        data[k] = (uint8_t)(k * 31 + i * 7 + (k >> 9));
+    }
+    return data;
+}
+
+static bool write_models() {
+    for (int i = 0; i < 3; i++) {
+        std::vector<uint8_t> data = model_data(i);
+        FILE* f = fopen(model_path(i).c_str(), "wb");
+        if (!f) {
+            return false;
+        }
+        fwrite(data.data(), 1, data.size(), f);
+        fclose(f);
+    }
+    return true;
+}
+
+static void remove_models() {
+    for (int i = 0; i < 3; i++) {
+        unlink(model_path(i).c_str());
+    }
+}
+
+// every test starts from an empty cache without a budget
+static void reset_cache() {
+    aiisp_model_cache::set_budget(0);
+    aiisp_model_cache::clear();
+}
+
+// one read,the copy is shared and matches the file
+bool test_acquire_shared() {
+    reset_cache();
+    aiisp_model_cache_stat before;
+    aiisp_model_cache::get_stat(&before);
+
+    aiisp_model_mem a, b;
+    TEST_ASSERT(aiisp_model_cache::acquire(model_path(0).c_str(), &a), "first acquire");
+    TEST_ASSERT(aiisp_model_cache::acquire(model_path(0).c_str(), &b), "second acquire");
+    TEST_ASSERT(a.virt_addr == b.virt_addr && a.phys_addr == b.phys_addr, "same mmz copy");
+    TEST_ASSERT(a.size == MODEL_SIZE, "size");
+    std::vector<uint8_t> data = model_data(0);
+    TEST_ASSERT(memcmp(a.virt_addr, data.data(), MODEL_SIZE) == 0, "content");
+
+    aiisp_model_cache_stat stat;
+    aiisp_model_cache::get_stat(&stat);
+    TEST_ASSERT(stat.misses == before.misses + 1 && stat.hits == before.hits + 1, "one miss,one hit");
+    TEST_ASSERT(stat.models == 1 && stat.used == 1 && stat.bytes == MODEL_SIZE, "one resident model");
+
+    aiisp_model_cache::release(a.virt_addr);
+    aiisp_model_cache::release(b.virt_addr);
+    return true;
+}
+
+// a released copy stays for the next acquire,clear frees it
+bool test_release_keeps_resident() {
+    reset_cache();
+    aiisp_model_mem a;
+    TEST_ASSERT(aiisp_model_cache::acquire(model_path(1).c_str(), &a), "acquire");
+    aiisp_model_cache::release(a.virt_addr);
+
+    aiisp_model_cache_stat stat;
+    aiisp_model_cache::get_stat(&stat);
+    TEST_ASSERT(stat.models == 1 && stat.used == 0 && stat.bytes == MODEL_SIZE, "idle but resident");
+
+    aiisp_model_mem b;
+    TEST_ASSERT(aiisp_model_cache::acquire(model_path(1).c_str(), &b), "acquire again");
+    TEST_ASSERT(b.virt_addr == a.virt_addr, "no reload");
+    aiisp_model_cache::clear();
+    aiisp_model_cache::get_stat(&stat);
+    TEST_ASSERT(stat.models == 1, "clear keeps a used copy");
+
+    aiisp_model_cache::release(b.virt_addr);
+    aiisp_model_cache::clear();
+    aiisp_model_cache::get_stat(&stat);
+    TEST_ASSERT(stat.models == 0 && stat.bytes == 0, "clear frees the idle copy");
+    return true;
+}
+
+// the least recently used idle copy makes room first
+bool test_budget_lru() {
+    reset_cache();
+    aiisp_model_cache::set_budget(MODEL_SIZE * 2 + MODEL_SIZE / 2);
+
+    aiisp_model_mem m0, m1, m2;
+    TEST_ASSERT(aiisp_model_cache::preload(model_path(0).c_str()), "preload 0");
+    TEST_ASSERT(aiisp_model_cache::preload(model_path(1).c_str()), "preload 1");
+
+    // touch 0,so 1 is the oldest
+    TEST_ASSERT(aiisp_model_cache::acquire(model_path(0).c_str(), &m0), "acquire 0");
+    aiisp_model_cache::release(m0.virt_addr);
+
+    aiisp_model_cache_stat before;
+    aiisp_model_cache::get_stat(&before);
+    TEST_ASSERT(aiisp_model_cache::acquire(model_path(2).c_str(), &m2), "acquire 2");
+
+    aiisp_model_cache_stat stat;
+    aiisp_model_cache::get_stat(&stat);
+    TEST_ASSERT(stat.evictions == before.evictions + 1 && stat.models == 2, "one eviction");
+
+    aiisp_model_cache::get_stat(&before);
+    TEST_ASSERT(aiisp_model_cache::acquire(model_path(0).c_str(), &m0), "0 still resident");
+    aiisp_model_cache::get_stat(&stat);
+    TEST_ASSERT(stat.hits == before.hits + 1, "hit on 0");
+
+    // 1 was evicted,0 and 2 are used,so it comes back over the budget
+    TEST_ASSERT(aiisp_model_cache::acquire(model_path(1).c_str(), &m1), "1 reloaded over the budget");
+    aiisp_model_cache::get_stat(&stat);
+    TEST_ASSERT(stat.models == 3 && stat.bytes == MODEL_SIZE * 3, "used copies are never evicted");
+    std::vector<uint8_t> data = model_data(1);
+    TEST_ASSERT(memcmp(m1.virt_addr, data.data(), MODEL_SIZE) == 0, "reloaded content");
+
+    // back under the budget once they are released
+    aiisp_model_cache::release(m0.virt_addr);
+    aiisp_model_cache::release(m1.virt_addr);
+    aiisp_model_cache::release(m2.virt_addr);
+    aiisp_model_cache::get_stat(&stat);
+    TEST_ASSERT(stat.bytes <= stat.budget && stat.models == 2, "released down to the budget");
+    return true;
+}
+
+// a preload never goes over the budget,missing files fail
+bool test_preload_budget() {
+    reset_cache();
+    aiisp_model_cache::set_budget(MODEL_SIZE + MODEL_SIZE / 2);
+
+    aiisp_model_mem m0;
+    TEST_ASSERT(aiisp_model_cache::acquire(model_path(0).c_str(), &m0), "acquire 0");
+    TEST_ASSERT(!aiisp_model_cache::preload(model_path(1).c_str()), "no room for 1");
+    TEST_ASSERT(aiisp_model_cache::preload(model_path(0).c_str()), "0 is resident");
+
+    aiisp_model_mem missing;
+    TEST_ASSERT(!aiisp_model_cache::acquire("/tmp/aiisp_model_cache_test_missing.bin", &missing), "missing acquire");
+    TEST_ASSERT(!aiisp_model_cache::preload("/tmp/aiisp_model_cache_test_missing.bin"), "missing preload");
+
+    aiisp_model_cache::release(m0.virt_addr);
+    aiisp_model_cache::release(NULL);
+    aiisp_model_cache::clear();
+    return true;
+}
+
+int main() {
+    int passed = 0;
+    int failed = 0;
+
+    std::cout << "=== aiisp_model_cache Unit Tests ===" << std::endl << std::endl;
+
+    if (!write_models()) {
+        std::cerr << "can not write the model files" << std::endl;
+        return 1;
+    }
+
+    RUN_TEST(test_acquire_shared);
+    RUN_TEST(test_release_keeps_resident);
+    RUN_TEST(test_budget_lru);
+    RUN_TEST(test_preload_budget);
+
+    remove_models();
+
+    std::cout << std::endl << "=== Results ===" << std::endl;
+    std::cout << "Passed: " << passed << std::endl;
+    std::cout << "Failed: " << failed << std::endl;
+
+    return failed > 0 ? 1 : 0;
+}
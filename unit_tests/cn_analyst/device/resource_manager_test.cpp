@@ -233,6 +233,125 @@ bool test_thread_safety() {
     return true;
 }
 
+// A 4MP camera with a main and a sub stream
+static memory_plan_camera make_plan_camera(int32_t id) {
+    memory_plan_camera camera;
+    camera.camera_id = id;
+    camera.sensor_width = 2688;
+    camera.sensor_height = 1520;
+    
+    stream_config main_stream;
+    main_stream.stream_id = 0;
+    main_stream.width = 2688;
+    main_stream.height = 1520;
+    stream_config sub_stream;
+    sub_stream.stream_id = 1;
+    sub_stream.width = 704;
+    sub_stream.height = 576;
+    camera.streams.push_back(main_stream);
+    camera.streams.push_back(sub_stream);
+    return camera;
+}
+
+static const vb_pool_plan* find_pool(const memory_plan& plan, const std::string& user) {
+    for (const auto& pool : plan.pools) {
+        if (std::find(pool.users.begin(), pool.users.end(), user) != pool.users.end()) {
+            return &pool;
+        }
+    }
+    return nullptr;
+}
+
+// Test: One camera, the pools and buffers it needs
+bool test_memory_plan_single() {
+    std::vector<memory_plan_camera> cameras = {make_plan_camera(0)};
+    memory_plan plan;
+    TEST_ASSERT(resource_manager::plan_memory(cameras, plan), "Single camera should fit");
+    TEST_ASSERT(plan.feasible && plan.error.empty(), "Feasible without error");
+    
+    // 12 bit raw and yuv420 of the same sensor come to the same block
+    const vb_pool_plan* raw = find_pool(plan, "camera0/vi_raw");
+    TEST_ASSERT(raw && raw->common && raw->blk_size == 4032ULL * 1520, "12 bit raw block");
+    TEST_ASSERT(raw->blk_size == resource_manager::yuv420_frame_size(2688, 1520), "yuv420 block");
+    TEST_ASSERT(raw == find_pool(plan, "camera0/vi") && raw == find_pool(plan, "camera0/vpss"), "One pool for raw, vi and vpss");
+    TEST_ASSERT(raw->blk_cnt == 3 + 2 + 2 + 2, "raw, vi, vpss depth plus one per venc");
+    TEST_ASSERT(plan.pools.size() == 1, "Nothing else without ai");
+    
+    int venc_bufs = 0;
+    for (const auto& item : plan.mmz) {
+        if (item.name.find("/venc_buf") != std::string::npos) {
+            venc_bufs++;
+        }
+    }
+    TEST_ASSERT(venc_bufs == 2, "One venc buffer per stream");
+    
+    uint64_t sum = 0;
+    for (const auto& pool : plan.pools) {
+        sum += pool.blk_size * pool.blk_cnt;
+    }
+    TEST_ASSERT(sum == plan.vb_bytes && plan.total_bytes == plan.vb_bytes + plan.mmz_bytes, "Totals add up");
+    TEST_ASSERT(resource_manager::format_memory_plan(plan).find("total") != std::string::npos, "Printable map");
+    return true;
+}
+
+// Test: Same sized cameras share common pools, private pools stay apart
+bool test_memory_plan_sharing() {
+    std::vector<memory_plan_camera> cameras = {make_plan_camera(0), make_plan_camera(1)};
+    cameras[0].aiisp_enabled = true;
+    cameras[1].aiisp_enabled = true;
+    cameras[1].yolov5_enabled = true;
+    
+    memory_plan plan;
+    TEST_ASSERT(resource_manager::plan_memory(cameras, plan), "Two cameras should fit");
+    const vb_pool_plan* raw0 = find_pool(plan, "camera0/vi_raw");
+    TEST_ASSERT(raw0 && raw0 == find_pool(plan, "camera1/vi_raw") && raw0->blk_cnt == 18, "Frame pool shared");
+    
+    const vb_pool_plan* bnr0 = find_pool(plan, "camera0/aiisp_bnr");
+    const vb_pool_plan* bnr1 = find_pool(plan, "camera1/aiisp_bnr");
+    TEST_ASSERT(bnr0 && bnr1 && bnr0 != bnr1 && !bnr0->common, "aiisp pools are private");
+    TEST_ASSERT(find_pool(plan, "camera1/yolov5") && !find_pool(plan, "camera0/yolov5"), "yolov5 pool only where enabled");
+    
+    // A block much smaller than the pool does not join it
+    const vb_pool_plan* yolo_vpss = find_pool(plan, "camera1/yolov5_vpss");
+    TEST_ASSERT(yolo_vpss && yolo_vpss != find_pool(plan, "camera1/vpss"), "640x640 frames get their own pool");
+    return true;
+}
+
+// Test: Configs beyond the mmz zone or the common pools are refused
+bool test_memory_plan_infeasible() {
+    resource_limits limits;
+    limits.mmz_bytes = 100ULL * 1024 * 1024;
+    resource_manager::init(limits);
+    
+    std::vector<memory_plan_camera> cameras = {make_plan_camera(0)};
+    memory_plan plan;
+    TEST_ASSERT(resource_manager::plan_memory(cameras, plan), "One camera fits 100MB");
+    cameras.push_back(make_plan_camera(1));
+    cameras[1].sensor_width = 3840;
+    cameras[1].sensor_height = 2160;
+    cameras[1].wdr = true;
+    TEST_ASSERT(!resource_manager::plan_memory(cameras, plan), "An 8MP wdr camera does not");
+    TEST_ASSERT(!plan.feasible && plan.error.find("mmz") != std::string::npos, "Error names the mmz");
+    TEST_ASSERT(plan.total_bytes > limits.mmz_bytes, "Plan still filled");
+    resource_manager::release();
+    
+    limits = resource_limits();
+    limits.max_common_pools = 1;
+    resource_manager::init(limits);
+    cameras.resize(1);
+    TEST_ASSERT(resource_manager::plan_memory(cameras, plan), "One common pool without ai");
+    cameras[0].yolov5_enabled = true;
+    TEST_ASSERT(!resource_manager::plan_memory(cameras, plan), "yolov5 frames need a second common pool");
+    TEST_ASSERT(plan.error.find("common pools") != std::string::npos, "Error names the pools");
+    resource_manager::release();
+    
+    memory_plan_camera no_size;
+    no_size.camera_id = 2;
+    cameras = {no_size};
+    TEST_ASSERT(!resource_manager::plan_memory(cameras, plan), "A camera without any size");
+    return true;
+}
+
 int main() {
     int passed = 0;
     int failed = 0;
@@ -246,6 +365,9 @@ int main() {
     RUN_TEST(test_vi_allocation);
     RUN_TEST(test_status_query);
     RUN_TEST(test_thread_safety);
+    RUN_TEST(test_memory_plan_single);
+    RUN_TEST(test_memory_plan_sharing);
+    RUN_TEST(test_memory_plan_infeasible);
     
     std::cout << std::endl;
     std::cout << "=== Results ===" << std::endl;
@@ -0,0 +1,264 @@
+#include "../../config/config_service.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+
+using namespace ceanic::config;
+
+// Test helper
+#define TEST_ASSERT(condition, message) \
+    if (!(condition)) { \
+        std::cerr << "FAILED: " << message << std::endl; \
+        return false; \
+    }
+
+#define RUN_TEST(test_func) \
+    std::cout << "Running " << #test_func << "..." << std::endl; \
+    if (test_func()) { \
+        std::cout << "  PASSED" << std::endl; \
+        passed++; \
+    } else { \
+        std::cout << "  FAILED" << std::endl; \
+        failed++; \
+    }
+
+// like net_service_t of main.cpp
+typedef struct {
+    int rtsp_port;
+    char playback_dir[64];
+    int rtmp_enable;
+    char rtmp_url[64];
+} net_t;
+
+static const char* g_net_default = R"({
+    "net_service" : {
+        "rtsp" : { "port" : 554, "playback_dir" : "/mnt" },
+        "rtmp" : { "enable" : 0, "url" : "rtmp://192.168.10.97/live/stream1" }
+    }
+})";
+
+static bool copy_str(const Json::Value& v, char* buf, size_t size) {
+    if (!v.isString() || v.asString().size() >= size) {
+        return false;
+    }
+    snprintf(buf, size, "%s", v.asCString());
+    return true;
+}
+
+static bool parse_net(const Json::Value& root, net_t* net) {
+    const Json::Value& node = root["net_service"];
+    net->rtsp_port = node["rtsp"]["port"].asInt();
+    net->rtmp_enable = node["rtmp"]["enable"].asInt();
+    return net->rtsp_port > 0 && net->rtsp_port < 65536
+        && copy_str(node["rtsp"]["playback_dir"], net->playback_dir, sizeof(net->playback_dir))
+        && copy_str(node["rtmp"]["url"], net->rtmp_url, sizeof(net->rtmp_url));
+}
+
+static std::string g_dir;
+
+static std::string path_of(const char* name) {
+    return g_dir + "/" + name;
+}
+
+static void write_file(const std::string& path, const std::string& text) {
+    std::ofstream ofs(path.c_str());
+    ofs << text;
+}
+
+static std::string read_file(const std::string& path) {
+    std::ifstream ifs(path.c_str());
+    return std::string((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+}
+
+static std::string net_text(int port, const char* dir, int rtmp_enable, const char* url) {
+    char buf[512];
+    snprintf(buf, sizeof(buf),
+            "{\"net_service\":{\"rtsp\":{\"port\":%d,\"playback_dir\":\"%s\"},\"rtmp\":{\"enable\":%d,\"url\":\"%s\"}}}",
+            port, dir, rtmp_enable, url);
+    return buf;
+}
+
+template<typename Pred>
+static bool wait_for(Pred pred, int timeout_ms = 2000) {
+    for (int i = 0; i < timeout_ms / 5; i++) {
+        if (pred()) {
+            return true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    return pred();
+}
+
+// the first boot writes the default text as it is and parses it from memory
+bool test_default() {
+    std::string path = path_of("default.json");
+    unlink(path.c_str());
+
+    config_service cs;
+    std::shared_ptr<typed_file<net_t>> net = cs.add<net_t>("net", path.c_str(), g_net_default, parse_net);
+    TEST_ASSERT(net->get()->rtsp_port == 0, "zeroed before the load");
+    TEST_ASSERT(cs.load_all(), "load");
+    TEST_ASSERT(net->get()->rtsp_port == 554 && strcmp(net->get()->playback_dir, "/mnt") == 0, "default values");
+    TEST_ASSERT(read_file(path) == g_net_default, "default text written unchanged");
+
+    write_file(path, net_text(8554, "/data", 1, "rtmp://a/b"));
+    TEST_ASSERT(net->load(), "load the edited file");
+    TEST_ASSERT(net->get()->rtsp_port == 8554 && net->get()->rtmp_enable == 1, "edited values");
+    return true;
+}
+
+// a broken or invalid file is refused,the values stay
+bool test_invalid() {
+    std::string path = path_of("invalid.json");
+    write_file(path, net_text(554, "/mnt", 0, "rtmp://a/b"));
+
+    config_service cs;
+    std::shared_ptr<typed_file<net_t>> net = cs.add<net_t>("net", path.c_str(), g_net_default, parse_net);
+    TEST_ASSERT(net->load(), "load");
+    typed_file<net_t>::value_ptr held = net->get();
+
+    write_file(path, "{\"net_service\":{\"rtsp\":{\"port\":");
+    TEST_ASSERT(!net->load(), "broken json");
+    write_file(path, net_text(70000, "/mnt", 0, "rtmp://a/b"));
+    TEST_ASSERT(!net->load(), "port out of range");
+    write_file(path, net_text(554, "/a/path/far/too/long/for/the/playback/dir/buffer/of/sixty/four/bytes", 0, "x"));
+    TEST_ASSERT(!net->load(), "string too long");
+    write_file(path, "{\"net_service\":{\"rtsp\":{\"port\":\"554\"}}}");
+    TEST_ASSERT(!net->load(), "wrong type");
+    TEST_ASSERT(net->get() == held && held->rtsp_port == 554, "values kept");
+
+    // a file refused at startup falls back to the default text,the file stays as it is
+    config_service cs3;
+    std::shared_ptr<typed_file<net_t>> fresh = cs3.add<net_t>("fresh", path.c_str(), g_net_default, parse_net);
+    TEST_ASSERT(!fresh->load() && fresh->get()->rtsp_port == 0, "refused,still zeroed");
+    TEST_ASSERT(fresh->load_default(), "load default");
+    TEST_ASSERT(fresh->get()->rtsp_port == 554 && strcmp(fresh->get()->playback_dir, "/mnt") == 0, "default values");
+    TEST_ASSERT(read_file(path) == "{\"net_service\":{\"rtsp\":{\"port\":\"554\"}}}", "file not rewritten");
+
+    unlink(path.c_str());
+    config_service cs2;
+    std::shared_ptr<typed_file<net_t>> none = cs2.add<net_t>("none", path.c_str(), NULL, parse_net);
+    TEST_ASSERT(!cs2.load_all(), "missing file without a default");
+    TEST_ASSERT(!none->load_default(), "no default to load");
+    return true;
+}
+
+// a reload calls only the subscribers whose settings changed,
+// an editor's rename is seen like a write in place
+bool test_watch() {
+    std::string path = path_of("watch.json");
+    write_file(path, net_text(554, "/mnt", 0, "rtmp://a/b"));
+
+    config_service cs;
+    std::shared_ptr<typed_file<net_t>> net = cs.add<net_t>("net", path.c_str(), g_net_default, parse_net);
+    std::atomic<int> rtsp_calls(0);
+    std::atomic<int> rtmp_calls(0);
+    std::atomic<int> reloads(0);
+    std::atomic<int> failed(0);
+    std::mutex mu;
+    int last_port = 0;
+
+    net->subscribe("rtsp",
+            [](const net_t& o, const net_t& n) { return o.rtsp_port != n.rtsp_port || strcmp(o.playback_dir, n.playback_dir) != 0; },
+            [&](const net_t&, const net_t& n) { std::lock_guard<std::mutex> lock(mu); last_port = n.rtsp_port; rtsp_calls++; });
+    net->subscribe("rtmp",
+            [](const net_t& o, const net_t& n) { return o.rtmp_enable != n.rtmp_enable || strcmp(o.rtmp_url, n.rtmp_url) != 0; },
+            [&](const net_t&, const net_t&) { rtmp_calls++; });
+    cs.set_observer([&](const reload_result& r) {
+        reloads++;
+        if (!r.ok) {
+            failed++;
+        }
+    });
+
+    TEST_ASSERT(cs.load_all(), "load");
+    TEST_ASSERT(cs.start_watch(), "start watch");
+
+    write_file(path, net_text(8554, "/mnt", 0, "rtmp://a/b"));
+    TEST_ASSERT(wait_for([&] { return rtsp_calls == 1; }), "rtsp told");
+    TEST_ASSERT(rtmp_calls == 0, "rtmp not told");
+    {
+        std::lock_guard<std::mutex> lock(mu);
+        TEST_ASSERT(last_port == 8554, "new port");
+    }
+
+    std::string tmp = path_of(".watch.json.swp");
+    write_file(tmp, net_text(8554, "/mnt", 1, "rtmp://c/d"));
+    TEST_ASSERT(rename(tmp.c_str(), path.c_str()) == 0, "rename");
+    TEST_ASSERT(wait_for([&] { return rtmp_calls == 1; }), "rtmp told after the rename");
+    TEST_ASSERT(rtsp_calls == 1, "rtsp not told again");
+
+    int before = reloads;
+    write_file(path, net_text(8554, "/mnt", 1, "rtmp://c/d"));
+    TEST_ASSERT(wait_for([&] { return reloads > before; }), "same content reloaded");
+    TEST_ASSERT(rtsp_calls == 1 && rtmp_calls == 1, "nobody told about an unchanged file");
+
+    write_file(path, "{ broken");
+    TEST_ASSERT(wait_for([&] { return failed == 1; }), "broken file reported");
+    TEST_ASSERT(net->get()->rtsp_port == 8554 && net->get()->rtmp_enable == 1, "values kept");
+
+    write_file(path_of("other.json"), "{}");
+    cs.stop_watch();
+    TEST_ASSERT(rtsp_calls == 1 && rtmp_calls == 1, "other files ignored");
+    return true;
+}
+
+// several writes in a row make few reloads,never one per event
+bool test_burst() {
+    std::string path = path_of("burst.json");
+    write_file(path, net_text(554, "/mnt", 0, "rtmp://a/b"));
+
+    config_service cs;
+    std::shared_ptr<typed_file<net_t>> net = cs.add<net_t>("net", path.c_str(), g_net_default, parse_net);
+    std::atomic<int> reloads(0);
+    cs.set_observer([&](const reload_result&) { reloads++; });
+    TEST_ASSERT(cs.load_all() && cs.start_watch(), "start");
+
+    for (int i = 0; i < 20; i++) {
+        write_file(path, net_text(1000 + i, "/mnt", 0, "rtmp://a/b"));
+    }
+    TEST_ASSERT(wait_for([&] { return net->get()->rtsp_port == 1019; }), "last write wins");
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    TEST_ASSERT(reloads < 20, "writes coalesced");
+    cs.stop_watch();
+    return true;
+}
+
+int main() {
+    int passed = 0;
+    int failed = 0;
+
+    char tmpl[] = "/tmp/config_service_test.XXXXXX";
+    if (mkdtemp(tmpl) == NULL) {
+        std::cerr << "mkdtemp failed" << std::endl;
+        return 1;
+    }
+    g_dir = tmpl;
+
+    std::cout << "=== config_service Unit Tests ===" << std::endl << std::endl;
+
+    RUN_TEST(test_default);
+    RUN_TEST(test_invalid);
+    RUN_TEST(test_watch);
+    RUN_TEST(test_burst);
+
+    const char* files[] = {"default.json", "invalid.json", "watch.json", "other.json", "burst.json"};
+    for (size_t i = 0; i < sizeof(files) / sizeof(files[0]); i++) {
+        unlink(path_of(files[i]).c_str());
+    }
+    rmdir(g_dir.c_str());
+
+    std::cout << std::endl << "=== Results ===" << std::endl;
+    std::cout << "Passed: " << passed << std::endl;
+    std::cout << "Failed: " << failed << std::endl;
+
+    return failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,216 @@
+// Per frame json output:a detection event(frame,pts,N objects with class,score,box) written and
+// read back N times.Json::Value+FastWriter and Json::Reader against SaxWriter into a reused
+// buffer and PullParser over the text.
+//
+// usage: json_sax_bench [objects per event] [events]
+#include "../../json/json/json.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+using namespace Json;
+
+static uint64_t now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+typedef struct {
+    int id;
+    const char* cls;
+    double score;
+    int box[4];
+} object_t;
+
+static const char* g_classes[] = {"person", "car", "bicycle", "dog"};
+
+static void make_objects(object_t* objs, int n, uint32_t frame) {
+    for (int i = 0; i < n; i++) {
+        objs[i].id = i;
+        objs[i].cls = g_classes[(frame + i) % 4];
+        objs[i].score = 0.5 + ((frame * 7 + i * 13) % 50) / 100.0;
+        objs[i].box[0] = (frame + i * 37) % 1920;
+        objs[i].box[1] = (frame + i * 53) % 1080;
+        objs[i].box[2] = 64 + i;
+        objs[i].box[3] = 128 + i;
+    }
+}
+
+static void write_value(std::string& out, const object_t* objs, int n, uint32_t frame) {
+    Value root;
+    root["frame"] = frame;
+    root["pts"] = (double)frame * 3600;
+    root["type"] = "detection";
+    Value& arr = root["objects"];
+    for (int i = 0; i < n; i++) {
+        Value o;
+        o["id"] = objs[i].id;
+        o["class"] = objs[i].cls;
+        o["score"] = objs[i].score;
+        for (int k = 0; k < 4; k++) {
+            o["box"].append(objs[i].box[k]);
+        }
+        arr.append(o);
+    }
+    FastWriter writer;
+    out = writer.write(root);
+}
+
+static void write_sax(SaxWriter& w, const object_t* objs, int n, uint32_t frame) {
+    w.reset();
+    w.startObject().key("frame").value(frame).key("pts").value((unsigned long long)frame * 3600)
+        .key("type").value("detection").key("objects").startArray();
+    for (int i = 0; i < n; i++) {
+        w.startObject().key("id").value(objs[i].id).key("class").value(objs[i].cls).key("score").value(objs[i].score, 3)
+            .key("box").startArray().value(objs[i].box[0]).value(objs[i].box[1]).value(objs[i].box[2]).value(objs[i].box[3]).endArray()
+            .endObject();
+    }
+    w.endArray().endObject();
+}
+
+// what a consumer does with an event:sum of the scores and the boxes
+static double read_value(const std::string& doc) {
+    Reader reader;
+    Value root;
+    if (!reader.parse(doc, root, false)) {
+        return -1;
+    }
+    double sum = root["frame"].asDouble();
+    const Value& arr = root["objects"];
+    for (Value::UInt i = 0; i < arr.size(); i++) {
+        sum += arr[i]["score"].asDouble();
+        for (Value::UInt k = 0; k < arr[i]["box"].size(); k++) {
+            sum += arr[i]["box"][k].asInt();
+        }
+    }
+    return sum;
+}
+
+static double read_pull(const std::string& doc) {
+    PullParser p(doc.data(), doc.data() + doc.size());
+    double sum = 0;
+    PullParser::TokenType t;
+    bool in_box = false;
+    while ((t = p.next()) != PullParser::tokenEnd) {
+        switch (t) {
+        case PullParser::tokenError:
+            return -1;
+        case PullParser::tokenKey:
+            if (p.isKey("frame") || p.isKey("score")) {
+                p.next();
+                sum += p.asDouble();
+            } else if (p.isKey("box")) {
+                in_box = true;
+            } else if (!p.isKey("objects")) {
+                p.skipValue();
+            }
+            break;
+        case PullParser::tokenNumber:
+            if (in_box) {
+                sum += (double)p.asInt64();
+            }
+            break;
+        case PullParser::tokenArrayEnd:
+            in_box = false;
+            break;
+        default:
+            break;
+        }
+    }
+    return sum;
+}
+
+static void print(const char* name, uint64_t ns, int events, size_t bytes) {
+    printf("  %-28s %8.0f ns/event  %7.1f MB/s\n", name, (double)ns / events, (double)bytes * 1000.0 / ns);
+}
+
+int main(int argc, char** argv) {
+    int n = argc > 1 ? atoi(argv[1]) : 20;
+    int events = argc > 2 ? atoi(argv[2]) : 20000;
+    if (n <= 0 || n > 1000 || events <= 0) {
+        printf("objects 1-1000,events > 0\n");
+        return 1;
+    }
+
+    object_t* objs = new object_t[n];
+    printf("%d events,%d objects each\n", events, n);
+
+    // write
+    std::string doc;
+    size_t value_bytes = 0;
+    uint64_t beg = now_ns();
+    for (int e = 0; e < events; e++) {
+        make_objects(objs, n, e);
+        write_value(doc, objs, n, e);
+        value_bytes += doc.size();
+    }
+    uint64_t value_write_ns = now_ns() - beg;
+
+    std::string buf;
+    SaxWriter w(buf);
+    size_t sax_bytes = 0;
+    beg = now_ns();
+    for (int e = 0; e < events; e++) {
+        make_objects(objs, n, e);
+        write_sax(w, objs, n, e);
+        sax_bytes += buf.size();
+    }
+    uint64_t sax_write_ns = now_ns() - beg;
+
+    printf("write\n");
+    print("Json::Value+FastWriter", value_write_ns, events, value_bytes);
+    print("SaxWriter", sax_write_ns, events, sax_bytes);
+
+    // read,the same text for both
+    make_objects(objs, n, 1);
+    write_sax(w, objs, n, 1);
+    std::string text = buf;
+    double check_value = 0;
+    beg = now_ns();
+    for (int e = 0; e < events; e++) {
+        check_value += read_value(text);
+    }
+    uint64_t value_read_ns = now_ns() - beg;
+
+    double check_pull = 0;
+    beg = now_ns();
+    for (int e = 0; e < events; e++) {
+        check_pull += read_pull(text);
+    }
+    uint64_t pull_read_ns = now_ns() - beg;
+
+    printf("read(%zu bytes)\n", text.size());
+    print("Json::Reader", value_read_ns, events, text.size() * events);
+    print("PullParser", pull_read_ns, events, text.size() * events);
+
+    // round trip:write an event and read it back
+    beg = now_ns();
+    for (int e = 0; e < events; e++) {
+        make_objects(objs, n, e);
+        write_value(doc, objs, n, e);
+        read_value(doc);
+    }
+    uint64_t value_rt_ns = now_ns() - beg;
+
+    beg = now_ns();
+    for (int e = 0; e < events; e++) {
+        make_objects(objs, n, e);
+        write_sax(w, objs, n, e);
+        read_pull(buf);
+    }
+    uint64_t sax_rt_ns = now_ns() - beg;
+
+    printf("round trip\n");
+    print("Json::Value", value_rt_ns, events, value_bytes);
+    print("SaxWriter+PullParser", sax_rt_ns, events, sax_bytes);
+    printf("speedup write %.1fx,read %.1fx,round trip %.1fx\n", (double)value_write_ns / sax_write_ns,
+            (double)value_read_ns / pull_read_ns, (double)value_rt_ns / sax_rt_ns);
+
+    delete[] objs;
+    if (check_value != check_pull) {
+        printf("read results differ:%f %f\n", check_value, check_pull);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,296 @@
+#include "../../json/json/json.h"
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <locale.h>
+#include <string>
+
+using namespace Json;
+
+// Test helper
+#define TEST_ASSERT(condition, message) \
+    if (!(condition)) { \
+        std::cerr << "FAILED: " << message << std::endl; \
+        return false; \
+    }
+
+#define RUN_TEST(test_func) \
+    std::cout << "Running " << #test_func << "..." << std::endl; \
+    if (test_func()) { \
+        std::cout << "  PASSED" << std::endl; \
+        passed++; \
+    } else { \
+        std::cout << "  FAILED" << std::endl; \
+        failed++; \
+    }
+
+static bool parse(const std::string& doc, Value& root) {
+    Reader reader;
+    return reader.parse(doc, root, false);
+}
+
+// commas,colons and nesting come from the writer
+bool test_write_structure() {
+    std::string buf;
+    SaxWriter w(buf);
+    w.startObject()
+        .key("frame").value(42)
+        .key("objects").startArray()
+            .startObject().key("cls").value("person").key("box").startArray().value(1).value(2).value(3).value(4).endArray().endObject()
+            .startObject().key("cls").value("car").key("box").startArray().endArray().endObject()
+        .endArray()
+        .key("empty").startObject().endObject()
+        .key("ok").value(true)
+        .key("none").null()
+    .endObject();
+
+    TEST_ASSERT(w.isComplete(), "complete");
+    TEST_ASSERT(buf == "{\"frame\":42,\"objects\":[{\"cls\":\"person\",\"box\":[1,2,3,4]},{\"cls\":\"car\",\"box\":[]}],"
+            "\"empty\":{},\"ok\":true,\"none\":null}", "output " + buf);
+
+    // the buffer keeps its capacity for the next document
+    size_t capacity = buf.capacity();
+    w.reset();
+    TEST_ASSERT(buf.empty() && buf.capacity() == capacity, "reset keeps the capacity");
+    w.startArray().value(-1).rawValue("{\"a\":1}", 7).endArray();
+    TEST_ASSERT(w.isComplete() && buf == "[-1,{\"a\":1}]", "raw value " + buf);
+    return true;
+}
+
+// calls breaking the structure are refused
+bool test_write_misuse() {
+    std::string buf;
+    SaxWriter w(buf);
+    w.startObject().value(1);
+    TEST_ASSERT(!w.isValid(), "value without a key");
+
+    w.reset();
+    w.startArray().key("a");
+    TEST_ASSERT(!w.isValid(), "key in an array");
+
+    w.reset();
+    w.startObject().endArray();
+    TEST_ASSERT(!w.isValid(), "wrong close");
+
+    w.reset();
+    w.startObject().key("a").endObject();
+    TEST_ASSERT(!w.isValid(), "key without a value");
+
+    w.reset();
+    w.value(1).value(2);
+    TEST_ASSERT(!w.isValid(), "two top level values");
+
+    w.reset();
+    for (int i = 0; i <= SaxWriter::maxDepth; i++) {
+        w.startArray();
+    }
+    TEST_ASSERT(!w.isValid(), "too deep");
+
+    w.reset();
+    w.startObject();
+    TEST_ASSERT(w.isValid() && !w.isComplete(), "open object is not complete");
+    return true;
+}
+
+// every control character,quote and backslash is escaped,utf-8 goes through
+bool test_write_escape() {
+    std::string in;
+    for (int c = 1; c < 0x20; c++) {
+        in += char(c);
+    }
+    in += "\"\\/ 中文 \xf0\x9f\x98\x80";
+    in += '\0';
+    in += "end";
+
+    std::string buf;
+    SaxWriter w(buf);
+    w.startObject().key("k\"ey").value(in).endObject();
+    TEST_ASSERT(buf.find("\\n") != std::string::npos && buf.find("\\u001f") != std::string::npos
+            && buf.find("\\u0000") != std::string::npos && buf.find("\\\"") != std::string::npos, "escapes " + buf);
+    for (size_t i = 0; i < buf.size(); i++) {
+        TEST_ASSERT((unsigned char)buf[i] >= 0x20, "no raw control character");
+    }
+
+    PullParser p(buf.data(), buf.data() + buf.size());
+    TEST_ASSERT(p.next() == PullParser::tokenObjectBegin, "object");
+    TEST_ASSERT(p.next() == PullParser::tokenKey && p.isKey("k\"ey"), "key");
+    TEST_ASSERT(p.next() == PullParser::tokenString && p.asString() == in, "string round trip");
+
+    Value root;
+    TEST_ASSERT(parse(buf, root), "Reader accepts it");
+    return true;
+}
+
+// numbers read back the same,without the locale's decimal point
+bool test_write_numbers() {
+    std::string buf;
+    SaxWriter w(buf);
+    const double values[] = {0.0, 1.0, -1.5, 0.1, 1.0 / 3.0, 3.141592653589793, 1e-300, 1.7976931348623157e308, -2.5e-7, 123456789.125};
+    w.startArray();
+    for (size_t i = 0; i < sizeof(values) / sizeof(values[0]); i++) {
+        w.value(values[i]);
+    }
+    w.value(-9223372036854775807LL - 1).value(18446744073709551615ULL).value(0u);
+    w.value(NAN).value(INFINITY);
+    w.value(0.87654, 3).value(-0.0004, 3).value(2.5, 0).value(-12.3456789, 9);
+    w.endArray();
+    TEST_ASSERT(w.isComplete(), "complete");
+
+    PullParser p(buf.data(), buf.data() + buf.size());
+    TEST_ASSERT(p.next() == PullParser::tokenArrayBegin, "array");
+    for (size_t i = 0; i < sizeof(values) / sizeof(values[0]); i++) {
+        TEST_ASSERT(p.next() == PullParser::tokenNumber && p.asDouble() == values[i], "double " + std::to_string(i) + " in " + buf);
+    }
+    TEST_ASSERT(p.next() == PullParser::tokenNumber && p.isInteger() && p.asInt64() == -9223372036854775807LL - 1, "int64 min");
+    TEST_ASSERT(p.next() == PullParser::tokenNumber && p.asUInt64() == 18446744073709551615ULL, "uint64 max");
+    TEST_ASSERT(p.next() == PullParser::tokenNumber && p.asUInt64() == 0, "zero");
+    TEST_ASSERT(p.next() == PullParser::tokenNull && p.next() == PullParser::tokenNull, "nan and inf are null");
+    TEST_ASSERT(buf.find("0.877,0.000,3,-12.345678900]") != std::string::npos, "fixed decimals,no sign on a rounded zero " + buf);
+
+    // a ',' decimal point locale changes nothing,when one is installed
+    if (setlocale(LC_NUMERIC, "de_DE.UTF-8") || setlocale(LC_NUMERIC, "fr_FR.UTF-8")) {
+        w.reset();
+        w.startArray().value(0.5).value(1.25, 2).endArray();
+        std::string de = buf;
+        PullParser q(de.data(), de.data() + de.size());
+        q.next();
+        bool ok = q.next() == PullParser::tokenNumber && q.asDouble() == 0.5;
+        q.next();
+        ok = ok && q.asDouble() == 1.25;
+        // more digits than the fast path takes go through strtod
+        const char* lng = "1.00000000000000000001";
+        PullParser r(lng, lng + strlen(lng));
+        ok = ok && r.next() == PullParser::tokenNumber && r.asDouble() == 1.0;
+        setlocale(LC_NUMERIC, "C");
+        TEST_ASSERT(de == "[0.5,1.25]", "locale independent output " + de);
+        TEST_ASSERT(ok, "locale independent parsing");
+    } else {
+        std::cout << "  (no de_DE/fr_FR locale,decimal point check skipped)" << std::endl;
+    }
+    return true;
+}
+
+// the tokens of a document,without a tree
+bool test_pull_tokens() {
+    const char* doc = " { \"a\" : [1, -2.5e3, \"x\\u00e9\\ud83d\\ude00\", true, false, null], \"b\" : {\"c\":{}} } ";
+    PullParser p(doc, doc + strlen(doc));
+    PullParser::TokenType expect[] = {
+        PullParser::tokenObjectBegin, PullParser::tokenKey, PullParser::tokenArrayBegin,
+        PullParser::tokenNumber, PullParser::tokenNumber, PullParser::tokenString, PullParser::tokenTrue,
+        PullParser::tokenFalse, PullParser::tokenNull, PullParser::tokenArrayEnd,
+        PullParser::tokenKey, PullParser::tokenObjectBegin, PullParser::tokenKey, PullParser::tokenObjectBegin,
+        PullParser::tokenObjectEnd, PullParser::tokenObjectEnd, PullParser::tokenObjectEnd, PullParser::tokenEnd};
+    int depths[] = {0, 1, 1, 2, 2, 2, 2, 2, 2, 1, 1, 1, 2, 2, 2, 1, 0, 0};
+    for (size_t i = 0; i < sizeof(expect) / sizeof(expect[0]); i++) {
+        PullParser::TokenType t = p.next();
+        TEST_ASSERT(t == expect[i], "token " + std::to_string(i) + " " + p.error());
+        TEST_ASSERT(t == PullParser::tokenEnd || p.depth() == depths[i], "depth of token " + std::to_string(i));
+        if (i == 4) {
+            TEST_ASSERT(!p.isInteger() && p.asDouble() == -2500.0 && p.asInt64() == 0, "-2.5e3");
+        }
+        if (i == 5) {
+            TEST_ASSERT(p.asString() == "x\xc3\xa9\xf0\x9f\x98\x80", "unicode escapes");
+        }
+    }
+    TEST_ASSERT(p.next() == PullParser::tokenEnd, "stays at the end");
+
+    // skip what is not needed
+    const char* ev = "{\"objects\":[{\"a\":[1,[2]]},{}],\"meta\":{\"x\":1},\"frame\":7}";
+    PullParser q(ev, ev + strlen(ev));
+    long long frame = -1;
+    q.next();
+    while (q.next() == PullParser::tokenKey) {
+        if (q.isKey("frame") && q.next() == PullParser::tokenNumber) {
+            frame = q.asInt64();
+        } else {
+            TEST_ASSERT(q.skipValue(), "skip");
+        }
+    }
+    TEST_ASSERT(q.token() == PullParser::tokenObjectEnd && frame == 7, "frame found after skipping");
+    return true;
+}
+
+// malformed documents stop with an error,never read past the end
+bool test_pull_errors() {
+    const char* bad[] = {"", "{", "[1,]", "{\"a\"}", "{\"a\":1,}", "{1:2}", "[1 2]", "\"abc", "tru", "01x", "-",
+        "1.", "1e", "[\"\\x\"]", "[\"\\u12\"]", "[\"\\ud800\"]", "{\"a\":1]", "[1]]", "1 2", "[\"a\nb\"]", "{\"a\" 1}"};
+    for (size_t i = 0; i < sizeof(bad) / sizeof(bad[0]); i++) {
+        const char* doc = bad[i];
+        PullParser p(doc, doc + strlen(doc));
+        int n = 0;
+        PullParser::TokenType t;
+        while ((t = p.next()) != PullParser::tokenError && t != PullParser::tokenEnd && n < 100) {
+            n++;
+        }
+        TEST_ASSERT(t == PullParser::tokenError, std::string("error for ") + doc);
+        TEST_ASSERT(strlen(p.error()) > 0 && p.next() == PullParser::tokenError, std::string("error sticks for ") + doc);
+    }
+
+    std::string deep(PullParser::maxDepth + 1, '[');
+    PullParser p(deep.data(), deep.data() + deep.size());
+    PullParser::TokenType t;
+    while ((t = p.next()) == PullParser::tokenArrayBegin) {
+    }
+    TEST_ASSERT(t == PullParser::tokenError, "too deep");
+
+    // the end pointer is respected,the document needs no terminating 0
+    const char trunc[] = {'[', '1', '2', ']'};
+    PullParser q(trunc, trunc + 2);
+    TEST_ASSERT(q.next() == PullParser::tokenArrayBegin, "begin");
+    TEST_ASSERT(q.next() == PullParser::tokenNumber && q.asInt64() == 1, "1 and not 12");
+    TEST_ASSERT(q.next() == PullParser::tokenError, "truncated");
+    return true;
+}
+
+// the writer and the pull parser agree with Reader/FastWriter on a detection event
+bool test_round_trip() {
+    std::string buf;
+    SaxWriter w(buf);
+    w.startObject().key("frame").value(1234567u).key("pts").value(90000ULL * 3600).key("objects").startArray();
+    for (int i = 0; i < 3; i++) {
+        w.startObject().key("id").value(i).key("class").value("person").key("score").value(0.5 + i * 0.125)
+            .key("box").startArray().value(10 * i).value(20 * i).value(100).value(200).endArray().endObject();
+    }
+    w.endArray().endObject();
+    TEST_ASSERT(w.isComplete(), "complete");
+
+    Value root;
+    TEST_ASSERT(parse(buf, root), "Reader parses it");
+    TEST_ASSERT(root["frame"].asUInt() == 1234567u && root["objects"].size() == 3, "frame and objects");
+    TEST_ASSERT(root["objects"][2u]["score"].asDouble() == 0.75 && root["objects"][1u]["box"][0u].asInt() == 10, "object fields");
+
+    std::string fast = FastWriter().write(root);
+    PullParser p(fast.data(), fast.data() + fast.size());
+    int scores = 0;
+    double sum = 0;
+    PullParser::TokenType t;
+    while ((t = p.next()) != PullParser::tokenEnd && t != PullParser::tokenError) {
+        if (t == PullParser::tokenKey && p.isKey("score") && p.next() == PullParser::tokenNumber) {
+            sum += p.asDouble();
+            scores++;
+        }
+    }
+    TEST_ASSERT(t == PullParser::tokenEnd && scores == 3 && sum == 0.5 + 0.625 + 0.75, "FastWriter output pulled");
+    return true;
+}
+
+int main() {
+    int passed = 0;
+    int failed = 0;
+
+    std::cout << "=== json sax Unit Tests ===" << std::endl << std::endl;
+
+    RUN_TEST(test_write_structure);
+    RUN_TEST(test_write_misuse);
+    RUN_TEST(test_write_escape);
+    RUN_TEST(test_write_numbers);
+    RUN_TEST(test_pull_tokens);
+    RUN_TEST(test_pull_errors);
+    RUN_TEST(test_round_trip);
+
+    std::cout << std::endl << "=== Results ===" << std::endl;
+    std::cout << "Passed: " << passed << std::endl;
+    std::cout << "Failed: " << failed << std::endl;
+
+    return failed > 0 ? 1 : 0;
+}
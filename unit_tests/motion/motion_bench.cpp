@@ -0,0 +1,71 @@
+// Per frame cost of motion_detect on the analysis channel size,scalar kernels against neon.
+// Host builds only have the scalar numbers; build on the board(or any arm64) to get both.
+// The target is a few ms per frame on one A55 core.
+//
+// usage: motion_bench [width] [height] [frames]
+#include "../../motion/motion_detect.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+using namespace ceanic::motion;
+
+// a textured scene with a square moving across it,noise on every frame
+static std::vector<std::vector<uint8_t>> make_frames(uint32_t w, uint32_t h, int count) {
+    std::vector<std::vector<uint8_t>> frames;
+    uint32_t seed = 1;
+    for (int i = 0; i < count; i++) {
+        std::vector<uint8_t> luma(w * h);
+        uint32_t sq_x = (i * 8) % (w > 64 ? w - 64 : 1);
+        for (uint32_t y = 0; y < h; y++) {
+            for (uint32_t x = 0; x < w; x++) {
+                seed = seed * 1103515245 + 12345;
+                int v = 64 + ((x * 7 + y * 13) & 63) + (int)((seed >> 16) % 7) - 3;
+                if (x >= sq_x && x < sq_x + 64 && y >= h / 3 && y < h / 3 + 64) {
+                    v = 230;
+                }
+                luma[y * w + x] = v;
+            }
+        }
+        frames.push_back(luma);
+    }
+    return frames;
+}
+
+static void run(const char* name, uint32_t w, uint32_t h, uint32_t scale, bool neon,
+        const std::vector<std::vector<uint8_t>>& frames, int count) {
+    motion_param param = motion_detect::default_param();
+    param.scale = scale;
+    param.block = 32 / scale;
+    param.use_neon = neon;
+    motion_detect md(w, h, &param);
+
+    uint64_t blocks = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < count; i++) {
+        blocks += md.process(frames[i % frames.size()].data(), w);
+    }
+    auto us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+
+    printf("%-8s scale %u  %ux%u  %6.3f ms/frame  %5.1f%% of a 25fps core  (moving cells %.1f/frame)\n",
+            name, scale, w, h, (double)us / 1000 / count, (double)us / count / 400, (double)blocks / count);
+}
+
+int main(int argc, char** argv) {
+    uint32_t w = argc > 1 ? atoi(argv[1]) : 640;
+    uint32_t h = argc > 2 ? atoi(argv[2]) : 640;
+    int count = argc > 3 ? atoi(argv[3]) : 1000;
+
+    std::vector<std::vector<uint8_t>> frames = make_frames(w, h, 50);
+    printf("motion_detect %ux%u, %d frames, neon %s\n", w, h, count, motion_detect::has_neon() ? "built" : "not built");
+
+    const uint32_t scales[] = {2, 4, 8};
+    for (uint32_t scale : scales) {
+        run("scalar", w, h, scale, false, frames, count);
+        if (motion_detect::has_neon()) {
+            run("neon", w, h, scale, true, frames, count);
+        }
+    }
+    return 0;
+}
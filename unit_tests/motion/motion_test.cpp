@@ -0,0 +1,218 @@
+#include "../../motion/motion_detect.h"
+#include <iostream>
+#include <vector>
+
+using namespace ceanic::motion;
+
+// Test helper
+#define TEST_ASSERT(condition, message) \
+    if (!(condition)) { \
+        std::cerr << "FAILED: " << message << std::endl; \
+        return false; \
+    }
+
+#define RUN_TEST(test_func) \
+    std::cout << "Running " << #test_func << "..." << std::endl; \
+    if (test_func()) { \
+        std::cout << "  PASSED" << std::endl; \
+        passed++; \
+    } else { \
+        std::cout << "  FAILED" << std::endl; \
+        failed++; \
+    }
+
+static uint32_t g_seed = 1;
+
+static int noise(int amp) {
+    g_seed = g_seed * 1103515245 + 12345;
+    return (int)((g_seed >> 16) % (2 * amp + 1)) - amp;
+}
+
+static uint8_t clip(int v) {
+    return v < 0 ? 0 : (v > 255 ? 255 : v);
+}
+
+// textured background,noise,an optional bright square,stride may be wider than the picture
+struct picture {
+    uint32_t w, h, stride;
+    std::vector<uint8_t> luma;
+
+    picture(uint32_t w_, uint32_t h_, uint32_t stride_ = 0)
+        : w(w_), h(h_), stride(stride_ ? stride_ : w_), luma(stride * h_, 0) {}
+
+    void draw(int offset, int amp, int sq_x = -1, int sq_y = -1, int sq_size = 64) {
+        for (uint32_t y = 0; y < h; y++) {
+            for (uint32_t x = 0; x < w; x++) {
+                int v = 64 + ((x * 7 + y * 13) & 63) + offset + noise(amp);
+                if (sq_x >= 0 && (int)x >= sq_x && (int)x < sq_x + sq_size && (int)y >= sq_y && (int)y < sq_y + sq_size) {
+                    v = 230 + noise(amp);
+                }
+                luma[y * stride + x] = clip(v);
+            }
+        }
+    }
+};
+
+// fixed vectors for the kernels,and neon against scalar where it is built
+bool test_kernels() {
+    const uint8_t r0[] = {0, 1, 10, 20, 255, 255, 3, 4};
+    const uint8_t r1[] = {1, 1, 30, 40, 255, 254, 4, 4};
+    uint8_t half[4] = {0};
+    motion_detect::halve_scalar(r0, r1, 8, half);
+    TEST_ASSERT(half[0] == 1 && half[1] == 25 && half[2] == 255 && half[3] == 4, "2x2 rounded average");
+
+    const uint8_t cur[] = {110, 90, 101, 100, 100};
+    uint16_t bg[] = {100 << 7, 100 << 7, 100 << 7, 100 << 7, 12900};
+    uint16_t acc[] = {0, 0, 0, 0, 5};
+    motion_detect::diff_scalar(cur, bg, acc, 5, 4);
+    TEST_ASSERT(acc[0] == 10 && acc[1] == 10 && acc[2] == 1 && acc[3] == 0 && acc[4] == 5, "absolute differences accumulated");
+    TEST_ASSERT(bg[0] == 12880 && bg[1] == 12720 && bg[2] == 12808 && bg[3] == 12800, "background 1/16 of the way");
+    TEST_ASSERT(bg[4] == 12893, "negative steps round down");
+
+#if defined(__ARM_NEON)
+    // odd widths run the scalar tail after the vectors
+    const uint32_t widths[] = {16, 37, 70, 160};
+    for (uint32_t w : widths) {
+        std::vector<uint8_t> a(w), b(w), c(w);
+        std::vector<uint16_t> bg_s(w), bg_n(w), acc_s(w), acc_n(w);
+        for (uint32_t i = 0; i < w; i++) {
+            a[i] = clip(128 + noise(127));
+            b[i] = clip(128 + noise(127));
+            c[i] = clip(128 + noise(127));
+            bg_s[i] = bg_n[i] = clip(128 + noise(127)) << 7 | (noise(63) & 0x7f);
+            acc_s[i] = acc_n[i] = noise(100) + 100;
+        }
+
+        std::vector<uint8_t> hs(w / 2), hn(w / 2);
+        motion_detect::halve_scalar(a.data(), b.data(), w & ~1u, hs.data());
+        motion_detect::halve_neon(a.data(), b.data(), w & ~1u, hn.data());
+        TEST_ASSERT(hs == hn, "halve neon matches scalar");
+
+        for (uint32_t shift = 0; shift <= 8; shift++) {
+            motion_detect::diff_scalar(c.data(), bg_s.data(), acc_s.data(), w, shift);
+            motion_detect::diff_neon(c.data(), bg_n.data(), acc_n.data(), w, shift);
+            TEST_ASSERT(bg_s == bg_n && acc_s == acc_n, "diff neon matches scalar");
+        }
+    }
+    std::cout << "  neon kernels checked" << std::endl;
+#endif
+    return true;
+}
+
+// sensor noise on a static scene is no motion
+bool test_static_noise() {
+    picture pic(640, 640);
+    motion_detect md(640, 640);
+    TEST_ASSERT(md.grid_w() == 20 && md.grid_h() == 20, "32x32 pixel cells");
+
+    for (int i = 0; i < 100; i++) {
+        pic.draw(0, 6);
+        TEST_ASSERT(md.process(pic.luma.data(), pic.stride) == 0, "no moving cell");
+    }
+    motion_event e;
+    TEST_ASSERT(!md.in_motion() && !md.get_event(&e), "no event");
+    return true;
+}
+
+// a moving square starts an event around it,it ends once the square is gone
+bool test_moving_square() {
+    picture pic(640, 640);
+    motion_detect md(640, 640);
+    for (int i = 0; i < 10; i++) {
+        pic.draw(0, 3);
+        md.process(pic.luma.data(), pic.stride);
+    }
+
+    motion_event e;
+    int sq_x = 0;
+    bool started = false;
+    for (int i = 0; i < 20 && !started; i++) {
+        sq_x = 100 + 8 * i;
+        pic.draw(0, 3, sq_x, 200);
+        md.process(pic.luma.data(), pic.stride);
+        started = md.get_event(&e);
+    }
+    TEST_ASSERT(started && e.type == MOTION_EVENT_START, "start event");
+    TEST_ASSERT(e.frame == 10 + 2, "after trigger_frames motion frames");
+    TEST_ASSERT(e.x1 <= (uint32_t)sq_x && e.x2 >= (uint32_t)sq_x + 64, "box covers the square horizontally");
+    TEST_ASSERT(e.y1 <= 200 && e.y2 >= 264 && e.y1 >= 200 - 32 && e.y2 <= 264 + 32, "box hugs the square vertically");
+    TEST_ASSERT(md.in_motion(), "in motion");
+
+    const std::vector<uint8_t>& grid = md.grid();
+    uint32_t gw = md.grid_w();
+    TEST_ASSERT(grid[(232 / 32) * gw + (sq_x + 32) / 32] == 1, "cell under the square moves");
+    TEST_ASSERT(grid[0] == 0 && grid[19 * gw + 19] == 0, "far cells still");
+    TEST_ASSERT(md.level()[(232 / 32) * gw + (sq_x + 32) / 32] > 50, "level of the moving cell");
+
+    // the trail fades into the background,then release_frames later the event ends
+    int frames = 0;
+    bool stopped = false;
+    for (; frames < 300 && !stopped; frames++) {
+        pic.draw(0, 3);
+        md.process(pic.luma.data(), pic.stride);
+        stopped = md.get_event(&e);
+    }
+    TEST_ASSERT(stopped && e.type == MOTION_EVENT_STOP, "stop event");
+    TEST_ASSERT(frames >= 25 && frames < 200, "stops after the trail and release_frames");
+    TEST_ASSERT(!md.in_motion() && !md.get_event(&e), "idle again");
+    return true;
+}
+
+// slow light changes are followed by the background
+bool test_illumination_ramp() {
+    picture pic(640, 640);
+    motion_detect md(640, 640);
+    for (int i = 0; i < 240; i++) {
+        pic.draw(-30 + i / 4, 3);
+        TEST_ASSERT(md.process(pic.luma.data(), pic.stride) == 0, "ramp absorbed");
+    }
+
+    // a light switch is motion everywhere
+    pic.draw(60, 3);
+    TEST_ASSERT(md.process(pic.luma.data(), pic.stride) == 400, "sudden change");
+    return true;
+}
+
+// padded strides and the other scales find the same cells
+bool test_stride_scale() {
+    const uint32_t scales[] = {1, 2, 8};
+    for (uint32_t scale : scales) {
+        motion_param param = motion_detect::default_param();
+        param.scale = scale;
+        param.block = 32 / scale;
+        param.trigger_frames = 1;
+        picture pic(640, 360, 768);
+        motion_detect md(640, 360, &param);
+        TEST_ASSERT(md.grid_w() == 20 && md.grid_h() == 11, "grid of 32x32 pixel cells");
+
+        pic.draw(0, 2);
+        md.process(pic.luma.data(), pic.stride);
+        pic.draw(0, 2, 320, 160);
+        md.process(pic.luma.data(), pic.stride);
+
+        motion_event e;
+        TEST_ASSERT(md.get_event(&e) && e.type == MOTION_EVENT_START, "start event");
+        TEST_ASSERT(e.x1 == 320 && e.y1 == 160 && e.x2 == 384 && e.y2 == 224, "cell aligned square");
+        TEST_ASSERT(md.grid()[5 * 20 + 10] && md.grid()[6 * 20 + 11] && !md.grid()[5 * 20 + 9], "moving cells");
+    }
+    return true;
+}
+
+int main() {
+    int passed = 0;
+    int failed = 0;
+
+    std::cout << "=== motion_detect Unit Tests ===" << std::endl << std::endl;
+
+    RUN_TEST(test_kernels);
+    RUN_TEST(test_static_noise);
+    RUN_TEST(test_moving_square);
+    RUN_TEST(test_illumination_ramp);
+    RUN_TEST(test_stride_scale);
+
+    std::cout << std::endl << "=== Results ===" << std::endl;
+    std::cout << "Passed: " << passed << std::endl;
+    std::cout << "Failed: " << failed << std::endl;
+
+    return failed > 0 ? 1 : 0;
+}
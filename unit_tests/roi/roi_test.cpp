@@ -0,0 +1,198 @@
+#include "../../roi/roi_qp_map.h"
+#include <iostream>
+#include <vector>
+
+using namespace ceanic::roi;
+
+// Test helper
+#define TEST_ASSERT(condition, message) \
+    if (!(condition)) { \
+        std::cerr << "FAILED: " << message << std::endl; \
+        return false; \
+    }
+
+#define RUN_TEST(test_func) \
+    std::cout << "Running " << #test_func << "..." << std::endl; \
+    if (test_func()) { \
+        std::cout << "  PASSED" << std::endl; \
+        passed++; \
+    } else { \
+        std::cout << "  FAILED" << std::endl; \
+        failed++; \
+    }
+
+static roi_box box(float x1, float y1, float x2, float y2, float score = 0.9f) {
+    roi_box b = {x1, y1, x2, y2, score};
+    return b;
+}
+
+static int enabled(const std::vector<roi_region>& regions) {
+    int n = 0;
+    for (size_t i = 0; i < regions.size(); i++) {
+        n += regions[i].enable ? 1 : 0;
+    }
+    return n;
+}
+
+// region covering the point(encoder pixels),the highest index wins like on the encoder
+static const roi_region* region_at(const std::vector<roi_region>& regions, uint32_t x, uint32_t y) {
+    const roi_region* hit = NULL;
+    for (size_t i = 0; i < regions.size(); i++) {
+        const roi_region& r = regions[i];
+        if (r.enable && x >= r.x && x < r.x + r.w && y >= r.y && y < r.y + r.h) {
+            hit = &r;
+        }
+    }
+    return hit;
+}
+
+// 640x640 analysis boxes land on the 1080p picture,aligned and inside it
+bool test_scale_align() {
+    roi_qp_param param = roi_qp_map::default_param();
+    param.margin = 0;
+    roi_qp_map m(640, 640, 1920, 1080, &param);
+    TEST_ASSERT(m.update({box(100, 100, 200, 300)}), "first object changes the map");
+
+    const std::vector<roi_region>& r = m.regions();
+    TEST_ASSERT(r.size() == 8 && enabled(r) == 2, "background and one object");
+    TEST_ASSERT(r[0].index == 0 && r[0].qp == 4 && r[0].x == 0 && r[0].y == 0 && r[0].w == 1920 && r[0].h == 1072,
+            "background covers the aligned picture");
+    TEST_ASSERT(r[1].qp == -4, "object qp");
+    TEST_ASSERT(r[1].x % 16 == 0 && r[1].y % 16 == 0 && r[1].w % 16 == 0 && r[1].h % 16 == 0, "aligned to macroblocks");
+    // 100..200 x 3,100..300 x 1.6875
+    TEST_ASSERT(r[1].x <= 300 && r[1].x + r[1].w >= 600 && r[1].y <= 168 && r[1].y + r[1].h >= 507, "covers the scaled box");
+    TEST_ASSERT(r[1].x + r[1].w <= 600 + 16 && r[1].y + r[1].h <= 507 + 16, "no more than the alignment");
+
+    // boxes over the edge are clipped,weak ones ignored
+    m.reset();
+    m.update({box(600, 600, 700, 700), box(10, 10, 50, 50, 0.1f)});
+    TEST_ASSERT(enabled(r) == 2, "weak detection skipped");
+    TEST_ASSERT(r[1].x + r[1].w == 1920 && r[1].y + r[1].h == 1072, "clipped to the picture");
+
+    // without background the objects start at index 0
+    param.background_qp = 0;
+    roi_qp_map m2(640, 640, 1920, 1080, &param);
+    m2.update({box(100, 100, 200, 300)});
+    TEST_ASSERT(enabled(m2.regions()) == 1 && m2.regions()[0].enable && m2.regions()[0].qp == -4, "object only");
+    return true;
+}
+
+// jitter does not reprogram the encoder,gone objects stay for hold updates
+bool test_hysteresis() {
+    roi_qp_param param = roi_qp_map::default_param();
+    param.hold = 5;
+    roi_qp_map m(640, 640, 1920, 1080, &param);
+    TEST_ASSERT(m.update({box(100, 100, 200, 300)}), "new object");
+
+    int changes = 0;
+    for (int i = 0; i < 50; i++) {
+        float d = (i % 3) - 1.0f;
+        changes += m.update({box(100 + d, 100 - d, 200 + d, 300 - d)}) ? 1 : 0;
+    }
+    TEST_ASSERT(changes == 0, "jittering box keeps the region");
+
+    // moving out grows the region at once
+    TEST_ASSERT(m.update({box(150, 100, 250, 300)}), "grows with the object");
+    const roi_region* r = region_at(m.regions(), 700, 400);
+    TEST_ASSERT(r && r->qp == -4, "new position covered");
+    TEST_ASSERT(region_at(m.regions(), 310, 400)->qp == -4, "old position still covered");
+
+    // it shrinks once the object fills less than half of it
+    TEST_ASSERT(!m.update({box(150, 100, 250, 300)}), "still fits");
+    TEST_ASSERT(m.update({box(160, 150, 200, 200)}), "much smaller object shrinks the region");
+    TEST_ASSERT(region_at(m.regions(), 310, 400)->qp == 4, "left part back to background");
+
+    // lost for hold updates,then dropped
+    for (uint32_t i = 0; i < param.hold; i++) {
+        TEST_ASSERT(!m.update({}), "held while missing");
+        TEST_ASSERT(m.object_count() == 1, "region kept");
+    }
+    TEST_ASSERT(m.update({}), "dropped after hold");
+    TEST_ASSERT(m.object_count() == 0 && enabled(m.regions()) == 1, "background only");
+
+    // a short dropout does not touch the encoder
+    m.update({box(100, 100, 200, 300)});
+    TEST_ASSERT(!m.update({}) && !m.update({}), "dropout held");
+    TEST_ASSERT(!m.update({box(100, 100, 200, 300)}), "back in the same region");
+    return true;
+}
+
+// a crowd never needs more regions than the encoder has
+bool test_cap() {
+    roi_qp_map m(640, 640, 3840, 2160);
+    std::vector<roi_box> boxes;
+    for (int y = 0; y < 4; y++) {
+        for (int x = 0; x < 5; x++) {
+            boxes.push_back(box(20 + x * 120, 20 + y * 150, 60 + x * 120, 100 + y * 150));
+        }
+    }
+    m.update(boxes);
+    const std::vector<roi_region>& r = m.regions();
+    TEST_ASSERT(enabled(r) == 8 && m.object_count() == 7, "capped at the encoder regions");
+
+    for (size_t i = 0; i < boxes.size(); i++) {
+        uint32_t cx = (boxes[i].x1 + boxes[i].x2) / 2 * 6;
+        uint32_t cy = (boxes[i].y1 + boxes[i].y2) / 2 * 3.375f;
+        const roi_region* hit = region_at(r, cx, cy);
+        TEST_ASSERT(hit && hit->qp < 0, "every object inside a merged region");
+    }
+
+    for (size_t i = 1; i < r.size(); i++) {
+        for (size_t j = i + 1; j < r.size(); j++) {
+            bool apart = r[i].x + r[i].w <= r[j].x || r[j].x + r[j].w <= r[i].x
+                || r[i].y + r[i].h <= r[j].y || r[j].y + r[j].h <= r[i].y;
+            TEST_ASSERT(apart, "object regions do not overlap");
+        }
+    }
+
+    // the same crowd again changes nothing
+    TEST_ASSERT(!m.update(boxes), "stable crowd");
+
+    roi_qp_param param = roi_qp_map::default_param();
+    param.max_num = 3;
+    roi_qp_map small(640, 640, 1920, 1080, &param);
+    small.update(boxes);
+    TEST_ASSERT(small.regions().size() == 3 && small.object_count() == 2, "smaller encoders too");
+    return true;
+}
+
+// with roi half of the time,the report compares the two halves
+bool test_ab_report() {
+    roi_ab_report ab(1000);
+    roi_ab_result res;
+    int results = 0;
+    for (uint64_t t = 0; t < 10000; t += 40) {
+        bool on = ab.roi_on(t);
+        ab.add_bytes(on ? 3000 : 5000, t);
+        if (ab.get_result(&res)) {
+            results++;
+            TEST_ASSERT(res.on_kbps == 600 && res.off_kbps == 1000, "bitrates of the halves");
+            TEST_ASSERT(res.saving == 40, "saving percent");
+        }
+    }
+    TEST_ASSERT(results == 4, "one result per finished cycle");
+    TEST_ASSERT(!ab.get_result(&res), "reported once");
+
+    // a long gap starts over
+    ab.add_bytes(100, 60000);
+    TEST_ASSERT(!ab.get_result(&res), "no result across a gap");
+    return true;
+}
+
+int main() {
+    int passed = 0;
+    int failed = 0;
+
+    std::cout << "=== roi_qp_map Unit Tests ===" << std::endl << std::endl;
+
+    RUN_TEST(test_scale_align);
+    RUN_TEST(test_hysteresis);
+    RUN_TEST(test_cap);
+    RUN_TEST(test_ab_report);
+
+    std::cout << std::endl << "=== Results ===" << std::endl;
+    std::cout << "Passed: " << passed << std::endl;
+    std::cout << "Failed: " << failed << std::endl;
+
+    return failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,200 @@
+#include "../../rtsp/stream/stream_playback.h"
+#include "../../stream_save/fmp4_writer.h"
+#include "../../log/ceanic_log.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+using namespace ceanic::rtsp;
+using namespace ceanic::stream_save;
+using namespace ceanic::util;
+
+//the tests do not start the log library
+LOG_HANDLE g_rtsp_log = NULL;
+extern "C" int ceanic_write_log(LOG_HANDLE h,CEANIC_LOG_LEVEL_E level,const char* msg,...)
+{
+    (void)h;
+    (void)level;
+    (void)msg;
+    return 0;
+}
+
+// Test helper
+#define TEST_ASSERT(condition, message) \
+    if (!(condition)) { \
+        std::cerr << "FAILED: " << message << std::endl; \
+        return false; \
+    }
+
+#define RUN_TEST(test_func) \
+    std::cout << "Running " << #test_func << "..." << std::endl; \
+    if (test_func()) { \
+        std::cout << "  PASSED" << std::endl; \
+        passed++; \
+    } else { \
+        std::cout << "  FAILED" << std::endl; \
+        failed++; \
+    }
+
+static const char* TEST_FILE = "/tmp/stream_playback_test.mp4";
+static const char* TEST_INDEX = "/tmp/stream_playback_test.mp4.idx";
+static const uint64_t START_US = 1700000000ULL * 1000000ULL;
+static const int FRAMES = 25;   // 1s at 25fps
+static const int GOP = 5;
+
+static std::vector<uint8_t> make_h264_frame(bool key, size_t payload) {
+    static const uint8_t sps[] = {0, 0, 0, 1, 0x67, 0x4d, 0x00, 0x28, 0x95, 0xa0, 0x1e, 0x00};
+    static const uint8_t pps[] = {0, 0, 0, 1, 0x68, 0xee, 0x3c, 0x80};
+    std::vector<uint8_t> f;
+    if (key) {
+        f.insert(f.end(), sps, sps + sizeof(sps));
+        f.insert(f.end(), pps, pps + sizeof(pps));
+    }
+    f.push_back(0); f.push_back(0); f.push_back(0); f.push_back(1);
+    f.push_back(key ? 0x65 : 0x41);
+    f.insert(f.end(), payload, 0x55);
+    return f;
+}
+
+// h264 with one key frame every GOP frames,40ms of g711 per video frame
+static bool write_file() {
+    media_head mh;
+    memset(&mh, 0, sizeof(mh));
+    mh.video_info.vcode = STREAM_VIDEO_ENCODE_H264;
+    mh.video_info.w = 1920;
+    mh.video_info.h = 1080;
+    mh.video_info.fr = 25;
+    mh.audio_info.acode = STREAM_AUDIO_ENCODE_G711U;
+    mh.audio_info.sample_rate = 8000;
+    mh.audio_info.chn = 1;
+    mh.audio_info.bit_width = 16;
+
+    fmp4_writer w(mh, 1000, 4 * 1024 * 1024);
+    if (!w.open(TEST_FILE)) {
+        return false;
+    }
+    std::vector<uint8_t> pcm(320, 0xff);
+    for (int i = 0; i < FRAMES; i++) {
+        std::vector<uint8_t> f = make_h264_frame(i % GOP == 0, 500);
+        w.write_video(f.data(), f.size(), START_US + (uint64_t)i * 40000, i % GOP == 0);
+        w.write_audio(pcm.data(), pcm.size(), START_US + (uint64_t)i * 40000);
+    }
+    w.close();
+    return true;
+}
+
+// key frames come with the parameter sets ahead,the slice type is in the last nalu
+class playback_observer : public stream_observer {
+public:
+    playback_observer() : keys(0), others(0), audio(0) {}
+
+    void on_stream_come(stream_obj_ptr sob, stream_head* head, const char* buf, int32_t len) override {
+        (void)sob;
+        (void)buf;
+        (void)len;
+        if (head->type == STREAM_AUDIO_FRAME) {
+            audio++;
+            return;
+        }
+        if (head->nalu.size() == 0) {
+            return;
+        }
+        if ((head->nalu[head->nalu.size() - 1].data[4] & 0x1f) == 5) {
+            keys++;
+        } else {
+            others++;
+        }
+    }
+
+    void on_stream_error(stream_obj_ptr sob, int32_t error) override {
+        (void)sob;
+        (void)error;
+    }
+
+    std::atomic<int> keys;
+    std::atomic<int> others;
+    std::atomic<int> audio;
+};
+
+// plays the file at scale until video frames were sent,the wall time it took in ms
+static int64_t play(double scale, int video, std::shared_ptr<playback_observer> ob) {
+    std::shared_ptr<stream_playback> pb = std::make_shared<stream_playback>(TEST_FILE);
+    pb->register_stream_observer(ob);
+    if (!pb->start()) {
+        return -1;
+    }
+
+    auto begin = std::chrono::steady_clock::now();
+    pb->play(0, scale);
+    int64_t ms = 0;
+    while (ms < 5000 && ob->keys + ob->others < video) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - begin).count();
+    }
+    // the audio of the same time is due with the last frame
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    pb->stop();
+    return ms;
+}
+
+// slow motion plays every sample,stretched by the pacing
+bool test_slow_motion() {
+    TEST_ASSERT(write_file(), "write file");
+    std::shared_ptr<playback_observer> ob = std::make_shared<playback_observer>();
+    int64_t ms = play(0.5, FRAMES, ob);
+    std::cout << "  scale 0.5: " << ob->keys << " key," << ob->others << " p," << ob->audio << " audio in " << ms << "ms" << std::endl;
+    TEST_ASSERT(ob->keys == FRAMES / GOP, "every key frame");
+    TEST_ASSERT(ob->others == FRAMES - FRAMES / GOP, "every p frame");
+    TEST_ASSERT(ob->audio == FRAMES, "every audio frame");
+    TEST_ASSERT(ms >= 1800 && ms < 2400, "960ms of media in about twice the time");
+    return true;
+}
+
+// fast forward sends the key frames only
+bool test_fast_forward() {
+    TEST_ASSERT(write_file(), "write file");
+    std::shared_ptr<playback_observer> ob = std::make_shared<playback_observer>();
+    int64_t ms = play(2.0, FRAMES / GOP, ob);
+    std::cout << "  scale 2: " << ob->keys << " key," << ob->others << " p," << ob->audio << " audio in " << ms << "ms" << std::endl;
+    TEST_ASSERT(ob->keys == FRAMES / GOP, "every key frame");
+    TEST_ASSERT(ob->others == 0 && ob->audio == 0, "nothing but key frames");
+    // the last key frame is at 800ms
+    TEST_ASSERT(ms >= 350 && ms < 600, "in about half the time");
+    return true;
+}
+
+// normal speed plays every sample
+bool test_normal_speed() {
+    TEST_ASSERT(write_file(), "write file");
+    std::shared_ptr<playback_observer> ob = std::make_shared<playback_observer>();
+    int64_t ms = play(1.0, FRAMES, ob);
+    TEST_ASSERT(ob->keys == FRAMES / GOP && ob->others == FRAMES - FRAMES / GOP, "every video frame");
+    TEST_ASSERT(ob->audio == FRAMES, "every audio frame");
+    TEST_ASSERT(ms >= 900 && ms < 1300, "in real time");
+    return true;
+}
+
+int main() {
+    int passed = 0;
+    int failed = 0;
+
+    std::cout << "=== RTSP Playback Unit Tests ===" << std::endl;
+
+    RUN_TEST(test_normal_speed);
+    RUN_TEST(test_slow_motion);
+    RUN_TEST(test_fast_forward);
+
+    remove(TEST_FILE);
+    remove(TEST_INDEX);
+
+    std::cout << std::endl;
+    std::cout << "=== Results ===" << std::endl;
+    std::cout << "Passed: " << passed << std::endl;
+    std::cout << "Failed: " << failed << std::endl;
+
+    return (failed == 0) ? 0 : 1;
+}
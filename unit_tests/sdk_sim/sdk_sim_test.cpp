@@ -0,0 +1,1483 @@
+#include "dev_sys.h"
+#include "dev_venc.h"
+#include "dev_vi_sim.h"
+#include "dev_venc_frame.h"
+#include "dev_snap.h"
+#include "ceanic_freetype.h"
+#include "dev_osd.h"
+#include "stream_save/frame_queue.h"
+#include "h264_rtp_serialize.h"
+#include "jpeg_rtp_serialize.h"
+#include "metadata_rtp_serialize.h"
+#include "dev_log.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <condition_variable>
+#include <string>
+#include <sys/stat.h>
+#include <thread>
+#include <vector>
+
+using namespace hisilicon::dev;
+
+//the tests do not start the log library
+LOG_HANDLE g_dev_log = NULL;
+extern "C" int ceanic_write_log(LOG_HANDLE h,CEANIC_LOG_LEVEL_E level,const char* msg,...)
+{
+    (void)h;
+    (void)level;
+    (void)msg;
+    return 0;
+}
+
+// Test helper
+#define TEST_ASSERT(condition, message) \
+    if (!(condition)) { \
+        std::cerr << "FAILED: " << message << std::endl; \
+        return false; \
+    }
+
+#define RUN_TEST(test_func) \
+    std::cout << "Running " << #test_func << "..." << std::endl; \
+    if (test_func()) { \
+        std::cout << "  PASSED" << std::endl; \
+        passed++; \
+    } else { \
+        std::cout << "  FAILED" << std::endl; \
+        failed++; \
+    }
+
+static const char* TEST_DIR = "/tmp/sdk_sim_test";
+static const int GOP = 5;
+static const int GOP_CNT = 3;
+
+static void append_nalu(std::vector<uint8_t>& out, bool long_start, const std::vector<uint8_t>& nalu) {
+    static const uint8_t sc4[4] = {0, 0, 0, 1};
+    out.insert(out.end(), long_start ? sc4 : sc4 + 1, sc4 + 4);
+    out.insert(out.end(), nalu.begin(), nalu.end());
+}
+
+static bool write_file(const std::string& file, const std::vector<uint8_t>& data) {
+    FILE* f = fopen(file.c_str(), "wb");
+    if (!f) {
+        return false;
+    }
+    bool ok = fwrite(data.data(), 1, data.size(), f) == data.size();
+    fclose(f);
+    return ok;
+}
+
+// SPS PPS IDR P P P P ... with mixed 3 and 4 byte start codes, the slices carry
+// first_mb_in_slice == 0 so every slice starts a picture,the last sps byte tells the files apart
+static bool make_h264(const std::string& file, uint8_t sps_tag = 0x11) {
+    std::vector<uint8_t> es;
+    for (int g = 0; g < GOP_CNT; g++) {
+        append_nalu(es, true, {0x67, 0x42, 0x00, 0x1f, sps_tag});
+        append_nalu(es, false, {0x68, 0xce, 0x3c, 0x80});
+        append_nalu(es, true, {0x65, 0x88, 0x84, 0x00, 0x10, 0x20, (uint8_t)g});
+        for (int i = 1; i < GOP; i++) {
+            append_nalu(es, (i & 1) != 0, {0x41, 0x9a, 0x02, (uint8_t)i, (uint8_t)g});
+        }
+    }
+    return write_file(file, es);
+}
+
+// like make_h264 with every picture cut into SLICES slices,a key frame has SLICES + 2 nalus
+static const int SLICES = 10;
+static bool make_h264_slices(const std::string& file) {
+    std::vector<uint8_t> es;
+    for (int g = 0; g < GOP_CNT; g++) {
+        append_nalu(es, true, {0x67, 0x42, 0x00, 0x1f, 0x11});
+        append_nalu(es, true, {0x68, 0xce, 0x3c, 0x80});
+        for (int i = 0; i < GOP; i++) {
+            for (int n = 0; n < SLICES; n++) {
+                // first_mb_in_slice is 0 only in the first slice
+                uint8_t first = n == 0 ? 0x88 : 0x44;
+                append_nalu(es, true, {(uint8_t)(i == 0 ? 0x65 : 0x41), first, (uint8_t)(n + 1), (uint8_t)(i + 1), (uint8_t)(g + 1)});
+            }
+        }
+    }
+    return write_file(file, es);
+}
+
+// VPS SPS PPS IDR_W_RADL TRAIL_R ...
+static bool make_h265(const std::string& file) {
+    std::vector<uint8_t> es;
+    for (int g = 0; g < GOP_CNT; g++) {
+        append_nalu(es, true, {0x40, 0x01, 0x0c, 0x01});
+        append_nalu(es, true, {0x42, 0x01, 0x01, 0x01});
+        append_nalu(es, true, {0x44, 0x01, 0xc1, 0x72});
+        append_nalu(es, true, {0x26, 0x01, 0xaf, 0x09, (uint8_t)g});
+        for (int i = 1; i < GOP; i++) {
+            append_nalu(es, true, {0x02, 0x01, 0xd0, (uint8_t)i, (uint8_t)g});
+        }
+    }
+    return write_file(file, es);
+}
+
+static void prepare_dir() {
+    std::string cmd = std::string("rm -rf ") + TEST_DIR + " && mkdir -p " + TEST_DIR;
+    if (system(cmd.c_str()) != 0) {
+        std::cerr << "prepare dir failed" << std::endl;
+    }
+    setenv("CEANIC_SIM_DIR", TEST_DIR, 1);
+}
+
+static ot_venc_chn_attr make_venc_attr(ot_payload_type type, int w, int h, int fr) {
+    ot_venc_chn_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.venc_attr.type = type;
+    attr.venc_attr.max_pic_width = w;
+    attr.venc_attr.max_pic_height = h;
+    attr.venc_attr.pic_width = w;
+    attr.venc_attr.pic_height = h;
+    attr.venc_attr.buf_size = w * h * 3 / 2;
+    if (type == OT_PT_H265) {
+        attr.rc_attr.rc_mode = OT_VENC_RC_MODE_H265_CBR;
+        attr.rc_attr.h265_cbr.dst_frame_rate = fr;
+    } else {
+        attr.rc_attr.rc_mode = OT_VENC_RC_MODE_H264_CBR;
+        attr.rc_attr.h264_cbr.dst_frame_rate = fr;
+    }
+    return attr;
+}
+
+static int nalu_type(const ot_venc_pack& pack, bool h265) {
+    const uint8_t* p = pack.addr + pack.offset;
+    if (p[0] != 0 || p[1] != 0 || p[2] != 0 || p[3] != 1) {
+        return -1;
+    }
+    return h265 ? ((p[4] >> 1) & 0x3f) : (p[4] & 0x1f);
+}
+
+bool test_vpss_frames() {
+    vi_sim vi(320, 240, 50);
+    TEST_ASSERT(vi.start(), "vi_sim start failed");
+
+    ot_video_frame_info frames[3];
+    uint64_t last_pts = 0;
+    std::vector<uint8_t> first_y;
+    for (int i = 0; i < 3; i++) {
+        td_s32 ret = ss_mpi_vpss_get_chn_frame(vi.vpss_grp(), vi.vpss_chn(), &frames[i], 1000);
+        TEST_ASSERT(ret == TD_SUCCESS, "get_chn_frame failed");
+
+        ot_video_frame& f = frames[i].video_frame;
+        TEST_ASSERT(f.width == 320 && f.height == 240, "frame size");
+        TEST_ASSERT(f.stride[0] == 320 && f.pixel_format == OT_PIXEL_FORMAT_YVU_SEMIPLANAR_420, "frame layout");
+        TEST_ASSERT(((uint8_t*)f.virt_addr[1])[0] == 128, "chroma is neutral");
+        if (i > 0) {
+            TEST_ASSERT(f.pts - last_pts >= 15000 && f.pts - last_pts <= 25000, "frames paced at 50fps");
+        } else {
+            first_y.assign((uint8_t*)f.virt_addr[0], (uint8_t*)f.virt_addr[0] + 320 * 240);
+        }
+        last_pts = f.pts;
+    }
+    TEST_ASSERT(memcmp(first_y.data(), frames[2].video_frame.virt_addr[0], first_y.size()) != 0,
+        "pattern moves between frames");
+
+    // the private pool holds 4 blocks, the channel refuses a 5th frame
+    ot_video_frame_info extra[2];
+    TEST_ASSERT(ss_mpi_vpss_get_chn_frame(vi.vpss_grp(), vi.vpss_chn(), &extra[0], 1000) == TD_SUCCESS, "4th frame");
+    TEST_ASSERT(ss_mpi_vpss_get_chn_frame(vi.vpss_grp(), vi.vpss_chn(), &extra[1], 1000) == OT_ERR_VPSS_NO_BUF,
+        "5th frame must fail while all blocks are held");
+
+    for (int i = 0; i < 3; i++) {
+        ss_mpi_vpss_release_chn_frame(vi.vpss_grp(), vi.vpss_chn(), &frames[i]);
+    }
+    ss_mpi_vpss_release_chn_frame(vi.vpss_grp(), vi.vpss_chn(), &extra[0]);
+
+    TEST_ASSERT(ss_mpi_vpss_get_chn_frame(vi.vpss_grp(), vi.vpss_chn(), &extra[1], 1000) == TD_SUCCESS,
+        "frame after release");
+    ss_mpi_vpss_release_chn_frame(vi.vpss_grp(), vi.vpss_chn(), &extra[1]);
+
+    vi.stop();
+    TEST_ASSERT(ss_mpi_vpss_get_chn_frame(vi.vpss_grp(), vi.vpss_chn(), &extra[0], 0) == OT_ERR_VPSS_UNEXIST,
+        "group is gone after stop");
+    return true;
+}
+
+bool test_vb_user_pool() {
+    ot_vb_pool_cfg cfg;
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.blk_size = 64 * 64 * 3 / 2;
+    cfg.blk_cnt = 1;
+    ot_vb_pool pool = ss_mpi_vb_create_pool(&cfg);
+    TEST_ASSERT(pool != OT_VB_INVALID_POOL_ID, "create pool failed");
+
+    vi_sim vi(64, 64, 30);
+    TEST_ASSERT(vi.start(), "vi_sim start failed");
+    TEST_ASSERT(ss_mpi_vpss_attach_chn_vb_pool(vi.vpss_grp(), vi.vpss_chn(), pool) == OT_ERR_VPSS_NOT_PERM,
+        "attach needs a user vb source");
+    TEST_ASSERT(ss_mpi_vpss_set_chn_vb_src(vi.vpss_grp(), vi.vpss_chn(), OT_VB_SRC_USER) == TD_SUCCESS, "vb src");
+    TEST_ASSERT(ss_mpi_vpss_attach_chn_vb_pool(vi.vpss_grp(), vi.vpss_chn(), pool) == TD_SUCCESS, "attach pool");
+
+    ot_video_frame_info frame;
+    TEST_ASSERT(ss_mpi_vpss_get_chn_frame(vi.vpss_grp(), vi.vpss_chn(), &frame, 1000) == TD_SUCCESS, "get frame");
+    TEST_ASSERT(frame.pool_id == pool, "frame comes from the user pool");
+
+    ot_vb_pool_info info;
+    TEST_ASSERT(ss_mpi_vb_get_pool_info(pool, &info) == TD_SUCCESS, "pool info");
+    TEST_ASSERT(frame.video_frame.phys_addr[0] == info.pool_phy_addr, "frame is the pool's block");
+    TEST_ASSERT(ss_mpi_vb_destroy_pool(pool) == OT_ERR_VB_NOT_PERM, "pool in use must not be destroyed");
+
+    ss_mpi_vpss_release_chn_frame(vi.vpss_grp(), vi.vpss_chn(), &frame);
+    vi.stop();
+    TEST_ASSERT(ss_mpi_vb_destroy_pool(pool) == TD_SUCCESS, "destroy pool");
+    return true;
+}
+
+bool test_venc_replay_h264() {
+    prepare_dir();
+    TEST_ASSERT(make_h264(std::string(TEST_DIR) + "/stream.h264"), "write h264");
+
+    ot_venc_chn chn = 10;
+    ot_venc_chn_attr attr = make_venc_attr(OT_PT_H264, 320, 240, 100);
+    TEST_ASSERT(ss_mpi_venc_create_chn(chn, &attr) == TD_SUCCESS, "create chn");
+    TEST_ASSERT(ss_mpi_venc_create_chn(chn, &attr) == OT_ERR_VENC_EXIST, "create twice");
+    ot_venc_start_param start_param;
+    start_param.recv_pic_num = -1;
+    TEST_ASSERT(ss_mpi_venc_start_chn(chn, &start_param) == TD_SUCCESS, "start chn");
+
+    int fd = ss_mpi_venc_get_fd(chn);
+    TEST_ASSERT(fd >= 0, "venc fd");
+
+    ot_venc_pack packs[8];
+    int key_cnt = 0;
+    uint32_t last_seq = 0;
+    // more than the file holds, the replay loops
+    for (int i = 0; i < GOP * GOP_CNT + GOP; i++) {
+        fd_set fds;
+        FD_ZERO(&fds);
+        FD_SET(fd, &fds);
+        struct timeval tv = {1, 0};
+        TEST_ASSERT(select(fd + 1, &fds, NULL, NULL, &tv) == 1, "fd readable");
+
+        ot_venc_chn_status stat;
+        TEST_ASSERT(ss_mpi_venc_query_status(chn, &stat) == TD_SUCCESS, "query status");
+        TEST_ASSERT(stat.cur_packs == 1 || stat.cur_packs == 3, "packs per frame");
+
+        ot_venc_stream stream;
+        memset(&stream, 0, sizeof(stream));
+        stream.pack = packs;
+        stream.pack_cnt = 1;
+        if (stat.cur_packs == 3) {
+            TEST_ASSERT(ss_mpi_venc_get_stream(chn, &stream, 0) == OT_ERR_VENC_ILLEGAL_PARAM, "pack array too small");
+        }
+        stream.pack_cnt = stat.cur_packs;
+        TEST_ASSERT(ss_mpi_venc_get_stream(chn, &stream, 0) == TD_SUCCESS, "get stream");
+        TEST_ASSERT(i == 0 || stream.seq == last_seq + 1, "seq increases");
+        last_seq = stream.seq;
+
+        if (i == 0) {
+            TEST_ASSERT(stream.pack_cnt == 3, "first frame carries the parameter sets");
+        }
+        if (stream.pack_cnt == 3) {
+            TEST_ASSERT(nalu_type(packs[0], false) == 7 && nalu_type(packs[1], false) == 8, "sps pps");
+            TEST_ASSERT(nalu_type(packs[2], false) == 5, "idr");
+            TEST_ASSERT(packs[1].len == 4 + 4, "3 byte start codes are normalized");
+            key_cnt++;
+        } else {
+            TEST_ASSERT(nalu_type(packs[0], false) == 1, "p slice");
+        }
+        TEST_ASSERT(packs[stream.pack_cnt - 1].is_frame_end == TD_TRUE, "frame end");
+        TEST_ASSERT(ss_mpi_venc_release_stream(chn, &stream) == TD_SUCCESS, "release stream");
+    }
+    TEST_ASSERT(key_cnt == GOP_CNT + 1, "one key frame per gop, looping");
+
+    // an idr request skips the rest of the gop
+    ss_mpi_venc_stop_chn(chn);
+    ot_venc_stream stream;
+    memset(&stream, 0, sizeof(stream));
+    stream.pack = packs;
+    stream.pack_cnt = 8;
+    while (ss_mpi_venc_get_stream(chn, &stream, 0) == TD_SUCCESS) {
+        ss_mpi_venc_release_stream(chn, &stream);
+    }
+    TEST_ASSERT(ss_mpi_venc_start_chn(chn, &start_param) == TD_SUCCESS, "restart chn");
+    TEST_ASSERT(ss_mpi_venc_get_stream(chn, &stream, 1000) == TD_SUCCESS, "get after restart");
+    TEST_ASSERT(stream.pack_cnt == 3, "restart begins with a key frame");
+    ss_mpi_venc_release_stream(chn, &stream);
+    TEST_ASSERT(ss_mpi_venc_get_stream(chn, &stream, 1000) == TD_SUCCESS, "get p frame");
+    TEST_ASSERT(stream.pack_cnt == 1, "p frame");
+    ss_mpi_venc_release_stream(chn, &stream);
+    TEST_ASSERT(ss_mpi_venc_request_idr(chn, TD_TRUE) == TD_SUCCESS, "request idr");
+    stream.pack_cnt = 8;
+    TEST_ASSERT(ss_mpi_venc_get_stream(chn, &stream, 1000) == TD_SUCCESS, "get after idr request");
+    TEST_ASSERT(stream.pack_cnt == 3 && nalu_type(packs[2], false) == 5, "idr follows the request");
+    ss_mpi_venc_release_stream(chn, &stream);
+
+    TEST_ASSERT(ss_mpi_venc_destroy_chn(chn) == TD_SUCCESS, "destroy chn");
+    TEST_ASSERT(ss_mpi_venc_get_fd(chn) == OT_ERR_VENC_UNEXIST, "chn is gone");
+    return true;
+}
+
+bool test_venc_replay_h265() {
+    prepare_dir();
+    // the size specific file wins over stream.h265
+    TEST_ASSERT(make_h265(std::string(TEST_DIR) + "/640x360.h265"), "write h265");
+
+    ot_venc_chn chn = 11;
+    ot_venc_chn_attr attr = make_venc_attr(OT_PT_H265, 320, 240, 100);
+    TEST_ASSERT(ss_mpi_venc_create_chn(chn, &attr) == OT_ERR_VENC_NOT_SUPPORT, "no source for 320x240");
+
+    attr = make_venc_attr(OT_PT_H265, 640, 360, 100);
+    TEST_ASSERT(ss_mpi_venc_create_chn(chn, &attr) == TD_SUCCESS, "create chn");
+    ot_venc_start_param start_param;
+    start_param.recv_pic_num = -1;
+    TEST_ASSERT(ss_mpi_venc_start_chn(chn, &start_param) == TD_SUCCESS, "start chn");
+
+    ot_venc_pack packs[8];
+    ot_venc_stream stream;
+    memset(&stream, 0, sizeof(stream));
+    stream.pack = packs;
+    stream.pack_cnt = 8;
+    TEST_ASSERT(ss_mpi_venc_get_stream(chn, &stream, 1000) == TD_SUCCESS, "get key frame");
+    TEST_ASSERT(stream.pack_cnt == 4, "vps sps pps idr");
+    TEST_ASSERT(nalu_type(packs[0], true) == 32 && nalu_type(packs[3], true) == 19, "h265 nalu types");
+    TEST_ASSERT(packs[3].data_type.h265_type == OT_VENC_H265_NALU_IDR_SLICE, "pack data type");
+    ss_mpi_venc_release_stream(chn, &stream);
+
+    stream.pack_cnt = 8;
+    TEST_ASSERT(ss_mpi_venc_get_stream(chn, &stream, 1000) == TD_SUCCESS, "get p frame");
+    TEST_ASSERT(stream.pack_cnt == 1 && nalu_type(packs[0], true) == 1, "trail_r");
+    ss_mpi_venc_release_stream(chn, &stream);
+
+    ss_mpi_venc_stop_chn(chn);
+    TEST_ASSERT(ss_mpi_venc_destroy_chn(chn) == TD_SUCCESS, "destroy chn");
+    return true;
+}
+
+class count_observer : public ceanic::util::stream_observer {
+public:
+    count_observer() : frames(0), keys(0), bad(0), last_ts(0) {}
+
+    void on_stream_come(ceanic::util::stream_obj_ptr sob, ceanic::util::stream_head* head, const char* buf, int32_t len) override {
+        (void)sob;
+        (void)buf;
+        (void)len;
+        if (head->nalu.size() == 0) {
+            bad++;
+            return;
+        }
+        if ((head->nalu[0].data[4] & 0x1f) == 7) {
+            keys++;
+        }
+        if (head->nalu[0].time_stamp < last_ts) {
+            bad++;
+        }
+        last_ts = head->nalu[0].time_stamp;
+        frames++;
+    }
+
+    void on_stream_error(ceanic::util::stream_obj_ptr sob, int32_t error) override {
+        (void)sob;
+        (void)error;
+        bad++;
+    }
+
+    std::atomic<int> frames;
+    std::atomic<int> keys;
+    std::atomic<int> bad;
+    uint64_t last_ts;
+};
+
+// the unmodified venc capture thread drives the emulated channel
+bool test_venc_capture() {
+    prepare_dir();
+    TEST_ASSERT(make_h264(std::string(TEST_DIR) + "/320x240.h264"), "write h264");
+
+    TEST_ASSERT(sys::init(OT_VI_OFFLINE_VPSS_OFFLINE), "sys init");
+    std::shared_ptr<vi_sim> vi = std::make_shared<vi_sim>(320, 240, 50);
+    TEST_ASSERT(vi->start(), "vi start");
+
+    venc_ptr v = std::make_shared<venc_h264_cbr>(0, 0, 320, 240, 50, 50, vi->vpss_grp(), vi->vpss_chn(), 1024);
+    std::shared_ptr<count_observer> ob = std::make_shared<count_observer>();
+    v->register_stream_observer(ob);
+    TEST_ASSERT(v->start(-1, -1), "venc start");
+    TEST_ASSERT(venc::start_capture(), "start capture");
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+
+    venc::stop_capture();
+    v->stop();
+    vi->stop();
+    sys::release();
+
+    std::cout << "  frames=" << ob->frames << " keys=" << ob->keys << std::endl;
+    TEST_ASSERT(ob->bad == 0, "malformed stream delivered");
+    TEST_ASSERT(ob->frames >= 15 && ob->frames <= 35, "about 25 frames in 500ms at 50fps");
+    TEST_ASSERT(ob->keys >= ob->frames / GOP, "key frames follow the gop");
+    return true;
+}
+
+// detection boxes in the 640x640 analysis picture become roi regions of the channel
+bool test_venc_roi() {
+    prepare_dir();
+    TEST_ASSERT(make_h264(std::string(TEST_DIR) + "/320x240.h264"), "write h264");
+
+    TEST_ASSERT(sys::init(OT_VI_OFFLINE_VPSS_OFFLINE), "sys init");
+    std::shared_ptr<vi_sim> vi = std::make_shared<vi_sim>(320, 240, 50);
+    TEST_ASSERT(vi->start(), "vi start");
+
+    venc_ptr v = std::make_shared<venc_h264_cbr>(0, 0, 320, 240, 50, 50, vi->vpss_grp(), vi->vpss_chn(), 1024);
+    TEST_ASSERT(v->start(-1, -1), "venc start");
+
+    ceanic::roi::roi_qp_param param = ceanic::roi::roi_qp_map::default_param();
+    param.hold = 2;
+    param.max_num = OT_VENC_MAX_ROI_NUM + 1;
+    TEST_ASSERT(!v->start_roi(&param, 640, 640), "more regions than the encoder has");
+    param.max_num = OT_VENC_MAX_ROI_NUM;
+    TEST_ASSERT(v->start_roi(&param, 640, 640), "start roi");
+
+    ceanic::roi::roi_box b = {200, 200, 400, 440, 0.9f};
+    v->update_roi({b});
+    ot_venc_roi_attr attr;
+    TEST_ASSERT(ss_mpi_venc_get_roi_attr(v->venc_chn(), 0, &attr) == TD_SUCCESS, "get roi 0");
+    TEST_ASSERT(attr.enable && attr.qp == 4 && attr.rect.width == 320 && attr.rect.height == 240, "background region");
+    TEST_ASSERT(ss_mpi_venc_get_roi_attr(v->venc_chn(), 1, &attr) == TD_SUCCESS, "get roi 1");
+    TEST_ASSERT(attr.enable && !attr.is_abs_qp && attr.qp == -4, "object region");
+    TEST_ASSERT(attr.rect.x <= 100 && attr.rect.x + (int)attr.rect.width >= 200
+            && attr.rect.y <= 75 && attr.rect.y + (int)attr.rect.height >= 165, "scaled to the channel");
+    TEST_ASSERT(ss_mpi_venc_get_roi_attr(v->venc_chn(), 2, &attr) == TD_SUCCESS && !attr.enable, "unused region off");
+
+    // held for two empty frames,then gone
+    for (int i = 0; i < 3; i++) {
+        v->update_roi({});
+    }
+    ss_mpi_venc_get_roi_attr(v->venc_chn(), 1, &attr);
+    TEST_ASSERT(!attr.enable, "object region dropped");
+
+    // a/b:the regions follow the halves of the period
+    TEST_ASSERT(v->start_roi(&param, 640, 640, 200), "start roi a/b");
+    v->update_roi({b});
+    ss_mpi_venc_get_roi_attr(v->venc_chn(), 1, &attr);
+    TEST_ASSERT(attr.enable, "on half");
+    std::this_thread::sleep_for(std::chrono::milliseconds(250));
+    v->update_roi({b});
+    ss_mpi_venc_get_roi_attr(v->venc_chn(), 1, &attr);
+    TEST_ASSERT(!attr.enable, "off half");
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    v->update_roi({b});
+    ss_mpi_venc_get_roi_attr(v->venc_chn(), 1, &attr);
+    TEST_ASSERT(attr.enable, "on again");
+
+    v->stop_roi();
+    ss_mpi_venc_get_roi_attr(v->venc_chn(), 0, &attr);
+    TEST_ASSERT(!attr.enable, "stop clears the regions");
+
+    v->stop();
+    vi->stop();
+    sys::release();
+    return true;
+}
+
+class rtp_capture : public ceanic::rtsp::rtp_session {
+public:
+    rtp_capture() : packets(0), markers(0), last_marker(false) {}
+
+    bool send_packet(ceanic::rtsp::rtp_packet_t* packet) override {
+        packets++;
+        last_marker = packet->phdr->marker != 0;
+        if (last_marker) {
+            markers++;
+        }
+        return true;
+    }
+
+    int packets;
+    int markers;
+    bool last_marker;
+};
+
+// low latency mode: slices go through the rtp serializer as they come,whole frames follow
+class slice_observer : public ceanic::util::stream_observer {
+public:
+    slice_observer()
+        : rtp(std::make_shared<rtp_capture>()), serialize(96), slices(0), pending(0), frames(0), keys(0), bad(0) {}
+
+    void on_stream_come(ceanic::util::stream_obj_ptr sob, ceanic::util::stream_head* head, const char* buf, int32_t len) override {
+        (void)sob;
+        (void)head;
+        (void)buf;
+        (void)len;
+        // whole frames come through on_frame_come
+        bad++;
+    }
+
+    void on_stream_error(ceanic::util::stream_obj_ptr sob, int32_t error) override {
+        (void)sob;
+        (void)error;
+        bad++;
+    }
+
+    void on_slice_come(ceanic::util::stream_obj_ptr sob, ceanic::util::stream_head* head) override {
+        (void)sob;
+        int markers = rtp->markers;
+        serialize.serialize(*head, NULL, 0, rtp);
+        bool end = !(head->flags & STREAM_FLAG_MORE_SLICES);
+        // the marker is on the last packet of the last slice only
+        if (rtp->markers != markers + (end ? 1 : 0) || rtp->last_marker != end) {
+            bad++;
+        }
+        slices++;
+        pending++;
+    }
+
+    void on_frame_come(ceanic::util::stream_obj_ptr sob, ceanic::util::stream_frame_ptr frame) override {
+        (void)sob;
+        ceanic::util::stream_head* head = frame->head();
+        bool key = (head->nalu[0].data[4] & 0x1f) == 7;
+        uint32_t expect = key ? SLICES + 2 : SLICES;
+        std::shared_ptr<venc_au_frame> au = std::dynamic_pointer_cast<venc_au_frame>(frame);
+        if (!(head->flags & STREAM_FLAG_SLICE_SENT) || head->nalu.size() != expect
+                || !au || (int)au->slice_count() != pending) {
+            bad++;
+        }
+        for (uint32_t i = 1; i < head->nalu.size(); i++) {
+            if (head->nalu[i].time_stamp != head->nalu[0].time_stamp) {
+                bad++;
+            }
+        }
+        keys += key ? 1 : 0;
+        pending = 0;
+        frames++;
+    }
+
+    std::shared_ptr<rtp_capture> rtp;
+    ceanic::rtsp::h264_rtp_serialize serialize;
+    std::atomic<int> slices;
+    std::atomic<int> pending;
+    std::atomic<int> frames;
+    std::atomic<int> keys;
+    std::atomic<int> bad;
+};
+
+bool test_venc_slice_mode() {
+    prepare_dir();
+    TEST_ASSERT(make_h264_slices(std::string(TEST_DIR) + "/320x240.h264"), "write h264");
+
+    TEST_ASSERT(sys::init(OT_VI_OFFLINE_VPSS_OFFLINE), "sys init");
+    std::shared_ptr<vi_sim> vi = std::make_shared<vi_sim>(320, 240, 50);
+    TEST_ASSERT(vi->start(), "vi start");
+
+    venc_ptr v = std::make_shared<venc_h264_cbr>(0, 0, 320, 240, 50, 50, vi->vpss_grp(), vi->vpss_chn(), 1024);
+    std::shared_ptr<slice_observer> ob = std::make_shared<slice_observer>();
+    v->register_stream_observer(ob);
+    v->set_slice_lines(1);
+    TEST_ASSERT(v->start(-1, -1), "venc start");
+
+    ot_venc_slice_split split;
+    TEST_ASSERT(ss_mpi_venc_get_slice_split(v->venc_chn(), &split) == TD_SUCCESS, "get slice split");
+    TEST_ASSERT(split.enable && split.split_size == 1, "slice split set");
+    TEST_ASSERT(venc::start_capture(), "start capture");
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+
+    venc::stop_capture();
+    v->stop();
+    vi->stop();
+    sys::release();
+
+    std::cout << "  slices=" << ob->slices << " frames=" << ob->frames << " keys=" << ob->keys
+              << " rtp=" << ob->rtp->packets << std::endl;
+    TEST_ASSERT(ob->bad == 0, "malformed slice or frame delivered");
+    TEST_ASSERT(ob->frames >= 8, "frames assembled from slices");
+    TEST_ASSERT(ob->keys >= 1, "key frame with more nalus than the inline list");
+    TEST_ASSERT(ob->slices >= ob->frames * SLICES, "every slice posted");
+    TEST_ASSERT(ob->rtp->markers == ob->slices / SLICES, "one marker per frame");
+    return true;
+}
+
+bool test_venc_jpeg_snap() {
+    prepare_dir();
+    ot_venc_chn chn = 12;
+    ot_venc_chn_attr attr = make_venc_attr(OT_PT_JPEG, 320, 240, 0);
+    TEST_ASSERT(ss_mpi_venc_create_chn(chn, &attr) == TD_SUCCESS, "jpeg chn needs no source until snap");
+    ot_venc_start_param start_param;
+    start_param.recv_pic_num = -1;
+    TEST_ASSERT(ss_mpi_venc_start_chn(chn, &start_param) == TD_SUCCESS, "start chn");
+
+    ot_video_frame_info frame;
+    memset(&frame, 0, sizeof(frame));
+    frame.video_frame.pts = 1234;
+    TEST_ASSERT(ss_mpi_venc_send_frame(chn, &frame, 1000) == OT_ERR_VENC_NOT_SUPPORT, "no snap.jpg yet");
+
+    std::vector<uint8_t> jpg = {0xff, 0xd8, 0xff, 0xe0, 0x00, 0x10, 0xff, 0xd9};
+    TEST_ASSERT(write_file(std::string(TEST_DIR) + "/snap.jpg", jpg), "write jpg");
+    TEST_ASSERT(ss_mpi_venc_send_frame(chn, &frame, 1000) == TD_SUCCESS, "send frame");
+
+    ot_venc_jpeg_param param;
+    TEST_ASSERT(ss_mpi_venc_get_jpeg_param(chn, &param) == TD_SUCCESS, "get jpeg param");
+    param.qfactor = 60;
+    TEST_ASSERT(ss_mpi_venc_set_jpeg_param(chn, &param) == TD_SUCCESS, "set jpeg param");
+    param.qfactor = 0;
+    TEST_ASSERT(ss_mpi_venc_get_jpeg_param(chn, &param) == TD_SUCCESS && param.qfactor == 60, "qfactor stored");
+
+    ot_venc_pack pack;
+    ot_venc_stream stream;
+    memset(&stream, 0, sizeof(stream));
+    stream.pack = &pack;
+    stream.pack_cnt = 1;
+    TEST_ASSERT(ss_mpi_venc_get_stream(chn, &stream, 1000) == TD_SUCCESS, "get jpeg");
+    TEST_ASSERT(pack.len == jpg.size() && memcmp(pack.addr, jpg.data(), jpg.size()) == 0, "jpeg bytes");
+    TEST_ASSERT(pack.pts == 1234, "jpeg keeps the frame pts");
+    ss_mpi_venc_release_stream(chn, &stream);
+    TEST_ASSERT(ss_mpi_venc_get_stream(chn, &stream, 0) == OT_ERR_VENC_BUF_EMPTY, "one picture per frame");
+
+    ss_mpi_venc_stop_chn(chn);
+    ss_mpi_venc_destroy_chn(chn);
+    return true;
+}
+
+// baseline 4:2:0 jpeg with restart markers,interval sizes in bytes
+static std::vector<uint8_t> make_jpeg(int w, int h, uint8_t sof, uint8_t luma_sampling, const std::vector<int>& intervals) {
+    std::vector<uint8_t> jpg = {0xff, 0xd8};
+    jpg.insert(jpg.end(), {0xff, 0xdb, 0x00, 0x84});
+    for (int t = 0; t < 2; t++) {
+        jpg.push_back(t);
+        for (int i = 0; i < 64; i++) {
+            jpg.push_back(t * 64 + i + 1);
+        }
+    }
+    jpg.insert(jpg.end(), {0xff, sof, 0x00, 0x11, 0x08, (uint8_t)(h >> 8), (uint8_t)h, (uint8_t)(w >> 8), (uint8_t)w, 0x03,
+            0x01, luma_sampling, 0x00, 0x02, 0x11, 0x01, 0x03, 0x11, 0x01});
+    if (intervals.size() > 1) {
+        jpg.insert(jpg.end(), {0xff, 0xdd, 0x00, 0x04, 0x00, 0x0a});
+    }
+    jpg.insert(jpg.end(), {0xff, 0xda, 0x00, 0x0c, 0x03, 0x01, 0x00, 0x02, 0x11, 0x03, 0x11, 0x00, 0x3f, 0x00});
+    for (size_t i = 0; i < intervals.size(); i++) {
+        for (int j = 0; j < intervals[i]; j++) {
+            jpg.push_back((i * 7 + j) & 0x7f);
+        }
+        if (i + 1 < intervals.size()) {
+            jpg.push_back(0xff);
+            jpg.push_back(0xd0 + (i & 7));
+        }
+    }
+    jpg.push_back(0xff);
+    jpg.push_back(0xd9);
+    return jpg;
+}
+
+// keeps the rfc2435 payload of every packet
+class jpeg_capture : public ceanic::rtsp::rtp_session {
+public:
+    bool send_packet(ceanic::rtsp::rtp_packet_t* packet) override {
+        std::vector<uint8_t> payload(packet->_inter_buf + TCP_TAG_SIZE + sizeof(ceanic::rtsp::RTP_FIXED_HEADER),
+                packet->_inter_buf + packet->_inter_len);
+        for (int i = 0; i < packet->outside_cnt; i++) {
+            payload.insert(payload.end(), packet->outside_info[i].data, packet->outside_info[i].data + packet->outside_info[i].len);
+        }
+        payloads.push_back(payload);
+        markers.push_back(packet->phdr->marker != 0);
+        sizes.push_back(packet->rtp_data_len);
+        timestamps.push_back(ntohl(packet->phdr->timestamp));
+        return true;
+    }
+
+    std::vector<std::vector<uint8_t>> payloads;
+    std::vector<bool> markers;
+    std::vector<uint32_t> sizes;
+    std::vector<uint32_t> timestamps;
+};
+
+static bool send_jpeg(ceanic::rtsp::jpeg_rtp_serialize& serialize, std::shared_ptr<jpeg_capture> rtp, std::vector<uint8_t>& jpg, size_t split) {
+    ceanic::util::stream_head head;
+    head.type = STREAM_MJPEG_FRAME;
+    head.nalu.push_back(jpg.data(), split, 1000);
+    if (split < jpg.size()) {
+        head.nalu.push_back(jpg.data() + split, jpg.size() - split, 1000);
+    }
+    return serialize.serialize(head, NULL, 0, rtp);
+}
+
+// packets are cut at the restart markers and put back together into the scan
+bool test_jpeg_rtp_payload() {
+    std::vector<int> intervals = {300, 300, 300, 300, 300, 3000, 200, 200, 500, 100};
+    std::vector<uint8_t> jpg = make_jpeg(320, 240, 0xc0, 0x22, intervals);
+
+    ceanic::rtsp::jpeg_rtp_serialize::jpeg_info_t info;
+    TEST_ASSERT(ceanic::rtsp::jpeg_rtp_serialize::parse(jpg.data(), jpg.size(), &info), "parse jpeg");
+    TEST_ASSERT(info.type == 65 && info.w == 320 && info.h == 240 && info.restart_interval == 10, "type 1 with restart");
+    TEST_ASSERT(info.qt_len[0] == 64 && info.qt_len[1] == 64 && info.qt[1][0] == 65, "luma and chroma tables");
+    TEST_ASSERT(info.restarts.size() == intervals.size(), "restart intervals found");
+    std::vector<uint8_t> scan(info.scan, info.scan + info.scan_len);
+
+    ceanic::rtsp::jpeg_rtp_serialize serialize;
+    std::shared_ptr<jpeg_capture> rtp = std::make_shared<jpeg_capture>();
+    //the packs of one picture are joined before the markers are walked
+    TEST_ASSERT(send_jpeg(serialize, rtp, jpg, jpg.size() / 2), "serialize jpeg");
+
+    std::vector<uint8_t> out(scan.size(), 0);
+    uint32_t covered = 0;
+    for (size_t i = 0; i < rtp->payloads.size(); i++) {
+        const std::vector<uint8_t>& p = rtp->payloads[i];
+        TEST_ASSERT(rtp->sizes[i] <= MAX_PACKET_LEN, "packet fits the mtu");
+        TEST_ASSERT(rtp->markers[i] == (i + 1 == rtp->payloads.size()), "marker on the last packet only");
+        uint32_t offset = (p[1] << 16) | (p[2] << 8) | p[3];
+        TEST_ASSERT(p[4] == 65 && p[5] == 255 && p[6] == 40 && p[7] == 30, "main header");
+        TEST_ASSERT(((p[8] << 8) | p[9]) == 10, "restart interval");
+        bool first = p[10] & 0x80;
+        bool last = p[10] & 0x40;
+        uint16_t count = ((p[10] & 0x3f) << 8) | p[11];
+        size_t pos = 12;
+        if (offset == 0) {
+            TEST_ASSERT(p[12] == 0 && p[13] == 0 && ((p[14] << 8) | p[15]) == 128, "quantization table header");
+            TEST_ASSERT(memcmp(&p[16], info.qt[0], 64) == 0 && memcmp(&p[80], info.qt[1], 64) == 0, "tables in band");
+            pos = 16 + 128;
+        }
+        uint32_t len = p.size() - pos;
+        TEST_ASSERT(offset == covered && offset + len <= scan.size(), "fragments in order");
+        memcpy(&out[offset], &p[pos], len);
+        covered += len;
+
+        TEST_ASSERT(count < info.restarts.size(), "restart count in range");
+        uint32_t beg = info.restarts[count];
+        uint32_t end = count + 1u < info.restarts.size() ? info.restarts[count + 1] : scan.size();
+        TEST_ASSERT(first == (offset == beg), "first bit at the start of an interval");
+        if (first && last) {
+            //whole intervals,the packet ends where an interval ends
+            bool aligned = offset + len == scan.size();
+            for (size_t r = count + 1; r < info.restarts.size(); r++) {
+                aligned = aligned || info.restarts[r] == offset + len;
+            }
+            TEST_ASSERT(aligned, "whole intervals per packet");
+        } else {
+            TEST_ASSERT(offset >= beg && offset + len <= end, "fragment within its interval");
+            TEST_ASSERT(last == (offset + len == end), "last bit at the end of an interval");
+        }
+    }
+    std::cout << "  packets=" << rtp->payloads.size() << std::endl;
+    TEST_ASSERT(covered == scan.size() && out == scan, "scan put back together");
+    TEST_ASSERT(rtp->payloads.size() < 10, "small intervals share packets");
+
+    //no restart markers,type 0 cut by size
+    std::vector<uint8_t> plain = make_jpeg(640, 480, 0xc0, 0x21, {5000});
+    std::shared_ptr<jpeg_capture> rtp2 = std::make_shared<jpeg_capture>();
+    TEST_ASSERT(send_jpeg(serialize, rtp2, plain, plain.size()), "serialize plain jpeg");
+    TEST_ASSERT(rtp2->payloads.size() == 4 && rtp2->payloads[0][4] == 0 && rtp2->payloads[0][6] == 80, "type 0 packets");
+    TEST_ASSERT(rtp2->markers.back(), "marker ends the picture");
+
+    std::vector<uint8_t> progressive = make_jpeg(320, 240, 0xc2, 0x22, {1000});
+    TEST_ASSERT(!ceanic::rtsp::jpeg_rtp_serialize::parse(progressive.data(), progressive.size(), &info), "progressive refused");
+    std::vector<uint8_t> yuv444 = make_jpeg(320, 240, 0xc0, 0x11, {1000});
+    TEST_ASSERT(!ceanic::rtsp::jpeg_rtp_serialize::parse(yuv444.data(), yuv444.size(), &info), "4:4:4 refused");
+    std::vector<uint8_t> wide = make_jpeg(2048, 240, 0xc0, 0x21, {1000});
+    TEST_ASSERT(!send_jpeg(serialize, rtp2, wide, wide.size()), "wider than 2040 refused");
+    return true;
+}
+
+// one xml document per frame,split over packets and stamped like the video of that frame
+bool test_metadata_rtp_payload() {
+    std::string xml = "<?xml version=\"1.0\" encoding=\"UTF-8\"?><tt:MetadataStream xmlns:tt=\"http://www.onvif.org/ver10/schema\">"
+        "<tt:VideoAnalytics><tt:Frame UtcTime=\"2026-10-19T08:00:00.000Z\">";
+    while (xml.size() < 3000) {
+        xml += "<tt:Object ObjectId=\"0\"><tt:Appearance><tt:Shape><tt:BoundingBox left=\"10\" top=\"20\" right=\"30\" bottom=\"40\"/>"
+            "</tt:Shape></tt:Appearance></tt:Object>";
+    }
+    xml += "</tt:Frame></tt:VideoAnalytics></tt:MetadataStream>";
+
+    ceanic::util::stream_head head;
+    head.type = STREAM_META_FRAME;
+    head.time_stamp = 123456;
+
+    ceanic::rtsp::metadata_rtp_serialize serialize;
+    std::shared_ptr<jpeg_capture> rtp = std::make_shared<jpeg_capture>();
+    TEST_ASSERT(serialize.serialize(head, xml.c_str(), xml.size(), rtp), "serialize metadata");
+    TEST_ASSERT(rtp->payloads.size() == (xml.size() + MAX_PACKET_LEN - 13) / (MAX_PACKET_LEN - 12), "fragments of the document");
+
+    std::string out;
+    for (size_t i = 0; i < rtp->payloads.size(); i++) {
+        TEST_ASSERT(rtp->sizes[i] <= MAX_PACKET_LEN, "packet fits the mtu");
+        TEST_ASSERT(rtp->markers[i] == (i + 1 == rtp->payloads.size()), "marker ends the document");
+        TEST_ASSERT(rtp->timestamps[i] == 123456u * 90, "90khz timestamp of the frame");
+        out.append(rtp->payloads[i].begin(), rtp->payloads[i].end());
+    }
+    TEST_ASSERT(out == xml, "document put back together");
+
+    //the video packets of the same frame carry the same timestamp
+    std::vector<uint8_t> idr = {0, 0, 0, 1, 0x65, 0x88, 0x84, 0x00};
+    ceanic::util::stream_head vhead;
+    vhead.type = STREAM_NALU_SLICE;
+    vhead.nalu.push_back(idr.data(), idr.size(), 123456);
+    ceanic::rtsp::h264_rtp_serialize video(96);
+    std::shared_ptr<jpeg_capture> vrtp = std::make_shared<jpeg_capture>();
+    TEST_ASSERT(video.serialize(vhead, NULL, 0, vrtp), "serialize video");
+    TEST_ASSERT(!vrtp->timestamps.empty() && vrtp->timestamps[0] == rtp->timestamps[0], "metadata lines up with the video");
+
+    head.type = STREAM_I_FRAME;
+    TEST_ASSERT(!serialize.serialize(head, xml.c_str(), xml.size(), rtp), "video heads refused");
+    return true;
+}
+
+class mjpeg_observer : public ceanic::util::stream_observer {
+public:
+    mjpeg_observer() : rtp(std::make_shared<jpeg_capture>()), frames(0), bad(0) {}
+
+    void on_stream_come(ceanic::util::stream_obj_ptr sob, ceanic::util::stream_head* head, const char* buf, int32_t len) override {
+        (void)sob;
+        if (head->type != STREAM_MJPEG_FRAME || !serialize.serialize(*head, buf, len, rtp)) {
+            bad++;
+            return;
+        }
+        frames++;
+    }
+
+    void on_stream_error(ceanic::util::stream_obj_ptr sob, int32_t error) override {
+        (void)sob;
+        (void)error;
+        bad++;
+    }
+
+    std::shared_ptr<jpeg_capture> rtp;
+    ceanic::rtsp::jpeg_rtp_serialize serialize;
+    std::atomic<int> frames;
+    std::atomic<int> bad;
+};
+
+// the jpeg stream runs at its own low rate next to the vi frame rate
+bool test_venc_mjpeg() {
+    prepare_dir();
+    std::vector<uint8_t> jpg = make_jpeg(320, 240, 0xc0, 0x22, {400, 400, 400});
+    TEST_ASSERT(write_file(std::string(TEST_DIR) + "/320x240.jpg", jpg), "write jpg");
+
+    TEST_ASSERT(sys::init(OT_VI_OFFLINE_VPSS_OFFLINE), "sys init");
+    std::shared_ptr<vi_sim> vi = std::make_shared<vi_sim>(320, 240, 50);
+    TEST_ASSERT(vi->start(), "vi start");
+
+    venc_ptr v = std::make_shared<venc_mjpeg>(0, 3, 320, 240, 50, 10, vi->vpss_grp(), vi->vpss_chn(), 60);
+    std::shared_ptr<mjpeg_observer> ob = std::make_shared<mjpeg_observer>();
+    v->register_stream_observer(ob);
+    TEST_ASSERT(v->start(-1, -1), "venc start");
+    TEST_ASSERT(venc::start_capture(), "start capture");
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+
+    venc::stop_capture();
+    v->stop();
+    vi->stop();
+    sys::release();
+
+    int markers = 0;
+    for (size_t i = 0; i < ob->rtp->markers.size(); i++) {
+        markers += ob->rtp->markers[i] ? 1 : 0;
+    }
+    std::cout << "  frames=" << ob->frames << " packets=" << ob->rtp->payloads.size() << std::endl;
+    TEST_ASSERT(ob->bad == 0, "every jpeg serialized");
+    TEST_ASSERT(ob->frames >= 3 && ob->frames <= 8, "about 5 frames in 500ms at 10fps");
+    TEST_ASSERT(markers == ob->frames, "one marker per picture");
+    return true;
+}
+
+// every frame with the sps it came after,the longest gap between two frames
+class reconfig_observer : public ceanic::util::stream_observer {
+public:
+    reconfig_observer() : frames(0), bad(0), last_us(0), max_gap_us(0), sps_tag(0) {}
+
+    void on_stream_come(ceanic::util::stream_obj_ptr sob, ceanic::util::stream_head* head, const char* buf, int32_t len) override {
+        (void)sob;
+        (void)buf;
+        (void)len;
+        std::lock_guard<std::mutex> lock(mu);
+        if (head->nalu.size() == 0) {
+            bad++;
+            return;
+        }
+        bool key = (head->nalu[0].data[4] & 0x1f) == 7;
+        if (key) {
+            sps_tag = head->nalu[0].data[head->nalu[0].size - 1];
+        }
+        tags.push_back(key ? sps_tag | 0x100 : sps_tag);
+
+        uint64_t now = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+        if (last_us && now - last_us > max_gap_us) {
+            max_gap_us = now - last_us;
+        }
+        last_us = now;
+        frames++;
+    }
+
+    void on_stream_error(ceanic::util::stream_obj_ptr sob, int32_t error) override {
+        (void)sob;
+        (void)error;
+        bad++;
+    }
+
+    // frames since the last mark,the gap to the frame before it is kept
+    int mark() {
+        std::lock_guard<std::mutex> lock(mu);
+        int n = tags.size();
+        tags.clear();
+        max_gap_us = 0;
+        return n;
+    }
+
+    std::mutex mu;
+    std::vector<int> tags;  // sps tag,0x100 on key frames
+    std::atomic<int> frames;
+    std::atomic<int> bad;
+    uint64_t last_us;
+    uint64_t max_gap_us;
+    uint8_t sps_tag;
+};
+
+// the rate control changes on the running channel,a new size restarts it with an idr,
+// above its max size the channel is rebuilt.the observer stays registered throughout
+bool test_venc_reconfigure() {
+    prepare_dir();
+    TEST_ASSERT(make_h264(std::string(TEST_DIR) + "/320x240.h264", 0x11), "write 320x240");
+    TEST_ASSERT(make_h264(std::string(TEST_DIR) + "/640x480.h264", 0x22), "write 640x480");
+
+    TEST_ASSERT(sys::init(OT_VI_OFFLINE_VPSS_OFFLINE), "sys init");
+    std::shared_ptr<vi_sim> vi = std::make_shared<vi_sim>(320, 240, 50);
+    TEST_ASSERT(vi->start(), "vi start");
+
+    venc_ptr v = std::make_shared<venc_h264_cbr>(0, 0, 320, 240, 50, 50, vi->vpss_grp(), vi->vpss_chn(), 1024);
+    std::shared_ptr<reconfig_observer> ob = std::make_shared<reconfig_observer>();
+    v->register_stream_observer(ob);
+    TEST_ASSERT(v->start(-1, -1), "venc start");
+    TEST_ASSERT(venc::start_capture(), "start capture");
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+    TEST_ASSERT(!v->set_rc(60, 512, 10), "above the source frame rate");
+    TEST_ASSERT(v->set_rc(25, 512, 10), "set rc");
+    ot_venc_chn_attr attr;
+    TEST_ASSERT(ss_mpi_venc_get_chn_attr(v->venc_chn(), &attr) == TD_SUCCESS, "get attr");
+    TEST_ASSERT(attr.rc_attr.h264_cbr.dst_frame_rate == 25 && attr.rc_attr.h264_cbr.bit_rate == 512
+            && attr.rc_attr.h264_cbr.gop == 10, "rc on the channel");
+    TEST_ASSERT(v->venc_fr() == 25 && v->venc_bitrate() == 512 && v->venc_gop() == 10, "rc of the venc");
+    ob->mark();
+    std::this_thread::sleep_for(std::chrono::milliseconds(400));
+    int n = ob->mark();
+    std::cout << "  25fps frames in 400ms=" << n << std::endl;
+    TEST_ASSERT(n >= 6 && n <= 14, "about 10 frames in 400ms at 25fps");
+
+    // above the 320x240 it was created for,the gap from the last old frame still counts after the mark
+    TEST_ASSERT(v->set_size(640, 480), "grow");
+    ob->mark();
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    {
+        std::lock_guard<std::mutex> lock(ob->mu);
+        TEST_ASSERT(!ob->tags.empty(), "frames after growing");
+        TEST_ASSERT(ob->tags[0] == (0x22 | 0x100), "first frame is an idr at the new size");
+        for (size_t i = 0; i < ob->tags.size(); i++) {
+            TEST_ASSERT((ob->tags[i] & 0xff) == 0x22, "no frame of the old size after the switch");
+        }
+        std::cout << "  grow: longest gap " << ob->max_gap_us / 1000 << "ms" << std::endl;
+        TEST_ASSERT(ob->max_gap_us < 10 * 1000000 / 25, "down for less than a gop");
+    }
+    TEST_ASSERT(ss_mpi_venc_get_chn_attr(v->venc_chn(), &attr) == TD_SUCCESS, "get attr");
+    TEST_ASSERT(attr.venc_attr.max_pic_width == 640 && attr.venc_attr.pic_height == 480, "channel rebuilt");
+    TEST_ASSERT(attr.rc_attr.h264_cbr.dst_frame_rate == 25, "rc kept over the rebuild");
+
+    // within the max size the channel stays
+    TEST_ASSERT(v->set_size(320, 240), "shrink");
+    ob->mark();
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    {
+        std::lock_guard<std::mutex> lock(ob->mu);
+        TEST_ASSERT(!ob->tags.empty() && ob->tags[0] == (0x11 | 0x100), "idr at the smaller size");
+        std::cout << "  shrink: longest gap " << ob->max_gap_us / 1000 << "ms" << std::endl;
+        TEST_ASSERT(ob->max_gap_us < 10 * 1000000 / 25, "down for less than a gop");
+    }
+    TEST_ASSERT(ss_mpi_venc_get_chn_attr(v->venc_chn(), &attr) == TD_SUCCESS, "get attr");
+    TEST_ASSERT(attr.venc_attr.max_pic_width == 640 && attr.venc_attr.pic_width == 320, "resized in place");
+    TEST_ASSERT(v->venc_w() == 320 && v->venc_h() == 240, "venc size");
+
+    venc::stop_capture();
+    v->stop();
+    vi->stop();
+    sys::release();
+
+    TEST_ASSERT(ob->bad == 0, "malformed stream delivered");
+    return true;
+}
+
+// keeps the first frame it gets until released,like a consumer stuck on a slow card
+class holding_observer : public reconfig_observer {
+public:
+    holding_observer() : taken(false) {}
+
+    void on_frame_come(ceanic::util::stream_obj_ptr sob, ceanic::util::stream_frame_ptr frame) override {
+        std::lock_guard<std::mutex> lock(hold_mu);
+        if (!taken) {
+            held = frame;
+            taken = true;
+        }
+        reconfig_observer::on_frame_come(sob, frame);
+    }
+
+    void release() {
+        std::lock_guard<std::mutex> lock(hold_mu);
+        held = nullptr;
+    }
+
+    std::mutex hold_mu;
+    ceanic::util::stream_frame_ptr held;
+    bool taken;
+};
+
+// a frame still held keeps the stream buffer,the channel goes on unchanged at the old size
+bool test_venc_resize_held() {
+    prepare_dir();
+    TEST_ASSERT(make_h264(std::string(TEST_DIR) + "/320x240.h264", 0x11), "write 320x240");
+    TEST_ASSERT(make_h264(std::string(TEST_DIR) + "/640x480.h264", 0x22), "write 640x480");
+
+    TEST_ASSERT(sys::init(OT_VI_OFFLINE_VPSS_OFFLINE), "sys init");
+    std::shared_ptr<vi_sim> vi = std::make_shared<vi_sim>(320, 240, 50);
+    TEST_ASSERT(vi->start(), "vi start");
+
+    venc_ptr v = std::make_shared<venc_h264_cbr>(0, 0, 320, 240, 50, 50, vi->vpss_grp(), vi->vpss_chn(), 1024);
+    std::shared_ptr<holding_observer> ob = std::make_shared<holding_observer>();
+    v->register_stream_observer(ob);
+    TEST_ASSERT(v->start(-1, -1), "venc start");
+    TEST_ASSERT(venc::start_capture(), "start capture");
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    TEST_ASSERT(ob->held != nullptr, "a frame held");
+
+    TEST_ASSERT(!v->set_size(640, 480), "refused while a frame is held");
+    TEST_ASSERT(v->venc_w() == 320 && v->venc_h() == 240, "size kept");
+    ot_venc_chn_attr attr;
+    TEST_ASSERT(ss_mpi_venc_get_chn_attr(v->venc_chn(), &attr) == TD_SUCCESS, "get attr");
+    TEST_ASSERT(attr.venc_attr.max_pic_width == 320 && attr.venc_attr.pic_width == 320, "channel not rebuilt");
+    TEST_ASSERT(ob->held->head()->nalu.size() > 0 && (ob->held->head()->nalu[0].data[4] & 0x1f) == 7, "held frame intact");
+
+    ob->mark();
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    {
+        std::lock_guard<std::mutex> lock(ob->mu);
+        TEST_ASSERT(!ob->tags.empty(), "frames after the refused resize");
+        for (size_t i = 0; i < ob->tags.size(); i++) {
+            TEST_ASSERT((ob->tags[i] & 0xff) == 0x11, "still the old size");
+        }
+    }
+
+    ob->release();
+    TEST_ASSERT(v->set_size(640, 480), "resized once the frame is released");
+    TEST_ASSERT(v->venc_w() == 640 && v->venc_h() == 480, "new size");
+
+    venc::stop_capture();
+    v->stop();
+    vi->stop();
+    sys::release();
+
+    TEST_ASSERT(ob->bad == 0, "malformed stream delivered");
+    return true;
+}
+
+// stuck in the first frame until released or a second went by,like an observer on a full queue
+class blocking_observer : public count_observer {
+public:
+    blocking_observer() : released(false) {}
+
+    void on_stream_come(ceanic::util::stream_obj_ptr sob, ceanic::util::stream_head* head, const char* buf, int32_t len) override {
+        count_observer::on_stream_come(sob, head, buf, len);
+        std::unique_lock<std::mutex> lock(mu);
+        cond.wait_for(lock, std::chrono::seconds(1), [this] { return released; });
+    }
+
+    void release() {
+        std::lock_guard<std::mutex> lock(mu);
+        released = true;
+        cond.notify_all();
+    }
+
+    std::mutex mu;
+    std::condition_variable cond;
+    bool released;
+};
+
+// the observers run without the channel list locked,a blocked one does not hold up
+// the resize of another channel.frames of every channel still wait for the capture thread
+bool test_venc_blocked_observer() {
+    prepare_dir();
+    TEST_ASSERT(make_h264(std::string(TEST_DIR) + "/320x240.h264", 0x11), "write 320x240");
+    TEST_ASSERT(make_h264(std::string(TEST_DIR) + "/160x120.h264", 0x33), "write 160x120");
+
+    TEST_ASSERT(sys::init(OT_VI_OFFLINE_VPSS_OFFLINE), "sys init");
+    std::shared_ptr<vi_sim> vi = std::make_shared<vi_sim>(320, 240, 50);
+    TEST_ASSERT(vi->start(), "vi start");
+
+    venc_ptr slow = std::make_shared<venc_h264_cbr>(0, 0, 320, 240, 50, 50, vi->vpss_grp(), vi->vpss_chn(), 1024);
+    venc_ptr fast = std::make_shared<venc_h264_cbr>(0, 1, 320, 240, 50, 50, vi->vpss_grp(), vi->vpss_chn(), 1024);
+    std::shared_ptr<blocking_observer> slow_ob = std::make_shared<blocking_observer>();
+    std::shared_ptr<count_observer> fast_ob = std::make_shared<count_observer>();
+    slow->register_stream_observer(slow_ob);
+    fast->register_stream_observer(fast_ob);
+    TEST_ASSERT(slow->start(-1, -1), "slow venc start");
+    TEST_ASSERT(fast->start(-1, -1), "fast venc start");
+    TEST_ASSERT(venc::start_capture(), "start capture");
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    TEST_ASSERT(slow_ob->frames == 1, "slow observer stuck in its first frame");
+
+    auto begin = std::chrono::steady_clock::now();
+    TEST_ASSERT(fast->set_size(160, 120), "resize the other channel");
+    int64_t ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - begin).count();
+    std::cout << "  resize while blocked " << ms << "ms" << std::endl;
+    TEST_ASSERT(ms < 300, "resize does not wait for the blocked observer");
+
+    slow_ob->release();
+    int before = fast_ob->frames;
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    TEST_ASSERT(fast_ob->frames > before, "frames of the resized channel after the release");
+    TEST_ASSERT(fast->venc_w() == 160 && fast->venc_h() == 120, "new size");
+
+    venc::stop_capture();
+    slow->stop();
+    fast->stop();
+    vi->stop();
+    sys::release();
+
+    TEST_ASSERT(slow_ob->bad == 0 && fast_ob->bad == 0, "malformed stream delivered");
+    return true;
+}
+
+static bool get_frame(venc_frame_pool_ptr pool, ot_venc_chn chn, venc_frame_ptr& frame) {
+    ot_venc_chn_status stat;
+    for (int i = 0; i < 100; i++) {
+        if (ss_mpi_venc_query_status(chn, &stat) == TD_SUCCESS && stat.cur_packs > 0) {
+            frame = pool->get(stat);
+            return frame != nullptr;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    return false;
+}
+
+// frames keep the venc stream until dropped, streams go back to venc in order
+bool test_venc_frame_ref() {
+    prepare_dir();
+    TEST_ASSERT(make_h264(std::string(TEST_DIR) + "/stream.h264"), "write h264");
+
+    ot_venc_chn chn = 13;
+    ot_venc_chn_attr attr = make_venc_attr(OT_PT_H264, 320, 240, 200);
+    TEST_ASSERT(ss_mpi_venc_create_chn(chn, &attr) == TD_SUCCESS, "create chn");
+    ot_venc_start_param start_param;
+    start_param.recv_pic_num = -1;
+    TEST_ASSERT(ss_mpi_venc_start_chn(chn, &start_param) == TD_SUCCESS, "start chn");
+
+    venc_frame_pool_ptr pool = std::make_shared<venc_frame_pool>(chn, attr.venc_attr.buf_size, 2);
+    venc_frame_ptr f1;
+    venc_frame_ptr f2;
+    venc_frame_ptr f3;
+    TEST_ASSERT(get_frame(pool, chn, f1) && get_frame(pool, chn, f2) && get_frame(pool, chn, f3), "get frames");
+    TEST_ASSERT(f1->is_ref() && f2->is_ref(), "first frames reference venc memory");
+    TEST_ASSERT(!f3->is_ref(), "frames past max_ref are copied");
+    TEST_ASSERT(pool->ref_frames() == 2 && pool->copy_frames() == 1, "pool counters");
+    TEST_ASSERT(nalu_type(f3->stream()->pack[0], false) == 1, "copied pack is a p slice");
+    TEST_ASSERT(pool->held_count() == 3, "the copy waits for older streams");
+
+    f2 = nullptr;
+    TEST_ASSERT(pool->held_count() == 3, "out of order drop keeps the order");
+    f1 = nullptr;
+    TEST_ASSERT(pool->held_count() == 0 && pool->held_bytes() == 0, "all streams released");
+    TEST_ASSERT(nalu_type(f3->stream()->pack[0], false) == 1, "copy outlives the venc stream");
+    f3 = nullptr;
+    TEST_ASSERT(pool->drain(0), "nothing left to drain");
+
+    // venc buffer nearly full, everything is copied and released at once
+    venc_frame_pool_ptr full = std::make_shared<venc_frame_pool>(chn, 1);
+    TEST_ASSERT(get_frame(full, chn, f1), "get frame");
+    TEST_ASSERT(!f1->is_ref() && full->held_count() == 0, "copied above the threshold");
+
+    // the saver queues the ref frame without copying the payload
+    venc_frame_pool_ptr save_pool = std::make_shared<venc_frame_pool>(chn, attr.venc_attr.buf_size);
+    TEST_ASSERT(get_frame(save_pool, chn, f2), "get frame");
+    ceanic::util::stream_head* head = f2->head();
+    head->type = STREAM_NALU_SLICE;
+    for (uint32_t i = 0; i < f2->stream()->pack_cnt; i++) {
+        head->nalu.push_back(f2->stream()->pack[i].addr, f2->stream()->pack[i].len, 0);
+    }
+    ceanic::stream_save::frame_queue queue(1024 * 1024);
+    ceanic::stream_save::save_frame_ptr sf = queue.make_frame(ceanic::util::STREAM_VIDEO_ENCODE_H264, f2);
+    TEST_ASSERT(sf && sf->data() == (const char*)head->nalu[0].data, "saver references the encoder memory");
+    f2 = nullptr;
+    TEST_ASSERT(save_pool->held_count() == 1, "queued frame holds the stream");
+    queue.release(sf);
+    TEST_ASSERT(save_pool->held_count() == 0, "released with the save frame");
+
+    f1 = nullptr;
+    ss_mpi_venc_stop_chn(chn);
+    TEST_ASSERT(ss_mpi_venc_destroy_chn(chn) == TD_SUCCESS, "destroy chn");
+    return true;
+}
+
+// glyphs are drawn into the atlas once and copied row by row afterwards
+bool test_glyph_atlas() {
+    const char* font = "/usr/share/fonts/truetype/dejavu/DejaVuSans.ttf";
+    if (access(font, R_OK) != 0) {
+        std::cout << "  no " << font << ",skipped" << std::endl;
+        return true;
+    }
+
+    ceanic_freetype ft(font);
+    TEST_ASSERT(ft.init(), "freetype init");
+    short bg = 0x0000;
+    short fg = (short)0xffff;
+    short outline = (short)0x8000;
+    const int font_size = 16;
+    const int area_w = 256;
+    const int area_h = 20;
+
+    uint32_t tiles;
+    uint32_t pixels;
+    TEST_ASSERT(ft.prewarm("0123456789-: ", area_h, font_size, bg, fg, outline), "prewarm");
+    ft.atlas_info(&tiles, &pixels);
+    TEST_ASSERT(tiles == 13 && pixels > 0, "one tile per glyph");
+
+    int text_w;
+    TEST_ASSERT(ft.get_width("2024-01-02 03:04:05", font_size, &text_w) && text_w < area_w, "text width");
+    std::vector<uint16_t> a(area_w * area_h, 0x1234);
+    std::vector<uint16_t> b(area_w * area_h, 0x1234);
+    ft.show_string("2024-01-02 03:04:05", area_w, area_h, font_size, (unsigned char*)a.data(), a.size() * 2, bg, fg, outline);
+    ft.atlas_info(&tiles, &pixels);
+    TEST_ASSERT(tiles == 13, "date drawn from the prewarmed tiles");
+
+    int fg_cnt = 0;
+    int outline_cnt = 0;
+    bool untouched = true;
+    for (int y = 0; y < area_h; y++) {
+        for (int x = 0; x < area_w; x++) {
+            uint16_t v = a[y * area_w + x];
+            fg_cnt += (v == (uint16_t)fg) ? 1 : 0;
+            outline_cnt += (v == (uint16_t)outline) ? 1 : 0;
+            if (x >= text_w && v != 0x1234) {
+                untouched = false;
+            }
+        }
+    }
+    TEST_ASSERT(fg_cnt > 0 && outline_cnt > 0, "fill and outline merged into the tiles");
+    TEST_ASSERT(untouched, "nothing drawn right of the text");
+
+    //only the changed tail is copied again,the result matches a full redraw
+    TEST_ASSERT(ft.show_string_compare("2024-01-02 03:04:05", "2024-01-02 03:04:16", area_w, area_h, font_size,
+            (unsigned char*)a.data(), a.size() * 2, bg, fg, outline), "compare");
+    ft.show_string("2024-01-02 03:04:16", area_w, area_h, font_size, (unsigned char*)b.data(), b.size() * 2, bg, fg, outline);
+    TEST_ASSERT(a == b, "partial redraw equals full redraw");
+
+    ft.show_string("2024", area_w, area_h, font_size, (unsigned char*)b.data(), b.size() * 2, bg, (short)0x83e0, outline);
+    ft.atlas_info(&tiles, &pixels);
+    TEST_ASSERT(tiles == 16, "other colors get their own tiles");
+
+    //clipped to a narrow area and to the buffer
+    std::vector<uint16_t> narrow(24 * area_h, 0);
+    ft.show_string("0000", 24, area_h, font_size, (unsigned char*)narrow.data(), narrow.size() * 2, bg, fg, outline);
+    std::vector<uint16_t> small(area_w * 4, 0);
+    ft.show_string("00", area_w, area_h, font_size, (unsigned char*)small.data(), small.size() * 2, bg, fg, outline);
+
+    ft.release();
+    ft.atlas_info(&tiles, &pixels);
+    TEST_ASSERT(tiles == 0 && pixels == 0, "atlas freed with the face");
+    return true;
+}
+
+// counts refreshes instead of drawing,the host has no osd font
+class count_osd : public osd_dynamic {
+public:
+    count_osd(int interval_ms) : osd_dynamic(0, 0, 16, 0, interval_ms), refreshes(0), misaligned(0) {}
+
+    bool refresh(time_t now) override {
+        (void)now;
+        struct timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        int64_t ms = (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+        //the first refresh comes at once,the others on multiples of the interval
+        if (refreshes > 0 && ms % m_interval_ms > 50) {
+            misaligned++;
+        }
+        refreshes++;
+        return false;
+    }
+
+    std::atomic<int> refreshes;
+    std::atomic<int> misaligned;
+};
+
+// one timerfd thread wakes only when some overlay is due
+bool test_osd_scheduler() {
+    count_osd date_main(1000);
+    count_osd date_sub(1000);
+    count_osd bitrate(250);
+    uint64_t wakeups = osd_scheduler::wakeups();
+    TEST_ASSERT(osd_scheduler::add(&date_main) && osd_scheduler::add(&date_sub) && osd_scheduler::add(&bitrate), "add overlays");
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(2100));
+    osd_scheduler::remove(&bitrate);
+    int bitrate_cnt = bitrate.refreshes;
+    std::this_thread::sleep_for(std::chrono::milliseconds(600));
+    osd_scheduler::remove(&date_main);
+    osd_scheduler::remove(&date_sub);
+    wakeups = osd_scheduler::wakeups() - wakeups;
+    osd_scheduler::stop();
+
+    std::cout << "  wakeups=" << wakeups << " date=" << date_main.refreshes << " bitrate=" << bitrate_cnt << std::endl;
+    TEST_ASSERT(date_main.refreshes >= 3 && date_main.refreshes <= 4 && date_sub.refreshes == date_main.refreshes, "dates once a second");
+    TEST_ASSERT(bitrate_cnt >= 8 && bitrate_cnt <= 10, "bitrate every 250ms");
+    TEST_ASSERT(bitrate.refreshes == bitrate_cnt, "removed overlay not refreshed");
+    TEST_ASSERT(date_main.misaligned == 0 && bitrate.misaligned == 0, "aligned to the wall clock");
+    TEST_ASSERT(wakeups <= 14, "wakeups shared by the overlays");
+    return true;
+}
+
+bool test_rgn_canvas() {
+    ot_rgn_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.type = OT_RGN_OVERLAY;
+    attr.attr.overlay.pixel_format = OT_PIXEL_FORMAT_ARGB_1555;
+    attr.attr.overlay.size.width = 64;
+    attr.attr.overlay.size.height = 32;
+    attr.attr.overlay.canvas_num = 2;
+    ot_rgn_handle hdl = 5;
+    TEST_ASSERT(ss_mpi_rgn_create(hdl, &attr) == TD_SUCCESS, "create rgn");
+    TEST_ASSERT(ss_mpi_rgn_create(hdl, &attr) == OT_ERR_RGN_EXIST, "create twice");
+
+    ot_rgn_canvas_info c1;
+    ot_rgn_canvas_info c2;
+    ot_rgn_canvas_info c3;
+    TEST_ASSERT(ss_mpi_rgn_get_canvas_info(hdl, &c1) == TD_SUCCESS, "canvas");
+    TEST_ASSERT(c1.stride == 128 && c1.size.width == 64 && c1.size.height == 32, "canvas layout");
+    memset(c1.virt_addr, 0xff, c1.stride * c1.size.height);
+    TEST_ASSERT(ss_mpi_rgn_update_canvas(hdl) == TD_SUCCESS, "update");
+    TEST_ASSERT(ss_mpi_rgn_get_canvas_info(hdl, &c2) == TD_SUCCESS, "canvas after update");
+    TEST_ASSERT(c2.virt_addr != c1.virt_addr, "double buffered");
+    ss_mpi_rgn_update_canvas(hdl);
+    ss_mpi_rgn_get_canvas_info(hdl, &c3);
+    TEST_ASSERT(c3.virt_addr == c1.virt_addr, "canvases alternate");
+
+    ot_mpp_chn chn;
+    chn.mod_id = OT_ID_VENC;
+    chn.dev_id = 0;
+    chn.chn_id = 0;
+    ot_rgn_chn_attr chn_attr;
+    memset(&chn_attr, 0, sizeof(chn_attr));
+    chn_attr.is_show = TD_TRUE;
+    chn_attr.type = OT_RGN_OVERLAY;
+    TEST_ASSERT(ss_mpi_rgn_attach_to_chn(hdl, &chn, &chn_attr) == TD_SUCCESS, "attach");
+    TEST_ASSERT(ss_mpi_rgn_attach_to_chn(hdl, &chn, &chn_attr) == OT_ERR_RGN_EXIST, "attach twice");
+    chn_attr.is_show = TD_FALSE;
+    TEST_ASSERT(ss_mpi_rgn_set_display_attr(hdl, &chn, &chn_attr) == TD_SUCCESS, "display attr");
+    TEST_ASSERT(ss_mpi_rgn_detach_from_chn(hdl, &chn) == TD_SUCCESS, "detach");
+    TEST_ASSERT(ss_mpi_rgn_detach_from_chn(hdl, &chn) == OT_ERR_RGN_UNEXIST, "detach twice");
+    TEST_ASSERT(ss_mpi_rgn_destroy(hdl) == TD_SUCCESS, "destroy");
+    return true;
+}
+
+static bool file_size(const std::string& file, size_t size) {
+    struct stat st;
+    return stat(file.c_str(), &st) == 0 && (size_t)st.st_size == size;
+}
+
+// snapshots are queued to the snap thread,repeats hit the cache and bursts keep their interval
+bool test_snap_service() {
+    prepare_dir();
+    std::vector<uint8_t> jpg = {0xff, 0xd8, 0xff, 0xe0, 0x00, 0x10, 0x4a, 0x46, 0xff, 0xd9};
+    TEST_ASSERT(write_file(std::string(TEST_DIR) + "/snap.jpg", jpg), "write jpg");
+
+    TEST_ASSERT(sys::init(OT_VI_OFFLINE_VPSS_OFFLINE), "sys init");
+    std::shared_ptr<vi_sim> vi = std::make_shared<vi_sim>(320, 240, 50);
+    TEST_ASSERT(vi->start(), "vi start");
+
+    std::shared_ptr<snap> s = std::make_shared<snap>(vi);
+    TEST_ASSERT(s->start(), "snap start");
+    TEST_ASSERT(s->latest() == nullptr, "nothing cached yet");
+
+    snap_image_ptr img = s->capture(80, "test");
+    TEST_ASSERT(img && img->data == jpg, "jpeg returned in memory");
+    TEST_ASSERT(s->latest() == img, "latest kept");
+    TEST_ASSERT(s->capture(80, "test") == img, "repeat within the window is cached");
+    snap_image_ptr other = s->capture(60, "test");
+    TEST_ASSERT(other && other != img, "another quality encodes again");
+
+    s->set_cache_ms(0);
+    std::mutex mu;
+    std::vector<int> index;
+    std::vector<std::chrono::steady_clock::time_point> tp;
+    snap_request req;
+    req.quality = 60;
+    req.count = 3;
+    req.interval_ms = 100;
+    req.path = std::string(TEST_DIR) + "/burst.jpg";
+    req.on_done = [&](snap_image_ptr b) {
+        std::unique_lock<std::mutex> lock(mu);
+        index.push_back(b ? b->index : -1);
+        tp.push_back(std::chrono::steady_clock::now());
+    };
+    TEST_ASSERT(s->request(req), "queue burst");
+    TEST_ASSERT(s->trigger((std::string(TEST_DIR) + "/single.jpg").c_str(), 50, NULL), "queue trigger");
+
+    for (int i = 0; i < 200; i++) {
+        {
+            std::unique_lock<std::mutex> lock(mu);
+            if (index.size() == 3) {
+                break;
+            }
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    {
+        std::unique_lock<std::mutex> lock(mu);
+        TEST_ASSERT(index.size() == 3 && index[0] == 0 && index[1] == 1 && index[2] == 2, "burst shots in order");
+        TEST_ASSERT(tp[2] - tp[0] >= std::chrono::milliseconds(150), "burst interval kept");
+    }
+
+    // stop waits for the pending writes
+    s->stop();
+    TEST_ASSERT(!s->request(snap_request()), "refused after stop");
+    TEST_ASSERT(file_size(std::string(TEST_DIR) + "/burst_0.jpg", jpg.size()), "burst_0 written");
+    TEST_ASSERT(file_size(std::string(TEST_DIR) + "/burst_2.jpg", jpg.size()), "burst_2 written");
+    TEST_ASSERT(file_size(std::string(TEST_DIR) + "/single.jpg", jpg.size()), "trigger written");
+
+    s = nullptr;
+    vi->stop();
+    sys::release();
+    return true;
+}
+
+static void clean_dir() {
+    std::string cmd = std::string("rm -rf ") + TEST_DIR;
+    if (system(cmd.c_str()) != 0) {
+        std::cerr << "cleanup failed" << std::endl;
+    }
+}
+
+int main() {
+    int passed = 0;
+    int failed = 0;
+
+    std::cout << "=== SDK Sim Unit Tests ===" << std::endl;
+
+    RUN_TEST(test_vpss_frames);
+    RUN_TEST(test_vb_user_pool);
+    RUN_TEST(test_venc_replay_h264);
+    RUN_TEST(test_venc_replay_h265);
+    RUN_TEST(test_venc_capture);
+    RUN_TEST(test_venc_roi);
+    RUN_TEST(test_venc_slice_mode);
+    RUN_TEST(test_venc_jpeg_snap);
+    RUN_TEST(test_venc_frame_ref);
+    RUN_TEST(test_rgn_canvas);
+    RUN_TEST(test_glyph_atlas);
+    RUN_TEST(test_osd_scheduler);
+    RUN_TEST(test_snap_service);
+    RUN_TEST(test_jpeg_rtp_payload);
+    RUN_TEST(test_metadata_rtp_payload);
+    RUN_TEST(test_venc_mjpeg);
+    RUN_TEST(test_venc_reconfigure);
+    RUN_TEST(test_venc_resize_held);
+    RUN_TEST(test_venc_blocked_observer);
+
+    clean_dir();
+
+    std::cout << std::endl;
+    std::cout << "=== Results ===" << std::endl;
+    std::cout << "Passed: " << passed << std::endl;
+    std::cout << "Failed: " << failed << std::endl;
+
+    return (failed == 0) ? 0 : 1;
+}
@@ -0,0 +1,182 @@
+// Boot time of the main.cpp startup steps on the sdk stand-in:the old one after another
+// order(one thread) against the dependency graph on a small pool.
+// sys,vi and the main venc are the real device code on device/sdk_sim,the first main stream
+// frame is timed from its capture thread.what the stand-in does not have(json on flash,
+// sensor/isp convergence,model files,npu and aiisp model loads) sleeps for a board like time,
+// scaled by the second argument.
+//
+// usage: startup_bench [threads] [scale]
+#include "../../startup/startup_dag.h"
+#include "dev_sys.h"
+#include "dev_venc.h"
+#include "dev_vi_sim.h"
+#include "dev_log.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace hisilicon::dev;
+using namespace ceanic::startup;
+
+//the bench does not start the log library
+LOG_HANDLE g_dev_log = NULL;
+extern "C" int ceanic_write_log(LOG_HANDLE h,CEANIC_LOG_LEVEL_E level,const char* msg,...)
+{
+    (void)h;
+    (void)level;
+    (void)msg;
+    return 0;
+}
+
+static const char* SIM_DIR = "/tmp/startup_bench";
+static double g_scale = 1.0;
+
+static uint64_t now_us() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void cost_ms(int ms) {
+    std::this_thread::sleep_for(std::chrono::microseconds((int64_t)(ms * 1000 * g_scale)));
+}
+
+// a short gop of replayed h264 for the main venc
+static bool prepare_sim() {
+    std::string cmd = std::string("rm -rf ") + SIM_DIR + " && mkdir -p " + SIM_DIR;
+    if (system(cmd.c_str()) != 0) {
+        return false;
+    }
+    setenv("CEANIC_SIM_DIR", SIM_DIR, 1);
+
+    std::vector<uint8_t> es;
+    auto nalu = [&es](std::vector<uint8_t> n) {
+        static const uint8_t sc[4] = {0, 0, 0, 1};
+        es.insert(es.end(), sc, sc + 4);
+        es.insert(es.end(), n.begin(), n.end());
+    };
+    nalu({0x67, 0x42, 0x00, 0x1f, 0x11});
+    nalu({0x68, 0xce, 0x3c, 0x80});
+    nalu({0x65, 0x88, 0x84, 0x00, 0x10});
+    for (int i = 1; i < 25; i++) {
+        nalu({0x41, 0x9a, 0x02, (uint8_t)i});
+    }
+
+    FILE* f = fopen((std::string(SIM_DIR) + "/640x360.h264").c_str(), "wb");
+    if (!f) {
+        return false;
+    }
+    fwrite(es.data(), 1, es.size(), f);
+    fclose(f);
+    return true;
+}
+
+class first_frame : public ceanic::util::stream_observer {
+public:
+    first_frame() : us(0) {}
+
+    void on_stream_come(ceanic::util::stream_obj_ptr sob, ceanic::util::stream_head* head, const char* buf, int32_t len) override {
+        (void)sob;
+        (void)head;
+        (void)buf;
+        (void)len;
+        uint64_t zero = 0;
+        us.compare_exchange_strong(zero, now_us());
+    }
+
+    void on_stream_error(ceanic::util::stream_obj_ptr sob, int32_t error) override {
+        (void)sob;
+        (void)error;
+    }
+
+    std::atomic<uint64_t> us;
+};
+
+// the steps of main.cpp with their dependencies
+static bool boot(uint32_t threads, uint64_t* first_frame_us, uint64_t* total_us, std::string* path) {
+    std::shared_ptr<vi_sim> vi;
+    venc_ptr v;
+    std::shared_ptr<first_frame> ob = std::make_shared<first_frame>();
+    startup_dag dag;
+
+    const char* cfgs[] = {"cfg_net", "cfg_jpg_save", "cfg_aiisp", "cfg_vi", "cfg_venc", "cfg_scene", "cfg_rate_auto", "cfg_mp4_save", "cfg_yolov5", "cfg_vo"};
+    std::vector<std::string> all_cfg;
+    for (size_t i = 0; i < sizeof(cfgs) / sizeof(cfgs[0]); i++) {
+        dag.add(cfgs[i], {}, [] { cost_ms(8); return true; });
+        all_cfg.push_back(cfgs[i]);
+    }
+    dag.add("show_info", all_cfg, [] { return true; });
+    dag.add("rtsp", {"cfg_net"}, [] { cost_ms(2); return true; });
+    dag.add("sys", {"cfg_aiisp", "cfg_jpg_save"}, [] { return sys::init(OT_VI_OFFLINE_VPSS_OFFLINE); });
+    dag.add("chn", {"sys", "cfg_vi", "cfg_venc"}, [&vi, &v, ob] {
+        // sensor,mipi and the isp settling
+        vi = std::make_shared<vi_sim>(640, 360, 30);
+        cost_ms(250);
+        if (!vi->start()) {
+            return false;
+        }
+        v = std::make_shared<venc_h264_cbr>(0, 0, 640, 360, 30, 30, vi->vpss_grp(), vi->vpss_chn(), 1024);
+        v->register_stream_observer(ob);
+        return v->start(-1, -1) && venc::start_capture();
+    });
+    dag.add("aiisp_model", {"cfg_aiisp"}, [] { cost_ms(80); return true; });
+    dag.add("aiisp", {"chn", "aiisp_model"}, [] { cost_ms(60); return true; });
+    dag.add("scene", {"chn", "cfg_scene"}, [] { cost_ms(50); return true; });
+    dag.add("rate_auto", {"chn", "cfg_rate_auto"}, [] { cost_ms(10); return true; });
+    dag.add("mp4_save", {"chn", "cfg_mp4_save"}, [] { cost_ms(20); return true; });
+    dag.add("yolov5_model", {"cfg_yolov5"}, [] { cost_ms(200); return true; });
+    dag.add("svp", {"sys", "cfg_yolov5"}, [] { cost_ms(100); return true; });
+    dag.add("yolov5", {"chn", "svp", "yolov5_model"}, [] { cost_ms(150); return true; });
+    dag.add("vo", {"chn", "cfg_vo"}, [] { cost_ms(80); return true; });
+
+    uint64_t begin = now_us();
+    bool ok = dag.run(threads);
+    *total_us = dag.total_us();
+
+    // the capture thread may still be on its way to the first frame
+    for (int i = 0; i < 200 && ob->us == 0; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    *first_frame_us = ob->us ? ob->us - begin : 0;
+
+    path->clear();
+    std::vector<std::string> critical = dag.critical_path();
+    for (size_t i = 0; i < critical.size(); i++) {
+        *path += (i ? "->" : "") + critical[i];
+    }
+
+    venc::stop_capture();
+    if (v) {
+        v->stop();
+    }
+    if (vi) {
+        vi->stop();
+    }
+    sys::release();
+    return ok;
+}
+
+int main(int argc, char** argv) {
+    uint32_t threads = argc > 1 ? atoi(argv[1]) : 4;
+    g_scale = argc > 2 ? atof(argv[2]) : 1.0;
+
+    if (!prepare_sim()) {
+        printf("can not prepare %s\n", SIM_DIR);
+        return 1;
+    }
+
+    uint32_t runs[] = {1, threads};
+    for (size_t i = 0; i < sizeof(runs) / sizeof(runs[0]); i++) {
+        uint64_t first_us = 0, total_us = 0;
+        std::string path;
+        if (!boot(runs[i], &first_us, &total_us, &path)) {
+            printf("boot on %u threads failed\n", runs[i]);
+            return 1;
+        }
+        printf("%u thread(s):first main frame %6.1f ms,all steps %6.1f ms\n", runs[i], first_us / 1000.0, total_us / 1000.0);
+        printf("  critical path %s\n", path.c_str());
+    }
+    return 0;
+}
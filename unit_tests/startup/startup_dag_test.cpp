@@ -0,0 +1,187 @@
+#include "../../startup/startup_dag.h"
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace ceanic::startup;
+
+// Test helper
+#define TEST_ASSERT(condition, message) \
+    if (!(condition)) { \
+        std::cerr << "FAILED: " << message << std::endl; \
+        return false; \
+    }
+
+#define RUN_TEST(test_func) \
+    std::cout << "Running " << #test_func << "..." << std::endl; \
+    if (test_func()) { \
+        std::cout << "  PASSED" << std::endl; \
+        passed++; \
+    } else { \
+        std::cout << "  FAILED" << std::endl; \
+        failed++; \
+    }
+
+static void sleep_ms(int ms) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+static const step_result* find(startup_dag& dag, const std::string& name) {
+    for (size_t i = 0; i < dag.results().size(); i++) {
+        if (dag.results()[i].name == name) {
+            return &dag.results()[i];
+        }
+    }
+    return NULL;
+}
+
+// a step begins after all of its dependencies ended
+bool test_order() {
+    std::mutex mu;
+    std::vector<std::string> log;
+    auto step = [&](const char* name) {
+        return [&mu, &log, name] {
+            sleep_ms(5);
+            std::lock_guard<std::mutex> lock(mu);
+            log.push_back(name);
+            return true;
+        };
+    };
+
+    startup_dag dag;
+    // added before its dependencies on purpose
+    TEST_ASSERT(dag.add("chn", {"sys", "cfg_vi", "cfg_venc"}, step("chn")), "add chn");
+    TEST_ASSERT(dag.add("cfg_vi", {}, step("cfg_vi")), "add cfg_vi");
+    TEST_ASSERT(dag.add("cfg_venc", {}, step("cfg_venc")), "add cfg_venc");
+    TEST_ASSERT(dag.add("sys", {"cfg_vi"}, step("sys")), "add sys");
+    TEST_ASSERT(dag.add("yolov5", {"chn"}, step("yolov5")), "add yolov5");
+    TEST_ASSERT(!dag.add("sys", {}, step("sys")), "duplicate name");
+    TEST_ASSERT(dag.run(4), "run");
+
+    TEST_ASSERT(log.size() == 5, "every step ran once");
+    for (size_t i = 0; i < dag.results().size(); i++) {
+        const step_result& r = dag.results()[i];
+        TEST_ASSERT(r.ok && !r.skipped && r.end_us >= r.begin_us, "result of " + r.name);
+    }
+    TEST_ASSERT(find(dag, "chn")->begin_us >= find(dag, "sys")->end_us, "chn after sys");
+    TEST_ASSERT(find(dag, "chn")->begin_us >= find(dag, "cfg_venc")->end_us, "chn after cfg_venc");
+    TEST_ASSERT(find(dag, "sys")->begin_us >= find(dag, "cfg_vi")->end_us, "sys after cfg_vi");
+    TEST_ASSERT(log.back() == "yolov5", "yolov5 last");
+    return true;
+}
+
+// independent steps overlap,one thread runs them one after another in add order
+bool test_parallel() {
+    startup_dag dag;
+    std::atomic<int> running(0);
+    std::atomic<int> peak(0);
+    for (int i = 0; i < 4; i++) {
+        dag.add(("load" + std::to_string(i)).c_str(), {}, [&running, &peak] {
+            int now = ++running;
+            int p = peak;
+            while (now > p && !peak.compare_exchange_weak(p, now)) {
+            }
+            sleep_ms(50);
+            running--;
+            return true;
+        });
+    }
+
+    TEST_ASSERT(dag.run(4), "run on 4 threads");
+    std::cout << "  4 x 50ms on 4 threads: " << dag.total_us() << "us" << std::endl;
+    TEST_ASSERT(peak == 4, "all four at once");
+    TEST_ASSERT(dag.total_us() < 150000, "faster than in sequence");
+
+    peak = 0;
+    TEST_ASSERT(dag.run(1), "run on 1 thread");
+    TEST_ASSERT(peak == 1, "one at a time");
+    TEST_ASSERT(dag.total_us() >= 200000, "in sequence");
+    for (int i = 1; i < 4; i++) {
+        TEST_ASSERT(dag.results()[i].begin_us >= dag.results()[i - 1].end_us, "add order");
+    }
+    return true;
+}
+
+// the dependents of a failed step are skipped,the other branches go on
+bool test_failure() {
+    startup_dag dag;
+    std::atomic<int> ran(0);
+    dag.add("sys", {}, [&ran] { ran++; return true; });
+    dag.add("svp", {"sys"}, [&ran] { ran++; return false; });
+    dag.add("yolov5_model", {}, [&ran] { ran++; sleep_ms(20); return true; });
+    dag.add("yolov5", {"svp", "yolov5_model"}, [&ran] { ran++; return true; });
+    dag.add("yolov5_roi", {"yolov5"}, [&ran] { ran++; return true; });
+    dag.add("chn", {"sys"}, [&ran] { ran++; return true; });
+    dag.add("throws", {}, [&ran]() -> bool { ran++; throw std::runtime_error("broken config"); });
+
+    std::vector<std::string> seen;
+    dag.set_observer([&seen](const step_result& r) { seen.push_back(r.name); });
+
+    TEST_ASSERT(!dag.run(2), "run reports the failure");
+    TEST_ASSERT(ran == 5, "the skipped steps did not run");
+    TEST_ASSERT(!find(dag, "svp")->ok && !find(dag, "svp")->skipped, "svp failed");
+    TEST_ASSERT(find(dag, "yolov5")->skipped && find(dag, "yolov5_roi")->skipped, "yolov5 chain skipped");
+    TEST_ASSERT(find(dag, "chn")->ok && find(dag, "yolov5_model")->ok, "other branches ran");
+    TEST_ASSERT(!find(dag, "throws")->ok, "an exception fails the step");
+    TEST_ASSERT(seen.size() == 7, "observer saw every step");
+    return true;
+}
+
+// unknown dependencies and cycles are refused before anything runs
+bool test_invalid() {
+    std::atomic<int> ran(0);
+    startup_dag unknown;
+    unknown.add("chn", {"sys"}, [&ran] { ran++; return true; });
+    TEST_ASSERT(!unknown.run(2), "unknown dependency");
+
+    startup_dag cycle;
+    cycle.add("a", {}, [&ran] { ran++; return true; });
+    cycle.add("b", {"a", "d"}, [&ran] { ran++; return true; });
+    cycle.add("c", {"b"}, [&ran] { ran++; return true; });
+    cycle.add("d", {"c"}, [&ran] { ran++; return true; });
+    TEST_ASSERT(!cycle.run(2), "cycle");
+    TEST_ASSERT(ran == 0, "nothing ran");
+
+    startup_dag empty;
+    TEST_ASSERT(empty.run(4) && empty.results().empty(), "no steps");
+    return true;
+}
+
+// the chain that ended last,through the latest dependency of each step
+bool test_critical_path() {
+    startup_dag dag;
+    dag.add("cfg", {}, [] { sleep_ms(5); return true; });
+    dag.add("isp", {"cfg"}, [] { sleep_ms(60); return true; });
+    dag.add("model", {"cfg"}, [] { sleep_ms(20); return true; });
+    dag.add("yolov5", {"isp", "model"}, [] { sleep_ms(10); return true; });
+    dag.add("vo", {"isp"}, [] { return true; });
+    TEST_ASSERT(dag.run(3), "run");
+
+    std::vector<std::string> path = dag.critical_path();
+    TEST_ASSERT(path.size() == 3 && path[0] == "cfg" && path[1] == "isp" && path[2] == "yolov5", "cfg->isp->yolov5");
+    return true;
+}
+
+int main() {
+    int passed = 0;
+    int failed = 0;
+
+    std::cout << "=== startup_dag Unit Tests ===" << std::endl << std::endl;
+
+    RUN_TEST(test_order);
+    RUN_TEST(test_parallel);
+    RUN_TEST(test_failure);
+    RUN_TEST(test_invalid);
+    RUN_TEST(test_critical_path);
+
+    std::cout << std::endl << "=== Results ===" << std::endl;
+    std::cout << "Passed: " << passed << std::endl;
+    std::cout << "Failed: " << failed << std::endl;
+
+    return failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,185 @@
+// Frame routing cost with many streams and viewers:the old stream_manager/rtmp session_manager
+// way(one mutex,a list walked comparing chn and stream_id) against stream_registry(one atomic
+// load of the slot's snapshot).every stream has its own frame thread like the venc capture,
+// a writer thread adds and removes viewers like rtsp SETUP/TEARDOWN.
+//
+// usage: stream_registry_bench [cameras] [streams per camera] [viewers per stream] [seconds]
+#include "../../util/stream_registry.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <list>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace ceanic::util;
+
+static uint64_t now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+struct viewer {
+    viewer(int32_t c, int32_t s) : chn(c), stream_id(s), bytes(0) {}
+
+    // what a stream_stock does with a frame before its observers
+    void process_data(int32_t len) {
+        bytes += len;
+    }
+
+    int32_t chn;
+    int32_t stream_id;
+    std::atomic<uint64_t> bytes;
+};
+
+typedef std::shared_ptr<viewer> viewer_ptr;
+
+// the old routing:every frame locks the manager and walks all viewers of all streams
+class locked_list {
+public:
+    void add(int32_t, int32_t, viewer_ptr v) {
+        std::unique_lock<std::mutex> lock(m_mu);
+        m_viewers.push_back(v);
+    }
+
+    void remove(int32_t, int32_t, viewer_ptr v) {
+        std::unique_lock<std::mutex> lock(m_mu);
+        m_viewers.remove(v);
+    }
+
+    void process_data(int32_t chn, int32_t stream_id, int32_t len) {
+        std::unique_lock<std::mutex> lock(m_mu);
+        for (auto it = m_viewers.begin(); it != m_viewers.end(); it++) {
+            if ((*it)->chn == chn && (*it)->stream_id == stream_id) {
+                (*it)->process_data(len);
+            }
+        }
+    }
+
+private:
+    std::mutex m_mu;
+    std::list<viewer_ptr> m_viewers;
+};
+
+class snapshot_registry {
+public:
+    void add(int32_t chn, int32_t stream_id, viewer_ptr v) {
+        m_reg.add(chn, stream_id, v);
+    }
+
+    void remove(int32_t chn, int32_t stream_id, viewer_ptr v) {
+        m_reg.remove(chn, stream_id, v);
+    }
+
+    void process_data(int32_t chn, int32_t stream_id, int32_t len) {
+        stream_registry<viewer>::snapshot viewers = m_reg.get(chn, stream_id);
+        if (viewers) {
+            for (size_t i = 0; i < viewers->size(); i++) {
+                (*viewers)[i]->process_data(len);
+            }
+        }
+    }
+
+private:
+    stream_registry<viewer> m_reg;
+};
+
+typedef struct {
+    uint64_t frames;
+    uint64_t p50_ns;
+    uint64_t p99_ns;
+    uint64_t max_ns;
+    uint64_t churn;
+} result_t;
+
+template<typename R>
+static result_t run(int cameras, int streams, int viewers, double seconds) {
+    R routes;
+    for (int c = 0; c < cameras; c++) {
+        for (int s = 0; s < streams; s++) {
+            for (int v = 0; v < viewers; v++) {
+                routes.add(c, s, std::make_shared<viewer>(c, s));
+            }
+        }
+    }
+
+    std::atomic<bool> running(true);
+    std::vector<std::vector<uint64_t>> lat(cameras * streams);
+    std::vector<std::thread> threads;
+    for (int c = 0; c < cameras; c++) {
+        for (int s = 0; s < streams; s++) {
+            std::vector<uint64_t>* l = &lat[c * streams + s];
+            threads.push_back(std::thread([&routes, &running, c, s, l] {
+                l->reserve(1 << 20);
+                while (running) {
+                    uint64_t beg = now_ns();
+                    routes.process_data(c, s, 1400);
+                    l->push_back(now_ns() - beg);
+                }
+            }));
+        }
+    }
+
+    // a client coming and going every millisecond
+    uint64_t churn = 0;
+    std::thread writer([&] {
+        int i = 0;
+        while (running) {
+            int c = i % cameras;
+            int s = (i / cameras) % streams;
+            viewer_ptr v = std::make_shared<viewer>(c, s);
+            routes.add(c, s, v);
+            std::this_thread::sleep_for(std::chrono::microseconds(500));
+            routes.remove(c, s, v);
+            std::this_thread::sleep_for(std::chrono::microseconds(500));
+            churn++;
+            i++;
+        }
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds((int)(seconds * 1000)));
+    running = false;
+    for (size_t i = 0; i < threads.size(); i++) {
+        threads[i].join();
+    }
+    writer.join();
+
+    std::vector<uint64_t> all;
+    for (size_t i = 0; i < lat.size(); i++) {
+        all.insert(all.end(), lat[i].begin(), lat[i].end());
+    }
+    std::sort(all.begin(), all.end());
+
+    result_t r;
+    r.frames = all.size();
+    r.p50_ns = all.empty() ? 0 : all[all.size() / 2];
+    r.p99_ns = all.empty() ? 0 : all[all.size() * 99 / 100];
+    r.max_ns = all.empty() ? 0 : all.back();
+    r.churn = churn;
+    return r;
+}
+
+static void print(const char* name, const result_t& r, double seconds) {
+    printf("  %-10s %10.0f frames/s  p50 %6llu ns  p99 %7llu ns  max %9llu ns  (%llu add/remove)\n", name,
+            r.frames / seconds, (unsigned long long)r.p50_ns, (unsigned long long)r.p99_ns,
+            (unsigned long long)r.max_ns, (unsigned long long)r.churn);
+}
+
+int main(int argc, char** argv) {
+    int cameras = argc > 1 ? atoi(argv[1]) : 4;
+    int streams = argc > 2 ? atoi(argv[2]) : 4;
+    int viewers = argc > 3 ? atoi(argv[3]) : 8;
+    double seconds = argc > 4 ? atof(argv[4]) : 2.0;
+
+    if (cameras <= 0 || cameras > STREAM_REGISTRY_MAX_CHN || streams <= 0 || streams > STREAM_REGISTRY_MAX_STREAM) {
+        printf("cameras 1-%d,streams 1-%d\n", STREAM_REGISTRY_MAX_CHN, STREAM_REGISTRY_MAX_STREAM);
+        return 1;
+    }
+
+    printf("%d cameras x %d streams,%d viewers each,%.1f s\n", cameras, streams, viewers, seconds);
+    print("mutex+list", run<locked_list>(cameras, streams, viewers, seconds), seconds);
+    print("snapshot", run<snapshot_registry>(cameras, streams, viewers, seconds), seconds);
+    return 0;
+}
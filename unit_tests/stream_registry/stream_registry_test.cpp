@@ -0,0 +1,182 @@
+#include "../../util/stream_registry.h"
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+using namespace ceanic::util;
+
+// Test helper
+#define TEST_ASSERT(condition, message) \
+    if (!(condition)) { \
+        std::cerr << "FAILED: " << message << std::endl; \
+        return false; \
+    }
+
+#define RUN_TEST(test_func) \
+    std::cout << "Running " << #test_func << "..." << std::endl; \
+    if (test_func()) { \
+        std::cout << "  PASSED" << std::endl; \
+        passed++; \
+    } else { \
+        std::cout << "  FAILED" << std::endl; \
+        failed++; \
+    }
+
+struct viewer {
+    explicit viewer(int i) : id(i), frames(0), stopped(false) {}
+
+    int id;
+    std::atomic<uint32_t> frames;
+    std::atomic<bool> stopped;
+};
+
+typedef stream_registry<viewer> registry;
+typedef registry::item_ptr viewer_ptr;
+
+// items land in their own slot only
+bool test_add_get() {
+    registry reg;
+    TEST_ASSERT(!reg.get(0, 0), "empty slot");
+
+    viewer_ptr a = std::make_shared<viewer>(1);
+    viewer_ptr b = std::make_shared<viewer>(2);
+    viewer_ptr c = std::make_shared<viewer>(3);
+    TEST_ASSERT(reg.add(0, 0, a) && reg.add(0, 0, b), "add to 0/0");
+    TEST_ASSERT(reg.add(3, 1, c), "add to 3/1");
+
+    registry::snapshot s = reg.get(0, 0);
+    TEST_ASSERT(s && s->size() == 2 && (*s)[0] == a && (*s)[1] == b, "0/0 in add order");
+    s = reg.get(3, 1);
+    TEST_ASSERT(s && s->size() == 1 && (*s)[0] == c, "3/1");
+    TEST_ASSERT(!reg.get(1, 0) && !reg.get(0, 1), "other slots empty");
+    TEST_ASSERT(reg.all().size() == 3, "all");
+
+    viewer_ptr found = reg.find_if(0, 0, [](const viewer_ptr& v) { return v->id == 2; });
+    TEST_ASSERT(found == b, "find_if");
+    TEST_ASSERT(!reg.find_if(3, 1, [](const viewer_ptr& v) { return v->id == 2; }), "find_if in the wrong slot");
+    return true;
+}
+
+// out of range ids are refused,never indexed
+bool test_invalid() {
+    registry reg;
+    viewer_ptr a = std::make_shared<viewer>(1);
+    TEST_ASSERT(!reg.add(-1, 0, a), "negative chn");
+    TEST_ASSERT(!reg.add(0, -1, a), "negative stream");
+    TEST_ASSERT(!reg.add(STREAM_REGISTRY_MAX_CHN, 0, a), "chn too big");
+    TEST_ASSERT(!reg.add(0, STREAM_REGISTRY_MAX_STREAM, a), "stream too big");
+    TEST_ASSERT(!reg.add(0, 0, viewer_ptr()), "null item");
+    TEST_ASSERT(!reg.get(STREAM_REGISTRY_MAX_CHN, 0), "get out of range");
+    TEST_ASSERT(!reg.remove(-1, 0, a), "remove out of range");
+    TEST_ASSERT(reg.all().empty(), "nothing added");
+    return true;
+}
+
+// a reader's snapshot does not change under it,removed items live until it lets go
+bool test_snapshot_stable() {
+    registry reg;
+    viewer_ptr a = std::make_shared<viewer>(1);
+    viewer_ptr b = std::make_shared<viewer>(2);
+    reg.add(1, 2, a);
+    reg.add(1, 2, b);
+
+    registry::snapshot held = reg.get(1, 2);
+    TEST_ASSERT(reg.remove(1, 2, a), "remove a");
+    TEST_ASSERT(!reg.remove(1, 2, a), "a is gone");
+    TEST_ASSERT(held->size() == 2 && (*held)[0] == a, "old snapshot unchanged");
+    TEST_ASSERT(reg.get(1, 2)->size() == 1, "new snapshot without a");
+
+    TEST_ASSERT(!registry::wait_unused(a, 20), "held snapshot still uses a");
+    held.reset();
+    TEST_ASSERT(registry::wait_unused(a, 20), "a unused once the snapshot is gone");
+
+    registry::item_list removed;
+    TEST_ASSERT(reg.remove_if(1, 2, [](const viewer_ptr& v) { return v->id == 2; }, &removed) == 1, "remove_if");
+    TEST_ASSERT(removed.size() == 1 && removed[0] == b, "removed b");
+    TEST_ASSERT(reg.get(1, 2)->empty(), "slot empty");
+    return true;
+}
+
+// frame threads walk their slots while a writer adds and removes viewers.
+// a stopped viewer is never sent to,removed ones are stopped only after wait_unused
+bool test_concurrent() {
+    registry reg;
+    const int chns = 2;
+    const int streams = 2;
+    std::atomic<bool> running(true);
+    std::atomic<uint32_t> stopped_sends(0);
+    std::atomic<uint64_t> sends(0);
+
+    std::vector<std::thread> readers;
+    for (int c = 0; c < chns; c++) {
+        for (int s = 0; s < streams; s++) {
+            readers.push_back(std::thread([&, c, s] {
+                while (running) {
+                    registry::snapshot items = reg.get(c, s);
+                    if (!items) {
+                        continue;
+                    }
+                    for (size_t i = 0; i < items->size(); i++) {
+                        if ((*items)[i]->stopped) {
+                            stopped_sends++;
+                        }
+                        (*items)[i]->frames++;
+                        sends++;
+                    }
+                }
+            }));
+        }
+    }
+
+    std::vector<viewer_ptr> live;
+    for (int i = 0; i < 2000; i++) {
+        int c = i % chns;
+        int s = (i / chns) % streams;
+        viewer_ptr v = std::make_shared<viewer>(i);
+        reg.add(c, s, v);
+        live.push_back(v);
+        if (live.size() > 8) {
+            viewer_ptr old = live.front();
+            live.erase(live.begin());
+            int oc = old->id % chns;
+            int os = (old->id / chns) % streams;
+            registry::item_list removed;
+            reg.remove_if(oc, os, [&old](const viewer_ptr& x) { return x == old; }, &removed);
+            old.reset();
+            for (size_t r = 0; r < removed.size(); r++) {
+                registry::wait_unused(removed[r]);
+                removed[r]->stopped = true;
+            }
+        }
+    }
+
+    running = false;
+    for (size_t i = 0; i < readers.size(); i++) {
+        readers[i].join();
+    }
+
+    TEST_ASSERT(stopped_sends == 0, "sent to a stopped viewer");
+    TEST_ASSERT(sends > 0, "frames went out");
+    TEST_ASSERT(reg.all().size() == live.size(), "the live viewers are registered");
+    return true;
+}
+
+int main() {
+    int passed = 0;
+    int failed = 0;
+
+    std::cout << "=== stream_registry Unit Tests ===" << std::endl << std::endl;
+
+    RUN_TEST(test_add_get);
+    RUN_TEST(test_invalid);
+    RUN_TEST(test_snapshot_stable);
+    RUN_TEST(test_concurrent);
+
+    std::cout << std::endl << "=== Results ===" << std::endl;
+    std::cout << "Passed: " << passed << std::endl;
+    std::cout << "Failed: " << failed << std::endl;
+
+    return failed > 0 ? 1 : 0;
+}
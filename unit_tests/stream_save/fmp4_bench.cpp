@@ -0,0 +1,159 @@
+// Muxer throughput benchmark: fmp4_writer vs the vendor SS_MP4 muxer used by mp4_save.
+// Host build only runs fmp4_writer; build on the board with -DWITH_SS_MP4 and the
+// hisilicon_mp4 library to get both numbers from the same synthetic stream.
+//
+// usage: fmp4_bench [dir] [seconds] [kbps]
+#include "../../stream_save/fmp4_writer.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <sys/resource.h>
+#ifdef WITH_SS_MP4
+#include <ss_mp4_format.h>
+#endif
+
+using namespace ceanic::stream_save;
+using namespace ceanic::util;
+
+struct frame_t {
+    std::vector<uint8_t> data;
+    bool key;
+};
+
+// 25fps,gop 50,key frame ~8x a p frame
+static std::vector<frame_t> make_stream(int seconds, int kbps) {
+    static const uint8_t sps[] = {0, 0, 0, 1, 0x67, 0x4d, 0x00, 0x33, 0x95, 0xa0, 0x1e, 0x00};
+    static const uint8_t pps[] = {0, 0, 0, 1, 0x68, 0xee, 0x3c, 0x80};
+    const int fr = 25;
+    const int gop = 50;
+    size_t gop_bytes = (size_t)kbps * 1000 / 8 * gop / fr;
+    size_t p_len = gop_bytes / (gop - 1 + 8);
+    size_t i_len = p_len * 8;
+
+    std::vector<frame_t> frames;
+    for (int i = 0; i < seconds * fr; i++) {
+        frame_t f;
+        f.key = (i % gop == 0);
+        if (f.key) {
+            f.data.insert(f.data.end(), sps, sps + sizeof(sps));
+            f.data.insert(f.data.end(), pps, pps + sizeof(pps));
+        }
+        f.data.push_back(0); f.data.push_back(0); f.data.push_back(0); f.data.push_back(1);
+        f.data.push_back(f.key ? 0x65 : 0x41);
+        f.data.insert(f.data.end(), f.key ? i_len : p_len, (uint8_t)(0x10 + i % 0xe0));
+        frames.push_back(f);
+    }
+    return frames;
+}
+
+static long max_rss_kb() {
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    return ru.ru_maxrss;
+}
+
+static void report(const char* name, uint64_t bytes, size_t frames, double sec, long rss_beg) {
+    printf("%-10s %8.1f MB/s %9.0f frames/s %8.1f MB written, rss +%ld KB\n",
+           name, bytes / 1024.0 / 1024.0 / sec, frames / sec, bytes / 1024.0 / 1024.0, max_rss_kb() - rss_beg);
+}
+
+static void bench_fmp4(const std::vector<frame_t>& frames, const std::string& dir) {
+    media_head mh;
+    memset(&mh, 0, sizeof(mh));
+    mh.video_info.vcode = STREAM_VIDEO_ENCODE_H264;
+    mh.video_info.w = 3840;
+    mh.video_info.h = 2160;
+    mh.video_info.fr = 25;
+
+    std::string file = dir + "/bench.fmp4.mp4";
+    long rss_beg = max_rss_kb();
+    auto beg = std::chrono::steady_clock::now();
+
+    fmp4_writer w(mh, 1000, 2 * 1024 * 1024);
+    if (!w.open(file.c_str())) {
+        printf("open %s failed\n", file.c_str());
+        return;
+    }
+    uint64_t pts = 0;
+    for (auto& f : frames) {
+        w.write_video(f.data.data(), f.data.size(), pts, f.key);
+        pts += 40000;
+    }
+    w.close();
+
+    double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - beg).count();
+    report("fmp4", w.bytes(), frames.size(), sec, rss_beg);
+    remove(file.c_str());
+}
+
+#ifdef WITH_SS_MP4
+static void bench_ss_mp4(const std::vector<frame_t>& frames, const std::string& dir) {
+    std::string file = dir + "/bench.ss_mp4.mp4";
+    OT_MP4_CONFIG_S cfg;
+    memset(&cfg, 0, sizeof(cfg));
+    snprintf(cfg.aszFileName, sizeof(cfg.aszFileName), "%s", file.c_str());
+    cfg.enConfigType = OT_MP4_CONFIG_MUXER;
+    cfg.stMuxerConfig.u32VBufSize = 1024 * 1024;
+    cfg.stMuxerConfig.bConstantFps = TD_TRUE;
+    cfg.stMuxerConfig.u32PreAllocUnit = 20 * 1024 * 1024;
+
+    OT_MP4_TRACK_INFO_S info;
+    memset(&info, 0, sizeof(info));
+    info.enTrackType = OT_MP4_STREAM_VIDEO;
+    info.fSpeed = 1.0f;
+    info.u32TimeScale = 120000;
+    info.stVideoInfo.enCodecID = OT_MP4_CODEC_ID_H264;
+    info.stVideoInfo.u32BitRate = 3000;
+    info.stVideoInfo.frameRate = 25;
+    info.stVideoInfo.u32Width = 3840;
+    info.stVideoInfo.u32Height = 2160;
+
+    long rss_beg = max_rss_kb();
+    auto beg = std::chrono::steady_clock::now();
+
+    TD_MW_PTR fh = NULL;
+    TD_MW_PTR th = NULL;
+    TD_U64 duration = 0;
+    if (SS_MP4_Create(&fh, &cfg) != TD_SUCCESS || SS_MP4_CreateTrack(fh, &th, &info) != TD_SUCCESS) {
+        printf("SS_MP4_Create %s failed\n", file.c_str());
+        return;
+    }
+    uint64_t pts = 0;
+    uint64_t bytes = 0;
+    for (auto& f : frames) {
+        OT_MP4_FRAME_DATA_S fd;
+        memset(&fd, 0, sizeof(fd));
+        fd.pu8DataBuffer = (TD_U8*)f.data.data();
+        fd.u32DataLength = f.data.size();
+        fd.bKeyFrameFlag = f.key ? TD_TRUE : TD_FALSE;
+        fd.u64TimeStamp = pts;
+        SS_MP4_WriteFrame(fh, th, &fd);
+        pts += 40000;
+        bytes += f.data.size();
+    }
+    SS_MP4_DestroyAllTracks(fh, NULL);
+    SS_MP4_Destroy(fh, &duration);
+
+    double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - beg).count();
+    report("ss_mp4", bytes, frames.size(), sec, rss_beg);
+    remove(file.c_str());
+}
+#endif
+
+int main(int argc, char** argv) {
+    std::string dir = argc > 1 ? argv[1] : "/tmp";
+    int seconds = argc > 2 ? atoi(argv[2]) : 120;
+    int kbps = argc > 3 ? atoi(argv[3]) : 16000;
+
+    std::vector<frame_t> frames = make_stream(seconds, kbps);
+    printf("=== Muxer Benchmark: %d s of %d kbps h264 to %s ===\n", seconds, kbps, dir.c_str());
+
+    bench_fmp4(frames, dir);
+#ifdef WITH_SS_MP4
+    bench_ss_mp4(frames, dir);
+#endif
+    return 0;
+}
@@ -0,0 +1,230 @@
+#include "../../stream_save/fmp4_writer.h"
+#include "../../stream_save/fmp4_reader.h"
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace ceanic::stream_save;
+using namespace ceanic::util;
+
+// Test helper
+#define TEST_ASSERT(condition, message) \
+    if (!(condition)) { \
+        std::cerr << "FAILED: " << message << std::endl; \
+        return false; \
+    }
+
+#define RUN_TEST(test_func) \
+    std::cout << "Running " << #test_func << "..." << std::endl; \
+    if (test_func()) { \
+        std::cout << "  PASSED" << std::endl; \
+        passed++; \
+    } else { \
+        std::cout << "  FAILED" << std::endl; \
+        failed++; \
+    }
+
+static const char* TEST_FILE = "/tmp/fmp4_reader_test.mp4";
+static const char* TEST_INDEX = "/tmp/fmp4_reader_test.mp4.idx";
+static const uint64_t START_US = 1700000000ULL * 1000000ULL;
+
+static std::vector<uint8_t> make_h264_frame(bool key, size_t payload) {
+    static const uint8_t sps[] = {0, 0, 0, 1, 0x67, 0x4d, 0x00, 0x28, 0x95, 0xa0, 0x1e, 0x00};
+    static const uint8_t pps[] = {0, 0, 0, 1, 0x68, 0xee, 0x3c, 0x80};
+    std::vector<uint8_t> f;
+    if (key) {
+        f.insert(f.end(), sps, sps + sizeof(sps));
+        f.insert(f.end(), pps, pps + sizeof(pps));
+    }
+    f.push_back(0); f.push_back(0); f.push_back(0); f.push_back(1);
+    f.push_back(key ? 0x65 : 0x41);
+    f.insert(f.end(), payload, 0x55);
+    return f;
+}
+
+static std::vector<uint8_t> make_h265_frame(bool key, size_t payload) {
+    static const uint8_t vps[] = {0, 0, 0, 1, 0x40, 0x01, 0x0c, 0x01, 0xff, 0xff};
+    static const uint8_t sps[] = {0, 0, 0, 1, 0x42, 0x01, 0x01, 0x01, 0x60, 0x00, 0x00, 0x03, 0x00, 0x90,
+                                  0x00, 0x00, 0x03, 0x00, 0x00, 0x03, 0x00, 0x99, 0xa0};
+    static const uint8_t pps[] = {0, 0, 0, 1, 0x44, 0x01, 0xc1, 0x72};
+    std::vector<uint8_t> f;
+    if (key) {
+        f.insert(f.end(), vps, vps + sizeof(vps));
+        f.insert(f.end(), sps, sps + sizeof(sps));
+        f.insert(f.end(), pps, pps + sizeof(pps));
+    }
+    f.push_back(0); f.push_back(0); f.push_back(0); f.push_back(1);
+    f.push_back(key ? 0x26 : 0x02);
+    f.push_back(0x01);
+    f.insert(f.end(), payload, 0x55);
+    return f;
+}
+
+static media_head make_head(uint8_t vcode, uint8_t acode) {
+    media_head mh;
+    memset(&mh, 0, sizeof(mh));
+    mh.video_info.vcode = vcode;
+    mh.video_info.w = 1920;
+    mh.video_info.h = 1080;
+    mh.video_info.fr = 25;
+    mh.audio_info.acode = acode;
+    mh.audio_info.sample_rate = 8000;
+    mh.audio_info.chn = 1;
+    mh.audio_info.bit_width = 16;
+    return mh;
+}
+
+// 25fps, one key frame per second, one fragment per GOP
+static bool write_h264(int seconds) {
+    fmp4_writer w(make_head(STREAM_VIDEO_ENCODE_H264, STREAM_AUDIO_ENCODE_NONE), 1000, 4 * 1024 * 1024);
+    if (!w.open(TEST_FILE)) {
+        return false;
+    }
+    for (int i = 0; i < seconds * 25; i++) {
+        std::vector<uint8_t> f = make_h264_frame(i % 25 == 0, 1000 + i);
+        w.write_video(f.data(), f.size(), START_US + (uint64_t)i * 40000, i % 25 == 0);
+    }
+    w.close();
+    return true;
+}
+
+bool test_h264_round_trip() {
+    TEST_ASSERT(write_h264(4), "Writer should open");
+
+    fmp4_reader r;
+    TEST_ASSERT(r.open(TEST_FILE), "Reader should open");
+    media_head mh = r.get_media_head();
+    TEST_ASSERT(mh.video_info.vcode == STREAM_VIDEO_ENCODE_H264, "Should be h264");
+    TEST_ASSERT(mh.video_info.w == 1920 && mh.video_info.h == 1080, "Should carry resolution");
+    TEST_ASSERT(mh.video_info.fr == 25, "Should estimate frame rate");
+    TEST_ASSERT(mh.audio_info.acode == STREAM_AUDIO_ENCODE_NONE, "Should have no audio");
+    TEST_ASSERT(r.start_time() == START_US, "Start time should come from the index");
+    TEST_ASSERT(r.duration() == 99 * 40, "Duration should be the last sample time");
+
+    const std::vector<uint8_t>& ps = r.param_sets();
+    TEST_ASSERT(ps.size() == 4 + 8 + 4 + 4, "Should hold sps and pps");
+    TEST_ASSERT(ps[4] == 0x67 && ps[16] == 0x68, "Param sets should be length prefixed");
+
+    fmp4_reader::sample_t s;
+    int count = 0;
+    while (r.next_sample(s)) {
+        TEST_ASSERT(s.video, "Should only have video");
+        TEST_ASSERT(s.time == (uint32_t)count * 40, "Sample time should follow pts");
+        TEST_ASSERT(s.key == (count % 25 == 0), "Key flag should round trip");
+        TEST_ASSERT(s.len == 4 + 1 + 1000 + (uint32_t)count, "Sample should drop param sets");
+        TEST_ASSERT(s.data[4] == (s.key ? 0x65 : 0x41), "Sample should be length prefixed");
+        count++;
+    }
+    TEST_ASSERT(count == 100, "Should read every frame");
+    return true;
+}
+
+bool test_seek_with_index() {
+    TEST_ASSERT(write_h264(4), "Writer should open");
+
+    fmp4_reader r;
+    TEST_ASSERT(r.open(TEST_FILE), "Reader should open");
+
+    uint32_t key_time = 0;
+    fmp4_reader::sample_t s;
+    TEST_ASSERT(r.seek(2500, &key_time), "Seek should succeed");
+    TEST_ASSERT(key_time == 2000, "Seek should land on the previous key frame");
+    TEST_ASSERT(r.next_sample(s) && s.key && s.time == 2000, "First sample after seek should be the key frame");
+
+    TEST_ASSERT(r.seek(0, &key_time) && key_time == 0, "Seek to start");
+    TEST_ASSERT(r.next_sample(s) && s.time == 0, "First sample should be at 0");
+
+    TEST_ASSERT(r.seek(60000, &key_time) && key_time == 3000, "Seek past the end should use the last key frame");
+    return true;
+}
+
+bool test_seek_without_index() {
+    TEST_ASSERT(write_h264(3), "Writer should open");
+    remove(TEST_INDEX);
+
+    fmp4_reader r;
+    TEST_ASSERT(r.open(TEST_FILE), "Reader should open without index");
+    TEST_ASSERT(r.start_time() == 0, "Start time is unknown without index");
+
+    uint32_t key_time = 0;
+    fmp4_reader::sample_t s;
+    TEST_ASSERT(r.seek(1999, &key_time) && key_time == 1000, "Index should be rebuilt from the fragments");
+    TEST_ASSERT(r.next_sample(s) && s.key && s.time == 1000, "First sample after seek should be the key frame");
+    return true;
+}
+
+bool test_h265_audio_interleaved() {
+    fmp4_writer w(make_head(STREAM_VIDEO_ENCODE_H265, STREAM_AUDIO_ENCODE_G711U), 1000, 4 * 1024 * 1024);
+    TEST_ASSERT(w.open(TEST_FILE), "Writer should open");
+    std::vector<uint8_t> pcm(320, 0xff);
+    for (int i = 0; i < 50; i++) {
+        std::vector<uint8_t> f = make_h265_frame(i % 25 == 0, 500);
+        w.write_video(f.data(), f.size(), START_US + (uint64_t)i * 40000, i % 25 == 0);
+        // 40ms of 8k g711 per video frame
+        w.write_audio(pcm.data(), pcm.size(), START_US + (uint64_t)i * 40000);
+    }
+    w.close();
+
+    fmp4_reader r;
+    TEST_ASSERT(r.open(TEST_FILE), "Reader should open");
+    media_head mh = r.get_media_head();
+    TEST_ASSERT(mh.video_info.vcode == STREAM_VIDEO_ENCODE_H265, "Should be h265");
+    TEST_ASSERT(mh.audio_info.acode == STREAM_AUDIO_ENCODE_G711U, "Should be g711u");
+    TEST_ASSERT(mh.audio_info.sample_rate == 8000 && mh.audio_info.chn == 1, "Should carry audio format");
+    TEST_ASSERT(r.param_sets().size() == 3 * 4 + 6 + 19 + 4, "Should hold vps,sps and pps");
+
+    fmp4_reader::sample_t s;
+    uint32_t last = 0;
+    int video = 0;
+    int audio = 0;
+    while (r.next_sample(s)) {
+        TEST_ASSERT(s.time >= last, "Samples should be in time order");
+        last = s.time;
+        if (s.video) {
+            video++;
+        } else {
+            TEST_ASSERT(s.len == 320, "Audio frame should round trip");
+            audio++;
+        }
+    }
+    TEST_ASSERT(video == 50 && audio == 50, "Should read both tracks");
+    return true;
+}
+
+bool test_reject_bad_file() {
+    FILE* f = fopen(TEST_FILE, "wb");
+    TEST_ASSERT(f != NULL, "Should create file");
+    fwrite("not an mp4 file", 1, 15, f);
+    fclose(f);
+    remove(TEST_INDEX);
+
+    fmp4_reader r;
+    TEST_ASSERT(!r.open(TEST_FILE), "Should reject non mp4");
+    TEST_ASSERT(!r.open("/tmp/fmp4_reader_test_missing.mp4"), "Should reject missing file");
+    return true;
+}
+
+int main() {
+    int passed = 0;
+    int failed = 0;
+
+    std::cout << "=== fMP4 Reader Unit Tests ===" << std::endl;
+
+    RUN_TEST(test_h264_round_trip);
+    RUN_TEST(test_seek_with_index);
+    RUN_TEST(test_seek_without_index);
+    RUN_TEST(test_h265_audio_interleaved);
+    RUN_TEST(test_reject_bad_file);
+
+    remove(TEST_FILE);
+    remove(TEST_INDEX);
+
+    std::cout << std::endl;
+    std::cout << "=== Results ===" << std::endl;
+    std::cout << "Passed: " << passed << std::endl;
+    std::cout << "Failed: " << failed << std::endl;
+
+    return (failed == 0) ? 0 : 1;
+}
@@ -0,0 +1,288 @@
+#include "../../stream_save/fmp4_writer.h"
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace ceanic::stream_save;
+using namespace ceanic::util;
+
+// Test helper
+#define TEST_ASSERT(condition, message) \
+    if (!(condition)) { \
+        std::cerr << "FAILED: " << message << std::endl; \
+        return false; \
+    }
+
+#define RUN_TEST(test_func) \
+    std::cout << "Running " << #test_func << "..." << std::endl; \
+    if (test_func()) { \
+        std::cout << "  PASSED" << std::endl; \
+        passed++; \
+    } else { \
+        std::cout << "  FAILED" << std::endl; \
+        failed++; \
+    }
+
+static const char* TEST_FILE = "/tmp/fmp4_writer_test.mp4";
+
+struct box_t {
+    std::string type;
+    size_t pos;
+    uint32_t size;
+};
+
+static uint32_t rd32(const std::vector<uint8_t>& b, size_t pos) {
+    return ((uint32_t)b[pos] << 24) | ((uint32_t)b[pos + 1] << 16) | ((uint32_t)b[pos + 2] << 8) | b[pos + 3];
+}
+
+static std::vector<uint8_t> read_file(const char* file) {
+    std::vector<uint8_t> data;
+    FILE* f = fopen(file, "rb");
+    if (f == NULL) {
+        return data;
+    }
+    uint8_t buf[4096];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) {
+        data.insert(data.end(), buf, buf + n);
+    }
+    fclose(f);
+    return data;
+}
+
+// Split [beg,end) into boxes, false if sizes do not add up
+static bool parse_boxes(const std::vector<uint8_t>& b, size_t beg, size_t end, std::vector<box_t>& boxes) {
+    size_t pos = beg;
+    while (pos + 8 <= end) {
+        box_t box;
+        box.pos = pos;
+        box.size = rd32(b, pos);
+        box.type.assign((const char*)&b[pos + 4], 4);
+        if (box.size < 8 || pos + box.size > end) {
+            return false;
+        }
+        boxes.push_back(box);
+        pos += box.size;
+    }
+    return pos == end;
+}
+
+static const box_t* find_box(const std::vector<box_t>& boxes, const char* type) {
+    for (auto& box : boxes) {
+        if (box.type == type) {
+            return &box;
+        }
+    }
+    return NULL;
+}
+
+static std::vector<uint8_t> make_h264_frame(bool key, size_t payload) {
+    static const uint8_t sps[] = {0, 0, 0, 1, 0x67, 0x4d, 0x00, 0x28, 0x95, 0xa0, 0x1e, 0x00};
+    static const uint8_t pps[] = {0, 0, 0, 1, 0x68, 0xee, 0x3c, 0x80};
+    std::vector<uint8_t> f;
+    if (key) {
+        f.insert(f.end(), sps, sps + sizeof(sps));
+        f.insert(f.end(), pps, pps + sizeof(pps));
+    }
+    f.push_back(0); f.push_back(0); f.push_back(0); f.push_back(1);
+    f.push_back(key ? 0x65 : 0x41);
+    f.insert(f.end(), payload, 0x55);
+    return f;
+}
+
+static std::vector<uint8_t> make_h265_frame(bool key, size_t payload) {
+    static const uint8_t vps[] = {0, 0, 0, 1, 0x40, 0x01, 0x0c, 0x01, 0xff, 0xff};
+    // sps: header,ids(max_sub_layers_minus1=0,nesting=1),ptl(main,level 5.1)
+    static const uint8_t sps[] = {0, 0, 0, 1, 0x42, 0x01, 0x01, 0x01, 0x60, 0x00, 0x00, 0x03, 0x00, 0x90,
+                                  0x00, 0x00, 0x03, 0x00, 0x00, 0x03, 0x00, 0x99, 0xa0};
+    static const uint8_t pps[] = {0, 0, 0, 1, 0x44, 0x01, 0xc1, 0x72};
+    std::vector<uint8_t> f;
+    if (key) {
+        f.insert(f.end(), vps, vps + sizeof(vps));
+        f.insert(f.end(), sps, sps + sizeof(sps));
+        f.insert(f.end(), pps, pps + sizeof(pps));
+    }
+    f.push_back(0); f.push_back(0); f.push_back(0); f.push_back(1);
+    f.push_back(key ? 0x26 : 0x02);
+    f.push_back(0x01);
+    f.insert(f.end(), payload, 0x55);
+    return f;
+}
+
+static media_head make_head(uint8_t vcode, uint8_t acode) {
+    media_head mh;
+    memset(&mh, 0, sizeof(mh));
+    mh.video_info.vcode = vcode;
+    mh.video_info.w = 1920;
+    mh.video_info.h = 1080;
+    mh.video_info.fr = 25;
+    mh.audio_info.acode = acode;
+    mh.audio_info.sample_rate = 8000;
+    mh.audio_info.bit_width = 16;
+    mh.audio_info.chn = 1;
+    return mh;
+}
+
+// Test: file is ftyp+moov followed by one moof+mdat per GOP
+bool test_h264_fragment_per_gop() {
+    fmp4_writer w(make_head(STREAM_VIDEO_ENCODE_H264, STREAM_AUDIO_ENCODE_NONE), 0, 8 * 1024 * 1024);
+    TEST_ASSERT(w.open(TEST_FILE), "Should open file");
+
+    uint64_t pts = 1000000;
+    for (int i = 0; i < 100; i++) {
+        std::vector<uint8_t> f = make_h264_frame(i % 25 == 0, i % 25 == 0 ? 20000 : 2000);
+        TEST_ASSERT(w.write_video(f.data(), f.size(), pts, i % 25 == 0), "Should write frame");
+        pts += 40000;
+    }
+    w.close();
+
+    std::vector<uint8_t> data = read_file(TEST_FILE);
+    std::vector<box_t> boxes;
+    TEST_ASSERT(parse_boxes(data, 0, data.size(), boxes), "Top level box sizes should cover the file");
+    TEST_ASSERT(boxes.size() == 2 + 4 * 2, "Should have ftyp,moov and 4 moof/mdat pairs");
+    TEST_ASSERT(boxes[0].type == "ftyp" && boxes[1].type == "moov", "Should start with init segment");
+    for (size_t i = 2; i < boxes.size(); i += 2) {
+        TEST_ASSERT(boxes[i].type == "moof" && boxes[i + 1].type == "mdat", "Should alternate moof/mdat");
+    }
+    TEST_ASSERT(w.fragments() == 4, "Should count 4 fragments");
+
+    // first fragment: 25 samples, data offset points just past the mdat header
+    std::vector<box_t> moof;
+    TEST_ASSERT(parse_boxes(data, boxes[2].pos + 8, boxes[2].pos + boxes[2].size, moof), "moof children should parse");
+    const box_t* traf = find_box(moof, "traf");
+    TEST_ASSERT(traf != NULL, "Should have traf");
+    std::vector<box_t> traf_children;
+    TEST_ASSERT(parse_boxes(data, traf->pos + 8, traf->pos + traf->size, traf_children), "traf children should parse");
+    const box_t* trun = find_box(traf_children, "trun");
+    TEST_ASSERT(trun != NULL, "Should have trun");
+    TEST_ASSERT(rd32(data, trun->pos + 12) == 25, "Fragment should hold one GOP");
+    TEST_ASSERT(rd32(data, trun->pos + 16) == boxes[2].size + 8, "Data offset should point into mdat");
+    TEST_ASSERT(rd32(data, trun->pos + 20) == 3600, "Sample duration should be 40ms in 90kHz");
+    TEST_ASSERT(rd32(data, trun->pos + 28) == 0x02000000, "First sample should be sync");
+    TEST_ASSERT(rd32(data, trun->pos + 40) == 0x01010000, "Second sample should be non-sync");
+
+    // sps/pps moved to avcC,first sample is the length prefixed idr
+    uint32_t first_size = rd32(data, trun->pos + 24);
+    TEST_ASSERT(first_size == 4 + 1 + 20000, "Key sample should only hold the idr nalu");
+    size_t mdat_payload = boxes[3].pos + 8;
+    TEST_ASSERT(rd32(data, mdat_payload) == 20001 && data[mdat_payload + 4] == 0x65, "Sample should be length prefixed");
+    return true;
+}
+
+// Test: a file cut after the last fragment is still complete up to it
+bool test_truncated_file_keeps_fragments() {
+    fmp4_writer w(make_head(STREAM_VIDEO_ENCODE_H264, STREAM_AUDIO_ENCODE_NONE), 0, 8 * 1024 * 1024);
+    TEST_ASSERT(w.open(TEST_FILE), "Should open file");
+
+    uint64_t pts = 0;
+    for (int i = 0; i < 60; i++) {
+        std::vector<uint8_t> f = make_h264_frame(i % 25 == 0, 1000);
+        w.write_video(f.data(), f.size(), pts, i % 25 == 0);
+        pts += 40000;
+    }
+
+    // not closed: the open GOP is only in memory,what is on disk must parse
+    std::vector<uint8_t> data = read_file(TEST_FILE);
+    std::vector<box_t> boxes;
+    TEST_ASSERT(parse_boxes(data, 0, data.size(), boxes), "On disk data should end on a box boundary");
+    TEST_ASSERT(boxes.size() == 2 + 2 * 2, "Two completed GOPs should be on disk");
+    w.close();
+    return true;
+}
+
+// Test: fragment_size bounds memory inside a long GOP
+bool test_fragment_size_limit() {
+    fmp4_writer w(make_head(STREAM_VIDEO_ENCODE_H264, STREAM_AUDIO_ENCODE_NONE), 1000, 64 * 1024);
+    TEST_ASSERT(w.open(TEST_FILE), "Should open file");
+
+    uint64_t pts = 0;
+    for (int i = 0; i < 100; i++) {
+        std::vector<uint8_t> f = make_h264_frame(i == 0, 10000);
+        w.write_video(f.data(), f.size(), pts, i == 0);
+        pts += 40000;
+    }
+    w.close();
+
+    TEST_ASSERT(w.fragments() >= 100 * 10000 / (64 * 1024), "Should split the GOP by size");
+    std::vector<uint8_t> data = read_file(TEST_FILE);
+    std::vector<box_t> boxes;
+    TEST_ASSERT(parse_boxes(data, 0, data.size(), boxes), "Box sizes should cover the file");
+    return true;
+}
+
+// Test: frames before the first key frame are dropped
+bool test_wait_key_frame() {
+    fmp4_writer w(make_head(STREAM_VIDEO_ENCODE_H264, STREAM_AUDIO_ENCODE_G711U), 0, 8 * 1024 * 1024);
+    TEST_ASSERT(w.open(TEST_FILE), "Should open file");
+
+    std::vector<uint8_t> p = make_h264_frame(false, 100);
+    TEST_ASSERT(!w.write_video(p.data(), p.size(), 0, false), "P frame before key should be dropped");
+    uint8_t pcm[160];
+    memset(pcm, 0xff, sizeof(pcm));
+    TEST_ASSERT(!w.write_audio(pcm, sizeof(pcm), 0), "Audio before key should be dropped");
+    std::vector<uint8_t> i = make_h264_frame(true, 100);
+    TEST_ASSERT(w.write_video(i.data(), i.size(), 40000, true), "Key frame should be written");
+    TEST_ASSERT(w.write_audio(pcm, sizeof(pcm), 50000), "Audio after key should be written");
+    w.close();
+    return true;
+}
+
+// Test: h265 sample entry and g711 audio track
+bool test_h265_with_audio() {
+    fmp4_writer w(make_head(STREAM_VIDEO_ENCODE_H265, STREAM_AUDIO_ENCODE_G711U), 0, 8 * 1024 * 1024);
+    TEST_ASSERT(w.open(TEST_FILE), "Should open file");
+
+    uint64_t pts = 0;
+    uint8_t pcm[320];
+    memset(pcm, 0xff, sizeof(pcm));
+    for (int i = 0; i < 50; i++) {
+        std::vector<uint8_t> f = make_h265_frame(i % 25 == 0, 3000);
+        TEST_ASSERT(w.write_video(f.data(), f.size(), pts, i % 25 == 0), "Should write h265 frame");
+        TEST_ASSERT(w.write_audio(pcm, sizeof(pcm), pts), "Should write audio frame");
+        pts += 40000;
+    }
+    w.close();
+
+    std::vector<uint8_t> data = read_file(TEST_FILE);
+    std::vector<box_t> boxes;
+    TEST_ASSERT(parse_boxes(data, 0, data.size(), boxes), "Box sizes should cover the file");
+    std::string all(data.begin(), data.begin() + boxes[1].pos + boxes[1].size);
+    TEST_ASSERT(all.find("hvc1") != std::string::npos && all.find("hvcC") != std::string::npos, "Should use hvc1/hvcC");
+    TEST_ASSERT(all.find("ulaw") != std::string::npos, "Should have g711 sample entry");
+    size_t hvcc = all.find("hvcC");
+    TEST_ASSERT((uint8_t)all[hvcc + 5] == 0x01, "hvcC should carry profile from sps");
+    TEST_ASSERT((uint8_t)all[hvcc + 16] == 0x99, "hvcC should carry level from unescaped sps");
+
+    std::vector<box_t> moof;
+    TEST_ASSERT(parse_boxes(data, boxes[2].pos + 8, boxes[2].pos + boxes[2].size, moof), "moof should parse");
+    int trafs = 0;
+    for (auto& b : moof) {
+        trafs += (b.type == "traf");
+    }
+    TEST_ASSERT(trafs == 2, "Fragment should hold video and audio");
+    return true;
+}
+
+int main() {
+    int passed = 0;
+    int failed = 0;
+
+    std::cout << "=== fMP4 Writer Unit Tests ===" << std::endl;
+
+    RUN_TEST(test_h264_fragment_per_gop);
+    RUN_TEST(test_truncated_file_keeps_fragments);
+    RUN_TEST(test_fragment_size_limit);
+    RUN_TEST(test_wait_key_frame);
+    RUN_TEST(test_h265_with_audio);
+
+    remove(TEST_FILE);
+
+    std::cout << std::endl;
+    std::cout << "=== Results ===" << std::endl;
+    std::cout << "Passed: " << passed << std::endl;
+    std::cout << "Failed: " << failed << std::endl;
+
+    return (failed == 0) ? 0 : 1;
+}
@@ -0,0 +1,232 @@
+#include "../../stream_save/segment_pool.h"
+#include "../../stream_save/fmp4_writer.h"
+#include "../../stream_save/fmp4_reader.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <sys/stat.h>
+
+using namespace ceanic::stream_save;
+using namespace ceanic::util;
+
+// Test helper
+#define TEST_ASSERT(condition, message) \
+    if (!(condition)) { \
+        std::cerr << "FAILED: " << message << std::endl; \
+        return false; \
+    }
+
+#define RUN_TEST(test_func) \
+    std::cout << "Running " << #test_func << "..." << std::endl; \
+    if (test_func()) { \
+        std::cout << "  PASSED" << std::endl; \
+        passed++; \
+    } else { \
+        std::cout << "  FAILED" << std::endl; \
+        failed++; \
+    }
+
+static const char* TEST_DIR = "/tmp/segment_pool_test";
+static const uint64_t START_US = 1700000000ULL * 1000000ULL;
+
+static segment_pool_param make_param(uint32_t count) {
+    segment_pool_param param = segment_pool::default_param();
+    snprintf(param.dir_path, sizeof(param.dir_path), "%s", TEST_DIR);
+    param.count = count;
+    param.segment_size = 1024 * 1024;
+    param.max_keys = 64;
+    return param;
+}
+
+static void clean_dir() {
+    std::string cmd = std::string("rm -rf ") + TEST_DIR;
+    if (system(cmd.c_str()) != 0) {
+        std::cerr << "cleanup failed" << std::endl;
+    }
+}
+
+static uint64_t file_size(const std::string& file) {
+    struct stat st;
+    return stat(file.c_str(), &st) == 0 ? st.st_size : 0;
+}
+
+// Forwards the writer index to one pool slot, as fmp4_save does
+class slot_sink : public fmp4_index_sink {
+public:
+    slot_sink(segment_pool& pool, int32_t slot) : m_pool(pool), m_slot(slot) {}
+    void on_index_start(uint64_t start_time) override { m_pool.set_start_time(m_slot, start_time); }
+    void on_index_entry(const fmp4_index_entry& entry) override { m_pool.add_key(m_slot, entry); }
+    void on_index_update(uint64_t bytes, uint32_t end_time) override { m_pool.update(m_slot, bytes, end_time); }
+
+private:
+    segment_pool& m_pool;
+    int32_t m_slot;
+};
+
+static std::vector<uint8_t> make_h264_frame(bool key, size_t payload) {
+    static const uint8_t sps[] = {0, 0, 0, 1, 0x67, 0x4d, 0x00, 0x28, 0x95, 0xa0, 0x1e, 0x00};
+    static const uint8_t pps[] = {0, 0, 0, 1, 0x68, 0xee, 0x3c, 0x80};
+    std::vector<uint8_t> f;
+    if (key) {
+        f.insert(f.end(), sps, sps + sizeof(sps));
+        f.insert(f.end(), pps, pps + sizeof(pps));
+    }
+    f.push_back(0); f.push_back(0); f.push_back(0); f.push_back(1);
+    f.push_back(key ? 0x65 : 0x41);
+    f.insert(f.end(), payload, 0x55);
+    return f;
+}
+
+// 25fps, one key frame per second
+static bool record(segment_pool& pool, int seconds, uint64_t start_us, std::string& file, int32_t& slot) {
+    media_head mh;
+    memset(&mh, 0, sizeof(mh));
+    mh.video_info.vcode = STREAM_VIDEO_ENCODE_H264;
+    mh.video_info.w = 1280;
+    mh.video_info.h = 720;
+    mh.video_info.fr = 25;
+
+    slot = pool.acquire(mh.video_info.vcode, mh.audio_info.acode, file);
+    if (slot < 0) {
+        return false;
+    }
+
+    slot_sink sink(pool, slot);
+    fmp4_writer w(mh, 1000, 512 * 1024);
+    if (!w.open(file.c_str(), &sink)) {
+        return false;
+    }
+    for (int i = 0; i < seconds * 25; i++) {
+        std::vector<uint8_t> f = make_h264_frame(i % 25 == 0, 2000);
+        w.write_video(f.data(), f.size(), start_us + (uint64_t)i * 40000, i % 25 == 0);
+    }
+    w.close();
+    pool.release(slot);
+    return true;
+}
+
+bool test_format_preallocates() {
+    clean_dir();
+    segment_pool_param param = make_param(4);
+    segment_pool pool(&param);
+    TEST_ASSERT(pool.open(), "Pool should format on first open");
+    for (uint32_t i = 0; i < 4; i++) {
+        TEST_ASSERT(file_size(pool.segment_file(i)) == param.segment_size, "Segment should be preallocated");
+        segment_info info;
+        TEST_ASSERT(pool.get_info(i, &info) && info.state == SEGMENT_EMPTY, "Segment should start empty");
+    }
+    TEST_ASSERT(file_size(std::string(TEST_DIR) + "/" + SEGMENT_POOL_INDEX) > 0, "Index should exist");
+    return true;
+}
+
+bool test_circular_recycle() {
+    clean_dir();
+    segment_pool_param param = make_param(3);
+    segment_pool pool(&param);
+    TEST_ASSERT(pool.open(), "Pool should open");
+
+    std::string file;
+    int32_t order[5];
+    for (int i = 0; i < 5; i++) {
+        order[i] = pool.acquire(STREAM_VIDEO_ENCODE_H264, STREAM_AUDIO_ENCODE_NONE, file);
+        TEST_ASSERT(order[i] >= 0, "Acquire should succeed");
+        TEST_ASSERT(file == pool.segment_file(order[i]), "File should match the slot");
+        pool.release(order[i]);
+    }
+    TEST_ASSERT(order[0] == 0 && order[1] == 1 && order[2] == 2, "Empty slots should be used first");
+    TEST_ASSERT(order[3] == 0 && order[4] == 1, "Oldest segment should be recycled");
+
+    int32_t busy = pool.acquire(STREAM_VIDEO_ENCODE_H264, STREAM_AUDIO_ENCODE_NONE, file);
+    int32_t next = pool.acquire(STREAM_VIDEO_ENCODE_H264, STREAM_AUDIO_ENCODE_NONE, file);
+    TEST_ASSERT(busy == 2 && next == 0, "A recording segment should not be handed out twice");
+    return true;
+}
+
+bool test_reload_after_power_loss() {
+    clean_dir();
+    segment_pool_param param = make_param(3);
+    std::string file;
+    {
+        segment_pool pool(&param);
+        TEST_ASSERT(pool.open(), "Pool should open");
+        int32_t slot = pool.acquire(STREAM_VIDEO_ENCODE_H264, STREAM_AUDIO_ENCODE_NONE, file);
+        pool.release(slot);
+        slot = pool.acquire(STREAM_VIDEO_ENCODE_H264, STREAM_AUDIO_ENCODE_NONE, file);
+        pool.update(slot, 4096, 1000);
+        // no release, as after a power loss
+    }
+
+    segment_pool pool(&param);
+    TEST_ASSERT(pool.open(), "Pool should reload");
+    segment_info info;
+    TEST_ASSERT(pool.get_info(1, &info) && info.state == SEGMENT_CLOSED, "Cut segment should be closed");
+    TEST_ASSERT(info.used == 4096, "Cut segment should keep its last update");
+    int32_t slot = pool.acquire(STREAM_VIDEO_ENCODE_H264, STREAM_AUDIO_ENCODE_NONE, file);
+    TEST_ASSERT(slot == 2, "Sequence should continue after reload");
+
+    segment_pool_param other = param;
+    other.count = 5;
+    segment_pool resized(&other);
+    TEST_ASSERT(resized.open(), "Changed layout should reformat");
+    TEST_ASSERT(resized.get_info(1, &info) && info.state == SEGMENT_EMPTY, "Reformatted pool should be empty");
+    return true;
+}
+
+bool test_reused_segment_reads_new_data_only() {
+    clean_dir();
+    segment_pool_param param = make_param(1);
+    segment_pool pool(&param);
+    TEST_ASSERT(pool.open(), "Pool should open");
+
+    std::string file;
+    int32_t slot;
+    TEST_ASSERT(record(pool, 8, START_US, file, slot), "First recording should succeed");
+    TEST_ASSERT(record(pool, 3, START_US + 3600ULL * 1000000, file, slot), "Second recording should reuse the segment");
+    TEST_ASSERT(file_size(file) == param.segment_size, "Segment should keep its size");
+
+    segment_info info;
+    TEST_ASSERT(pool.get_info(slot, &info), "Info should be available");
+    TEST_ASSERT(info.start_time == START_US + 3600ULL * 1000000, "Start time should be the new recording");
+    TEST_ASSERT(info.end_time == info.start_time + 3000ULL * 1000, "End time should cover the recording");
+    TEST_ASSERT(info.key_count == 3, "Should index one key per fragment");
+    TEST_ASSERT(pool.find(info.start_time + 1500000) == slot, "Should find the segment by time");
+    TEST_ASSERT(pool.find(START_US) < 0, "Overwritten time should not be found");
+
+    fmp4_reader r;
+    TEST_ASSERT(r.open(file.c_str()), "Reader should open the segment");
+    TEST_ASSERT(r.start_time() == info.start_time, "Reader should use the pool index");
+    fmp4_reader::sample_t s;
+    int count = 0;
+    while (r.next_sample(s)) {
+        count++;
+    }
+    TEST_ASSERT(count == 75, "Stale fragments of the old recording should be hidden");
+
+    uint32_t key_time = 0;
+    TEST_ASSERT(r.seek(2100, &key_time) && key_time == 2000, "Seek should use the pool index");
+    return true;
+}
+
+int main() {
+    int passed = 0;
+    int failed = 0;
+
+    std::cout << "=== Segment Pool Unit Tests ===" << std::endl;
+
+    RUN_TEST(test_format_preallocates);
+    RUN_TEST(test_circular_recycle);
+    RUN_TEST(test_reload_after_power_loss);
+    RUN_TEST(test_reused_segment_reads_new_data_only);
+
+    clean_dir();
+
+    std::cout << std::endl;
+    std::cout << "=== Results ===" << std::endl;
+    std::cout << "Passed: " << passed << std::endl;
+    std::cout << "Failed: " << failed << std::endl;
+
+    return (failed == 0) ? 0 : 1;
+}
@@ -0,0 +1,300 @@
+#include "../../tracker/mot_tracker.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+using namespace ceanic::tracker;
+
+// Test helper
+#define TEST_ASSERT(condition, message) \
+    if (!(condition)) { \
+        std::cerr << "FAILED: " << message << std::endl; \
+        return false; \
+    }
+
+#define RUN_TEST(test_func) \
+    std::cout << "Running " << #test_func << "..." << std::endl; \
+    if (test_func()) { \
+        std::cout << "  PASSED" << std::endl; \
+        passed++; \
+    } else { \
+        std::cout << "  FAILED" << std::endl; \
+        failed++; \
+    }
+
+// Synthetic object moving at constant speed, boxes in model pixels
+struct object {
+    float x, y, w, h, vx, vy;
+    int32_t class_id;
+
+    detection at(int frame, float score = 0.9f) const {
+        detection d;
+        d.x1 = x + vx * frame;
+        d.y1 = y + vy * frame;
+        d.x2 = d.x1 + w;
+        d.y2 = d.y1 + h;
+        d.score = score;
+        d.class_id = class_id;
+        return d;
+    }
+};
+
+static const track* find_track(const std::vector<track>& tracks, uint32_t id) {
+    for (size_t i = 0; i < tracks.size(); i++) {
+        if (tracks[i].id == id) {
+            return &tracks[i];
+        }
+    }
+    return NULL;
+}
+
+// nearest reported track to a detection
+static const track* match(const std::vector<track>& tracks, const detection& d) {
+    const track* best = NULL;
+    float best_iou = 0;
+    for (size_t i = 0; i < tracks.size(); i++) {
+        float v = mot_tracker::iou(tracks[i].x1, tracks[i].y1, tracks[i].x2, tracks[i].y2, d.x1, d.y1, d.x2, d.y2);
+        if (v > best_iou) {
+            best_iou = v;
+            best = &tracks[i];
+        }
+    }
+    return best;
+}
+
+static float center_error(const track& t, const detection& d) {
+    float dx = (t.x1 + t.x2) / 2 - (d.x1 + d.x2) / 2;
+    float dy = (t.y1 + t.y2) / 2 - (d.y1 + d.y2) / 2;
+    return std::sqrt(dx * dx + dy * dy);
+}
+
+// brute force over all column orders, the reference for small matrices
+static float best_cost(const std::vector<float>& cost, int rows, int cols) {
+    std::vector<int> perm(cols);
+    for (int i = 0; i < cols; i++) {
+        perm[i] = i;
+    }
+    float best = 1e30f;
+    do {
+        float sum = 0;
+        for (int r = 0; r < rows && r < cols; r++) {
+            sum += cost[r * cols + perm[r]];
+        }
+        best = std::min(best, sum);
+    } while (std::next_permutation(perm.begin(), perm.end()));
+    return best;
+}
+
+bool test_hungarian() {
+    srand(1);
+    for (int round = 0; round < 200; round++) {
+        int rows = 1 + rand() % 6;
+        int cols = rows;
+        std::vector<float> cost(rows * cols);
+        for (size_t i = 0; i < cost.size(); i++) {
+            cost[i] = (rand() % 1000) / 100.0f;
+        }
+
+        std::vector<int32_t> r2c;
+        mot_tracker::hungarian(cost, rows, cols, r2c);
+        float sum = 0;
+        std::vector<bool> used(cols, false);
+        for (int r = 0; r < rows; r++) {
+            TEST_ASSERT(r2c[r] >= 0 && r2c[r] < cols && !used[r2c[r]], "a distinct column per row");
+            used[r2c[r]] = true;
+            sum += cost[r * cols + r2c[r]];
+        }
+        TEST_ASSERT(std::fabs(sum - best_cost(cost, rows, cols)) < 1e-3f, "minimum cost");
+    }
+
+    //more rows than columns,the cheapest rows win
+    std::vector<float> cost = {5, 1,
+                               0, 9,
+                               3, 3};
+    std::vector<int32_t> r2c;
+    mot_tracker::hungarian(cost, 3, 2, r2c);
+    TEST_ASSERT(r2c[0] == 1 && r2c[1] == 0 && r2c[2] == -1, "rectangular assignment");
+    return true;
+}
+
+// one object walking across the frame keeps its id
+bool test_single_object() {
+    mot_tracker t;
+    object o = {20, 100, 60, 120, 4, 1, 0};
+    uint32_t id = 0;
+    for (int f = 0; f < 100; f++) {
+        const std::vector<track>& out = t.update({o.at(f)});
+        if (f == 0) {
+            TEST_ASSERT(out.empty(), "tentative until min_hits");
+            continue;
+        }
+        TEST_ASSERT(out.size() == 1, "one track");
+        if (id == 0) {
+            id = out[0].id;
+        }
+        TEST_ASSERT(out[0].id == id, "stable id");
+        TEST_ASSERT(center_error(out[0], o.at(f)) < 3, "box follows the object");
+    }
+    const track* tr = find_track(t.tracks(), id);
+    TEST_ASSERT(tr && std::fabs(tr->vx - 4) < 0.3f && std::fabs(tr->vy - 1) < 0.3f, "velocity estimated");
+    return true;
+}
+
+// two objects of one class cross,the velocity keeps the ids apart
+bool test_crossing() {
+    mot_tracker t;
+    object a = {0, 200, 60, 120, 5, 0, 0};
+    object b = {400, 230, 60, 120, -5, 0, 0};
+    uint32_t id_a = 0, id_b = 0;
+    for (int f = 0; f < 80; f++) {
+        const std::vector<track>& out = t.update({a.at(f), b.at(f)});
+        if (f < 5) {
+            continue;
+        }
+        const track* ta = match(out, a.at(f));
+        const track* tb = match(out, b.at(f));
+        TEST_ASSERT(ta && tb && ta != tb, "both objects tracked");
+        if (id_a == 0) {
+            id_a = ta->id;
+            id_b = tb->id;
+        }
+        TEST_ASSERT(ta->id == id_a && tb->id == id_b, "ids survive the crossing");
+    }
+    return true;
+}
+
+// missed and weak detections,the track coasts and is picked up again
+bool test_occlusion() {
+    mot_tracker t;
+    object o = {50, 50, 80, 160, 3, 2, 2};
+    uint32_t id = 0;
+    for (int f = 0; f < 60; f++) {
+        std::vector<detection> dets;
+        if (f >= 20 && f < 24) {
+            //lost for 4 frames
+        } else if (f >= 30 && f < 35) {
+            dets.push_back(o.at(f, 0.3f)); //partly hidden,low score
+        } else {
+            dets.push_back(o.at(f));
+        }
+
+        const std::vector<track>& out = t.update(dets);
+        if (f < 2) {
+            continue;
+        }
+        TEST_ASSERT(out.size() == 1, "track kept while hidden");
+        if (id == 0) {
+            id = out[0].id;
+        }
+        TEST_ASSERT(out[0].id == id, "same id after the occlusion");
+        TEST_ASSERT(center_error(out[0], o.at(f)) < 6, "coasting box extrapolated");
+    }
+
+    //gone for good
+    for (int f = 0; f < 6; f++) {
+        t.update({});
+    }
+    TEST_ASSERT(t.tracks().empty(), "dropped after max_age");
+
+    //low scores do not start tracks,a new object gets a new id
+    for (int f = 0; f < 5; f++) {
+        t.update({o.at(f, 0.3f)});
+    }
+    TEST_ASSERT(t.tracks().empty(), "weak detections start nothing");
+    t.update({o.at(0)});
+    const std::vector<track>& out = t.update({o.at(1)});
+    TEST_ASSERT(out.size() == 1 && out[0].id > id, "new id");
+    return true;
+}
+
+// classes do not mix
+bool test_class_gate() {
+    mot_tracker t;
+    object o = {100, 100, 60, 60, 0, 0, 1};
+    for (int f = 0; f < 3; f++) {
+        t.update({o.at(f)});
+    }
+    uint32_t id = t.tracks()[0].id;
+    object other = o;
+    other.class_id = 7;
+    t.update({other.at(3)});
+    const std::vector<track>& out = t.update({other.at(4)});
+    TEST_ASSERT(out.size() == 2, "other class starts its own track");
+    TEST_ASSERT(find_track(out, id) && find_track(out, id)->misses == 2, "first track unmatched");
+    return true;
+}
+
+// inference skipped on static scenes,boxes extrapolated in between
+bool test_adaptive_interval() {
+    mot_tracker_param param = mot_tracker::default_param();
+    param.max_interval = 8;
+    mot_tracker t(&param);
+
+    object still = {200, 200, 50, 100, 0, 0, 0};
+    int detects = 0;
+    int f = 0;
+    for (; f < 100; f++) {
+        if (t.need_detect()) {
+            t.update({still.at(f)});
+            detects++;
+        } else {
+            t.predict();
+        }
+    }
+    std::cout << "  static: " << detects << " detections in 100 frames,interval=" << t.interval() << std::endl;
+    TEST_ASSERT(t.interval() == 8, "interval grows while nothing moves");
+    TEST_ASSERT(detects < 25, "most frames skipped");
+    TEST_ASSERT(t.tracks().size() == 1, "track reported on skipped frames");
+
+    //something starts moving,every frame again
+    object mover = {0, 400, 60, 120, 6, 0, 3};
+    int start = f;
+    while (!t.need_detect()) {
+        t.predict();
+        f++;
+    }
+    t.update({still.at(f), mover.at(f - start)});
+    TEST_ASSERT(t.interval() == 1, "new object,every frame");
+    for (int i = 0; i < 20; i++) {
+        f++;
+        TEST_ASSERT(t.need_detect(), "moving scene detects every frame");
+        t.update({still.at(f), mover.at(f - start)});
+    }
+
+    //a slow but steady object coasts well through skipped frames
+    mot_tracker t2(&param);
+    object slow = {100, 100, 60, 120, 0.5f, 0.25f, 0};
+    float worst = 0;
+    for (f = 0; f < 200; f++) {
+        const std::vector<track>& out = t2.need_detect() ? t2.update({slow.at(f)}) : t2.predict();
+        if (f > 10 && !out.empty()) {
+            worst = std::max(worst, center_error(out[0], slow.at(f)));
+        }
+    }
+    std::cout << "  slow: interval=" << t2.interval() << ",worst center error=" << worst << "px" << std::endl;
+    TEST_ASSERT(t2.interval() > 1, "slow object counts as static");
+    TEST_ASSERT(worst < 3, "extrapolated boxes stay on the object");
+    return true;
+}
+
+int main() {
+    int passed = 0;
+    int failed = 0;
+
+    std::cout << "=== mot_tracker Unit Tests ===" << std::endl << std::endl;
+
+    RUN_TEST(test_hungarian);
+    RUN_TEST(test_single_object);
+    RUN_TEST(test_crossing);
+    RUN_TEST(test_occlusion);
+    RUN_TEST(test_class_gate);
+    RUN_TEST(test_adaptive_interval);
+
+    std::cout << std::endl << "=== Results ===" << std::endl;
+    std::cout << "Passed: " << passed << std::endl;
+    std::cout << "Failed: " << failed << std::endl;
+
+    return failed > 0 ? 1 : 0;
+}
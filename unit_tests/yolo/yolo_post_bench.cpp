@@ -0,0 +1,168 @@
+// Per frame cost of yolo_post,scalar kernels against neon,on recorded or synthetic tensors.
+// Record tensors on the board with "post":{"dump_file":...} in yolov5.json; without a file
+// the benchmark makes yolov5s(3 heads) and yolov8(84x8400) shaped frames with a dozen objects.
+// Host builds only have the scalar numbers; build on the board(or any arm64) to get both.
+//
+// usage: yolo_post_bench [tensor_file] [iterations]
+#include "../../yolo/yolo_post.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+using namespace ceanic::yolo;
+
+struct frame_t {
+    std::vector<float> storage;
+    std::vector<yolo_tensor> tensors;
+};
+
+static uint32_t g_seed = 1;
+
+static float rnd(float lo, float hi) {
+    g_seed = g_seed * 1103515245 + 12345;
+    return lo + (hi - lo) * ((g_seed >> 8) & 0xffff) / 65535.0f;
+}
+
+static void make_v5(frame_t& f) {
+    const uint32_t sizes[] = {80, 40, 20};
+    const uint32_t c = 3 * 85;
+    size_t total = 0;
+    for (uint32_t w : sizes) {
+        total += (size_t)c * w * w;
+    }
+    f.storage.resize(total);
+    for (size_t i = 0; i < total; i++) {
+        f.storage[i] = rnd(-9, -3);
+    }
+
+    size_t off = 0;
+    for (uint32_t w : sizes) {
+        yolo_tensor t = {f.storage.data() + off, c, w, w, w};
+        f.tensors.push_back(t);
+        // a dozen objects,each seen by two neighbouring cells
+        for (int o = 0; o < 12 && w == 40; o++) {
+            uint32_t x = 2 + o * 3, y = 5 + o * 2;
+            for (uint32_t d = 0; d < 2; d++) {
+                float* cell = f.storage.data() + off + (size_t)y * w + x + d;
+                size_t plane = (size_t)w * w;
+                // both cells put the center on the same spot
+                cell[0] = d == 0 ? 1.1f : -1.1f;
+                for (uint32_t k = 1; k < 4; k++) {
+                    cell[k * plane] = rnd(-0.3f, 0.3f);
+                }
+                cell[4 * plane] = rnd(2, 4);
+                cell[(5 + o) * plane] = rnd(2, 4);
+            }
+        }
+        off += (size_t)c * w * w;
+    }
+}
+
+static void make_v8(frame_t& f) {
+    const uint32_t n = 8400, nc = 80;
+    f.storage.resize((4 + nc) * n);
+    for (uint32_t i = 0; i < n; i++) {
+        f.storage[i] = rnd(0, 640);
+        f.storage[n + i] = rnd(0, 640);
+        f.storage[2 * n + i] = rnd(8, 200);
+        f.storage[3 * n + i] = rnd(8, 200);
+    }
+    for (size_t i = 4 * n; i < f.storage.size(); i++) {
+        f.storage[i] = rnd(0, 0.05f);
+    }
+    for (int o = 0; o < 12; o++) {
+        for (uint32_t d = 0; d < 4; d++) {
+            uint32_t i = 100 + o * 500 + d;
+            f.storage[i] = 50 + o * 40 + d;
+            f.storage[n + i] = 300 + d;
+            f.storage[2 * n + i] = 60;
+            f.storage[3 * n + i] = 120;
+            f.storage[(4 + o) * n + i] = rnd(0.6f, 0.95f);
+        }
+    }
+    yolo_tensor t = {f.storage.data(), 4 + nc, 1, n, n};
+    f.tensors.push_back(t);
+}
+
+static void run(const char* name, const std::vector<frame_t>& frames, bool neon, int count) {
+    const std::vector<yolo_tensor>& first = frames[0].tensors;
+    yolo_post_param param = yolo_post::default_param();
+    if (first.size() == 1) {
+        param.head = YOLO_HEAD_V8;
+        param.num_classes = first[0].c * first[0].h - 4;
+    } else {
+        param.num_classes = first[0].c / YOLO_ANCHOR_NUM - 5;
+    }
+    param.use_neon = neon;
+    yolo_post post(&param);
+
+    std::vector<yolo_box> boxes;
+    uint64_t cands = 0, dets = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < count; i++) {
+        if (!post.process(frames[i % frames.size()].tensors, boxes)) {
+            printf("%s: tensors do not fit the head\n", name);
+            return;
+        }
+        cands += post.candidates();
+        dets += boxes.size();
+    }
+    auto us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+
+    printf("%-10s %-6s %6.3f ms/frame  candidates %.1f  boxes %.1f\n",
+            name, neon ? "neon" : "scalar", (double)us / 1000 / count, (double)cands / count, (double)dets / count);
+}
+
+static void run_both(const char* name, const std::vector<frame_t>& frames, int count) {
+    run(name, frames, false, count);
+    if (yolo_post::has_neon()) {
+        run(name, frames, true, count);
+    }
+}
+
+int main(int argc, char** argv) {
+    int count = argc > 2 ? atoi(argv[2]) : 200;
+    printf("yolo_post %d iterations, neon %s\n", count, yolo_post::has_neon() ? "built" : "not built");
+
+    if (argc > 1) {
+        FILE* f = fopen(argv[1], "rb");
+        if (f == NULL) {
+            printf("can not open %s\n", argv[1]);
+            return 1;
+        }
+
+        std::vector<frame_t> frames;
+        frame_t frame;
+        while (yolo_post::load_tensors(f, frame.storage, frame.tensors)) {
+            frames.push_back(frame);
+            frame = frame_t();
+        }
+        fclose(f);
+
+        // the copies moved the floats,point the tensors at their own storage
+        for (size_t i = 0; i < frames.size(); i++) {
+            size_t off = 0;
+            for (size_t t = 0; t < frames[i].tensors.size(); t++) {
+                yolo_tensor& x = frames[i].tensors[t];
+                x.data = frames[i].storage.data() + off;
+                off += (size_t)x.c * x.h * x.w;
+            }
+        }
+
+        if (frames.empty()) {
+            printf("no frame in %s\n", argv[1]);
+            return 1;
+        }
+        printf("%zu recorded frames\n", frames.size());
+        run_both("recorded", frames, count);
+        return 0;
+    }
+
+    std::vector<frame_t> v5(1), v8(1);
+    make_v5(v5[0]);
+    make_v8(v8[0]);
+    run_both("yolov5s", v5, count);
+    run_both("yolov8", v8, count);
+    return 0;
+}
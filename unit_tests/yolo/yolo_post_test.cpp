@@ -0,0 +1,328 @@
+#include "../../yolo/yolo_post.h"
+#include <iostream>
+#include <vector>
+#include <math.h>
+#include <stdio.h>
+#include <unistd.h>
+
+using namespace ceanic::yolo;
+
+// Test helper
+#define TEST_ASSERT(condition, message) \
+    if (!(condition)) { \
+        std::cerr << "FAILED: " << message << std::endl; \
+        return false; \
+    }
+
+#define RUN_TEST(test_func) \
+    std::cout << "Running " << #test_func << "..." << std::endl; \
+    if (test_func()) { \
+        std::cout << "  PASSED" << std::endl; \
+        passed++; \
+    } else { \
+        std::cout << "  FAILED" << std::endl; \
+        failed++; \
+    }
+
+static bool near(float a, float b, float eps = 0.01f) {
+    return fabsf(a - b) < eps;
+}
+
+#if defined(__ARM_NEON)
+static uint32_t g_seed = 1;
+
+static float rnd(float lo, float hi) {
+    g_seed = g_seed * 1103515245 + 12345;
+    return lo + (hi - lo) * ((g_seed >> 8) & 0xffff) / 65535.0f;
+}
+#endif
+
+// yolov5 heads of a 64x64 input,2 classes,rows padded to stride floats
+struct v5_heads {
+    static const uint32_t nc = 2;
+    static const uint32_t ch = 5 + nc;
+    std::vector<std::vector<float>> data;
+    std::vector<yolo_tensor> tensors;
+
+    v5_heads() {
+        const uint32_t sizes[] = {8, 4, 2};
+        for (uint32_t w : sizes) {
+            yolo_tensor t;
+            t.c = YOLO_ANCHOR_NUM * ch;
+            t.h = w;
+            t.w = w;
+            t.stride = w + 3;
+            data.push_back(std::vector<float>(t.c * t.h * t.stride, -10.0f));
+            tensors.push_back(t);
+        }
+        // coarsest first,the decoder sorts the levels itself
+        std::swap(data[0], data[2]);
+        std::swap(tensors[0], tensors[2]);
+        for (size_t i = 0; i < tensors.size(); i++) {
+            tensors[i].data = data[i].data();
+        }
+    }
+
+    float& at(uint32_t w, uint32_t a, uint32_t k, uint32_t y, uint32_t x) {
+        for (size_t i = 0; i < tensors.size(); i++) {
+            yolo_tensor& t = tensors[i];
+            if (t.w == w) {
+                return data[i][((a * ch + k) * t.h + y) * t.stride + x];
+            }
+        }
+        static float dummy;
+        return dummy;
+    }
+
+    // one object:logits of the offsets,objectness and class
+    void object(uint32_t w, uint32_t a, uint32_t y, uint32_t x, float obj, uint32_t cls, float cls_logit,
+            float tx = 0, float ty = 0, float tw = 0, float th = 0) {
+        at(w, a, 0, y, x) = tx;
+        at(w, a, 1, y, x) = ty;
+        at(w, a, 2, y, x) = tw;
+        at(w, a, 3, y, x) = th;
+        at(w, a, 4, y, x) = obj;
+        at(w, a, 5 + cls, y, x) = cls_logit;
+    }
+};
+
+static yolo_post_param v5_param() {
+    yolo_post_param param = yolo_post::default_param();
+    param.num_classes = v5_heads::nc;
+    param.input_w = 64;
+    param.input_h = 64;
+    return param;
+}
+
+// fixed vectors for the kernels,and neon against scalar where it is built
+bool test_kernels() {
+    const float src[] = {-1, 0.5f, 0.49f, 3, -7, 0.5f, 0, 9, 0.51f};
+    uint32_t idx[9];
+    TEST_ASSERT(yolo_post::scan_scalar(src, 9, 0.5f, idx) == 5, "values at or above the threshold");
+    TEST_ASSERT(idx[0] == 1 && idx[1] == 3 && idx[2] == 5 && idx[3] == 7 && idx[4] == 8, "their indexes");
+
+    // 3 rows of 5,stride 6,ties keep the first row
+    const float cls[] = {
+        1, 5, 0, 2, -1, 99,
+        3, 5, 0, 1, -2, 99,
+        2, 6, 0, 2, -3, 99,
+    };
+    float max[5];
+    uint32_t arg[5];
+    yolo_post::class_max_scalar(cls, 6, 3, 5, max, arg);
+    TEST_ASSERT(max[0] == 3 && max[1] == 6 && max[2] == 0 && max[3] == 2 && max[4] == -1, "column maxima");
+    TEST_ASSERT(arg[0] == 1 && arg[1] == 2 && arg[2] == 0 && arg[3] == 0 && arg[4] == 0, "first row wins a tie");
+
+#if defined(__ARM_NEON)
+    const uint32_t widths[] = {4, 13, 80, 8400};
+    for (uint32_t n : widths) {
+        uint32_t stride = n + 5;
+        std::vector<float> v(stride * 7);
+        for (size_t i = 0; i < v.size(); i++) {
+            v[i] = rnd(-8, 2);
+        }
+
+        std::vector<uint32_t> is(n), in(n);
+        uint32_t cs = yolo_post::scan_scalar(v.data(), n, 0.0f, is.data());
+        uint32_t cn = yolo_post::scan_neon(v.data(), n, 0.0f, in.data());
+        TEST_ASSERT(cs == cn && std::equal(is.begin(), is.begin() + cs, in.begin()), "scan neon matches scalar");
+
+        std::vector<float> ms(n), mn(n);
+        std::vector<uint32_t> as(n), an(n);
+        yolo_post::class_max_scalar(v.data(), stride, 7, n, ms.data(), as.data());
+        yolo_post::class_max_neon(v.data(), stride, 7, n, mn.data(), an.data());
+        TEST_ASSERT(ms == mn && as == an, "class_max neon matches scalar");
+    }
+    std::cout << "  neon kernels checked" << std::endl;
+#endif
+    return true;
+}
+
+// anchor decode of one cell,reference values from the yolov5 formulas
+bool test_v5_decode() {
+    v5_heads heads;
+    yolo_post_param param = v5_param();
+    yolo_post post(&param);
+    std::vector<yolo_box> boxes;
+
+    // stride 8,anchor 16x30,cell (5,3)
+    heads.object(8, 1, 3, 5, 3.0f, 1, 2.0f);
+    TEST_ASSERT(post.process(heads.tensors, boxes), "heads accepted");
+    TEST_ASSERT(boxes.size() == 1 && post.candidates() == 1, "one box");
+    const yolo_box& b = boxes[0];
+    TEST_ASSERT(b.class_id == 1, "class");
+    TEST_ASSERT(near(b.score, 0.9526f * 0.8808f), "score is objectness times class");
+    TEST_ASSERT(near(b.x1, 36) && near(b.x2, 52) && near(b.y1, 13) && near(b.y2, 43), "center and anchor size");
+
+    // offsets and sizes,stride 32,anchor 373x326 clipped to the picture
+    heads.object(2, 2, 1, 0, 4.0f, 0, 4.0f, 1.0f, -1.0f, 0.5f, -0.5f);
+    post.process(heads.tensors, boxes);
+    TEST_ASSERT(boxes.size() == 2, "second level");
+    float sx = 1 / (1 + expf(-1.0f)), sy = 1 / (1 + expf(1.0f));
+    float sw = 2 / (1 + expf(-0.5f)), sh = 2 / (1 + expf(0.5f));
+    float cx = (sx * 2 - 0.5f + 0) * 32, cy = (sy * 2 - 0.5f + 1) * 32;
+    float w = sw * sw * 373, h = sh * sh * 326;
+    const yolo_box& c = boxes[0].class_id == 0 ? boxes[0] : boxes[1];
+    TEST_ASSERT(near(c.x1, std::max(cx - w / 2, 0.0f)) && near(c.x2, std::min(cx + w / 2, 64.0f)), "x decode");
+    TEST_ASSERT(near(c.y1, std::max(cy - h / 2, 0.0f)) && near(c.y2, std::min(cy + h / 2, 64.0f)), "y decode");
+    return true;
+}
+
+// the objectness filters first,the product of both decides
+bool test_v5_threshold() {
+    yolo_post_param param = v5_param();
+    yolo_post post(&param);
+    std::vector<yolo_box> boxes;
+
+    v5_heads weak;
+    weak.object(8, 0, 1, 1, -0.1f, 0, 10.0f);
+    post.process(weak.tensors, boxes);
+    TEST_ASSERT(boxes.empty() && post.candidates() == 0, "objectness below the threshold");
+
+    v5_heads unsure;
+    unsure.object(8, 0, 1, 1, 10.0f, 0, -0.1f);
+    post.process(unsure.tensors, boxes);
+    TEST_ASSERT(boxes.empty(), "class below the threshold");
+
+    v5_heads both;
+    both.object(8, 0, 1, 1, 0.5f, 0, 0.5f);
+    post.process(both.tensors, boxes);
+    TEST_ASSERT(boxes.empty(), "0.62 * 0.62 is below 0.5");
+
+    param.score_threshold = 0.3f;
+    yolo_post low(&param);
+    low.process(both.tensors, boxes);
+    TEST_ASSERT(boxes.size() == 1, "passes a lower threshold");
+    return true;
+}
+
+// yolov8 layout,class aware nms,the box cap
+bool test_v8_nms() {
+    const uint32_t nc = 3, n = 10, stride = 12;
+    std::vector<float> data((4 + nc) * stride, 0.0f);
+    auto set = [&](uint32_t i, float cx, float cy, float w, float h, uint32_t cls, float score) {
+        data[i] = cx;
+        data[stride + i] = cy;
+        data[2 * stride + i] = w;
+        data[3 * stride + i] = h;
+        data[(4 + cls) * stride + i] = score;
+    };
+    set(4, 100, 50, 20, 10, 2, 0.9f);
+    set(7, 102, 51, 20, 10, 2, 0.8f);   // same class,iou 0.7
+    set(8, 101, 50, 20, 10, 1, 0.7f);   // other class
+    set(1, 300, 300, 40, 40, 2, 0.6f);
+    set(2, 500, 500, 40, 40, 0, 0.4f);  // below the threshold
+
+    // a [1][4+nc][n] tensor
+    yolo_tensor t = {data.data(), 4 + nc, 1, n, stride};
+    std::vector<yolo_tensor> tensors = {t};
+
+    yolo_post_param param = yolo_post::default_param();
+    param.head = YOLO_HEAD_V8;
+    param.num_classes = nc;
+    yolo_post post(&param);
+    std::vector<yolo_box> boxes;
+    TEST_ASSERT(post.process(tensors, boxes), "tensor accepted");
+    TEST_ASSERT(post.candidates() == 4 && boxes.size() == 3, "one of the same class suppressed");
+    TEST_ASSERT(boxes[0].score == 0.9f && boxes[1].score == 0.7f && boxes[2].score == 0.6f, "strongest first");
+    TEST_ASSERT(boxes[0].class_id == 2 && boxes[1].class_id == 1, "classes");
+    TEST_ASSERT(boxes[0].x1 == 90 && boxes[0].y1 == 45 && boxes[0].x2 == 110 && boxes[0].y2 == 55, "center to corners");
+
+    param.class_agnostic = true;
+    yolo_post agnostic(&param);
+    agnostic.process(tensors, boxes);
+    TEST_ASSERT(boxes.size() == 2, "agnostic nms across classes");
+
+    param.class_agnostic = false;
+    param.max_det = 1;
+    yolo_post capped(&param);
+    capped.process(tensors, boxes);
+    TEST_ASSERT(boxes.size() == 1 && boxes[0].score == 0.9f, "max_det");
+
+    // logits instead of probabilities
+    for (uint32_t i = 0; i < n; i++) {
+        for (uint32_t c = 0; c < nc; c++) {
+            float& s = data[(4 + c) * stride + i];
+            s = s > 0 ? logf(s / (1 - s)) : -20.0f;
+        }
+    }
+    param.max_det = 64;
+    param.score_logits = true;
+    yolo_post logits(&param);
+    logits.process(tensors, boxes);
+    TEST_ASSERT(boxes.size() == 3 && near(boxes[0].score, 0.9f, 1e-4f), "sigmoid of the logits");
+    return true;
+}
+
+// shapes of another model are refused
+bool test_shape_mismatch() {
+    v5_heads heads;
+    yolo_post_param param = v5_param();
+    param.num_classes = 80;
+    yolo_post post(&param);
+    std::vector<yolo_box> boxes;
+    TEST_ASSERT(!post.process(heads.tensors, boxes), "v5 class count");
+    TEST_ASSERT(!post.process({}, boxes), "no tensor");
+
+    param = v5_param();
+    param.head = YOLO_HEAD_V8;
+    yolo_post v8(&param);
+    TEST_ASSERT(!v8.process(heads.tensors, boxes), "v5 heads are no v8 tensor");
+    return true;
+}
+
+// recorded tensors come back identical,padding dropped
+bool test_record() {
+    char path[] = "/tmp/yolo_post_testXXXXXX";
+    int fd = mkstemp(path);
+    TEST_ASSERT(fd >= 0, "temp file");
+    close(fd);
+    unlink(path);
+
+    v5_heads heads;
+    heads.object(8, 1, 3, 5, 3.0f, 1, 2.0f);
+    TEST_ASSERT(yolo_post::save_tensors(path, heads.tensors), "first frame saved");
+    heads.object(4, 0, 2, 2, 3.0f, 0, 2.0f);
+    TEST_ASSERT(yolo_post::save_tensors(path, heads.tensors), "second frame appended");
+
+    FILE* f = fopen(path, "rb");
+    TEST_ASSERT(f != NULL, "open");
+    yolo_post_param param = v5_param();
+    yolo_post post(&param);
+    std::vector<float> storage;
+    std::vector<yolo_tensor> tensors;
+    std::vector<yolo_box> boxes;
+    size_t counts[2];
+    for (int i = 0; i < 2; i++) {
+        TEST_ASSERT(yolo_post::load_tensors(f, storage, tensors), "frame loaded");
+        TEST_ASSERT(tensors.size() == 3 && tensors[0].w == 2 && tensors[0].stride == 2, "dims,no padding");
+        TEST_ASSERT(post.process(tensors, boxes), "decodes");
+        counts[i] = boxes.size();
+    }
+    TEST_ASSERT(!yolo_post::load_tensors(f, storage, tensors), "end of file");
+    fclose(f);
+    unlink(path);
+
+    TEST_ASSERT(counts[0] == 1 && counts[1] == 2, "same detections as the live tensors");
+    return true;
+}
+
+int main() {
+    int passed = 0;
+    int failed = 0;
+
+    std::cout << "=== yolo_post Unit Tests ===" << std::endl << std::endl;
+
+    RUN_TEST(test_kernels);
+    RUN_TEST(test_v5_decode);
+    RUN_TEST(test_v5_threshold);
+    RUN_TEST(test_v8_nms);
+    RUN_TEST(test_shape_mismatch);
+    RUN_TEST(test_record);
+
+    std::cout << std::endl << "=== Results ===" << std::endl;
+    std::cout << "Passed: " << passed << std::endl;
+    std::cout << "Failed: " << failed << std::endl;
+
+    return failed > 0 ? 1 : 0;
+}
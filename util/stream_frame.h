@@ -0,0 +1,46 @@
+#ifndef stream_frame_include_h
+#define stream_frame_include_h
+
+#include <memory>
+#include <util/stream_type.h>
+
+namespace ceanic{namespace util{
+
+    //one encoded video frame shared by reference between the producer and its consumers.
+    //the nalus in head() stay valid until the last reference is dropped,so a consumer may
+    //queue the frame instead of copying the payload
+    class stream_frame
+    {
+        public:
+            stream_frame()
+            {
+            }
+
+            virtual ~stream_frame()
+            {
+            }
+
+            stream_frame(const stream_frame&) = delete;
+            stream_frame& operator=(const stream_frame&) = delete;
+
+            stream_head* head()
+            {
+                return &m_head;
+            }
+
+            //true when the nalus point into encoder memory held by this frame,
+            //such a frame should not be kept longer than a few frame intervals
+            virtual bool is_ref()
+            {
+                return false;
+            }
+
+        protected:
+            stream_head m_head;
+    };
+
+    typedef std::shared_ptr<stream_frame> stream_frame_ptr;
+
+}}//namespace
+
+#endif
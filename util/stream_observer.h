@@ -2,8 +2,10 @@
 #define stream_observer_include_h
 
 #include <list>
+#include <memory>
 #include <vector>
 #include <util/stream_type.h>
+#include <util/stream_frame.h>
 #include <mutex>
 #include <thread>
 
@@ -48,6 +50,18 @@ namespace ceanic{namespace util{
         public:
             virtual void on_stream_come(stream_obj_ptr sob,util::stream_head* head, const char* buf, int32_t len) = 0;
             virtual void on_stream_error(stream_obj_ptr sob,int32_t error) = 0;
+
+            //video frames posted by reference,observers that do not keep frames use the head only
+            virtual void on_frame_come(stream_obj_ptr sob,stream_frame_ptr frame)
+            {
+                on_stream_come(sob,frame->head(),NULL,0);
+            }
+
+            //low latency mode,slices posted as the encoder emits them ahead of the whole frame.
+            //STREAM_FLAG_MORE_SLICES is cleared on the last slice of a frame
+            virtual void on_slice_come(stream_obj_ptr /*sob*/,stream_head* /*head*/)
+            {
+            }
     };
 
     typedef std::shared_ptr<stream_observer> stream_observer_ptr;
@@ -122,6 +136,26 @@ namespace ceanic{namespace util{
                 }
             }
 
+            void post_frame_to_observer(stream_obj_ptr sobj,stream_frame_ptr frame)
+            {
+                std::unique_lock<std::mutex> lock(m_stream_observers_mu);
+                std::list<stream_observer_ptr>::iterator it;
+                for (it = m_stream_observers.begin(); it != m_stream_observers.end(); it++)
+                {
+                    (*it)->on_frame_come(sobj,frame);
+                }
+            }
+
+            void post_slice_to_observer(stream_obj_ptr sobj,stream_head* head)
+            {
+                std::unique_lock<std::mutex> lock(m_stream_observers_mu);
+                std::list<stream_observer_ptr>::iterator it;
+                for (it = m_stream_observers.begin(); it != m_stream_observers.end(); it++)
+                {
+                    (*it)->on_slice_come(sobj,head);
+                }
+            }
+
         protected:
             std::list<stream_observer_ptr> m_stream_observers;
             std::mutex  m_stream_observers_mu;
@@ -0,0 +1,179 @@
+#ifndef stream_registry_include_h
+#define stream_registry_include_h
+
+#include <stdint.h>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <thread>
+#include <chrono>
+
+namespace ceanic{namespace util{
+
+    //camera ids come from camera_manager(at most 4 cameras,ids below 40),
+    //stream ids are MAIN/SUB/AI/MJPEG_STREAM_ID
+#define STREAM_REGISTRY_MAX_CHN 40
+#define STREAM_REGISTRY_MAX_STREAM 8
+
+    //what the frame path sends to,indexed by (chn,stream_id).
+    //a slot holds an immutable list,readers take it with one atomic load and walk it
+    //without a lock.writers copy the list under the writer mutex and publish the new one,
+    //a reader still walking the old list keeps it(and its items) alive.
+    //an item taken out may still be in use by such a reader,wait_unused() before tearing it down.
+    //a lookup and the add depending on it need a lock of the caller around both
+    template<typename T>
+    class stream_registry
+    {
+        public:
+            typedef std::shared_ptr<T> item_ptr;
+            typedef std::vector<item_ptr> item_list;
+            typedef std::shared_ptr<const item_list> snapshot;
+
+        public:
+            stream_registry()
+            {
+            }
+
+            stream_registry(const stream_registry&) = delete;
+            stream_registry& operator=(const stream_registry&) = delete;
+
+            static bool valid(int32_t chn,int32_t stream_id)
+            {
+                return chn >= 0 && chn < STREAM_REGISTRY_MAX_CHN
+                    && stream_id >= 0 && stream_id < STREAM_REGISTRY_MAX_STREAM;
+            }
+
+            //the frame path,no mutex.null when nothing was ever added to the slot
+            snapshot get(int32_t chn,int32_t stream_id) const
+            {
+                if(!valid(chn,stream_id))
+                {
+                    return snapshot();
+                }
+
+                return std::atomic_load(&m_slots[chn][stream_id]);
+            }
+
+            bool add(int32_t chn,int32_t stream_id,item_ptr item)
+            {
+                if(!valid(chn,stream_id) || !item)
+                {
+                    return false;
+                }
+
+                std::unique_lock<std::mutex> lock(m_writer_mu);
+                snapshot old = m_slots[chn][stream_id];
+                std::shared_ptr<item_list> items = old ? std::make_shared<item_list>(*old) : std::make_shared<item_list>();
+                items->push_back(item);
+                std::atomic_store(&m_slots[chn][stream_id],snapshot(items));
+                return true;
+            }
+
+            //false when the item is not in the slot(taken out by someone else)
+            bool remove(int32_t chn,int32_t stream_id,const item_ptr& item)
+            {
+                return remove_if(chn,stream_id,[&item](const item_ptr& it){return it == item;}) > 0;
+            }
+
+            //the removed items are appended to removed when it is not null
+            template<typename Pred>
+            uint32_t remove_if(int32_t chn,int32_t stream_id,Pred pred,item_list* removed = NULL)
+            {
+                if(!valid(chn,stream_id))
+                {
+                    return 0;
+                }
+
+                std::unique_lock<std::mutex> lock(m_writer_mu);
+                snapshot old = m_slots[chn][stream_id];
+                if(!old)
+                {
+                    return 0;
+                }
+
+                std::shared_ptr<item_list> items = std::make_shared<item_list>();
+                items->reserve(old->size());
+                uint32_t cnt = 0;
+                for(size_t i = 0; i < old->size(); i++)
+                {
+                    if(pred((*old)[i]))
+                    {
+                        cnt++;
+                        if(removed)
+                        {
+                            removed->push_back((*old)[i]);
+                        }
+                    }
+                    else
+                    {
+                        items->push_back((*old)[i]);
+                    }
+                }
+
+                if(cnt > 0)
+                {
+                    std::atomic_store(&m_slots[chn][stream_id],snapshot(items));
+                }
+                return cnt;
+            }
+
+            //first item of the slot matching pred,for the writers' lookups
+            template<typename Pred>
+            item_ptr find_if(int32_t chn,int32_t stream_id,Pred pred) const
+            {
+                snapshot items = get(chn,stream_id);
+                if(items)
+                {
+                    for(size_t i = 0; i < items->size(); i++)
+                    {
+                        if(pred((*items)[i]))
+                        {
+                            return (*items)[i];
+                        }
+                    }
+                }
+                return item_ptr();
+            }
+
+            //every item of every slot,a copy for the slow paths(checks,teardown)
+            item_list all() const
+            {
+                item_list items;
+                for(int32_t c = 0; c < STREAM_REGISTRY_MAX_CHN; c++)
+                {
+                    for(int32_t s = 0; s < STREAM_REGISTRY_MAX_STREAM; s++)
+                    {
+                        snapshot slot = get(c,s);
+                        if(slot)
+                        {
+                            items.insert(items.end(),slot->begin(),slot->end());
+                        }
+                    }
+                }
+                return items;
+            }
+
+            //after remove:returns once no snapshot and no reader holds item anymore,
+            //item is the caller's last reference then.false on timeout
+            static bool wait_unused(const item_ptr& item,uint32_t timeout_ms = 1000)
+            {
+                std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+                while(item.use_count() > 1)
+                {
+                    if(std::chrono::steady_clock::now() >= end)
+                    {
+                        return false;
+                    }
+                    std::this_thread::sleep_for(std::chrono::microseconds(200));
+                }
+                return true;
+            }
+
+        private:
+            snapshot m_slots[STREAM_REGISTRY_MAX_CHN][STREAM_REGISTRY_MAX_STREAM];
+            std::mutex m_writer_mu;
+    };
+
+}}//namespace
+
+#endif
@@ -2,6 +2,7 @@
 #define stream_type_include_h
 
 #include <stdint.h>
+#include <vector>
 
 namespace ceanic{namespace util{
 
@@ -11,6 +12,7 @@ namespace ceanic{namespace util{
 #define STREAM_B_FRAME 3
 #define STREAM_NALU_SLICE 4 
 #define STREAM_MJPEG_FRAME 6
+#define STREAM_META_FRAME 7 //analytics metadata document of one analysed frame
 
 #define IS_VIDEO_FRAME(n) ((n) == STREAM_I_FRAME  \
 || (n)== STREAM_P_FRAME  \
@@ -23,7 +25,15 @@ namespace ceanic{namespace util{
 
 #define IS_AUDIO_FRAME(n)((n) == STREAM_AUDIO_FRAME)
 
-#define MAX_STREAM_NALU_COUNT (8)
+#define IS_META_FRAME(n)((n) == STREAM_META_FRAME)
+
+//nalus kept inline in a stream_head,multi-slice frames spill the rest to the heap
+#define STREAM_NALU_INLINE_COUNT (8)
+
+//stream_head flags
+#define STREAM_FLAG_MORE_SLICES 0x1 //slice head passed to on_slice_come,more slices of the frame follow
+#define STREAM_FLAG_SLICE_SENT 0x2 //whole frame whose slices were already posted by on_slice_come
+
     typedef struct
     {
         uint8_t* data;
@@ -31,14 +41,93 @@ namespace ceanic{namespace util{
         uint32_t time_stamp;
     }nalu_t;
 
-    typedef struct {
+    class nalu_list
+    {
+        public:
+            nalu_list()
+                :m_count(0)
+            {
+            }
+
+            uint32_t size() const
+            {
+                return m_count;
+            }
+
+            bool empty() const
+            {
+                return m_count == 0;
+            }
+
+            nalu_t& operator[](uint32_t i)
+            {
+                return i < STREAM_NALU_INLINE_COUNT ? m_inline[i] : m_more[i - STREAM_NALU_INLINE_COUNT];
+            }
+
+            const nalu_t& operator[](uint32_t i) const
+            {
+                return i < STREAM_NALU_INLINE_COUNT ? m_inline[i] : m_more[i - STREAM_NALU_INLINE_COUNT];
+            }
+
+            nalu_t& back()
+            {
+                return (*this)[m_count - 1];
+            }
+
+            void push_back(const nalu_t& nalu)
+            {
+                if(m_count < STREAM_NALU_INLINE_COUNT)
+                {
+                    m_inline[m_count] = nalu;
+                }
+                else
+                {
+                    m_more.push_back(nalu);
+                }
+                m_count++;
+            }
+
+            void push_back(uint8_t* data,uint32_t size,uint32_t time_stamp)
+            {
+                nalu_t nalu = {data,size,time_stamp};
+                push_back(nalu);
+            }
+
+            void clear()
+            {
+                m_count = 0;
+                m_more.clear();
+            }
+
+        private:
+            uint32_t m_count;
+            nalu_t m_inline[STREAM_NALU_INLINE_COUNT];
+            std::vector<nalu_t> m_more;
+    };
+
+    struct stream_head
+    {
         uint32_t len;
         uint32_t type; //0:p,1:i 2:audio 3:nalu
         uint32_t time_stamp;
+        uint32_t flags; //STREAM_FLAG_*
 
-        uint32_t nalu_count;
-        nalu_t nalu[MAX_STREAM_NALU_COUNT];
-    }stream_head;
+        nalu_list nalu;
+
+        stream_head()
+            :len(0),type(0),time_stamp(0),flags(0)
+        {
+        }
+
+        void reset()
+        {
+            len = 0;
+            type = 0;
+            time_stamp = 0;
+            flags = 0;
+            nalu.clear();
+        }
+    };
 
     enum
     {
@@ -54,6 +143,12 @@ namespace ceanic{namespace util{
         STREAM_AUDIO_ENCODE_AAC = 0x2,
     };
 
+    enum
+    {
+        STREAM_META_ENCODE_NONE = 0x0,
+        STREAM_META_ENCODE_ONVIF = 0x1, //onvif MetadataStream xml
+    };
+
 #define CEANIC_TAG 0x5550564e
     typedef struct
     {
@@ -75,6 +170,11 @@ namespace ceanic{namespace util{
             uint8_t chn;
         }audio_info;
 
+        struct
+        {
+            uint8_t mcode;
+        }meta_info;
+
     }media_head;
 
 }}//namespace
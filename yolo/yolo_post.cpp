@@ -0,0 +1,481 @@
+#include "yolo_post.h"
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace ceanic{namespace yolo{
+
+#define YOLO_TENSOR_MAGIC 0x544c4f59 //"YOLT"
+#define YOLO_TENSOR_MAX 16
+
+    static inline float sigmoid(float x)
+    {
+        return 1.0f / (1.0f + expf(-x));
+    }
+
+    yolo_post_param yolo_post::default_param()
+    {
+        //coco anchors of yolov5s,p3/8,p4/16,p5/32
+        static const float anchors[3][YOLO_ANCHOR_NUM * 2] =
+        {
+            {10,13,16,30,33,23},
+            {30,61,62,45,59,119},
+            {116,90,156,198,373,326},
+        };
+
+        yolo_post_param param;
+        memset(&param,0,sizeof(param));
+        param.head = YOLO_HEAD_V5;
+        param.num_classes = 80;
+        param.input_w = 640;
+        param.input_h = 640;
+        memcpy(param.anchors,anchors,sizeof(anchors));
+        param.score_logits = false;
+        param.score_threshold = 0.5f;
+        param.nms_threshold = 0.45f;
+        param.max_candidates = 1024;
+        param.max_det = 64;
+        param.class_agnostic = false;
+        param.use_neon = true;
+        return param;
+    }
+
+    bool yolo_post::has_neon()
+    {
+#if defined(__ARM_NEON)
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    yolo_post::yolo_post(const yolo_post_param* param)
+        :m_param(param ? *param : default_param())
+    {
+        m_neon = m_param.use_neon && has_neon();
+
+        float t = std::min(std::max(m_param.score_threshold,1e-6f),1.0f - 1e-6f);
+        m_logit_threshold = logf(t / (1.0f - t));
+    }
+
+    yolo_post::~yolo_post()
+    {
+    }
+
+    uint32_t yolo_post::candidates()
+    {
+        return m_cand.size();
+    }
+
+    uint32_t yolo_post::scan_scalar(const float* src,uint32_t n,float thr,uint32_t* idx)
+    {
+        uint32_t cnt = 0;
+        for(uint32_t i = 0; i < n; i++)
+        {
+            if(src[i] >= thr)
+            {
+                idx[cnt++] = i;
+            }
+        }
+        return cnt;
+    }
+
+    void yolo_post::class_max_scalar(const float* src,uint32_t stride,uint32_t nc,uint32_t n,float* max,uint32_t* arg)
+    {
+        //row by row,so every class row streams through once
+        memcpy(max,src,n * sizeof(float));
+        memset(arg,0,n * sizeof(uint32_t));
+        for(uint32_t c = 1; c < nc; c++)
+        {
+            const float* row = src + (size_t)c * stride;
+            for(uint32_t i = 0; i < n; i++)
+            {
+                if(row[i] > max[i])
+                {
+                    max[i] = row[i];
+                    arg[i] = c;
+                }
+            }
+        }
+    }
+
+#if defined(__ARM_NEON)
+    uint32_t yolo_post::scan_neon(const float* src,uint32_t n,float thr,uint32_t* idx)
+    {
+        float32x4_t vthr = vdupq_n_f32(thr);
+        uint32_t cnt = 0;
+        uint32_t i = 0;
+        for(; i + 4 <= n; i += 4)
+        {
+            //nearly every cell is background,four of them are skipped with one test
+            uint32x4_t ge = vcgeq_f32(vld1q_f32(src + i),vthr);
+            uint32x2_t any = vorr_u32(vget_low_u32(ge),vget_high_u32(ge));
+            if((vget_lane_u32(any,0) | vget_lane_u32(any,1)) == 0)
+            {
+                continue;
+            }
+
+            for(uint32_t k = i; k < i + 4; k++)
+            {
+                if(src[k] >= thr)
+                {
+                    idx[cnt++] = k;
+                }
+            }
+        }
+
+        uint32_t tail = scan_scalar(src + i,n - i,thr,idx + cnt);
+        for(uint32_t k = cnt; k < cnt + tail; k++)
+        {
+            idx[k] += i;
+        }
+        return cnt + tail;
+    }
+
+    void yolo_post::class_max_neon(const float* src,uint32_t stride,uint32_t nc,uint32_t n,float* max,uint32_t* arg)
+    {
+        memcpy(max,src,n * sizeof(float));
+        memset(arg,0,n * sizeof(uint32_t));
+        for(uint32_t c = 1; c < nc; c++)
+        {
+            const float* row = src + (size_t)c * stride;
+            uint32x4_t vc = vdupq_n_u32(c);
+            uint32_t i = 0;
+            for(; i + 4 <= n; i += 4)
+            {
+                float32x4_t v = vld1q_f32(row + i);
+                float32x4_t m = vld1q_f32(max + i);
+                uint32x4_t gt = vcgtq_f32(v,m);
+                vst1q_f32(max + i,vbslq_f32(gt,v,m));
+                vst1q_u32(arg + i,vbslq_u32(gt,vc,vld1q_u32(arg + i)));
+            }
+
+            for(; i < n; i++)
+            {
+                if(row[i] > max[i])
+                {
+                    max[i] = row[i];
+                    arg[i] = c;
+                }
+            }
+        }
+    }
+#endif
+
+    uint32_t yolo_post::scan(const float* src,uint32_t n,float thr,uint32_t* idx)
+    {
+#if defined(__ARM_NEON)
+        if(m_neon)
+        {
+            return scan_neon(src,n,thr,idx);
+        }
+#endif
+        return scan_scalar(src,n,thr,idx);
+    }
+
+    void yolo_post::class_max(const float* src,uint32_t stride,uint32_t nc,uint32_t n,float* max,uint32_t* arg)
+    {
+#if defined(__ARM_NEON)
+        if(m_neon)
+        {
+            class_max_neon(src,stride,nc,n,max,arg);
+            return;
+        }
+#endif
+        class_max_scalar(src,stride,nc,n,max,arg);
+    }
+
+    bool yolo_post::decode_v5(const std::vector<yolo_tensor>& tensors)
+    {
+        uint32_t nc = m_param.num_classes;
+        uint32_t ch = 5 + nc;
+        if(tensors.empty() || tensors.size() > YOLO_MAX_LEVEL)
+        {
+            return false;
+        }
+
+        //the finest grid is the first level of anchors
+        std::vector<const yolo_tensor*> levels;
+        for(size_t i = 0; i < tensors.size(); i++)
+        {
+            const yolo_tensor& t = tensors[i];
+            if(t.c != YOLO_ANCHOR_NUM * ch || t.h == 0 || t.w == 0 || t.stride < t.w || t.data == NULL)
+            {
+                return false;
+            }
+            levels.push_back(&t);
+        }
+        std::stable_sort(levels.begin(),levels.end(),[](const yolo_tensor* a,const yolo_tensor* b)
+                {
+                    return a->w > b->w;
+                });
+
+        for(size_t l = 0; l < levels.size(); l++)
+        {
+            const yolo_tensor& t = *levels[l];
+            float step_x = (float)m_param.input_w / t.w;
+            float step_y = (float)m_param.input_h / t.h;
+            m_idx.resize(std::max((size_t)t.w,m_idx.size()));
+
+            for(uint32_t a = 0; a < YOLO_ANCHOR_NUM; a++)
+            {
+                //channel k,row y:data + (k * h + y) * stride
+                const float* base = t.data + (size_t)a * ch * t.h * t.stride;
+                size_t plane = (size_t)t.h * t.stride;
+                float anchor_w = m_param.anchors[l][a * 2];
+                float anchor_h = m_param.anchors[l][a * 2 + 1];
+
+                for(uint32_t y = 0; y < t.h; y++)
+                {
+                    const float* obj = base + 4 * plane + (size_t)y * t.stride;
+                    //score = sigmoid(obj) * sigmoid(cls) can not pass without sigmoid(obj) passing
+                    uint32_t cnt = scan(obj,t.w,m_logit_threshold,m_idx.data());
+                    for(uint32_t k = 0; k < cnt; k++)
+                    {
+                        uint32_t x = m_idx[k];
+                        const float* cell = base + (size_t)y * t.stride + x;
+
+                        float best = cell[5 * plane];
+                        uint32_t best_c = 0;
+                        for(uint32_t c = 1; c < nc; c++)
+                        {
+                            float v = cell[(5 + c) * plane];
+                            if(v > best)
+                            {
+                                best = v;
+                                best_c = c;
+                            }
+                        }
+
+                        float score = sigmoid(obj[x]) * sigmoid(best);
+                        if(score < m_param.score_threshold)
+                        {
+                            continue;
+                        }
+
+                        float cx = (sigmoid(cell[0]) * 2.0f - 0.5f + x) * step_x;
+                        float cy = (sigmoid(cell[plane]) * 2.0f - 0.5f + y) * step_y;
+                        float bw = sigmoid(cell[2 * plane]) * 2.0f;
+                        float bh = sigmoid(cell[3 * plane]) * 2.0f;
+                        bw = bw * bw * anchor_w;
+                        bh = bh * bh * anchor_h;
+
+                        yolo_box b;
+                        b.x1 = cx - bw / 2;
+                        b.y1 = cy - bh / 2;
+                        b.x2 = cx + bw / 2;
+                        b.y2 = cy + bh / 2;
+                        b.score = score;
+                        b.class_id = best_c;
+                        m_cand.push_back(b);
+                    }
+                }
+            }
+        }
+        return true;
+    }
+
+    bool yolo_post::decode_v8(const std::vector<yolo_tensor>& tensors)
+    {
+        uint32_t nc = m_param.num_classes;
+        if(tensors.size() != 1)
+        {
+            return false;
+        }
+
+        //[4+nc][n],a [1][4+nc][n] tensor comes as h = 1
+        const yolo_tensor& t = tensors[0];
+        uint32_t rows = t.c * t.h;
+        uint32_t n = t.w;
+        if(rows != 4 + nc || nc == 0 || n == 0 || t.stride < t.w || t.data == NULL)
+        {
+            return false;
+        }
+
+        m_max.resize(n);
+        m_arg.resize(n);
+        m_idx.resize(std::max((size_t)n,m_idx.size()));
+        class_max(t.data + 4 * (size_t)t.stride,t.stride,nc,n,m_max.data(),m_arg.data());
+
+        float thr = m_param.score_logits ? m_logit_threshold : m_param.score_threshold;
+        uint32_t cnt = scan(m_max.data(),n,thr,m_idx.data());
+        for(uint32_t k = 0; k < cnt; k++)
+        {
+            uint32_t i = m_idx[k];
+            float cx = t.data[i];
+            float cy = t.data[t.stride + i];
+            float bw = t.data[2 * (size_t)t.stride + i];
+            float bh = t.data[3 * (size_t)t.stride + i];
+
+            yolo_box b;
+            b.x1 = cx - bw / 2;
+            b.y1 = cy - bh / 2;
+            b.x2 = cx + bw / 2;
+            b.y2 = cy + bh / 2;
+            b.score = m_param.score_logits ? sigmoid(m_max[i]) : m_max[i];
+            b.class_id = m_arg[i];
+            m_cand.push_back(b);
+        }
+        return true;
+    }
+
+    void yolo_post::nms(std::vector<yolo_box>& boxes)
+    {
+        auto stronger = [](const yolo_box& a,const yolo_box& b)
+        {
+            return a.score > b.score;
+        };
+
+        //a crowded or broken frame does not turn the nms quadratic on thousands of boxes
+        if(m_cand.size() > m_param.max_candidates)
+        {
+            std::nth_element(m_cand.begin(),m_cand.begin() + m_param.max_candidates,m_cand.end(),stronger);
+            m_cand.resize(m_param.max_candidates);
+        }
+        std::stable_sort(m_cand.begin(),m_cand.end(),stronger);
+
+        size_t num = m_cand.size();
+        m_area.resize(num);
+        m_drop.assign(num,false);
+        for(size_t i = 0; i < num; i++)
+        {
+            const yolo_box& b = m_cand[i];
+            m_area[i] = (b.x2 - b.x1) * (b.y2 - b.y1);
+        }
+
+        for(size_t i = 0; i < num && boxes.size() < m_param.max_det; i++)
+        {
+            if(m_drop[i])
+            {
+                continue;
+            }
+
+            const yolo_box& a = m_cand[i];
+            boxes.push_back(a);
+            for(size_t j = i + 1; j < num; j++)
+            {
+                const yolo_box& b = m_cand[j];
+                if(m_drop[j] || (!m_param.class_agnostic && a.class_id != b.class_id))
+                {
+                    continue;
+                }
+
+                float iw = std::min(a.x2,b.x2) - std::max(a.x1,b.x1);
+                float ih = std::min(a.y2,b.y2) - std::max(a.y1,b.y1);
+                if(iw <= 0 || ih <= 0)
+                {
+                    continue;
+                }
+
+                float inter = iw * ih;
+                if(inter > m_param.nms_threshold * (m_area[i] + m_area[j] - inter))
+                {
+                    m_drop[j] = true;
+                }
+            }
+        }
+    }
+
+    bool yolo_post::process(const std::vector<yolo_tensor>& tensors,std::vector<yolo_box>& boxes)
+    {
+        boxes.clear();
+        m_cand.clear();
+
+        bool ok = m_param.head == YOLO_HEAD_V8 ? decode_v8(tensors) : decode_v5(tensors);
+        if(!ok)
+        {
+            return false;
+        }
+
+        nms(boxes);
+
+        float max_x = m_param.input_w;
+        float max_y = m_param.input_h;
+        for(size_t i = 0; i < boxes.size(); i++)
+        {
+            yolo_box& b = boxes[i];
+            b.x1 = std::min(std::max(b.x1,0.0f),max_x);
+            b.y1 = std::min(std::max(b.y1,0.0f),max_y);
+            b.x2 = std::min(std::max(b.x2,0.0f),max_x);
+            b.y2 = std::min(std::max(b.y2,0.0f),max_y);
+        }
+        return true;
+    }
+
+    bool yolo_post::save_tensors(const char* path,const std::vector<yolo_tensor>& tensors)
+    {
+        FILE* f = fopen(path,"ab");
+        if(f == NULL)
+        {
+            return false;
+        }
+
+        //magic,count,then per tensor c,h,w and the rows without padding
+        bool ok = true;
+        uint32_t head[2] = {YOLO_TENSOR_MAGIC,(uint32_t)tensors.size()};
+        ok = ok && fwrite(head,sizeof(head),1,f) == 1;
+        for(size_t i = 0; i < tensors.size() && ok; i++)
+        {
+            const yolo_tensor& t = tensors[i];
+            uint32_t dims[3] = {t.c,t.h,t.w};
+            ok = fwrite(dims,sizeof(dims),1,f) == 1;
+            for(size_t r = 0; r < (size_t)t.c * t.h && ok; r++)
+            {
+                ok = fwrite(t.data + r * t.stride,sizeof(float),t.w,f) == t.w;
+            }
+        }
+
+        fclose(f);
+        return ok;
+    }
+
+    bool yolo_post::load_tensors(FILE* f,std::vector<float>& storage,std::vector<yolo_tensor>& tensors)
+    {
+        uint32_t head[2];
+        if(fread(head,sizeof(head),1,f) != 1 || head[0] != YOLO_TENSOR_MAGIC || head[1] > YOLO_TENSOR_MAX)
+        {
+            return false;
+        }
+
+        tensors.clear();
+        std::vector<size_t> offsets;
+        size_t total = 0;
+        storage.clear();
+        for(uint32_t i = 0; i < head[1]; i++)
+        {
+            uint32_t dims[3];
+            if(fread(dims,sizeof(dims),1,f) != 1)
+            {
+                return false;
+            }
+
+            size_t count = (size_t)dims[0] * dims[1] * dims[2];
+            storage.resize(total + count);
+            if(fread(storage.data() + total,sizeof(float),count,f) != count)
+            {
+                return false;
+            }
+
+            yolo_tensor t;
+            t.data = NULL;
+            t.c = dims[0];
+            t.h = dims[1];
+            t.w = dims[2];
+            t.stride = dims[2];
+            tensors.push_back(t);
+            offsets.push_back(total);
+            total += count;
+        }
+
+        //storage is complete,it does not move anymore
+        for(size_t i = 0; i < tensors.size(); i++)
+        {
+            tensors[i].data = storage.data() + offsets[i];
+        }
+        return true;
+    }
+
+}}//namespace
@@ -0,0 +1,116 @@
+#ifndef yolo_post_include_h
+#define yolo_post_include_h
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <vector>
+
+namespace ceanic{namespace yolo{
+
+    enum
+    {
+        //yolov5 style anchor heads,one [anchors*(5+classes)][h][w] tensor per stride,raw logits
+        YOLO_HEAD_V5 = 0,
+        //yolov8 style one [4+classes][n] tensor,cx,cy,w,h in input pixels then the class scores
+        YOLO_HEAD_V8,
+    };
+
+#define YOLO_MAX_LEVEL 4
+#define YOLO_ANCHOR_NUM 3
+
+    //one output tensor,c x h rows of w floats,rows are stride floats apart
+    typedef struct
+    {
+        const float* data;
+        uint32_t c;
+        uint32_t h;
+        uint32_t w;
+        uint32_t stride;
+    }yolo_tensor;
+
+    //a detection in input pixels
+    typedef struct
+    {
+        float x1;
+        float y1;
+        float x2;
+        float y2;
+        float score;
+        uint32_t class_id;
+    }yolo_box;
+
+    typedef struct
+    {
+        uint32_t head;                  //YOLO_HEAD_V5/V8
+        uint32_t num_classes;
+        uint32_t input_w;               //model input,the boxes come out in these pixels
+        uint32_t input_h;
+        //YOLO_HEAD_V5:w,h pairs per level,the finest level(stride 8) first
+        float anchors[YOLO_MAX_LEVEL][YOLO_ANCHOR_NUM * 2];
+        bool score_logits;              //YOLO_HEAD_V8:the class scores are logits,not probabilities
+        float score_threshold;
+        float nms_threshold;            //iou above which the weaker box of a class is dropped
+        uint32_t max_candidates;        //strongest candidates kept for the nms
+        uint32_t max_det;
+        bool class_agnostic;            //nms across classes
+        bool use_neon;                  //false forces the scalar kernels,ignored without neon
+    }yolo_post_param;
+
+    //cpu post processing of raw yolo heads:decode,score filter and nms.
+    //the objectness(v5) or best class score(v8) is compared in the logit domain
+    //first,so the exp of the decode only runs for the few cells that pass.not thread safe
+    class yolo_post
+    {
+        public:
+            yolo_post(const yolo_post_param* param = NULL);
+            virtual ~yolo_post();
+
+        public:
+            //false when the tensors do not fit the head type
+            bool process(const std::vector<yolo_tensor>& tensors,std::vector<yolo_box>& boxes);
+
+            //candidates above the score threshold in the last process()
+            uint32_t candidates();
+
+            static yolo_post_param default_param();
+            static bool has_neon();
+
+            //raw tensors of a frame,appended to path,for the benchmark and the tests
+            static bool save_tensors(const char* path,const std::vector<yolo_tensor>& tensors);
+            //the next frame of a file,storage holds the floats the tensors point to
+            static bool load_tensors(FILE* f,std::vector<float>& storage,std::vector<yolo_tensor>& tensors);
+
+        public:
+            //kernels,public for the bit exactness tests and the benchmark.
+            //scan:indexes of src[i] >= thr,returns their count
+            static uint32_t scan_scalar(const float* src,uint32_t n,float thr,uint32_t* idx);
+            //class_max:per column the best of nc rows(stride floats apart),the first wins a tie
+            static void class_max_scalar(const float* src,uint32_t stride,uint32_t nc,uint32_t n,float* max,uint32_t* arg);
+#if defined(__ARM_NEON)
+            static uint32_t scan_neon(const float* src,uint32_t n,float thr,uint32_t* idx);
+            static void class_max_neon(const float* src,uint32_t stride,uint32_t nc,uint32_t n,float* max,uint32_t* arg);
+#endif
+
+        private:
+            bool decode_v5(const std::vector<yolo_tensor>& tensors);
+            bool decode_v8(const std::vector<yolo_tensor>& tensors);
+            void nms(std::vector<yolo_box>& boxes);
+            uint32_t scan(const float* src,uint32_t n,float thr,uint32_t* idx);
+            void class_max(const float* src,uint32_t stride,uint32_t nc,uint32_t n,float* max,uint32_t* arg);
+
+        private:
+            yolo_post_param m_param;
+            bool m_neon;
+            float m_logit_threshold;
+            std::vector<yolo_box> m_cand;
+            std::vector<uint32_t> m_idx;
+            std::vector<float> m_max;
+            std::vector<uint32_t> m_arg;
+            std::vector<float> m_area;
+            std::vector<bool> m_drop;
+    };
+
+}}//namespace
+
+#endif